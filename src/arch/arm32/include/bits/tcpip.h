@@ -12,8 +12,14 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 static inline __attribute__ (( always_inline )) uint16_t
 tcpip_continue_chksum ( uint16_t partial, const void *data, size_t len ) {
 
-	/* Not yet optimised */
 	return generic_tcpip_continue_chksum ( partial, data, len );
 }
 
+static inline __attribute__ (( always_inline )) uint16_t
+tcpip_copy_chksum ( uint16_t partial, void *dest, const void *src,
+		    size_t len ) {
+
+	return generic_tcpip_copy_chksum ( partial, dest, src, len );
+}
+
 #endif /* _BITS_TCPIP_H */
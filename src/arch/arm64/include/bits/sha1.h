@@ -0,0 +1,32 @@
+#ifndef _BITS_SHA1_H
+#define _BITS_SHA1_H
+
+/** @file
+ *
+ * SHA-1 algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stddef.h>
+
+struct sha1_digest;
+
+/**
+ * Digest SHA-1 data blocks using CPU extensions
+ *
+ * @v digest		Digest (in network byte order) to update
+ * @v data		Data blocks
+ * @v count		Number of blocks
+ * @ret count		Number of blocks digested
+ */
+static inline __attribute__ (( always_inline )) size_t
+sha1_arch_blocks ( struct sha1_digest *digest __unused,
+		   const void *data __unused, size_t count __unused ) {
+
+	/* No CPU extensions available */
+	return 0;
+}
+
+#endif /* _BITS_SHA1_H */
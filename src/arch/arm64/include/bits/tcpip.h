@@ -12,4 +12,11 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 extern uint16_t tcpip_continue_chksum ( uint16_t sum, const void *data,
 					size_t len );
 
+static inline __attribute__ (( always_inline )) uint16_t
+tcpip_copy_chksum ( uint16_t sum, void *dest, const void *src,
+		    size_t len ) {
+
+	return generic_tcpip_copy_chksum ( sum, dest, src, len );
+}
+
 #endif /* _BITS_TCPIP_H */
@@ -133,6 +133,21 @@ int linux_bind ( int fd, const struct sockaddr *addr, socklen_t addrlen ) {
 #endif
 }
 
+int linux_setsockopt ( int fd, int level, int optname, const void *optval,
+		       socklen_t optlen ) {
+#ifdef __NR_setsockopt
+	return linux_syscall ( __NR_setsockopt, fd, level, optname,
+			       optval, optlen );
+#else
+#ifndef SOCKOP_setsockopt
+# define SOCKOP_setsockopt 14
+#endif
+	unsigned long sc_args[] = { fd, level, optname,
+				    (unsigned long)optval, optlen };
+	return linux_syscall ( __NR_socketcall, SOCKOP_setsockopt, sc_args );
+#endif
+}
+
 ssize_t linux_sendto ( int fd, const void *buf, size_t len, int flags,
 		       const struct sockaddr *daddr, socklen_t addrlen ) {
 #ifdef __NR_sendto
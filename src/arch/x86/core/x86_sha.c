@@ -0,0 +1,627 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * SHA-1 and SHA-256 using the x86 SHA extensions
+ *
+ * iPXE is built without SSE support, so the compiler will never
+ * allocate SSE registers.  Each accelerated routine therefore saves
+ * and restores the SSE registers that it uses, so that any state
+ * belonging to the surrounding environment (e.g. UEFI firmware) is
+ * preserved.  Only %xmm0-%xmm7 are used, allowing the same code to be
+ * used in both 32-bit and 64-bit builds.
+ *
+ */
+
+#include <stdint.h>
+#include <byteswap.h>
+#include <ipxe/cpuid.h>
+#include <ipxe/sha1.h>
+#include <ipxe/sha256.h>
+
+/** CR4: operating system supports FXSAVE/FXRSTOR (and hence SSE) */
+#define CR4_OSFXSR 0x00000200UL
+
+/** SHA extension usability */
+enum x86_sha_state {
+	/** Usability not yet determined */
+	X86_SHA_UNKNOWN = 0,
+	/** SHA extensions are usable */
+	X86_SHA_USABLE,
+	/** SHA extensions are not usable */
+	X86_SHA_UNUSABLE,
+};
+
+/** SHA extension usability */
+static enum x86_sha_state x86_sha_state;
+
+/** Scratch space used by accelerated routines */
+struct x86_sha_scratch {
+	/** Saved SSE registers */
+	uint8_t xmm[8][16];
+	/** Saved hash values */
+	uint32_t save[2][4];
+} __attribute__ (( aligned ( 16 ) ));
+
+/** SHA-1 constants */
+struct x86_sha1_constants {
+	/** Byte-reversal shuffle mask */
+	uint8_t shuffle[16];
+} __attribute__ (( aligned ( 16 ) ));
+
+/** SHA-1 constants */
+static const struct x86_sha1_constants x86_sha1_constants = {
+	.shuffle = { 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 },
+};
+
+/** SHA-256 constants */
+struct x86_sha256_constants {
+	/** Per-dword byte-swapping shuffle mask */
+	uint8_t shuffle[16];
+	/** Round constants */
+	uint32_t k[SHA256_ROUNDS];
+} __attribute__ (( aligned ( 16 ) ));
+
+/** SHA-256 constants */
+static const struct x86_sha256_constants x86_sha256_constants = {
+	.shuffle = { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+	.k = {
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+		0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+		0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+		0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+		0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+		0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+		0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+		0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+		0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+		0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+		0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+		0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+	},
+};
+
+/** Save SSE registers %xmm0-%xmm7 to scratch space */
+#define X86_SHA_SAVE_XMM						\
+	"movdqu %%xmm0, 0(%[scratch])\n\t"				\
+	"movdqu %%xmm1, 16(%[scratch])\n\t"				\
+	"movdqu %%xmm2, 32(%[scratch])\n\t"				\
+	"movdqu %%xmm3, 48(%[scratch])\n\t"				\
+	"movdqu %%xmm4, 64(%[scratch])\n\t"				\
+	"movdqu %%xmm5, 80(%[scratch])\n\t"				\
+	"movdqu %%xmm6, 96(%[scratch])\n\t"				\
+	"movdqu %%xmm7, 112(%[scratch])\n\t"
+
+/** Restore SSE registers %xmm0-%xmm7 from scratch space */
+#define X86_SHA_RESTORE_XMM						\
+	"movdqu 0(%[scratch]), %%xmm0\n\t"				\
+	"movdqu 16(%[scratch]), %%xmm1\n\t"				\
+	"movdqu 32(%[scratch]), %%xmm2\n\t"				\
+	"movdqu 48(%[scratch]), %%xmm3\n\t"				\
+	"movdqu 64(%[scratch]), %%xmm4\n\t"				\
+	"movdqu 80(%[scratch]), %%xmm5\n\t"				\
+	"movdqu 96(%[scratch]), %%xmm6\n\t"				\
+	"movdqu 112(%[scratch]), %%xmm7\n\t"
+
+/**
+ * Check whether or not SSE instructions may be used
+ *
+ * @ret usable		SSE instructions may be used
+ */
+static int x86_sse_usable ( void ) {
+	unsigned long cr4;
+	uint16_t cs;
+
+	/* If we are running in user mode (e.g. as a Linux userspace
+	 * application) then the operating system will have enabled
+	 * SSE.  We cannot read %cr4 from user mode.
+	 */
+	__asm__ ( "movw %%cs, %0" : "=r" ( cs ) );
+	if ( cs & 3 )
+		return 1;
+
+	/* Otherwise, check that SSE has been enabled */
+	__asm__ ( "mov %%cr4, %0" : "=r" ( cr4 ) );
+	return ( !! ( cr4 & CR4_OSFXSR ) );
+}
+
+/**
+ * Check whether or not SHA extensions may be used
+ *
+ * @ret usable		SHA extensions may be used
+ */
+static int x86_sha_usable ( void ) {
+	struct x86_features features;
+	uint32_t discard_a;
+	uint32_t ebx;
+	uint32_t discard_c;
+	uint32_t discard_d;
+
+	/* Use cached result, if available */
+	if ( x86_sha_state != X86_SHA_UNKNOWN )
+		return ( x86_sha_state == X86_SHA_USABLE );
+	x86_sha_state = X86_SHA_UNUSABLE;
+
+	/* Check for SSE2, SSSE3 and SSE4.1 */
+	x86_features ( &features );
+	if ( ! ( ( features.intel.edx & CPUID_FEATURES_INTEL_EDX_SSE2 ) &&
+		 ( features.intel.ecx & CPUID_FEATURES_INTEL_ECX_SSSE3 ) &&
+		 ( features.intel.ecx & CPUID_FEATURES_INTEL_ECX_SSE4_1 ) ) ){
+		DBGC ( &x86_sha_state, "SHA has no SSE4.1 support\n" );
+		return 0;
+	}
+
+	/* Check for SHA extensions */
+	if ( cpuid_supported ( CPUID_EXTENDED_FEATURES ) != 0 )
+		return 0;
+	cpuid ( CPUID_EXTENDED_FEATURES, 0, &discard_a, &ebx, &discard_c,
+		&discard_d );
+	if ( ! ( ebx & CPUID_EXTENDED_FEATURES_EBX_SHA ) ) {
+		DBGC ( &x86_sha_state, "SHA has no SHA extensions\n" );
+		return 0;
+	}
+
+	/* Check that SSE has been enabled */
+	if ( ! x86_sse_usable() ) {
+		DBGC ( &x86_sha_state, "SHA extensions present but SSE is "
+		       "not enabled\n" );
+		return 0;
+	}
+
+	DBGC ( &x86_sha_state, "SHA using x86 SHA extensions\n" );
+	x86_sha_state = X86_SHA_USABLE;
+	return 1;
+}
+
+/**
+ * Digest SHA-1 data blocks using x86 SHA extensions
+ *
+ * @v digest		Digest (in network byte order) to update
+ * @v data		Data blocks
+ * @v count		Number of blocks
+ * @ret count		Number of blocks digested
+ */
+size_t sha1_arch_blocks ( struct sha1_digest *digest, const void *data,
+			  size_t count ) {
+	struct x86_sha_scratch scratch;
+	uint32_t state[ 5 /* a-e */ + 3 /* padding */ ];
+	const void *end = ( data + ( count * sizeof ( union sha1_block ) ) );
+	unsigned int i;
+
+	/* Do nothing unless SHA extensions are usable */
+	if ( ( count == 0 ) || ( ! x86_sha_usable() ) )
+		return 0;
+
+	/* Convert digest to host byte order */
+	for ( i = 0 ; i < 5 ; i++ )
+		state[i] = be32_to_cpu ( digest->h[i] );
+
+	/* Digest blocks */
+	__asm__ __volatile__ (
+		X86_SHA_SAVE_XMM
+		/* Load a-d into %xmm0 and e into upper dword of %xmm1 */
+		"movdqu 0(%[state]), %%xmm0\n\t"
+		"pshufd $0x1b, %%xmm0, %%xmm0\n\t"
+		"movd 16(%[state]), %%xmm1\n\t"
+		"pslldq $12, %%xmm1\n\t"
+		"movdqa (%[consts]), %%xmm7\n\t"
+		"\n1:\n\t"
+		/* Save hash values */
+		"movdqa %%xmm1, 128(%[scratch])\n\t"
+		"movdqa %%xmm0, 144(%[scratch])\n\t"
+		/* Rounds 0-3 */
+		"movdqu 0(%[data]), %%xmm3\n\t"
+		"pshufb %%xmm7, %%xmm3\n\t"
+		"paddd %%xmm3, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+		/* Rounds 4-7 */
+		"movdqu 16(%[data]), %%xmm4\n\t"
+		"pshufb %%xmm7, %%xmm4\n\t"
+		"sha1nexte %%xmm4, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1rnds4 $0, %%xmm2, %%xmm0\n\t"
+		"sha1msg1 %%xmm4, %%xmm3\n\t"
+		/* Rounds 8-11 */
+		"movdqu 32(%[data]), %%xmm5\n\t"
+		"pshufb %%xmm7, %%xmm5\n\t"
+		"sha1nexte %%xmm5, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+		"sha1msg1 %%xmm5, %%xmm4\n\t"
+		"pxor %%xmm5, %%xmm3\n\t"
+		/* Rounds 12-15 */
+		"movdqu 48(%[data]), %%xmm6\n\t"
+		"pshufb %%xmm7, %%xmm6\n\t"
+		"sha1nexte %%xmm6, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1msg2 %%xmm6, %%xmm3\n\t"
+		"sha1rnds4 $0, %%xmm2, %%xmm0\n\t"
+		"sha1msg1 %%xmm6, %%xmm5\n\t"
+		"pxor %%xmm6, %%xmm4\n\t"
+		/* Rounds 16-19 */
+		"sha1nexte %%xmm3, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1msg2 %%xmm3, %%xmm4\n\t"
+		"sha1rnds4 $0, %%xmm1, %%xmm0\n\t"
+		"sha1msg1 %%xmm3, %%xmm6\n\t"
+		"pxor %%xmm3, %%xmm5\n\t"
+		/* Rounds 20-23 */
+		"sha1nexte %%xmm4, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1msg2 %%xmm4, %%xmm5\n\t"
+		"sha1rnds4 $1, %%xmm2, %%xmm0\n\t"
+		"sha1msg1 %%xmm4, %%xmm3\n\t"
+		"pxor %%xmm4, %%xmm6\n\t"
+		/* Rounds 24-27 */
+		"sha1nexte %%xmm5, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1msg2 %%xmm5, %%xmm6\n\t"
+		"sha1rnds4 $1, %%xmm1, %%xmm0\n\t"
+		"sha1msg1 %%xmm5, %%xmm4\n\t"
+		"pxor %%xmm5, %%xmm3\n\t"
+		/* Rounds 28-31 */
+		"sha1nexte %%xmm6, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1msg2 %%xmm6, %%xmm3\n\t"
+		"sha1rnds4 $1, %%xmm2, %%xmm0\n\t"
+		"sha1msg1 %%xmm6, %%xmm5\n\t"
+		"pxor %%xmm6, %%xmm4\n\t"
+		/* Rounds 32-35 */
+		"sha1nexte %%xmm3, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1msg2 %%xmm3, %%xmm4\n\t"
+		"sha1rnds4 $1, %%xmm1, %%xmm0\n\t"
+		"sha1msg1 %%xmm3, %%xmm6\n\t"
+		"pxor %%xmm3, %%xmm5\n\t"
+		/* Rounds 36-39 */
+		"sha1nexte %%xmm4, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1msg2 %%xmm4, %%xmm5\n\t"
+		"sha1rnds4 $1, %%xmm2, %%xmm0\n\t"
+		"sha1msg1 %%xmm4, %%xmm3\n\t"
+		"pxor %%xmm4, %%xmm6\n\t"
+		/* Rounds 40-43 */
+		"sha1nexte %%xmm5, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1msg2 %%xmm5, %%xmm6\n\t"
+		"sha1rnds4 $2, %%xmm1, %%xmm0\n\t"
+		"sha1msg1 %%xmm5, %%xmm4\n\t"
+		"pxor %%xmm5, %%xmm3\n\t"
+		/* Rounds 44-47 */
+		"sha1nexte %%xmm6, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1msg2 %%xmm6, %%xmm3\n\t"
+		"sha1rnds4 $2, %%xmm2, %%xmm0\n\t"
+		"sha1msg1 %%xmm6, %%xmm5\n\t"
+		"pxor %%xmm6, %%xmm4\n\t"
+		/* Rounds 48-51 */
+		"sha1nexte %%xmm3, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1msg2 %%xmm3, %%xmm4\n\t"
+		"sha1rnds4 $2, %%xmm1, %%xmm0\n\t"
+		"sha1msg1 %%xmm3, %%xmm6\n\t"
+		"pxor %%xmm3, %%xmm5\n\t"
+		/* Rounds 52-55 */
+		"sha1nexte %%xmm4, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1msg2 %%xmm4, %%xmm5\n\t"
+		"sha1rnds4 $2, %%xmm2, %%xmm0\n\t"
+		"sha1msg1 %%xmm4, %%xmm3\n\t"
+		"pxor %%xmm4, %%xmm6\n\t"
+		/* Rounds 56-59 */
+		"sha1nexte %%xmm5, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1msg2 %%xmm5, %%xmm6\n\t"
+		"sha1rnds4 $2, %%xmm1, %%xmm0\n\t"
+		"sha1msg1 %%xmm5, %%xmm4\n\t"
+		"pxor %%xmm5, %%xmm3\n\t"
+		/* Rounds 60-63 */
+		"sha1nexte %%xmm6, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1msg2 %%xmm6, %%xmm3\n\t"
+		"sha1rnds4 $3, %%xmm2, %%xmm0\n\t"
+		"sha1msg1 %%xmm6, %%xmm5\n\t"
+		"pxor %%xmm6, %%xmm4\n\t"
+		/* Rounds 64-67 */
+		"sha1nexte %%xmm3, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1msg2 %%xmm3, %%xmm4\n\t"
+		"sha1rnds4 $3, %%xmm1, %%xmm0\n\t"
+		"sha1msg1 %%xmm3, %%xmm6\n\t"
+		"pxor %%xmm3, %%xmm5\n\t"
+		/* Rounds 68-71 */
+		"sha1nexte %%xmm4, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1msg2 %%xmm4, %%xmm5\n\t"
+		"sha1rnds4 $3, %%xmm2, %%xmm0\n\t"
+		"pxor %%xmm4, %%xmm6\n\t"
+		/* Rounds 72-75 */
+		"sha1nexte %%xmm5, %%xmm1\n\t"
+		"movdqa %%xmm0, %%xmm2\n\t"
+		"sha1msg2 %%xmm5, %%xmm6\n\t"
+		"sha1rnds4 $3, %%xmm1, %%xmm0\n\t"
+		/* Rounds 76-79 */
+		"sha1nexte %%xmm6, %%xmm2\n\t"
+		"movdqa %%xmm0, %%xmm1\n\t"
+		"sha1rnds4 $3, %%xmm2, %%xmm0\n\t"
+		/* Add saved hash values */
+		"sha1nexte 128(%[scratch]), %%xmm1\n\t"
+		"paddd 144(%[scratch]), %%xmm0\n\t"
+		/* Loop until all blocks are processed */
+		"add $64, %[data]\n\t"
+		"cmp %[end], %[data]\n\t"
+		"jne 1b\n\t"
+		/* Store a-e */
+		"pshufd $0x1b, %%xmm0, %%xmm0\n\t"
+		"movdqu %%xmm0, 0(%[state])\n\t"
+		"psrldq $12, %%xmm1\n\t"
+		"movd %%xmm1, 16(%[state])\n\t"
+		X86_SHA_RESTORE_XMM
+		: [data] "+r" ( data )
+		: [end] "r" ( end ), [state] "r" ( state ),
+		  [consts] "r" ( &x86_sha1_constants ),
+		  [scratch] "r" ( &scratch )
+		: "memory" );
+
+	/* Convert digest to network byte order */
+	for ( i = 0 ; i < 5 ; i++ )
+		digest->h[i] = cpu_to_be32 ( state[i] );
+
+	return count;
+}
+
+/**
+ * Digest SHA-256 data blocks using x86 SHA extensions
+ *
+ * @v digest		Digest (in network byte order) to update
+ * @v data		Data blocks
+ * @v count		Number of blocks
+ * @ret count		Number of blocks digested
+ */
+size_t sha256_arch_blocks ( struct sha256_digest *digest, const void *data,
+			    size_t count ) {
+	struct x86_sha_scratch scratch;
+	uint32_t state[8];
+	const void *end = ( data + ( count * sizeof ( union sha256_block ) ) );
+	unsigned int i;
+
+	/* Do nothing unless SHA extensions are usable */
+	if ( ( count == 0 ) || ( ! x86_sha_usable() ) )
+		return 0;
+
+	/* Convert digest to host byte order */
+	for ( i = 0 ; i < 8 ; i++ )
+		state[i] = be32_to_cpu ( digest->h[i] );
+
+	/* Digest blocks */
+	__asm__ __volatile__ (
+		X86_SHA_SAVE_XMM
+		/* Load a-h and rearrange into ABEF (%xmm1) and CDGH (%xmm2) */
+		"movdqu 0(%[state]), %%xmm1\n\t"
+		"movdqu 16(%[state]), %%xmm2\n\t"
+		"pshufd $0xb1, %%xmm1, %%xmm1\n\t"
+		"pshufd $0x1b, %%xmm2, %%xmm2\n\t"
+		"movdqa %%xmm1, %%xmm7\n\t"
+		"palignr $8, %%xmm2, %%xmm1\n\t"
+		"pblendw $0xf0, %%xmm7, %%xmm2\n\t"
+		"\n1:\n\t"
+		/* Save hash values */
+		"movdqa %%xmm1, 128(%[scratch])\n\t"
+		"movdqa %%xmm2, 144(%[scratch])\n\t"
+		/* Rounds 0-3 */
+		"movdqu 0(%[data]), %%xmm0\n\t"
+		"pshufb (%[consts]), %%xmm0\n\t"
+		"movdqa %%xmm0, %%xmm3\n\t"
+		"paddd 16(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		/* Rounds 4-7 */
+		"movdqu 16(%[data]), %%xmm0\n\t"
+		"pshufb (%[consts]), %%xmm0\n\t"
+		"movdqa %%xmm0, %%xmm4\n\t"
+		"paddd 32(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm4, %%xmm3\n\t"
+		/* Rounds 8-11 */
+		"movdqu 32(%[data]), %%xmm0\n\t"
+		"pshufb (%[consts]), %%xmm0\n\t"
+		"movdqa %%xmm0, %%xmm5\n\t"
+		"paddd 48(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm5, %%xmm4\n\t"
+		/* Rounds 12-15 */
+		"movdqu 48(%[data]), %%xmm0\n\t"
+		"pshufb (%[consts]), %%xmm0\n\t"
+		"movdqa %%xmm0, %%xmm6\n\t"
+		"paddd 64(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm6, %%xmm7\n\t"
+		"palignr $4, %%xmm5, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm3\n\t"
+		"sha256msg2 %%xmm6, %%xmm3\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm6, %%xmm5\n\t"
+		/* Rounds 16-19 */
+		"movdqa %%xmm3, %%xmm0\n\t"
+		"paddd 80(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm3, %%xmm7\n\t"
+		"palignr $4, %%xmm6, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm4\n\t"
+		"sha256msg2 %%xmm3, %%xmm4\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm3, %%xmm6\n\t"
+		/* Rounds 20-23 */
+		"movdqa %%xmm4, %%xmm0\n\t"
+		"paddd 96(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm4, %%xmm7\n\t"
+		"palignr $4, %%xmm3, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm5\n\t"
+		"sha256msg2 %%xmm4, %%xmm5\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm4, %%xmm3\n\t"
+		/* Rounds 24-27 */
+		"movdqa %%xmm5, %%xmm0\n\t"
+		"paddd 112(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm5, %%xmm7\n\t"
+		"palignr $4, %%xmm4, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm6\n\t"
+		"sha256msg2 %%xmm5, %%xmm6\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm5, %%xmm4\n\t"
+		/* Rounds 28-31 */
+		"movdqa %%xmm6, %%xmm0\n\t"
+		"paddd 128(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm6, %%xmm7\n\t"
+		"palignr $4, %%xmm5, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm3\n\t"
+		"sha256msg2 %%xmm6, %%xmm3\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm6, %%xmm5\n\t"
+		/* Rounds 32-35 */
+		"movdqa %%xmm3, %%xmm0\n\t"
+		"paddd 144(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm3, %%xmm7\n\t"
+		"palignr $4, %%xmm6, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm4\n\t"
+		"sha256msg2 %%xmm3, %%xmm4\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm3, %%xmm6\n\t"
+		/* Rounds 36-39 */
+		"movdqa %%xmm4, %%xmm0\n\t"
+		"paddd 160(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm4, %%xmm7\n\t"
+		"palignr $4, %%xmm3, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm5\n\t"
+		"sha256msg2 %%xmm4, %%xmm5\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm4, %%xmm3\n\t"
+		/* Rounds 40-43 */
+		"movdqa %%xmm5, %%xmm0\n\t"
+		"paddd 176(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm5, %%xmm7\n\t"
+		"palignr $4, %%xmm4, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm6\n\t"
+		"sha256msg2 %%xmm5, %%xmm6\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm5, %%xmm4\n\t"
+		/* Rounds 44-47 */
+		"movdqa %%xmm6, %%xmm0\n\t"
+		"paddd 192(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm6, %%xmm7\n\t"
+		"palignr $4, %%xmm5, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm3\n\t"
+		"sha256msg2 %%xmm6, %%xmm3\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm6, %%xmm5\n\t"
+		/* Rounds 48-51 */
+		"movdqa %%xmm3, %%xmm0\n\t"
+		"paddd 208(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm3, %%xmm7\n\t"
+		"palignr $4, %%xmm6, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm4\n\t"
+		"sha256msg2 %%xmm3, %%xmm4\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		"sha256msg1 %%xmm3, %%xmm6\n\t"
+		/* Rounds 52-55 */
+		"movdqa %%xmm4, %%xmm0\n\t"
+		"paddd 224(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm4, %%xmm7\n\t"
+		"palignr $4, %%xmm3, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm5\n\t"
+		"sha256msg2 %%xmm4, %%xmm5\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		/* Rounds 56-59 */
+		"movdqa %%xmm5, %%xmm0\n\t"
+		"paddd 240(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"movdqa %%xmm5, %%xmm7\n\t"
+		"palignr $4, %%xmm4, %%xmm7\n\t"
+		"paddd %%xmm7, %%xmm6\n\t"
+		"sha256msg2 %%xmm5, %%xmm6\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		/* Rounds 60-63 */
+		"movdqa %%xmm6, %%xmm0\n\t"
+		"paddd 256(%[consts]), %%xmm0\n\t"
+		"sha256rnds2 %%xmm1, %%xmm2\n\t"
+		"pshufd $0x0e, %%xmm0, %%xmm0\n\t"
+		"sha256rnds2 %%xmm2, %%xmm1\n\t"
+		/* Add saved hash values */
+		"paddd 128(%[scratch]), %%xmm1\n\t"
+		"paddd 144(%[scratch]), %%xmm2\n\t"
+		/* Loop until all blocks are processed */
+		"add $64, %[data]\n\t"
+		"cmp %[end], %[data]\n\t"
+		"jne 1b\n\t"
+		/* Rearrange and store a-h */
+		"pshufd $0x1b, %%xmm1, %%xmm1\n\t"
+		"pshufd $0xb1, %%xmm2, %%xmm2\n\t"
+		"movdqa %%xmm1, %%xmm7\n\t"
+		"pblendw $0xf0, %%xmm2, %%xmm1\n\t"
+		"palignr $8, %%xmm7, %%xmm2\n\t"
+		"movdqu %%xmm1, 0(%[state])\n\t"
+		"movdqu %%xmm2, 16(%[state])\n\t"
+		X86_SHA_RESTORE_XMM
+		: [data] "+r" ( data )
+		: [end] "r" ( end ), [state] "r" ( state ),
+		  [consts] "r" ( &x86_sha256_constants ),
+		  [scratch] "r" ( &scratch )
+		: "memory" );
+
+	/* Convert digest to network byte order */
+	for ( i = 0 ; i < 8 ; i++ )
+		digest->h[i] = cpu_to_be32 ( state[i] );
+
+	return count;
+}
@@ -29,7 +29,57 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+#include <stdint.h>
 #include <string.h>
+#include <ipxe/cpuid.h>
+
+/** Native word-sized string move instruction */
+#ifdef __x86_64__
+#define MOVS_WORD "movsq"
+#else
+#define MOVS_WORD "movsl"
+#endif
+
+/** Enhanced "rep movsb" state */
+enum x86_erms_state {
+	/** Not yet checked */
+	X86_ERMS_UNKNOWN = 0,
+	/** Not supported */
+	X86_ERMS_ABSENT,
+	/** Supported */
+	X86_ERMS_PRESENT,
+};
+
+/** Enhanced "rep movsb" state */
+static enum x86_erms_state x86_erms_state;
+
+/**
+ * Check whether or not enhanced "rep movsb" is supported
+ *
+ * @ret supported	Enhanced "rep movsb" is supported
+ */
+static int x86_erms_supported ( void ) {
+	uint32_t discard_a;
+	uint32_t ebx;
+	uint32_t discard_c;
+	uint32_t discard_d;
+
+	/* Use cached result, if available */
+	if ( x86_erms_state != X86_ERMS_UNKNOWN )
+		return ( x86_erms_state == X86_ERMS_PRESENT );
+	x86_erms_state = X86_ERMS_ABSENT;
+
+	/* Check for enhanced "rep movsb" */
+	if ( cpuid_supported ( CPUID_EXTENDED_FEATURES ) != 0 )
+		return 0;
+	cpuid ( CPUID_EXTENDED_FEATURES, 0, &discard_a, &ebx, &discard_c,
+		&discard_d );
+	if ( ! ( ebx & CPUID_EXTENDED_FEATURES_EBX_ERMS ) )
+		return 0;
+
+	x86_erms_state = X86_ERMS_PRESENT;
+	return 1;
+}
 
 /**
  * Copy memory area
@@ -43,21 +93,37 @@ void * __attribute__ (( noinline )) __memcpy ( void *dest, const void *src,
 					       size_t len ) {
 	void *edi = dest;
 	const void *esi = src;
-	int discard_ecx;
+	unsigned long discard_ecx;
+
+	/* With enhanced "rep movsb", the CPU itself handles alignment
+	 * and moves the data in the widest available units.  This is
+	 * at least as fast as a word-sized move for aligned data, and
+	 * around twice as fast for misaligned data.
+	 */
+	if ( x86_erms_supported() ) {
+		__asm__ __volatile__ ( "rep movsb"
+				       : "=&D" ( edi ), "=&S" ( esi ),
+					 "=&c" ( discard_ecx )
+				       : "0" ( edi ), "1" ( esi ), "2" ( len )
+				       : "memory" );
+		return dest;
+	}
 
-	/* We often do large dword-aligned and dword-length block
-	 * moves.  Using movsl rather than movsb speeds these up by
-	 * around 32%.
+	/* We often do large word-aligned and word-length block
+	 * moves.  Using word-sized moves rather than movsb speeds
+	 * these up considerably.
 	 */
-	__asm__ __volatile__ ( "rep movsl"
+	__asm__ __volatile__ ( "rep " MOVS_WORD
 			       : "=&D" ( edi ), "=&S" ( esi ),
 				 "=&c" ( discard_ecx )
-			       : "0" ( edi ), "1" ( esi ), "2" ( len >> 2 )
+			       : "0" ( edi ), "1" ( esi ),
+				 "2" ( len / sizeof ( unsigned long ) )
 			       : "memory" );
 	__asm__ __volatile__ ( "rep movsb"
 			       : "=&D" ( edi ), "=&S" ( esi ),
 				 "=&c" ( discard_ecx )
-			       : "0" ( edi ), "1" ( esi ), "2" ( len & 3 )
+			       : "0" ( edi ), "1" ( esi ),
+				 "2" ( len % sizeof ( unsigned long ) )
 			       : "memory" );
 	return dest;
 }
@@ -75,18 +141,28 @@ void * __attribute__ (( noinline )) __memcpy_reverse ( void *dest,
 						       size_t len ) {
 	void *edi = ( dest + len - 1 );
 	const void *esi = ( src + len - 1 );
-	int discard_ecx;
+	unsigned long discard_ecx;
 
-	/* Assume memmove() is not performance-critical, and perform a
-	 * bytewise copy for simplicity.
+	/* Backwards string operations do not benefit from the CPU's
+	 * fast string microcode, and a bytewise backwards copy runs
+	 * at around one byte per cycle.  This is too slow for
+	 * operations such as initrd reshuffling, which may move
+	 * hundreds of megabytes.  Copy the trailing partial word
+	 * bytewise, then copy the remainder using word-sized moves.
 	 */
 	__asm__ __volatile__ ( "std\n\t"
 			       "rep movsb\n\t"
+			       "sub %5, %0\n\t"
+			       "sub %5, %1\n\t"
+			       "mov %6, %2\n\t"
+			       "rep " MOVS_WORD "\n\t"
 			       "cld\n\t"
 			       : "=&D" ( edi ), "=&S" ( esi ),
 				 "=&c" ( discard_ecx )
 			       : "0" ( edi ), "1" ( esi ),
-				 "2" ( len )
+				 "i" ( sizeof ( unsigned long ) - 1 ),
+				 "r" ( len / sizeof ( unsigned long ) ),
+				 "2" ( len % sizeof ( unsigned long ) )
 			       : "memory" );
 	return dest;
 }
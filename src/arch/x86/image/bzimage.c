@@ -79,6 +79,8 @@ struct bzimage_context {
 	physaddr_t ramdisk_image;
 	/** Initrd size */
 	physaddr_t ramdisk_size;
+	/** Initrds are already in place */
+	int initrds_in_place;
 
 	/** Command line magic block */
 	struct bzimage_cmdline cmdline_magic;
@@ -408,7 +410,11 @@ static size_t bzimage_load_initrd ( struct image *image,
 
 	/* Copy in initrd image body (and cpio header if applicable) */
 	if ( address ) {
-		memmove_user ( address, offset, initrd->data, 0, initrd->len );
+		if ( userptr_sub ( userptr_add ( address, offset ),
+				   initrd->data ) != 0 ) {
+			memmove_user ( address, offset, initrd->data, 0,
+				       initrd->len );
+		}
 		if ( offset ) {
 			memset_user ( address, 0, 0, offset );
 			copy_to_user ( address, 0, &cpio, sizeof ( cpio ) );
@@ -433,6 +439,66 @@ static size_t bzimage_load_initrd ( struct image *image,
 	return offset;
 }
 
+/**
+ * Check whether initrds were already placed during download
+ *
+ * @v image		bzImage image
+ * @v bzimg		bzImage context
+ * @ret in_place	Initrds can be loaded without being moved
+ *
+ * Initrds that were placed in memory during download will be in
+ * order, above the kernel, and separated only by gaps large enough
+ * to hold the CPIO headers.  If this is the case, then the CPIO
+ * headers can be constructed within the gaps and the initrds can be
+ * handed to the kernel without reshuffling or copying.
+ */
+static int bzimage_initrds_in_place ( struct image *image,
+				      struct bzimage_context *bzimg ) {
+	struct image *initrd;
+	userptr_t end;
+	userptr_t header;
+	size_t offset;
+	size_t len;
+	int count = 0;
+
+	/* Start immediately above the kernel */
+	end = userptr_add ( bzimg->pm_kernel, bzimg->pm_sz );
+
+	/* Check each initrd in turn */
+	for_each_image ( initrd ) {
+
+		/* Skip kernel */
+		if ( initrd == image )
+			continue;
+
+		/* Locate CPIO header (if applicable) */
+		len = bzimage_load_initrd ( image, initrd, UNULL );
+		offset = ( len - initrd->len );
+		header = userptr_add ( initrd->data, -offset );
+
+		/* Check that header follows previous initrd closely */
+		if ( userptr_sub ( header, end ) < 0 )
+			return 0;
+		if ( count && ( userptr_sub ( header, end ) >=
+				INITRD_PLACE_GAP_MAX ) ) {
+			return 0;
+		}
+
+		/* Move to end of this initrd */
+		end = userptr_add ( initrd->data, initrd->len );
+		count++;
+	}
+
+	/* Check that initrds fit within kernel's memory limit */
+	if ( ! count )
+		return 0;
+	if ( user_to_phys ( end, ( INITRD_ALIGN - 1 ) ) > bzimg->mem_limit )
+		return 0;
+
+	DBGC ( image, "bzImage %p initrds are already in place\n", image );
+	return 1;
+}
+
 /**
  * Check that initrds can be loaded
  *
@@ -467,6 +533,11 @@ static int bzimage_check_initrds ( struct image *image,
 			     user_to_virt ( initrd->data, 0 ), initrd->len );
 	}
 
+	/* Use initrds in place, if possible */
+	bzimg->initrds_in_place = bzimage_initrds_in_place ( image, bzimg );
+	if ( bzimg->initrds_in_place )
+		return 0;
+
 	/* Calculate lowest usable address */
 	bottom = userptr_add ( bzimg->pm_kernel, bzimg->pm_sz );
 
@@ -491,6 +562,51 @@ static int bzimage_check_initrds ( struct image *image,
 	return 0;
 }
 
+/**
+ * Load initrds in place
+ *
+ * @v image		bzImage image
+ * @v bzimg		bzImage context
+ */
+static void bzimage_load_initrds_in_place ( struct image *image,
+					    struct bzimage_context *bzimg ) {
+	struct image *initrd;
+	userptr_t end = UNULL;
+	userptr_t dest;
+	size_t offset;
+	size_t len;
+
+	/* Construct CPIO headers within the gaps between initrds */
+	for_each_image ( initrd ) {
+
+		/* Skip kernel */
+		if ( initrd == image )
+			continue;
+
+		/* Locate CPIO header (if applicable) */
+		offset = ( bzimage_load_initrd ( image, initrd, UNULL ) -
+			   initrd->len );
+		dest = userptr_add ( initrd->data, -offset );
+
+		/* Zero any gap following the previous initrd */
+		if ( end && ( userptr_sub ( dest, end ) > 0 ) )
+			memset_user ( end, 0, 0, userptr_sub ( dest, end ) );
+
+		/* Load initrd at this address */
+		len = bzimage_load_initrd ( image, initrd, dest );
+		end = userptr_add ( initrd->data, initrd->len );
+
+		/* Record initrd location */
+		if ( ! bzimg->ramdisk_image )
+			bzimg->ramdisk_image = user_to_phys ( dest, 0 );
+		bzimg->ramdisk_size = ( user_to_phys ( dest, len ) -
+					bzimg->ramdisk_image );
+	}
+	DBGC ( image, "bzImage %p initrds in place at [%#08lx,%#08lx)\n",
+	       image, bzimg->ramdisk_image,
+	       ( bzimg->ramdisk_image + bzimg->ramdisk_size ) );
+}
+
 /**
  * Load initrds, if any
  *
@@ -507,6 +623,12 @@ static void bzimage_load_initrds ( struct image *image,
 	size_t offset;
 	size_t len;
 
+	/* Use initrds in place, if possible */
+	if ( bzimg->initrds_in_place ) {
+		bzimage_load_initrds_in_place ( image, bzimg );
+		return;
+	}
+
 	/* Reshuffle initrds into desired order */
 	initrd_reshuffle ( userptr_add ( bzimg->pm_kernel, bzimg->pm_sz ) );
 
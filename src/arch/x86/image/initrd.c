@@ -27,6 +27,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <initrd.h>
 #include <ipxe/image.h>
 #include <ipxe/uaccess.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/downloader.h>
 #include <ipxe/init.h>
 #include <ipxe/memblock.h>
 
@@ -280,6 +283,106 @@ int initrd_reshuffle_check ( size_t len, userptr_t bottom ) {
 	return ( ( len < available ) ? 0 : -ENOBUFS );
 }
 
+/**
+ * Reallocate initrd data buffer
+ *
+ * @v xferbuf		Data transfer buffer
+ * @v len		New length (or zero to free buffer)
+ * @ret rc		Return status code
+ *
+ * A new initrd is placed in memory immediately above any existing
+ * initrds placed in this way, leaving room for a CPIO header.  The
+ * initrds will therefore already be contiguous and in the correct
+ * order when the kernel is executed, and will not need reshuffling.
+ */
+static int initrd_xferbuf_realloc ( struct xfer_buffer *xferbuf,
+				    size_t len ) {
+	userptr_t *udata = xferbuf->data;
+	userptr_t new_udata;
+
+	/* Place new initrd above existing initrds, if possible */
+	if ( ! *udata ) {
+		new_udata = memtop_umalloc_low ( len, INITRD_PLACE_MIN,
+						 INITRD_PLACE_HEADROOM );
+		if ( new_udata ) {
+			DBGC ( &images, "INITRD placed at [%#08lx,%#08lx)\n",
+			       user_to_phys ( new_udata, 0 ),
+			       user_to_phys ( new_udata, len ) );
+			*udata = new_udata;
+			return 0;
+		}
+	}
+
+	/* Otherwise, reallocate as for any other image */
+	new_udata = urealloc ( *udata, len );
+
+	/* A placed initrd cannot grow once another initrd has been
+	 * placed above it (e.g. by a concurrent download).  Move it
+	 * elsewhere if this happens.
+	 */
+	if ( ( ! new_udata ) && *udata ) {
+		new_udata = umalloc ( len );
+		if ( new_udata ) {
+			memcpy_user ( new_udata, 0, *udata, 0, xferbuf->len );
+			ufree ( *udata );
+		}
+	}
+	if ( ! new_udata )
+		return -ENOSPC;
+	*udata = new_udata;
+	return 0;
+}
+
+/**
+ * Write data to initrd data buffer
+ *
+ * @v xferbuf		Data transfer buffer
+ * @v offset		Starting offset
+ * @v data		Data to write
+ * @v len		Length of data
+ */
+static void initrd_xferbuf_write ( struct xfer_buffer *xferbuf, size_t offset,
+				   const void *data, size_t len ) {
+	userptr_t *udata = xferbuf->data;
+
+	copy_to_user ( *udata, offset, data, len );
+}
+
+/**
+ * Read data from initrd data buffer
+ *
+ * @v xferbuf		Data transfer buffer
+ * @v offset		Starting offset
+ * @v data		Data to read
+ * @v len		Length of data
+ */
+static void initrd_xferbuf_read ( struct xfer_buffer *xferbuf, size_t offset,
+				  void *data, size_t len ) {
+	userptr_t *udata = xferbuf->data;
+
+	copy_from_user ( data, *udata, offset, len );
+}
+
+/** Initrd data transfer buffer operations */
+static struct xfer_buffer_operations initrd_xferbuf_operations = {
+	.realloc = initrd_xferbuf_realloc,
+	.write = initrd_xferbuf_write,
+	.read = initrd_xferbuf_read,
+};
+
+/**
+ * Initialise data transfer buffer for an initrd
+ *
+ * @v xferbuf		Data transfer buffer
+ * @v image		Image
+ */
+void initrd_xferbuf_init ( struct xfer_buffer *xferbuf,
+			   struct image *image ) {
+
+	xferbuf->data = &image->data;
+	xferbuf->op = &initrd_xferbuf_operations;
+}
+
 /**
  * initrd startup function
  *
@@ -0,0 +1,19 @@
+#ifndef _BITS_SHA1_H
+#define _BITS_SHA1_H
+
+/** @file
+ *
+ * SHA-1 algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stddef.h>
+
+struct sha1_digest;
+
+extern size_t sha1_arch_blocks ( struct sha1_digest *digest, const void *data,
+				 size_t count );
+
+#endif /* _BITS_SHA1_H */
@@ -0,0 +1,19 @@
+#ifndef _BITS_SHA256_H
+#define _BITS_SHA256_H
+
+/** @file
+ *
+ * SHA-256 algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stddef.h>
+
+struct sha256_digest;
+
+extern size_t sha256_arch_blocks ( struct sha256_digest *digest,
+				   const void *data, size_t count );
+
+#endif /* _BITS_SHA256_H */
@@ -24,6 +24,28 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 #define INITRD_MIN_FREE_LEN ( 512 * 1024 )
 
+/** Minimum address for initrds placed during download
+ *
+ * Initrds placed during download must stay clear of the region into
+ * which the kernel will be loaded and decompressed.  This is a policy
+ * decision.
+ */
+#define INITRD_PLACE_MIN 0x10000000UL
+
+/** Free space left before each initrd placed during download
+ *
+ * This leaves room for a CPIO header to be constructed immediately
+ * before the initrd, without moving the initrd.
+ */
+#define INITRD_PLACE_HEADROOM INITRD_ALIGN
+
+/** Maximum gap between consecutive initrds placed during download
+ *
+ * This allows for the headroom, the allocator's block header and
+ * alignment padding.
+ */
+#define INITRD_PLACE_GAP_MAX ( INITRD_PLACE_HEADROOM + ( 2 * INITRD_ALIGN ) )
+
 extern void initrd_reshuffle ( userptr_t bottom );
 extern int initrd_reshuffle_check ( size_t len, userptr_t bottom );
 
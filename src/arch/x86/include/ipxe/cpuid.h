@@ -39,9 +39,27 @@ struct x86_features {
 /** Get standard features */
 #define CPUID_FEATURES 0x00000001UL
 
+/** SSSE3 instructions are supported */
+#define CPUID_FEATURES_INTEL_ECX_SSSE3 0x00000200UL
+
+/** SSE4.1 instructions are supported */
+#define CPUID_FEATURES_INTEL_ECX_SSE4_1 0x00080000UL
+
 /** Hypervisor is present */
 #define CPUID_FEATURES_INTEL_ECX_HYPERVISOR 0x80000000UL
 
+/** SSE2 instructions are supported */
+#define CPUID_FEATURES_INTEL_EDX_SSE2 0x04000000UL
+
+/** Get structured extended features */
+#define CPUID_EXTENDED_FEATURES 0x00000007UL
+
+/** Enhanced "rep movsb" and "rep stosb" are supported */
+#define CPUID_EXTENDED_FEATURES_EBX_ERMS 0x00000200UL
+
+/** SHA extensions are supported */
+#define CPUID_EXTENDED_FEATURES_EBX_SHA 0x20000000UL
+
 /** Get largest extended function */
 #define CPUID_AMD_MAX_FN 0x80000000UL
 
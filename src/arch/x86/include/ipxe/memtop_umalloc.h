@@ -15,4 +15,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define UMALLOC_PREFIX_memtop __memtop_
 #endif
 
+#include <ipxe/uaccess.h>
+
+extern userptr_t memtop_umalloc_low ( size_t size, physaddr_t min,
+				      size_t headroom );
+
 #endif /* _IPXE_MEMTOP_UMALLOC_H */
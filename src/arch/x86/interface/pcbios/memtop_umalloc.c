@@ -49,18 +49,33 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 /** An external memory block */
 struct external_memory {
+	/** Next lower block allocated upwards, or UNULL
+	 *
+	 * This is used only for blocks allocated upwards from the
+	 * base of the heap.
+	 */
+	userptr_t prev;
 	/** Size of this memory block (excluding this header) */
 	size_t size;
 	/** Block is currently in use */
 	int used;
 };
 
+/** Base of heap */
+static userptr_t base = UNULL;
+
 /** Top of heap */
 static userptr_t top = UNULL;
 
 /** Bottom of heap (current lowest allocated block) */
 static userptr_t bottom = UNULL;
 
+/** Current highest block allocated upwards, or UNULL */
+static userptr_t low = UNULL;
+
+/** Start of memory allocated upwards */
+static userptr_t low_start = UNULL;
+
 /** Remaining space on heap */
 static size_t heap_size;
 
@@ -119,7 +134,6 @@ size_t largest_memblock ( userptr_t *start ) {
  *
  */
 static void init_eheap ( void ) {
-	userptr_t base;
 
 	heap_size = largest_memblock ( &base );
 	bottom = top = userptr_add ( base, heap_size );
@@ -127,6 +141,35 @@ static void init_eheap ( void ) {
 	      user_to_phys ( top, 0 ), heap_size );
 }
 
+/**
+ * Get lowest address in use by blocks allocated downwards
+ *
+ * @ret ceiling		Lowest address in use
+ */
+static userptr_t eceiling ( void ) {
+
+	/* The lowest block's header lies immediately below the block */
+	return ( ( bottom == top ) ?
+		 top : userptr_add ( bottom, -sizeof ( struct external_memory ) ));
+}
+
+/**
+ * Get end of memory allocated upwards
+ *
+ * @ret floor		Lowest address available for blocks allocated downwards
+ */
+static userptr_t efloor ( void ) {
+	struct external_memory extmem;
+
+	/* Use base of heap if nothing is allocated upwards */
+	if ( ! low )
+		return base;
+
+	/* Otherwise, use end of highest block allocated upwards */
+	copy_from_user ( &extmem, low, -sizeof ( extmem ), sizeof ( extmem ) );
+	return userptr_add ( low, extmem.size );
+}
+
 /**
  * Collect free blocks
  *
@@ -145,8 +188,33 @@ static void ecollect_free ( void ) {
 		      user_to_phys ( bottom, extmem.size ) );
 		len = ( extmem.size + sizeof ( extmem ) );
 		bottom = userptr_add ( bottom, len );
-		heap_size += len;
 	}
+
+	/* Walk the list of blocks allocated upwards and collect empty blocks */
+	while ( low ) {
+		copy_from_user ( &extmem, low, -sizeof ( extmem ),
+				 sizeof ( extmem ) );
+		if ( extmem.used )
+			break;
+		DBG ( "EXTMEM freeing low [%lx,%lx)\n", user_to_phys ( low, 0 ),
+		      user_to_phys ( low, extmem.size ) );
+		low = extmem.prev;
+	}
+
+	/* Recalculate remaining space on heap */
+	heap_size = userptr_sub ( eceiling(), efloor() );
+}
+
+/**
+ * Hide heap from memory map
+ *
+ */
+static void ehide ( void ) {
+	userptr_t start;
+
+	/* Hide everything from the lowest block to the top of the heap */
+	start = ( low ? low_start : eceiling() );
+	hide_umalloc ( user_to_phys ( start, 0 ), user_to_phys ( top, 0 ) );
 }
 
 /**
@@ -165,7 +233,7 @@ static userptr_t memtop_urealloc ( userptr_t ptr, size_t new_size ) {
 	size_t align;
 
 	/* (Re)initialise external memory allocator if necessary */
-	if ( bottom == top )
+	if ( ( bottom == top ) && ! low )
 		init_eheap();
 
 	/* Get block properties into extmem */
@@ -175,14 +243,15 @@ static userptr_t memtop_urealloc ( userptr_t ptr, size_t new_size ) {
 				 sizeof ( extmem ) );
 	} else {
 		/* Create a zero-length block */
-		if ( heap_size < sizeof ( extmem ) ) {
+		if ( heap_size < ( 2 * sizeof ( extmem ) ) ) {
 			DBG ( "EXTMEM out of space\n" );
 			return UNULL;
 		}
 		ptr = bottom = userptr_add ( bottom, -sizeof ( extmem ) );
-		heap_size -= sizeof ( extmem );
+		heap_size = userptr_sub ( eceiling(), efloor() );
 		DBG ( "EXTMEM allocating [%lx,%lx)\n",
 		      user_to_phys ( ptr, 0 ), user_to_phys ( ptr, 0 ) );
+		extmem.prev = UNULL;
 		extmem.size = 0;
 	}
 	extmem.used = ( new_size > 0 );
@@ -190,12 +259,12 @@ static userptr_t memtop_urealloc ( userptr_t ptr, size_t new_size ) {
 	/* Expand/shrink block if possible */
 	if ( ptr == bottom ) {
 		/* Update block */
-		if ( new_size > ( heap_size - extmem.size ) ) {
+		new = userptr_add ( ptr, - ( new_size - extmem.size ) );
+		align = ( user_to_phys ( new, 0 ) & ( EM_ALIGN - 1 ) );
+		if ( ( new_size + align ) > ( heap_size - extmem.size ) ) {
 			DBG ( "EXTMEM out of space\n" );
 			return UNULL;
 		}
-		new = userptr_add ( ptr, - ( new_size - extmem.size ) );
-		align = ( user_to_phys ( new, 0 ) & ( EM_ALIGN - 1 ) );
 		new_size += align;
 		new = userptr_add ( new, -align );
 		DBG ( "EXTMEM expanding [%lx,%lx) to [%lx,%lx)\n",
@@ -208,6 +277,18 @@ static userptr_t memtop_urealloc ( userptr_t ptr, size_t new_size ) {
 		bottom = new;
 		heap_size -= ( new_size - extmem.size );
 		extmem.size = new_size;
+	} else if ( ptr == low ) {
+		/* Update highest block allocated upwards in place */
+		if ( new_size > ( heap_size + extmem.size ) ) {
+			DBG ( "EXTMEM out of space\n" );
+			return UNULL;
+		}
+		DBG ( "EXTMEM resizing [%lx,%lx) to [%lx,%lx)\n",
+		      user_to_phys ( ptr, 0 ),
+		      user_to_phys ( ptr, extmem.size ),
+		      user_to_phys ( ptr, 0 ),
+		      user_to_phys ( ptr, new_size ) );
+		extmem.size = new_size;
 	} else {
 		/* Cannot expand; can only pretend to shrink */
 		if ( new_size > extmem.size ) {
@@ -225,11 +306,68 @@ static userptr_t memtop_urealloc ( userptr_t ptr, size_t new_size ) {
 
 	/* Collect any free blocks and update hidden memory region */
 	ecollect_free();
-	hide_umalloc ( user_to_phys ( bottom, ( ( bottom == top ) ?
-						0 : -sizeof ( extmem ) ) ),
-		       user_to_phys ( top, 0 ) );
+	ehide();
 
 	return ( new_size ? new : UNOWHERE );
 }
 
+/**
+ * Allocate external memory upwards from the base of the heap
+ *
+ * @v size		Requested size
+ * @v min		Minimum physical address
+ * @v headroom		Free space to leave below the allocated memory
+ * @ret ptr		Allocated memory, or UNULL
+ *
+ * The memory is placed above any other memory allocated in this way,
+ * so that a sequence of allocations will be contiguous (apart from
+ * the requested headroom and alignment padding) and in order of
+ * allocation.  The highest such block may be resized in place using
+ * urealloc(), and any such block may be freed using ufree().
+ */
+userptr_t memtop_umalloc_low ( size_t size, physaddr_t min,
+			       size_t headroom ) {
+	struct external_memory extmem;
+	userptr_t start;
+	userptr_t ptr;
+	size_t len;
+
+	/* (Re)initialise external memory allocator if necessary */
+	if ( ( bottom == top ) && ! low )
+		init_eheap();
+
+	/* Place block above any existing blocks allocated upwards */
+	start = efloor();
+	if ( user_to_phys ( start, 0 ) < min )
+		start = phys_to_user ( min );
+	len = ( sizeof ( extmem ) + headroom );
+	len += ( ( -user_to_phys ( start, len ) ) & ( EM_ALIGN - 1 ) );
+	ptr = userptr_add ( start, len );
+
+	/* Check for available space */
+	if ( ( userptr_sub ( eceiling(), ptr ) < 0 ) ||
+	     ( size > ( ( size_t ) userptr_sub ( eceiling(), ptr ) ) ) ) {
+		DBG ( "EXTMEM out of space above %lx\n",
+		      user_to_phys ( start, 0 ) );
+		return UNULL;
+	}
+	DBG ( "EXTMEM allocating [%lx,%lx) upwards\n",
+	      user_to_phys ( ptr, 0 ), user_to_phys ( ptr, size ) );
+
+	/* Record block */
+	extmem.prev = low;
+	extmem.size = size;
+	extmem.used = ( size > 0 );
+	copy_to_user ( ptr, -sizeof ( extmem ), &extmem, sizeof ( extmem ) );
+	if ( ! low )
+		low_start = userptr_add ( ptr, -sizeof ( extmem ) );
+	low = ptr;
+
+	/* Collect any free blocks and update hidden memory region */
+	ecollect_free();
+	ehide();
+
+	return ( size ? ptr : UNOWHERE );
+}
+
 PROVIDE_UMALLOC ( memtop, urealloc, memtop_urealloc );
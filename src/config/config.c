@@ -182,6 +182,15 @@ REQUIRE_OBJECT ( efi_image );
 #ifdef IMAGE_SDI
 REQUIRE_OBJECT ( sdi );
 #endif
+#ifdef IMAGE_GZIP
+REQUIRE_OBJECT ( gzip );
+#endif
+#ifdef IMAGE_ZSTD
+REQUIRE_OBJECT ( zstd );
+#endif
+#ifdef IMAGE_XZ
+REQUIRE_OBJECT ( xz );
+#endif
 
 /*
  * Drag in all requested commands
@@ -275,6 +284,18 @@ REQUIRE_OBJECT ( ipstat_cmd );
 #ifdef PROFSTAT_CMD
 REQUIRE_OBJECT ( profstat_cmd );
 #endif
+#ifdef PEERSTAT_CMD
+REQUIRE_OBJECT ( peerstat_cmd );
+#endif
+#ifdef TIMELINE_CMD
+REQUIRE_OBJECT ( timeline_cmd );
+#endif
+#ifdef METRICS_CMD
+REQUIRE_OBJECT ( metrics_cmd );
+#endif
+#ifdef BENCH_CMD
+REQUIRE_OBJECT ( bench_cmd );
+#endif
 #ifdef NTP_CMD
 REQUIRE_OBJECT ( ntp_cmd );
 #endif
@@ -299,6 +320,12 @@ REQUIRE_OBJECT ( gdbidt );
 REQUIRE_OBJECT ( gdbudp );
 REQUIRE_OBJECT ( gdbstub_cmd );
 #endif
+#ifdef AUTOBOOT_CONCURRENT
+REQUIRE_OBJECT ( autoboot_concurrent );
+#endif
+#ifdef METRICS_SYSLOG
+REQUIRE_OBJECT ( metrics_syslog );
+#endif
 
 /*
  * Drag in objects that are always required, but not dragged in via
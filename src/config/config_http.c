@@ -46,6 +46,18 @@ REQUIRE_OBJECT ( httpntlm );
 #ifdef HTTP_ENC_PEERDIST
 REQUIRE_OBJECT ( peerdist );
 #endif
+#ifdef HTTP_ENC_GZIP
+REQUIRE_OBJECT ( httpgzip );
+#endif
+#ifdef HTTP_ENC_ZSTD
+REQUIRE_OBJECT ( httpzstd );
+#endif
+#ifdef HTTP_ENC_XZ
+REQUIRE_OBJECT ( httpxz );
+#endif
+#ifdef HTTP_PEERDIST_SERVER
+REQUIRE_OBJECT ( peerserve );
+#endif
 #ifdef HTTP_HACK_GCE
 REQUIRE_OBJECT ( httpgce );
 #endif
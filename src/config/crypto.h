@@ -15,6 +15,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** AES-CBC block cipher */
 #define CRYPTO_CIPHER_AES_CBC
 
+/** AES-GCM authenticated cipher
+ *
+ * Note that AES-GCM is required for TLSv1.3.
+ */
+#define CRYPTO_CIPHER_AES_GCM
+
 /** MD5 digest algorithm
  *
  * Note that use of MD5 is implicit when using TLSv1.1 or earlier.
@@ -42,6 +48,17 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 /** SHA-512 digest algorithm */
 #define CRYPTO_DIGEST_SHA512
 
+/** Calculate image digests during download
+ *
+ * Calculating the digest of an image while it is being downloaded
+ * allows signature verification and the digest commands to avoid
+ * making a second pass over the image data, at the cost of hashing
+ * every downloaded image whether or not it is subsequently used.
+ */
+//#define DOWNLOAD_DIGEST_MD5
+//#define DOWNLOAD_DIGEST_SHA1
+//#define DOWNLOAD_DIGEST_SHA256
+
 /** Margin of error (in seconds) allowed in signed timestamps
  *
  * We default to allowing a reasonable margin of error: 12 hours to
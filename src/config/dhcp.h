@@ -88,6 +88,14 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define PXEBS_MAX_TIMEOUT_SEC		3
 //#define PXEBS_MAX_TIMEOUT_SEC		7	/* as per PXE spec */
 
+/*
+ * Request a two-message exchange using Rapid Commit (RFC 4039 for
+ * DHCPv4, RFC 8415 for DHCPv6).  Servers that do not support Rapid
+ * Commit will ignore the request, and the normal four-message
+ * exchange will be used.
+ */
+#define DHCP_DISC_RAPID_COMMIT		1
+
 #include <config/local/dhcp.h>
 
 #endif /* CONFIG_DHCP_H */
@@ -79,6 +79,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define HTTP_AUTH_DIGEST	/* Digest authentication */
 //#define HTTP_AUTH_NTLM	/* NTLM authentication */
 //#define HTTP_ENC_PEERDIST	/* PeerDist content encoding */
+//#define HTTP_ENC_GZIP		/* gzip and deflate content encodings */
+//#define HTTP_ENC_ZSTD		/* zstd content encoding */
+//#define HTTP_ENC_XZ		/* xz content encoding */
+//#define HTTP_PEERDIST_SERVER	/* Serve PeerDist content to peers */
 //#define HTTP_HACK_GCE		/* Google Compute Engine hacks */
 
 /*
@@ -116,6 +120,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define	IMAGE_PNG		/* PNG image support */
 #define	IMAGE_DER		/* DER image support */
 #define	IMAGE_PEM		/* PEM image support */
+//#define	IMAGE_GZIP		/* GZIP image support */
+//#define	IMAGE_ZSTD		/* Zstandard image support */
+//#define	IMAGE_XZ		/* XZ image support */
 
 /*
  * Command-line commands to include
@@ -152,6 +159,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 //#define CONSOLE_CMD		/* Console command */
 //#define IPSTAT_CMD		/* IP statistics commands */
 //#define PROFSTAT_CMD		/* Profiling commands */
+//#define PEERSTAT_CMD		/* PeerDist statistics commands */
+//#define TIMELINE_CMD		/* Boot timeline commands */
+//#define METRICS_CMD		/* Metrics commands */
+//#define BENCH_CMD		/* Benchmark commands */
 //#define NTP_CMD		/* NTP commands */
 //#define CERT_CMD		/* Certificate management commands */
 
@@ -162,6 +173,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #undef	NONPNP_HOOK_INT19	/* Hook INT19 on non-PnP BIOSes */
 #define	AUTOBOOT_ROM_FILTER	/* Autoboot only devices matching our ROM */
 
+/*
+ * Automatic booting options
+ *
+ */
+#undef	AUTOBOOT_CONCURRENT	/* Configure all network devices concurrently */
+
 /*
  * Virtual network devices
  *
@@ -189,6 +206,11 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #undef	BUILD_ID		/* Include a custom build ID string,
 				 * e.g "test-foo" */
 #undef	NULL_TRAP		/* Attempt to catch NULL function calls */
+#undef	BOOT_TIMELINE		/* Record a timeline of boot phases */
+#undef	METRICS_SYSLOG		/* Send metrics to system log at boot exit */
+#define	METRICS_SYSLOG_INTERVAL	0 /* Also send metrics to system log
+				   * periodically (in seconds, 0 to
+				   * disable) */
 #undef	GDBSERIAL		/* Remote GDB debugging over serial */
 #undef	GDBUDP			/* Remote GDB debugging over UDP
 				 * (both may be set) */
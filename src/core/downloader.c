@@ -34,7 +34,11 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/umalloc.h>
 #include <ipxe/image.h>
 #include <ipxe/xferbuf.h>
+#include <ipxe/imgdigest.h>
 #include <ipxe/downloader.h>
+#include <ipxe/timer.h>
+#include <ipxe/timeline.h>
+#include <ipxe/metrics.h>
 
 /** @file
  *
@@ -56,6 +60,25 @@ struct downloader {
 	struct image *image;
 	/** Data transfer buffer */
 	struct xfer_buffer buffer;
+	/** Time at which download started */
+	unsigned long started;
+};
+
+/** Downloaded length metric */
+static struct metric download_length_metric __metric = {
+	.name = "download.length",
+	.unit = "bytes",
+};
+
+/** Download duration metric */
+static struct metric download_time_metric __metric = {
+	.name = "download.time",
+	.unit = "ms",
+};
+
+/** Download failure metric */
+static struct metric download_failure_metric __metric = {
+	.name = "download.failure",
 };
 
 /**
@@ -79,6 +102,18 @@ static void downloader_free ( struct refcnt *refcnt ) {
  */
 static void downloader_finished ( struct downloader *downloader, int rc ) {
 
+	/* Record end of download */
+	timeline_end ( "download", downloader, rc );
+	if ( rc == 0 ) {
+		metric_sample ( &download_length_metric,
+				downloader->buffer.len );
+		metric_sample ( &download_time_metric,
+				( ( currticks() - downloader->started ) /
+				  TICKS_PER_MS ) );
+	} else {
+		metric_inc ( &download_failure_metric );
+	}
+
 	/* Log download status */
 	if ( rc == 0 ) {
 		syslog ( LOG_NOTICE, "Downloaded \"%s\"\n",
@@ -91,6 +126,13 @@ static void downloader_finished ( struct downloader *downloader, int rc ) {
 	/* Update image length */
 	downloader->image->len = downloader->buffer.len;
 
+	/* Finalise (or discard) any digests calculated during download */
+	if ( rc == 0 ) {
+		image_digest_final ( downloader->image );
+	} else {
+		image_digest_discard ( downloader->image );
+	}
+
 	/* Shut down interfaces */
 	intf_shutdown ( &downloader->xfer, rc );
 	intf_shutdown ( &downloader->job, rc );
@@ -146,8 +188,19 @@ static int downloader_progress ( struct downloader *downloader,
 static int downloader_deliver ( struct downloader *downloader,
 				struct io_buffer *iobuf,
 				struct xfer_metadata *meta ) {
+	size_t pos;
 	int rc;
 
+	/* Update any digests being calculated during download */
+	if ( downloader->image->digests ) {
+		pos = downloader->buffer.pos;
+		if ( meta->flags & XFER_FL_ABS_OFFSET )
+			pos = 0;
+		pos += meta->offset;
+		image_digest_update ( downloader->image, pos, iobuf->data,
+				      iob_len ( iobuf ) );
+	}
+
 	/* Add data to buffer */
 	if ( ( rc = xferbuf_deliver ( &downloader->buffer, iob_disown ( iobuf ),
 				      meta ) ) != 0 )
@@ -169,10 +222,26 @@ static int downloader_deliver ( struct downloader *downloader,
 static struct xfer_buffer *
 downloader_buffer ( struct downloader *downloader ) {
 
+	/* Data written directly to the buffer bypasses the digests
+	 * being calculated during download, so discard them.
+	 */
+	image_digest_discard ( downloader->image );
+
 	/* Provide direct access to underlying data transfer buffer */
 	return &downloader->buffer;
 }
 
+/**
+ * Get image being downloaded
+ *
+ * @v downloader	Downloader
+ * @ret image		Image
+ */
+static struct image * downloader_xfer_image ( struct downloader *downloader ) {
+
+	return downloader->image;
+}
+
 /**
  * Redirect data transfer interface
  *
@@ -216,6 +285,8 @@ static struct interface_operation downloader_xfer_operations[] = {
 	INTF_OP ( xfer_deliver, struct downloader *, downloader_deliver ),
 	INTF_OP ( xfer_buffer, struct downloader *, downloader_buffer ),
 	INTF_OP ( xfer_vredirect, struct downloader *, downloader_vredirect ),
+	INTF_OP ( downloader_image, struct downloader *,
+		  downloader_xfer_image ),
 	INTF_OP ( intf_close, struct downloader *, downloader_finished ),
 };
 
@@ -245,6 +316,21 @@ static struct interface_descriptor downloader_job_desc =
  *
  */
 
+/**
+ * Initialise data transfer buffer for an initrd
+ *
+ * @v xferbuf		Data transfer buffer
+ * @v image		Image
+ *
+ * Platforms able to place initrds directly at their final location
+ * during download may override this function.
+ */
+__weak void initrd_xferbuf_init ( struct xfer_buffer *xferbuf,
+				  struct image *image ) {
+
+	xferbuf_umalloc_init ( xferbuf, &image->data );
+}
+
 /**
  * Instantiate a downloader
  *
@@ -269,7 +355,17 @@ int create_downloader ( struct interface *job, struct image *image ) {
 	intf_init ( &downloader->xfer, &downloader_xfer_desc,
 		    &downloader->refcnt );
 	downloader->image = image_get ( image );
-	xferbuf_umalloc_init ( &downloader->buffer, &image->data );
+	if ( image->flags & IMAGE_INITRD ) {
+		initrd_xferbuf_init ( &downloader->buffer, image );
+	} else {
+		xferbuf_umalloc_init ( &downloader->buffer, &image->data );
+	}
+	downloader->started = currticks();
+	timeline_begin ( "download", downloader );
+
+	/* Start calculating digests during download */
+	if ( ( rc = image_digest_start ( image ) ) != 0 )
+		goto err;
 
 	/* Instantiate child objects and attach to our interfaces */
 	if ( ( rc = xfer_open_uri ( &downloader->xfer, image->uri ) ) != 0 )
@@ -285,3 +381,30 @@ int create_downloader ( struct interface *job, struct image *image ) {
 	ref_put ( &downloader->refcnt );
 	return rc;
 }
+
+/**
+ * Get image being downloaded via data transfer interface
+ *
+ * @v intf		Data transfer interface
+ * @ret image		Image, or NULL if not downloading to an image
+ *
+ * The caller must use image_get() to retain a reference to the
+ * image, if required.
+ */
+struct image * downloader_image ( struct interface *intf ) {
+	struct interface *dest;
+	downloader_image_TYPE ( void * ) *op =
+		intf_get_dest_op ( intf, downloader_image, &dest );
+	void *object = intf_object ( dest );
+	struct image *image;
+
+	if ( op ) {
+		image = op ( object );
+	} else {
+		/* Default is to not be downloading to an image */
+		image = NULL;
+	}
+
+	intf_put ( dest );
+	return image;
+}
@@ -0,0 +1,291 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/fec.h>
+
+/** @file
+ *
+ * Forward error correction
+ *
+ * We use a systematic Reed-Solomon erasure code over GF(2^8),
+ * constructed from a Cauchy matrix.  A group of k data symbols (each
+ * of which is a block of bytes) is extended with up to (256-k) repair
+ * symbols.  Repair symbol r is the sum of each data symbol i
+ * multiplied by the coefficient
+ *
+ *    1 / ( x_r + y_i ),  where x_r = k + r and y_i = i
+ *
+ * Since every square submatrix of a Cauchy matrix is invertible, any
+ * k of the data and repair symbols are sufficient to recover the
+ * whole group.
+ *
+ */
+
+/** Field generator polynomial (x^8 + x^4 + x^3 + x^2 + 1) */
+#define FEC_POLY 0x11d
+
+/** Exponent table (duplicated to avoid reducing sums of logarithms) */
+static uint8_t fec_exp[ 2 * 255 ];
+
+/** Logarithm table */
+static uint8_t fec_log[256];
+
+/**
+ * Construct field arithmetic tables, if not already done
+ *
+ */
+static void fec_init ( void ) {
+	unsigned int x = 1;
+	unsigned int i;
+
+	/* Do nothing if tables already exist */
+	if ( fec_exp[0] )
+		return;
+
+	/* Construct tables */
+	for ( i = 0 ; i < 255 ; i++ ) {
+		fec_exp[i] = fec_exp[ i + 255 ] = x;
+		fec_log[x] = i;
+		x <<= 1;
+		if ( x & 0x100 )
+			x ^= FEC_POLY;
+	}
+}
+
+/**
+ * Calculate multiplicative inverse
+ *
+ * @v value		Nonzero field element
+ * @ret inverse		Inverse
+ */
+static inline __attribute__ (( always_inline )) uint8_t
+fec_inverse ( uint8_t value ) {
+	return fec_exp[ 255 - fec_log[value] ];
+}
+
+/**
+ * Multiply two field elements
+ *
+ * @v a			Field element
+ * @v b			Field element
+ * @ret product		Product
+ */
+static inline __attribute__ (( always_inline )) uint8_t
+fec_mul ( uint8_t a, uint8_t b ) {
+	if ( ! ( a && b ) )
+		return 0;
+	return fec_exp[ fec_log[a] + fec_log[b] ];
+}
+
+/**
+ * Get encoding coefficient
+ *
+ * @v k			Number of data symbols within group
+ * @v row		Repair symbol index
+ * @v index		Data symbol index
+ * @ret coefficient	Coefficient
+ */
+uint8_t fec_coefficient ( unsigned int k, unsigned int row,
+			  unsigned int index ) {
+
+	/* Sanity checks */
+	assert ( index < k );
+	assert ( row < fec_max_rows ( k ) );
+
+	fec_init();
+	return fec_inverse ( ( k + row ) ^ index );
+}
+
+/**
+ * Add multiple of a block to another block
+ *
+ * @v coefficient	Coefficient
+ * @v src		Source block
+ * @v dst		Destination block
+ * @v len		Length of blocks
+ */
+void fec_mul_add ( uint8_t coefficient, const void *src, void *dst,
+		   size_t len ) {
+	const uint8_t *src_byte = src;
+	uint8_t *dst_byte = dst;
+	const uint8_t *exp;
+
+	/* Handle trivial coefficients */
+	if ( ! coefficient )
+		return;
+	if ( coefficient == 1 ) {
+		while ( len-- )
+			*(dst_byte++) ^= *(src_byte++);
+		return;
+	}
+
+	/* Multiply and add */
+	fec_init();
+	exp = &fec_exp[ fec_log[coefficient] ];
+	while ( len-- ) {
+		if ( *src_byte )
+			*dst_byte ^= exp[ fec_log[*src_byte] ];
+		src_byte++;
+		dst_byte++;
+	}
+}
+
+/**
+ * Multiply block by constant
+ *
+ * @v coefficient	Nonzero coefficient
+ * @v data		Block
+ * @v len		Length of block
+ */
+static void fec_scale ( uint8_t coefficient, void *data, size_t len ) {
+	uint8_t *byte = data;
+
+	for ( ; len-- ; byte++ )
+		*byte = fec_mul ( coefficient, *byte );
+}
+
+/**
+ * Construct repair symbol
+ *
+ * @v k			Number of data symbols within group
+ * @v row		Repair symbol index
+ * @v data		Data symbols (or NULL for an all-zeroes symbol)
+ * @v repair		Repair symbol to fill in
+ * @v len		Length of symbols
+ */
+void fec_encode ( unsigned int k, unsigned int row,
+		  const void * const *data, void *repair, size_t len ) {
+	unsigned int i;
+
+	memset ( repair, 0, len );
+	for ( i = 0 ; i < k ; i++ ) {
+		if ( data[i] ) {
+			fec_mul_add ( fec_coefficient ( k, row, i ), data[i],
+				      repair, len );
+		}
+	}
+}
+
+/**
+ * Recover missing data symbols
+ *
+ * @v k			Number of data symbols within group
+ * @v count		Number of missing data symbols
+ * @v rows		Indices of available repair symbols
+ * @v missing		Indices of missing data symbols
+ * @v blocks		Reduced repair symbols
+ * @v len		Length of symbols
+ * @ret rc		Return status code
+ *
+ * On entry, each block must contain the corresponding repair symbol
+ * with the contributions of all known data symbols already removed
+ * (using fec_coefficient() and fec_mul_add()).  On successful exit,
+ * blocks[i] will contain the data symbol missing[i].  Note that the
+ * list of block pointers may be reordered.
+ */
+int fec_recover ( unsigned int k, unsigned int count,
+		  const unsigned int *rows, const unsigned int *missing,
+		  void **blocks, size_t len ) {
+	uint8_t *matrix;
+	uint8_t *pivot_row;
+	uint8_t *row;
+	uint8_t tmp_row[count];
+	uint8_t inverse;
+	uint8_t factor;
+	void *tmp;
+	unsigned int pivot;
+	unsigned int i;
+	unsigned int j;
+	int rc;
+
+	/* Allocate and construct coefficient matrix */
+	matrix = malloc ( count * count );
+	if ( ! matrix ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	for ( i = 0 ; i < count ; i++ ) {
+		for ( j = 0 ; j < count ; j++ ) {
+			matrix[ i * count + j ] =
+				fec_coefficient ( k, rows[i], missing[j] );
+		}
+	}
+
+	/* Perform Gauss-Jordan elimination, applying each row
+	 * operation to the blocks as well as to the matrix.
+	 */
+	for ( i = 0 ; i < count ; i++ ) {
+
+		/* Find pivot */
+		for ( pivot = i ; pivot < count ; pivot++ ) {
+			if ( matrix[ pivot * count + i ] )
+				break;
+		}
+		if ( pivot == count ) {
+			/* Only possible with duplicate indices */
+			rc = -EINVAL;
+			goto err_singular;
+		}
+
+		/* Swap pivot row into place */
+		pivot_row = &matrix[ i * count ];
+		if ( pivot != i ) {
+			row = &matrix[ pivot * count ];
+			memcpy ( tmp_row, row, count );
+			memcpy ( row, pivot_row, count );
+			memcpy ( pivot_row, tmp_row, count );
+			tmp = blocks[pivot];
+			blocks[pivot] = blocks[i];
+			blocks[i] = tmp;
+		}
+
+		/* Normalise pivot row */
+		inverse = fec_inverse ( pivot_row[i] );
+		fec_scale ( inverse, pivot_row, count );
+		fec_scale ( inverse, blocks[i], len );
+
+		/* Eliminate column from all other rows */
+		for ( j = 0 ; j < count ; j++ ) {
+			row = &matrix[ j * count ];
+			factor = row[i];
+			if ( ( j == i ) || ( ! factor ) )
+				continue;
+			fec_mul_add ( factor, pivot_row, row, count );
+			fec_mul_add ( factor, blocks[i], blocks[j], len );
+		}
+	}
+
+	rc = 0;
+
+ err_singular:
+	free ( matrix );
+ err_alloc:
+	return rc;
+}
@@ -35,6 +35,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/umalloc.h>
 #include <ipxe/uri.h>
 #include <ipxe/image.h>
+#include <ipxe/imgdigest.h>
+#include <ipxe/timeline.h>
 
 /** @file
  *
@@ -77,6 +79,7 @@ static void free_image ( struct refcnt *refcnt ) {
 	free ( image->cmdline );
 	uri_put ( image->uri );
 	ufree ( image->data );
+	image_digest_discard ( image );
 	image_put ( image->replacement );
 	free ( image );
 }
@@ -327,7 +330,10 @@ int image_exec ( struct image *image ) {
 	syslog ( LOG_NOTICE, "Executing \"%s\"\n", image->name );
 
 	/* Try executing the image */
-	if ( ( rc = image->type->exec ( image ) ) != 0 ) {
+	timeline_begin ( "exec", image );
+	rc = image->type->exec ( image );
+	timeline_end ( "exec", image, rc );
+	if ( rc != 0 ) {
 		DBGC ( image, "IMAGE %s could not execute: %s\n",
 		       image->name, strerror ( rc ) );
 		/* Do not return yet; we still have clean-up to do */
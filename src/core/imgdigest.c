@@ -0,0 +1,217 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/image.h>
+#include <ipxe/md5.h>
+#include <ipxe/sha1.h>
+#include <ipxe/sha256.h>
+#include <ipxe/imgdigest.h>
+#include <config/crypto.h>
+
+/** @file
+ *
+ * Image digests
+ *
+ * Verifying a signature over an image (or printing its digest)
+ * requires a full pass over the image data.  For large images, this
+ * second pass can take a significant amount of time.  To avoid this,
+ * the downloader may calculate digests on the fly as data arrives,
+ * and cache the result for later use.
+ *
+ * A cached digest is used only if the data was delivered strictly in
+ * order and covers the whole image.  In all other cases, the digest
+ * is recalculated from the image data.
+ */
+
+/** Digest algorithms to calculate during download */
+static struct digest_algorithm *image_digest_algorithms[] = {
+#ifdef DOWNLOAD_DIGEST_MD5
+	&md5_algorithm,
+#endif
+#ifdef DOWNLOAD_DIGEST_SHA1
+	&sha1_algorithm,
+#endif
+#ifdef DOWNLOAD_DIGEST_SHA256
+	&sha256_algorithm,
+#endif
+	NULL
+};
+
+/**
+ * Discard any digests calculated during download
+ *
+ * @v image		Image
+ */
+void image_digest_discard ( struct image *image ) {
+	struct image_digest *digest;
+
+	while ( ( digest = image->digests ) != NULL ) {
+		image->digests = digest->next;
+		free ( digest );
+	}
+}
+
+/**
+ * Add a digest to be calculated during download
+ *
+ * @v image		Image
+ * @v algorithm		Digest algorithm
+ * @ret rc		Return status code
+ */
+int image_digest_add ( struct image *image,
+		       struct digest_algorithm *algorithm ) {
+	struct image_digest *digest;
+
+	/* Allocate and initialise digest */
+	digest = zalloc ( sizeof ( *digest ) + algorithm->ctxsize +
+			  algorithm->digestsize );
+	if ( ! digest )
+		return -ENOMEM;
+	digest->digest = algorithm;
+	digest->ctx = ( ( ( void * ) digest ) + sizeof ( *digest ) );
+	digest->out = ( digest->ctx + algorithm->ctxsize );
+	digest_init ( algorithm, digest->ctx );
+
+	/* Add to image's list of digests */
+	digest->next = image->digests;
+	image->digests = digest;
+
+	return 0;
+}
+
+/**
+ * Start calculating digests during download
+ *
+ * @v image		Image
+ * @ret rc		Return status code
+ */
+int image_digest_start ( struct image *image ) {
+	struct digest_algorithm **algorithms;
+	int rc;
+
+	/* Discard any existing digests */
+	image_digest_discard ( image );
+
+	/* Add each configured digest */
+	for ( algorithms = image_digest_algorithms ; *algorithms ;
+	      algorithms++ ) {
+		if ( ( rc = image_digest_add ( image, *algorithms ) ) != 0 ) {
+			image_digest_discard ( image );
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Update digests with newly downloaded data
+ *
+ * @v image		Image
+ * @v offset		Offset of data within image
+ * @v data		Data
+ * @v len		Length of data
+ *
+ * Any data not delivered in strict order causes all digests to be
+ * discarded, since they would no longer describe the image contents.
+ */
+void image_digest_update ( struct image *image, size_t offset,
+			   const void *data, size_t len ) {
+	struct image_digest *digest;
+
+	for ( digest = image->digests ; digest ; digest = digest->next ) {
+		if ( digest->final || ( offset != digest->len ) ) {
+			DBGC ( image, "IMAGE %s discarding %s digest at "
+			       "offset %#zx\n", image->name,
+			       digest->digest->name, offset );
+			image_digest_discard ( image );
+			return;
+		}
+		digest_update ( digest->digest, digest->ctx, data, len );
+		digest->len += len;
+	}
+}
+
+/**
+ * Finalise digests calculated during download
+ *
+ * @v image		Image
+ */
+void image_digest_final ( struct image *image ) {
+	struct image_digest *digest;
+
+	for ( digest = image->digests ; digest ; digest = digest->next ) {
+		if ( digest->final )
+			continue;
+		digest_final ( digest->digest, digest->ctx, digest->out );
+		digest->final = 1;
+		DBGC ( image, "IMAGE %s cached %s digest:\n",
+		       image->name, digest->digest->name );
+		DBGC_HDA ( image, 0, digest->out,
+			   digest->digest->digestsize );
+	}
+}
+
+/**
+ * Calculate image digest
+ *
+ * @v image		Image
+ * @v algorithm		Digest algorithm
+ * @v out		Buffer for digest output
+ */
+void image_digest ( struct image *image, struct digest_algorithm *algorithm,
+		    void *out ) {
+	struct image_digest *digest;
+	uint8_t ctx[ algorithm->ctxsize ];
+	uint8_t block[ algorithm->blocksize ];
+	size_t offset = 0;
+	size_t remaining;
+	size_t frag_len;
+
+	/* Use cached digest, if it covers the whole image */
+	for ( digest = image->digests ; digest ; digest = digest->next ) {
+		if ( ( digest->digest == algorithm ) && digest->final &&
+		     ( digest->len == image->len ) ) {
+			memcpy ( out, digest->out, algorithm->digestsize );
+			return;
+		}
+	}
+
+	/* Otherwise, calculate digest one block at a time */
+	digest_init ( algorithm, ctx );
+	for ( remaining = image->len ; remaining ; remaining -= frag_len ) {
+		frag_len = remaining;
+		if ( frag_len > sizeof ( block ) )
+			frag_len = sizeof ( block );
+		copy_from_user ( block, image->data, offset, frag_len );
+		digest_update ( algorithm, ctx, block, frag_len );
+		offset += frag_len;
+	}
+	digest_final ( algorithm, ctx, out );
+}
@@ -0,0 +1,315 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/interface.h>
+#include <ipxe/xfer.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/deflate.h>
+#include <ipxe/inflate.h>
+
+/** @file
+ *
+ * Streaming decompression filter
+ *
+ * The decompressor requires the preceding window of output to be
+ * present in the output buffer.  We therefore retain the history
+ * window at the start of the output buffer, and deliver and discard
+ * everything before it whenever the free space runs low.  The output
+ * buffer is enlarged as needed to hold the window, which is not known
+ * until the decompressor has parsed the stream header.
+ *
+ */
+
+/** A streaming decompression filter */
+struct inflater {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Decompressed data transfer interface */
+	struct interface xfer;
+	/** Compressed data transfer interface */
+	struct interface raw;
+	/** Decompression algorithm */
+	struct inflate_algorithm *algorithm;
+	/** Decompressor context (in external memory) */
+	userptr_t ctx;
+	/** Output chunk */
+	struct deflate_chunk out;
+	/** Offset of first undelivered byte within output buffer */
+	size_t pending;
+	/** Decompression has finished */
+	int finished;
+};
+
+/**
+ * Get decompressor context
+ *
+ * @v inflater		Streaming decompression filter
+ * @ret ctx		Decompressor context
+ */
+static inline void * inflate_ctx ( struct inflater *inflater ) {
+	return user_to_virt ( inflater->ctx, 0 );
+}
+
+/**
+ * Free streaming decompression filter
+ *
+ * @v refcnt		Reference count
+ */
+static void inflate_free ( struct refcnt *refcnt ) {
+	struct inflater *inflater =
+		container_of ( refcnt, struct inflater, refcnt );
+
+	ufree ( inflater->out.data );
+	ufree ( inflater->ctx );
+	free ( inflater );
+}
+
+/**
+ * Close streaming decompression filter
+ *
+ * @v inflater		Streaming decompression filter
+ * @v rc		Reason for close
+ */
+static void inflate_close ( struct inflater *inflater, int rc ) {
+
+	intfs_shutdown ( rc, &inflater->raw, &inflater->xfer, NULL );
+}
+
+/**
+ * Deliver decompressed data and discard all but the history window
+ *
+ * @v inflater		Streaming decompression filter
+ * @ret rc		Return status code
+ */
+static int inflate_flush ( struct inflater *inflater ) {
+	struct inflate_algorithm *algorithm = inflater->algorithm;
+	struct deflate_chunk *out = &inflater->out;
+	userptr_t data;
+	size_t window;
+	size_t history;
+	size_t len;
+	int rc;
+
+	/* Deliver any undelivered data */
+	while ( inflater->pending < out->offset ) {
+		len = ( out->offset - inflater->pending );
+		if ( len > INFLATE_DELIVER_LEN )
+			len = INFLATE_DELIVER_LEN;
+		if ( ( rc = xfer_deliver_raw ( &inflater->xfer,
+					       user_to_virt ( out->data,
+							      inflater->pending ),
+					       len ) ) != 0 ) {
+			DBGC ( inflater, "INFLATE %p could not deliver: %s\n",
+			       inflater, strerror ( rc ) );
+			return rc;
+		}
+		inflater->pending += len;
+	}
+
+	/* Move history window to start of output buffer */
+	window = algorithm->window ( inflate_ctx ( inflater ) );
+	if ( out->offset > window ) {
+		history = ( out->offset - window );
+		memmove_user ( out->data, 0, out->data, history, window );
+		out->offset = window;
+		inflater->pending = window;
+	}
+
+	/* Enlarge output buffer if the history window occupies more
+	 * than half of it, so that the cost of moving the window
+	 * remains proportional to the amount of data delivered.
+	 */
+	len = ( ( 2 * out->offset ) + algorithm->step );
+	if ( len > out->len ) {
+		data = urealloc ( out->data, len );
+		if ( ! data ) {
+			DBGC ( inflater, "INFLATE %p could not enlarge buffer "
+			       "to %#zx bytes\n", inflater, len );
+			return -ENOMEM;
+		}
+		out->data = data;
+		out->len = len;
+	}
+
+	return 0;
+}
+
+/**
+ * Receive compressed data
+ *
+ * @v inflater		Streaming decompression filter
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ *
+ * Any positioning metadata refers to the compressed data and so is
+ * ignored.  (This includes the seek used by HTTP to presize the
+ * receive buffer to the compressed length.)
+ */
+static int inflate_deliver ( struct inflater *inflater,
+			     struct io_buffer *iobuf,
+			     struct xfer_metadata *meta __unused ) {
+	struct inflate_algorithm *algorithm = inflater->algorithm;
+	struct deflate_chunk *out = &inflater->out;
+	struct deflate_chunk in;
+	int rc;
+
+	/* Decompress data, flushing output whenever free space runs
+	 * low.  Continue after the input is exhausted for as long as
+	 * decompression is being held up by lack of output space.
+	 */
+	deflate_chunk_init ( &in, virt_to_user ( iobuf->data ), 0,
+			     iob_len ( iobuf ) );
+	while ( ( ( in.offset < in.len ) ||
+		  ( ( out->len - out->offset ) < algorithm->step ) ) &&
+		! inflater->finished ) {
+
+		/* Flush output if free space is running low */
+		if ( ( out->len - out->offset ) < algorithm->step ) {
+			if ( ( rc = inflate_flush ( inflater ) ) != 0 )
+				goto err;
+		}
+
+		/* Decompress */
+		if ( ( rc = algorithm->decompress ( inflate_ctx ( inflater ),
+						    &in, out ) ) != 0 ) {
+			DBGC ( inflater, "INFLATE %p could not decompress: "
+			       "%s\n", inflater, strerror ( rc ) );
+			goto err;
+		}
+		assert ( out->offset <= out->len );
+
+		/* Ignore any trailing data */
+		inflater->finished =
+			algorithm->finished ( inflate_ctx ( inflater ) );
+	}
+
+	free_iob ( iobuf );
+	return 0;
+
+ err:
+	free_iob ( iobuf );
+	inflate_close ( inflater, rc );
+	return rc;
+}
+
+/**
+ * Close compressed data transfer interface
+ *
+ * @v inflater		Streaming decompression filter
+ * @v rc		Reason for close
+ */
+static void inflate_raw_close ( struct inflater *inflater, int rc ) {
+
+	/* Fail if compressed data ended prematurely */
+	if ( ( rc == 0 ) && ! inflater->finished ) {
+		DBGC ( inflater, "INFLATE %p truncated compressed data\n",
+		       inflater );
+		rc = -EINVAL;
+	}
+
+	/* Deliver any remaining data */
+	if ( rc == 0 )
+		rc = inflate_flush ( inflater );
+
+	/* Close filter */
+	inflate_close ( inflater, rc );
+}
+
+/** Streaming decompression filter decompressed data interface operations */
+static struct interface_operation inflate_xfer_operations[] = {
+	INTF_OP ( intf_close, struct inflater *, inflate_close ),
+};
+
+/** Streaming decompression filter decompressed data interface descriptor */
+static struct interface_descriptor inflate_xfer_desc =
+	INTF_DESC_PASSTHRU ( struct inflater, xfer,
+			     inflate_xfer_operations, raw );
+
+/** Streaming decompression filter compressed data interface operations */
+static struct interface_operation inflate_raw_operations[] = {
+	INTF_OP ( xfer_deliver, struct inflater *, inflate_deliver ),
+	INTF_OP ( intf_close, struct inflater *, inflate_raw_close ),
+};
+
+/** Streaming decompression filter compressed data interface descriptor */
+static struct interface_descriptor inflate_raw_desc =
+	INTF_DESC_PASSTHRU ( struct inflater, raw,
+			     inflate_raw_operations, xfer );
+
+/**
+ * Add streaming decompression filter
+ *
+ * @v xfer		Data transfer interface to receive decompressed data
+ * @v raw		Data transfer interface providing compressed data
+ * @v algorithm		Decompression algorithm
+ * @ret rc		Return status code
+ */
+int inflate_filter ( struct interface *xfer, struct interface *raw,
+		     struct inflate_algorithm *algorithm ) {
+	struct inflater *inflater;
+	userptr_t buffer;
+
+	/* Allocate and initialise structure */
+	inflater = zalloc ( sizeof ( *inflater ) );
+	if ( ! inflater )
+		goto err_alloc;
+	ref_init ( &inflater->refcnt, inflate_free );
+	intf_init ( &inflater->xfer, &inflate_xfer_desc, &inflater->refcnt );
+	intf_init ( &inflater->raw, &inflate_raw_desc, &inflater->refcnt );
+	inflater->algorithm = algorithm;
+
+	/* Allocate decompressor context.  This may be too large for
+	 * the heap (e.g. when it includes a block buffer).
+	 */
+	inflater->ctx = umalloc ( algorithm->ctxsize );
+	if ( ! inflater->ctx )
+		goto err_ctx;
+	algorithm->init ( inflate_ctx ( inflater ) );
+
+	/* Allocate output buffer */
+	buffer = umalloc ( INFLATE_BUFFER_LEN );
+	if ( ! buffer )
+		goto err_buffer;
+	deflate_chunk_init ( &inflater->out, buffer, 0, INFLATE_BUFFER_LEN );
+
+	/* Attach to parent interfaces, mortalise self, and return */
+	intf_plug_plug ( &inflater->xfer, xfer );
+	intf_plug_plug ( &inflater->raw, raw );
+	ref_put ( &inflater->refcnt );
+	return 0;
+
+ err_buffer:
+ err_ctx:
+	ref_put ( &inflater->refcnt );
+ err_alloc:
+	return -ENOMEM;
+}
@@ -0,0 +1,186 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <syslog.h>
+#include <ipxe/vsprintf.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/profile.h>
+#include <ipxe/settings.h>
+#include <ipxe/metrics.h>
+
+/** @file
+ *
+ * Metrics
+ *
+ * Network device statistics, registered metrics and profiler
+ * summaries are exported in a machine-readable form, as one JSON
+ * object per line.  The lines may be sent to the system log, or
+ * retrieved via the "metrics" setting (e.g. for submission to a
+ * central collector via an HTTP POST).
+ *
+ */
+
+/**
+ * Format metrics as JSON lines
+ *
+ * @v buf		Buffer to fill in (or NULL)
+ * @v len		Length of buffer
+ * @ret len		Length of formatted metrics (excluding NUL)
+ */
+size_t metrics_format ( char *buf, size_t len ) {
+	struct net_device *netdev;
+	struct metric *metric;
+	struct profiler *profiler;
+	size_t used = 0;
+
+	/* Ensure buffer is terminated even if there are no metrics */
+	if ( len )
+		buf[0] = '\0';
+
+	/* Format network device statistics */
+	for_each_netdev ( netdev ) {
+		used += ssnprintf ( ( buf + used ), ( len - used ),
+				    "{\"type\":\"netdev\",\"name\":\"%s\","
+				    "\"tx\":%d,\"tx_err\":%d,\"rx\":%d,"
+				    "\"rx_err\":%d}\n", netdev->name,
+				    netdev->tx_stats.good, netdev->tx_stats.bad,
+				    netdev->rx_stats.good,
+				    netdev->rx_stats.bad );
+	}
+
+	/* Format registered metrics */
+	for_each_table_entry ( metric, METRICS ) {
+		used += ssnprintf ( ( buf + used ), ( len - used ),
+				    "{\"type\":\"metric\",\"name\":\"%s\","
+				    "\"count\":%ld", metric->name,
+				    metric->count );
+		if ( metric->unit ) {
+			used += ssnprintf ( ( buf + used ), ( len - used ),
+					    ",\"unit\":\"%s\",\"total\":%ld,"
+					    "\"max\":%ld", metric->unit,
+					    metric->total, metric->max );
+		}
+		used += ssnprintf ( ( buf + used ), ( len - used ), "}\n" );
+	}
+
+	/* Format profiler summaries */
+	for_each_table_entry ( profiler, PROFILERS ) {
+		used += ssnprintf ( ( buf + used ), ( len - used ),
+				    "{\"type\":\"profiler\",\"name\":\"%s\","
+				    "\"count\":%d,\"mean\":%ld,"
+				    "\"stddev\":%ld}\n", profiler->name,
+				    profiler->count, profile_mean ( profiler ),
+				    profile_stddev ( profiler ) );
+	}
+
+	return used;
+}
+
+/**
+ * Format metrics as JSON lines into a newly allocated string
+ *
+ * @ret string		Formatted metrics, or NULL on failure
+ *
+ * The caller is responsible for eventually freeing the string.
+ */
+char * metrics_alloc ( void ) {
+	size_t len;
+	char *string;
+
+	/* Allocate and format string */
+	len = metrics_format ( NULL, 0 );
+	string = malloc ( len + 1 /* NUL */ );
+	if ( ! string )
+		return NULL;
+	metrics_format ( string, ( len + 1 /* NUL */ ) );
+
+	return string;
+}
+
+/**
+ * Send metrics to system log
+ *
+ * @ret rc		Return status code
+ *
+ * Metrics are logged regardless of the configured LOG_LEVEL, since
+ * this is an explicit request for export.
+ */
+int metrics_log ( void ) {
+	char *string;
+
+	/* Format metrics */
+	string = metrics_alloc();
+	if ( ! string )
+		return -ENOMEM;
+
+	/* Log metrics (one message per line) */
+	log_printf ( "%s", string );
+	free ( string );
+
+	return 0;
+}
+
+/**
+ * Fetch metrics setting
+ *
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int metrics_fetch ( void *data, size_t len ) {
+	size_t string_len;
+	char *string;
+
+	/* Format metrics */
+	string = metrics_alloc();
+	if ( ! string )
+		return -ENOMEM;
+	string_len = strlen ( string );
+
+	/* Copy metrics (excluding terminating NUL) */
+	if ( len > string_len )
+		len = string_len;
+	memcpy ( data, string, len );
+	free ( string );
+
+	return string_len;
+}
+
+/** Metrics setting */
+const struct setting metrics_setting __setting ( SETTING_MISC, metrics ) = {
+	.name = "metrics",
+	.description = "Metrics (JSON lines)",
+	.type = &setting_type_string,
+	.scope = &builtin_scope,
+};
+
+/** Metrics built-in setting */
+struct builtin_setting metrics_builtin_setting __builtin_setting = {
+	.setting = &metrics_setting,
+	.fetch = metrics_fetch,
+};
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <ipxe/init.h>
+#include <ipxe/timer.h>
+#include <ipxe/retry.h>
+#include <ipxe/metrics.h>
+#include <config/general.h>
+
+/** @file
+ *
+ * Metrics export via system log
+ *
+ * Metrics are sent to the system log at boot exit (i.e. immediately
+ * before handing over to the operating system) and, if
+ * METRICS_SYSLOG_INTERVAL is non-zero, periodically while iPXE is
+ * running.
+ *
+ */
+
+/**
+ * Handle metrics export timer expiry
+ *
+ * @v timer		Metrics export timer
+ * @v fail		Failure indicator
+ */
+static void metrics_syslog_expired ( struct retry_timer *timer,
+				     int fail __unused ) {
+
+	/* Restart timer */
+	start_timer_fixed ( timer, ( METRICS_SYSLOG_INTERVAL * TICKS_PER_SEC ) );
+
+	/* Send metrics to system log */
+	metrics_log();
+}
+
+/** Metrics export timer */
+static struct retry_timer metrics_syslog_timer =
+	TIMER_INIT ( metrics_syslog_expired );
+
+/**
+ * Start periodic metrics export
+ *
+ */
+static void metrics_syslog_startup ( void ) {
+
+	/* Start timer, if applicable */
+	if ( METRICS_SYSLOG_INTERVAL ) {
+		start_timer_fixed ( &metrics_syslog_timer,
+				    ( METRICS_SYSLOG_INTERVAL * TICKS_PER_SEC ) );
+	}
+}
+
+/**
+ * Export metrics at boot exit
+ *
+ * @v booting		System is shutting down in order to boot
+ */
+static void metrics_syslog_shutdown ( int booting ) {
+
+	/* Stop periodic export */
+	stop_timer ( &metrics_syslog_timer );
+
+	/* Send final metrics to system log, if booting.  This runs
+	 * before network devices are removed, so that the system log
+	 * is still reachable.
+	 */
+	if ( booting )
+		metrics_log();
+}
+
+/** Metrics export startup function */
+struct startup_fn metrics_syslog_startup_fn __startup_fn ( STARTUP_LATE ) = {
+	.name = "metrics",
+	.startup = metrics_syslog_startup,
+	.shutdown = metrics_syslog_shutdown,
+};
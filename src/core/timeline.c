@@ -0,0 +1,218 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/vsprintf.h>
+#include <ipxe/timer.h>
+#include <ipxe/settings.h>
+#include <ipxe/timeline.h>
+
+/** @file
+ *
+ * Boot timeline
+ *
+ * Boot phases (link wait, network configuration, DNS resolution, TCP
+ * connection establishment, TLS negotiation, certificate validation,
+ * downloads, signature verification and image execution) record
+ * timestamped start and end events into a fixed-size ring buffer.
+ * The recorded events may be exported in the Chrome trace event
+ * format via the "timeline" setting, for consumption by external
+ * tools such as chrome://tracing or Perfetto.
+ *
+ */
+
+/** Boot timeline event ring buffer */
+static struct timeline_event timeline_events[TIMELINE_MAX_EVENTS];
+
+/** Boot timeline event producer counter */
+static unsigned int timeline_prod;
+
+/**
+ * Record boot timeline event
+ *
+ * @v name		Phase name
+ * @v id		Phase instance
+ * @v type		Event type
+ * @v rc		Status code
+ */
+void timeline_record ( const char *name, const void *id, char type, int rc ) {
+	struct timeline_event *event;
+
+	/* Overwrite oldest event, if applicable */
+	event = &timeline_events[ timeline_prod++ % TIMELINE_MAX_EVENTS ];
+	event->name = name;
+	event->id = id;
+	event->ticks = currticks();
+	event->rc = rc;
+	event->type = type;
+}
+
+/**
+ * Get number of retained boot timeline events
+ *
+ * @ret count		Number of events
+ */
+unsigned int timeline_count ( void ) {
+
+	return ( ( timeline_prod < TIMELINE_MAX_EVENTS ) ?
+		 timeline_prod : TIMELINE_MAX_EVENTS );
+}
+
+/**
+ * Get retained boot timeline event
+ *
+ * @v index		Event index (from oldest retained event)
+ * @ret event		Event
+ */
+struct timeline_event * timeline_event ( unsigned int index ) {
+	unsigned int first = ( timeline_prod - timeline_count() );
+
+	return &timeline_events[ ( first + index ) % TIMELINE_MAX_EVENTS ];
+}
+
+/**
+ * Find start event corresponding to an end event
+ *
+ * @v index		End event index
+ * @ret begin		Start event, or NULL if not retained
+ */
+struct timeline_event * timeline_begin_of ( unsigned int index ) {
+	struct timeline_event *end = timeline_event ( index );
+	struct timeline_event *event;
+
+	/* Search backwards for the most recent event for this phase
+	 * instance, which must be a start event.
+	 */
+	while ( index-- ) {
+		event = timeline_event ( index );
+		if ( ( event->id != end->id ) ||
+		     ( strcmp ( event->name, end->name ) != 0 ) )
+			continue;
+		return ( ( event->type == TIMELINE_BEGIN ) ? event : NULL );
+	}
+	return NULL;
+}
+
+/**
+ * Format boot timeline event as a Chrome trace event
+ *
+ * @v event		Event
+ * @v buf		Buffer to fill in (or NULL)
+ * @v len		Length of buffer
+ * @ret len		Length of formatted event (excluding NUL)
+ */
+size_t timeline_json_event ( struct timeline_event *event,
+			     char *buf, size_t len ) {
+	unsigned long long usecs;
+	size_t used;
+
+	/* Construct event */
+	usecs = ( ( event->ticks * 1000000ULL ) / TICKS_PER_SEC );
+	used = ssnprintf ( buf, len, "{\"name\":\"%s\",\"cat\":\"ipxe\","
+			   "\"ph\":\"%c\",\"id\":\"%p\",\"ts\":%lld,"
+			   "\"pid\":1,\"tid\":1", event->name, event->type,
+			   event->id, usecs );
+	if ( event->rc != 0 ) {
+		used += ssnprintf ( ( buf + used ), ( len - used ),
+				    ",\"args\":{\"rc\":\"%#08x\"}",
+				    event->rc );
+	}
+	used += ssnprintf ( ( buf + used ), ( len - used ), "}" );
+
+	return used;
+}
+
+/**
+ * Format boot timeline as a Chrome trace
+ *
+ * @v buf		Buffer to fill in (or NULL)
+ * @v len		Length of buffer
+ * @ret len		Length of formatted trace (excluding NUL)
+ */
+size_t timeline_json ( char *buf, size_t len ) {
+	unsigned int count = timeline_count();
+	unsigned int i;
+	size_t used;
+
+	/* Construct trace */
+	used = ssnprintf ( buf, len, "{\"traceEvents\":[" );
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( i )
+			used += ssnprintf ( ( buf + used ), ( len - used ),
+					    "," );
+		used += timeline_json_event ( timeline_event ( i ),
+					      ( buf + used ),
+					      ( ( used < len ) ?
+						( len - used ) : 0 ) );
+	}
+	used += ssnprintf ( ( buf + used ), ( len - used ),
+			    "],\"displayTimeUnit\":\"ms\"}" );
+
+	return used;
+}
+
+/**
+ * Fetch boot timeline setting
+ *
+ * @v data		Buffer to fill with setting data
+ * @v len		Length of buffer
+ * @ret len		Length of setting data, or negative error
+ */
+static int timeline_fetch ( void *data, size_t len ) {
+	size_t trace_len;
+	char *trace;
+
+	/* Construct trace (including terminating NUL) */
+	trace_len = timeline_json ( NULL, 0 );
+	trace = malloc ( trace_len + 1 /* NUL */ );
+	if ( ! trace )
+		return -ENOMEM;
+	timeline_json ( trace, ( trace_len + 1 /* NUL */ ) );
+
+	/* Copy trace (excluding terminating NUL) */
+	if ( len > trace_len )
+		len = trace_len;
+	memcpy ( data, trace, len );
+	free ( trace );
+
+	return trace_len;
+}
+
+/** Boot timeline setting */
+const struct setting timeline_setting __setting ( SETTING_MISC, timeline ) = {
+	.name = "timeline",
+	.description = "Boot timeline (Chrome trace format)",
+	.type = &setting_type_string,
+	.scope = &builtin_scope,
+};
+
+/** Boot timeline built-in setting */
+struct builtin_setting timeline_builtin_setting __builtin_setting = {
+	.setting = &timeline_setting,
+	.fetch = timeline_fetch,
+};
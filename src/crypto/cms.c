@@ -38,7 +38,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/asn1.h>
 #include <ipxe/x509.h>
 #include <ipxe/malloc.h>
-#include <ipxe/uaccess.h>
+#include <ipxe/image.h>
+#include <ipxe/imgdigest.h>
 #include <ipxe/cms.h>
 
 /* Disambiguate the various error causes */
@@ -532,35 +533,19 @@ int cms_signature ( const void *data, size_t len, struct cms_signature **sig ) {
  *
  * @v sig		CMS signature
  * @v info		Signer information
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @v out		Digest output
+ *
+ * The digest may have been calculated already during download, in
+ * which case no further pass over the image data is required.
  */
 static void cms_digest ( struct cms_signature *sig,
 			 struct cms_signer_info *info,
-			 userptr_t data, size_t len, void *out ) {
+			 struct image *image, void *out ) {
 	struct digest_algorithm *digest = info->digest;
-	uint8_t ctx[ digest->ctxsize ];
-	uint8_t block[ digest->blocksize ];
-	size_t offset = 0;
-	size_t frag_len;
-
-	/* Initialise digest */
-	digest_init ( digest, ctx );
-
-	/* Process data one block at a time */
-	while ( len ) {
-		frag_len = len;
-		if ( frag_len > sizeof ( block ) )
-			frag_len = sizeof ( block );
-		copy_from_user ( block, data, offset, frag_len );
-		digest_update ( digest, ctx, block, frag_len );
-		offset += frag_len;
-		len -= frag_len;
-	}
 
-	/* Finalise digest */
-	digest_final ( digest, ctx, out );
+	/* Calculate (or retrieve cached) digest */
+	image_digest ( image, digest, out );
 
 	DBGC ( sig, "CMS %p/%p digest value:\n", sig, info );
 	DBGC_HDA ( sig, 0, out, digest->digestsize );
@@ -572,14 +557,13 @@ static void cms_digest ( struct cms_signature *sig,
  * @v sig		CMS signature
  * @v info		Signer information
  * @v cert		Corresponding certificate
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @ret rc		Return status code
  */
 static int cms_verify_digest ( struct cms_signature *sig,
 			       struct cms_signer_info *info,
 			       struct x509_certificate *cert,
-			       userptr_t data, size_t len ) {
+			       struct image *image ) {
 	struct digest_algorithm *digest = info->digest;
 	struct pubkey_algorithm *pubkey = info->pubkey;
 	struct x509_public_key *public_key = &cert->subject.public_key;
@@ -588,7 +572,7 @@ static int cms_verify_digest ( struct cms_signature *sig,
 	int rc;
 
 	/* Generate digest */
-	cms_digest ( sig, info, data, len, digest_out );
+	cms_digest ( sig, info, image, digest_out );
 
 	/* Initialise public-key algorithm */
 	if ( ( rc = pubkey_init ( pubkey, ctx, public_key->raw.data,
@@ -618,8 +602,7 @@ static int cms_verify_digest ( struct cms_signature *sig,
  *
  * @v sig		CMS signature
  * @v info		Signer information
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @v time		Time at which to validate certificates
  * @v store		Certificate store, or NULL to use default
  * @v root		Root certificate list, or NULL to use default
@@ -627,8 +610,8 @@ static int cms_verify_digest ( struct cms_signature *sig,
  */
 static int cms_verify_signer_info ( struct cms_signature *sig,
 				    struct cms_signer_info *info,
-				    userptr_t data, size_t len,
-				    time_t time, struct x509_chain *store,
+				    struct image *image, time_t time,
+				    struct x509_chain *store,
 				    struct x509_root *root ) {
 	struct x509_certificate *cert;
 	int rc;
@@ -660,7 +643,7 @@ static int cms_verify_signer_info ( struct cms_signature *sig,
 	}
 
 	/* Verify digest */
-	if ( ( rc = cms_verify_digest ( sig, info, cert, data, len ) ) != 0 )
+	if ( ( rc = cms_verify_digest ( sig, info, cert, image ) ) != 0 )
 		return rc;
 
 	return 0;
@@ -670,15 +653,14 @@ static int cms_verify_signer_info ( struct cms_signature *sig,
  * Verify CMS signature
  *
  * @v sig		CMS signature
- * @v data		Signed data
- * @v len		Length of signed data
+ * @v image		Signed image
  * @v name		Required common name, or NULL to check all signatures
  * @v time		Time at which to validate certificates
  * @v store		Certificate store, or NULL to use default
  * @v root		Root certificate list, or NULL to use default
  * @ret rc		Return status code
  */
-int cms_verify ( struct cms_signature *sig, userptr_t data, size_t len,
+int cms_verify ( struct cms_signature *sig, struct image *image,
 		 const char *name, time_t time, struct x509_chain *store,
 		 struct x509_root *root ) {
 	struct cms_signer_info *info;
@@ -691,7 +673,7 @@ int cms_verify ( struct cms_signature *sig, userptr_t data, size_t len,
 		cert = x509_first ( info->chain );
 		if ( name && ( x509_check_name ( cert, name ) != 0 ) )
 			continue;
-		if ( ( rc = cms_verify_signer_info ( sig, info, data, len, time,
+		if ( ( rc = cms_verify_signer_info ( sig, info, image, time,
 						     store, root ) ) != 0 )
 			return rc;
 		count++;
@@ -28,6 +28,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <errno.h>
 #include <assert.h>
 #include <ctype.h>
+#include <byteswap.h>
 #include <ipxe/uaccess.h>
 #include <ipxe/deflate.h>
 
@@ -70,6 +71,13 @@ static uint8_t deflate_litlen_base[28];
  */
 static uint16_t deflate_distance_base[32];
 
+/** Minimum length for which a non-overlapping copy uses memcpy()
+ *
+ * Shorter copies are performed inline a word at a time, avoiding the
+ * setup cost of a block copy for typical duplicated strings.
+ */
+#define DEFLATE_COPY_BLOCK_LEN 128
+
 /** Code length map */
 static uint8_t deflate_codelen_map[19] = {
 	16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15
@@ -220,6 +228,8 @@ static int deflate_alphabet ( struct deflate *deflate,
 	unsigned int raw;
 	unsigned int adjustment;
 	unsigned int prefix;
+	unsigned int reversed;
+	unsigned int i;
 	int complete;
 
 	/* Clear symbol table */
@@ -283,6 +293,31 @@ static int deflate_alphabet ( struct deflate *deflate,
 		}
 	}
 
+	/* Populate direct lookup table.  Huffman codes are stored
+	 * most significant bit first, and so each code must be
+	 * bit-reversed to obtain its index within the table.  Each
+	 * code of length N fills every (1<<N)th entry, since the
+	 * remaining index bits belong to the following symbol.
+	 */
+	memset ( alphabet->table, 0, sizeof ( alphabet->table ) );
+	for ( bits = 1 ; bits <= DEFLATE_TABLE_BITS ; bits++ ) {
+		huf_sym = &alphabet->huf[ bits - 1 ];
+		huf = ( huf_sym->start >> huf_sym->shift );
+		for ( i = 0 ; i < huf_sym->freq ; i++, huf++ ) {
+			raw = huf_sym->raw[huf];
+			reversed = ( ( ( deflate_reverse[ huf & 0xff ] << 8 ) |
+				       deflate_reverse[ huf >> 8 ] ) >>
+				     ( 16 - bits ) );
+			for ( prefix = reversed ;
+			      prefix < ( 1 << DEFLATE_TABLE_BITS ) ;
+			      prefix += ( 1 << bits ) ) {
+				alphabet->table[prefix] =
+					( ( raw << DEFLATE_TABLE_RAW_LSB ) |
+					  bits );
+			}
+		}
+	}
+
 	/* Dump alphabet (for debugging) */
 	deflate_dump_alphabet ( deflate, alphabet );
 
@@ -307,29 +342,43 @@ static int deflate_alphabet ( struct deflate *deflate,
 static int deflate_accumulate ( struct deflate *deflate,
 				struct deflate_chunk *in,
 				unsigned int target ) {
-	uint8_t byte;
-
-	while ( deflate->bits < target ) {
-
-		/* Check for end of input */
-		if ( in->offset >= in->len )
-			break;
-
-		/* Acquire byte from input */
-		copy_from_user ( &byte, in->data, in->offset++,
-				 sizeof ( byte ) );
-		deflate->accumulator = ( deflate->accumulator |
-					 ( byte << deflate->bits ) );
-		deflate->rotalumucca = ( deflate->rotalumucca |
-					 ( deflate_reverse[byte] <<
-					   ( 24 - deflate->bits ) ) );
-		deflate->bits += 8;
-
-		/* Sanity check */
-		assert ( deflate->bits <=
-			 ( 8 * sizeof ( deflate->accumulator ) ) );
+	const uint8_t *data;
+	uint64_t word;
+	unsigned int count;
+
+	/* Do nothing if we already have enough bits */
+	if ( deflate->bits >= target )
+		return ( deflate->bits - target );
+
+	/* Fill the accumulator with as many whole bytes as will fit.
+	 * Where possible, load a complete word and discard any bytes
+	 * that do not fit.  Part of the first discarded byte may
+	 * remain in the accumulator above the valid bits; this is
+	 * harmless since it will be overwritten with the same value
+	 * when that byte is next accumulated.
+	 */
+	data = ( user_to_virt ( in->data, in->offset ) );
+	if ( ( in->len - in->offset ) >= sizeof ( word ) ) {
+		memcpy ( &word, data, sizeof ( word ) );
+		deflate->accumulator |= ( le64_to_cpu ( word ) <<
+					  deflate->bits );
+		count = ( ( ( 8 * sizeof ( word ) ) - 1 - deflate->bits ) / 8 );
+		deflate->bits += ( 8 * count );
+		in->offset += count;
+	} else {
+		while ( ( deflate->bits <=
+			  ( ( 8 * sizeof ( deflate->accumulator ) ) - 8 ) ) &&
+			( in->offset < in->len ) ) {
+			deflate->accumulator |= ( ( ( uint64_t ) *(data++) ) <<
+						  deflate->bits );
+			deflate->bits += 8;
+			in->offset++;
+		}
 	}
 
+	/* Sanity check */
+	assert ( deflate->bits <= ( 8 * sizeof ( deflate->accumulator ) ) );
+
 	return ( deflate->bits - target );
 }
 
@@ -349,7 +398,6 @@ static int deflate_consume ( struct deflate *deflate, unsigned int count ) {
 	/* Extract data and consume bits */
 	data = ( deflate->accumulator & ( ( 1 << count ) - 1 ) );
 	deflate->accumulator >>= count;
-	deflate->rotalumucca <<= count;
 	deflate->bits -= count;
 
 	return data;
@@ -399,6 +447,8 @@ static int deflate_decode ( struct deflate *deflate,
 	struct deflate_huf_symbols *huf_sym;
 	uint16_t huf;
 	unsigned int lookup_index;
+	unsigned int entry;
+	unsigned int bits;
 	int excess;
 	unsigned int raw;
 
@@ -409,28 +459,40 @@ static int deflate_decode ( struct deflate *deflate,
 	 */
 	deflate_accumulate ( deflate, in, DEFLATE_HUFFMAN_BITS );
 
-	/* Normalise the bit-reversed accumulated value to 16 bits */
-	huf = ( deflate->rotalumucca >> 16 );
+	/* Look up short symbols directly */
+	entry = alphabet->table[ deflate->accumulator &
+				 ( ( 1 << DEFLATE_TABLE_BITS ) - 1 ) ];
+	if ( entry ) {
+		bits = ( entry & DEFLATE_TABLE_LEN_MASK );
+		raw = ( entry >> DEFLATE_TABLE_RAW_LSB );
+	} else {
 
-	/* Find symbol set for this length */
-	lookup_index = ( huf >> DEFLATE_HUFFMAN_QL_SHIFT );
-	huf_sym = &alphabet->huf[ alphabet->lookup[ lookup_index ] ];
-	while ( huf < huf_sym->start )
-		huf_sym--;
+		/* Normalise the bit-reversed accumulated value to 16
+		 * bits.
+		 */
+		huf = ( ( deflate_reverse[ deflate->accumulator & 0xff ]
+			  << 8 ) |
+			deflate_reverse[ ( deflate->accumulator >> 8 ) &
+					 0xff ] );
+
+		/* Find symbol set for this length */
+		lookup_index = ( huf >> DEFLATE_HUFFMAN_QL_SHIFT );
+		huf_sym = &alphabet->huf[ alphabet->lookup[ lookup_index ] ];
+		while ( huf < huf_sym->start )
+			huf_sym--;
+		bits = huf_sym->bits;
+		raw = huf_sym->raw[ huf >> huf_sym->shift ];
+	}
 
 	/* Calculate number of excess bits, and return if not yet complete */
-	excess = ( deflate->bits - huf_sym->bits );
+	excess = ( deflate->bits - bits );
 	if ( excess < 0 )
 		return excess;
 
 	/* Consume bits */
-	deflate_consume ( deflate, huf_sym->bits );
-
-	/* Look up raw symbol */
-	raw = huf_sym->raw[ huf >> huf_sym->shift ];
-	DBGCP ( deflate, "DEFLATE %p decoded %s = %#x = %d\n", deflate,
-		deflate_bin ( ( huf >> huf_sym->shift ), huf_sym->bits ),
-		raw, raw );
+	deflate_consume ( deflate, bits );
+	DBGCP ( deflate, "DEFLATE %p decoded %d-bit symbol = %#x = %d\n",
+		deflate, bits, raw, raw );
 
 	return raw;
 }
@@ -445,6 +507,23 @@ static void deflate_discard_to_byte ( struct deflate *deflate ) {
 	deflate_consume ( deflate, ( deflate->bits & 7 ) );
 }
 
+/**
+ * Copy literal byte to output buffer (if available)
+ *
+ * @v out		Output data buffer
+ * @v byte		Literal byte
+ */
+static inline __attribute__ (( always_inline )) void
+deflate_literal ( struct deflate_chunk *out, uint8_t byte ) {
+	uint8_t *data;
+
+	if ( out->offset < out->len ) {
+		data = user_to_virt ( out->data, out->offset );
+		*data = byte;
+	}
+	out->offset++;
+}
+
 /**
  * Copy data to output buffer (if available)
  *
@@ -455,18 +534,47 @@ static void deflate_discard_to_byte ( struct deflate *deflate ) {
  */
 static void deflate_copy ( struct deflate_chunk *out,
 			   userptr_t start, size_t offset, size_t len ) {
-	size_t out_offset = out->offset;
+	const uint8_t *src;
+	uint8_t *dst;
+	uint64_t word;
 	size_t copy_len;
 
-	/* Copy data one byte at a time, to allow for overlap */
-	if ( out_offset < out->len ) {
-		copy_len = ( out->len - out_offset );
+	/* Copy as much data as will fit */
+	if ( out->offset < out->len ) {
+		copy_len = ( out->len - out->offset );
 		if ( copy_len > len )
 			copy_len = len;
-		while ( copy_len-- ) {
-			memcpy_user ( out->data, out_offset++,
-				      start, offset++, 1 );
+		src = user_to_virt ( start, offset );
+		dst = user_to_virt ( out->data, out->offset );
+
+		/* A duplicated string may overlap its own output, in
+		 * which case the output is a repeating pattern with a
+		 * period of the duplicate distance.  Copying forwards
+		 * a word at a time gives the correct result provided
+		 * that the distance is at least one word; shorter
+		 * distances must be copied a byte at a time.
+		 */
+		if ( ( src > dst ) || ( ( src + copy_len ) <= dst ) ) {
+			/* Non-overlapping: use a block copy for long
+			 * strings (e.g. stored blocks).
+			 */
+			if ( copy_len >= DEFLATE_COPY_BLOCK_LEN ) {
+				memcpy ( dst, src, copy_len );
+				copy_len = 0;
+			}
+		} else if ( ( dst - src ) < ( ( ssize_t ) sizeof ( word ) ) ) {
+			for ( ; copy_len ; copy_len-- )
+				*(dst++) = *(src++);
+		}
+		for ( ; copy_len >= sizeof ( word ) ;
+		      copy_len -= sizeof ( word ) ) {
+			memcpy ( &word, src, sizeof ( word ) );
+			memcpy ( dst, &word, sizeof ( word ) );
+			src += sizeof ( word );
+			dst += sizeof ( word );
 		}
+		for ( ; copy_len ; copy_len-- )
+			*(dst++) = *(src++);
 	}
 	out->offset += len;
 }
@@ -501,6 +609,7 @@ int deflate_inflate ( struct deflate *deflate,
 	} else switch ( deflate->format ) {
 		case DEFLATE_RAW:	goto block_header;
 		case DEFLATE_ZLIB:	goto zlib_header;
+		case DEFLATE_GZIP:	goto gzip_header;
 		default:		assert ( 0 );
 	}
 
@@ -532,6 +641,149 @@ int deflate_inflate ( struct deflate *deflate,
 		goto block_header;
 	}
 
+ gzip_header: {
+		int magic;
+
+		/* Extract magic */
+		magic = deflate_extract ( deflate, in, GZIP_MAGIC_BITS );
+		if ( magic < 0 ) {
+			deflate->resume = &&gzip_header;
+			return 0;
+		}
+
+		/* Verify magic */
+		if ( magic != GZIP_MAGIC ) {
+			DBGC ( deflate, "DEFLATE %p invalid GZIP magic %#04x\n",
+			       deflate, magic );
+			return -EINVAL;
+		}
+	}
+
+ gzip_flags: {
+		int header;
+		int cm;
+
+		/* Extract compression method and flags */
+		header = deflate_extract ( deflate, in, GZIP_HEADER_BITS );
+		if ( header < 0 ) {
+			deflate->resume = &&gzip_flags;
+			return 0;
+		}
+
+		/* Parse header */
+		cm = ( ( header >> GZIP_HEADER_CM_LSB ) & GZIP_HEADER_CM_MASK );
+		if ( cm != GZIP_HEADER_CM_DEFLATE ) {
+			DBGC ( deflate, "DEFLATE %p unsupported GZIP "
+			       "compression method %d\n", deflate, cm );
+			return -ENOTSUP;
+		}
+		if ( header & GZIP_HEADER_RESERVED_MASK ) {
+			DBGC ( deflate, "DEFLATE %p unsupported GZIP flags "
+			       "%#04x\n", deflate, header );
+			return -ENOTSUP;
+		}
+		deflate->header = header;
+
+		/* Skip modification time, extra flags and OS */
+		deflate->remaining = GZIP_HEADER_SKIP_LEN;
+	}
+
+ gzip_skip: {
+		int byte;
+
+		/* Skip fixed-length header fields */
+		while ( deflate->remaining ) {
+			byte = deflate_extract ( deflate, in, 8 );
+			if ( byte < 0 ) {
+				deflate->resume = &&gzip_skip;
+				return 0;
+			}
+			deflate->remaining--;
+		}
+
+		/* Process extra field, if present */
+		if ( ! ( deflate->header & ( 1 << GZIP_HEADER_FEXTRA_BIT ) ) )
+			goto gzip_name;
+	}
+
+ gzip_xlen: {
+		int xlen;
+
+		/* Extract extra field length */
+		xlen = deflate_extract ( deflate, in, GZIP_XLEN_BITS );
+		if ( xlen < 0 ) {
+			deflate->resume = &&gzip_xlen;
+			return 0;
+		}
+		deflate->remaining = xlen;
+	}
+
+ gzip_extra: {
+		int byte;
+
+		/* Skip extra field */
+		while ( deflate->remaining ) {
+			byte = deflate_extract ( deflate, in, 8 );
+			if ( byte < 0 ) {
+				deflate->resume = &&gzip_extra;
+				return 0;
+			}
+			deflate->remaining--;
+		}
+	}
+
+ gzip_name: {
+		int byte;
+
+		/* Skip NUL-terminated original file name, if present */
+		if ( deflate->header & ( 1 << GZIP_HEADER_FNAME_BIT ) ) {
+			do {
+				byte = deflate_extract ( deflate, in, 8 );
+				if ( byte < 0 ) {
+					deflate->resume = &&gzip_name;
+					return 0;
+				}
+			} while ( byte );
+		}
+	}
+
+ gzip_comment: {
+		int byte;
+
+		/* Skip NUL-terminated file comment, if present */
+		if ( deflate->header & ( 1 << GZIP_HEADER_FCOMMENT_BIT ) ) {
+			do {
+				byte = deflate_extract ( deflate, in, 8 );
+				if ( byte < 0 ) {
+					deflate->resume = &&gzip_comment;
+					return 0;
+				}
+			} while ( byte );
+		}
+
+		/* Skip header CRC16, if present */
+		deflate->remaining =
+			( ( deflate->header & ( 1 << GZIP_HEADER_FHCRC_BIT ) ) ?
+			  GZIP_HCRC_LEN : 0 );
+	}
+
+ gzip_hcrc: {
+		int byte;
+
+		/* Skip header CRC16 */
+		while ( deflate->remaining ) {
+			byte = deflate_extract ( deflate, in, 8 );
+			if ( byte < 0 ) {
+				deflate->resume = &&gzip_hcrc;
+				return 0;
+			}
+			deflate->remaining--;
+		}
+
+		/* Process first block header */
+		goto block_header;
+	}
+
  block_header: {
 		int header;
 		int bfinal;
@@ -610,6 +862,16 @@ int deflate_inflate ( struct deflate *deflate,
 		size_t in_remaining;
 		size_t len;
 
+		/* Copy any whole bytes already held in the accumulator */
+		while ( deflate->remaining && ( deflate->bits >= 8 ) ) {
+			deflate_literal ( out, deflate_consume ( deflate, 8 ) );
+			deflate->remaining--;
+		}
+		if ( deflate->remaining ) {
+			assert ( deflate->bits == 0 );
+			deflate->accumulator = 0;
+		}
+
 		/* Calculate available amount of literal data */
 		in_remaining = ( in->len - in->offset );
 		len = deflate->remaining;
@@ -844,8 +1106,7 @@ int deflate_inflate ( struct deflate *deflate,
 				DBGCP ( deflate, "DEFLATE %p literal %#02x "
 					"('%c')\n", deflate, byte,
 					( isprint ( byte ) ? byte : '.' ) );
-				deflate_copy ( out, virt_to_user ( &byte ), 0,
-					       sizeof ( byte ) );
+				deflate_literal ( out, byte );
 
 			} else if ( code == DEFLATE_LITLEN_END ) {
 
@@ -953,6 +1214,7 @@ int deflate_inflate ( struct deflate *deflate,
 		switch ( deflate->format ) {
 		case DEFLATE_RAW:	goto finished;
 		case DEFLATE_ZLIB:	goto zlib_footer;
+		case DEFLATE_GZIP:	goto gzip_footer;
 		default:		assert ( 0 );
 		}
 	}
@@ -982,6 +1244,34 @@ int deflate_inflate ( struct deflate *deflate,
 		goto finished;
 	}
 
+ gzip_footer: {
+
+		/* Discard any bits up to the next byte boundary */
+		deflate_discard_to_byte ( deflate );
+
+		/* Skip CRC32 and ISIZE */
+		deflate->remaining = GZIP_FOOTER_LEN;
+	}
+
+ gzip_trailer: {
+		int byte;
+
+		/* Skip footer.  As with the ZLIB ADLER32 checksum, we
+		 * don't check the values.
+		 */
+		while ( deflate->remaining ) {
+			byte = deflate_extract ( deflate, in, 8 );
+			if ( byte < 0 ) {
+				deflate->resume = &&gzip_trailer;
+				return 0;
+			}
+			deflate->remaining--;
+		}
+
+		/* Finish processing */
+		goto finished;
+	}
+
  finished: {
 		/* Mark as finished and terminate */
 		DBGCP ( deflate, "DEFLATE %p finished\n", deflate );
@@ -1047,3 +1337,114 @@ void deflate_init ( struct deflate *deflate, enum deflate_format format ) {
 	memset ( deflate, 0, sizeof ( *deflate ) );
 	deflate->format = format;
 }
+
+/**
+ * Initialise ZLIB decompressor
+ *
+ * @v ctx		Decompressor
+ */
+static void deflate_zlib_init ( void *ctx ) {
+
+	deflate_init ( ctx, DEFLATE_ZLIB );
+}
+
+/**
+ * Initialise GZIP decompressor
+ *
+ * @v ctx		Decompressor
+ */
+static void deflate_gzip_init ( void *ctx ) {
+
+	deflate_init ( ctx, DEFLATE_GZIP );
+}
+
+/**
+ * Decompress data in bounded steps
+ *
+ * @v ctx		Decompressor
+ * @v in		Compressed input data
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ *
+ * The decompressor does not stop when the output buffer is full.  We
+ * therefore limit each step to an amount of input that cannot produce
+ * more output than the remaining free space.  Any data following the
+ * end of the compressed stream is ignored.
+ */
+static int deflate_step ( void *ctx, struct deflate_chunk *in,
+			  struct deflate_chunk *out ) {
+	struct deflate *deflate = ctx;
+	size_t space;
+	size_t limit;
+	size_t len;
+	int rc;
+
+	while ( ( in->offset < in->len ) &&
+		( ( space = ( out->len - out->offset ) ) >=
+		  DEFLATE_STEP_SPACE ) ) {
+
+		/* Limit input to that which cannot overflow the buffer */
+		limit = ( ( ( space - DEFLATE_MAX_MATCH ) / DEFLATE_MAX_RATIO )
+			  - DEFLATE_ACCUMULATED );
+		len = in->len;
+		if ( limit < ( len - in->offset ) )
+			in->len = ( in->offset + limit );
+
+		/* Decompress */
+		rc = deflate_inflate ( deflate, in, out );
+		in->len = len;
+		if ( rc != 0 )
+			return rc;
+		assert ( out->offset <= out->len );
+
+		/* Stop at end of compressed stream */
+		if ( deflate_finished ( deflate ) )
+			break;
+	}
+
+	return 0;
+}
+
+/**
+ * Check if decompression has finished
+ *
+ * @v ctx		Decompressor
+ * @ret finished	Decompression has finished
+ */
+static int deflate_step_finished ( void *ctx ) {
+
+	return deflate_finished ( ctx );
+}
+
+/**
+ * Get history window length
+ *
+ * @v ctx		Decompressor
+ * @ret window		Length of preceding output to be retained
+ */
+static size_t deflate_window ( void *ctx __unused ) {
+
+	return DEFLATE_WINDOW;
+}
+
+/** ZLIB decompression algorithm */
+struct inflate_algorithm deflate_zlib_algorithm = {
+	.name = "zlib",
+	.ctxsize = sizeof ( struct deflate ),
+	.step = DEFLATE_STEP_SPACE,
+	.init = deflate_zlib_init,
+	.decompress = deflate_step,
+	.finished = deflate_step_finished,
+	.window = deflate_window,
+};
+
+/** GZIP decompression algorithm */
+struct inflate_algorithm deflate_gzip_algorithm = {
+	.name = "gzip",
+	.ctxsize = sizeof ( struct deflate ),
+	.step = DEFLATE_STEP_SPACE,
+	.init = deflate_gzip_init,
+	.decompress = deflate_step,
+	.finished = deflate_step_finished,
+	.window = deflate_window,
+};
@@ -0,0 +1,327 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Galois/Counter Mode (GCM)
+ *
+ * The GHASH multiplication uses Shoup's 4-bit table method: sixteen
+ * multiples of the hash key are precomputed when the key is set, and
+ * each 128-bit block is then multiplied four bits at a time, with a
+ * small constant table used to fold the bits shifted out of the low
+ * end back in via the field polynomial.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <byteswap.h>
+#include <assert.h>
+#include <ipxe/crypto.h>
+#include <ipxe/gcm.h>
+
+/** Reduction values for each 4-bit remainder
+ *
+ * These are the multiples of the field polynomial (0xe1 followed by
+ * 120 zero bits) by each possible four-bit value shifted out of the
+ * low end of the accumulator, shown as the top 16 bits of the value
+ * to be XORed into the high 64 bits.
+ */
+static const uint16_t gcm_reduce[16] = {
+	0x0000, 0x1c20, 0x3840, 0x2460, 0x7080, 0x6ca0, 0x48c0, 0x54e0,
+	0xe100, 0xfd20, 0xd940, 0xc560, 0x9180, 0x8da0, 0xa9c0, 0xb5e0,
+};
+
+/**
+ * Shift accumulator right by four bits and add a table entry
+ *
+ * @v context		GCM context
+ * @v hi		High 64 bits of accumulator
+ * @v lo		Low 64 bits of accumulator
+ * @v nibble		Four-bit multiplier value
+ */
+static inline __attribute__ (( always_inline )) void
+gcm_step ( struct gcm_context *context, uint64_t *hi, uint64_t *lo,
+	   unsigned int nibble ) {
+	struct gcm_table_entry *entry = &context->table[nibble];
+	unsigned int rem;
+
+	rem = ( *lo & 0xf );
+	*lo = ( ( *hi << 60 ) | ( *lo >> 4 ) );
+	*hi = ( ( *hi >> 4 ) ^ ( ( ( uint64_t ) gcm_reduce[rem] ) << 48 ) );
+	*hi ^= entry->hi;
+	*lo ^= entry->lo;
+}
+
+/**
+ * Multiply accumulated hash value by the hash key
+ *
+ * @v context		GCM context
+ */
+static void gcm_multiply ( struct gcm_context *context ) {
+	const uint8_t *byte = context->hash.byte;
+	uint64_t hi = 0;
+	uint64_t lo = 0;
+	int i;
+
+	/* Process each byte from least significant, low nibble first */
+	for ( i = ( GCM_BLOCK_SIZE - 1 ) ; i >= 0 ; i-- ) {
+		gcm_step ( context, &hi, &lo, ( byte[i] & 0xf ) );
+		gcm_step ( context, &hi, &lo, ( byte[i] >> 4 ) );
+	}
+
+	/* Store result */
+	context->hash.qword[0] = cpu_to_be64 ( hi );
+	context->hash.qword[1] = cpu_to_be64 ( lo );
+}
+
+/**
+ * Add data to accumulated hash value
+ *
+ * @v context		GCM context
+ * @v data		Data
+ * @v len		Length of data
+ *
+ * A trailing partial block is treated as though it were padded with
+ * zeros.
+ */
+static void gcm_hash ( struct gcm_context *context, const void *data,
+		       size_t len ) {
+	const uint8_t *bytes = data;
+	size_t frag_len;
+	unsigned int i;
+
+	while ( len ) {
+		frag_len = len;
+		if ( frag_len > GCM_BLOCK_SIZE )
+			frag_len = GCM_BLOCK_SIZE;
+		for ( i = 0 ; i < frag_len ; i++ )
+			context->hash.byte[i] ^= bytes[i];
+		gcm_multiply ( context );
+		bytes += frag_len;
+		len -= frag_len;
+	}
+}
+
+/**
+ * Set key
+ *
+ * @v context		GCM context
+ * @v key		Key
+ * @v keylen		Key length
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v raw_ctx		Underlying cipher context
+ * @ret rc		Return status code
+ */
+int gcm_setkey ( struct gcm_context *context, const void *key, size_t keylen,
+		 struct cipher_algorithm *raw_cipher, void *raw_ctx ) {
+	struct gcm_table_entry *entry;
+	union gcm_block hkey;
+	uint64_t hi;
+	uint64_t lo;
+	unsigned int i;
+	unsigned int j;
+	int rc;
+
+	/* Sanity check */
+	assert ( raw_cipher->blocksize == GCM_BLOCK_SIZE );
+
+	/* Set underlying cipher key */
+	if ( ( rc = cipher_setkey ( raw_cipher, raw_ctx, key, keylen ) ) != 0 )
+		return rc;
+
+	/* Construct hash key by encrypting an all-zeros block */
+	memset ( &hkey, 0, sizeof ( hkey ) );
+	cipher_encrypt ( raw_cipher, raw_ctx, &hkey, &hkey, sizeof ( hkey ) );
+
+	/* Construct power-of-two multiples.  The bit ordering used
+	 * by GCM means that the hash key itself corresponds to the
+	 * nibble value 8, and each halving of the nibble value
+	 * corresponds to a shift right (with reduction).
+	 */
+	memset ( context->table, 0, sizeof ( context->table ) );
+	hi = be64_to_cpu ( hkey.qword[0] );
+	lo = be64_to_cpu ( hkey.qword[1] );
+	for ( i = 8 ; i ; i >>= 1 ) {
+		entry = &context->table[i];
+		entry->hi = hi;
+		entry->lo = lo;
+		lo = ( ( hi << 63 ) | ( lo >> 1 ) );
+		hi = ( ( hi >> 1 ) ^ ( ( entry->lo & 1 ) ?
+				       ( 0xe1ULL << 56 ) : 0 ) );
+	}
+
+	/* Construct remaining multiples by addition */
+	for ( i = 2 ; i <= 8 ; i <<= 1 ) {
+		for ( j = 1 ; j < i ; j++ ) {
+			context->table[ i + j ].hi = ( context->table[i].hi ^
+						       context->table[j].hi );
+			context->table[ i + j ].lo = ( context->table[i].lo ^
+						       context->table[j].lo );
+		}
+	}
+
+	return 0;
+}
+
+/**
+ * Set initialisation vector
+ *
+ * @v context		GCM context
+ * @v iv		Initialisation vector
+ *
+ * Setting the initialisation vector begins a new message.
+ */
+void gcm_setiv ( struct gcm_context *context, const void *iv ) {
+
+	/* Construct pre-counter block */
+	memcpy ( context->j0.byte, iv, GCM_IV_LEN );
+	context->j0.dword[3] = cpu_to_be32 ( 1 );
+	memcpy ( &context->ctr, &context->j0, sizeof ( context->ctr ) );
+
+	/* Reset hash */
+	memset ( &context->hash, 0, sizeof ( context->hash ) );
+	context->add_len = 0;
+	context->data_len = 0;
+}
+
+/**
+ * Encrypt or decrypt data
+ *
+ * @v context		GCM context
+ * @v src		Input data
+ * @v dst		Output data
+ * @v len		Length of data
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v raw_ctx		Underlying cipher context
+ * @v encrypt		Data is being encrypted
+ */
+static void gcm_crypt ( struct gcm_context *context, const void *src,
+			void *dst, size_t len,
+			struct cipher_algorithm *raw_cipher, void *raw_ctx,
+			int encrypt ) {
+	const uint8_t *in = src;
+	uint8_t *out = dst;
+	union gcm_block keystream;
+	size_t frag_len;
+	unsigned int i;
+
+	/* Handle additional data */
+	if ( ! dst ) {
+		assert ( context->data_len == 0 );
+		gcm_hash ( context, src, len );
+		context->add_len += len;
+		return;
+	}
+
+	/* Encrypt or decrypt data */
+	context->data_len += len;
+	while ( len ) {
+
+		/* Generate keystream block */
+		context->ctr.dword[3] =
+			cpu_to_be32 ( be32_to_cpu ( context->ctr.dword[3] ) + 1 );
+		cipher_encrypt ( raw_cipher, raw_ctx, &context->ctr,
+				 &keystream, sizeof ( keystream ) );
+
+		/* Hash ciphertext (before overwriting, if decrypting
+		 * in place) and combine with keystream.
+		 */
+		frag_len = len;
+		if ( frag_len > GCM_BLOCK_SIZE )
+			frag_len = GCM_BLOCK_SIZE;
+		if ( ! encrypt )
+			gcm_hash ( context, in, frag_len );
+		for ( i = 0 ; i < frag_len ; i++ )
+			out[i] = ( in[i] ^ keystream.byte[i] );
+		if ( encrypt )
+			gcm_hash ( context, out, frag_len );
+
+		in += frag_len;
+		out += frag_len;
+		len -= frag_len;
+	}
+}
+
+/**
+ * Encrypt data
+ *
+ * @v context		GCM context
+ * @v src		Data to encrypt
+ * @v dst		Buffer for encrypted data, or NULL for additional data
+ * @v len		Length of data
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v raw_ctx		Underlying cipher context
+ */
+void gcm_encrypt ( struct gcm_context *context, const void *src, void *dst,
+		   size_t len, struct cipher_algorithm *raw_cipher,
+		   void *raw_ctx ) {
+
+	gcm_crypt ( context, src, dst, len, raw_cipher, raw_ctx, 1 );
+}
+
+/**
+ * Decrypt data
+ *
+ * @v context		GCM context
+ * @v src		Data to decrypt
+ * @v dst		Buffer for decrypted data, or NULL for additional data
+ * @v len		Length of data
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v raw_ctx		Underlying cipher context
+ */
+void gcm_decrypt ( struct gcm_context *context, const void *src, void *dst,
+		   size_t len, struct cipher_algorithm *raw_cipher,
+		   void *raw_ctx ) {
+
+	gcm_crypt ( context, src, dst, len, raw_cipher, raw_ctx, 0 );
+}
+
+/**
+ * Generate authentication tag
+ *
+ * @v context		GCM context
+ * @v auth		Buffer for authentication tag
+ * @v raw_cipher	Underlying cipher algorithm
+ * @v raw_ctx		Underlying cipher context
+ */
+void gcm_auth ( struct gcm_context *context, void *auth,
+		struct cipher_algorithm *raw_cipher, void *raw_ctx ) {
+	union gcm_block lengths;
+	union gcm_block mask;
+	uint8_t *out = auth;
+	unsigned int i;
+
+	/* Hash lengths (in bits) */
+	lengths.qword[0] = cpu_to_be64 ( context->add_len * 8 );
+	lengths.qword[1] = cpu_to_be64 ( context->data_len * 8 );
+	gcm_hash ( context, &lengths, sizeof ( lengths ) );
+
+	/* Encrypt hash using pre-counter block */
+	cipher_encrypt ( raw_cipher, raw_ctx, &context->j0, &mask,
+			 sizeof ( mask ) );
+	for ( i = 0 ; i < GCM_AUTH_LEN ; i++ )
+		out[i] = ( context->hash.byte[i] ^ mask.byte[i] );
+}
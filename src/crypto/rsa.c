@@ -28,6 +28,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdarg.h>
 #include <string.h>
 #include <errno.h>
+#include <byteswap.h>
 #include <ipxe/asn1.h>
 #include <ipxe/crypto.h>
 #include <ipxe/bigint.h>
@@ -46,6 +47,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 	__einfo_error ( EINFO_EACCES_VERIFY )
 #define EINFO_EACCES_VERIFY \
 	__einfo_uniqify ( EINFO_EACCES, 0x01, "RSA signature incorrect" )
+#define EACCES_PSS \
+	__einfo_error ( EINFO_EACCES_PSS )
+#define EINFO_EACCES_PSS \
+	__einfo_uniqify ( EINFO_EACCES, 0x02, "RSA-PSS signature incorrect" )
 
 /** "rsaEncryption" object identifier */
 static uint8_t oid_rsa_encryption[] = { ASN1_OID_RSAENCRYPTION };
@@ -571,6 +576,235 @@ static int rsa_verify ( void *ctx, struct digest_algorithm *digest,
 	return 0;
 }
 
+/**
+ * Calculate RSA-PSS encoded message length in bits
+ *
+ * @v context		RSA context
+ * @ret em_bits		Encoded message length in bits
+ */
+static unsigned int rsa_pss_em_bits ( struct rsa_context *context ) {
+	bigint_t ( context->size ) *modulus = ( ( void * ) context->modulus0 );
+
+	return ( bigint_max_set_bit ( modulus ) - 1 );
+}
+
+/**
+ * Apply RSA-PSS mask generation function (MGF1)
+ *
+ * @v digest		Digest algorithm
+ * @v seed		Seed
+ * @v data		Data to be masked
+ * @v len		Length of data
+ */
+static void rsa_pss_mask ( struct digest_algorithm *digest, const void *seed,
+			   uint8_t *data, size_t len ) {
+	uint8_t ctx[digest->ctxsize];
+	uint8_t mask[digest->digestsize];
+	uint32_t counter;
+	uint32_t counter_be;
+	size_t frag_len;
+	unsigned int i;
+
+	for ( counter = 0 ; len ; counter++ ) {
+
+		/* Generate mask block */
+		counter_be = cpu_to_be32 ( counter );
+		digest_init ( digest, ctx );
+		digest_update ( digest, ctx, seed, digest->digestsize );
+		digest_update ( digest, ctx, &counter_be,
+				sizeof ( counter_be ) );
+		digest_final ( digest, ctx, mask );
+
+		/* Apply mask block */
+		frag_len = len;
+		if ( frag_len > sizeof ( mask ) )
+			frag_len = sizeof ( mask );
+		for ( i = 0 ; i < frag_len ; i++ )
+			data[i] ^= mask[i];
+		data += frag_len;
+		len -= frag_len;
+	}
+}
+
+/**
+ * Calculate RSA-PSS message hash
+ *
+ * @v digest		Digest algorithm
+ * @v value		Digest value
+ * @v salt		Salt (of the same length as the digest value)
+ * @v hash		Hash to fill in
+ */
+static void rsa_pss_hash ( struct digest_algorithm *digest, const void *value,
+			   const void *salt, void *hash ) {
+	static const uint8_t zero[8];
+	uint8_t ctx[digest->ctxsize];
+
+	digest_init ( digest, ctx );
+	digest_update ( digest, ctx, zero, sizeof ( zero ) );
+	digest_update ( digest, ctx, value, digest->digestsize );
+	digest_update ( digest, ctx, salt, digest->digestsize );
+	digest_final ( digest, ctx, hash );
+}
+
+/**
+ * Sign digest value using RSA-PSS
+ *
+ * @v ctx		RSA context
+ * @v digest		Digest algorithm
+ * @v value		Digest value
+ * @v signature		Signature
+ * @ret signature_len	Signature length, or negative error
+ *
+ * The salt length is always equal to the digest length, as required
+ * by TLS.
+ */
+static int rsa_pss_sign ( void *ctx, struct digest_algorithm *digest,
+			  const void *value, void *signature ) {
+	struct rsa_context *context = ctx;
+	size_t digest_len = digest->digestsize;
+	unsigned int em_bits = rsa_pss_em_bits ( context );
+	size_t em_len = ( ( em_bits + 7 ) / 8 );
+	uint8_t *encoded;
+	uint8_t *masked;
+	uint8_t *salt;
+	uint8_t *hash;
+	size_t masked_len;
+	void *temp;
+	int rc;
+
+	DBGC ( context, "RSA %p PSS-signing %s digest:\n",
+	       context, digest->name );
+	DBGC_HDA ( context, 0, value, digest_len );
+
+	/* Sanity check */
+	if ( em_len < ( digest_len + digest_len + 2 ) ) {
+		DBGC ( context, "RSA %p too short for PSS with %s\n",
+		       context, digest->name );
+		return -ERANGE;
+	}
+
+	/* Construct encoded message (using the big integer output
+	 * buffer as temporary storage).  The encoded message may be
+	 * one byte shorter than the modulus.
+	 */
+	temp = context->output0;
+	encoded = temp;
+	memset ( encoded, 0, context->max_len );
+	masked = ( encoded + context->max_len - em_len );
+	masked_len = ( em_len - digest_len - 1 );
+	salt = ( masked + masked_len - digest_len );
+	hash = ( masked + masked_len );
+	if ( ( rc = get_random_nz ( salt, digest_len ) ) != 0 ) {
+		DBGC ( context, "RSA %p could not generate salt: %s\n",
+		       context, strerror ( rc ) );
+		return rc;
+	}
+	salt[-1] = 0x01;
+	rsa_pss_hash ( digest, value, salt, hash );
+	rsa_pss_mask ( digest, hash, masked, masked_len );
+	masked[0] &= ( 0xff >> ( ( 8 * em_len ) - em_bits ) );
+	hash[digest_len] = 0xbc;
+	DBGC ( context, "RSA %p PSS-encoded %s digest:\n",
+	       context, digest->name );
+	DBGC_HDA ( context, 0, encoded, context->max_len );
+
+	/* Encipher the encoded message */
+	rsa_cipher ( context, encoded, signature );
+	DBGC ( context, "RSA %p PSS-signed %s digest:\n",
+	       context, digest->name );
+	DBGC_HDA ( context, 0, signature, context->max_len );
+
+	return context->max_len;
+}
+
+/**
+ * Verify signed digest value using RSA-PSS
+ *
+ * @v ctx		RSA context
+ * @v digest		Digest algorithm
+ * @v value		Digest value
+ * @v signature		Signature
+ * @v signature_len	Signature length
+ * @ret rc		Return status code
+ */
+static int rsa_pss_verify ( void *ctx, struct digest_algorithm *digest,
+			    const void *value, const void *signature,
+			    size_t signature_len ) {
+	struct rsa_context *context = ctx;
+	size_t digest_len = digest->digestsize;
+	unsigned int em_bits = rsa_pss_em_bits ( context );
+	size_t em_len = ( ( em_bits + 7 ) / 8 );
+	uint8_t top_mask = ( 0xff >> ( ( 8 * em_len ) - em_bits ) );
+	uint8_t expected[digest_len];
+	uint8_t *encoded;
+	uint8_t *masked;
+	uint8_t *salt;
+	uint8_t *hash;
+	size_t masked_len;
+	void *temp;
+	unsigned int i;
+
+	/* Sanity check */
+	if ( signature_len != context->max_len ) {
+		DBGC ( context, "RSA %p signature incorrect length (%zd "
+		       "bytes, should be %zd)\n",
+		       context, signature_len, context->max_len );
+		return -ERANGE;
+	}
+	if ( em_len < ( digest_len + digest_len + 2 ) ) {
+		DBGC ( context, "RSA %p too short for PSS with %s\n",
+		       context, digest->name );
+		return -ERANGE;
+	}
+	DBGC ( context, "RSA %p PSS-verifying %s digest:\n",
+	       context, digest->name );
+	DBGC_HDA ( context, 0, value, digest_len );
+	DBGC_HDA ( context, 0, signature, signature_len );
+
+	/* Decipher the signature (using the big integer input buffer
+	 * as temporary storage)
+	 */
+	temp = context->input0;
+	encoded = temp;
+	rsa_cipher ( context, signature, encoded );
+	DBGC ( context, "RSA %p deciphered signature:\n", context );
+	DBGC_HDA ( context, 0, encoded, context->max_len );
+
+	/* Parse the encoded message */
+	masked = ( encoded + context->max_len - em_len );
+	masked_len = ( em_len - digest_len - 1 );
+	salt = ( masked + masked_len - digest_len );
+	hash = ( masked + masked_len );
+	if ( ( masked != encoded ) && ( encoded[0] != 0x00 ) )
+		goto invalid;
+	if ( hash[digest_len] != 0xbc )
+		goto invalid;
+	if ( masked[0] & ~top_mask )
+		goto invalid;
+	rsa_pss_mask ( digest, hash, masked, masked_len );
+	masked[0] &= top_mask;
+	for ( i = 0 ; i < ( masked_len - digest_len - 1 ) ; i++ ) {
+		if ( masked[i] != 0x00 )
+			goto invalid;
+	}
+	if ( salt[-1] != 0x01 )
+		goto invalid;
+
+	/* Verify the hash */
+	rsa_pss_hash ( digest, value, salt, expected );
+	if ( memcmp ( hash, expected, digest_len ) != 0 )
+		goto invalid;
+
+	DBGC ( context, "RSA %p PSS signature verified successfully\n",
+	       context );
+	return 0;
+
+ invalid:
+	DBGC ( context, "RSA %p PSS signature verification failed\n",
+	       context );
+	return -EACCES_PSS;
+}
+
 /**
  * Finalise RSA cipher
  *
@@ -636,6 +870,24 @@ struct pubkey_algorithm rsa_algorithm = {
 	.match		= rsa_match,
 };
 
+/** RSA-PSS public-key algorithm
+ *
+ * This shares the key format and encryption scheme of @c
+ * rsa_algorithm, differing only in the signature scheme.
+ */
+struct pubkey_algorithm rsa_pss_algorithm = {
+	.name		= "rsa-pss",
+	.ctxsize	= RSA_CTX_SIZE,
+	.init		= rsa_init,
+	.max_len	= rsa_max_len,
+	.encrypt	= rsa_encrypt,
+	.decrypt	= rsa_decrypt,
+	.sign		= rsa_pss_sign,
+	.verify		= rsa_pss_verify,
+	.final		= rsa_final,
+	.match		= rsa_match,
+};
+
 /* Drag in objects via rsa_algorithm */
 REQUIRING_SYMBOL ( rsa_algorithm );
 
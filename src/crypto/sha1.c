@@ -199,6 +199,35 @@ static void sha1_digest ( struct sha1_context *context ) {
 		   sizeof ( context->ddd.dd.digest ) );
 }
 
+/**
+ * Digest whole SHA-1 data blocks
+ *
+ * @v context		SHA-1 context
+ * @v data		Data blocks
+ * @v count		Number of blocks
+ *
+ * The context must not contain any partially accumulated data.
+ */
+static void sha1_blocks ( struct sha1_context *context,
+			  const void *data, size_t count ) {
+	union sha1_block *block = &context->ddd.dd.data;
+	size_t done;
+
+	/* Use CPU extensions, if available */
+	done = sha1_arch_blocks ( &context->ddd.dd.digest, data, count );
+	context->len += ( done * sizeof ( *block ) );
+	data += ( done * sizeof ( *block ) );
+	count -= done;
+
+	/* Digest any remaining blocks in software */
+	while ( count-- ) {
+		memcpy ( block, data, sizeof ( *block ) );
+		context->len += sizeof ( *block );
+		sha1_digest ( context );
+		data += sizeof ( *block );
+	}
+}
+
 /**
  * Accumulate data with SHA-1 algorithm
  *
@@ -208,19 +237,34 @@ static void sha1_digest ( struct sha1_context *context ) {
  */
 static void sha1_update ( void *ctx, const void *data, size_t len ) {
 	struct sha1_context *context = ctx;
-	const uint8_t *byte = data;
+	union sha1_block *block = &context->ddd.dd.data;
 	size_t offset;
+	size_t frag_len;
 
-	/* Accumulate data a byte at a time, performing the digest
-	 * whenever we fill the data buffer
-	 */
-	while ( len-- ) {
-		offset = ( context->len % sizeof ( context->ddd.dd.data ) );
-		context->ddd.dd.data.byte[offset] = *(byte++);
-		context->len++;
-		if ( ( context->len % sizeof ( context->ddd.dd.data ) ) == 0 )
+	/* Complete any partially accumulated block */
+	offset = ( context->len % sizeof ( *block ) );
+	if ( offset ) {
+		frag_len = ( sizeof ( *block ) - offset );
+		if ( frag_len > len )
+			frag_len = len;
+		memcpy ( &block->byte[offset], data, frag_len );
+		context->len += frag_len;
+		data += frag_len;
+		len -= frag_len;
+		if ( ( context->len % sizeof ( *block ) ) == 0 )
 			sha1_digest ( context );
 	}
+
+	/* Digest whole blocks directly from the source data */
+	frag_len = ( len - ( len % sizeof ( *block ) ) );
+	sha1_blocks ( context, data, ( frag_len / sizeof ( *block ) ) );
+	data += frag_len;
+	len -= frag_len;
+
+	/* Accumulate any remaining data */
+	offset = ( context->len % sizeof ( *block ) );
+	memcpy ( &block->byte[offset], data, len );
+	context->len += len;
 }
 
 /**
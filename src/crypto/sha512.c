@@ -224,6 +224,27 @@ static void sha512_digest ( struct sha512_context *context ) {
 		   sizeof ( context->ddq.dd.digest ) );
 }
 
+/**
+ * Digest whole SHA-512 data blocks
+ *
+ * @v context		SHA-512 context
+ * @v data		Data blocks
+ * @v count		Number of blocks
+ *
+ * The context must not contain any partially accumulated data.
+ */
+static void sha512_blocks ( struct sha512_context *context,
+			    const void *data, size_t count ) {
+	union sha512_block *block = &context->ddq.dd.data;
+
+	while ( count-- ) {
+		memcpy ( block, data, sizeof ( *block ) );
+		context->len += sizeof ( *block );
+		sha512_digest ( context );
+		data += sizeof ( *block );
+	}
+}
+
 /**
  * Accumulate data with SHA-512 algorithm
  *
@@ -233,19 +254,34 @@ static void sha512_digest ( struct sha512_context *context ) {
  */
 void sha512_update ( void *ctx, const void *data, size_t len ) {
 	struct sha512_context *context = ctx;
-	const uint8_t *byte = data;
+	union sha512_block *block = &context->ddq.dd.data;
 	size_t offset;
+	size_t frag_len;
 
-	/* Accumulate data a byte at a time, performing the digest
-	 * whenever we fill the data buffer
-	 */
-	while ( len-- ) {
-		offset = ( context->len % sizeof ( context->ddq.dd.data ) );
-		context->ddq.dd.data.byte[offset] = *(byte++);
-		context->len++;
-		if ( ( context->len % sizeof ( context->ddq.dd.data ) ) == 0 )
+	/* Complete any partially accumulated block */
+	offset = ( context->len % sizeof ( *block ) );
+	if ( offset ) {
+		frag_len = ( sizeof ( *block ) - offset );
+		if ( frag_len > len )
+			frag_len = len;
+		memcpy ( &block->byte[offset], data, frag_len );
+		context->len += frag_len;
+		data += frag_len;
+		len -= frag_len;
+		if ( ( context->len % sizeof ( *block ) ) == 0 )
 			sha512_digest ( context );
 	}
+
+	/* Digest whole blocks directly from the source data */
+	frag_len = ( len - ( len % sizeof ( *block ) ) );
+	sha512_blocks ( context, data, ( frag_len / sizeof ( *block ) ) );
+	data += frag_len;
+	len -= frag_len;
+
+	/* Accumulate any remaining data */
+	offset = ( context->len % sizeof ( *block ) );
+	memcpy ( &block->byte[offset], data, len );
+	context->len += len;
 }
 
 /**
@@ -0,0 +1,1005 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/deflate.h>
+#include <ipxe/xz.h>
+
+/** @file
+ *
+ * XZ decompression algorithm
+ *
+ * This file implements a decompressor for the XZ container format
+ * using the LZMA2 filter.  Other filters (such as the branch/call/jump
+ * converters) are not supported.  Integrity checks and CRCs are not
+ * verified (matching the treatment of the DEFLATE checksums).
+ * Decompression stops at the end of the first stream; any subsequent
+ * data is ignored.
+ *
+ * The dictionary is held in the output buffer.  Each LZMA2 chunk is
+ * gathered before being decoded, so that decoding may be paused at
+ * any point when the output buffer becomes full.
+ *
+ */
+
+/** XZ stream header magic */
+static const uint8_t xz_magic[] = XZ_MAGIC;
+
+/** XZ stream footer magic */
+static const uint8_t xz_footer_magic[] = XZ_FOOTER_MAGIC;
+
+/** An LZMA range decoder */
+struct xz_rc {
+	/** Range */
+	uint32_t range;
+	/** Code */
+	uint32_t code;
+	/** Compressed data */
+	const uint8_t *data;
+	/** Offset within compressed data */
+	size_t offset;
+	/** Length of compressed data */
+	size_t len;
+};
+
+/**
+ * Normalise range decoder
+ *
+ * @v rc		Range decoder
+ *
+ * Reading beyond the end of the compressed data produces zero bytes.
+ * The caller must check the final offset.
+ */
+static inline __attribute__ (( always_inline )) void
+xz_rc_normalise ( struct xz_rc *rc ) {
+
+	if ( rc->range < XZ_RC_TOP ) {
+		rc->range <<= 8;
+		rc->code <<= 8;
+		if ( rc->offset < rc->len )
+			rc->code |= rc->data[rc->offset];
+		rc->offset++;
+	}
+}
+
+/**
+ * Decode bit
+ *
+ * @v rc		Range decoder
+ * @v prob		Probability
+ * @ret bit		Decoded bit
+ */
+static inline __attribute__ (( always_inline )) unsigned int
+xz_rc_bit ( struct xz_rc *rc, uint16_t *prob ) {
+	uint32_t bound = ( ( rc->range >> XZ_RC_PROB_BITS ) * ( *prob ) );
+	unsigned int bit;
+
+	if ( rc->code < bound ) {
+		rc->range = bound;
+		*prob += ( ( ( 1 << XZ_RC_PROB_BITS ) - *prob ) >>
+			   XZ_RC_MOVE_BITS );
+		bit = 0;
+	} else {
+		rc->range -= bound;
+		rc->code -= bound;
+		*prob -= ( *prob >> XZ_RC_MOVE_BITS );
+		bit = 1;
+	}
+	xz_rc_normalise ( rc );
+	return bit;
+}
+
+/**
+ * Decode bit tree
+ *
+ * @v rc		Range decoder
+ * @v probs		Probabilities
+ * @v bits		Number of bits
+ * @ret value		Decoded value
+ */
+static inline unsigned int xz_rc_tree ( struct xz_rc *rc, uint16_t *probs,
+					unsigned int bits ) {
+	unsigned int symbol = 1;
+	unsigned int i;
+
+	for ( i = 0 ; i < bits ; i++ )
+		symbol = ( ( symbol << 1 ) | xz_rc_bit ( rc, &probs[symbol] ) );
+	return ( symbol - ( 1 << bits ) );
+}
+
+/**
+ * Decode reverse bit tree
+ *
+ * @v rc		Range decoder
+ * @v probs		Probabilities
+ * @v bits		Number of bits
+ * @ret value		Decoded value
+ */
+static inline unsigned int xz_rc_reverse ( struct xz_rc *rc, uint16_t *probs,
+					   unsigned int bits ) {
+	unsigned int symbol = 1;
+	unsigned int value = 0;
+	unsigned int bit;
+	unsigned int i;
+
+	for ( i = 0 ; i < bits ; i++ ) {
+		bit = xz_rc_bit ( rc, &probs[symbol] );
+		symbol = ( ( symbol << 1 ) | bit );
+		value |= ( bit << i );
+	}
+	return value;
+}
+
+/**
+ * Decode direct bits
+ *
+ * @v rc		Range decoder
+ * @v bits		Number of bits
+ * @ret value		Decoded value
+ */
+static uint32_t xz_rc_direct ( struct xz_rc *rc, unsigned int bits ) {
+	uint32_t value = 0;
+	uint32_t mask;
+
+	while ( bits-- ) {
+		rc->range >>= 1;
+		rc->code -= rc->range;
+		mask = ( 0 - ( rc->code >> 31 ) );
+		rc->code += ( rc->range & mask );
+		value = ( ( value << 1 ) + ( mask + 1 ) );
+		xz_rc_normalise ( rc );
+	}
+	return value;
+}
+
+/**
+ * Decode match length
+ *
+ * @v rc		Range decoder
+ * @v length		Length decoder
+ * @v pos_state		Position state
+ * @ret len		Match length (excluding minimum match length)
+ */
+static unsigned int xz_lzma_length ( struct xz_rc *rc,
+				     struct xz_lzma_length *length,
+				     unsigned int pos_state ) {
+
+	if ( ! xz_rc_bit ( rc, &length->choice ) )
+		return xz_rc_tree ( rc, length->low[pos_state], 3 );
+	if ( ! xz_rc_bit ( rc, &length->choice2 ) )
+		return ( 8 + xz_rc_tree ( rc, length->mid[pos_state], 3 ) );
+	return ( 16 + xz_rc_tree ( rc, length->high, 8 ) );
+}
+
+/**
+ * Decode match distance
+ *
+ * @v rc		Range decoder
+ * @v probs		LZMA probabilities
+ * @v len		Match length (excluding minimum match length)
+ * @ret dist		Match distance (minus one)
+ */
+static uint32_t xz_lzma_distance ( struct xz_rc *rc,
+				   struct xz_lzma_probs *probs,
+				   unsigned int len ) {
+	unsigned int dist_state;
+	unsigned int slot;
+	unsigned int bits;
+	uint32_t dist;
+
+	/* Decode distance slot */
+	dist_state = ( ( len < XZ_LZMA_DIST_STATES ) ?
+		       len : ( XZ_LZMA_DIST_STATES - 1 ) );
+	slot = xz_rc_tree ( rc, probs->dist_slot[dist_state],
+			    XZ_LZMA_DIST_SLOT_BITS );
+	if ( slot < 4 )
+		return slot;
+
+	/* Decode remaining distance bits */
+	bits = ( ( slot >> 1 ) - 1 );
+	dist = ( ( 2 | ( slot & 1 ) ) << bits );
+	if ( slot < XZ_LZMA_DIST_MODEL_END ) {
+		dist += xz_rc_reverse ( rc, &probs->dist_special[ dist - slot ],
+					bits );
+	} else {
+		dist += ( xz_rc_direct ( rc, ( bits - XZ_LZMA_ALIGN_BITS ) ) <<
+			  XZ_LZMA_ALIGN_BITS );
+		dist += xz_rc_reverse ( rc, probs->dist_align,
+					XZ_LZMA_ALIGN_BITS );
+	}
+	return dist;
+}
+
+/**
+ * Reset LZMA state
+ *
+ * @v xz		Decompressor
+ */
+static void xz_lzma_reset ( struct xz *xz ) {
+	uint16_t *prob = ( ( uint16_t * ) &xz->probs );
+	unsigned int i;
+
+	for ( i = 0 ; i < ( sizeof ( xz->probs ) / sizeof ( *prob ) ) ; i++ )
+		prob[i] = XZ_RC_PROB_INIT;
+	xz->lzma_state = 0;
+	memset ( xz->rep, 0, sizeof ( xz->rep ) );
+	xz->len = 0;
+}
+
+/**
+ * Decode LZMA chunk
+ *
+ * @v xz		Decompressor
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ *
+ * Decoding continues until the chunk is complete or the output
+ * buffer is full.
+ */
+static int xz_lzma ( struct xz *xz, struct deflate_chunk *out ) {
+	struct xz_lzma_probs *probs = &xz->probs;
+	struct xz_rc rc;
+	uint8_t *base = user_to_virt ( out->data, 0 );
+	uint8_t *start = ( base + out->offset );
+	uint8_t *dst = start;
+	uint8_t *end;
+	const uint8_t *src;
+	uint16_t *literal;
+	unsigned int state = xz->lzma_state;
+	unsigned int pos_state;
+	unsigned int match_byte;
+	unsigned int match_bit;
+	unsigned int symbol;
+	unsigned int bit;
+	uint32_t rep0 = xz->rep[0];
+	uint32_t rep1 = xz->rep[1];
+	uint32_t rep2 = xz->rep[2];
+	uint32_t rep3 = xz->rep[3];
+	uint32_t dist;
+	size_t len = xz->len;
+	size_t limit;
+	size_t frag_len;
+	size_t pos;
+
+	/* Initialise range decoder */
+	rc.range = xz->range;
+	rc.code = xz->code;
+	rc.data = xz->chunk;
+	rc.offset = xz->offset;
+	rc.len = xz->compressed;
+
+	/* Limit output to the end of the chunk */
+	limit = ( out->len - out->offset );
+	if ( limit > xz->uncompressed )
+		limit = xz->uncompressed;
+	end = ( dst + limit );
+
+	while ( 1 ) {
+
+		/* Copy (remainder of) match */
+		if ( len ) {
+			frag_len = ( end - dst );
+			if ( frag_len > len )
+				frag_len = len;
+			src = ( dst - rep0 - 1 );
+			len -= frag_len;
+			while ( frag_len-- )
+				*(dst++) = *(src++);
+		}
+		if ( dst == end )
+			break;
+
+		/* Decode literal */
+		pos = ( xz->pos + ( dst - start ) );
+		pos_state = ( pos & xz->pb_mask );
+		if ( ! xz_rc_bit ( &rc, &probs->is_match[state][pos_state] ) ) {
+			symbol = ( pos ? dst[-1] : 0 );
+			literal = &probs->literal[ XZ_LZMA_LITERAL_CODER *
+						   ( ( ( pos & xz->lp_mask ) <<
+						       xz->lc ) +
+						     ( symbol >>
+						       ( 8 - xz->lc ) ) ) ];
+			symbol = 1;
+			if ( state >= XZ_LZMA_MATCH_STATE ) {
+				match_byte = *( dst - rep0 - 1 );
+				do {
+					match_bit = ( ( match_byte >> 7 ) & 1 );
+					match_byte <<= 1;
+					bit = xz_rc_bit ( &rc,
+						&literal[ 0x100 +
+							  ( match_bit << 8 ) +
+							  symbol ] );
+					symbol = ( ( symbol << 1 ) | bit );
+				} while ( ( match_bit == bit ) &&
+					  ( symbol < 0x100 ) );
+			}
+			while ( symbol < 0x100 ) {
+				symbol = ( ( symbol << 1 ) |
+					   xz_rc_bit ( &rc,
+						       &literal[symbol] ) );
+			}
+			*(dst++) = symbol;
+			state = ( ( state < 4 ) ? 0 :
+				  ( ( state < 10 ) ? ( state - 3 ) :
+				    ( state - 6 ) ) );
+			continue;
+		}
+
+		/* Decode match */
+		if ( xz_rc_bit ( &rc, &probs->is_rep[state] ) ) {
+			if ( ! xz_rc_bit ( &rc, &probs->is_rep0[state] ) ) {
+				if ( ! xz_rc_bit ( &rc,
+					&probs->is_rep0_long[state][pos_state]
+						   ) ) {
+					/* Single byte repeated match */
+					state = ( ( state < XZ_LZMA_MATCH_STATE ) ?
+						  9 : 11 );
+					len = 1;
+					goto check;
+				}
+			} else {
+				if ( ! xz_rc_bit ( &rc,
+						   &probs->is_rep1[state] ) ) {
+					dist = rep1;
+				} else {
+					if ( ! xz_rc_bit ( &rc,
+						&probs->is_rep2[state] ) ) {
+						dist = rep2;
+					} else {
+						dist = rep3;
+						rep3 = rep2;
+					}
+					rep2 = rep1;
+				}
+				rep1 = rep0;
+				rep0 = dist;
+			}
+			len = xz_lzma_length ( &rc, &probs->rep_len,
+					       pos_state );
+			state = ( ( state < XZ_LZMA_MATCH_STATE ) ? 8 : 11 );
+		} else {
+			rep3 = rep2;
+			rep2 = rep1;
+			rep1 = rep0;
+			len = xz_lzma_length ( &rc, &probs->match_len,
+					       pos_state );
+			state = ( ( state < XZ_LZMA_MATCH_STATE ) ? 7 : 10 );
+			rep0 = xz_lzma_distance ( &rc, probs, len );
+		}
+		len += XZ_LZMA_MATCH_MIN;
+
+	check:
+		/* Check that distance lies within the dictionary */
+		if ( ( rep0 >= pos ) || ( rep0 >= xz->dict_size ) ||
+		     ( rep0 >= ( size_t ) ( dst - base ) ) ) {
+			DBGC ( xz, "XZ %p invalid distance %#x\n",
+			       xz, ( rep0 + 1 ) );
+			return -EINVAL;
+		}
+	}
+
+	/* Record decoder state */
+	xz->range = rc.range;
+	xz->code = rc.code;
+	xz->offset = rc.offset;
+	xz->lzma_state = state;
+	xz->rep[0] = rep0;
+	xz->rep[1] = rep1;
+	xz->rep[2] = rep2;
+	xz->rep[3] = rep3;
+	xz->len = len;
+	out->offset += ( dst - start );
+	xz->pos += ( dst - start );
+	xz->uncompressed -= ( dst - start );
+
+	/* Check that compressed data was consumed exactly at end of chunk */
+	if ( ( rc.offset > rc.len ) ||
+	     ( ( xz->uncompressed == 0 ) &&
+	       ( ( rc.offset != rc.len ) || rc.code || len ) ) ) {
+		DBGC ( xz, "XZ %p invalid LZMA chunk\n", xz );
+		return -EINVAL;
+	}
+
+	return 0;
+}
+
+/**
+ * Consume input data
+ *
+ * @v xz		Decompressor
+ * @v in		Compressed input data
+ * @v len		Length to consume
+ */
+static inline void xz_consume ( struct xz *xz, struct deflate_chunk *in,
+				size_t len ) {
+
+	in->offset += len;
+	xz->consumed += len;
+}
+
+/**
+ * Gather fixed-length data from input
+ *
+ * @v xz		Decompressor
+ * @v in		Compressed input data
+ * @v buf		Buffer
+ * @v len		Length of data to gather
+ * @ret complete	All data has been gathered
+ */
+static int xz_gather ( struct xz *xz, struct deflate_chunk *in,
+		       void *buf, size_t len ) {
+	size_t frag_len = ( len - xz->have );
+	size_t remaining = ( in->len - in->offset );
+
+	if ( frag_len > remaining )
+		frag_len = remaining;
+	memcpy ( ( buf + xz->have ), user_to_virt ( in->data, in->offset ),
+		 frag_len );
+	xz_consume ( xz, in, frag_len );
+	xz->have += frag_len;
+
+	return ( xz->have == len );
+}
+
+/**
+ * Skip input data
+ *
+ * @v xz		Decompressor
+ * @v in		Compressed input data
+ * @ret complete	All data has been skipped
+ */
+static int xz_skip ( struct xz *xz, struct deflate_chunk *in ) {
+	size_t len = ( in->len - in->offset );
+
+	if ( len > xz->remaining )
+		len = xz->remaining;
+	xz_consume ( xz, in, len );
+	xz->remaining -= len;
+
+	return ( xz->remaining == 0 );
+}
+
+/**
+ * Skip zero padding to a four-byte boundary
+ *
+ * @v xz		Decompressor
+ * @v in		Compressed input data
+ * @ret rc		Return status code (positive when complete)
+ */
+static int xz_padding ( struct xz *xz, struct deflate_chunk *in ) {
+	const uint8_t *data = user_to_virt ( in->data, in->offset );
+
+	while ( xz->consumed & 0x03 ) {
+		if ( in->offset == in->len )
+			return 0;
+		if ( *(data++) != 0 ) {
+			DBGC ( xz, "XZ %p invalid padding\n", xz );
+			return -EINVAL;
+		}
+		xz_consume ( xz, in, 1 );
+	}
+	return 1;
+}
+
+/**
+ * Parse variable-length integer
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @v offset		Offset to update
+ * @v value		Value to fill in
+ * @ret rc		Return status code
+ */
+static int xz_vli ( const uint8_t *data, size_t len, size_t *offset,
+		    uint64_t *value ) {
+	unsigned int i;
+	uint8_t byte;
+
+	*value = 0;
+	for ( i = 0 ; i < XZ_VLI_MAX_LEN ; i++ ) {
+		if ( *offset >= len )
+			return -EINVAL;
+		byte = data[ (*offset)++ ];
+		*value |= ( ( ( uint64_t ) ( byte & ~XZ_VLI_MORE ) ) <<
+			    ( 7 * i ) );
+		if ( ! ( byte & XZ_VLI_MORE ) )
+			return 0;
+	}
+	return -EINVAL;
+}
+
+/**
+ * Parse stream header
+ *
+ * @v xz		Decompressor
+ * @ret rc		Return status code
+ */
+static int xz_stream_header ( struct xz *xz ) {
+	unsigned int check;
+
+	/* Check magic and flags */
+	if ( ( memcmp ( xz->header, xz_magic, sizeof ( xz_magic ) ) != 0 ) ||
+	     ( xz->header[ sizeof ( xz_magic ) ] != 0 ) ||
+	     ( xz->header[ sizeof ( xz_magic ) + 1 ] & ~XZ_CHECK_MAX ) ) {
+		DBGC ( xz, "XZ %p invalid stream header\n", xz );
+		DBGC_HDA ( xz, 0, xz->header, XZ_STREAM_HEADER_LEN );
+		return -EINVAL;
+	}
+
+	/* Record check length */
+	check = xz->header[ sizeof ( xz_magic ) + 1 ];
+	xz->check_len = ( check ? ( 4 << ( ( check - 1 ) / 3 ) ) : 0 );
+
+	return 0;
+}
+
+/**
+ * Parse block header
+ *
+ * @v xz		Decompressor
+ * @ret rc		Return status code
+ */
+static int xz_block_header ( struct xz *xz ) {
+	const uint8_t *data = xz->header;
+	size_t len = ( xz->header_len - sizeof ( uint32_t ) /* CRC */ );
+	size_t offset = 2;
+	unsigned int flags = data[1];
+	uint64_t value;
+	uint64_t dict;
+	unsigned int prop;
+	int rc;
+
+	/* Check flags */
+	if ( flags & XZ_BLOCK_RESERVED_MASK ) {
+		DBGC ( xz, "XZ %p invalid block flags %#02x\n", xz, flags );
+		return -EINVAL;
+	}
+	if ( flags & XZ_BLOCK_FILTERS_MASK ) {
+		DBGC ( xz, "XZ %p multiple filters not supported\n", xz );
+		return -ENOTSUP;
+	}
+
+	/* Skip compressed and uncompressed sizes, if present */
+	if ( ( flags & XZ_BLOCK_COMPRESSED_SIZE ) &&
+	     ( ( rc = xz_vli ( data, len, &offset, &value ) ) != 0 ) )
+		return rc;
+	if ( ( flags & XZ_BLOCK_UNCOMPRESSED_SIZE ) &&
+	     ( ( rc = xz_vli ( data, len, &offset, &value ) ) != 0 ) )
+		return rc;
+
+	/* Parse filter */
+	if ( ( rc = xz_vli ( data, len, &offset, &value ) ) != 0 )
+		return rc;
+	if ( value != XZ_FILTER_LZMA2 ) {
+		DBGC ( xz, "XZ %p filter %#llx not supported\n",
+		       xz, ( ( unsigned long long ) value ) );
+		return -ENOTSUP;
+	}
+	if ( ( rc = xz_vli ( data, len, &offset, &value ) ) != 0 )
+		return rc;
+	if ( ( value != 1 ) || ( offset >= len ) )
+		return -EINVAL;
+	prop = data[ offset++ ];
+	if ( prop > XZ_DICT_PROP_MAX )
+		return -EINVAL;
+	dict = ( ( 2ULL | ( prop & 1 ) ) << ( ( prop / 2 ) + 11 ) );
+	if ( dict > XZ_DICT_MAX ) {
+		DBGC ( xz, "XZ %p dictionary size %#llx not supported\n",
+		       xz, ( ( unsigned long long ) dict ) );
+		return -ENOTSUP;
+	}
+	xz->dict_size = dict;
+
+	/* Check header padding */
+	while ( offset < len ) {
+		if ( data[ offset++ ] != 0 )
+			return -EINVAL;
+	}
+
+	/* Require a dictionary reset and properties in the first chunk */
+	xz->need_dict_reset = 1;
+	xz->need_props = 1;
+
+	return 0;
+}
+
+/**
+ * Parse LZMA2 control byte
+ *
+ * @v xz		Decompressor
+ * @ret rc		Return status code
+ */
+static int xz_lzma2_control ( struct xz *xz ) {
+	unsigned int control = xz->control;
+
+	/* Handle dictionary reset */
+	if ( ( control >= XZ_LZMA2_DICT_RESET ) ||
+	     ( control == XZ_LZMA2_COPY_RESET ) ) {
+		xz->pos = 0;
+		xz->need_dict_reset = 0;
+		xz->need_props = 1;
+	} else if ( xz->need_dict_reset ) {
+		goto err;
+	}
+
+	/* Determine chunk header length */
+	if ( control >= XZ_LZMA2_LZMA ) {
+		if ( control >= XZ_LZMA2_PROPS_RESET ) {
+			xz->chunk_header_len = 5;
+		} else if ( xz->need_props ) {
+			goto err;
+		} else {
+			xz->chunk_header_len = 4;
+		}
+	} else if ( control <= XZ_LZMA2_COPY ) {
+		xz->chunk_header_len = 2;
+	} else {
+		goto err;
+	}
+
+	return 0;
+
+ err:
+	DBGC ( xz, "XZ %p invalid LZMA2 control %#02x\n", xz, control );
+	return -EINVAL;
+}
+
+/**
+ * Parse LZMA2 chunk header
+ *
+ * @v xz		Decompressor
+ * @ret rc		Return status code
+ */
+static int xz_lzma2_header ( struct xz *xz ) {
+	const uint8_t *header = xz->chunk_header;
+	unsigned int control = xz->control;
+	unsigned int props;
+	unsigned int lc;
+	unsigned int lp;
+	unsigned int pb;
+
+	/* Handle uncompressed chunks */
+	if ( control < XZ_LZMA2_LZMA ) {
+		xz->uncompressed = ( ( ( header[0] << 8 ) | header[1] ) + 1 );
+		return 0;
+	}
+
+	/* Parse lengths */
+	xz->uncompressed = ( ( ( control & 0x1f ) << 16 ) +
+			     ( ( header[0] << 8 ) | header[1] ) + 1 );
+	xz->compressed = ( ( ( header[2] << 8 ) | header[3] ) + 1 );
+	if ( xz->compressed < XZ_RC_INIT_LEN )
+		return -EINVAL;
+
+	/* Parse properties, if present */
+	if ( control >= XZ_LZMA2_PROPS_RESET ) {
+		props = header[4];
+		lc = ( props % 9 );
+		props /= 9;
+		lp = ( props % 5 );
+		pb = ( props / 5 );
+		if ( ( ( lc + lp ) > XZ_LZMA_LCLP_MAX ) ||
+		     ( pb > XZ_LZMA_PB_MAX ) ) {
+			DBGC ( xz, "XZ %p invalid LZMA properties %#02x\n",
+			       xz, header[4] );
+			return -EINVAL;
+		}
+		xz->lc = lc;
+		xz->lp_mask = ( ( 1 << lp ) - 1 );
+		xz->pb_mask = ( ( 1 << pb ) - 1 );
+		xz->need_props = 0;
+	}
+
+	/* Reset state, if applicable */
+	if ( control >= XZ_LZMA2_STATE_RESET )
+		xz_lzma_reset ( xz );
+
+	return 0;
+}
+
+/**
+ * Initialise decompressor
+ *
+ * @v xz		Decompressor
+ */
+void xz_init ( struct xz *xz ) {
+
+	memset ( xz, 0, sizeof ( *xz ) );
+	xz->state = XZ_STATE_STREAM_HEADER;
+}
+
+/**
+ * Decompress data
+ *
+ * @v xz		Decompressor
+ * @v in		Compressed input data
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ *
+ * The output data buffer must contain the dictionary of preceding
+ * decompressed data.  Decompression stops when the input is
+ * exhausted, when the compressed stream ends, or when the output
+ * buffer is full.
+ */
+int xz_decompress ( struct xz *xz, struct deflate_chunk *in,
+		    struct deflate_chunk *out ) {
+	const uint8_t *data;
+	size_t remaining;
+	size_t space;
+	size_t len;
+	uint8_t byte;
+	int rc;
+
+	while ( 1 ) {
+
+		remaining = ( in->len - in->offset );
+		space = ( out->len - out->offset );
+		data = user_to_virt ( in->data, in->offset );
+
+		switch ( xz->state ) {
+
+		case XZ_STATE_STREAM_HEADER:
+			if ( ! xz_gather ( xz, in, xz->header,
+					   XZ_STREAM_HEADER_LEN ) )
+				return 0;
+			xz->have = 0;
+			if ( ( rc = xz_stream_header ( xz ) ) != 0 )
+				return rc;
+			xz->state = XZ_STATE_BLOCK_START;
+			break;
+
+		case XZ_STATE_BLOCK_START:
+			if ( ! xz_gather ( xz, in, xz->header, 1 ) )
+				return 0;
+			if ( xz->header[0] == 0 ) {
+				/* Index indicator */
+				xz->have = 0;
+				xz->vli = 0;
+				xz->vli_len = 0;
+				xz->state = XZ_STATE_INDEX_COUNT;
+			} else {
+				xz->header_len = ( ( xz->header[0] + 1 ) * 4 );
+				xz->state = XZ_STATE_BLOCK_HEADER;
+			}
+			break;
+
+		case XZ_STATE_BLOCK_HEADER:
+			if ( ! xz_gather ( xz, in, xz->header,
+					   xz->header_len ) )
+				return 0;
+			xz->have = 0;
+			if ( ( rc = xz_block_header ( xz ) ) != 0 )
+				return rc;
+			xz->state = XZ_STATE_LZMA2_CONTROL;
+			break;
+
+		case XZ_STATE_LZMA2_CONTROL:
+			if ( ! remaining )
+				return 0;
+			xz->control = *data;
+			xz_consume ( xz, in, 1 );
+			if ( xz->control == XZ_LZMA2_END ) {
+				xz->state = XZ_STATE_BLOCK_PADDING;
+				break;
+			}
+			if ( ( rc = xz_lzma2_control ( xz ) ) != 0 )
+				return rc;
+			xz->state = XZ_STATE_LZMA2_HEADER;
+			break;
+
+		case XZ_STATE_LZMA2_HEADER:
+			if ( ! xz_gather ( xz, in, xz->chunk_header,
+					   xz->chunk_header_len ) )
+				return 0;
+			xz->have = 0;
+			if ( ( rc = xz_lzma2_header ( xz ) ) != 0 )
+				return rc;
+			xz->state = ( ( xz->control >= XZ_LZMA2_LZMA ) ?
+				      XZ_STATE_LZMA2_DATA :
+				      XZ_STATE_LZMA2_COPY );
+			break;
+
+		case XZ_STATE_LZMA2_COPY:
+			len = xz->uncompressed;
+			if ( len > remaining )
+				len = remaining;
+			if ( len > space )
+				len = space;
+			memcpy ( user_to_virt ( out->data, out->offset ),
+				 data, len );
+			xz_consume ( xz, in, len );
+			out->offset += len;
+			xz->pos += len;
+			xz->uncompressed -= len;
+			if ( xz->uncompressed )
+				return 0;
+			xz->state = XZ_STATE_LZMA2_CONTROL;
+			break;
+
+		case XZ_STATE_LZMA2_DATA:
+			if ( ! xz_gather ( xz, in, xz->chunk,
+					   xz->compressed ) )
+				return 0;
+			xz->have = 0;
+			if ( xz->chunk[0] != 0 ) {
+				DBGC ( xz, "XZ %p invalid range coder\n", xz );
+				return -EINVAL;
+			}
+			xz->range = 0xffffffffUL;
+			xz->code = ( ( ( ( uint32_t ) xz->chunk[1] ) << 24 ) |
+				     ( xz->chunk[2] << 16 ) |
+				     ( xz->chunk[3] << 8 ) | xz->chunk[4] );
+			xz->offset = XZ_RC_INIT_LEN;
+			xz->state = XZ_STATE_LZMA2_DECODE;
+			break;
+
+		case XZ_STATE_LZMA2_DECODE:
+			if ( ( rc = xz_lzma ( xz, out ) ) != 0 )
+				return rc;
+			if ( xz->uncompressed )
+				return 0;
+			xz->state = XZ_STATE_LZMA2_CONTROL;
+			break;
+
+		case XZ_STATE_BLOCK_PADDING:
+			if ( ( rc = xz_padding ( xz, in ) ) <= 0 )
+				return rc;
+			xz->remaining = xz->check_len;
+			xz->state = XZ_STATE_BLOCK_CHECK;
+			break;
+
+		case XZ_STATE_BLOCK_CHECK:
+			/* Integrity check is not verified */
+			if ( ! xz_skip ( xz, in ) )
+				return 0;
+			xz->state = XZ_STATE_BLOCK_START;
+			break;
+
+		case XZ_STATE_INDEX_COUNT:
+			if ( ! remaining )
+				return 0;
+			byte = *data;
+			xz_consume ( xz, in, 1 );
+			xz->vli |= ( ( ( uint64_t ) ( byte & ~XZ_VLI_MORE ) ) <<
+				     ( 7 * xz->vli_len++ ) );
+			if ( byte & XZ_VLI_MORE ) {
+				if ( xz->vli_len >= XZ_VLI_MAX_LEN )
+					return -EINVAL;
+				break;
+			}
+			xz->index_fields = ( 2 * xz->vli );
+			if ( ( xz->index_fields / 2 ) != xz->vli )
+				return -EINVAL;
+			xz->state = XZ_STATE_INDEX_RECORD;
+			break;
+
+		case XZ_STATE_INDEX_RECORD:
+			/* Index records are not verified */
+			while ( xz->index_fields ) {
+				if ( ! remaining-- )
+					return 0;
+				if ( ! ( *(data++) & XZ_VLI_MORE ) )
+					xz->index_fields--;
+				xz_consume ( xz, in, 1 );
+			}
+			xz->state = XZ_STATE_INDEX_PADDING;
+			break;
+
+		case XZ_STATE_INDEX_PADDING:
+			if ( ( rc = xz_padding ( xz, in ) ) <= 0 )
+				return rc;
+			xz->remaining = sizeof ( uint32_t ) /* CRC */;
+			xz->state = XZ_STATE_INDEX_CRC;
+			break;
+
+		case XZ_STATE_INDEX_CRC:
+			if ( ! xz_skip ( xz, in ) )
+				return 0;
+			xz->state = XZ_STATE_FOOTER;
+			break;
+
+		case XZ_STATE_FOOTER:
+			if ( ! xz_gather ( xz, in, xz->header,
+					   XZ_STREAM_HEADER_LEN ) )
+				return 0;
+			xz->have = 0;
+			if ( memcmp ( &xz->header[ XZ_STREAM_HEADER_LEN -
+						   sizeof ( xz_footer_magic ) ],
+				      xz_footer_magic,
+				      sizeof ( xz_footer_magic ) ) != 0 ) {
+				DBGC ( xz, "XZ %p invalid stream footer\n",
+				       xz );
+				return -EINVAL;
+			}
+			xz->state = XZ_STATE_DONE;
+			break;
+
+		default: /* XZ_STATE_DONE */
+			return 0;
+		}
+	}
+}
+
+/**
+ * Initialise decompressor
+ *
+ * @v ctx		Decompressor
+ */
+static void xz_step_init ( void *ctx ) {
+
+	xz_init ( ctx );
+}
+
+/**
+ * Decompress data
+ *
+ * @v ctx		Decompressor
+ * @v in		Compressed input data
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ */
+static int xz_step ( void *ctx, struct deflate_chunk *in,
+		     struct deflate_chunk *out ) {
+
+	return xz_decompress ( ctx, in, out );
+}
+
+/**
+ * Check if decompression has finished
+ *
+ * @v ctx		Decompressor
+ * @ret finished	Decompression has finished
+ */
+static int xz_step_finished ( void *ctx ) {
+
+	return xz_finished ( ctx );
+}
+
+/**
+ * Get history window length
+ *
+ * @v ctx		Decompressor
+ * @ret window		Length of preceding output to be retained
+ */
+static size_t xz_window ( void *ctx ) {
+	struct xz *xz = ctx;
+
+	return xz->dict_size;
+}
+
+/** XZ decompression algorithm */
+struct inflate_algorithm xz_algorithm = {
+	.name = "xz",
+	.ctxsize = sizeof ( struct xz ),
+	.step = 1,
+	.init = xz_step_init,
+	.decompress = xz_step,
+	.finished = xz_step_finished,
+	.window = xz_window,
+};
@@ -0,0 +1,1368 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <assert.h>
+#include <byteswap.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/deflate.h>
+#include <ipxe/zstd.h>
+
+/** @file
+ *
+ * Zstandard decompression algorithm
+ *
+ * This file implements a decompressor for the Zstandard format
+ * specified in RFC 8878.  Dictionaries are not supported, and content
+ * checksums are not verified (matching the treatment of the DEFLATE
+ * checksums).  Decompression stops at the end of the first frame;
+ * any subsequent data is ignored.
+ *
+ * The history window is held in the output buffer.  A block is
+ * decompressed only when enough free output space is available to
+ * hold the whole block.
+ *
+ */
+
+/** A backward bitstream
+ *
+ * FSE and Huffman bitstreams are written forwards and read backwards,
+ * starting from the final (non-zero) byte.  Reading beyond the start
+ * of the bitstream produces zero bits.
+ */
+struct zstd_bitstream {
+	/** Data */
+	const uint8_t *data;
+	/** Length of data */
+	size_t len;
+	/** Current bit position (may become negative) */
+	long pos;
+};
+
+/** Literals length codes */
+static const struct {
+	/** Baseline */
+	uint32_t base;
+	/** Number of extra bits */
+	uint8_t bits;
+} zstd_ll_codes[ ZSTD_LL_MAX_CODE + 1 ] = {
+	{ 0, 0 }, { 1, 0 }, { 2, 0 }, { 3, 0 }, { 4, 0 }, { 5, 0 },
+	{ 6, 0 }, { 7, 0 }, { 8, 0 }, { 9, 0 }, { 10, 0 }, { 11, 0 },
+	{ 12, 0 }, { 13, 0 }, { 14, 0 }, { 15, 0 }, { 16, 1 }, { 18, 1 },
+	{ 20, 1 }, { 22, 1 }, { 24, 2 }, { 28, 2 }, { 32, 3 }, { 40, 3 },
+	{ 48, 4 }, { 64, 6 }, { 128, 7 }, { 256, 8 }, { 512, 9 },
+	{ 1024, 10 }, { 2048, 11 }, { 4096, 12 }, { 8192, 13 },
+	{ 16384, 14 }, { 32768, 15 }, { 65536, 16 },
+};
+
+/** Match length codes */
+static const struct {
+	/** Baseline */
+	uint32_t base;
+	/** Number of extra bits */
+	uint8_t bits;
+} zstd_ml_codes[ ZSTD_ML_MAX_CODE + 1 ] = {
+	{ 3, 0 }, { 4, 0 }, { 5, 0 }, { 6, 0 }, { 7, 0 }, { 8, 0 },
+	{ 9, 0 }, { 10, 0 }, { 11, 0 }, { 12, 0 }, { 13, 0 }, { 14, 0 },
+	{ 15, 0 }, { 16, 0 }, { 17, 0 }, { 18, 0 }, { 19, 0 }, { 20, 0 },
+	{ 21, 0 }, { 22, 0 }, { 23, 0 }, { 24, 0 }, { 25, 0 }, { 26, 0 },
+	{ 27, 0 }, { 28, 0 }, { 29, 0 }, { 30, 0 }, { 31, 0 }, { 32, 0 },
+	{ 33, 0 }, { 34, 0 }, { 35, 1 }, { 37, 1 }, { 39, 1 }, { 41, 1 },
+	{ 43, 2 }, { 47, 2 }, { 51, 3 }, { 59, 3 }, { 67, 4 }, { 83, 4 },
+	{ 99, 5 }, { 131, 7 }, { 259, 8 }, { 515, 9 }, { 1027, 10 },
+	{ 2051, 11 }, { 4099, 12 }, { 8195, 13 }, { 16387, 14 },
+	{ 32771, 15 }, { 65539, 16 },
+};
+
+/** Predefined literals length distribution */
+static const int16_t zstd_ll_default[ ZSTD_LL_MAX_CODE + 1 ] = {
+	4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1, 2, 2, 2, 2, 2, 2,
+	2, 2, 2, 3, 2, 1, 1, 1, 1, 1, -1, -1, -1, -1,
+};
+
+/** Predefined match length distribution */
+static const int16_t zstd_ml_default[ ZSTD_ML_MAX_CODE + 1 ] = {
+	1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, -1, -1, -1, -1, -1, -1, -1,
+};
+
+/** Predefined offset distribution */
+static const int16_t zstd_of_default[ ZSTD_OF_MAX_CODE + 1 ] = {
+	1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+	1, 1, -1, -1, -1, -1, -1,
+};
+
+/** Length of frame header dictionary ID fields */
+static const uint8_t zstd_dict_len[] = { 0, 1, 2, 4 };
+
+/** Length of frame header content size fields */
+static const uint8_t zstd_fcs_len[] = { 0, 2, 4, 8 };
+
+/**
+ * Read little-endian value from byte array
+ *
+ * @v data		Data
+ * @v len		Length of value
+ * @ret value		Value
+ */
+static uint64_t zstd_le ( const uint8_t *data, size_t len ) {
+	uint64_t value = 0;
+
+	while ( len-- )
+		value = ( ( value << 8 ) | data[len] );
+	return value;
+}
+
+/**
+ * Initialise backward bitstream
+ *
+ * @v bs		Bitstream
+ * @v data		Data
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int zstd_bits_init ( struct zstd_bitstream *bs, const uint8_t *data,
+			    size_t len ) {
+
+	/* Final byte must contain the start marker bit */
+	if ( ( len == 0 ) || ( data[ len - 1 ] == 0 ) )
+		return -EINVAL;
+
+	/* Start immediately below the marker bit */
+	bs->data = data;
+	bs->len = len;
+	bs->pos = ( ( 8 * ( len - 1 ) ) + fls ( data[ len - 1 ] ) - 1 );
+	return 0;
+}
+
+/**
+ * Peek at bits from backward bitstream
+ *
+ * @v bs		Bitstream
+ * @v bits		Number of bits (at most 32)
+ * @ret value		Value
+ */
+static inline uint32_t zstd_bits_peek ( struct zstd_bitstream *bs,
+					unsigned int bits ) {
+	long pos = ( bs->pos - bits );
+	size_t offset;
+	uint64_t word;
+
+	/* Load bits, treating data before the start as zero */
+	if ( pos >= 0 ) {
+		offset = ( pos / 8 );
+		if ( ( offset + sizeof ( word ) ) <= bs->len ) {
+			memcpy ( &word, ( bs->data + offset ),
+				 sizeof ( word ) );
+			word = le64_to_cpu ( word );
+		} else {
+			word = zstd_le ( ( bs->data + offset ),
+					 ( bs->len - offset ) );
+		}
+		word >>= ( pos % 8 );
+	} else if ( pos > -( ( long ) bits ) ) {
+		word = zstd_le ( bs->data, ( ( bs->len < sizeof ( word ) ) ?
+					     bs->len : sizeof ( word ) ) );
+		word <<= -pos;
+	} else {
+		word = 0;
+	}
+
+	return ( word & ( ( 1ULL << bits ) - 1 ) );
+}
+
+/**
+ * Read bits from backward bitstream
+ *
+ * @v bs		Bitstream
+ * @v bits		Number of bits (at most 32)
+ * @ret value		Value
+ */
+static inline uint32_t zstd_bits_read ( struct zstd_bitstream *bs,
+					unsigned int bits ) {
+	uint32_t value;
+
+	value = zstd_bits_peek ( bs, bits );
+	bs->pos -= bits;
+	return value;
+}
+
+/**
+ * Read bits from forward bitstream
+ *
+ * @v data		Data
+ * @v len		Length of data
+ * @v pos		Bit position to update
+ * @v bits		Number of bits (at most 16)
+ * @ret value		Value
+ *
+ * Reading beyond the end of the data produces zero bits.  The caller
+ * must check the final bit position.
+ */
+static unsigned int zstd_bits_forward ( const uint8_t *data, size_t len,
+					size_t *pos, unsigned int bits ) {
+	size_t offset = ( *pos / 8 );
+	unsigned int value;
+
+	value = ( ( offset < len ) ?
+		  zstd_le ( ( data + offset ),
+			    ( ( ( len - offset ) < 4 ) ? ( len - offset ) : 4 ) )
+		  : 0 );
+	value = ( ( value >> ( *pos % 8 ) ) & ( ( 1 << bits ) - 1 ) );
+	*pos += bits;
+	return value;
+}
+
+/**
+ * Construct FSE decoding table
+ *
+ * @v table		FSE table
+ * @v counts		Normalised counts
+ * @v symbols		Number of symbols
+ * @v accuracy		Accuracy (log2 of table size)
+ * @ret rc		Return status code
+ */
+static int zstd_fse_build ( struct zstd_fse_table *table,
+			    const int16_t *counts, unsigned int symbols,
+			    unsigned int accuracy ) {
+	struct zstd_fse_entry *entry;
+	uint16_t next[ZSTD_FSE_MAX_SYMBOLS];
+	unsigned int size = ( 1 << accuracy );
+	unsigned int mask = ( size - 1 );
+	unsigned int step = ( ( size >> 1 ) + ( size >> 3 ) + 3 );
+	unsigned int high = size;
+	unsigned int pos = 0;
+	unsigned int symbol;
+	unsigned int state;
+	unsigned int bits;
+	int i;
+
+	/* Mark table as invalid until construction succeeds */
+	table->accuracy = -1;
+
+	/* Allocate "less than one" probability symbols from the end */
+	for ( symbol = 0 ; symbol < symbols ; symbol++ ) {
+		if ( counts[symbol] == -1 ) {
+			if ( high == 0 )
+				return -EINVAL;
+			table->entry[--high].symbol = symbol;
+			next[symbol] = 1;
+		}
+	}
+
+	/* Spread remaining symbols across the table */
+	for ( symbol = 0 ; symbol < symbols ; symbol++ ) {
+		if ( counts[symbol] <= 0 )
+			continue;
+		next[symbol] = counts[symbol];
+		for ( i = 0 ; i < counts[symbol] ; i++ ) {
+			table->entry[pos].symbol = symbol;
+			do {
+				pos = ( ( pos + step ) & mask );
+			} while ( pos >= high );
+		}
+	}
+	if ( pos != 0 )
+		return -EINVAL;
+
+	/* Construct next state baselines */
+	for ( pos = 0 ; pos < size ; pos++ ) {
+		entry = &table->entry[pos];
+		state = next[entry->symbol]++;
+		bits = ( accuracy + 1 - fls ( state ) );
+		entry->bits = bits;
+		entry->base = ( ( state << bits ) - size );
+	}
+
+	table->accuracy = accuracy;
+	return 0;
+}
+
+/**
+ * Construct single-symbol FSE decoding table
+ *
+ * @v table		FSE table
+ * @v symbol		Symbol
+ */
+static void zstd_fse_rle ( struct zstd_fse_table *table,
+			   unsigned int symbol ) {
+
+	table->entry[0].symbol = symbol;
+	table->entry[0].bits = 0;
+	table->entry[0].base = 0;
+	table->accuracy = 0;
+}
+
+/**
+ * Parse FSE table description and construct decoding table
+ *
+ * @v table		FSE table
+ * @v data		Table description
+ * @v len		Length of available data
+ * @v symbols		Maximum number of symbols
+ * @v max_accuracy	Maximum accuracy
+ * @ret used		Length of table description
+ * @ret rc		Return status code
+ */
+static int zstd_fse_parse ( struct zstd_fse_table *table, const uint8_t *data,
+			    size_t len, unsigned int symbols,
+			    unsigned int max_accuracy, size_t *used ) {
+	int16_t counts[ZSTD_FSE_MAX_SYMBOLS];
+	unsigned int accuracy;
+	unsigned int symbol = 0;
+	unsigned int repeat;
+	unsigned int threshold;
+	unsigned int lower;
+	unsigned int value;
+	unsigned int bits;
+	unsigned int i;
+	size_t pos = 0;
+	int remaining;
+	int count;
+
+	/* Read accuracy */
+	accuracy = ( ZSTD_FSE_MIN_ACCURACY +
+		     zstd_bits_forward ( data, len, &pos, 4 ) );
+	if ( accuracy > max_accuracy )
+		return -EINVAL;
+
+	/* Read normalised counts */
+	remaining = ( 1 << accuracy );
+	while ( remaining > 0 ) {
+
+		/* Read variable-length count */
+		if ( symbol >= symbols )
+			return -EINVAL;
+		bits = fls ( remaining + 1 );
+		lower = ( ( 1 << ( bits - 1 ) ) - 1 );
+		threshold = ( ( 1 << bits ) - 1 - ( remaining + 1 ) );
+		value = zstd_bits_forward ( data, len, &pos, bits );
+		if ( ( value & lower ) < threshold ) {
+			value &= lower;
+			pos--;
+		} else if ( value > lower ) {
+			value -= threshold;
+		}
+		count = ( ( ( int ) value ) - 1 );
+		remaining -= ( ( count < 0 ) ? -count : count );
+		counts[symbol++] = count;
+
+		/* Read repeated zero counts */
+		if ( count == 0 ) {
+			do {
+				repeat = zstd_bits_forward ( data, len,
+							     &pos, 2 );
+				if ( ( symbol + repeat ) > symbols )
+					return -EINVAL;
+				for ( i = 0 ; i < repeat ; i++ )
+					counts[symbol++] = 0;
+			} while ( repeat == 3 );
+		}
+	}
+	if ( remaining != 0 )
+		return -EINVAL;
+
+	/* Check that description lies within the available data */
+	*used = ( ( pos + 7 ) / 8 );
+	if ( *used > len )
+		return -EINVAL;
+
+	/* Construct decoding table */
+	return zstd_fse_build ( table, counts, symbol, accuracy );
+}
+
+/**
+ * Parse Huffman tree description and construct decoding table
+ *
+ * @v zstd		Decompressor
+ * @v data		Tree description
+ * @v len		Length of available data
+ * @ret used		Length of tree description
+ * @ret rc		Return status code
+ */
+static int zstd_huf_parse ( struct zstd *zstd, const uint8_t *data,
+			    size_t len, size_t *used ) {
+	struct zstd_fse_table *fse = &zstd->weights;
+	struct zstd_fse_entry *entry;
+	struct zstd_bitstream bs;
+	uint8_t weights[ZSTD_HUF_MAX_SYMBOLS];
+	unsigned int next[ ZSTD_HUF_MAX_BITS + 1 ];
+	unsigned int state[2];
+	unsigned int count = 0;
+	unsigned int header;
+	unsigned int weight;
+	unsigned int bits;
+	unsigned int max;
+	unsigned int symbol;
+	unsigned int index;
+	unsigned int fill;
+	unsigned int i;
+	uint32_t sum;
+	uint32_t rem;
+	size_t table_len;
+	int rc;
+
+	/* Mark table as invalid until construction succeeds */
+	zstd->huf_bits = 0;
+
+	/* Read weights */
+	if ( ! len )
+		return -EINVAL;
+	header = data[0];
+	if ( header < 128 ) {
+
+		/* FSE-compressed weights */
+		*used = ( 1 + header );
+		if ( *used > len )
+			return -EINVAL;
+		if ( ( rc = zstd_fse_parse ( fse, ( data + 1 ), header,
+					     ( ZSTD_HUF_MAX_BITS + 1 ),
+					     ZSTD_HUF_WEIGHT_MAX_ACCURACY,
+					     &table_len ) ) != 0 )
+			return rc;
+		if ( ( rc = zstd_bits_init ( &bs, ( data + 1 + table_len ),
+					     ( header - table_len ) ) ) != 0 )
+			return rc;
+
+		/* Decode weights using two interleaved states.  The
+		 * final weight is decoded from the other state once
+		 * the bitstream has been exhausted.
+		 */
+		state[0] = zstd_bits_read ( &bs, fse->accuracy );
+		state[1] = zstd_bits_read ( &bs, fse->accuracy );
+		for ( i = 0 ; ; i ^= 1 ) {
+			if ( count >= ( ZSTD_HUF_MAX_SYMBOLS - 2 ) )
+				return -EINVAL;
+			entry = &fse->entry[ state[i] ];
+			weights[count++] = entry->symbol;
+			state[i] = ( entry->base +
+				     zstd_bits_read ( &bs, entry->bits ) );
+			if ( bs.pos < 0 ) {
+				entry = &fse->entry[ state[ i ^ 1 ] ];
+				weights[count++] = entry->symbol;
+				break;
+			}
+		}
+
+	} else {
+
+		/* Directly represented weights */
+		count = ( header - 127 );
+		*used = ( 1 + ( ( count + 1 ) / 2 ) );
+		if ( *used > len )
+			return -EINVAL;
+		for ( i = 0 ; i < count ; i++ ) {
+			weight = data[ 1 + ( i / 2 ) ];
+			weights[i] = ( ( i & 1 ) ? ( weight & 0x0f ) :
+				       ( weight >> 4 ) );
+		}
+	}
+
+	/* Calculate maximum code length and implied final weight */
+	sum = 0;
+	for ( i = 0 ; i < count ; i++ ) {
+		weight = weights[i];
+		if ( weight > ZSTD_HUF_MAX_BITS )
+			return -EINVAL;
+		if ( weight )
+			sum += ( 1 << ( weight - 1 ) );
+	}
+	if ( ! sum )
+		return -EINVAL;
+	max = fls ( sum );
+	if ( max > ZSTD_HUF_MAX_BITS )
+		return -EINVAL;
+	rem = ( ( 1 << max ) - sum );
+	if ( rem & ( rem - 1 ) )
+		return -EINVAL;
+	weights[count++] = fls ( rem );
+
+	/* Allocate table ranges by code length, longest codes first */
+	memset ( next, 0, sizeof ( next ) );
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		if ( weights[symbol] )
+			next[ max + 1 - weights[symbol] ]++;
+	}
+	index = 0;
+	for ( bits = max ; bits ; bits-- ) {
+		fill = next[bits];
+		next[bits] = index;
+		index += ( fill << ( max - bits ) );
+	}
+	assert ( index == ( 1U << max ) );
+
+	/* Populate table */
+	for ( symbol = 0 ; symbol < count ; symbol++ ) {
+		if ( ! weights[symbol] )
+			continue;
+		bits = ( max + 1 - weights[symbol] );
+		fill = ( 1 << ( max - bits ) );
+		for ( i = 0 ; i < fill ; i++ ) {
+			zstd->huf[ next[bits] + i ].symbol = symbol;
+			zstd->huf[ next[bits] + i ].bits = bits;
+		}
+		next[bits] += fill;
+	}
+
+	zstd->huf_bits = max;
+	return 0;
+}
+
+/**
+ * Decode Huffman-coded literals stream
+ *
+ * @v zstd		Decompressor
+ * @v data		Stream
+ * @v len		Length of stream
+ * @v out		Output buffer
+ * @v count		Number of literals
+ * @ret rc		Return status code
+ */
+static int zstd_huf_stream ( struct zstd *zstd, const uint8_t *data,
+			     size_t len, uint8_t *out, size_t count ) {
+	struct zstd_huf_entry *entry;
+	struct zstd_bitstream bs;
+	int rc;
+
+	/* Initialise bitstream */
+	if ( ( rc = zstd_bits_init ( &bs, data, len ) ) != 0 )
+		return rc;
+
+	/* Decode literals */
+	while ( count-- ) {
+		entry = &zstd->huf[ zstd_bits_peek ( &bs, zstd->huf_bits ) ];
+		*(out++) = entry->symbol;
+		bs.pos -= entry->bits;
+	}
+
+	/* Check that the stream has been consumed exactly */
+	if ( bs.pos != 0 )
+		return -EINVAL;
+
+	return 0;
+}
+
+/**
+ * Decode literals section
+ *
+ * @v zstd		Decompressor
+ * @v data		Block contents
+ * @v len		Length of block contents
+ * @ret literals	Literals
+ * @ret count		Number of literals
+ * @ret used		Length of literals section
+ * @ret rc		Return status code
+ */
+static int zstd_literals ( struct zstd *zstd, const uint8_t *data, size_t len,
+			   const uint8_t **literals, size_t *count,
+			   size_t *used ) {
+	const uint8_t *stream;
+	uint8_t *out;
+	unsigned int type;
+	unsigned int format;
+	unsigned int header_len;
+	unsigned int field_bits;
+	unsigned int streams;
+	unsigned int i;
+	size_t stream_len[4];
+	size_t compressed;
+	size_t segment;
+	size_t tree_len;
+	uint64_t fields;
+	int rc;
+
+	/* Parse header */
+	if ( ! len )
+		return -EINVAL;
+	type = ( data[0] & 0x03 );
+	format = ( ( data[0] >> 2 ) & 0x03 );
+	if ( ( type == ZSTD_LITERALS_RAW ) || ( type == ZSTD_LITERALS_RLE ) ) {
+		header_len = ( ( format & 1 ) ? ( 2 + ( format >> 1 ) ) : 1 );
+		if ( header_len > len )
+			return -EINVAL;
+		*count = ( zstd_le ( data, header_len ) >>
+			   ( ( format & 1 ) ? 4 : 3 ) );
+		compressed = ( ( type == ZSTD_LITERALS_RAW ) ? *count : 1 );
+		streams = 0;
+	} else {
+		header_len = ( ( format < 2 ) ? 3 : ( format + 2 ) );
+		field_bits = ( ( format < 2 ) ? 10 : ( 6 + ( 4 * format ) ) );
+		streams = ( format ? 4 : 1 );
+		if ( header_len > len )
+			return -EINVAL;
+		fields = ( zstd_le ( data, header_len ) >> 4 );
+		*count = ( fields & ( ( 1 << field_bits ) - 1 ) );
+		compressed = ( ( fields >> field_bits ) &
+			       ( ( 1 << field_bits ) - 1 ) );
+	}
+	if ( *count > zstd->block_max ) {
+		DBGC ( zstd, "ZSTD %p literals overlength (%zd bytes)\n",
+		       zstd, *count );
+		return -EINVAL;
+	}
+	if ( compressed > ( len - header_len ) )
+		return -EINVAL;
+	*used = ( header_len + compressed );
+	data += header_len;
+
+	/* Decode literals */
+	switch ( type ) {
+
+	case ZSTD_LITERALS_RAW:
+		*literals = data;
+		return 0;
+
+	case ZSTD_LITERALS_RLE:
+		memset ( zstd->literals, data[0], *count );
+		*literals = zstd->literals;
+		return 0;
+
+	case ZSTD_LITERALS_COMPRESSED:
+		if ( ( rc = zstd_huf_parse ( zstd, data, compressed,
+					     &tree_len ) ) != 0 ) {
+			DBGC ( zstd, "ZSTD %p invalid Huffman tree: %s\n",
+			       zstd, strerror ( rc ) );
+			return rc;
+		}
+		data += tree_len;
+		compressed -= tree_len;
+		break;
+
+	default: /* ZSTD_LITERALS_TREELESS */
+		if ( ! zstd->huf_bits ) {
+			DBGC ( zstd, "ZSTD %p missing Huffman tree\n", zstd );
+			return -EINVAL;
+		}
+		break;
+	}
+
+	/* Identify streams */
+	if ( streams == 1 ) {
+		stream_len[0] = compressed;
+		segment = *count;
+	} else {
+		if ( compressed < 6 )
+			return -EINVAL;
+		stream_len[3] = ( compressed - 6 );
+		for ( i = 0 ; i < 3 ; i++ ) {
+			stream_len[i] = zstd_le ( ( data + ( 2 * i ) ), 2 );
+			if ( stream_len[i] > stream_len[3] )
+				return -EINVAL;
+			stream_len[3] -= stream_len[i];
+		}
+		data += 6;
+		segment = ( ( *count + 3 ) / 4 );
+		if ( ( 3 * segment ) > *count )
+			return -EINVAL;
+	}
+
+	/* Decode streams */
+	stream = data;
+	out = zstd->literals;
+	for ( i = 0 ; i < streams ; i++ ) {
+		if ( i == 3 )
+			segment = ( *count - ( 3 * segment ) );
+		if ( ( rc = zstd_huf_stream ( zstd, stream, stream_len[i],
+					      out, segment ) ) != 0 ) {
+			DBGC ( zstd, "ZSTD %p invalid literals stream %d\n",
+			       zstd, i );
+			return rc;
+		}
+		stream += stream_len[i];
+		out += segment;
+	}
+	*literals = zstd->literals;
+
+	return 0;
+}
+
+/**
+ * Construct sequence decoding table
+ *
+ * @v zstd		Decompressor
+ * @v table		FSE table
+ * @v mode		Compression mode
+ * @v counts		Predefined distribution
+ * @v accuracy		Predefined distribution accuracy
+ * @v symbols		Number of symbols
+ * @v max_accuracy	Maximum accuracy
+ * @v data		Table description
+ * @v len		Length of available data
+ * @ret used		Length of table description
+ * @ret rc		Return status code
+ */
+static int zstd_table ( struct zstd *zstd, struct zstd_fse_table *table,
+			unsigned int mode, const int16_t *counts,
+			unsigned int accuracy, unsigned int symbols,
+			unsigned int max_accuracy, const uint8_t *data,
+			size_t len, size_t *used ) {
+	int rc;
+
+	*used = 0;
+	switch ( mode ) {
+
+	case ZSTD_MODE_PREDEFINED:
+		return zstd_fse_build ( table, counts, symbols, accuracy );
+
+	case ZSTD_MODE_RLE:
+		if ( ( ! len ) || ( data[0] >= symbols ) )
+			return -EINVAL;
+		zstd_fse_rle ( table, data[0] );
+		*used = 1;
+		return 0;
+
+	case ZSTD_MODE_COMPRESSED:
+		if ( ( rc = zstd_fse_parse ( table, data, len, symbols,
+					     max_accuracy, used ) ) != 0 ) {
+			DBGC ( zstd, "ZSTD %p invalid FSE table: %s\n",
+			       zstd, strerror ( rc ) );
+			return rc;
+		}
+		return 0;
+
+	default: /* ZSTD_MODE_REPEAT */
+		if ( table->accuracy < 0 ) {
+			DBGC ( zstd, "ZSTD %p missing FSE table\n", zstd );
+			return -EINVAL;
+		}
+		return 0;
+	}
+}
+
+/**
+ * Copy duplicate string within output buffer
+ *
+ * @v dst		Destination
+ * @v offset		Offset to source
+ * @v len		Length
+ */
+static inline void zstd_copy ( uint8_t *dst, size_t offset, size_t len ) {
+	const uint8_t *src = ( dst - offset );
+
+	if ( offset >= len ) {
+		memcpy ( dst, src, len );
+	} else {
+		while ( len-- )
+			*(dst++) = *(src++);
+	}
+}
+
+/**
+ * Decode sequences section and execute sequences
+ *
+ * @v zstd		Decompressor
+ * @v data		Sequences section
+ * @v len		Length of sequences section
+ * @v literals		Literals
+ * @v count		Number of literals
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ */
+static int zstd_sequences ( struct zstd *zstd, const uint8_t *data,
+			    size_t len, const uint8_t *literals, size_t count,
+			    struct deflate_chunk *out ) {
+	struct zstd_fse_entry *ll;
+	struct zstd_fse_entry *of;
+	struct zstd_fse_entry *ml;
+	struct zstd_bitstream bs;
+	uint8_t *base = user_to_virt ( out->data, 0 );
+	size_t remaining = zstd->block_max;
+	unsigned int sequences;
+	unsigned int modes;
+	unsigned int ll_state = 0;
+	unsigned int of_state = 0;
+	unsigned int ml_state = 0;
+	unsigned int index;
+	uint32_t literal_len;
+	uint32_t match_len;
+	uint32_t offset;
+	size_t used;
+	int rc;
+
+	/* Parse header */
+	bs.pos = 0;
+	if ( ! len )
+		return -EINVAL;
+	sequences = data[0];
+	if ( sequences == 0 ) {
+		used = 1;
+	} else if ( sequences < 128 ) {
+		used = 2;
+	} else if ( sequences < 255 ) {
+		used = 3;
+		if ( used > len )
+			return -EINVAL;
+		sequences = ( ( ( sequences - 128 ) << 8 ) + data[1] );
+	} else {
+		used = 4;
+		if ( used > len )
+			return -EINVAL;
+		sequences = ( zstd_le ( ( data + 1 ), 2 ) + 0x7f00 );
+	}
+	if ( sequences ) {
+		if ( used > len )
+			return -EINVAL;
+		modes = data[ used - 1 ];
+		if ( modes & 0x03 )
+			return -EINVAL;
+	} else {
+		modes = 0;
+	}
+	data += used;
+	len -= used;
+
+	/* Construct decoding tables */
+	if ( sequences ) {
+		if ( ( rc = zstd_table ( zstd, &zstd->ll, ( modes >> 6 ),
+					 zstd_ll_default,
+					 ZSTD_LL_DEFAULT_ACCURACY,
+					 ( ZSTD_LL_MAX_CODE + 1 ),
+					 ZSTD_LL_MAX_ACCURACY,
+					 data, len, &used ) ) != 0 )
+			return rc;
+		data += used;
+		len -= used;
+		if ( ( rc = zstd_table ( zstd, &zstd->of,
+					 ( ( modes >> 4 ) & 0x03 ),
+					 zstd_of_default,
+					 ZSTD_OF_DEFAULT_ACCURACY,
+					 ( ZSTD_OF_MAX_CODE + 1 ),
+					 ZSTD_OF_MAX_ACCURACY,
+					 data, len, &used ) ) != 0 )
+			return rc;
+		data += used;
+		len -= used;
+		if ( ( rc = zstd_table ( zstd, &zstd->ml,
+					 ( ( modes >> 2 ) & 0x03 ),
+					 zstd_ml_default,
+					 ZSTD_ML_DEFAULT_ACCURACY,
+					 ( ZSTD_ML_MAX_CODE + 1 ),
+					 ZSTD_ML_MAX_ACCURACY,
+					 data, len, &used ) ) != 0 )
+			return rc;
+		data += used;
+		len -= used;
+
+		/* Initialise states */
+		if ( ( rc = zstd_bits_init ( &bs, data, len ) ) != 0 )
+			return rc;
+		ll_state = zstd_bits_read ( &bs, zstd->ll.accuracy );
+		of_state = zstd_bits_read ( &bs, zstd->of.accuracy );
+		ml_state = zstd_bits_read ( &bs, zstd->ml.accuracy );
+	}
+
+	/* Execute sequences */
+	for ( ; sequences ; sequences-- ) {
+
+		/* Decode sequence */
+		ll = &zstd->ll.entry[ll_state];
+		of = &zstd->of.entry[of_state];
+		ml = &zstd->ml.entry[ml_state];
+		offset = ( ( 1UL << of->symbol ) +
+			   zstd_bits_read ( &bs, of->symbol ) );
+		match_len = ( zstd_ml_codes[ml->symbol].base +
+			      zstd_bits_read ( &bs,
+					       zstd_ml_codes[ml->symbol].bits ) );
+		literal_len = ( zstd_ll_codes[ll->symbol].base +
+				zstd_bits_read ( &bs,
+					zstd_ll_codes[ll->symbol].bits ) );
+
+		/* Update states (except after the final sequence) */
+		if ( sequences > 1 ) {
+			ll_state = ( ll->base + zstd_bits_read ( &bs, ll->bits ) );
+			ml_state = ( ml->base + zstd_bits_read ( &bs, ml->bits ) );
+			of_state = ( of->base + zstd_bits_read ( &bs, of->bits ) );
+		}
+
+		/* Resolve repeated offsets */
+		if ( offset > 3 ) {
+			offset -= 3;
+			zstd->rep[2] = zstd->rep[1];
+			zstd->rep[1] = zstd->rep[0];
+			zstd->rep[0] = offset;
+		} else {
+			index = ( offset - ( literal_len ? 1 : 0 ) );
+			if ( index == 0 ) {
+				offset = zstd->rep[0];
+			} else {
+				offset = ( ( index < 3 ) ? zstd->rep[index] :
+					   ( zstd->rep[0] - 1 ) );
+				if ( index > 1 )
+					zstd->rep[2] = zstd->rep[1];
+				zstd->rep[1] = zstd->rep[0];
+				zstd->rep[0] = offset;
+			}
+		}
+
+		/* Sanity checks */
+		if ( ( literal_len > count ) ||
+		     ( ( literal_len + match_len ) > remaining ) ) {
+			DBGC ( zstd, "ZSTD %p overlength sequence\n", zstd );
+			return -EINVAL;
+		}
+		if ( ( offset == 0 ) ||
+		     ( offset > ( out->offset + literal_len ) ) ) {
+			DBGC ( zstd, "ZSTD %p offset %d out of range\n",
+			       zstd, offset );
+			return -EINVAL;
+		}
+
+		/* Copy literals */
+		memcpy ( ( base + out->offset ), literals, literal_len );
+		literals += literal_len;
+		count -= literal_len;
+		out->offset += literal_len;
+
+		/* Copy match */
+		zstd_copy ( ( base + out->offset ), offset, match_len );
+		out->offset += match_len;
+		remaining -= ( literal_len + match_len );
+	}
+
+	/* Check that the bitstream has been consumed exactly */
+	if ( bs.pos != 0 ) {
+		DBGC ( zstd, "ZSTD %p invalid sequences bitstream\n", zstd );
+		return -EINVAL;
+	}
+
+	/* Copy remaining literals */
+	if ( count > remaining )
+		return -EINVAL;
+	memcpy ( ( base + out->offset ), literals, count );
+	out->offset += count;
+
+	return 0;
+}
+
+/**
+ * Decompress block
+ *
+ * @v zstd		Decompressor
+ * @v data		Block contents
+ * @v len		Length of block contents
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ */
+static int zstd_block ( struct zstd *zstd, const uint8_t *data, size_t len,
+			struct deflate_chunk *out ) {
+	const uint8_t *literals;
+	size_t count;
+	size_t used;
+	int rc;
+
+	/* Decode literals */
+	if ( ( rc = zstd_literals ( zstd, data, len, &literals, &count,
+				    &used ) ) != 0 )
+		return rc;
+
+	/* Decode and execute sequences */
+	if ( ( rc = zstd_sequences ( zstd, ( data + used ), ( len - used ),
+				     literals, count, out ) ) != 0 )
+		return rc;
+
+	return 0;
+}
+
+/**
+ * Get length of frame header window descriptor field
+ *
+ * @v descriptor	Frame header descriptor
+ * @ret len		Length of field
+ */
+static inline unsigned int zstd_window_len ( unsigned int descriptor ) {
+
+	/* Window descriptor is omitted for single segment frames */
+	return ( ( descriptor & ( 1 << ZSTD_FHD_SINGLE_BIT ) ) ? 0 : 1 );
+}
+
+/**
+ * Get length of frame header content size field
+ *
+ * @v descriptor	Frame header descriptor
+ * @ret len		Length of field
+ */
+static inline unsigned int zstd_size_len ( unsigned int descriptor ) {
+	unsigned int flag = ( descriptor >> ZSTD_FHD_FCS_LSB );
+
+	/* Content size is always present for single segment frames */
+	if ( ( flag == 0 ) && ! zstd_window_len ( descriptor ) )
+		return 1;
+	return zstd_fcs_len[flag];
+}
+
+/**
+ * Parse frame header
+ *
+ * @v zstd		Decompressor
+ * @ret rc		Return status code
+ */
+static int zstd_frame ( struct zstd *zstd ) {
+	const uint8_t *field = &zstd->header[1];
+	unsigned int descriptor = zstd->header[0];
+	unsigned int dict_len = zstd_dict_len[ descriptor & ZSTD_FHD_DICT_MASK ];
+	unsigned int fcs_len = zstd_size_len ( descriptor );
+	unsigned int log;
+	uint64_t window = 0;
+	uint64_t size;
+
+	/* Parse window descriptor, if present */
+	if ( zstd_window_len ( descriptor ) ) {
+		log = ( ZSTD_WINDOW_MIN_LOG + ( *field >> 3 ) );
+		window = ( 1ULL << log );
+		window += ( ( window / 8 ) * ( *field & 0x07 ) );
+		field++;
+	}
+
+	/* Reject dictionaries */
+	if ( zstd_le ( field, dict_len ) != 0 ) {
+		DBGC ( zstd, "ZSTD %p dictionaries not supported\n", zstd );
+		return -ENOTSUP;
+	}
+	field += dict_len;
+
+	/* Parse frame content size, if present */
+	size = zstd_le ( field, fcs_len );
+	if ( fcs_len == 2 )
+		size += 256;
+	if ( ! zstd_window_len ( descriptor ) )
+		window = size;
+
+	/* Check window size */
+	if ( window > ZSTD_WINDOW_MAX ) {
+		DBGC ( zstd, "ZSTD %p window size %#llx not supported\n",
+		       zstd, ( ( unsigned long long ) window ) );
+		return -ENOTSUP;
+	}
+	zstd->window = window;
+	zstd->block_max = ( ( window < ZSTD_BLOCK_MAX ) ?
+			    window : ZSTD_BLOCK_MAX );
+	DBGC2 ( zstd, "ZSTD %p frame window %#zx content size %#llx\n",
+		zstd, zstd->window, ( ( unsigned long long ) size ) );
+
+	/* Reset per-frame state */
+	zstd->rep[0] = 1;
+	zstd->rep[1] = 4;
+	zstd->rep[2] = 8;
+	zstd->huf_bits = 0;
+	zstd->ll.accuracy = -1;
+	zstd->of.accuracy = -1;
+	zstd->ml.accuracy = -1;
+
+	return 0;
+}
+
+/**
+ * Gather fixed-length data from input
+ *
+ * @v zstd		Decompressor
+ * @v in		Compressed input data
+ * @v buf		Buffer
+ * @v len		Length of data to gather
+ * @ret complete	All data has been gathered
+ */
+static int zstd_gather ( struct zstd *zstd, struct deflate_chunk *in,
+			 void *buf, size_t len ) {
+	size_t frag_len = ( len - zstd->have );
+	size_t remaining = ( in->len - in->offset );
+
+	if ( frag_len > remaining )
+		frag_len = remaining;
+	memcpy ( ( buf + zstd->have ), user_to_virt ( in->data, in->offset ),
+		 frag_len );
+	in->offset += frag_len;
+	zstd->have += frag_len;
+
+	return ( zstd->have == len );
+}
+
+/**
+ * Initialise decompressor
+ *
+ * @v zstd		Decompressor
+ */
+void zstd_init ( struct zstd *zstd ) {
+
+	memset ( zstd, 0, sizeof ( *zstd ) );
+	zstd->state = ZSTD_STATE_MAGIC;
+}
+
+/**
+ * Decompress data
+ *
+ * @v zstd		Decompressor
+ * @v in		Compressed input data
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ *
+ * The output data buffer must contain the history window of
+ * preceding decompressed data.  Decompression stops when the input
+ * is exhausted, when the compressed frame ends, or when there is
+ * insufficient free output space to hold the next block.
+ */
+int zstd_decompress ( struct zstd *zstd, struct deflate_chunk *in,
+		      struct deflate_chunk *out ) {
+	const uint8_t *data;
+	uint32_t header;
+	uint32_t magic;
+	size_t remaining;
+	size_t space;
+	size_t len;
+	int rc;
+
+	while ( 1 ) {
+
+		remaining = ( in->len - in->offset );
+		space = ( out->len - out->offset );
+		data = user_to_virt ( in->data, in->offset );
+
+		switch ( zstd->state ) {
+
+		case ZSTD_STATE_MAGIC:
+			if ( ! zstd_gather ( zstd, in, zstd->header,
+					     sizeof ( magic ) ) )
+				return 0;
+			zstd->have = 0;
+			magic = zstd_le ( zstd->header, sizeof ( magic ) );
+			if ( magic == ZSTD_MAGIC ) {
+				zstd->state = ZSTD_STATE_DESCRIPTOR;
+			} else if ( ( magic & ZSTD_SKIPPABLE_MASK ) ==
+				    ZSTD_SKIPPABLE_MAGIC ) {
+				zstd->state = ZSTD_STATE_SKIP_LEN;
+			} else {
+				DBGC ( zstd, "ZSTD %p invalid magic %#08x\n",
+				       zstd, magic );
+				return -EINVAL;
+			}
+			break;
+
+		case ZSTD_STATE_SKIP_LEN:
+			if ( ! zstd_gather ( zstd, in, zstd->header,
+					     sizeof ( uint32_t ) ) )
+				return 0;
+			zstd->have = 0;
+			zstd->remaining = zstd_le ( zstd->header,
+						    sizeof ( uint32_t ) );
+			zstd->state = ZSTD_STATE_SKIP;
+			break;
+
+		case ZSTD_STATE_SKIP:
+			len = ( ( remaining < zstd->remaining ) ?
+				remaining : zstd->remaining );
+			in->offset += len;
+			zstd->remaining -= len;
+			if ( zstd->remaining )
+				return 0;
+			zstd->state = ZSTD_STATE_MAGIC;
+			break;
+
+		case ZSTD_STATE_DESCRIPTOR:
+			if ( ! zstd_gather ( zstd, in, zstd->header, 1 ) )
+				return 0;
+			header = zstd->header[0];
+			if ( header & ( 1 << ZSTD_FHD_RESERVED_BIT ) ) {
+				DBGC ( zstd, "ZSTD %p reserved descriptor "
+				       "%#02x\n", zstd, header );
+				return -EINVAL;
+			}
+			zstd->header_len = ( 1 + zstd_window_len ( header ) +
+					     zstd_dict_len[ header &
+							    ZSTD_FHD_DICT_MASK ] +
+					     zstd_size_len ( header ) );
+			assert ( zstd->header_len <= sizeof ( zstd->header ) );
+			zstd->state = ZSTD_STATE_HEADER;
+			break;
+
+		case ZSTD_STATE_HEADER:
+			if ( ! zstd_gather ( zstd, in, zstd->header,
+					     zstd->header_len ) )
+				return 0;
+			zstd->have = 0;
+			if ( ( rc = zstd_frame ( zstd ) ) != 0 )
+				return rc;
+			zstd->state = ZSTD_STATE_BLOCK_HEADER;
+			break;
+
+		case ZSTD_STATE_BLOCK_HEADER:
+			if ( ! zstd_gather ( zstd, in, zstd->block_header,
+					     sizeof ( zstd->block_header ) ) )
+				return 0;
+			zstd->have = 0;
+			header = zstd_le ( zstd->block_header,
+					   sizeof ( zstd->block_header ) );
+			zstd->last = ( header & ( 1 << ZSTD_BLOCK_LAST_BIT ) );
+			zstd->block_type = ( ( header >> ZSTD_BLOCK_TYPE_LSB ) &
+					     ZSTD_BLOCK_TYPE_MASK );
+			zstd->block_len = ( header >> ZSTD_BLOCK_SIZE_LSB );
+			if ( ( zstd->block_type > ZSTD_BLOCK_COMPRESSED ) ||
+			     ( zstd->block_len > zstd->block_max ) ) {
+				DBGC ( zstd, "ZSTD %p invalid block header "
+				       "%#06x\n", zstd, header );
+				return -EINVAL;
+			}
+			zstd->state = ZSTD_STATE_BLOCK;
+			break;
+
+		case ZSTD_STATE_BLOCK:
+			switch ( zstd->block_type ) {
+
+			case ZSTD_BLOCK_RAW:
+				len = ( zstd->block_len - zstd->have );
+				if ( len > remaining )
+					len = remaining;
+				if ( len > space )
+					len = space;
+				memcpy ( user_to_virt ( out->data,
+							out->offset ),
+					 data, len );
+				in->offset += len;
+				out->offset += len;
+				zstd->have += len;
+				if ( zstd->have < zstd->block_len )
+					return 0;
+				break;
+
+			case ZSTD_BLOCK_RLE:
+				if ( ( ! remaining ) ||
+				     ( space < zstd->block_len ) )
+					return 0;
+				memset ( user_to_virt ( out->data,
+							out->offset ),
+					 *data, zstd->block_len );
+				in->offset++;
+				out->offset += zstd->block_len;
+				break;
+
+			default: /* ZSTD_BLOCK_COMPRESSED */
+				if ( space < zstd->block_max )
+					return 0;
+				if ( ( zstd->have == 0 ) &&
+				     ( remaining >= zstd->block_len ) ) {
+					/* Decompress directly from input */
+					in->offset += zstd->block_len;
+				} else {
+					/* Gather complete block */
+					if ( ! zstd_gather ( zstd, in,
+							     zstd->block,
+							     zstd->block_len ) )
+						return 0;
+					data = zstd->block;
+				}
+				if ( ( rc = zstd_block ( zstd, data,
+							 zstd->block_len,
+							 out ) ) != 0 ) {
+					DBGC ( zstd, "ZSTD %p could not "
+					       "decompress block: %s\n",
+					       zstd, strerror ( rc ) );
+					return rc;
+				}
+				break;
+			}
+			zstd->have = 0;
+			if ( ! zstd->last ) {
+				zstd->state = ZSTD_STATE_BLOCK_HEADER;
+			} else if ( zstd->header[0] &
+				    ( 1 << ZSTD_FHD_CHECKSUM_BIT ) ) {
+				zstd->state = ZSTD_STATE_CHECKSUM;
+			} else {
+				zstd->state = ZSTD_STATE_DONE;
+			}
+			break;
+
+		case ZSTD_STATE_CHECKSUM:
+			/* Content checksum is not verified */
+			if ( ! zstd_gather ( zstd, in, zstd->header,
+					     ZSTD_CHECKSUM_LEN ) )
+				return 0;
+			zstd->have = 0;
+			zstd->state = ZSTD_STATE_DONE;
+			break;
+
+		default: /* ZSTD_STATE_DONE */
+			return 0;
+		}
+	}
+}
+
+/**
+ * Initialise decompressor
+ *
+ * @v ctx		Decompressor
+ */
+static void zstd_step_init ( void *ctx ) {
+
+	zstd_init ( ctx );
+}
+
+/**
+ * Decompress data
+ *
+ * @v ctx		Decompressor
+ * @v in		Compressed input data
+ * @v out		Output data buffer
+ * @ret rc		Return status code
+ */
+static int zstd_step ( void *ctx, struct deflate_chunk *in,
+		       struct deflate_chunk *out ) {
+
+	return zstd_decompress ( ctx, in, out );
+}
+
+/**
+ * Check if decompression has finished
+ *
+ * @v ctx		Decompressor
+ * @ret finished	Decompression has finished
+ */
+static int zstd_step_finished ( void *ctx ) {
+
+	return zstd_finished ( ctx );
+}
+
+/**
+ * Get history window length
+ *
+ * @v ctx		Decompressor
+ * @ret window		Length of preceding output to be retained
+ */
+static size_t zstd_window ( void *ctx ) {
+	struct zstd *zstd = ctx;
+
+	return zstd->window;
+}
+
+/** Zstandard decompression algorithm */
+struct inflate_algorithm zstd_algorithm = {
+	.name = "zstd",
+	.ctxsize = sizeof ( struct zstd ),
+	.step = ZSTD_BLOCK_MAX,
+	.init = zstd_step_init,
+	.decompress = zstd_step,
+	.finished = zstd_step_finished,
+	.window = zstd_window,
+};
@@ -0,0 +1,428 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * X25519 key exchange
+ *
+ * X25519 is the Diffie-Hellman function over Curve25519, as defined
+ * in RFC 7748.  This implementation uses a Montgomery ladder with a
+ * constant sequence of field operations and constant-time
+ * conditional swaps, so that the running time is independent of the
+ * (secret) scalar.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/x25519.h>
+
+/** Constant (A-2)/4 used in the Montgomery ladder */
+#define X25519_A24 121665
+
+/** X25519 generator (base point u=9) */
+const struct x25519_value x25519_generator = {
+	.raw = { 9 },
+};
+
+/**
+ * Get number of bits held in a limb
+ *
+ * @v index		Limb index
+ * @ret bits		Number of bits
+ */
+static inline __attribute__ (( always_inline )) unsigned int
+x25519_limb_bits ( unsigned int index ) {
+
+	return ( ( index & 1 ) ? 25 : 26 );
+}
+
+/**
+ * Propagate carries between limbs
+ *
+ * @v f			Field element
+ *
+ * Each limb is reduced to within its nominal width, with any carry
+ * out of the most significant limb being folded back into the least
+ * significant limb (since 2^255 = 19 modulo p).  The least
+ * significant limb is then carried once more, which may leave the
+ * second limb marginally outside its nominal width.
+ */
+static void x25519_carry ( struct x25519_field *f ) {
+	int64_t carry;
+	unsigned int bits;
+	unsigned int i;
+
+	for ( i = 0 ; i < X25519_LIMBS ; i++ ) {
+		bits = x25519_limb_bits ( i );
+		carry = ( f->limb[i] >> bits );
+		f->limb[i] &= ( ( 1ULL << bits ) - 1 );
+		if ( i == ( X25519_LIMBS - 1 ) ) {
+			f->limb[0] += ( 19 * carry );
+		} else {
+			f->limb[ i + 1 ] += carry;
+		}
+	}
+	carry = ( f->limb[0] >> 26 );
+	f->limb[0] &= ( ( 1ULL << 26 ) - 1 );
+	f->limb[1] += carry;
+}
+
+/**
+ * Add field elements
+ *
+ * @v augend		Element to add to
+ * @v addend		Element to add
+ * @v sum		Sum
+ *
+ * The result is not carried, and so may be used only as an input to
+ * a multiplication.
+ */
+static void x25519_add ( const struct x25519_field *augend,
+			 const struct x25519_field *addend,
+			 struct x25519_field *sum ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < X25519_LIMBS ; i++ )
+		sum->limb[i] = ( augend->limb[i] + addend->limb[i] );
+}
+
+/**
+ * Subtract field elements
+ *
+ * @v minuend		Element to subtract from
+ * @v subtrahend	Element to subtract
+ * @v difference	Difference
+ *
+ * The result is not carried, and so may be used only as an input to
+ * a multiplication.
+ */
+static void x25519_subtract ( const struct x25519_field *minuend,
+			      const struct x25519_field *subtrahend,
+			      struct x25519_field *difference ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < X25519_LIMBS ; i++ ) {
+		difference->limb[i] =
+			( minuend->limb[i] - subtrahend->limb[i] );
+	}
+}
+
+/**
+ * Multiply field elements
+ *
+ * @v multiplicand	Element to multiply
+ * @v multiplier	Element to multiply by
+ * @v result		Product (may overlap either input)
+ *
+ * Inputs may be either carried elements or the (uncarried) sum or
+ * difference of two carried elements.
+ */
+static void x25519_multiply ( const struct x25519_field *multiplicand,
+			      const struct x25519_field *multiplier,
+			      struct x25519_field *result ) {
+	int64_t product[X25519_LIMBS];
+	int64_t term;
+	unsigned int i;
+	unsigned int j;
+	unsigned int k;
+
+	/* Accumulate products.  Limb i represents bit 25i+ceil(i/2),
+	 * so the product of two odd limbs must be doubled to land on
+	 * a limb boundary, and any product landing beyond 2^255 is
+	 * folded back by multiplying by 19.
+	 */
+	memset ( product, 0, sizeof ( product ) );
+	for ( i = 0 ; i < X25519_LIMBS ; i++ ) {
+		for ( j = 0 ; j < X25519_LIMBS ; j++ ) {
+			term = ( multiplicand->limb[i] * multiplier->limb[j] );
+			if ( i & j & 1 )
+				term *= 2;
+			k = ( i + j );
+			if ( k >= X25519_LIMBS ) {
+				k -= X25519_LIMBS;
+				term *= 19;
+			}
+			product[k] += term;
+		}
+	}
+
+	/* Store and carry result */
+	memcpy ( result->limb, product, sizeof ( result->limb ) );
+	x25519_carry ( result );
+}
+
+/**
+ * Multiply field element by a small constant
+ *
+ * @v multiplicand	Element to multiply
+ * @v multiplier	Constant to multiply by
+ * @v result		Product
+ */
+static void x25519_multiply_small ( const struct x25519_field *multiplicand,
+				    unsigned int multiplier,
+				    struct x25519_field *result ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < X25519_LIMBS ; i++ )
+		result->limb[i] = ( multiplicand->limb[i] * multiplier );
+	x25519_carry ( result );
+}
+
+/**
+ * Invert field element
+ *
+ * @v invertend		Element to invert
+ * @v result		Inverse
+ *
+ * The inverse is calculated as invertend^(p-2) using Fermat's little
+ * theorem.  The exponent p-2 = 2^255-21 has every bit from 0 to 254
+ * set except for bits 2 and 4.
+ */
+static void x25519_invert ( const struct x25519_field *invertend,
+			    struct x25519_field *result ) {
+	struct x25519_field tmp;
+	int bit;
+
+	memcpy ( &tmp, invertend, sizeof ( tmp ) );
+	for ( bit = 253 ; bit >= 0 ; bit-- ) {
+		x25519_multiply ( &tmp, &tmp, &tmp );
+		if ( ( bit != 2 ) && ( bit != 4 ) )
+			x25519_multiply ( &tmp, invertend, &tmp );
+	}
+	memcpy ( result, &tmp, sizeof ( *result ) );
+}
+
+/**
+ * Conditionally swap field elements (in constant time)
+ *
+ * @v a			First element
+ * @v b			Second element
+ * @v swap		Swap elements (must be 0 or 1)
+ */
+static void x25519_swap ( struct x25519_field *a, struct x25519_field *b,
+			  unsigned int swap ) {
+	int64_t mask = -( ( int64_t ) swap );
+	int64_t diff;
+	unsigned int i;
+
+	for ( i = 0 ; i < X25519_LIMBS ; i++ ) {
+		diff = ( mask & ( a->limb[i] ^ b->limb[i] ) );
+		a->limb[i] ^= diff;
+		b->limb[i] ^= diff;
+	}
+}
+
+/**
+ * Unpack field element from an X25519 value
+ *
+ * @v value		X25519 value
+ * @v f			Field element to fill in
+ *
+ * The most significant bit of the value is ignored, as required by
+ * RFC 7748.  Non-canonical values (i.e. values greater than p) are
+ * accepted and reduced implicitly.
+ */
+static void x25519_unpack ( const struct x25519_value *value,
+			    struct x25519_field *f ) {
+	unsigned int offset = 0;
+	unsigned int bits;
+	unsigned int byte;
+	uint64_t accum;
+	unsigned int i;
+	unsigned int j;
+
+	for ( i = 0 ; i < X25519_LIMBS ; i++ ) {
+		bits = x25519_limb_bits ( i );
+		accum = 0;
+		for ( j = 0 ; j < 5 ; j++ ) {
+			byte = ( ( offset / 8 ) + j );
+			if ( byte < sizeof ( value->raw ) )
+				accum |= ( ( ( uint64_t ) value->raw[byte] )
+					   << ( 8 * j ) );
+		}
+		f->limb[i] = ( ( accum >> ( offset % 8 ) ) &
+			       ( ( 1ULL << bits ) - 1 ) );
+		offset += bits;
+	}
+}
+
+/**
+ * Pack field element into an X25519 value
+ *
+ * @v f			Field element
+ * @v value		X25519 value to fill in
+ *
+ * The value is fully reduced to its canonical representation.
+ */
+static void x25519_pack ( const struct x25519_field *f,
+			  struct x25519_value *value ) {
+	struct x25519_field reduced;
+	struct x25519_field trial;
+	int64_t mask;
+	int64_t carry;
+	uint64_t accum = 0;
+	unsigned int have = 0;
+	unsigned int bits;
+	uint8_t *out = value->raw;
+	unsigned int i;
+
+	/* Three carry passes are sufficient to bring every limb to
+	 * within its nominal width with no wraparound carry, leaving
+	 * a value in the range [0,2^255).
+	 */
+	memcpy ( &reduced, f, sizeof ( reduced ) );
+	x25519_carry ( &reduced );
+	x25519_carry ( &reduced );
+	x25519_carry ( &reduced );
+
+	/* Subtract p if the value is at least p, i.e. if adding 19
+	 * would carry into bit 255.
+	 */
+	memcpy ( &trial, &reduced, sizeof ( trial ) );
+	trial.limb[0] += 19;
+	for ( i = 0 ; i < X25519_LIMBS ; i++ ) {
+		bits = x25519_limb_bits ( i );
+		carry = ( trial.limb[i] >> bits );
+		trial.limb[i] &= ( ( 1ULL << bits ) - 1 );
+		if ( i < ( X25519_LIMBS - 1 ) )
+			trial.limb[ i + 1 ] += carry;
+	}
+	mask = -carry;
+	for ( i = 0 ; i < X25519_LIMBS ; i++ ) {
+		reduced.limb[i] = ( ( trial.limb[i] & mask ) |
+				    ( reduced.limb[i] & ~mask ) );
+	}
+
+	/* Construct little-endian value */
+	for ( i = 0 ; i < X25519_LIMBS ; i++ ) {
+		accum |= ( ( ( uint64_t ) reduced.limb[i] ) << have );
+		have += x25519_limb_bits ( i );
+		while ( have >= 8 ) {
+			*(out++) = accum;
+			accum >>= 8;
+			have -= 8;
+		}
+	}
+	*out = accum;
+}
+
+/**
+ * Calculate X25519 key
+ *
+ * @v base		Base point u-coordinate
+ * @v scalar		Scalar (private key)
+ * @v result		Result to fill in
+ * @ret rc		Return status code
+ *
+ * The scalar is clamped as required by RFC 7748 before use.  To
+ * construct a public key, use @c x25519_generator as the base point.
+ * An error is returned if the result is zero, which indicates that
+ * the base point was of small order (and so must not be used as a
+ * shared secret).
+ */
+int x25519_key ( const struct x25519_value *base,
+		 const struct x25519_value *scalar,
+		 struct x25519_value *result ) {
+	struct x25519_value clamped;
+	struct x25519_field x1;
+	struct x25519_field x2;
+	struct x25519_field z2;
+	struct x25519_field x3;
+	struct x25519_field z3;
+	struct x25519_field a;
+	struct x25519_field aa;
+	struct x25519_field b;
+	struct x25519_field bb;
+	struct x25519_field c;
+	struct x25519_field d;
+	struct x25519_field e;
+	struct x25519_field da;
+	struct x25519_field cb;
+	unsigned int swap = 0;
+	unsigned int bit;
+	uint8_t check = 0;
+	int t;
+	unsigned int i;
+
+	/* Clamp scalar */
+	memcpy ( &clamped, scalar, sizeof ( clamped ) );
+	clamped.raw[0] &= 0xf8;
+	clamped.raw[ X25519_SIZE - 1 ] &= 0x7f;
+	clamped.raw[ X25519_SIZE - 1 ] |= 0x40;
+
+	/* Initialise ladder with (x2:z2) = (1:0), (x3:z3) = (u:1) */
+	x25519_unpack ( base, &x1 );
+	memset ( &x2, 0, sizeof ( x2 ) );
+	x2.limb[0] = 1;
+	memset ( &z2, 0, sizeof ( z2 ) );
+	memcpy ( &x3, &x1, sizeof ( x3 ) );
+	memset ( &z3, 0, sizeof ( z3 ) );
+	z3.limb[0] = 1;
+
+	/* Montgomery ladder */
+	for ( t = 254 ; t >= 0 ; t-- ) {
+		bit = ( ( clamped.raw[ t / 8 ] >> ( t % 8 ) ) & 1 );
+		swap ^= bit;
+		x25519_swap ( &x2, &x3, swap );
+		x25519_swap ( &z2, &z3, swap );
+		swap = bit;
+
+		x25519_add ( &x2, &z2, &a );
+		x25519_multiply ( &a, &a, &aa );
+		x25519_subtract ( &x2, &z2, &b );
+		x25519_multiply ( &b, &b, &bb );
+		x25519_subtract ( &aa, &bb, &e );
+		x25519_add ( &x3, &z3, &c );
+		x25519_subtract ( &x3, &z3, &d );
+		x25519_multiply ( &d, &a, &da );
+		x25519_multiply ( &c, &b, &cb );
+		x25519_add ( &da, &cb, &x3 );
+		x25519_multiply ( &x3, &x3, &x3 );
+		x25519_subtract ( &da, &cb, &z3 );
+		x25519_multiply ( &z3, &z3, &z3 );
+		x25519_multiply ( &z3, &x1, &z3 );
+		x25519_multiply ( &aa, &bb, &x2 );
+		x25519_multiply_small ( &e, X25519_A24, &z2 );
+		x25519_add ( &aa, &z2, &z2 );
+		x25519_multiply ( &e, &z2, &z2 );
+	}
+	x25519_swap ( &x2, &x3, swap );
+	x25519_swap ( &z2, &z3, swap );
+
+	/* Calculate affine result x2/z2 */
+	x25519_invert ( &z2, &z2 );
+	x25519_multiply ( &x2, &z2, &x2 );
+	x25519_pack ( &x2, result );
+
+	/* Reject an all-zero result */
+	for ( i = 0 ; i < sizeof ( result->raw ) ; i++ )
+		check |= result->raw[i];
+	if ( ! check )
+		return -EPERM;
+
+	return 0;
+}
@@ -19,6 +19,7 @@
 #include <errno.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <linux_api.h>
 #include <ipxe/list.h>
 #include <ipxe/linux.h>
@@ -45,14 +46,53 @@
 #define LINUX_SOCK_RAW 3
 #define LINUX_SIOCGIFINDEX 0x8933
 #define LINUX_SIOCGIFHWADDR 0x8927
+#define LINUX_SOL_PACKET 263
 
 #define RX_BUF_SIZE 1536
 
+/** Size of a shared-memory ring block */
+#define RING_BLOCK_SIZE ( 1 << 16 )
+
+/** Number of RX ring blocks */
+#define RING_RX_BLOCKS 16
+
+/** Number of TX ring blocks */
+#define RING_TX_BLOCKS 4
+
+/** Size of a shared-memory ring frame */
+#define RING_FRAME_SIZE 2048
+
+/** Number of frames per ring block */
+#define RING_BLOCK_FRAMES ( RING_BLOCK_SIZE / RING_FRAME_SIZE )
+
+/** Number of TX ring frames */
+#define RING_TX_FRAMES ( RING_TX_BLOCKS * RING_BLOCK_FRAMES )
+
+/** Offset of packet data within a TX ring frame */
+#define RING_TX_DATA TPACKET_ALIGN ( sizeof ( struct tpacket3_hdr ) )
+
+/** RX ring block retirement timeout (in ms)
+ *
+ * A partially filled block is handed over to us once this timeout
+ * expires, which bounds the latency added by the RX ring.
+ */
+#define RING_RX_TIMEOUT 1
+
 /** @file
  *
  * The AF_PACKET driver.
  *
  * Bind to an existing linux network interface.
+ *
+ * By default, one frame is read or written per system call.  The
+ * "ring=1" setting instead maps TPACKET_V3 RX and TX rings into our
+ * address space, so that received frames can be consumed in batches
+ * without a system call per frame, and transmitted frames can be
+ * handed to the kernel in batches with a single system call per
+ * poll.  This increases throughput, at the cost of up to
+ * RING_RX_TIMEOUT of additional latency per received frame while
+ * the kernel waits to fill an RX ring block.  Lockstep protocols
+ * such as TFTP will therefore be slower when using the rings.
  */
 
 struct af_packet_nic {
@@ -62,12 +102,25 @@ struct af_packet_nic {
 	int fd;
 	/** ifindex */
 	int ifindex;
+	/** Shared-memory rings are permitted */
+	int use_ring;
+	/** Shared-memory rings (or NULL if not in use) */
+	void *ring;
+	/** Length of shared-memory rings */
+	size_t ring_len;
+	/** Current RX ring block index */
+	unsigned int rx_block;
+	/** TX ring (or NULL if not in use) */
+	void *tx_ring;
+	/** Current TX ring frame index */
+	unsigned int tx_frame;
+	/** TX ring frames are awaiting transmission */
+	int tx_pending;
 };
 
-/** Open the linux interface */
-static int af_packet_nic_open ( struct net_device * netdev )
+/** Open and bind the packet socket */
+static int af_packet_socket ( struct af_packet_nic *nic )
 {
-	struct af_packet_nic * nic = netdev->priv;
 	struct sockaddr_ll socket_address;
 	struct ifreq if_data;
 	int ret;
@@ -119,13 +172,183 @@ static int af_packet_nic_open ( struct net_device * netdev )
 	return 0;
 }
 
+/**
+ * Map shared-memory rings
+ *
+ * @v nic		AF_PACKET NIC
+ * @ret rc		Return status code
+ *
+ * The TX ring requires TPACKET_V3 TX ring support (Linux 4.11 or
+ * later).  If this is absent, the RX ring is used alone.
+ */
+static int af_packet_ring_open ( struct af_packet_nic *nic )
+{
+	struct tpacket_req3 req;
+	int version = TPACKET_V3;
+	unsigned int blocks;
+	int ret;
+
+	ret = linux_setsockopt(nic->fd, LINUX_SOL_PACKET, PACKET_VERSION,
+			       &version, sizeof(version));
+	if (ret < 0) {
+		DBGC(nic, "af_packet %p setsockopt(PACKET_VERSION) = %d "
+		     "(%s)\n", nic, ret, linux_strerror(linux_errno));
+		return ret;
+	}
+
+	/* Create RX ring */
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = RING_BLOCK_SIZE;
+	req.tp_block_nr = RING_RX_BLOCKS;
+	req.tp_frame_size = RING_FRAME_SIZE;
+	req.tp_frame_nr = (RING_RX_BLOCKS * RING_BLOCK_FRAMES);
+	req.tp_retire_blk_tov = RING_RX_TIMEOUT;
+	ret = linux_setsockopt(nic->fd, LINUX_SOL_PACKET, PACKET_RX_RING,
+			       &req, sizeof(req));
+	if (ret < 0) {
+		DBGC(nic, "af_packet %p setsockopt(PACKET_RX_RING) = %d "
+		     "(%s)\n", nic, ret, linux_strerror(linux_errno));
+		return ret;
+	}
+	blocks = RING_RX_BLOCKS;
+
+	/* Create TX ring, if supported */
+	memset(&req, 0, sizeof(req));
+	req.tp_block_size = RING_BLOCK_SIZE;
+	req.tp_block_nr = RING_TX_BLOCKS;
+	req.tp_frame_size = RING_FRAME_SIZE;
+	req.tp_frame_nr = RING_TX_FRAMES;
+	ret = linux_setsockopt(nic->fd, LINUX_SOL_PACKET, PACKET_TX_RING,
+			       &req, sizeof(req));
+	if (ret == 0) {
+		blocks += RING_TX_BLOCKS;
+	} else {
+		DBGC(nic, "af_packet %p setsockopt(PACKET_TX_RING) = %d "
+		     "(%s)\n", nic, ret, linux_strerror(linux_errno));
+	}
+
+	/* Map rings (RX ring first, followed by TX ring) */
+	nic->ring_len = (blocks * RING_BLOCK_SIZE);
+	nic->ring = linux_mmap(NULL, nic->ring_len, (PROT_READ | PROT_WRITE),
+			       MAP_SHARED, nic->fd, 0);
+	if (nic->ring == MAP_FAILED) {
+		DBGC(nic, "af_packet %p mmap() failed (%s)\n",
+		     nic, linux_strerror(linux_errno));
+		nic->ring = NULL;
+		return -ENOMEM;
+	}
+	if (blocks > RING_RX_BLOCKS)
+		nic->tx_ring = (nic->ring + (RING_RX_BLOCKS * RING_BLOCK_SIZE));
+	nic->rx_block = 0;
+	nic->tx_frame = 0;
+	nic->tx_pending = 0;
+
+	DBGC(nic, "af_packet %p using shared-memory RX%s ring\n",
+	     nic, (nic->tx_ring ? " and TX" : ""));
+	return 0;
+}
+
+/** Open the linux interface */
+static int af_packet_nic_open ( struct net_device * netdev )
+{
+	struct af_packet_nic * nic = netdev->priv;
+	int ret;
+
+	/* Use shared-memory rings if possible */
+	if (nic->use_ring) {
+		ret = af_packet_socket(nic);
+		if (ret != 0)
+			return ret;
+		if (af_packet_ring_open(nic) == 0)
+			return 0;
+
+		/* A socket with a partially configured ring cannot be
+		 * used for ordinary reads, so start afresh.
+		 */
+		DBGC(nic, "af_packet %p falling back to read/write\n", nic);
+		linux_close(nic->fd);
+	}
+
+	return af_packet_socket(nic);
+}
+
+/** Hand any pending TX ring frames to the kernel */
+static void af_packet_ring_flush ( struct af_packet_nic *nic )
+{
+	int rc;
+
+	if (! nic->tx_pending)
+		return;
+	nic->tx_pending = 0;
+
+	rc = linux_sendto(nic->fd, NULL, 0, 0, NULL, 0);
+	if (rc < 0) {
+		DBGC(nic, "af_packet %p TX ring sendto() = %d (%s)\n",
+		     nic, rc, linux_strerror(linux_errno));
+	}
+}
+
 /** Close the packet socket */
 static void af_packet_nic_close ( struct net_device *netdev )
 {
 	struct af_packet_nic * nic = netdev->priv;
+
+	if (nic->ring) {
+		af_packet_ring_flush(nic);
+		linux_munmap(nic->ring, nic->ring_len);
+		nic->ring = NULL;
+		nic->tx_ring = NULL;
+	}
 	linux_close(nic->fd);
 }
 
+/**
+ * Transmit an ethernet packet via the TX ring.
+ *
+ * The packet is copied into the ring and marked as complete
+ * immediately.  The kernel is notified of all pending frames at the
+ * next poll.
+ */
+static int af_packet_ring_transmit ( struct net_device *netdev,
+				     struct io_buffer *iobuf )
+{
+	struct af_packet_nic * nic = netdev->priv;
+	struct tpacket3_hdr *hdr;
+	size_t len = iob_len(iobuf);
+
+	if (len > (RING_FRAME_SIZE - RING_TX_DATA))
+		return -ERANGE;
+
+	/* Wait for the kernel to release the next frame, if necessary */
+	hdr = (nic->tx_ring + (nic->tx_frame * RING_FRAME_SIZE));
+	if (hdr->tp_status & (TP_STATUS_SEND_REQUEST | TP_STATUS_SENDING)) {
+		af_packet_ring_flush(nic);
+		__sync_synchronize();
+		if (hdr->tp_status & (TP_STATUS_SEND_REQUEST |
+				      TP_STATUS_SENDING))
+			return -ENOBUFS;
+	}
+	if (hdr->tp_status & TP_STATUS_WRONG_FORMAT) {
+		DBGC(nic, "af_packet %p TX ring frame %d rejected\n",
+		     nic, nic->tx_frame);
+	}
+
+	/* Fill in frame and hand over to kernel */
+	memcpy(((void *) hdr + RING_TX_DATA), iobuf->data, len);
+	hdr->tp_len = len;
+	hdr->tp_snaplen = len;
+	hdr->tp_next_offset = 0;
+	__sync_synchronize();
+	hdr->tp_status = TP_STATUS_SEND_REQUEST;
+	nic->tx_frame = ((nic->tx_frame + 1) % RING_TX_FRAMES);
+	nic->tx_pending = 1;
+
+	DBGC2(nic, "af_packet %p queued %zd bytes\n", nic, len);
+	netdev_tx_complete(netdev, iobuf);
+
+	return 0;
+}
+
 /**
  * Transmit an ethernet packet.
  *
@@ -139,6 +362,9 @@ static int af_packet_nic_transmit ( struct net_device *netdev,
 	const struct ethhdr * eh;
 	int rc;
 
+	if (nic->tx_ring)
+		return af_packet_ring_transmit(netdev, iobuf);
+
 	memset(&socket_address, 0, sizeof(socket_address));
 	socket_address.sll_family = LINUX_AF_PACKET;
 	socket_address.sll_ifindex = nic->ifindex;
@@ -157,6 +383,52 @@ static int af_packet_nic_transmit ( struct net_device *netdev,
 	return 0;
 }
 
+/** Poll the shared-memory rings */
+static void af_packet_ring_poll ( struct net_device *netdev )
+{
+	struct af_packet_nic * nic = netdev->priv;
+	struct tpacket_block_desc *block;
+	struct tpacket3_hdr *hdr;
+	struct io_buffer *iobuf;
+	unsigned int count;
+	unsigned int i;
+
+	/* Hand over any frames queued for transmission */
+	af_packet_ring_flush(nic);
+
+	/* Consume all blocks released to us by the kernel */
+	while (1) {
+		block = (nic->ring + (nic->rx_block * RING_BLOCK_SIZE));
+		if (! (block->hdr.bh1.block_status & TP_STATUS_USER))
+			break;
+		__sync_synchronize();
+
+		count = block->hdr.bh1.num_pkts;
+		hdr = ((void *) block + block->hdr.bh1.offset_to_first_pkt);
+		for (i = 0; i < count; i++) {
+			DBGC2(nic, "af_packet %p ring read %d bytes\n",
+			      nic, hdr->tp_snaplen);
+			iobuf = alloc_iob(hdr->tp_snaplen);
+			if (! iobuf) {
+				netdev_rx_err(netdev, NULL, -ENOMEM);
+			} else if (hdr->tp_snaplen != hdr->tp_len) {
+				netdev_rx_err(netdev, iobuf, -ERANGE);
+			} else {
+				memcpy(iob_put(iobuf, hdr->tp_snaplen),
+				       ((void *) hdr + hdr->tp_mac),
+				       hdr->tp_snaplen);
+				netdev_rx(netdev, iobuf);
+			}
+			hdr = ((void *) hdr + hdr->tp_next_offset);
+		}
+
+		/* Return block to kernel */
+		__sync_synchronize();
+		block->hdr.bh1.block_status = TP_STATUS_KERNEL;
+		nic->rx_block = ((nic->rx_block + 1) % RING_RX_BLOCKS);
+	}
+}
+
 /** Poll for new packets */
 static void af_packet_nic_poll ( struct net_device *netdev )
 {
@@ -165,6 +437,11 @@ static void af_packet_nic_poll ( struct net_device *netdev )
 	struct io_buffer * iobuf;
 	int r;
 
+	if (nic->ring) {
+		af_packet_ring_poll(netdev);
+		return;
+	}
+
 	pfd.fd = nic->fd;
 	pfd.events = POLLIN;
 	if (linux_poll(&pfd, 1, 0) == -1) {
@@ -257,6 +534,7 @@ static int af_packet_nic_probe ( struct linux_device *device,
 				 struct linux_device_request *request )
 {
 	struct linux_setting *if_setting;
+	struct linux_setting *ring_setting;
 	struct net_device *netdev;
 	struct af_packet_nic *nic;
 	int rc;
@@ -289,6 +567,13 @@ static int af_packet_nic_probe ( struct linux_device *device,
 	af_packet_update_properties(netdev);
 	if_setting->applied = 1;
 
+	/* Look for the optional ring setting */
+	ring_setting = linux_find_setting("ring", &request->settings);
+	if (ring_setting) {
+		nic->use_ring = strtoul(ring_setting->value, NULL, 0);
+		ring_setting->applied = 1;
+	}
+
 	/* Apply rest of the settings */
 	linux_apply_settings(&request->settings, &netdev->settings.settings);
 
@@ -19,6 +19,7 @@
 #include <errno.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <linux_api.h>
 #include <ipxe/list.h>
 #include <ipxe/linux.h>
@@ -29,6 +30,7 @@
 #include <ipxe/ethernet.h>
 #include <ipxe/settings.h>
 #include <ipxe/socket.h>
+#include <ipxe/tcpip.h>
 
 /* This hack prevents pre-2.6.32 headers from redefining struct sockaddr */
 #define _SYS_SOCKET_H
@@ -40,66 +42,160 @@
 #include <linux/if_tun.h>
 
 #define RX_BUF_SIZE 1536
-#define RX_QUOTA 4
+#define RX_QUOTA 16
+
+/** Maximum number of queues */
+#define TAP_MAX_QUEUES 8
+
+/** Receive buffer size when offloads are enabled
+ *
+ * The kernel may deliver GSO frames containing a complete IP datagram.
+ */
+#define RX_GSO_BUF_SIZE ( sizeof ( struct tap_vnet_hdr ) + ETH_HLEN + 65535 )
+
+/** Offloads accepted from the kernel */
+#define TAP_OFFLOADS ( TUN_F_CSUM | TUN_F_TSO4 | TUN_F_TSO6 )
 
 /** @file
  *
  * The TAP driver.
  *
  * The TAP is a Virtual Ethernet network device.
+ *
+ * With the "offload=1" setting, each frame is preceded by a virtio-net
+ * header, allowing the kernel to hand us unchecksummed and GSO frames
+ * (as it would to a vhost backend).  The "queues=<n>" setting opens
+ * the interface as a multi-queue tap with one file descriptor per
+ * queue.
  */
 
+/** A virtio-net header (as used by IFF_VNET_HDR) */
+struct tap_vnet_hdr {
+	/** Flags */
+	uint8_t flags;
+	/** GSO type */
+	uint8_t gso_type;
+	/** Length of headers */
+	uint16_t hdr_len;
+	/** GSO segment size */
+	uint16_t gso_size;
+	/** Offset at which checksumming starts */
+	uint16_t csum_start;
+	/** Offset of checksum field from csum_start */
+	uint16_t csum_offset;
+} __attribute__ (( packed ));
+
+/** Frame requires checksum completion */
+#define TAP_VNET_HDR_F_NEEDS_CSUM 0x01
+
 struct tap_nic {
 	/** Tap interface name */
 	char * interface;
-	/** File descriptor of the opened tap device */
-	int fd;
+	/** Number of queues */
+	unsigned int queues;
+	/** Use virtio-net header offloads */
+	int offload;
+	/** File descriptors of the opened tap queues */
+	int fd[TAP_MAX_QUEUES];
+	/** Bounce buffer (when offloads are enabled) */
+	void *buf;
 };
 
-/** Open the TAP device */
-static int tap_open(struct net_device * netdev)
+/** Open one queue of the TAP device */
+static int tap_open_queue(struct tap_nic *nic, unsigned int queue)
 {
-	struct tap_nic * nic = netdev->priv;
 	struct ifreq ifr;
+	unsigned int offloads = (nic->offload ? TAP_OFFLOADS : 0);
+	int fd;
 	int ret;
 
-	nic->fd = linux_open("/dev/net/tun", O_RDWR);
-	if (nic->fd < 0) {
-		DBGC(nic, "tap %p open('/dev/net/tun') = %d (%s)\n", nic, nic->fd, linux_strerror(linux_errno));
-		return nic->fd;
+	fd = linux_open("/dev/net/tun", O_RDWR);
+	if (fd < 0) {
+		DBGC(nic, "tap %p open('/dev/net/tun') = %d (%s)\n", nic, fd, linux_strerror(linux_errno));
+		return fd;
 	}
 
 	memset(&ifr, 0, sizeof(ifr));
 	/* IFF_NO_PI for no extra packet information */
 	ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+	if (nic->queues > 1)
+		ifr.ifr_flags |= IFF_MULTI_QUEUE;
+	if (nic->offload)
+		ifr.ifr_flags |= IFF_VNET_HDR;
 	strncpy(ifr.ifr_name, nic->interface, IFNAMSIZ);
-	DBGC(nic, "tap %p interface = '%s'\n", nic, nic->interface);
+	DBGC(nic, "tap %p interface = '%s' queue %d\n", nic, nic->interface, queue);
 
-	ret = linux_ioctl(nic->fd, TUNSETIFF, &ifr);
+	ret = linux_ioctl(fd, TUNSETIFF, &ifr);
 
 	if (ret != 0) {
-		DBGC(nic, "tap %p ioctl(%d, ...) = %d (%s)\n", nic, nic->fd, ret, linux_strerror(linux_errno));
-		linux_close(nic->fd);
-		return ret;
+		DBGC(nic, "tap %p ioctl(%d, ...) = %d (%s)\n", nic, fd, ret, linux_strerror(linux_errno));
+		goto err;
+	}
+
+	/* Accept checksum-offloaded and GSO frames if applicable.
+	 * Offloads persist on a persistent tap device, so must be
+	 * explicitly disabled when not in use.
+	 */
+	ret = linux_ioctl(fd, TUNSETOFFLOAD, (void *)(intptr_t)offloads);
+	if ((ret != 0) && offloads) {
+		DBGC(nic, "tap %p ioctl(%d, TUNSETOFFLOAD) = %d (%s)\n", nic, fd, ret, linux_strerror(linux_errno));
+		goto err;
 	}
 
 	/* Set nonblocking mode to make tap_poll easier */
-	ret = linux_fcntl(nic->fd, F_SETFL, O_NONBLOCK);
+	ret = linux_fcntl(fd, F_SETFL, O_NONBLOCK);
 
 	if (ret != 0) {
-		DBGC(nic, "tap %p fcntl(%d, ...) = %d (%s)\n", nic, nic->fd, ret, linux_strerror(linux_errno));
-		linux_close(nic->fd);
-		return ret;
+		DBGC(nic, "tap %p fcntl(%d, ...) = %d (%s)\n", nic, fd, ret, linux_strerror(linux_errno));
+		goto err;
+	}
+
+	nic->fd[queue] = fd;
+	return 0;
+
+err:
+	linux_close(fd);
+	return ret;
+}
+
+/** Open the TAP device */
+static int tap_open(struct net_device * netdev)
+{
+	struct tap_nic * nic = netdev->priv;
+	unsigned int i;
+	int ret;
+
+	if (nic->offload) {
+		nic->buf = malloc(RX_GSO_BUF_SIZE);
+		if (! nic->buf)
+			return -ENOMEM;
+	}
+
+	for (i = 0; i < nic->queues; i++) {
+		if ((ret = tap_open_queue(nic, i)) != 0)
+			goto err;
 	}
 
 	return 0;
+
+err:
+	while (i--)
+		linux_close(nic->fd[i]);
+	free(nic->buf);
+	nic->buf = NULL;
+	return ret;
 }
 
 /** Close the TAP device */
 static void tap_close(struct net_device *netdev)
 {
 	struct tap_nic * nic = netdev->priv;
-	linux_close(nic->fd);
+	unsigned int i;
+
+	for (i = 0; i < nic->queues; i++)
+		linux_close(nic->fd[i]);
+	free(nic->buf);
+	nic->buf = NULL;
 }
 
 /**
@@ -110,59 +206,156 @@ static void tap_close(struct net_device *netdev)
 static int tap_transmit(struct net_device *netdev, struct io_buffer *iobuf)
 {
 	struct tap_nic * nic = netdev->priv;
+	struct tap_vnet_hdr *hdr;
+	size_t len;
 	int rc;
 
 	/* Pad and align packet */
 	iob_pad(iobuf, ETH_ZLEN);
-
-	rc = linux_write(nic->fd, iobuf->data, iobuf->tail - iobuf->data);
+	len = iob_len(iobuf);
+
+	if (! nic->offload) {
+		rc = linux_write(nic->fd[0], iobuf->data, len);
+	} else if (iob_ensure_headroom(iobuf, sizeof(*hdr)) == 0) {
+		/* Prepend an empty header (nothing is offloaded) */
+		hdr = iob_push(iobuf, sizeof(*hdr));
+		memset(hdr, 0, sizeof(*hdr));
+		rc = linux_write(nic->fd[0], iobuf->data, iob_len(iobuf));
+	} else {
+		/* No headroom: go via the bounce buffer */
+		hdr = nic->buf;
+		memset(hdr, 0, sizeof(*hdr));
+		memcpy((hdr + 1), iobuf->data, len);
+		rc = linux_write(nic->fd[0], hdr, (sizeof(*hdr) + len));
+	}
 	DBGC2(nic, "tap %p wrote %d bytes\n", nic, rc);
 	netdev_tx_complete(netdev, iobuf);
 
 	return 0;
 }
 
-/** Poll for new packets */
-static void tap_poll(struct net_device *netdev)
+/**
+ * Receive a frame with a virtio-net header
+ *
+ * @v netdev		Network device
+ * @v fd		File descriptor
+ * @ret rc		Return status code (or -EAGAIN if no frame is ready)
+ *
+ * Frames may be GSO frames containing a complete IP datagram, and
+ * may require checksum completion.  iPXE has no receive checksum
+ * offload, so the checksum is completed here.
+ */
+static int tap_rx_offload(struct net_device *netdev, int fd)
 {
 	struct tap_nic * nic = netdev->priv;
-	struct pollfd pfd;
+	struct tap_vnet_hdr *hdr = nic->buf;
 	struct io_buffer * iobuf;
-	unsigned int quota = RX_QUOTA;
+	uint16_t *csum;
+	size_t start;
+	size_t len;
 	int r;
 
-	pfd.fd = nic->fd;
-	pfd.events = POLLIN;
-	if (linux_poll(&pfd, 1, 0) == -1) {
-		DBGC(nic, "tap %p poll failed (%s)\n", nic, linux_strerror(linux_errno));
-		return;
+	r = linux_read(fd, nic->buf, RX_GSO_BUF_SIZE);
+	if (r <= 0)
+		return -EAGAIN;
+	DBGC2(nic, "tap %p read %d bytes\n", nic, r);
+	if ((size_t)r < sizeof(*hdr)) {
+		netdev_rx_err(netdev, NULL, -EINVAL);
+		return 0;
 	}
-	if ((pfd.revents & POLLIN) == 0)
-		return;
+	len = (r - sizeof(*hdr));
 
-	/* At this point we know there is at least one new packet to be read */
+	iobuf = alloc_iob(len);
+	if (! iobuf) {
+		netdev_rx_err(netdev, NULL, -ENOMEM);
+		return -ENOMEM;
+	}
+	memcpy(iob_put(iobuf, len), (hdr + 1), len);
+
+	if (hdr->flags & TAP_VNET_HDR_F_NEEDS_CSUM) {
+		start = hdr->csum_start;
+		if ((start + hdr->csum_offset + sizeof(*csum)) > len) {
+			DBGC(nic, "tap %p bad checksum offset %d+%d\n", nic, hdr->csum_start, hdr->csum_offset);
+			netdev_rx_err(netdev, iobuf, -EINVAL);
+			return 0;
+		}
+		/* The checksum field holds the pseudo-header checksum */
+		csum = (iobuf->data + start + hdr->csum_offset);
+		*csum = tcpip_chksum((iobuf->data + start), (len - start));
+	}
 
-	iobuf = alloc_iob(RX_BUF_SIZE);
-	if (! iobuf)
-		goto allocfail;
+	netdev_rx(netdev, iobuf);
+	return 0;
+}
 
-	while (quota-- &&
-	       ((r = linux_read(nic->fd, iobuf->data, RX_BUF_SIZE)) > 0)) {
-		DBGC2(nic, "tap %p read %d bytes\n", nic, r);
+/**
+ * Receive a plain frame
+ *
+ * @v netdev		Network device
+ * @v fd		File descriptor
+ * @ret rc		Return status code (or -EAGAIN if no frame is ready)
+ */
+static int tap_rx(struct net_device *netdev, int fd)
+{
+	struct tap_nic * nic = netdev->priv;
+	struct io_buffer * iobuf;
+	int r;
 
-		iob_put(iobuf, r);
-		netdev_rx(netdev, iobuf);
+	iobuf = alloc_iob(RX_BUF_SIZE);
+	if (! iobuf) {
+		netdev_rx_err(netdev, NULL, -ENOMEM);
+		return -ENOMEM;
+	}
 
-		iobuf = alloc_iob(RX_BUF_SIZE);
-		if (! iobuf)
-			goto allocfail;
+	r = linux_read(fd, iobuf->data, RX_BUF_SIZE);
+	if (r <= 0) {
+		free_iob(iobuf);
+		return -EAGAIN;
 	}
+	DBGC2(nic, "tap %p read %d bytes\n", nic, r);
 
-	free_iob(iobuf);
-	return;
+	iob_put(iobuf, r);
+	netdev_rx(netdev, iobuf);
+	return 0;
+}
+
+/** Poll for new packets
+ *
+ * All queues are checked with a single poll(), and each readable
+ * queue is then drained (up to the quota) without further polling.
+ */
+static void tap_poll(struct net_device *netdev)
+{
+	struct tap_nic * nic = netdev->priv;
+	struct pollfd pfd[TAP_MAX_QUEUES];
+	unsigned int quota;
+	unsigned int i;
+	int rc;
+
+	for (i = 0; i < nic->queues; i++) {
+		pfd[i].fd = nic->fd[i];
+		pfd[i].events = POLLIN;
+		pfd[i].revents = 0;
+	}
+	if (linux_poll(pfd, nic->queues, 0) == -1) {
+		DBGC(nic, "tap %p poll failed (%s)\n", nic, linux_strerror(linux_errno));
+		return;
+	}
 
-allocfail:
-	DBGC(nic, "tap %p alloc_iob failed\n", nic);
+	for (i = 0; i < nic->queues; i++) {
+		if ((pfd[i].revents & POLLIN) == 0)
+			continue;
+
+		/* At this point we know there is at least one new packet to be read */
+		quota = RX_QUOTA;
+		do {
+			if (nic->offload) {
+				rc = tap_rx_offload(netdev, nic->fd[i]);
+			} else {
+				rc = tap_rx(netdev, nic->fd[i]);
+			}
+		} while ((rc == 0) && --quota);
+	}
 }
 
 /**
@@ -190,6 +383,8 @@ static struct net_device_operations tap_operations = {
 static int tap_probe(struct linux_device *device, struct linux_device_request *request)
 {
 	struct linux_setting *if_setting;
+	struct linux_setting *queues_setting;
+	struct linux_setting *offload_setting;
 	struct net_device *netdev;
 	struct tap_nic *nic;
 	int rc;
@@ -220,6 +415,26 @@ static int tap_probe(struct linux_device *device, struct linux_device_request *r
 	device->dev.desc.bus_type = BUS_TYPE_TAP;
 	if_setting->applied = 1;
 
+	/* Look for the optional queues setting */
+	nic->queues = 1;
+	queues_setting = linux_find_setting("queues", &request->settings);
+	if (queues_setting) {
+		nic->queues = strtoul(queues_setting->value, NULL, 0);
+		if ((nic->queues < 1) || (nic->queues > TAP_MAX_QUEUES)) {
+			printf("tap queues must be between 1 and %d\n", TAP_MAX_QUEUES);
+			rc = -EINVAL;
+			goto err_settings;
+		}
+		queues_setting->applied = 1;
+	}
+
+	/* Look for the optional offload setting */
+	offload_setting = linux_find_setting("offload", &request->settings);
+	if (offload_setting) {
+		nic->offload = strtoul(offload_setting->value, NULL, 0);
+		offload_setting->applied = 1;
+	}
+
 	/* Apply rest of the settings */
 	linux_apply_settings(&request->settings, &netdev->settings.settings);
 
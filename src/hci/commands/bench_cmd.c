@@ -0,0 +1,92 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdio.h>
+#include <string.h>
+#include <getopt.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/bench.h>
+
+/** @file
+ *
+ * Benchmark commands
+ *
+ */
+
+/** "bench" options */
+struct bench_options {};
+
+/** "bench" option list */
+static struct option_descriptor bench_opts[] = {};
+
+/** "bench" command descriptor */
+static struct command_descriptor bench_cmd =
+	COMMAND_DESC ( struct bench_options, bench_opts, 0, MAX_ARGUMENTS,
+		       "[<name>...]" );
+
+/**
+ * The "bench" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int bench_exec ( int argc, char **argv ) {
+	struct bench_options opts;
+	int i;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &bench_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Run all benchmarks if no names are specified */
+	if ( optind == argc )
+		return bench_run_all();
+
+	/* Run named benchmarks */
+	for ( i = optind ; i < argc ; i++ ) {
+		if ( ( rc = bench_run ( argv[i] ) ) != 0 ) {
+			printf ( "Could not run \"%s\": %s\n",
+				 argv[i], strerror ( rc ) );
+			return rc;
+		}
+	}
+
+	return 0;
+}
+
+/** Benchmark commands */
+struct command bench_commands[] __command = {
+	{
+		.name = "bench",
+		.exec = bench_exec,
+	},
+};
+
+/* Drag in all applicable benchmarks */
+REQUIRING_SYMBOL ( bench_commands );
+REQUIRE_OBJECT ( benchmarks );
@@ -45,6 +45,10 @@ struct lotest_options {
 	unsigned int mtu;
 	/** Broadcast */
 	int broadcast;
+	/** Maximum number of packets in flight */
+	unsigned int window;
+	/** Number of packets to send */
+	unsigned int count;
 };
 
 /** "lotest" option list */
@@ -53,6 +57,10 @@ static struct option_descriptor lotest_opts[] = {
 		      struct lotest_options, mtu, parse_integer ),
 	OPTION_DESC ( "broadcast", 'b', no_argument,
 		      struct lotest_options, broadcast, parse_flag ),
+	OPTION_DESC ( "window", 'w', required_argument,
+		      struct lotest_options, window, parse_integer ),
+	OPTION_DESC ( "count", 'c', required_argument,
+		      struct lotest_options, count, parse_integer ),
 };
 
 /** "lotest" command descriptor */
@@ -91,7 +99,8 @@ static int lotest_exec ( int argc, char **argv ) {
 
 	/* Perform loopback test */
 	if ( ( rc = loopback_test ( sender, receiver, opts.mtu,
-				    opts.broadcast ) ) != 0 ) {
+				    opts.broadcast, opts.window,
+				    opts.count ) ) != 0 ) {
 		printf ( "Test failed: %s\n", strerror ( rc ) );
 		return rc;
 	}
@@ -0,0 +1,93 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <getopt.h>
+#include <ipxe/command.h>
+#include <ipxe/parseopt.h>
+#include <ipxe/metrics.h>
+
+/** @file
+ *
+ * Metrics commands
+ *
+ */
+
+/** "metrics" options */
+struct metrics_options {
+	/** Send metrics to system log */
+	int syslog;
+};
+
+/** "metrics" option list */
+static struct option_descriptor metrics_opts[] = {
+	OPTION_DESC ( "syslog", 's', no_argument,
+		      struct metrics_options, syslog, parse_flag ),
+};
+
+/** "metrics" command descriptor */
+static struct command_descriptor metrics_cmd =
+	COMMAND_DESC ( struct metrics_options, metrics_opts, 0, 0,
+		       "[--syslog]" );
+
+/**
+ * The "metrics" command
+ *
+ * @v argc		Argument count
+ * @v argv		Argument list
+ * @ret rc		Return status code
+ */
+static int metrics_exec ( int argc, char **argv ) {
+	struct metrics_options opts;
+	char *metrics;
+	int rc;
+
+	/* Parse options */
+	if ( ( rc = parse_options ( argc, argv, &metrics_cmd, &opts ) ) != 0 )
+		return rc;
+
+	/* Send to system log, if applicable */
+	if ( opts.syslog )
+		return metrics_log();
+
+	/* Show metrics */
+	metrics = metrics_alloc();
+	if ( ! metrics )
+		return -ENOMEM;
+	printf ( "%s", metrics );
+	free ( metrics );
+
+	return 0;
+}
+
+/** Metrics commands */
+struct command metrics_commands[] __command = {
+	{
+		.name = "metrics",
+		.exec = metrics_exec,
+	},
+};
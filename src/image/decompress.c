@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Compressed images
+ *
+ * A compressed image is executed by decompressing it to a new image
+ * (named without the compression suffix), which then replaces the
+ * compressed image.
+ *
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/umalloc.h>
+#include <ipxe/deflate.h>
+#include <ipxe/image.h>
+#include <ipxe/decompress.h>
+
+/**
+ * Decompress image
+ *
+ * @v image		Compressed image
+ * @v algorithm		Decompression algorithm
+ * @v len		Expected decompressed length (or zero if unknown)
+ * @v suffix		Filename suffix to be removed
+ * @ret extracted	Decompressed image
+ * @ret rc		Return status code
+ *
+ * The expected decompressed length is merely a hint.  The output
+ * buffer is enlarged as needed, and shrunk to fit once decompression
+ * is complete.
+ */
+int decompress_extract ( struct image *image,
+			 struct inflate_algorithm *algorithm,
+			 size_t len, const char *suffix,
+			 struct image **extracted ) {
+	struct deflate_chunk in;
+	struct deflate_chunk out;
+	userptr_t ctx;
+	userptr_t data;
+	char *sep;
+	int rc;
+
+	/* Allocate and initialise decompressor */
+	ctx = umalloc ( algorithm->ctxsize );
+	if ( ! ctx ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	algorithm->init ( user_to_virt ( ctx, 0 ) );
+
+	/* Decompress image */
+	deflate_chunk_init ( &in, image->data, 0, image->len );
+	deflate_chunk_init ( &out, UNULL, 0, 0 );
+	len += algorithm->step;
+	while ( 1 ) {
+
+		/* Enlarge output buffer if necessary */
+		if ( ( out.len - out.offset ) < algorithm->step ) {
+			if ( len < ( out.offset + algorithm->step ) )
+				len = ( 2 * ( out.offset + algorithm->step ) );
+			data = urealloc ( out.data, len );
+			if ( ! data ) {
+				rc = -ENOMEM;
+				goto err_data;
+			}
+			out.data = data;
+			out.len = len;
+		}
+
+		/* Decompress into output buffer */
+		if ( ( rc = algorithm->decompress ( user_to_virt ( ctx, 0 ),
+						    &in, &out ) ) != 0 ) {
+			DBGC ( image, "IMAGE %s could not decompress (%s): "
+			       "%s\n", image->name, algorithm->name,
+			       strerror ( rc ) );
+			goto err_decompress;
+		}
+		if ( algorithm->finished ( user_to_virt ( ctx, 0 ) ) )
+			break;
+		if ( ( in.offset == in.len ) &&
+		     ( ( out.len - out.offset ) >= algorithm->step ) ) {
+			DBGC ( image, "IMAGE %s is truncated (%s)\n",
+			       image->name, algorithm->name );
+			rc = -EINVAL;
+			goto err_decompress;
+		}
+	}
+	DBGC ( image, "IMAGE %s decompressed (%s) %#zx to %#zx bytes\n",
+	       image->name, algorithm->name, image->len, out.offset );
+
+	/* Shrink output buffer to fit */
+	if ( out.offset ) {
+		data = urealloc ( out.data, out.offset );
+		if ( data )
+			out.data = data;
+	}
+
+	/* Allocate decompressed image */
+	*extracted = alloc_image ( image->uri );
+	if ( ! *extracted ) {
+		rc = -ENOMEM;
+		goto err_image;
+	}
+	if ( ( rc = image_set_name ( *extracted, image->name ) ) != 0 )
+		goto err_set_name;
+	sep = strrchr ( (*extracted)->name, '.' );
+	if ( sep && ( strcasecmp ( sep, suffix ) == 0 ) )
+		*sep = '\0';
+	if ( image->cmdline &&
+	     ( ( rc = image_set_cmdline ( *extracted, image->cmdline ) ) != 0 ))
+		goto err_set_cmdline;
+	(*extracted)->data = out.data;
+	(*extracted)->len = out.offset;
+	out.data = UNULL;
+
+	/* Decompressed image is trusted only if the original was */
+	if ( image->flags & IMAGE_TRUSTED )
+		image_trust ( *extracted );
+
+	ufree ( ctx );
+	return 0;
+
+ err_set_cmdline:
+ err_set_name:
+	image_put ( *extracted );
+ err_image:
+ err_decompress:
+ err_data:
+	ufree ( out.data );
+	ufree ( ctx );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Execute compressed image
+ *
+ * @v image		Compressed image
+ * @v algorithm		Decompression algorithm
+ * @v len		Expected decompressed length (or zero if unknown)
+ * @v suffix		Filename suffix to be removed
+ * @ret rc		Return status code
+ */
+int decompress_exec ( struct image *image,
+		      struct inflate_algorithm *algorithm,
+		      size_t len, const char *suffix ) {
+	struct image *extracted;
+	int rc;
+
+	/* Decompress image */
+	if ( ( rc = decompress_extract ( image, algorithm, len, suffix,
+					 &extracted ) ) != 0 )
+		goto err_extract;
+
+	/* Register decompressed image */
+	extracted->flags |= IMAGE_AUTO_UNREGISTER;
+	if ( ( rc = register_image ( extracted ) ) != 0 )
+		goto err_register;
+
+	/* Replace self with decompressed image */
+	if ( ( rc = image_replace ( extracted ) ) != 0 ) {
+		DBGC ( image, "IMAGE %s could not replace self with %s: %s\n",
+		       image->name, extracted->name, strerror ( rc ) );
+		goto err_replace;
+	}
+
+	/* Drop our reference to the decompressed image */
+	image_put ( extracted );
+
+	return 0;
+
+ err_replace:
+	unregister_image ( extracted );
+ err_register:
+	image_put ( extracted );
+ err_extract:
+	return rc;
+}
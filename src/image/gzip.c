@@ -0,0 +1,106 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * GZIP compressed images
+ *
+ * A gzip-compressed image is executed by decompressing it to a new
+ * image (named without the ".gz" suffix), which then replaces the
+ * compressed image.
+ *
+ */
+
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/deflate.h>
+#include <ipxe/image.h>
+#include <ipxe/decompress.h>
+
+/** A GZIP signature */
+struct gzip_signature {
+	/** Magic */
+	uint16_t magic;
+	/** Compression method */
+	uint8_t cm;
+} __attribute__ (( packed ));
+
+/** Minimum length of a GZIP image (header and footer) */
+#define GZIP_MIN_LEN 18
+
+/** GZIP filename suffix */
+#define GZIP_SUFFIX ".gz"
+
+/**
+ * Execute GZIP image
+ *
+ * @v image		GZIP image
+ * @ret rc		Return status code
+ *
+ * The decompressed length is taken from the ISIZE footer field.  This
+ * is merely a hint, since it is stored modulo 2^32.
+ */
+static int gzip_exec ( struct image *image ) {
+	uint32_t isize;
+
+	copy_from_user ( &isize, image->data, ( image->len - sizeof ( isize ) ),
+			 sizeof ( isize ) );
+	return decompress_exec ( image, &deflate_gzip_algorithm,
+				 le32_to_cpu ( isize ), GZIP_SUFFIX );
+}
+
+/**
+ * Probe GZIP image
+ *
+ * @v image		GZIP image
+ * @ret rc		Return status code
+ */
+static int gzip_probe ( struct image *image ) {
+	struct gzip_signature signature;
+
+	/* Sanity check */
+	if ( image->len < GZIP_MIN_LEN ) {
+		DBGC ( image, "GZIP %s is too short\n", image->name );
+		return -ENOEXEC;
+	}
+
+	/* Check signature */
+	copy_from_user ( &signature, image->data, 0, sizeof ( signature ) );
+	if ( ! ( ( signature.magic == cpu_to_le16 ( GZIP_MAGIC ) ) &&
+		 ( signature.cm == GZIP_HEADER_CM_DEFLATE ) ) ) {
+		DBGC ( image, "GZIP %s has invalid signature\n", image->name );
+		return -ENOEXEC;
+	}
+
+	return 0;
+}
+
+/** GZIP image type */
+struct image_type gzip_image_type __image_type ( PROBE_NORMAL ) = {
+	.name = "GZIP",
+	.probe = gzip_probe,
+	.exec = gzip_exec,
+};
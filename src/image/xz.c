@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * XZ compressed images
+ *
+ * An XZ-compressed image is executed by decompressing it to a new
+ * image (named without the ".xz" suffix), which then replaces the
+ * compressed image.
+ *
+ */
+
+#include <string.h>
+#include <errno.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/xz.h>
+#include <ipxe/image.h>
+#include <ipxe/decompress.h>
+
+/** Minimum length of an XZ image (stream header and footer) */
+#define XZ_MIN_LEN ( 2 * XZ_STREAM_HEADER_LEN )
+
+/** XZ filename suffix */
+#define XZ_SUFFIX ".xz"
+
+/** Assumed compression ratio used to size the decompressed image */
+#define XZ_RATIO_HINT 4
+
+/**
+ * Execute XZ image
+ *
+ * @v image		XZ image
+ * @ret rc		Return status code
+ */
+static int xz_exec ( struct image *image ) {
+
+	return decompress_exec ( image, &xz_algorithm,
+				 ( XZ_RATIO_HINT * image->len ), XZ_SUFFIX );
+}
+
+/**
+ * Probe XZ image
+ *
+ * @v image		XZ image
+ * @ret rc		Return status code
+ */
+static int xz_probe ( struct image *image ) {
+	static const uint8_t expected[] = XZ_MAGIC;
+	uint8_t header[XZ_STREAM_HEADER_LEN];
+
+	/* Sanity check */
+	if ( image->len < XZ_MIN_LEN ) {
+		DBGC ( image, "XZ %s is too short\n", image->name );
+		return -ENOEXEC;
+	}
+
+	/* Check magic */
+	copy_from_user ( header, image->data, 0, sizeof ( header ) );
+	if ( memcmp ( header, expected, sizeof ( expected ) ) != 0 ) {
+		DBGC ( image, "XZ %s has invalid signature\n", image->name );
+		return -ENOEXEC;
+	}
+
+	return 0;
+}
+
+/** XZ image type */
+struct image_type xz_image_type __image_type ( PROBE_NORMAL ) = {
+	.name = "XZ",
+	.probe = xz_probe,
+	.exec = xz_exec,
+};
@@ -0,0 +1,95 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Zstandard compressed images
+ *
+ * A Zstandard-compressed image is executed by decompressing it to a
+ * new image (named without the ".zst" suffix), which then replaces
+ * the compressed image.
+ *
+ */
+
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/zstd.h>
+#include <ipxe/image.h>
+#include <ipxe/decompress.h>
+
+/** Minimum length of a Zstandard image (magic and frame header) */
+#define ZSTD_MIN_LEN 6
+
+/** Zstandard filename suffix */
+#define ZSTD_SUFFIX ".zst"
+
+/** Assumed compression ratio used to size the decompressed image */
+#define ZSTD_RATIO_HINT 4
+
+/**
+ * Execute Zstandard image
+ *
+ * @v image		Zstandard image
+ * @ret rc		Return status code
+ */
+static int zstd_exec ( struct image *image ) {
+
+	return decompress_exec ( image, &zstd_algorithm,
+				 ( ZSTD_RATIO_HINT * image->len ),
+				 ZSTD_SUFFIX );
+}
+
+/**
+ * Probe Zstandard image
+ *
+ * @v image		Zstandard image
+ * @ret rc		Return status code
+ */
+static int zstd_probe ( struct image *image ) {
+	uint32_t magic;
+
+	/* Sanity check */
+	if ( image->len < ZSTD_MIN_LEN ) {
+		DBGC ( image, "ZSTD %s is too short\n", image->name );
+		return -ENOEXEC;
+	}
+
+	/* Check magic (skippable frames are not recognised) */
+	copy_from_user ( &magic, image->data, 0, sizeof ( magic ) );
+	if ( magic != cpu_to_le32 ( ZSTD_MAGIC ) ) {
+		DBGC ( image, "ZSTD %s has invalid signature\n", image->name );
+		return -ENOEXEC;
+	}
+
+	return 0;
+}
+
+/** Zstandard image type */
+struct image_type zstd_image_type __image_type ( PROBE_NORMAL ) = {
+	.name = "ZSTD",
+	.probe = zstd_probe,
+	.exec = zstd_exec,
+};
@@ -0,0 +1,58 @@
+#ifndef _IPXE_BENCH_H
+#define _IPXE_BENCH_H
+
+/** @file
+ *
+ * Benchmark infrastructure
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stddef.h>
+#include <ipxe/tables.h>
+
+/** A benchmark */
+struct benchmark {
+	/** Name */
+	const char *name;
+	/** Length of data processed by each iteration, or zero
+	 *
+	 * This is reported alongside the results, to allow a cost
+	 * per byte to be calculated.
+	 */
+	size_t len;
+	/** Number of iterations, or zero to use the default */
+	unsigned int count;
+	/**
+	 * Prepare benchmark (optional)
+	 *
+	 * @ret rc		Return status code
+	 */
+	int ( * setup ) ( void );
+	/**
+	 * Run a single iteration
+	 *
+	 * @ret rc		Return status code
+	 */
+	int ( * exec ) ( void );
+	/**
+	 * Clean up after benchmark (optional)
+	 *
+	 */
+	void ( * teardown ) ( void );
+};
+
+/** Benchmark table */
+#define BENCHMARKS __table ( struct benchmark, "benchmarks" )
+
+/** Declare a benchmark */
+#define __benchmark __table_entry ( BENCHMARKS, 01 )
+
+/** Default number of iterations for each benchmark */
+#define BENCH_COUNT 64
+
+extern int bench_run ( const char *name );
+extern int bench_run_all ( void );
+
+#endif /* _IPXE_BENCH_H */
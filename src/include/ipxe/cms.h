@@ -14,7 +14,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/crypto.h>
 #include <ipxe/x509.h>
 #include <ipxe/refcnt.h>
-#include <ipxe/uaccess.h>
+
+struct image;
 
 /** CMS signer information */
 struct cms_signer_info {
@@ -69,7 +70,7 @@ cms_put ( struct cms_signature *sig ) {
 
 extern int cms_signature ( const void *data, size_t len,
 			   struct cms_signature **sig );
-extern int cms_verify ( struct cms_signature *sig, userptr_t data, size_t len,
+extern int cms_verify ( struct cms_signature *sig, struct image *image,
 			const char *name, time_t time, struct x509_chain *store,
 			struct x509_root *root );
 
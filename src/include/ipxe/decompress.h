@@ -0,0 +1,25 @@
+#ifndef _IPXE_DECOMPRESS_H
+#define _IPXE_DECOMPRESS_H
+
+/** @file
+ *
+ * Compressed images
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stddef.h>
+#include <ipxe/inflate.h>
+
+struct image;
+
+extern int decompress_extract ( struct image *image,
+				struct inflate_algorithm *algorithm,
+				size_t len, const char *suffix,
+				struct image **extracted );
+extern int decompress_exec ( struct image *image,
+			     struct inflate_algorithm *algorithm,
+			     size_t len, const char *suffix );
+
+#endif /* _IPXE_DECOMPRESS_H */
@@ -12,6 +12,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdint.h>
 #include <string.h>
 #include <ipxe/uaccess.h>
+#include <ipxe/inflate.h>
 
 /** Compression formats */
 enum deflate_format {
@@ -19,6 +20,8 @@ enum deflate_format {
 	DEFLATE_RAW,
 	/** ZLIB header and footer */
 	DEFLATE_ZLIB,
+	/** GZIP header and footer */
+	DEFLATE_GZIP,
 };
 
 /** Block header length (in bits) */
@@ -81,6 +84,20 @@ enum deflate_format {
 /** Quick lookup shift */
 #define DEFLATE_HUFFMAN_QL_SHIFT ( 16 - DEFLATE_HUFFMAN_QL_BITS )
 
+/** Direct lookup length for a Huffman symbol (in bits)
+ *
+ * This is a policy decision.  Symbols up to this length are decoded
+ * with a single table lookup; longer symbols fall back to searching
+ * the per-length symbol sets.
+ */
+#define DEFLATE_TABLE_BITS 10
+
+/** Direct lookup table entry symbol length mask */
+#define DEFLATE_TABLE_LEN_MASK 0x0f
+
+/** Direct lookup table entry raw symbol LSB */
+#define DEFLATE_TABLE_RAW_LSB 4
+
 /** Literal/length end of block code */
 #define DEFLATE_LITLEN_END 256
 
@@ -93,6 +110,30 @@ enum deflate_format {
 /** Maximum value of a code length code */
 #define DEFLATE_CODELEN_MAX_CODE 18
 
+/** History window length */
+#define DEFLATE_WINDOW 32768
+
+/** Maximum length of a duplicated string */
+#define DEFLATE_MAX_MATCH 258
+
+/** Maximum decompressed length per compressed byte
+ *
+ * A maximum-length duplicated string may be encoded using as few as
+ * two bits.
+ */
+#define DEFLATE_MAX_RATIO ( 4 * DEFLATE_MAX_MATCH )
+
+/** Maximum number of compressed bytes held within the accumulator */
+#define DEFLATE_ACCUMULATED 8
+
+/** Minimum compressed length per streaming decompression step */
+#define DEFLATE_MIN_STEP 16
+
+/** Free output space required for a streaming decompression step */
+#define DEFLATE_STEP_SPACE						\
+	( DEFLATE_MAX_MATCH +						\
+	  ( ( DEFLATE_ACCUMULATED + DEFLATE_MIN_STEP ) * DEFLATE_MAX_RATIO ) )
+
 /** ZLIB header length (in bits) */
 #define ZLIB_HEADER_BITS 16
 
@@ -111,6 +152,51 @@ enum deflate_format {
 /** ZLIB ADLER32 length (in bits) */
 #define ZLIB_ADLER32_BITS 32
 
+/** GZIP magic length (in bits) */
+#define GZIP_MAGIC_BITS 16
+
+/** GZIP magic value */
+#define GZIP_MAGIC 0x8b1f
+
+/** GZIP compression method and flags length (in bits) */
+#define GZIP_HEADER_BITS 16
+
+/** GZIP compression method LSB */
+#define GZIP_HEADER_CM_LSB 0
+
+/** GZIP compression method mask */
+#define GZIP_HEADER_CM_MASK 0xff
+
+/** GZIP compression method for DEFLATE */
+#define GZIP_HEADER_CM_DEFLATE 8
+
+/** GZIP header CRC16 flag bit */
+#define GZIP_HEADER_FHCRC_BIT 9
+
+/** GZIP extra field flag bit */
+#define GZIP_HEADER_FEXTRA_BIT 10
+
+/** GZIP original file name flag bit */
+#define GZIP_HEADER_FNAME_BIT 11
+
+/** GZIP file comment flag bit */
+#define GZIP_HEADER_FCOMMENT_BIT 12
+
+/** GZIP reserved flag bits */
+#define GZIP_HEADER_RESERVED_MASK 0xe000
+
+/** GZIP modification time, extra flags and OS length (in bytes) */
+#define GZIP_HEADER_SKIP_LEN 6
+
+/** GZIP extra field length length (in bits) */
+#define GZIP_XLEN_BITS 16
+
+/** GZIP header CRC16 length (in bytes) */
+#define GZIP_HCRC_LEN 2
+
+/** GZIP footer (CRC32 and ISIZE) length (in bytes) */
+#define GZIP_FOOTER_LEN 8
+
 /** A Huffman-coded set of symbols of a given length */
 struct deflate_huf_symbols {
 	/** Length of Huffman-coded symbols */
@@ -134,6 +220,14 @@ struct deflate_huf_symbols {
 struct deflate_alphabet {
 	/** Huffman-coded symbol set for each length */
 	struct deflate_huf_symbols huf[DEFLATE_HUFFMAN_BITS];
+	/** Direct lookup table
+	 *
+	 * Indexed by the next DEFLATE_TABLE_BITS bits of input (in
+	 * stream order).  Each entry holds the raw symbol and the
+	 * symbol length, or zero if the symbol is longer than
+	 * DEFLATE_TABLE_BITS.
+	 */
+	uint16_t table[ 1 << DEFLATE_TABLE_BITS ];
 	/** Quick lookup table */
 	uint8_t lookup[ 1 << DEFLATE_HUFFMAN_QL_BITS ];
 	/** Raw symbols
@@ -163,13 +257,13 @@ struct deflate {
 	/** Format */
 	enum deflate_format format;
 
-	/** Accumulator */
-	uint32_t accumulator;
-	/** Bit-reversed accumulator
+	/** Accumulator
 	 *
-	 * Don't ask.
+	 * Bits above the valid bits may contain a copy of the
+	 * following input data, which will be overwritten with the
+	 * same values when that data is accumulated.
 	 */
-	uint32_t rotalumucca;
+	uint64_t accumulator;
 	/** Number of bits within the accumulator */
 	unsigned int bits;
 
@@ -274,6 +368,9 @@ static inline int deflate_finished ( struct deflate *deflate ) {
 	return ( deflate->resume == NULL );
 }
 
+extern struct inflate_algorithm deflate_zlib_algorithm;
+extern struct inflate_algorithm deflate_gzip_algorithm;
+
 extern void deflate_init ( struct deflate *deflate,
 			   enum deflate_format format );
 extern int deflate_inflate ( struct deflate *deflate,
@@ -264,6 +264,14 @@ struct dhcp_client_id {
 /** User class identifier */
 #define DHCP_USER_CLASS_ID 77
 
+/** Rapid Commit
+ *
+ * A zero-length option which, when included in a DHCPDISCOVER,
+ * invites the server to respond immediately with a DHCPACK (as
+ * defined in RFC 4039).
+ */
+#define DHCP_RAPID_COMMIT 80
+
 /** Client system architecture */
 #define DHCP_CLIENT_ARCHITECTURE 93
 
@@ -433,6 +441,15 @@ struct dhcp_netdev_desc {
 /** Use cached network settings (obsolete; do not reuse this value) */
 #define DHCP_EB_USE_CACHED DHCP_ENCAP_OPT ( DHCP_EB_ENCAP, 0xb2 )
 
+/** Skip waiting for ProxyDHCP when a boot filename is present
+ *
+ * If set to a non-zero value, iPXE will not continue to wait for
+ * ProxyDHCP offers once it has a DHCPOFFER (or Rapid Commit DHCPACK)
+ * that already specifies a boot filename.  Any ProxyDHCP offer that
+ * has already arrived will still be used.
+ */
+#define DHCP_EB_SKIP_PROXY_WAIT DHCP_ENCAP_OPT ( DHCP_EB_ENCAP, 0xb3 )
+
 /** SAN retry count
  *
  * This is the maximum number of times that SAN operations will be
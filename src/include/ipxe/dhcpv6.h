@@ -142,6 +142,9 @@ struct dhcpv6_user_class_option {
 	struct dhcpv6_user_class user_class[0];
 } __attribute__ (( packed ));
 
+/** DHCPv6 rapid commit option */
+#define DHCPV6_RAPID_COMMIT 14
+
 /** DHCPv6 user class option */
 #define DHCPV6_USER_CLASS 15
 
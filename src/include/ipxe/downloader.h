@@ -11,7 +11,13 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 struct interface;
 struct image;
+struct xfer_buffer;
 
+extern void initrd_xferbuf_init ( struct xfer_buffer *xferbuf,
+				  struct image *image );
 extern int create_downloader ( struct interface *job, struct image *image );
+extern struct image * downloader_image ( struct interface *intf );
+#define downloader_image_TYPE( object_type ) \
+	typeof ( struct image * ( object_type ) )
 
 #endif /* _IPXE_DOWNLOADER_H */
@@ -75,6 +75,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define ERRFILE_sanboot		       ( ERRFILE_CORE | 0x00230000 )
 #define ERRFILE_dummy_sanboot	       ( ERRFILE_CORE | 0x00240000 )
 #define ERRFILE_fdt		       ( ERRFILE_CORE | 0x00250000 )
+#define ERRFILE_imgdigest	       ( ERRFILE_CORE | 0x00260000 )
+#define ERRFILE_fec		       ( ERRFILE_CORE | 0x00270000 )
+#define ERRFILE_timeline	       ( ERRFILE_CORE | 0x00280000 )
+#define ERRFILE_metrics		       ( ERRFILE_CORE | 0x00290000 )
+#define ERRFILE_inflate		       ( ERRFILE_CORE | 0x002a0000 )
+#define ERRFILE_bench		       ( ERRFILE_CORE | 0x002b0000 )
 
 #define ERRFILE_eisa		     ( ERRFILE_DRIVER | 0x00000000 )
 #define ERRFILE_isa		     ( ERRFILE_DRIVER | 0x00010000 )
@@ -284,6 +290,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define ERRFILE_xsigo			( ERRFILE_NET | 0x00480000 )
 #define ERRFILE_ntp			( ERRFILE_NET | 0x00490000 )
 #define ERRFILE_httpntlm		( ERRFILE_NET | 0x004a0000 )
+#define ERRFILE_peerserve		( ERRFILE_NET | 0x004b0000 )
 
 #define ERRFILE_image		      ( ERRFILE_IMAGE | 0x00000000 )
 #define ERRFILE_elf		      ( ERRFILE_IMAGE | 0x00010000 )
@@ -295,6 +302,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define ERRFILE_png		      ( ERRFILE_IMAGE | 0x00070000 )
 #define ERRFILE_der		      ( ERRFILE_IMAGE | 0x00080000 )
 #define ERRFILE_pem		      ( ERRFILE_IMAGE | 0x00090000 )
+#define ERRFILE_gzip		      ( ERRFILE_IMAGE | 0x000a0000 )
+#define ERRFILE_decompress	      ( ERRFILE_IMAGE | 0x000b0000 )
+#define ERRFILE_zstd		      ( ERRFILE_IMAGE | 0x000c0000 )
+#define ERRFILE_xz		      ( ERRFILE_IMAGE | 0x000d0000 )
 
 #define ERRFILE_asn1		      ( ERRFILE_OTHER | 0x00000000 )
 #define ERRFILE_chap		      ( ERRFILE_OTHER | 0x00010000 )
@@ -379,6 +390,18 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #define ERRFILE_acpi_settings	      ( ERRFILE_OTHER | 0x00500000 )
 #define ERRFILE_ntlm		      ( ERRFILE_OTHER | 0x00510000 )
 #define ERRFILE_efi_blacklist	      ( ERRFILE_OTHER | 0x00520000 )
+#define ERRFILE_autoboot_concurrent   ( ERRFILE_OTHER | 0x00530000 )
+#define ERRFILE_unzstd		      ( ERRFILE_OTHER | 0x00540000 )
+#define ERRFILE_unxz		      ( ERRFILE_OTHER | 0x00550000 )
+#define ERRFILE_metrics_cmd	      ( ERRFILE_OTHER | 0x00560000 )
+#define ERRFILE_bench_cmd	      ( ERRFILE_OTHER | 0x00570000 )
+#define ERRFILE_benchrun	      ( ERRFILE_OTHER | 0x00580000 )
+#define ERRFILE_deflate_bench	      ( ERRFILE_OTHER | 0x00590000 )
+#define ERRFILE_cipher_bench	      ( ERRFILE_OTHER | 0x005a0000 )
+#define ERRFILE_bigint_bench	      ( ERRFILE_OTHER | 0x005b0000 )
+#define ERRFILE_tls_bench	      ( ERRFILE_OTHER | 0x005c0000 )
+#define ERRFILE_tcp_bench	      ( ERRFILE_OTHER | 0x005d0000 )
+#define ERRFILE_x25519		      ( ERRFILE_OTHER | 0x005e0000 )
 
 /** @} */
 
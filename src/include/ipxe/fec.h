@@ -0,0 +1,39 @@
+#ifndef _IPXE_FEC_H
+#define _IPXE_FEC_H
+
+/** @file
+ *
+ * Forward error correction
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stddef.h>
+
+/** Maximum number of symbols (data plus repair) within a group */
+#define FEC_MAX_SYMBOLS 256
+
+/**
+ * Get maximum number of repair symbols for a group
+ *
+ * @v k			Number of data symbols within group
+ * @ret rows		Maximum number of repair symbols
+ */
+static inline __attribute__ (( always_inline )) unsigned int
+fec_max_rows ( unsigned int k ) {
+	return ( FEC_MAX_SYMBOLS - k );
+}
+
+extern uint8_t fec_coefficient ( unsigned int k, unsigned int row,
+				 unsigned int index );
+extern void fec_mul_add ( uint8_t coefficient, const void *src, void *dst,
+			  size_t len );
+extern void fec_encode ( unsigned int k, unsigned int row,
+			 const void * const *data, void *repair, size_t len );
+extern int fec_recover ( unsigned int k, unsigned int count,
+			 const unsigned int *rows, const unsigned int *missing,
+			 void **blocks, size_t len );
+
+#endif /* _IPXE_FEC_H */
@@ -0,0 +1,136 @@
+#ifndef _IPXE_GCM_H
+#define _IPXE_GCM_H
+
+/** @file
+ *
+ * Galois/Counter Mode (GCM)
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/crypto.h>
+
+/** GCM block size */
+#define GCM_BLOCK_SIZE 16
+
+/** GCM initialisation vector length
+ *
+ * Only the 96-bit initialisation vector recommended by NIST SP
+ * 800-38D (and used by TLS) is supported.
+ */
+#define GCM_IV_LEN 12
+
+/** GCM authentication tag length */
+#define GCM_AUTH_LEN 16
+
+/** A GCM block */
+union gcm_block {
+	/** Raw bytes */
+	uint8_t byte[GCM_BLOCK_SIZE];
+	/** Big-endian 32-bit words */
+	uint32_t dword[ GCM_BLOCK_SIZE / sizeof ( uint32_t ) ];
+	/** Big-endian 64-bit words */
+	uint64_t qword[ GCM_BLOCK_SIZE / sizeof ( uint64_t ) ];
+};
+
+/** A GCM multiplication table entry
+ *
+ * This is a multiple of the hash key, held as a host-endian 128-bit
+ * value.
+ */
+struct gcm_table_entry {
+	/** High 64 bits */
+	uint64_t hi;
+	/** Low 64 bits */
+	uint64_t lo;
+};
+
+/** GCM context */
+struct gcm_context {
+	/** Accumulated hash value */
+	union gcm_block hash;
+	/** Counter block */
+	union gcm_block ctr;
+	/** Pre-counter block */
+	union gcm_block j0;
+	/** Length of additional data (in bytes) */
+	uint64_t add_len;
+	/** Length of encrypted data (in bytes) */
+	uint64_t data_len;
+	/** Multiples of the hash key for each 4-bit value */
+	struct gcm_table_entry table[16];
+};
+
+extern int gcm_setkey ( struct gcm_context *context, const void *key,
+			size_t keylen, struct cipher_algorithm *raw_cipher,
+			void *raw_ctx );
+extern void gcm_setiv ( struct gcm_context *context, const void *iv );
+extern void gcm_encrypt ( struct gcm_context *context, const void *src,
+			  void *dst, size_t len,
+			  struct cipher_algorithm *raw_cipher, void *raw_ctx );
+extern void gcm_decrypt ( struct gcm_context *context, const void *src,
+			  void *dst, size_t len,
+			  struct cipher_algorithm *raw_cipher, void *raw_ctx );
+extern void gcm_auth ( struct gcm_context *context, void *auth,
+		       struct cipher_algorithm *raw_cipher, void *raw_ctx );
+
+/**
+ * Create a GCM mode of behaviour of an existing cipher
+ *
+ * @v _gcm_name		Name for the new GCM cipher
+ * @v _gcm_cipher	New cipher algorithm
+ * @v _raw_cipher	Underlying cipher algorithm
+ * @v _raw_context	Context structure for the underlying cipher
+ *
+ * The underlying cipher must have a 128-bit block size.  Data may be
+ * passed to the encrypt and decrypt methods in several calls, but
+ * every call except the last (for each of the additional data and
+ * the encrypted data) must be a multiple of @c GCM_BLOCK_SIZE.
+ */
+#define GCM_CIPHER( _gcm_name, _gcm_cipher, _raw_cipher, _raw_context )	\
+struct _gcm_name ## _context {						\
+	_raw_context raw_ctx;						\
+	struct gcm_context gcm_ctx;					\
+};									\
+static int _gcm_name ## _setkey ( void *ctx, const void *key,		\
+				  size_t keylen ) {			\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	return gcm_setkey ( &_gcm_name ## _ctx->gcm_ctx, key, keylen,	\
+			    &_raw_cipher, &_gcm_name ## _ctx->raw_ctx );\
+}									\
+static void _gcm_name ## _setiv ( void *ctx, const void *iv ) {		\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	gcm_setiv ( &_gcm_name ## _ctx->gcm_ctx, iv );			\
+}									\
+static void _gcm_name ## _encrypt ( void *ctx, const void *src,		\
+				    void *dst, size_t len ) {		\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	gcm_encrypt ( &_gcm_name ## _ctx->gcm_ctx, src, dst, len,	\
+		      &_raw_cipher, &_gcm_name ## _ctx->raw_ctx );	\
+}									\
+static void _gcm_name ## _decrypt ( void *ctx, const void *src,		\
+				    void *dst, size_t len ) {		\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	gcm_decrypt ( &_gcm_name ## _ctx->gcm_ctx, src, dst, len,	\
+		      &_raw_cipher, &_gcm_name ## _ctx->raw_ctx );	\
+}									\
+static void _gcm_name ## _auth ( void *ctx, void *auth ) {		\
+	struct _gcm_name ## _context * _gcm_name ## _ctx = ctx;		\
+	gcm_auth ( &_gcm_name ## _ctx->gcm_ctx, auth,			\
+		   &_raw_cipher, &_gcm_name ## _ctx->raw_ctx );		\
+}									\
+struct cipher_algorithm _gcm_cipher = {					\
+	.name		= #_gcm_name,					\
+	.ctxsize	= sizeof ( struct _gcm_name ## _context ),	\
+	.blocksize	= 1,						\
+	.authsize	= GCM_AUTH_LEN,					\
+	.setkey		= _gcm_name ## _setkey,				\
+	.setiv		= _gcm_name ## _setiv,				\
+	.encrypt	= _gcm_name ## _encrypt,			\
+	.decrypt	= _gcm_name ## _decrypt,			\
+	.auth		= _gcm_name ## _auth,				\
+};
+
+#endif /* _IPXE_GCM_H */
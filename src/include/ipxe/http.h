@@ -21,6 +21,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/ntlm.h>
 
 struct http_transaction;
+struct xfer_metadata;
 
 /******************************************************************************
  *
@@ -405,6 +406,20 @@ struct http_state {
 	 */
 	int ( * rx ) ( struct http_transaction *http,
 		       struct io_buffer **iobuf );
+	/** Receive data placed directly into data transfer buffer
+	 *
+	 * @v http		HTTP transaction
+	 * @v iobuf		Empty I/O buffer
+	 * @v meta		Data transfer metadata
+	 * @ret rc		Return status code
+	 *
+	 * This method is optional.  It should be provided only by
+	 * states in which received data maps directly onto the
+	 * content.
+	 */
+	int ( * placed ) ( struct http_transaction *http,
+			   struct io_buffer *iobuf,
+			   struct xfer_metadata *meta );
 	/** Server connection closed
 	 *
 	 * @v http		HTTP transaction
@@ -19,6 +19,7 @@ struct uri;
 struct pixel_buffer;
 struct asn1_cursor;
 struct image_type;
+struct image_digest;
 
 /** An executable image */
 struct image {
@@ -45,6 +46,9 @@ struct image {
 	/** Image type, if known */
 	struct image_type *type;
 
+	/** Digests calculated during download, if any */
+	struct image_digest *digests;
+
 	/** Replacement image
 	 *
 	 * An image wishing to replace itself with another image (in a
@@ -72,6 +76,9 @@ struct image {
 /** Image will be automatically unregistered after execution */
 #define IMAGE_AUTO_UNREGISTER 0x0008
 
+/** Image is expected to be used as an initrd */
+#define IMAGE_INITRD 0x0010
+
 /** An executable image type */
 struct image_type {
 	/** Name of this image type */
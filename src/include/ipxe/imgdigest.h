@@ -0,0 +1,43 @@
+#ifndef _IPXE_IMGDIGEST_H
+#define _IPXE_IMGDIGEST_H
+
+/** @file
+ *
+ * Image digests
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/crypto.h>
+
+struct image;
+
+/** An image digest calculated during download */
+struct image_digest {
+	/** Next digest for this image */
+	struct image_digest *next;
+	/** Digest algorithm */
+	struct digest_algorithm *digest;
+	/** Length of data digested so far */
+	size_t len;
+	/** Digest has been finalised */
+	int final;
+	/** Digest context */
+	void *ctx;
+	/** Digest output (valid only once finalised) */
+	void *out;
+};
+
+extern int image_digest_add ( struct image *image,
+			      struct digest_algorithm *algorithm );
+extern int image_digest_start ( struct image *image );
+extern void image_digest_update ( struct image *image, size_t offset,
+				  const void *data, size_t len );
+extern void image_digest_final ( struct image *image );
+extern void image_digest_discard ( struct image *image );
+extern void image_digest ( struct image *image,
+			   struct digest_algorithm *digest, void *out );
+
+#endif /* _IPXE_IMGDIGEST_H */
@@ -0,0 +1,81 @@
+#ifndef _IPXE_INFLATE_H
+#define _IPXE_INFLATE_H
+
+/** @file
+ *
+ * Streaming decompression filter
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stddef.h>
+#include <ipxe/interface.h>
+
+struct deflate_chunk;
+
+/** Initial output buffer length (including history window) */
+#define INFLATE_BUFFER_LEN ( 256 * 1024 )
+
+/** Maximum length of data delivered in a single I/O buffer */
+#define INFLATE_DELIVER_LEN 16384
+
+/** A decompression algorithm */
+struct inflate_algorithm {
+	/** Algorithm name */
+	const char *name;
+	/** Context size */
+	size_t ctxsize;
+	/** Free output space required for a decompression step */
+	size_t step;
+	/**
+	 * Initialise decompressor
+	 *
+	 * @v ctx		Context
+	 */
+	void ( * init ) ( void *ctx );
+	/**
+	 * Decompress data
+	 *
+	 * @v ctx		Context
+	 * @v in		Compressed input data
+	 * @v out		Output data buffer
+	 * @ret rc		Return status code
+	 *
+	 * The output data buffer must contain (at least) the history
+	 * window of preceding decompressed data.  Decompression stops
+	 * when the input is exhausted, when the compressed stream
+	 * ends, or when fewer than @c step bytes of free space remain
+	 * in the output data buffer.  Data is never written beyond
+	 * the end of the output data buffer.
+	 *
+	 * Compressed data may be consumed before the corresponding
+	 * output is produced.  If decompression stops with fewer than
+	 * @c step bytes of free space remaining, it must be resumed
+	 * once space is available even if no further input remains.
+	 */
+	int ( * decompress ) ( void *ctx, struct deflate_chunk *in,
+			       struct deflate_chunk *out );
+	/**
+	 * Check if decompression has finished
+	 *
+	 * @v ctx		Context
+	 * @ret finished	Decompression has finished
+	 *
+	 * This is meaningful only after at least one decompression
+	 * step.
+	 */
+	int ( * finished ) ( void *ctx );
+	/**
+	 * Get history window length
+	 *
+	 * @v ctx		Context
+	 * @ret window		Length of preceding output to be retained
+	 */
+	size_t ( * window ) ( void *ctx );
+};
+
+extern int inflate_filter ( struct interface *xfer, struct interface *raw,
+			    struct inflate_algorithm *algorithm );
+
+#endif /* _IPXE_INFLATE_H */
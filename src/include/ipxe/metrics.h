@@ -0,0 +1,70 @@
+#ifndef _IPXE_METRICS_H
+#define _IPXE_METRICS_H
+
+/** @file
+ *
+ * Metrics
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stddef.h>
+#include <ipxe/tables.h>
+
+/** A metric
+ *
+ * A metric is either a simple counter (with no unit), or an
+ * accumulation of samples (with a unit) for which the number of
+ * samples, the total and the maximum sample value are recorded.
+ */
+struct metric {
+	/** Name */
+	const char *name;
+	/** Unit of sample values, or NULL for a simple counter */
+	const char *unit;
+	/** Number of events or samples */
+	unsigned long count;
+	/** Total of sample values */
+	unsigned long total;
+	/** Maximum sample value */
+	unsigned long max;
+};
+
+/** Metric table */
+#define METRICS __table ( struct metric, "metrics" )
+
+/** Declare a metric */
+#define __metric __table_entry ( METRICS, 01 )
+
+/**
+ * Increment metric counter
+ *
+ * @v metric		Metric
+ */
+static inline __attribute__ (( always_inline )) void
+metric_inc ( struct metric *metric ) {
+
+	metric->count++;
+}
+
+/**
+ * Record metric sample
+ *
+ * @v metric		Metric
+ * @v sample		Sample value
+ */
+static inline __attribute__ (( always_inline )) void
+metric_sample ( struct metric *metric, unsigned long sample ) {
+
+	metric->count++;
+	metric->total += sample;
+	if ( metric->max < sample )
+		metric->max = sample;
+}
+
+extern size_t metrics_format ( char *buf, size_t len );
+extern char * metrics_alloc ( void );
+extern int metrics_log ( void );
+
+#endif /* _IPXE_METRICS_H */
@@ -40,7 +40,24 @@ struct peerdist_discovery_reply {
 	char *locations;
 };
 
+/** A PeerDist discovery probe */
+struct peerdist_discovery_probe {
+	/** Message ID */
+	char *message;
+	/** List of segment ID strings
+	 *
+	 * The list is terminated with a zero-length string.
+	 */
+	char *ids;
+};
+
 extern char * peerdist_discovery_request ( const char *uuid, const char *id );
+extern char * peerdist_discovery_match ( const char *uuid,
+					 const char *relates, const char *ids,
+					 const char *locations,
+					 const char *counts );
+extern int peerdist_discovery_probe ( char *data, size_t len,
+				      struct peerdist_discovery_probe *probe );
 extern int peerdist_discovery_reply ( char *data, size_t len,
 				      struct peerdist_discovery_reply *reply );
 
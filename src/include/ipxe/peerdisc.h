@@ -71,6 +71,14 @@ struct peerdisc_segment {
 struct peerdisc_peer {
 	/** List of peers */
 	struct list_head list;
+	/** Number of bytes successfully downloaded from this peer */
+	size_t bytes;
+	/** Total duration of successful downloads (in ticks) */
+	unsigned long ticks;
+	/** Number of successful downloads */
+	unsigned int successes;
+	/** Number of failed downloads */
+	unsigned int failures;
 	/** Peer location */
 	char location[0];
 };
@@ -115,6 +123,8 @@ extern void peerdisc_stat ( struct interface *intf, struct peerdisc_peer *peer,
 	typeof ( void ( object_type, struct peerdisc_peer *peer,	\
 			struct list_head *peers ) )
 
+extern struct peerdisc_peer *
+peerdisc_fastest ( struct peerdisc_segment *segment );
 extern int peerdisc_open ( struct peerdisc_client *peerdisc, const void *id,
 			   size_t len );
 extern void peerdisc_close ( struct peerdisc_client *peerdisc );
@@ -19,7 +19,19 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/pccrc.h>
 
 /** Maximum number of concurrent block downloads */
-#define PEERMUX_MAX_BLOCKS 32
+#define PEERMUX_MAX_BLOCKS 64
+
+/** Minimum number of concurrent block downloads */
+#define PEERMUX_MIN_BLOCKS 4
+
+/** Initial number of concurrent block downloads */
+#define PEERMUX_INITIAL_BLOCKS 16
+
+/** Maximum block download latency (as a multiple of the lowest
+ * observed latency) before the number of concurrent block downloads
+ * is reduced
+ */
+#define PEERMUX_LATENCY_FACTOR 2
 
 /** PeerDist download content information cache */
 struct peerdist_info_cache {
@@ -39,6 +51,10 @@ struct peerdist_multiplexed_block {
 	struct list_head list;
 	/** Data transfer interface */
 	struct interface xfer;
+	/** Length of block being downloaded */
+	size_t len;
+	/** Time at which download was started */
+	unsigned long started;
 };
 
 /** PeerDist statistics */
@@ -49,6 +65,10 @@ struct peerdist_statistics {
 	unsigned int total;
 	/** Number of blocks downloaded from peers */
 	unsigned int local;
+	/** Number of bytes downloaded in total */
+	unsigned long long total_bytes;
+	/** Number of bytes downloaded from peers */
+	unsigned long long local_bytes;
 };
 
 /** A PeerDist download multiplexer */
@@ -75,11 +95,19 @@ struct peerdist_multiplexer {
 	struct list_head idle;
 	/** Block downloads */
 	struct peerdist_multiplexed_block block[PEERMUX_MAX_BLOCKS];
+	/** Number of busy block downloads */
+	unsigned int active;
+	/** Maximum number of busy block downloads */
+	unsigned int window;
+	/** Lowest observed block download latency (in ticks) */
+	unsigned long latency;
 
 	/** Statistics */
 	struct peerdist_statistics stats;
 };
 
+extern struct peerdist_statistics peermux_stats;
+
 extern int peermux_filter ( struct interface *xfer, struct interface *info,
 			    struct uri *uri );
 
@@ -0,0 +1,21 @@
+#ifndef _IPXE_PEERSERVE_H
+#define _IPXE_PEERSERVE_H
+
+/** @file
+ *
+ * Peer Content Caching and Retrieval (PeerDist) protocol content server
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <ipxe/interface.h>
+#include <ipxe/pccrc.h>
+
+/** PeerDist retrieval protocol HTTP server port */
+#define PEERSERVE_PORT 80
+
+extern void peerserve_add ( struct interface *xfer,
+			    const struct peerdist_info *info );
+
+#endif /* _IPXE_PEERSERVE_H */
@@ -11,6 +11,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 
 #include <stdint.h>
 #include <ipxe/crypto.h>
+#include <bits/sha1.h>
 
 /** An SHA-1 digest */
 struct sha1_digest {
@@ -11,6 +11,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
 #include <ipxe/crypto.h>
+#include <bits/sha256.h>
 
 /** SHA-256 number of rounds */
 #define SHA256_ROUNDS 64
@@ -11,8 +11,12 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+#include <ipxe/list.h>
 #include <ipxe/tcpip.h>
 
+struct interface;
+struct sockaddr;
+
 /**
  * A TCP header
  */
@@ -397,6 +401,16 @@ struct tcp_options {
 	  sizeof ( struct tcp_window_scale_padded_option ) +	\
 	  sizeof ( struct tcp_timestamp_padded_option ) )
 
+/**
+ * TCP receive buffer compaction ratio
+ *
+ * A received segment carrying data that occupies less than this
+ * fraction of its I/O buffer will be copied into an appropriately
+ * sized buffer while its checksum is being verified, to avoid holding
+ * large and mostly empty buffers on the receive queue.
+ */
+#define TCP_RX_COMPACT_RATIO 4
+
 /**
  * Compare TCP sequence numbers
  *
@@ -433,6 +447,28 @@ static inline int tcp_in_window ( uint32_t seq, uint32_t start,
  */
 #define TCP_FINISH_TIMEOUT ( 1 * TICKS_PER_SEC )
 
+/** A TCP listener */
+struct tcp_listener {
+	/** List of TCP listeners */
+	struct list_head list;
+	/** Local port */
+	unsigned int port;
+	/**
+	 * Accept incoming connection
+	 *
+	 * @v xfer		Data transfer interface of new connection
+	 * @v peer		Peer socket address
+	 * @ret rc		Return status code
+	 *
+	 * The new connection will be closed if this method returns
+	 * an error.
+	 */
+	int ( * accept ) ( struct interface *xfer, struct sockaddr *peer );
+};
+
 extern struct tcpip_protocol tcp_protocol __tcpip_protocol;
 
+extern int tcp_listen ( struct tcp_listener *listener );
+extern void tcp_unlisten ( struct tcp_listener *listener );
+
 #endif /* _IPXE_TCP_H */
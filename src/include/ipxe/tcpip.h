@@ -16,6 +16,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 extern uint16_t generic_tcpip_continue_chksum ( uint16_t partial,
 						const void *data, size_t len );
+extern uint16_t generic_tcpip_copy_chksum ( uint16_t partial, void *dest,
+					    const void *src, size_t len );
 
 #include <bits/tcpip.h>
 
@@ -200,6 +202,8 @@ extern struct tcpip_net_protocol * tcpip_net_protocol ( sa_family_t sa_family );
 extern struct net_device * tcpip_netdev ( struct sockaddr_tcpip *st_dest );
 extern size_t tcpip_mtu ( struct sockaddr_tcpip *st_dest );
 extern uint16_t tcpip_chksum ( const void *data, size_t len );
+extern uint16_t tcpip_combine_chksum ( uint16_t partial, uint16_t frag,
+				       size_t offset );
 extern int tcpip_bind ( struct sockaddr_tcpip *st_local,
 			int ( * available ) ( int port ) );
 
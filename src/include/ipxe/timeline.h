@@ -0,0 +1,92 @@
+#ifndef _IPXE_TIMELINE_H
+#define _IPXE_TIMELINE_H
+
+/** @file
+ *
+ * Boot timeline
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stddef.h>
+#include <config/general.h>
+
+/** A boot timeline event */
+struct timeline_event {
+	/** Phase name */
+	const char *name;
+	/** Phase instance (e.g. the object performing the phase) */
+	const void *id;
+	/** Timestamp (in ticks) */
+	unsigned long ticks;
+	/** Status code (for end events) */
+	int rc;
+	/** Event type */
+	char type;
+};
+
+/** Boot timeline event types
+ *
+ * These are chosen to match the Chrome trace format's asynchronous
+ * event phase identifiers, since phases for different instances
+ * (e.g. concurrent DNS requests) may overlap arbitrarily.
+ */
+enum timeline_event_type {
+	/** Start of phase */
+	TIMELINE_BEGIN = 'b',
+	/** End of phase */
+	TIMELINE_END = 'e',
+};
+
+/** Maximum number of boot timeline events retained
+ *
+ * The oldest events are overwritten once this limit is reached.
+ */
+#define TIMELINE_MAX_EVENTS 256
+
+#ifdef BOOT_TIMELINE
+#define TIMELINE_ENABLED 1
+#else
+#define TIMELINE_ENABLED 0
+#endif
+
+extern void timeline_record ( const char *name, const void *id,
+			      char type, int rc );
+extern unsigned int timeline_count ( void );
+extern struct timeline_event * timeline_event ( unsigned int index );
+extern struct timeline_event * timeline_begin_of ( unsigned int index );
+extern size_t timeline_json_event ( struct timeline_event *event,
+				    char *buf, size_t len );
+extern size_t timeline_json ( char *buf, size_t len );
+
+/**
+ * Record start of boot phase
+ *
+ * @v name		Phase name
+ * @v id		Phase instance
+ */
+static inline __attribute__ (( always_inline )) void
+timeline_begin ( const char *name, const void *id ) {
+
+	/* Force dead code elimination in non-timeline builds */
+	if ( TIMELINE_ENABLED )
+		timeline_record ( name, id, TIMELINE_BEGIN, 0 );
+}
+
+/**
+ * Record end of boot phase
+ *
+ * @v name		Phase name
+ * @v id		Phase instance
+ * @v rc		Status code
+ */
+static inline __attribute__ (( always_inline )) void
+timeline_end ( const char *name, const void *id, int rc ) {
+
+	/* Force dead code elimination in non-timeline builds */
+	if ( TIMELINE_ENABLED )
+		timeline_record ( name, id, TIMELINE_END, rc );
+}
+
+#endif /* _IPXE_TIMELINE_H */
@@ -10,6 +10,7 @@
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
 #include <stdint.h>
+#include <time.h>
 #include <ipxe/refcnt.h>
 #include <ipxe/interface.h>
 #include <ipxe/process.h>
@@ -17,6 +18,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/md5.h>
 #include <ipxe/sha1.h>
 #include <ipxe/sha256.h>
+#include <ipxe/sha512.h>
+#include <ipxe/x25519.h>
 #include <ipxe/x509.h>
 #include <ipxe/pending.h>
 #include <ipxe/iobuf.h>
@@ -47,6 +50,9 @@ struct tls_header {
 /** TLS version 1.2 */
 #define TLS_VERSION_TLS_1_2 0x0303
 
+/** TLS version 1.3 */
+#define TLS_VERSION_TLS_1_3 0x0304
+
 /** Change cipher content type */
 #define TLS_TYPE_CHANGE_CIPHER 20
 
@@ -64,6 +70,7 @@ struct tls_header {
 #define TLS_CLIENT_HELLO 1
 #define TLS_SERVER_HELLO 2
 #define TLS_NEW_SESSION_TICKET 4
+#define TLS_ENCRYPTED_EXTENSIONS 8
 #define TLS_CERTIFICATE 11
 #define TLS_SERVER_KEY_EXCHANGE 12
 #define TLS_CERTIFICATE_REQUEST 13
@@ -71,6 +78,7 @@ struct tls_header {
 #define TLS_CERTIFICATE_VERIFY 15
 #define TLS_CLIENT_KEY_EXCHANGE 16
 #define TLS_FINISHED 20
+#define TLS_KEY_UPDATE 24
 
 /* TLS alert levels */
 #define TLS_ALERT_WARNING 1
@@ -83,6 +91,8 @@ struct tls_header {
 #define TLS_RSA_WITH_AES_256_CBC_SHA 0x0035
 #define TLS_RSA_WITH_AES_128_CBC_SHA256 0x003c
 #define TLS_RSA_WITH_AES_256_CBC_SHA256 0x003d
+#define TLS_AES_128_GCM_SHA256 0x1301
+#define TLS_AES_256_GCM_SHA384 0x1302
 
 /* TLS hash algorithm identifiers */
 #define TLS_MD5_ALGORITHM 1
@@ -91,9 +101,13 @@ struct tls_header {
 #define TLS_SHA256_ALGORITHM 4
 #define TLS_SHA384_ALGORITHM 5
 #define TLS_SHA512_ALGORITHM 6
+#define TLS_INTRINSIC_ALGORITHM 8
 
 /* TLS signature algorithm identifiers */
 #define TLS_RSA_ALGORITHM 1
+#define TLS_RSA_PSS_RSAE_SHA256_ALGORITHM 4
+#define TLS_RSA_PSS_RSAE_SHA384_ALGORITHM 5
+#define TLS_RSA_PSS_RSAE_SHA512_ALGORITHM 6
 
 /* TLS server name extension */
 #define TLS_SERVER_NAME 0
@@ -106,15 +120,35 @@ struct tls_header {
 #define TLS_MAX_FRAGMENT_LENGTH_2048 3
 #define TLS_MAX_FRAGMENT_LENGTH_4096 4
 
+/* TLS supported groups extension */
+#define TLS_SUPPORTED_GROUPS 10
+#define TLS_NAMED_GROUP_X25519 0x001d
+
 /* TLS signature algorithms extension */
 #define TLS_SIGNATURE_ALGORITHMS 13
 
 /* TLS session ticket extension */
 #define TLS_SESSION_TICKET 35
 
+/* TLS pre-shared key extension */
+#define TLS_PRE_SHARED_KEY 41
+
+/* TLS supported versions extension */
+#define TLS_SUPPORTED_VERSIONS 43
+
+/* TLS pre-shared key exchange modes extension */
+#define TLS_PSK_KEY_EXCHANGE_MODES 45
+#define TLS_PSK_DHE_KE 1
+
+/* TLS key share extension */
+#define TLS_KEY_SHARE 51
+
 /* TLS renegotiation information extension */
 #define TLS_RENEGOTIATION_INFO 0xff01
 
+/** Maximum TLSv1.3 session ticket lifetime (in seconds) */
+#define TLS_TICKET_LIFETIME_MAX ( 7 * 24 * 60 * 60 )
+
 /** TLS verification data */
 struct tls_verify_data {
 	/** Client verification data */
@@ -137,6 +171,7 @@ enum tls_tx_pending {
 	TLS_TX_CERTIFICATE_VERIFY = 0x0008,
 	TLS_TX_CHANGE_CIPHER = 0x0010,
 	TLS_TX_FINISHED = 0x0020,
+	TLS_TX_KEY_UPDATE = 0x0040,
 };
 
 /** A TLS cipher suite */
@@ -151,6 +186,12 @@ struct tls_cipher_suite {
 	uint16_t key_len;
 	/** Numeric code (in network-endian order) */
 	uint16_t code;
+	/** Minimum protocol version
+	 *
+	 * TLSv1.3 cipher suites may not be used with earlier protocol
+	 * versions, and vice versa.
+	 */
+	uint16_t version;
 };
 
 /** TLS cipher suite table */
@@ -161,6 +202,9 @@ struct tls_cipher_suite {
 #define __tls_cipher_suite( pref )					\
 	__table_entry ( TLS_CIPHER_SUITES, pref )
 
+/** Length of TLSv1.3 AEAD initialisation vector */
+#define TLS_AEAD_IV_LEN 12
+
 /** A TLS cipher specification */
 struct tls_cipherspec {
 	/** Cipher suite */
@@ -173,8 +217,10 @@ struct tls_cipherspec {
 	void *cipher_ctx;
 	/** Next bulk encryption cipher context (TX only) */
 	void *cipher_next_ctx;
-	/** MAC secret */
+	/** MAC secret (or TLSv1.3 traffic secret) */
 	void *mac_secret;
+	/** Fixed initialisation vector (TLSv1.3 only) */
+	uint8_t iv[TLS_AEAD_IV_LEN];
 };
 
 /** A TLS signature and hash algorithm identifier */
@@ -265,6 +311,16 @@ struct tls_session {
 	size_t ticket_len;
 	/** Master secret */
 	uint8_t master_secret[48];
+	/** TLSv1.3 pre-shared key cipher suite (if ticket is for TLSv1.3) */
+	struct tls_cipher_suite *psk_suite;
+	/** TLSv1.3 pre-shared key */
+	uint8_t psk[SHA384_DIGEST_SIZE];
+	/** TLSv1.3 ticket age obfuscation value */
+	uint32_t ticket_age_add;
+	/** TLSv1.3 ticket lifetime (in seconds) */
+	uint32_t ticket_lifetime;
+	/** TLSv1.3 ticket receipt time */
+	time_t ticket_time;
 
 	/** List of connections */
 	struct list_head conn;
@@ -305,8 +361,16 @@ struct tls_connection {
 	struct tls_cipherspec rx_cipherspec_pending;
 	/** Premaster secret */
 	struct tls_pre_master_secret pre_master_secret;
-	/** Master secret */
+	/** Master secret
+	 *
+	 * For TLSv1.3, this holds the current secret within the key
+	 * schedule, culminating in the resumption master secret.
+	 */
 	uint8_t master_secret[48];
+	/** TLSv1.3 pre-shared key cipher suite (if offered or accepted) */
+	struct tls_cipher_suite *psk_suite;
+	/** TLSv1.3 ephemeral X25519 private key */
+	struct x25519_value x25519_private;
 	/** Server random bytes */
 	uint8_t server_random[32];
 	/** Client random bytes */
@@ -315,6 +379,8 @@ struct tls_connection {
 	uint8_t handshake_md5_sha1_ctx[MD5_SHA1_CTX_SIZE];
 	/** SHA256 context for handshake verification */
 	uint8_t handshake_sha256_ctx[SHA256_CTX_SIZE];
+	/** SHA384 context for handshake verification */
+	uint8_t handshake_sha384_ctx[SHA512_CTX_SIZE];
 	/** Digest algorithm used for handshake verification */
 	struct digest_algorithm *handshake_digest;
 	/** Digest algorithm context used for handshake verification */
@@ -328,6 +394,8 @@ struct tls_connection {
 
 	/** Server certificate chain */
 	struct x509_chain *chain;
+	/** Server certificate signature has been verified (TLSv1.3 only) */
+	int certificate_verified;
 	/** Certificate validator */
 	struct interface validator;
 
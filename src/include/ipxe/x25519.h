@@ -0,0 +1,47 @@
+#ifndef _IPXE_X25519_H
+#define _IPXE_X25519_H
+
+/** @file
+ *
+ * X25519 key exchange
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+
+/** X25519 value length */
+#define X25519_SIZE 32
+
+/** Number of limbs in an X25519 field element */
+#define X25519_LIMBS 10
+
+/** An X25519 value
+ *
+ * This is a little-endian encoding of a scalar or of the
+ * u-coordinate of a point on Curve25519, as used on the wire.
+ */
+struct x25519_value {
+	/** Raw value */
+	uint8_t raw[X25519_SIZE];
+};
+
+/** An element of the field GF(2^255-19)
+ *
+ * Elements are held as ten signed limbs of alternately 26 and 25
+ * bits (i.e. in radix 2^25.5), so that the product of any two limbs
+ * fits within a 64-bit integer with headroom to spare.
+ */
+struct x25519_field {
+	/** Limbs (least significant first) */
+	int64_t limb[X25519_LIMBS];
+};
+
+extern const struct x25519_value x25519_generator;
+
+extern int x25519_key ( const struct x25519_value *base,
+			const struct x25519_value *scalar,
+			struct x25519_value *result );
+
+#endif /* _IPXE_X25519_H */
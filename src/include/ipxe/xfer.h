@@ -62,6 +62,17 @@ struct xfer_metadata {
 /** Data content is a response */
 #define XFER_FL_RESPONSE 0x0010
 
+/** Data has already been placed in the data transfer buffer
+ *
+ * The I/O buffer is empty, and the (relative) offset gives the
+ * length of data that the sender has already written directly to
+ * the underlying data transfer buffer (as obtained via
+ * xfer_buffer()) at the current position.  A recipient that tracks
+ * the length of the received stream must treat this as a delivery
+ * of that many bytes.
+ */
+#define XFER_FL_PLACED 0x0020
+
 /* Data transfer interface operations */
 
 extern int xfer_vredirect ( struct interface *intf, int type,
@@ -0,0 +1,307 @@
+#ifndef _IPXE_XZ_H
+#define _IPXE_XZ_H
+
+/** @file
+ *
+ * XZ decompression algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/deflate.h>
+#include <ipxe/inflate.h>
+
+/** XZ stream header magic */
+#define XZ_MAGIC { 0xfd, '7', 'z', 'X', 'Z', 0x00 }
+
+/** XZ stream footer magic */
+#define XZ_FOOTER_MAGIC { 'Y', 'Z' }
+
+/** XZ stream header or footer length */
+#define XZ_STREAM_HEADER_LEN 12
+
+/** Maximum XZ check type */
+#define XZ_CHECK_MAX 0x0f
+
+/** Maximum block header length */
+#define XZ_BLOCK_HEADER_MAX_LEN 1024
+
+/** Block header number of filters mask */
+#define XZ_BLOCK_FILTERS_MASK 0x03
+
+/** Block header reserved flags mask */
+#define XZ_BLOCK_RESERVED_MASK 0x3c
+
+/** Block header compressed size present flag */
+#define XZ_BLOCK_COMPRESSED_SIZE 0x40
+
+/** Block header uncompressed size present flag */
+#define XZ_BLOCK_UNCOMPRESSED_SIZE 0x80
+
+/** LZMA2 filter ID */
+#define XZ_FILTER_LZMA2 0x21
+
+/** Maximum LZMA2 dictionary size property */
+#define XZ_DICT_PROP_MAX 40
+
+/** Maximum supported dictionary size
+ *
+ * This is a policy decision.  It is larger than the dictionary size
+ * used by the reference compressor's highest preset.
+ */
+#define XZ_DICT_MAX ( 128 * 1024 * 1024 )
+
+/** Maximum length of a variable-length integer */
+#define XZ_VLI_MAX_LEN 9
+
+/** Variable-length integer continuation flag */
+#define XZ_VLI_MORE 0x80
+
+/** LZMA2 control byte: end of data */
+#define XZ_LZMA2_END 0x00
+
+/** LZMA2 control byte: uncompressed chunk with dictionary reset */
+#define XZ_LZMA2_COPY_RESET 0x01
+
+/** LZMA2 control byte: uncompressed chunk */
+#define XZ_LZMA2_COPY 0x02
+
+/** LZMA2 control byte: LZMA chunk */
+#define XZ_LZMA2_LZMA 0x80
+
+/** LZMA2 control byte: LZMA chunk with state reset */
+#define XZ_LZMA2_STATE_RESET 0xa0
+
+/** LZMA2 control byte: LZMA chunk with new properties */
+#define XZ_LZMA2_PROPS_RESET 0xc0
+
+/** LZMA2 control byte: LZMA chunk with dictionary reset */
+#define XZ_LZMA2_DICT_RESET 0xe0
+
+/** Maximum LZMA2 chunk header length (excluding control byte) */
+#define XZ_LZMA2_HEADER_MAX_LEN 5
+
+/** Maximum LZMA2 compressed chunk length */
+#define XZ_LZMA2_CHUNK_MAX ( 64 * 1024 )
+
+/** Maximum sum of LZMA literal context and position bits */
+#define XZ_LZMA_LCLP_MAX 4
+
+/** Maximum LZMA position bits */
+#define XZ_LZMA_PB_MAX 4
+
+/** Number of LZMA states */
+#define XZ_LZMA_STATES 12
+
+/** First LZMA state following a match */
+#define XZ_LZMA_MATCH_STATE 7
+
+/** Number of LZMA position states */
+#define XZ_LZMA_POS_STATES ( 1 << XZ_LZMA_PB_MAX )
+
+/** Number of LZMA literal coder probabilities per context */
+#define XZ_LZMA_LITERAL_CODER 0x300
+
+/** Number of LZMA length-to-distance states */
+#define XZ_LZMA_DIST_STATES 4
+
+/** Number of LZMA distance slot bits */
+#define XZ_LZMA_DIST_SLOT_BITS 6
+
+/** First LZMA distance slot using direct bits */
+#define XZ_LZMA_DIST_MODEL_END 14
+
+/** Number of LZMA distance alignment bits */
+#define XZ_LZMA_ALIGN_BITS 4
+
+/** Number of LZMA full distances */
+#define XZ_LZMA_FULL_DISTANCES ( 1 << ( XZ_LZMA_DIST_MODEL_END / 2 ) )
+
+/** Minimum LZMA match length */
+#define XZ_LZMA_MATCH_MIN 2
+
+/** LZMA range decoder normalisation threshold */
+#define XZ_RC_TOP ( 1UL << 24 )
+
+/** LZMA range decoder probability bits */
+#define XZ_RC_PROB_BITS 11
+
+/** LZMA range decoder probability adaptation shift */
+#define XZ_RC_MOVE_BITS 5
+
+/** LZMA range decoder initial probability */
+#define XZ_RC_PROB_INIT ( 1 << ( XZ_RC_PROB_BITS - 1 ) )
+
+/** LZMA range decoder initialisation length */
+#define XZ_RC_INIT_LEN 5
+
+/** An LZMA length decoder */
+struct xz_lzma_length {
+	/** Choice between low and mid/high lengths */
+	uint16_t choice;
+	/** Choice between mid and high lengths */
+	uint16_t choice2;
+	/** Low lengths */
+	uint16_t low[XZ_LZMA_POS_STATES][8];
+	/** Mid lengths */
+	uint16_t mid[XZ_LZMA_POS_STATES][8];
+	/** High lengths */
+	uint16_t high[256];
+};
+
+/** LZMA probabilities */
+struct xz_lzma_probs {
+	/** Match flags */
+	uint16_t is_match[XZ_LZMA_STATES][XZ_LZMA_POS_STATES];
+	/** Repeated match flags */
+	uint16_t is_rep[XZ_LZMA_STATES];
+	/** Repeated match 0 flags */
+	uint16_t is_rep0[XZ_LZMA_STATES];
+	/** Repeated match 1 flags */
+	uint16_t is_rep1[XZ_LZMA_STATES];
+	/** Repeated match 2 flags */
+	uint16_t is_rep2[XZ_LZMA_STATES];
+	/** Long repeated match 0 flags */
+	uint16_t is_rep0_long[XZ_LZMA_STATES][XZ_LZMA_POS_STATES];
+	/** Distance slots */
+	uint16_t dist_slot[XZ_LZMA_DIST_STATES][ 1 << XZ_LZMA_DIST_SLOT_BITS ];
+	/** Distances for slots below the direct bits model
+	 *
+	 * Each slot's bit tree is indexed from one, so the first
+	 * entry is unused.
+	 */
+	uint16_t dist_special[ 1 + XZ_LZMA_FULL_DISTANCES -
+			       XZ_LZMA_DIST_MODEL_END ];
+	/** Distance alignment bits */
+	uint16_t dist_align[ 1 << XZ_LZMA_ALIGN_BITS ];
+	/** Match lengths */
+	struct xz_lzma_length match_len;
+	/** Repeated match lengths */
+	struct xz_lzma_length rep_len;
+	/** Literals */
+	uint16_t literal[ XZ_LZMA_LITERAL_CODER << XZ_LZMA_LCLP_MAX ];
+};
+
+/** Decompressor state */
+enum xz_state {
+	/** Awaiting stream header */
+	XZ_STATE_STREAM_HEADER = 0,
+	/** Awaiting block header length or index indicator */
+	XZ_STATE_BLOCK_START,
+	/** Awaiting remainder of block header */
+	XZ_STATE_BLOCK_HEADER,
+	/** Awaiting LZMA2 control byte */
+	XZ_STATE_LZMA2_CONTROL,
+	/** Awaiting remainder of LZMA2 chunk header */
+	XZ_STATE_LZMA2_HEADER,
+	/** Copying uncompressed LZMA2 chunk */
+	XZ_STATE_LZMA2_COPY,
+	/** Awaiting LZMA2 compressed chunk */
+	XZ_STATE_LZMA2_DATA,
+	/** Decompressing LZMA2 compressed chunk */
+	XZ_STATE_LZMA2_DECODE,
+	/** Skipping block padding */
+	XZ_STATE_BLOCK_PADDING,
+	/** Skipping block check */
+	XZ_STATE_BLOCK_CHECK,
+	/** Awaiting index record count */
+	XZ_STATE_INDEX_COUNT,
+	/** Awaiting index records */
+	XZ_STATE_INDEX_RECORD,
+	/** Skipping index padding */
+	XZ_STATE_INDEX_PADDING,
+	/** Skipping index CRC */
+	XZ_STATE_INDEX_CRC,
+	/** Awaiting stream footer */
+	XZ_STATE_FOOTER,
+	/** Finished */
+	XZ_STATE_DONE,
+};
+
+/** Decompressor */
+struct xz {
+	/** Current state */
+	enum xz_state state;
+	/** Length of partially gathered data */
+	size_t have;
+	/** Total length of consumed input */
+	size_t consumed;
+	/** Remaining length of data to skip */
+	size_t remaining;
+	/** Check length */
+	size_t check_len;
+	/** Stream or block header */
+	uint8_t header[XZ_BLOCK_HEADER_MAX_LEN];
+	/** Block header length */
+	size_t header_len;
+	/** Partially decoded variable-length integer */
+	uint64_t vli;
+	/** Length of partially decoded variable-length integer */
+	unsigned int vli_len;
+	/** Remaining number of index fields */
+	size_t index_fields;
+
+	/** Dictionary size */
+	size_t dict_size;
+	/** Position since last dictionary reset */
+	size_t pos;
+	/** A dictionary reset is required */
+	int need_dict_reset;
+	/** A properties reset is required */
+	int need_props;
+	/** LZMA2 control byte */
+	unsigned int control;
+	/** LZMA2 chunk header */
+	uint8_t chunk_header[XZ_LZMA2_HEADER_MAX_LEN];
+	/** LZMA2 chunk header length */
+	size_t chunk_header_len;
+	/** Remaining uncompressed length of current chunk */
+	size_t uncompressed;
+	/** Compressed length of current chunk */
+	size_t compressed;
+
+	/** Range decoder range */
+	uint32_t range;
+	/** Range decoder code */
+	uint32_t code;
+	/** Range decoder position within compressed chunk */
+	size_t offset;
+
+	/** LZMA literal context bits */
+	unsigned int lc;
+	/** LZMA literal position mask */
+	unsigned int lp_mask;
+	/** LZMA position mask */
+	unsigned int pb_mask;
+	/** LZMA state */
+	unsigned int lzma_state;
+	/** Repeated distances */
+	uint32_t rep[4];
+	/** Remaining length of current match */
+	size_t len;
+	/** LZMA probabilities */
+	struct xz_lzma_probs probs;
+
+	/** LZMA2 compressed chunk */
+	uint8_t chunk[XZ_LZMA2_CHUNK_MAX];
+};
+
+/**
+ * Check if decompression has finished
+ *
+ * @v xz		Decompressor
+ * @ret finished	Decompression has finished
+ */
+static inline int xz_finished ( struct xz *xz ) {
+	return ( xz->state == XZ_STATE_DONE );
+}
+
+extern struct inflate_algorithm xz_algorithm;
+
+extern void xz_init ( struct xz *xz );
+extern int xz_decompress ( struct xz *xz, struct deflate_chunk *in,
+			   struct deflate_chunk *out );
+
+#endif /* _IPXE_XZ_H */
@@ -0,0 +1,266 @@
+#ifndef _IPXE_ZSTD_H
+#define _IPXE_ZSTD_H
+
+/** @file
+ *
+ * Zstandard decompression algorithm
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <ipxe/deflate.h>
+#include <ipxe/inflate.h>
+
+/** Zstandard frame magic number */
+#define ZSTD_MAGIC 0xfd2fb528UL
+
+/** Zstandard skippable frame magic number */
+#define ZSTD_SKIPPABLE_MAGIC 0x184d2a50UL
+
+/** Zstandard skippable frame magic number mask */
+#define ZSTD_SKIPPABLE_MASK 0xfffffff0UL
+
+/** Frame header descriptor frame content size flag LSB */
+#define ZSTD_FHD_FCS_LSB 6
+
+/** Frame header descriptor single segment flag bit */
+#define ZSTD_FHD_SINGLE_BIT 5
+
+/** Frame header descriptor reserved bit */
+#define ZSTD_FHD_RESERVED_BIT 3
+
+/** Frame header descriptor content checksum flag bit */
+#define ZSTD_FHD_CHECKSUM_BIT 2
+
+/** Frame header descriptor dictionary ID flag mask */
+#define ZSTD_FHD_DICT_MASK 0x03
+
+/** Maximum length of a frame header (excluding magic number) */
+#define ZSTD_HEADER_MAX_LEN 14
+
+/** Minimum window size (log2) */
+#define ZSTD_WINDOW_MIN_LOG 10
+
+/** Maximum supported window size
+ *
+ * This is a policy decision.  It matches the largest window used by
+ * the reference compressor's highest compression level.
+ */
+#define ZSTD_WINDOW_MAX ( 128 * 1024 * 1024 )
+
+/** Block header length */
+#define ZSTD_BLOCK_HEADER_LEN 3
+
+/** Block header last block flag bit */
+#define ZSTD_BLOCK_LAST_BIT 0
+
+/** Block header type LSB */
+#define ZSTD_BLOCK_TYPE_LSB 1
+
+/** Block header type mask */
+#define ZSTD_BLOCK_TYPE_MASK 0x03
+
+/** Block header size LSB */
+#define ZSTD_BLOCK_SIZE_LSB 3
+
+/** Block type: raw */
+#define ZSTD_BLOCK_RAW 0
+
+/** Block type: run-length encoded */
+#define ZSTD_BLOCK_RLE 1
+
+/** Block type: compressed */
+#define ZSTD_BLOCK_COMPRESSED 2
+
+/** Maximum block size */
+#define ZSTD_BLOCK_MAX ( 128 * 1024 )
+
+/** Content checksum length */
+#define ZSTD_CHECKSUM_LEN 4
+
+/** Literals section type: raw */
+#define ZSTD_LITERALS_RAW 0
+
+/** Literals section type: run-length encoded */
+#define ZSTD_LITERALS_RLE 1
+
+/** Literals section type: Huffman-compressed */
+#define ZSTD_LITERALS_COMPRESSED 2
+
+/** Literals section type: Huffman-compressed using previous table */
+#define ZSTD_LITERALS_TREELESS 3
+
+/** Maximum Huffman code length (in bits) */
+#define ZSTD_HUF_MAX_BITS 11
+
+/** Maximum number of Huffman-coded literal symbols */
+#define ZSTD_HUF_MAX_SYMBOLS 256
+
+/** Maximum accuracy of the FSE table for Huffman weights */
+#define ZSTD_HUF_WEIGHT_MAX_ACCURACY 6
+
+/** Maximum FSE table accuracy (log2 of table size) */
+#define ZSTD_FSE_MAX_ACCURACY 9
+
+/** Minimum FSE table accuracy encoded in a table description */
+#define ZSTD_FSE_MIN_ACCURACY 5
+
+/** Maximum number of FSE symbols */
+#define ZSTD_FSE_MAX_SYMBOLS 53
+
+/** Maximum literals length code */
+#define ZSTD_LL_MAX_CODE 35
+
+/** Maximum literals length FSE table accuracy */
+#define ZSTD_LL_MAX_ACCURACY 9
+
+/** Predefined literals length FSE table accuracy */
+#define ZSTD_LL_DEFAULT_ACCURACY 6
+
+/** Maximum match length code */
+#define ZSTD_ML_MAX_CODE 52
+
+/** Maximum match length FSE table accuracy */
+#define ZSTD_ML_MAX_ACCURACY 9
+
+/** Predefined match length FSE table accuracy */
+#define ZSTD_ML_DEFAULT_ACCURACY 6
+
+/** Maximum offset code
+ *
+ * Offset codes above this value would describe offsets beyond the
+ * maximum supported window size.
+ */
+#define ZSTD_OF_MAX_CODE 31
+
+/** Maximum offset FSE table accuracy */
+#define ZSTD_OF_MAX_ACCURACY 8
+
+/** Predefined offset FSE table accuracy */
+#define ZSTD_OF_DEFAULT_ACCURACY 5
+
+/** Sequence compression mode: predefined distribution */
+#define ZSTD_MODE_PREDEFINED 0
+
+/** Sequence compression mode: run-length encoded */
+#define ZSTD_MODE_RLE 1
+
+/** Sequence compression mode: FSE-compressed */
+#define ZSTD_MODE_COMPRESSED 2
+
+/** Sequence compression mode: repeat previous table */
+#define ZSTD_MODE_REPEAT 3
+
+/** A Huffman decoding table entry */
+struct zstd_huf_entry {
+	/** Symbol */
+	uint8_t symbol;
+	/** Code length (in bits) */
+	uint8_t bits;
+} __attribute__ (( packed ));
+
+/** An FSE decoding table entry */
+struct zstd_fse_entry {
+	/** Symbol */
+	uint8_t symbol;
+	/** Number of bits to read for the next state */
+	uint8_t bits;
+	/** Baseline for the next state */
+	uint16_t base;
+} __attribute__ (( packed ));
+
+/** An FSE decoding table */
+struct zstd_fse_table {
+	/** Accuracy (log2 of table size), or negative if invalid */
+	int accuracy;
+	/** Entries */
+	struct zstd_fse_entry entry[ 1 << ZSTD_FSE_MAX_ACCURACY ];
+};
+
+/** Decompressor state */
+enum zstd_state {
+	/** Awaiting frame magic number */
+	ZSTD_STATE_MAGIC = 0,
+	/** Awaiting skippable frame length */
+	ZSTD_STATE_SKIP_LEN,
+	/** Skipping skippable frame */
+	ZSTD_STATE_SKIP,
+	/** Awaiting frame header descriptor */
+	ZSTD_STATE_DESCRIPTOR,
+	/** Awaiting remainder of frame header */
+	ZSTD_STATE_HEADER,
+	/** Awaiting block header */
+	ZSTD_STATE_BLOCK_HEADER,
+	/** Awaiting block contents */
+	ZSTD_STATE_BLOCK,
+	/** Awaiting content checksum */
+	ZSTD_STATE_CHECKSUM,
+	/** Finished */
+	ZSTD_STATE_DONE,
+};
+
+/** Decompressor */
+struct zstd {
+	/** Current state */
+	enum zstd_state state;
+	/** Length of partially gathered data */
+	size_t have;
+	/** Frame header (excluding magic number) */
+	uint8_t header[ZSTD_HEADER_MAX_LEN];
+	/** Frame header length */
+	size_t header_len;
+	/** Remaining length of skippable frame */
+	size_t remaining;
+	/** Current block header */
+	uint8_t block_header[ZSTD_BLOCK_HEADER_LEN];
+	/** Current block type */
+	unsigned int block_type;
+	/** Current block length (as stored) */
+	size_t block_len;
+	/** Current block is the last block */
+	int last;
+	/** Window size */
+	size_t window;
+	/** Maximum block size */
+	size_t block_max;
+	/** Repeated offsets */
+	uint32_t rep[3];
+
+	/** Huffman table maximum code length, or zero if invalid */
+	unsigned int huf_bits;
+	/** Huffman decoding table */
+	struct zstd_huf_entry huf[ 1 << ZSTD_HUF_MAX_BITS ];
+	/** Huffman weight FSE table */
+	struct zstd_fse_table weights;
+	/** Literals length FSE table */
+	struct zstd_fse_table ll;
+	/** Offset FSE table */
+	struct zstd_fse_table of;
+	/** Match length FSE table */
+	struct zstd_fse_table ml;
+
+	/** Decoded literals */
+	uint8_t literals[ZSTD_BLOCK_MAX];
+	/** Gathered block contents */
+	uint8_t block[ZSTD_BLOCK_MAX];
+};
+
+/**
+ * Check if decompression has finished
+ *
+ * @v zstd		Decompressor
+ * @ret finished	Decompression has finished
+ */
+static inline int zstd_finished ( struct zstd *zstd ) {
+	return ( zstd->state == ZSTD_STATE_DONE );
+}
+
+extern struct inflate_algorithm zstd_algorithm;
+
+extern void zstd_init ( struct zstd *zstd );
+extern int zstd_decompress ( struct zstd *zstd, struct deflate_chunk *in,
+			     struct deflate_chunk *out );
+
+#endif /* _IPXE_ZSTD_H */
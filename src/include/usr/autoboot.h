@@ -35,9 +35,14 @@ extern int uriboot ( struct uri *filename, struct uri **root_paths,
 		     const char *san_filename, unsigned int flags );
 extern struct uri *
 fetch_next_server_and_filename ( struct settings *settings );
+extern int netboot_is_bootable ( struct settings *settings );
+extern int netboot_configured ( struct net_device *netdev,
+				struct settings *settings );
 extern int netboot ( struct net_device *netdev );
 extern int ipxe ( struct net_device *netdev );
 
 extern int pxe_menu_boot ( struct net_device *netdev );
+extern int netboot_concurrent ( int ( * is_candidate )
+					( struct net_device *netdev ) );
 
 #endif /* _USR_AUTOBOOT_H */
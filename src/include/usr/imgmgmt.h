@@ -15,6 +15,12 @@ extern int imgdownload ( struct uri *uri, unsigned long timeout,
 			 struct image **image );
 extern int imgdownload_string ( const char *uri_string, unsigned long timeout,
 				struct image **image );
+extern int imgdownload_background ( struct uri *uri, struct image **image );
+extern int imgdownload_background_string ( const char *uri_string,
+					   unsigned long timeout,
+					   struct image **image );
+extern int imgwait ( char **names, unsigned int count,
+		     unsigned long timeout );
 extern int imgacquire ( const char *name, unsigned long timeout,
 			struct image **image );
 extern void imgstat ( struct image *image );
@@ -0,0 +1,14 @@
+#ifndef _USR_PEERSTAT_H
+#define _USR_PEERSTAT_H
+
+/** @file
+ *
+ * PeerDist statistics
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+extern void peerstat ( void );
+
+#endif /* _USR_PEERSTAT_H */
@@ -0,0 +1,15 @@
+#ifndef _USR_TIMESTAT_H
+#define _USR_TIMESTAT_H
+
+/** @file
+ *
+ * Boot timeline
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+extern void timeline_stat ( void );
+extern void timeline_log ( void );
+
+#endif /* _USR_TIMESTAT_H */
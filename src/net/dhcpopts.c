@@ -273,7 +273,9 @@ static int resize_dhcp_option ( struct dhcp_options *options,
  *
  * Sets the value of a DHCP option within the options block.  The
  * option may or may not already exist.  Encapsulators will be created
- * (and deleted) as necessary.
+ * (and deleted) as necessary.  A NULL value deletes the option; a
+ * non-NULL zero-length value creates an empty option (such as Rapid
+ * Commit).
  *
  * This call may fail due to insufficient space in the options block.
  * If it does fail, and the option existed previously, the option will
@@ -288,7 +290,7 @@ static int set_dhcp_option ( struct dhcp_options *options, unsigned int tag,
 	struct dhcp_option *option;
 	unsigned int encap_tag = DHCP_ENCAPSULATOR ( tag );
 	size_t old_len = 0;
-	size_t new_len = ( len ? ( len + DHCP_OPTION_HEADER_LEN ) : 0 );
+	size_t new_len = ( data ? ( len + DHCP_OPTION_HEADER_LEN ) : 0 );
 	int rc;
 
 	/* Sanity check */
@@ -333,7 +335,7 @@ static int set_dhcp_option ( struct dhcp_options *options, unsigned int tag,
 		return rc;
 
 	/* Copy new data into option, if applicable */
-	if ( len ) {
+	if ( data ) {
 		option = dhcp_option ( options, offset );
 		option->tag = tag;
 		option->len = len;
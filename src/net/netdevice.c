@@ -41,6 +41,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/profile.h>
 #include <ipxe/fault.h>
 #include <ipxe/vlan.h>
+#include <ipxe/timeline.h>
 #include <ipxe/netdevice.h>
 
 /** @file
@@ -58,12 +59,32 @@ static struct list_head open_net_devices = LIST_HEAD_INIT ( open_net_devices );
 /** Network device index */
 static unsigned int netdev_index = 0;
 
+/** Maximum number of received packets processed as a single batch */
+#define NET_RX_BATCH 8
+
+/** A received packet awaiting network-layer processing */
+struct net_rx_packet {
+	/** I/O buffer (with link-layer header removed) */
+	struct io_buffer *iobuf;
+	/** Destination link-layer address */
+	const void *ll_dest;
+	/** Source link-layer address */
+	const void *ll_source;
+	/** Network-layer protocol, in network-byte order */
+	uint16_t net_proto;
+	/** Packet flags */
+	unsigned int flags;
+};
+
 /** Network polling profiler */
 static struct profiler net_poll_profiler __profiler = { .name = "net.poll" };
 
 /** Network receive profiler */
 static struct profiler net_rx_profiler __profiler = { .name = "net.rx" };
 
+/** Link-layer receive profiler */
+static struct profiler net_ll_rx_profiler __profiler = { .name = "net.ll_rx" };
+
 /** Network transmit profiler */
 static struct profiler net_tx_profiler __profiler = { .name = "net.tx" };
 
@@ -576,6 +597,7 @@ static void netdev_config_close ( struct net_device_configuration *config,
 
 	/* Record configuration result */
 	config->rc = rc;
+	timeline_end ( configurator->name, config, rc );
 	if ( rc == 0 ) {
 		DBGC ( netdev, "NETDEV %s configured via %s\n",
 		       netdev->name, configurator->name );
@@ -1015,26 +1037,43 @@ int net_tx ( struct io_buffer *iobuf, struct net_device *netdev,
 }
 
 /**
- * Process received network-layer packet
+ * Identify network-layer protocol
+ *
+ * @v net_proto		Network-layer protocol, in network-byte order
+ * @ret net_protocol	Network-layer protocol, or NULL if not found
+ */
+static struct net_protocol * net_protocol_find ( uint16_t net_proto ) {
+	struct net_protocol *net_protocol;
+
+	for_each_table_entry ( net_protocol, NET_PROTOCOLS ) {
+		if ( net_protocol->net_proto == net_proto )
+			return net_protocol;
+	}
+	return NULL;
+}
+
+/**
+ * Hand received packet to network-layer protocol
  *
  * @v iobuf		I/O buffer
  * @v netdev		Network device
+ * @v net_protocol	Network-layer protocol, or NULL if not found
  * @v net_proto		Network-layer protocol, in network-byte order
  * @v ll_dest		Destination link-layer address
  * @v ll_source		Source link-layer address
  * @v flags		Packet flags
  * @ret rc		Return status code
  */
-int net_rx ( struct io_buffer *iobuf, struct net_device *netdev,
-	     uint16_t net_proto, const void *ll_dest, const void *ll_source,
-	     unsigned int flags ) {
-	struct net_protocol *net_protocol;
+static int net_protocol_rx ( struct io_buffer *iobuf,
+			     struct net_device *netdev,
+			     struct net_protocol *net_protocol,
+			     uint16_t net_proto, const void *ll_dest,
+			     const void *ll_source, unsigned int flags ) {
 
 	/* Hand off to network-layer protocol, if any */
-	for_each_table_entry ( net_protocol, NET_PROTOCOLS ) {
-		if ( net_protocol->net_proto == net_proto )
-			return net_protocol->rx ( iobuf, netdev, ll_dest,
-						  ll_source, flags );
+	if ( net_protocol ) {
+		return net_protocol->rx ( iobuf, netdev, ll_dest, ll_source,
+					  flags );
 	}
 
 	DBGC ( netdev, "NETDEV %s unknown network protocol %04x\n",
@@ -1043,21 +1082,119 @@ int net_rx ( struct io_buffer *iobuf, struct net_device *netdev,
 	return -ENOTSUP;
 }
 
+/**
+ * Process received network-layer packet
+ *
+ * @v iobuf		I/O buffer
+ * @v netdev		Network device
+ * @v net_proto		Network-layer protocol, in network-byte order
+ * @v ll_dest		Destination link-layer address
+ * @v ll_source		Source link-layer address
+ * @v flags		Packet flags
+ * @ret rc		Return status code
+ */
+int net_rx ( struct io_buffer *iobuf, struct net_device *netdev,
+	     uint16_t net_proto, const void *ll_dest, const void *ll_source,
+	     unsigned int flags ) {
+
+	return net_protocol_rx ( iobuf, netdev, net_protocol_find ( net_proto ),
+				 net_proto, ll_dest, ll_source, flags );
+}
+
+/**
+ * Remove link-layer headers from a batch of received packets
+ *
+ * @v netdev		Network device
+ * @v batch		Batch to fill in
+ * @ret count		Number of packets in batch
+ *
+ * Packets with invalid link-layer headers are discarded.
+ */
+static unsigned int net_rx_batch ( struct net_device *netdev,
+				   struct net_rx_packet *batch ) {
+	struct ll_protocol *ll_protocol = netdev->ll_protocol;
+	struct net_rx_packet *packet;
+	struct io_buffer *iobuf;
+	unsigned int count = 0;
+	int rc;
+
+	while ( ( count < NET_RX_BATCH ) &&
+		( iobuf = netdev_rx_dequeue ( netdev ) ) ) {
+
+		DBGC2 ( netdev, "NETDEV %s processing %p (%p+%zx)\n",
+			netdev->name, iobuf, iobuf->data, iob_len ( iobuf ) );
+		profile_start ( &net_ll_rx_profiler );
+
+		/* Remove link-layer header */
+		packet = &batch[count];
+		if ( ( rc = ll_protocol->pull ( netdev, iobuf,
+						&packet->ll_dest,
+						&packet->ll_source,
+						&packet->net_proto,
+						&packet->flags ) ) != 0 ) {
+			free_iob ( iobuf );
+			profile_stop ( &net_ll_rx_profiler );
+			continue;
+		}
+		packet->iobuf = iobuf;
+		count++;
+		profile_stop ( &net_ll_rx_profiler );
+	}
+
+	return count;
+}
+
+/**
+ * Process a received packet from a batch
+ *
+ * @v netdev		Network device
+ * @v packet		Received packet
+ * @v net_protocol	Network-layer protocol of previous packet, or NULL
+ *
+ * The network-layer protocol is looked up only if it differs from
+ * that of the previous packet.
+ */
+static void net_rx_packet ( struct net_device *netdev,
+			    struct net_rx_packet *packet,
+			    struct net_protocol **net_protocol ) {
+	int rc;
+
+	profile_start ( &net_rx_profiler );
+
+	/* Identify network-layer protocol, if changed */
+	if ( ( ! *net_protocol ) ||
+	     ( (*net_protocol)->net_proto != packet->net_proto ) )
+		*net_protocol = net_protocol_find ( packet->net_proto );
+
+	/* Hand packet to network layer */
+	if ( ( rc = net_protocol_rx ( packet->iobuf, netdev, *net_protocol,
+				      packet->net_proto, packet->ll_dest,
+				      packet->ll_source,
+				      packet->flags ) ) != 0 ) {
+		/* Record error for diagnosis */
+		netdev_rx_err ( netdev, NULL, rc );
+	}
+
+	profile_stop ( &net_rx_profiler );
+}
+
 /**
  * Poll the network stack
  *
  * This polls all interfaces for received packets, and processes
  * packets from the RX queue.
+ *
+ * Received packets are processed in batches.  The link-layer headers
+ * of all packets in a batch are removed first, and the network-layer
+ * protocol is then identified only once for each run of consecutive
+ * packets using the same protocol.
  */
 void net_poll ( void ) {
+	struct net_rx_packet batch[NET_RX_BATCH];
+	struct net_rx_packet *packet;
+	struct net_protocol *net_protocol = NULL;
 	struct net_device *netdev;
-	struct io_buffer *iobuf;
-	struct ll_protocol *ll_protocol;
-	const void *ll_dest;
-	const void *ll_source;
-	uint16_t net_proto;
-	unsigned int flags;
-	int rc;
+	unsigned int count;
 
 	/* Poll and process each network device */
 	list_for_each_entry ( netdev, &net_devices, list ) {
@@ -1077,31 +1214,9 @@ void net_poll ( void ) {
 			continue;
 
 		/* Process all received packets */
-		while ( ( iobuf = netdev_rx_dequeue ( netdev ) ) ) {
-
-			DBGC2 ( netdev, "NETDEV %s processing %p (%p+%zx)\n",
-				netdev->name, iobuf, iobuf->data,
-				iob_len ( iobuf ) );
-			profile_start ( &net_rx_profiler );
-
-			/* Remove link-layer header */
-			ll_protocol = netdev->ll_protocol;
-			if ( ( rc = ll_protocol->pull ( netdev, iobuf,
-							&ll_dest, &ll_source,
-							&net_proto,
-							&flags ) ) != 0 ) {
-				free_iob ( iobuf );
-				continue;
-			}
-
-			/* Hand packet to network layer */
-			if ( ( rc = net_rx ( iob_disown ( iobuf ), netdev,
-					     net_proto, ll_dest,
-					     ll_source, flags ) ) != 0 ) {
-				/* Record error for diagnosis */
-				netdev_rx_err ( netdev, NULL, rc );
-			}
-			profile_stop ( &net_rx_profiler );
+		while ( ( count = net_rx_batch ( netdev, batch ) ) ) {
+			for ( packet = batch ; count-- ; packet++ )
+				net_rx_packet ( netdev, packet, &net_protocol );
 		}
 	}
 }
@@ -1239,11 +1354,13 @@ int netdev_configure ( struct net_device *netdev,
 	       netdev->name, configurator->name );
 
 	/* Start configuration */
+	timeline_begin ( configurator->name, config );
 	if ( ( rc = configurator->start ( &config->job, netdev ) ) != 0 ) {
 		DBGC ( netdev, "NETDEV %s could not start configuration via "
 		       "%s: %s\n", netdev->name, configurator->name,
 		       strerror ( rc ) );
 		config->rc = rc;
+		timeline_end ( configurator->name, config, rc );
 		return rc;
 	}
 
@@ -93,6 +93,65 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 	  "</soap:Body>"						      \
 	"</soap:Envelope>"
 
+/** Discovery probe action */
+#define PEERDIST_DISCOVERY_PROBE_ACTION					      \
+	"http://schemas.xmlsoap.org/ws/2005/04/discovery/Probe"
+
+/** Discovery probe match format */
+#define PEERDIST_DISCOVERY_MATCH					      \
+	"<?xml version=\"1.0\" encoding=\"utf-8\"?>"			      \
+	"<soap:Envelope "						      \
+	    "xmlns:soap=\"http://www.w3.org/2003/05/soap-envelope\" "	      \
+	    "xmlns:wsa=\"http://schemas.xmlsoap.org/ws/2004/08/addressing\" " \
+	    "xmlns:wsd=\"http://schemas.xmlsoap.org/ws/2005/04/discovery\" "  \
+	    "xmlns:PeerDist=\"http://schemas.microsoft.com/p2p/"	      \
+			     "2007/09/PeerDistributionDiscovery\">"	      \
+	  "<soap:Header>"						      \
+	    "<wsa:To>"							      \
+	      "http://schemas.xmlsoap.org/ws/2004/08/addressing/role/"	      \
+	      "anonymous"						      \
+	    "</wsa:To>"							      \
+	    "<wsa:Action>"						      \
+	      "http://schemas.xmlsoap.org/ws/2005/04/discovery/ProbeMatches"  \
+	    "</wsa:Action>"						      \
+	    "<wsa:MessageID>"						      \
+	      "urn:uuid:%s"						      \
+	    "</wsa:MessageID>"						      \
+	    "<wsa:RelatesTo>"						      \
+	      "%s"							      \
+	    "</wsa:RelatesTo>"						      \
+	    "<wsd:AppSequence InstanceId=\"1\" MessageNumber=\"1\"/>"	      \
+	  "</soap:Header>"						      \
+	  "<soap:Body>"							      \
+	    "<wsd:ProbeMatches>"					      \
+	      "<wsd:ProbeMatch>"					      \
+		"<wsa:EndpointReference>"				      \
+		  "<wsa:Address>"					      \
+		    "urn:uuid:%s"					      \
+		  "</wsa:Address>"					      \
+		"</wsa:EndpointReference>"				      \
+		"<wsd:Types>"						      \
+		  "PeerDist:PeerDistData"				      \
+		"</wsd:Types>"						      \
+		"<wsd:Scopes>"						      \
+		  "%s"							      \
+		"</wsd:Scopes>"						      \
+		"<wsd:XAddrs>"						      \
+		  "%s"							      \
+		"</wsd:XAddrs>"						      \
+		"<wsd:MetadataVersion>"					      \
+		  "1"							      \
+		"</wsd:MetadataVersion>"				      \
+		"<PeerDist:PeerDistData>"				      \
+		  "<PeerDist:BlockCount>"				      \
+		    "%s"						      \
+		  "</PeerDist:BlockCount>"				      \
+		"</PeerDist:PeerDistData>"				      \
+	      "</wsd:ProbeMatch>"					      \
+	    "</wsd:ProbeMatches>"					      \
+	  "</soap:Body>"						      \
+	"</soap:Envelope>"
+
 /**
  * Construct discovery request
  *
@@ -115,6 +174,34 @@ char * peerdist_discovery_request ( const char *uuid, const char *id ) {
 	return request;
 }
 
+/**
+ * Construct discovery probe match
+ *
+ * @v uuid		Message UUID string
+ * @v relates		Message ID of discovery request
+ * @v ids		Space-separated segment identifier strings
+ * @v locations		Space-separated peer locations
+ * @v counts		Concatenated block counts (one per segment)
+ * @ret match		Discovery probe match, or NULL on failure
+ *
+ * The probe match is dynamically allocated; the caller must
+ * eventually free() the probe match.
+ */
+char * peerdist_discovery_match ( const char *uuid, const char *relates,
+				  const char *ids, const char *locations,
+				  const char *counts ) {
+	char *match;
+	int len;
+
+	/* Construct probe match */
+	len = asprintf ( &match, PEERDIST_DISCOVERY_MATCH, uuid, relates,
+			 uuid, ids, locations, counts );
+	if ( len < 0 )
+		return NULL;
+
+	return match;
+}
+
 /**
  * Locate discovery reply tag
  *
@@ -165,12 +252,28 @@ static char * peerdist_discovery_reply_values ( char *data, size_t len,
 	char *out;
 	char c;
 
-	/* Locate opening tag */
-	snprintf ( buf, sizeof ( buf ), "<%s>", name );
-	open = peerdist_discovery_reply_tag ( data, len, buf );
-	if ( ! open )
-		return NULL;
-	start = ( open + strlen ( buf ) );
+	/* Locate opening tag, skipping any attributes */
+	snprintf ( buf, sizeof ( buf ), "<%s", name );
+	do {
+		open = peerdist_discovery_reply_tag ( data, len, buf );
+		if ( ! open )
+			return NULL;
+		start = ( open + strlen ( buf ) );
+		len -= ( start - data );
+		data = start;
+		if ( ! len )
+			return NULL;
+		c = *data;
+		if ( isspace ( c ) ) {
+			end = memchr ( data, '>', len );
+			if ( ! end )
+				return NULL;
+			len -= ( end - data );
+			data = end;
+			c = *data;
+		}
+	} while ( c != '>' );
+	start = ( data + 1 );
 	len -= ( start - data );
 	data = start;
 
@@ -202,6 +305,60 @@ static char * peerdist_discovery_reply_values ( char *data, size_t len,
 	return start;
 }
 
+/**
+ * Parse discovery probe
+ *
+ * @v data		Probe data (not NUL-terminated, will be modified)
+ * @v len		Length of probe data
+ * @v probe		Discovery probe to fill in
+ * @ret rc		Return status code
+ *
+ * The discovery probe includes pointers to strings within the
+ * modified probe data.
+ */
+int peerdist_discovery_probe ( char *data, size_t len,
+			       struct peerdist_discovery_probe *probe ) {
+	char *action;
+	char *message;
+	char *scopes;
+
+	/* Find <wsa:Action> tag */
+	action = peerdist_discovery_reply_values ( data, len, "wsa:Action" );
+	if ( ! action ) {
+		DBGC ( probe, "PCCRD %p missing <wsa:Action> tag\n", probe );
+		return -ENOENT;
+	}
+
+	/* Ignore anything other than probes (e.g. Hello and Bye) */
+	if ( strcmp ( action, PEERDIST_DISCOVERY_PROBE_ACTION ) != 0 ) {
+		DBGC2 ( probe, "PCCRD %p ignoring action %s\n",
+			probe, action );
+		return -ENOTSUP;
+	}
+
+	/* Find <wsa:MessageID> tag */
+	message = peerdist_discovery_reply_values ( data, len,
+						    "wsa:MessageID" );
+	if ( ! message ) {
+		DBGC ( probe, "PCCRD %p missing <wsa:MessageID> tag\n",
+		       probe );
+		return -ENOENT;
+	}
+
+	/* Find <wsd:Scopes> tag */
+	scopes = peerdist_discovery_reply_values ( data, len, "wsd:Scopes" );
+	if ( ! scopes ) {
+		DBGC ( probe, "PCCRD %p missing <wsd:Scopes> tag\n", probe );
+		return -ENOENT;
+	}
+
+	/* Fill in discovery probe */
+	probe->message = message;
+	probe->ids = scopes;
+
+	return 0;
+}
+
 /**
  * Parse discovery reply
  *
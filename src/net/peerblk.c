@@ -43,10 +43,14 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  */
 
 /** PeerDist decryption chunksize
+ *
+ * Larger chunks amortise the per-step overhead of reading from and
+ * writing to the data transfer buffer, at the cost of holding off
+ * other processes for longer.
  *
  * This is a policy decision.
  */
-#define PEERBLK_DECRYPT_CHUNKSIZE 2048
+#define PEERBLK_DECRYPT_CHUNKSIZE 16384
 
 /** PeerDist maximum number of concurrent raw block downloads
  *
@@ -61,11 +65,20 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  * connection to go through the full client certificate verification.
  *
  * Limit the total number of concurrent raw block downloads to
- * ameliorate these problems.
+ * ameliorate these problems.  The limit starts at
+ * PEERBLK_RAW_INITIAL, is increased (up to PEERBLK_RAW_MAX) each
+ * time a raw block download succeeds while other raw block downloads
+ * are waiting, and is halved each time a raw block download fails.
+ *
+ * This is a policy decision.
+ */
+#define PEERBLK_RAW_MAX 8
+
+/** PeerDist initial limit on number of concurrent raw block downloads
  *
  * This is a policy decision.
  */
-#define PEERBLK_RAW_MAX 2
+#define PEERBLK_RAW_INITIAL 2
 
 /** PeerDist raw block download attempt initial progress timeout
  *
@@ -126,6 +139,7 @@ static struct profiler peerblk_discovery_success_profiler __profiler =
 static struct profiler peerblk_discovery_timeout_profiler __profiler =
 	{ .name = "peerblk.discovery.timeout" };
 
+static struct peerdist_block_queue peerblk_raw_queue;
 static void peerblk_dequeue ( struct peerdist_block *peerblk );
 
 /**
@@ -287,6 +301,50 @@ static int peerblk_deliver ( struct peerdist_block *peerblk,
 	return 0;
 }
 
+/**
+ * Record outcome of PeerDist block download attempt
+ *
+ * @v peerblk		PeerDist block download
+ * @v rc		Attempt status code
+ *
+ * Successful attempts from peers are used to rank peers by
+ * throughput, and the outcome of raw block downloads from the origin
+ * server is used to adjust the raw block download concurrency limit.
+ */
+static void peerblk_feedback ( struct peerdist_block *peerblk, int rc ) {
+	struct peerdisc_segment *segment = peerblk->discovery.segment;
+	struct peerdist_block_queue *queue = &peerblk_raw_queue;
+	struct peerdisc_peer *peer = peerblk->peer;
+	struct peerdisc_peer *head;
+
+	/* Do nothing unless an attempt was in progress */
+	if ( ! peer )
+		return;
+
+	/* Adjust raw block download concurrency limit */
+	head = list_entry ( &segment->peers, struct peerdisc_peer, list );
+	if ( peer == head ) {
+		if ( rc != 0 ) {
+			queue->max = ( ( queue->max + 1 ) / 2 );
+		} else if ( ( queue->max < PEERBLK_RAW_MAX ) &&
+			    ( ! list_empty ( &queue->list ) ) ) {
+			queue->max++;
+		}
+		DBGC2 ( peerblk, "PEERBLK %p %d.%d raw limit %d\n", peerblk,
+			peerblk->segment, peerblk->block, queue->max );
+		return;
+	}
+
+	/* Update peer statistics */
+	if ( rc != 0 ) {
+		peer->failures++;
+		return;
+	}
+	peer->bytes += ( peerblk->range.end - peerblk->range.start );
+	peer->ticks += ( currticks() - peerblk->attempted );
+	peer->successes++;
+}
+
 /**
  * Finish PeerDist block download attempt
  *
@@ -324,6 +382,9 @@ static void peerblk_done ( struct peerdist_block *peerblk, int rc ) {
 	profile_custom ( &peerblk_attempt_success_profiler,
 			 ( now - peerblk->attempted ) );
 
+	/* Record successful attempt */
+	peerblk_feedback ( peerblk, 0 );
+
 	/* Report peer statistics */
 	head = list_entry ( &segment->peers, struct peerdisc_peer, list );
 	peer = ( ( peerblk->peer == head ) ? NULL : peerblk->peer );
@@ -337,6 +398,7 @@ static void peerblk_done ( struct peerdist_block *peerblk, int rc ) {
 	/* Record failure reason and schedule a retry attempt */
 	profile_custom ( &peerblk_attempt_failure_profiler,
 			 ( now - peerblk->attempted ) );
+	peerblk_feedback ( peerblk, rc );
 	peerblk_reset ( peerblk, rc );
 	peerblk->rc = rc;
 	start_timer_nodelay ( &peerblk->timer );
@@ -563,7 +625,7 @@ static struct process_descriptor peerblk_queue_desc =
 static struct peerdist_block_queue peerblk_raw_queue = {
 	.process = PROC_INIT ( peerblk_raw_queue.process, &peerblk_queue_desc ),
 	.list = LIST_HEAD_INIT ( peerblk_raw_queue.list ),
-	.max = PEERBLK_RAW_MAX,
+	.max = PEERBLK_RAW_INITIAL,
 	.open = peerblk_raw_open,
 };
 
@@ -1299,13 +1361,16 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 		DBGC ( peerblk, "PEERBLK %p %d.%d timed out after %ld ticks\n",
 		       peerblk, peerblk->segment, peerblk->block,
 		       timer->timeout );
+		peerblk_feedback ( peerblk, -ETIMEDOUT );
 	}
 
 	/* Abort any current download attempt */
 	peerblk_reset ( peerblk, -ETIMEDOUT );
 
-	/* Record attempt start time */
-	peerblk->attempted = now;
+	/* Record attempt start time.  This is also used to measure
+	 * peer throughput, and so cannot use the profiling timestamp.
+	 */
+	peerblk->attempted = currticks();
 
 	/* If we have exceeded our maximum number of attempt cycles
 	 * (each cycle comprising a retrieval protocol download from
@@ -1320,11 +1385,20 @@ static void peerblk_expired ( struct retry_timer *timer, int over __unused ) {
 		goto err;
 	}
 
-	/* If we have not yet made any download attempts, then move to
-	 * the start of the peer list.
+	/* If we have not yet made any download attempts, then start
+	 * with the fastest known peer (if any), otherwise move to the
+	 * start of the peer list.
 	 */
-	if ( peerblk->peer == NULL )
-		peerblk->peer = head;
+	if ( peerblk->peer == NULL ) {
+		peerblk->peer = peerdisc_fastest ( segment );
+		if ( peerblk->peer ) {
+			peerblk->peer = list_entry ( peerblk->peer->list.prev,
+						     struct peerdisc_peer,
+						     list );
+		} else {
+			peerblk->peer = head;
+		}
+	}
 
 	/* Attempt retrieval protocol download from next usable peer */
 	list_for_each_entry_continue ( peerblk->peer, &segment->peers, list ) {
@@ -23,6 +23,7 @@
 
 FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 
+#include <stdint.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
@@ -410,6 +411,33 @@ static int peerdisc_discovered ( struct peerdisc_segment *segment,
 	return 0;
 }
 
+/**
+ * Find fastest discovered PeerDist peer
+ *
+ * @v segment		PeerDist discovery segment
+ * @ret peer		Fastest peer, or NULL if no peer has been measured
+ *
+ * Peers are ranked by observed download throughput.  Peers which
+ * have failed at least as often as they have succeeded are ignored.
+ */
+struct peerdisc_peer * peerdisc_fastest ( struct peerdisc_segment *segment ) {
+	struct peerdisc_peer *peer;
+	struct peerdisc_peer *fastest = NULL;
+
+	list_for_each_entry ( peer, &segment->peers, list ) {
+		if ( peer->failures >= peer->successes )
+			continue;
+		if ( fastest &&
+		     ( ( ( ( uint64_t ) peer->bytes ) *
+			 ( fastest->ticks + 1 ) ) <=
+		       ( ( ( uint64_t ) fastest->bytes ) *
+			 ( peer->ticks + 1 ) ) ) )
+			continue;
+		fastest = peer;
+	}
+	return fastest;
+}
+
 /**
  * Handle discovery timer expiry
  *
@@ -29,8 +29,10 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/uri.h>
 #include <ipxe/xferbuf.h>
 #include <ipxe/job.h>
+#include <ipxe/timer.h>
 #include <ipxe/peerblk.h>
 #include <ipxe/peermux.h>
+#include <ipxe/peerserve.h>
 
 /** @file
  *
@@ -38,6 +40,23 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/** Cumulative PeerDist statistics for all downloads */
+struct peerdist_statistics peermux_stats;
+
+/**
+ * Offer downloaded PeerDist content to peers
+ *
+ * @v xfer		Data transfer interface of completed download
+ * @v info		Content information
+ *
+ * This is a weak stub which is overridden when the PeerDist content
+ * server is present.
+ */
+__weak void peerserve_add ( struct interface *xfer __unused,
+			    const struct peerdist_info *info __unused ) {
+	/* Nothing to do */
+}
+
 /**
  * Free PeerDist download multiplexer
  *
@@ -184,10 +203,10 @@ static void peermux_step ( struct peerdist_multiplexer *peermux ) {
 	unsigned int next_block;
 	int rc;
 
-	/* Stop initiation process if all block downloads are busy */
+	/* Stop initiation process if the window is full */
 	peermblk = list_first_entry ( &peermux->idle,
 				      struct peerdist_multiplexed_block, list );
-	if ( ! peermblk ) {
+	if ( ( ! peermblk ) || ( peermux->active >= peermux->window ) ) {
 		process_del ( &peermux->process );
 		return;
 	}
@@ -209,8 +228,10 @@ static void peermux_step ( struct peerdist_multiplexer *peermux ) {
 		 */
 		if ( next_segment >= info->segments ) {
 			process_del ( &peermux->process );
-			if ( list_empty ( &peermux->busy ) )
+			if ( list_empty ( &peermux->busy ) ) {
+				peerserve_add ( &peermux->xfer, info );
 				peermux_close ( peermux, 0 );
+			}
 			return;
 		}
 
@@ -251,6 +272,9 @@ static void peermux_step ( struct peerdist_multiplexer *peermux ) {
 	/* Move to list of busy block downloads */
 	list_del ( &peermblk->list );
 	list_add_tail ( &peermblk->list, &peermux->busy );
+	peermblk->len = ( block->trim.end - block->trim.start );
+	peermblk->started = currticks();
+	peermux->active++;
 
 	return;
 
@@ -258,6 +282,36 @@ static void peermux_step ( struct peerdist_multiplexer *peermux ) {
 	peermux_close ( peermux, rc );
 }
 
+/**
+ * Adjust multiplexed block download window
+ *
+ * @v peermux		PeerDist download multiplexer
+ * @v latency		Latency of completed block download (in ticks)
+ *
+ * The window is grown for as long as block downloads complete within
+ * PEERMUX_LATENCY_FACTOR times the lowest observed latency, and is
+ * shrunk once latency rises beyond this (indicating that the peers,
+ * the origin server, or the network are saturated).
+ */
+static void peermux_adjust ( struct peerdist_multiplexer *peermux,
+			     unsigned long latency ) {
+
+	/* Update lowest observed latency */
+	if ( ( ! peermux->latency ) || ( latency < peermux->latency ) )
+		peermux->latency = ( latency ? latency : 1 );
+
+	/* Grow or shrink window */
+	if ( latency <= ( PEERMUX_LATENCY_FACTOR * peermux->latency ) ) {
+		if ( peermux->window < PEERMUX_MAX_BLOCKS )
+			peermux->window++;
+	} else {
+		if ( peermux->window > PEERMUX_MIN_BLOCKS )
+			peermux->window--;
+	}
+	DBGC2 ( peermux, "PEERMUX %p latency %ld (min %ld) window %d\n",
+		peermux, latency, peermux->latency, peermux->window );
+}
+
 /**
  * Receive data from multiplexed block download
  *
@@ -319,10 +373,19 @@ static void peermux_block_stat ( struct peerdist_multiplexed_block *peermblk,
 	if ( count > stats->peers )
 		stats->peers = count;
 
-	/* Update block counts */
-	if ( peer )
+	/* Update block and byte counts */
+	if ( peer ) {
 		stats->local++;
+		stats->local_bytes += peermblk->len;
+		peermux_stats.local++;
+		peermux_stats.local_bytes += peermblk->len;
+	}
 	stats->total++;
+	stats->total_bytes += peermblk->len;
+	peermux_stats.total++;
+	peermux_stats.total_bytes += peermblk->len;
+	if ( count > peermux_stats.peers )
+		peermux_stats.peers = count;
 	DBGC2 ( peermux, "PEERMUX %p downloaded %d/%d from %d peers\n",
 		peermux, stats->local, stats->total, stats->peers );
 }
@@ -340,6 +403,7 @@ static void peermux_block_close ( struct peerdist_multiplexed_block *peermblk,
 	/* Move to list of idle downloads */
 	list_del ( &peermblk->list );
 	list_add_tail ( &peermblk->list, &peermux->idle );
+	peermux->active--;
 
 	/* If any error occurred, terminate the whole multiplexer */
 	if ( rc != 0 ) {
@@ -347,6 +411,9 @@ static void peermux_block_close ( struct peerdist_multiplexed_block *peermblk,
 		return;
 	}
 
+	/* Adjust window */
+	peermux_adjust ( peermux, ( currticks() - peermblk->started ) );
+
 	/* Restart data transfer interface */
 	intf_restart ( &peermblk->xfer, rc );
 
@@ -428,6 +495,7 @@ int peermux_filter ( struct interface *xfer, struct interface *info,
 			       &peermux->refcnt );
 	INIT_LIST_HEAD ( &peermux->busy );
 	INIT_LIST_HEAD ( &peermux->idle );
+	peermux->window = PEERMUX_INITIAL_BLOCKS;
 	for ( i = 0 ; i < PEERMUX_MAX_BLOCKS ; i++ ) {
 		peermblk = &peermux->block[i];
 		peermblk->peermux = peermux;
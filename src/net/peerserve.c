@@ -0,0 +1,1099 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/list.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/xfer.h>
+#include <ipxe/retry.h>
+#include <ipxe/timer.h>
+#include <ipxe/init.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/image.h>
+#include <ipxe/downloader.h>
+#include <ipxe/in.h>
+#include <ipxe/ip.h>
+#include <ipxe/udp.h>
+#include <ipxe/tcp.h>
+#include <ipxe/uuid.h>
+#include <ipxe/base16.h>
+#include <ipxe/crypto.h>
+#include <ipxe/aes.h>
+#include <ipxe/pccrc.h>
+#include <ipxe/pccrd.h>
+#include <ipxe/pccrr.h>
+#include <ipxe/peerserve.h>
+
+/** @file
+ *
+ * Peer Content Caching and Retrieval (PeerDist) protocol content server
+ *
+ * Content which has been downloaded via PeerDist is offered to other
+ * peers on the local network.  We respond to discovery probes for
+ * any segments that we hold, and serve retrieval protocol requests
+ * for the corresponding blocks via a minimal HTTP server.  Block
+ * data is read directly from the downloaded image.
+ *
+ * Only IPv4 is supported.
+ */
+
+/** Maximum length of a retrieval protocol HTTP request
+ *
+ * This is a policy decision.
+ */
+#define PEERSERVE_MAX_REQUEST 2048
+
+/** Maximum length of a retrieval protocol HTTP response header */
+#define PEERSERVE_MAX_HEADER 128
+
+/** Retrieval protocol HTTP connection timeout
+ *
+ * This is a policy decision.
+ */
+#define PEERSERVE_TIMEOUT ( 15 * TICKS_PER_SEC )
+
+/** A served content information segment */
+struct peerserve_segment {
+	/** Content information segment */
+	struct peerdist_info_segment segment;
+	/** First block held */
+	unsigned int first;
+	/** Number of blocks held */
+	unsigned int count;
+};
+
+/** Served PeerDist content */
+struct peerserve_content {
+	/** List of served content */
+	struct list_head list;
+	/** Image holding the trimmed content range */
+	struct image *image;
+	/** Content information */
+	struct peerdist_info info;
+	/** Content information segments */
+	struct peerserve_segment segments[0];
+};
+
+/** A retrieval protocol HTTP connection */
+struct peerserve_connection {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** Data transfer interface */
+	struct interface xfer;
+	/** Timeout timer */
+	struct retry_timer timer;
+
+	/** Length of received request */
+	size_t len;
+	/** Offset of request body (or zero if headers are incomplete) */
+	size_t body;
+	/** Length of request body */
+	size_t content_len;
+	/** Received request */
+	char request[ PEERSERVE_MAX_REQUEST + 1 /* NUL */ ];
+};
+
+/** A PeerDist content server */
+struct peerserve_server {
+	/** Discovery socket */
+	struct interface socket;
+	/** Retrieval protocol HTTP listener */
+	struct tcp_listener listener;
+	/** Server has been started */
+	int started;
+};
+
+/** List of served content */
+static LIST_HEAD ( peerserve_contents );
+
+static struct interface_descriptor peerserve_socket_desc;
+static int peerserve_accept ( struct interface *xfer, struct sockaddr *peer );
+
+/** PeerDist content server */
+static struct peerserve_server peerserve = {
+	.socket = INTF_INIT ( peerserve_socket_desc ),
+	.listener = {
+		.port = PEERSERVE_PORT,
+		.accept = peerserve_accept,
+	},
+};
+
+/******************************************************************************
+ *
+ * Served content
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Get served content
+ *
+ * @v pseg		Served segment
+ * @ret content		Served content
+ */
+static inline __attribute__ (( always_inline )) struct peerserve_content *
+peerserve_content ( struct peerserve_segment *pseg ) {
+	return container_of ( ( ( struct peerdist_info * )
+				pseg->segment.info ),
+			      struct peerserve_content, info );
+}
+
+/**
+ * Find served segment
+ *
+ * @v id		Segment identifier
+ * @v digestsize	Length of segment identifier
+ * @ret pseg		Served segment, or NULL if not found
+ */
+static struct peerserve_segment * peerserve_find ( const void *id,
+						   size_t digestsize ) {
+	struct peerserve_content *content;
+	struct peerserve_segment *pseg;
+	unsigned int i;
+
+	list_for_each_entry ( content, &peerserve_contents, list ) {
+		if ( content->info.digestsize != digestsize )
+			continue;
+		for ( i = 0 ; i < content->info.segments ; i++ ) {
+			pseg = &content->segments[i];
+			if ( memcmp ( pseg->segment.id, id, digestsize ) == 0 )
+				return pseg;
+		}
+	}
+	return NULL;
+}
+
+/**
+ * Check if served segment blocks are available
+ *
+ * @v pseg		Served segment
+ * @ret count		Number of available blocks
+ *
+ * An image may be modified after it has been downloaded (e.g. by
+ * "imgdecrypt" or "imgextract"), in which case we can no longer
+ * serve its blocks.  Peers verify every block they receive, so this
+ * is simply an optimisation to avoid wasting their time.
+ */
+static unsigned int peerserve_available ( struct peerserve_segment *pseg ) {
+	struct peerserve_content *content = peerserve_content ( pseg );
+	struct peerdist_info *info = &content->info;
+
+	if ( content->image->len != ( info->trim.end - info->trim.start ) )
+		return 0;
+	return pseg->count;
+}
+
+/**
+ * Free served content
+ *
+ * @v content		Served content
+ */
+static void peerserve_free ( struct peerserve_content *content ) {
+
+	list_del ( &content->list );
+	image_put ( content->image );
+	free ( content );
+}
+
+/******************************************************************************
+ *
+ * Retrieval protocol messages
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Allocate retrieval protocol response
+ *
+ * @v len		Length of response body
+ * @ret iobuf		I/O buffer, or NULL on error
+ */
+static struct io_buffer * peerserve_alloc_iob ( size_t len ) {
+	struct io_buffer *iobuf;
+
+	/* Allocate I/O buffer with space for the HTTP response header */
+	iobuf = alloc_iob ( PEERSERVE_MAX_HEADER + len );
+	if ( ! iobuf )
+		return NULL;
+	iob_reserve ( iobuf, PEERSERVE_MAX_HEADER );
+	memset ( iob_put ( iobuf, len ), 0, len );
+
+	return iobuf;
+}
+
+/**
+ * Construct retrieval protocol negotiation response
+ *
+ * @ret iobuf		I/O buffer, or NULL on error
+ */
+static struct io_buffer * peerserve_nego ( void ) {
+	struct {
+		struct peerdist_msg_transport_header hdr;
+		struct peerdist_msg_nego_resp msg;
+	} __attribute__ (( packed )) *rsp;
+	struct io_buffer *iobuf;
+
+	/* Allocate response */
+	iobuf = peerserve_alloc_iob ( sizeof ( *rsp ) );
+	if ( ! iobuf )
+		return NULL;
+	rsp = iobuf->data;
+
+	/* Construct response */
+	rsp->hdr.len = htonl ( sizeof ( rsp->msg ) );
+	rsp->msg.hdr.version.raw = htonl ( PEERDIST_MSG_NEGO_RESP_VERSION );
+	rsp->msg.hdr.type = htonl ( PEERDIST_MSG_NEGO_RESP_TYPE );
+	rsp->msg.hdr.len = htonl ( sizeof ( rsp->msg ) );
+	rsp->msg.versions.min.raw = htonl ( PEERDIST_MSG_VERSION_1_0 );
+	rsp->msg.versions.max.raw = htonl ( PEERDIST_MSG_VERSION_1_0 );
+
+	return iobuf;
+}
+
+/**
+ * Construct retrieval protocol block list response
+ *
+ * @v id		Segment identifier
+ * @v digestsize	Length of segment identifier
+ * @ret iobuf		I/O buffer, or NULL on error
+ *
+ * We report the single contiguous range of blocks that we hold,
+ * irrespective of the ranges requested.
+ */
+static struct io_buffer * peerserve_blklist ( const void *id,
+					      size_t digestsize ) {
+	struct peerserve_segment *pseg = peerserve_find ( id, digestsize );
+	unsigned int available = ( pseg ? peerserve_available ( pseg ) : 0 );
+	unsigned int count = ( available ? 1 : 0 );
+	struct {
+		struct peerdist_msg_transport_header hdr;
+		peerdist_msg_blklist_t ( digestsize, count ) msg;
+	} __attribute__ (( packed )) *rsp;
+	struct io_buffer *iobuf;
+
+	/* Allocate response */
+	iobuf = peerserve_alloc_iob ( sizeof ( *rsp ) );
+	if ( ! iobuf )
+		return NULL;
+	rsp = iobuf->data;
+
+	/* Construct response */
+	rsp->hdr.len = htonl ( sizeof ( rsp->msg ) );
+	rsp->msg.blklist.hdr.version.raw =
+		htonl ( PEERDIST_MSG_BLKLIST_VERSION );
+	rsp->msg.blklist.hdr.type = htonl ( PEERDIST_MSG_BLKLIST_TYPE );
+	rsp->msg.blklist.hdr.len = htonl ( sizeof ( rsp->msg ) );
+	rsp->msg.segment.segment.digestsize = htonl ( digestsize );
+	memcpy ( rsp->msg.segment.id, id, digestsize );
+	rsp->msg.ranges.ranges.count = htonl ( count );
+	if ( count ) {
+		rsp->msg.ranges.range[0].first = htonl ( pseg->first );
+		rsp->msg.ranges.range[0].count = htonl ( available );
+	}
+
+	return iobuf;
+}
+
+/**
+ * Construct retrieval protocol block fetch response
+ *
+ * @v id		Segment identifier
+ * @v digestsize	Length of segment identifier
+ * @v index		Block index
+ * @v algorithm		Requested cryptographic algorithm ID
+ * @ret iobuf		I/O buffer, or NULL on error
+ *
+ * Blocks that we do not hold are reported via a zero-length data
+ * block, which peers interpret as "block not found".
+ */
+static struct io_buffer * peerserve_blk ( const void *id, size_t digestsize,
+					  unsigned int index,
+					  uint32_t algorithm ) {
+	struct cipher_algorithm *cipher = &aes_cbc_algorithm;
+	struct peerserve_segment *pseg = peerserve_find ( id, digestsize );
+	unsigned int available = ( pseg ? peerserve_available ( pseg ) : 0 );
+	struct peerserve_content *content;
+	struct peerdist_info_block block;
+	union {
+		uint8_t bytes[AES_BLOCKSIZE];
+		uint32_t dword[ AES_BLOCKSIZE / sizeof ( uint32_t ) ];
+	} iv;
+	size_t keylen = 0;
+	size_t blksize;
+	size_t data_len = 0;
+	size_t len = 0;
+	unsigned int i;
+	int rc;
+
+	/* Determine cipher algorithm and key length */
+	switch ( algorithm ) {
+	case htonl ( PEERDIST_MSG_PLAINTEXT ) :
+		cipher = NULL;
+		break;
+	case htonl ( PEERDIST_MSG_AES_128_CBC ) :
+		keylen = ( 128 / 8 );
+		break;
+	case htonl ( PEERDIST_MSG_AES_192_CBC ) :
+		keylen = ( 192 / 8 );
+		break;
+	case htonl ( PEERDIST_MSG_AES_256_CBC ) :
+		keylen = ( 256 / 8 );
+		break;
+	default:
+		DBGC ( &peerserve, "PEERSERVE unrecognised algorithm %#08x\n",
+		       ntohl ( algorithm ) );
+		return NULL;
+	}
+	blksize = ( cipher ? cipher->blocksize : 0 );
+	if ( keylen > digestsize ) {
+		DBGC ( &peerserve, "PEERSERVE %zd-byte secret too short for "
+		       "%zd-bit key\n", digestsize, ( 8 * keylen ) );
+		return NULL;
+	}
+
+	/* Identify block, if held */
+	if ( pseg && ( index >= pseg->first ) &&
+	     ( index < ( pseg->first + available ) ) ) {
+		if ( ( rc = peerdist_info_block ( &pseg->segment, &block,
+						  index ) ) != 0 ) {
+			DBGC ( &peerserve, "PEERSERVE could not get block %d "
+			       "information: %s\n", index, strerror ( rc ) );
+			return NULL;
+		}
+		data_len = ( block.range.end - block.range.start );
+		len = data_len;
+		if ( cipher )
+			len = ( ( len + blksize - 1 ) & ~( blksize - 1 ) );
+	}
+
+	/* Allocate and construct response */
+	{
+		struct {
+			struct peerdist_msg_transport_header hdr;
+			peerdist_msg_blk_t ( digestsize, len, 0, blksize ) msg;
+		} __attribute__ (( packed )) *rsp;
+		struct io_buffer *iobuf;
+
+		/* Allocate response */
+		iobuf = peerserve_alloc_iob ( sizeof ( *rsp ) );
+		if ( ! iobuf )
+			return NULL;
+		rsp = iobuf->data;
+
+		/* Construct response */
+		rsp->hdr.len = htonl ( sizeof ( rsp->msg ) );
+		rsp->msg.blk.hdr.version.raw =
+			htonl ( PEERDIST_MSG_BLK_VERSION );
+		rsp->msg.blk.hdr.type = htonl ( PEERDIST_MSG_BLK_TYPE );
+		rsp->msg.blk.hdr.len = htonl ( sizeof ( rsp->msg ) );
+		rsp->msg.blk.hdr.algorithm = algorithm;
+		rsp->msg.segment.segment.digestsize = htonl ( digestsize );
+		memcpy ( rsp->msg.segment.id, id, digestsize );
+		rsp->msg.index = htonl ( index );
+		rsp->msg.block.block.len = htonl ( len );
+		rsp->msg.iv.iv.blksize = htonl ( blksize );
+		if ( ! len )
+			return iobuf;
+
+		/* Indicate next available block, if any */
+		if ( ( index + 1 ) < ( pseg->first + available ) )
+			rsp->msg.next = htonl ( index + 1 );
+
+		/* Read block data from image */
+		content = peerserve_content ( pseg );
+		copy_from_user ( rsp->msg.block.data, content->image->data,
+				 ( block.range.start -
+				   content->info.trim.start ), data_len );
+
+		/* Encrypt block data, if applicable.  The initialisation
+		 * vector does not require high quality randomness.
+		 */
+		if ( cipher ) {
+			uint8_t ctx[cipher->ctxsize];
+
+			for ( i = 0 ; i < ( sizeof ( iv.dword ) /
+					    sizeof ( iv.dword[0] ) ) ; i++ ) {
+				iv.dword[i] = random();
+			}
+			memcpy ( rsp->msg.iv.data, iv.bytes, blksize );
+			if ( ( rc = cipher_setkey ( cipher, ctx,
+						    pseg->segment.secret,
+						    keylen ) ) != 0 ) {
+				DBGC ( &peerserve, "PEERSERVE could not set "
+				       "key: %s\n", strerror ( rc ) );
+				free_iob ( iobuf );
+				return NULL;
+			}
+			cipher_setiv ( cipher, ctx, iv.bytes );
+			cipher_encrypt ( cipher, ctx, rsp->msg.block.data,
+					 rsp->msg.block.data, len );
+		}
+
+		DBGC2 ( &peerserve, "PEERSERVE serving block %d [%08zx,%08zx) "
+			"of \"%s\"\n", index, block.range.start,
+			block.range.end, content->image->name );
+		return iobuf;
+	}
+}
+
+/**
+ * Construct retrieval protocol response
+ *
+ * @v data		Request message
+ * @v len		Length of request message
+ * @ret iobuf		I/O buffer, or NULL on error
+ */
+static struct io_buffer * peerserve_message ( const void *data, size_t len ) {
+	const struct peerdist_msg_header *hdr = data;
+	const struct peerdist_msg_segment *segment;
+	size_t digestsize;
+
+	/* Check message header */
+	if ( len < ( sizeof ( *hdr ) + sizeof ( *segment ) ) ) {
+		if ( ( len >= sizeof ( *hdr ) ) &&
+		     ( hdr->type == htonl ( PEERDIST_MSG_NEGO_REQ_TYPE ) ) )
+			return peerserve_nego();
+		DBGC ( &peerserve, "PEERSERVE message too short (%zd bytes)\n",
+		       len );
+		return NULL;
+	}
+	if ( hdr->type == htonl ( PEERDIST_MSG_NEGO_REQ_TYPE ) )
+		return peerserve_nego();
+
+	/* Block list and block fetch requests both start with a
+	 * segment ID and a block range list.
+	 */
+	segment = ( data + sizeof ( *hdr ) );
+	digestsize = ntohl ( segment->digestsize );
+	if ( digestsize > PEERDIST_DIGEST_MAX_SIZE ) {
+		DBGC ( &peerserve, "PEERSERVE invalid digest size %zd\n",
+		       digestsize );
+		return NULL;
+	}
+	{
+		const peerdist_msg_getblklist_t ( digestsize, 1 ) *req = data;
+
+		/* Check message length */
+		if ( ( len < sizeof ( *req ) ) ||
+		     ( req->ranges.ranges.count == 0 ) ) {
+			DBGC ( &peerserve, "PEERSERVE message too short for "
+			       "range (%zd bytes)\n", len );
+			return NULL;
+		}
+
+		/* Handle request */
+		switch ( hdr->type ) {
+		case htonl ( PEERDIST_MSG_GETBLKLIST_TYPE ) :
+			return peerserve_blklist ( req->segment.id,
+						   digestsize );
+		case htonl ( PEERDIST_MSG_GETBLKS_TYPE ) :
+			return peerserve_blk ( req->segment.id, digestsize,
+					       ntohl ( req->ranges.range[0].first ),
+					       hdr->algorithm );
+		default:
+			DBGC ( &peerserve, "PEERSERVE unsupported message type "
+			       "%#08x\n", ntohl ( hdr->type ) );
+			return NULL;
+		}
+	}
+}
+
+/******************************************************************************
+ *
+ * Retrieval protocol HTTP connections
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Close retrieval protocol HTTP connection
+ *
+ * @v conn		Retrieval protocol HTTP connection
+ * @v rc		Reason for close
+ */
+static void peerserve_close ( struct peerserve_connection *conn, int rc ) {
+
+	/* Stop timer */
+	stop_timer ( &conn->timer );
+
+	/* Shut down interfaces */
+	intf_shutdown ( &conn->xfer, rc );
+}
+
+/**
+ * Send HTTP response
+ *
+ * @v conn		Retrieval protocol HTTP connection
+ * @v status		HTTP status code
+ * @v message		HTTP status message
+ * @v iobuf		Response body, or NULL
+ */
+static void peerserve_respond ( struct peerserve_connection *conn,
+				unsigned int status, const char *message,
+				struct io_buffer *iobuf ) {
+	char header[PEERSERVE_MAX_HEADER + 1 /* NUL */];
+	size_t len;
+	int rc;
+
+	/* Allocate empty response body, if applicable */
+	if ( ( ! iobuf ) &&
+	     ( ( iobuf = peerserve_alloc_iob ( 0 ) ) == NULL ) ) {
+		rc = -ENOMEM;
+		goto err;
+	}
+
+	/* Construct response header */
+	len = snprintf ( header, sizeof ( header ),
+			 "HTTP/1.1 %d %s\r\n"
+			 "Content-Type: application/octet-stream\r\n"
+			 "Content-Length: %zd\r\n"
+			 "Connection: close\r\n"
+			 "\r\n", status, message, iob_len ( iobuf ) );
+	assert ( len < sizeof ( header ) );
+	memcpy ( iob_push ( iobuf, len ), header, len );
+
+	/* Send response */
+	if ( ( rc = xfer_deliver_iob ( &conn->xfer, iobuf ) ) != 0 ) {
+		DBGC ( conn, "PEERSERVE %p could not send response: %s\n",
+		       conn, strerror ( rc ) );
+		goto err;
+	}
+	rc = 0;
+
+ err:
+	peerserve_close ( conn, rc );
+}
+
+/**
+ * Parse HTTP request headers
+ *
+ * @v conn		Retrieval protocol HTTP connection
+ * @v end		End of request headers
+ * @ret rc		Return status code
+ */
+static int peerserve_parse ( struct peerserve_connection *conn, char *end ) {
+	char *line = conn->request;
+	char *next;
+	char *name;
+	char *value;
+	char *sep;
+	char *tmp;
+
+	/* Record start of request body */
+	*end = '\0';
+	conn->body = ( end + 4 /* "\r\n\r\n" */ - conn->request );
+
+	/* Parse request line */
+	if ( ( next = strstr ( line, "\r\n" ) ) != NULL )
+		*next = '\0';
+	DBGC2 ( conn, "PEERSERVE %p RX %s\n", conn, line );
+	if ( strncmp ( line, "POST ", 5 ) != 0 )
+		return -ENOTSUP;
+	if ( strncmp ( ( line + 5 ), PEERDIST_MAGIC_PATH " ",
+		       ( sizeof ( PEERDIST_MAGIC_PATH ) /* " " */ ) ) != 0 )
+		return -ENOENT;
+
+	/* Parse header lines */
+	for ( line = ( next ? ( next + 2 ) : NULL ) ; line ;
+	      line = ( next ? ( next + 2 ) : NULL ) ) {
+		if ( ( next = strstr ( line, "\r\n" ) ) != NULL )
+			*next = '\0';
+		DBGC2 ( conn, "PEERSERVE %p RX %s\n", conn, line );
+		sep = strchr ( line, ':' );
+		if ( ! sep )
+			return -EINVAL;
+		*sep = '\0';
+		name = line;
+		value = ( sep + 1 );
+		if ( strcasecmp ( name, "Content-Length" ) == 0 ) {
+			conn->content_len = strtoul ( value, &tmp, 10 );
+			if ( *tmp )
+				return -EINVAL;
+		}
+	}
+
+	/* Check that request body will fit */
+	if ( conn->content_len > ( PEERSERVE_MAX_REQUEST - conn->body ) )
+		return -ERANGE;
+
+	return 0;
+}
+
+/**
+ * Receive data on retrieval protocol HTTP connection
+ *
+ * @v conn		Retrieval protocol HTTP connection
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int peerserve_deliver ( struct peerserve_connection *conn,
+			       struct io_buffer *iobuf,
+			       struct xfer_metadata *meta __unused ) {
+	size_t len = iob_len ( iobuf );
+	struct io_buffer *rsp;
+	char *end;
+	int rc;
+
+	/* Append to request */
+	if ( len > ( PEERSERVE_MAX_REQUEST - conn->len ) ) {
+		DBGC ( conn, "PEERSERVE %p request too long\n", conn );
+		free_iob ( iobuf );
+		peerserve_respond ( conn, 413, "Request Entity Too Large",
+				    NULL );
+		return -ERANGE;
+	}
+	memcpy ( ( conn->request + conn->len ), iobuf->data, len );
+	conn->len += len;
+	conn->request[conn->len] = '\0';
+	free_iob ( iobuf );
+
+	/* Parse request headers, once complete */
+	if ( ! conn->body ) {
+		end = strstr ( conn->request, "\r\n\r\n" );
+		if ( ! end )
+			return 0;
+		if ( ( rc = peerserve_parse ( conn, end ) ) != 0 ) {
+			DBGC ( conn, "PEERSERVE %p could not parse request: "
+			       "%s\n", conn, strerror ( rc ) );
+			if ( rc == -ENOENT ) {
+				peerserve_respond ( conn, 404, "Not Found",
+						    NULL );
+			} else {
+				peerserve_respond ( conn, 400, "Bad Request",
+						    NULL );
+			}
+			return rc;
+		}
+	}
+
+	/* Wait for complete request body */
+	if ( conn->len < ( conn->body + conn->content_len ) )
+		return 0;
+
+	/* Construct and send response */
+	rsp = peerserve_message ( ( conn->request + conn->body ),
+				  conn->content_len );
+	if ( rsp ) {
+		peerserve_respond ( conn, 200, "OK", rsp );
+	} else {
+		peerserve_respond ( conn, 400, "Bad Request", NULL );
+	}
+
+	return 0;
+}
+
+/**
+ * Handle retrieval protocol HTTP connection timeout
+ *
+ * @v timer		Timeout timer
+ * @v over		Failure indicator
+ */
+static void peerserve_expired ( struct retry_timer *timer, int over __unused ) {
+	struct peerserve_connection *conn =
+		container_of ( timer, struct peerserve_connection, timer );
+
+	DBGC ( conn, "PEERSERVE %p timed out\n", conn );
+	peerserve_close ( conn, -ETIMEDOUT );
+}
+
+/** Retrieval protocol HTTP connection interface operations */
+static struct interface_operation peerserve_conn_operations[] = {
+	INTF_OP ( xfer_deliver, struct peerserve_connection *,
+		  peerserve_deliver ),
+	INTF_OP ( intf_close, struct peerserve_connection *, peerserve_close ),
+};
+
+/** Retrieval protocol HTTP connection interface descriptor */
+static struct interface_descriptor peerserve_conn_desc =
+	INTF_DESC ( struct peerserve_connection, xfer,
+		    peerserve_conn_operations );
+
+/**
+ * Accept retrieval protocol HTTP connection
+ *
+ * @v xfer		Data transfer interface of new connection
+ * @v peer		Peer socket address
+ * @ret rc		Return status code
+ */
+static int peerserve_accept ( struct interface *xfer, struct sockaddr *peer ) {
+	struct peerserve_connection *conn;
+
+	/* Allocate and initialise structure */
+	conn = zalloc ( sizeof ( *conn ) );
+	if ( ! conn )
+		return -ENOMEM;
+	ref_init ( &conn->refcnt, NULL );
+	intf_init ( &conn->xfer, &peerserve_conn_desc, &conn->refcnt );
+	timer_init ( &conn->timer, peerserve_expired, &conn->refcnt );
+	DBGC ( conn, "PEERSERVE %p accepted connection from %s\n",
+	       conn, sock_ntoa ( peer ) );
+
+	/* Start timeout timer */
+	start_timer_fixed ( &conn->timer, PEERSERVE_TIMEOUT );
+
+	/* Attach to data transfer interface, mortalise self, and return */
+	intf_plug_plug ( &conn->xfer, xfer );
+	ref_put ( &conn->refcnt );
+	return 0;
+}
+
+/******************************************************************************
+ *
+ * Discovery socket
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Find local address for responding to peer
+ *
+ * @v peer		Peer address
+ * @ret miniroute	IPv4 routing table entry, or NULL
+ */
+static struct ipv4_miniroute * peerserve_miniroute ( struct in_addr peer ) {
+	struct ipv4_miniroute *miniroute;
+
+	list_for_each_entry ( miniroute, &ipv4_miniroutes, list ) {
+		if ( ! netdev_is_open ( miniroute->netdev ) )
+			continue;
+		if ( ( ( miniroute->address.s_addr ^ peer.s_addr ) &
+		       miniroute->netmask.s_addr ) == 0 )
+			return miniroute;
+	}
+	return NULL;
+}
+
+/**
+ * Receive discovery probe
+ *
+ * @v server		PeerDist content server
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int peerserve_socket_rx ( struct peerserve_server *server,
+				 struct io_buffer *iobuf,
+				 struct xfer_metadata *meta ) {
+	struct sockaddr_in *sin_src = ( ( struct sockaddr_in * ) meta->src );
+	struct peerdist_discovery_probe probe;
+	struct peerserve_segment *pseg;
+	struct ipv4_miniroute *miniroute;
+	struct xfer_metadata reply_meta;
+	union {
+		union uuid uuid;
+		uint32_t dword[ sizeof ( union uuid ) / sizeof ( uint32_t ) ];
+	} random_uuid;
+	char location[ sizeof ( "255.255.255.255:65535" ) ];
+	uint8_t id[PEERDIST_DIGEST_MAX_SIZE];
+	unsigned int available;
+	unsigned int count = 0;
+	unsigned int i;
+	size_t ids_len = 0;
+	char *ids;
+	char *counts;
+	char *match;
+	char *tmp;
+	int len;
+	int rc;
+
+	/* Ignore probes from unknown sources */
+	if ( ( ! sin_src ) || ( sin_src->sin_family != AF_INET ) ) {
+		rc = -ENOTSUP;
+		goto err_src;
+	}
+	miniroute = peerserve_miniroute ( sin_src->sin_addr );
+	if ( ! miniroute ) {
+		rc = -ENETUNREACH;
+		goto err_src;
+	}
+
+	/* Parse probe */
+	if ( ( rc = peerdist_discovery_probe ( iobuf->data, iob_len ( iobuf ),
+					       &probe ) ) != 0 ) {
+		DBGC2 ( server, "PEERSERVE could not parse probe: %s\n",
+			strerror ( rc ) );
+		goto err_probe;
+	}
+
+	/* Allocate space for matching segment IDs and block counts */
+	for ( tmp = probe.ids ; *tmp ; tmp += ( strlen ( tmp ) + 1 ) )
+		ids_len += ( strlen ( tmp ) + 1 /* " " or NUL */ );
+	ids = malloc ( ids_len + 1 /* NUL */ );
+	counts = malloc ( ( ids_len * sizeof ( struct
+					   peerdist_discovery_block_count ) )
+			  + 1 /* NUL */ );
+	if ( ! ( ids && counts ) ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ids[0] = '\0';
+	counts[0] = '\0';
+
+	/* Identify segments that we hold */
+	for ( tmp = probe.ids ; *tmp ; tmp += ( strlen ( tmp ) + 1 ) ) {
+		len = base16_decode ( tmp, id, sizeof ( id ) );
+		if ( ( len < 0 ) || ( ( ( size_t ) len ) > sizeof ( id ) ) )
+			continue;
+		pseg = peerserve_find ( id, len );
+		if ( ! pseg )
+			continue;
+		available = peerserve_available ( pseg );
+		if ( ! available )
+			continue;
+		DBGC ( server, "PEERSERVE holds %d blocks of %s\n",
+		       available, tmp );
+		sprintf ( ( ids + strlen ( ids ) ), "%s%s",
+			  ( count ? " " : "" ), tmp );
+		sprintf ( ( counts + strlen ( counts ) ), "%08X", available );
+		count++;
+	}
+	if ( ! count ) {
+		rc = 0;
+		goto no_match;
+	}
+
+	/* Construct probe match.  This does not require high quality
+	 * randomness.
+	 */
+	for ( i = 0 ; i < ( sizeof ( random_uuid.dword ) /
+			    sizeof ( random_uuid.dword[0] ) ) ; i++ )
+		random_uuid.dword[i] = random();
+	snprintf ( location, sizeof ( location ), "%s:%d",
+		   inet_ntoa ( miniroute->address ), PEERSERVE_PORT );
+	match = peerdist_discovery_match ( uuid_ntoa ( &random_uuid.uuid ),
+					   probe.message, ids, location,
+					   counts );
+	if ( ! match ) {
+		rc = -ENOMEM;
+		goto err_match;
+	}
+
+	/* Send probe match */
+	memset ( &reply_meta, 0, sizeof ( reply_meta ) );
+	reply_meta.dest = meta->src;
+	if ( ( rc = xfer_deliver_raw_meta ( &server->socket, match,
+					    strlen ( match ),
+					    &reply_meta ) ) != 0 ) {
+		DBGC ( server, "PEERSERVE could not send probe match: %s\n",
+		       strerror ( rc ) );
+		goto err_deliver;
+	}
+
+ err_deliver:
+	free ( match );
+ err_match:
+ no_match:
+ err_alloc:
+	free ( counts );
+	free ( ids );
+ err_probe:
+ err_src:
+	free_iob ( iobuf );
+	return rc;
+}
+
+/** Discovery socket interface operations */
+static struct interface_operation peerserve_socket_operations[] = {
+	INTF_OP ( xfer_deliver, struct peerserve_server *,
+		  peerserve_socket_rx ),
+};
+
+/** Discovery socket interface descriptor */
+static struct interface_descriptor peerserve_socket_desc =
+	INTF_DESC ( struct peerserve_server, socket,
+		    peerserve_socket_operations );
+
+/******************************************************************************
+ *
+ * Content registration
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Start PeerDist content server
+ *
+ * @ret rc		Return status code
+ */
+static int peerserve_start ( void ) {
+	union {
+		struct sockaddr sa;
+		struct sockaddr_in sin;
+	} local;
+	int rc;
+
+	/* Do nothing if already started */
+	if ( peerserve.started )
+		return 0;
+
+	/* Open discovery socket */
+	memset ( &local, 0, sizeof ( local ) );
+	local.sin.sin_family = AF_INET;
+	local.sin.sin_port = htons ( PEERDIST_DISCOVERY_PORT );
+	if ( ( rc = udp_open ( &peerserve.socket, NULL, &local.sa ) ) != 0 ) {
+		DBGC ( &peerserve, "PEERSERVE could not open discovery "
+		       "socket: %s\n", strerror ( rc ) );
+		goto err_socket;
+	}
+
+	/* Start listening for retrieval protocol requests */
+	if ( ( rc = tcp_listen ( &peerserve.listener ) ) != 0 ) {
+		DBGC ( &peerserve, "PEERSERVE could not listen: %s\n",
+		       strerror ( rc ) );
+		goto err_listen;
+	}
+
+	peerserve.started = 1;
+	return 0;
+
+	tcp_unlisten ( &peerserve.listener );
+ err_listen:
+	intf_restart ( &peerserve.socket, rc );
+ err_socket:
+	return rc;
+}
+
+/**
+ * Offer downloaded PeerDist content to peers
+ *
+ * @v xfer		Data transfer interface of completed download
+ * @v info		Content information
+ */
+void peerserve_add ( struct interface *xfer,
+		     const struct peerdist_info *info ) {
+	struct peerserve_content *content;
+	struct peerserve_segment *pseg;
+	struct peerdist_info_block block;
+	struct image *image;
+	unsigned int i;
+	unsigned int j;
+	size_t len;
+	void *raw;
+	int rc;
+
+	/* Identify image */
+	image = downloader_image ( xfer );
+	if ( ! image ) {
+		DBGC ( &peerserve, "PEERSERVE cannot serve non-image "
+		       "content\n" );
+		return;
+	}
+
+	/* Allocate and initialise structure, retaining a copy of the
+	 * raw content information.
+	 */
+	len = ( sizeof ( *content ) +
+		( info->segments * sizeof ( content->segments[0] ) ) );
+	content = zalloc ( len + info->raw.len );
+	if ( ! content )
+		return;
+	raw = ( ( ( void * ) content ) + len );
+	copy_from_user ( raw, info->raw.data, 0, info->raw.len );
+	content->image = image_get ( image );
+
+	/* Parse content information */
+	if ( ( rc = peerdist_info ( virt_to_user ( raw ), info->raw.len,
+				    &content->info ) ) != 0 ) {
+		DBGC ( content, "PEERSERVE %p could not parse content "
+		       "information: %s\n", content, strerror ( rc ) );
+		goto err;
+	}
+	if ( content->info.segments != info->segments ) {
+		rc = -EINVAL;
+		goto err;
+	}
+
+	/* Identify blocks which lie entirely within the trimmed
+	 * content range, and so are held within the image.
+	 */
+	for ( i = 0 ; i < content->info.segments ; i++ ) {
+		pseg = &content->segments[i];
+		if ( ( rc = peerdist_info_segment ( &content->info,
+						    &pseg->segment, i ) ) != 0 )
+			goto err;
+		for ( j = 0 ; j < pseg->segment.blocks ; j++ ) {
+			if ( ( rc = peerdist_info_block ( &pseg->segment,
+							  &block, j ) ) != 0 )
+				goto err;
+			if ( ( block.trim.start != block.range.start ) ||
+			     ( block.trim.end != block.range.end ) ||
+			     ( block.range.start == block.range.end ) )
+				continue;
+			if ( ! pseg->count )
+				pseg->first = j;
+			pseg->count++;
+		}
+	}
+
+	/* Start server */
+	if ( ( rc = peerserve_start() ) != 0 )
+		goto err;
+
+	/* Add to list of served content */
+	list_add_tail ( &content->list, &peerserve_contents );
+	DBGC ( content, "PEERSERVE %p serving \"%s\" (%d segments)\n",
+	       content, image->name, content->info.segments );
+
+	return;
+
+ err:
+	image_put ( content->image );
+	free ( content );
+}
+
+/**
+ * Shut down PeerDist content server
+ *
+ * @v booting		System is shutting down for OS boot
+ */
+static void peerserve_shutdown ( int booting __unused ) {
+	struct peerserve_content *content;
+	struct peerserve_content *tmp;
+
+	/* Stop server */
+	if ( peerserve.started ) {
+		tcp_unlisten ( &peerserve.listener );
+		intf_restart ( &peerserve.socket, 0 );
+		peerserve.started = 0;
+	}
+
+	/* Stop serving all content */
+	list_for_each_entry_safe ( content, tmp, &peerserve_contents, list )
+		peerserve_free ( content );
+}
+
+/** PeerDist content server shutdown function */
+struct startup_fn peerserve_startup_fn __startup_fn ( STARTUP_NORMAL ) = {
+	.name = "peerserve",
+	.shutdown = peerserve_shutdown,
+};
@@ -12,6 +12,7 @@
 #include <ipxe/refcnt.h>
 #include <ipxe/pending.h>
 #include <ipxe/xfer.h>
+#include <ipxe/xferbuf.h>
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
 #include <ipxe/netdevice.h>
@@ -20,6 +21,8 @@
 #include <ipxe/job.h>
 #include <ipxe/tcpip.h>
 #include <ipxe/tcp.h>
+#include <ipxe/timeline.h>
+#include <ipxe/metrics.h>
 
 /** @file
  *
@@ -35,6 +38,8 @@ struct tcp_connection {
 	struct refcnt refcnt;
 	/** List of TCP connections */
 	struct list_head list;
+	/** Hash chain of TCP connections sharing a local port hash */
+	struct list_head hash;
 
 	/** Flags */
 	unsigned int flags;
@@ -135,6 +140,8 @@ enum tcp_flags {
 	TCP_ACK_PENDING = 0x0004,
 	/** TCP selective acknowledgement is enabled */
 	TCP_SACK_ENABLED = 0x0008,
+	/** TCP connection was opened by a peer */
+	TCP_PASSIVE = 0x0010,
 };
 
 /** TCP internal header
@@ -158,8 +165,15 @@ struct tcp_rx_queued_header {
 	 * enqueued.
 	 */
 	uint8_t flags;
+	/** Data has been placed in the data transfer buffer
+	 *
+	 * If set, then the I/O buffer contains no data, since the
+	 * data has already been written directly to its final
+	 * location.
+	 */
+	uint8_t placed;
 	/** Reserved */
-	uint8_t reserved[3];
+	uint8_t reserved[2];
 };
 
 /**
@@ -167,6 +181,19 @@ struct tcp_rx_queued_header {
  */
 static LIST_HEAD ( tcp_conns );
 
+/** Number of TCP connection hash chains (must be a power of two) */
+#define TCP_HASH_SIZE 64
+
+/**
+ * TCP connections hashed by local port
+ */
+static struct list_head tcp_hash[TCP_HASH_SIZE];
+
+/**
+ * List of TCP listeners
+ */
+static LIST_HEAD ( tcp_listeners );
+
 /** Transmit profiler */
 static struct profiler tcp_tx_profiler __profiler = { .name = "tcp.tx" };
 
@@ -176,13 +203,20 @@ static struct profiler tcp_rx_profiler __profiler = { .name = "tcp.rx" };
 /** Data transfer profiler */
 static struct profiler tcp_xfer_profiler __profiler = { .name = "tcp.xfer" };
 
+/** Retransmission metric */
+static struct metric tcp_retransmit_metric __metric = {
+	.name = "tcp.retransmit",
+};
+
 /* Forward declarations */
 static struct process_descriptor tcp_process_desc;
 static struct interface_descriptor tcp_xfer_desc;
 static void tcp_expired ( struct retry_timer *timer, int over );
 static void tcp_keepalive_expired ( struct retry_timer *timer, int over );
 static void tcp_wait_expired ( struct retry_timer *timer, int over );
-static struct tcp_connection * tcp_demux ( unsigned int local_port );
+static void tcp_close ( struct tcp_connection *tcp, int rc );
+static struct tcp_connection * tcp_demux ( unsigned int local_port,
+					   struct sockaddr_tcpip *peer );
 static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 			uint32_t win );
 
@@ -251,6 +285,33 @@ tcp_dump_flags ( struct tcp_connection *tcp, unsigned int flags ) {
  ***************************************************************************
  */
 
+/**
+ * Get TCP connection hash chain
+ *
+ * @v local_port	Local port
+ * @ret chain		Hash chain
+ */
+static inline __attribute__ (( always_inline )) struct list_head *
+tcp_hash_chain ( unsigned int local_port ) {
+	return &tcp_hash[ local_port & ( TCP_HASH_SIZE - 1 ) ];
+}
+
+/**
+ * Find TCP listener
+ *
+ * @v local_port	Local port
+ * @ret listener	TCP listener, or NULL
+ */
+static struct tcp_listener * tcp_find_listener ( unsigned int local_port ) {
+	struct tcp_listener *listener;
+
+	list_for_each_entry ( listener, &tcp_listeners, list ) {
+		if ( listener->port == local_port )
+			return listener;
+	}
+	return NULL;
+}
+
 /**
  * Check if local TCP port is available
  *
@@ -259,24 +320,24 @@ tcp_dump_flags ( struct tcp_connection *tcp, unsigned int flags ) {
  */
 static int tcp_port_available ( int port ) {
 
-	return ( tcp_demux ( port ) ? -EADDRINUSE : port );
+	return ( ( tcp_demux ( port, NULL ) || tcp_find_listener ( port ) ) ?
+		 -EADDRINUSE : port );
 }
 
 /**
- * Open a TCP connection
+ * Create a TCP connection
  *
- * @v xfer		Data transfer interface
- * @v peer		Peer socket address
- * @v local		Local socket address, or NULL
+ * @v st_peer		Peer socket address
+ * @v tcp_out		TCP connection to fill in
  * @ret rc		Return status code
+ *
+ * The connection is created in SYN_SENT, without a local port and
+ * without being added to the list of connections.
  */
-static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
-		      struct sockaddr *local ) {
-	struct sockaddr_tcpip *st_peer = ( struct sockaddr_tcpip * ) peer;
-	struct sockaddr_tcpip *st_local = ( struct sockaddr_tcpip * ) local;
+static int tcp_create ( struct sockaddr_tcpip *st_peer,
+			struct tcp_connection **tcp_out ) {
 	struct tcp_connection *tcp;
 	size_t mtu;
-	int port;
 	int rc;
 
 	/* Allocate and initialise structure */
@@ -302,12 +363,40 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	mtu = tcpip_mtu ( &tcp->peer );
 	if ( ! mtu ) {
 		DBGC ( tcp, "TCP %p has no route to %s\n",
-		       tcp, sock_ntoa ( peer ) );
+		       tcp, sock_ntoa ( ( struct sockaddr * ) st_peer ) );
 		rc = -ENETUNREACH;
 		goto err;
 	}
 	tcp->mss = ( mtu - sizeof ( struct tcp_header ) );
 
+	*tcp_out = tcp;
+	return 0;
+
+ err:
+	ref_put ( &tcp->refcnt );
+	return rc;
+}
+
+/**
+ * Open a TCP connection
+ *
+ * @v xfer		Data transfer interface
+ * @v peer		Peer socket address
+ * @v local		Local socket address, or NULL
+ * @ret rc		Return status code
+ */
+static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
+		      struct sockaddr *local ) {
+	struct sockaddr_tcpip *st_peer = ( struct sockaddr_tcpip * ) peer;
+	struct sockaddr_tcpip *st_local = ( struct sockaddr_tcpip * ) local;
+	struct tcp_connection *tcp;
+	int port;
+	int rc;
+
+	/* Create connection */
+	if ( ( rc = tcp_create ( st_peer, &tcp ) ) != 0 )
+		return rc;
+
 	/* Bind to local port */
 	port = tcpip_bind ( st_local, tcp_port_available );
 	if ( port < 0 ) {
@@ -321,6 +410,7 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 
 	/* Start timer to initiate SYN */
 	start_timer_nodelay ( &tcp->timer );
+	timeline_begin ( "tcp", tcp );
 
 	/* Add a pending operation for the SYN */
 	pending_get ( &tcp->pending_flags );
@@ -330,6 +420,7 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	 */
 	intf_plug_plug ( &tcp->xfer, xfer );
 	list_add ( &tcp->list, &tcp_conns );
+	list_add ( &tcp->hash, tcp_hash_chain ( tcp->local_port ) );
 	return 0;
 
  err:
@@ -337,6 +428,94 @@ static int tcp_open ( struct interface *xfer, struct sockaddr *peer,
 	return rc;
 }
 
+/**
+ * Accept an incoming TCP connection
+ *
+ * @v local_port	Local port
+ * @v st_peer		Peer socket address
+ * @ret tcp		TCP connection, or NULL
+ *
+ * The new connection remains in SYN_SENT until the received SYN is
+ * processed, whereupon it will transition to SYN_RCVD and respond
+ * with SYN+ACK.
+ */
+static struct tcp_connection * tcp_accept ( unsigned int local_port,
+					    struct sockaddr_tcpip *st_peer ) {
+	struct tcp_listener *listener;
+	struct tcp_connection *tcp;
+	int rc;
+
+	/* Find listener */
+	listener = tcp_find_listener ( local_port );
+	if ( ! listener )
+		return NULL;
+
+	/* Create connection */
+	if ( ( rc = tcp_create ( st_peer, &tcp ) ) != 0 )
+		return NULL;
+	tcp->flags |= TCP_PASSIVE;
+	tcp->local_port = local_port;
+	DBGC ( tcp, "TCP %p accepted on port %d from %s:%d\n", tcp,
+	       tcp->local_port, sock_ntoa ( ( struct sockaddr * ) st_peer ),
+	       ntohs ( st_peer->st_port ) );
+
+	/* Add a pending operation for the SYN */
+	pending_get ( &tcp->pending_flags );
+
+	/* Transfer reference to connection list */
+	list_add ( &tcp->list, &tcp_conns );
+	list_add ( &tcp->hash, tcp_hash_chain ( tcp->local_port ) );
+
+	/* Notify listener */
+	if ( ( rc = listener->accept ( &tcp->xfer,
+				       ( struct sockaddr * ) &tcp->peer ) ) != 0){
+		DBGC ( tcp, "TCP %p was not accepted: %s\n",
+		       tcp, strerror ( rc ) );
+		tcp_close ( tcp, rc );
+		return NULL;
+	}
+
+	return tcp;
+}
+
+/**
+ * Start listening for incoming TCP connections
+ *
+ * @v listener		TCP listener
+ * @ret rc		Return status code
+ */
+int tcp_listen ( struct tcp_listener *listener ) {
+	int rc;
+
+	/* Check that port is not already in use */
+	if ( ( rc = tcp_port_available ( listener->port ) ) < 0 ) {
+		DBGC ( listener, "TCP %p could not listen on port %d: %s\n",
+		       listener, listener->port, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Add to list of listeners */
+	list_add ( &listener->list, &tcp_listeners );
+	DBGC ( listener, "TCP %p listening on port %d\n",
+	       listener, listener->port );
+
+	return 0;
+}
+
+/**
+ * Stop listening for incoming TCP connections
+ *
+ * @v listener		TCP listener
+ *
+ * Any previously accepted connections are unaffected.
+ */
+void tcp_unlisten ( struct tcp_listener *listener ) {
+
+	list_del ( &listener->list );
+	DBGC ( listener, "TCP %p stopped listening on port %d\n",
+	       listener, listener->port );
+}
+
 /**
  * Close TCP connection
  *
@@ -364,6 +543,10 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
 		tcp->tcp_state = TCP_CLOSED;
 		tcp_dump_state ( tcp );
 
+		/* Record failure to connect, if applicable */
+		if ( ! ( tcp->flags & TCP_PASSIVE ) )
+			timeline_end ( "tcp", tcp, rc );
+
 		/* Free any unprocessed I/O buffers */
 		list_for_each_entry_safe ( iobuf, tmp, &tcp->rx_queue, list ) {
 			list_del ( &iobuf->list );
@@ -388,6 +571,7 @@ static void tcp_close ( struct tcp_connection *tcp, int rc ) {
 		stop_timer ( &tcp->keepalive );
 		stop_timer ( &tcp->wait );
 		list_del ( &tcp->list );
+		list_del ( &tcp->hash );
 		ref_put ( &tcp->refcnt );
 		DBGC ( tcp, "TCP %p connection deleted\n", tcp );
 		return;
@@ -557,28 +741,38 @@ static unsigned int tcp_sack ( struct tcp_connection *tcp, uint32_t seq ) {
  * @v tcp		TCP connection
  * @v max_len		Maximum length to process
  * @v dest		I/O buffer to fill with data, or NULL
+ * @v csum		Checksum of data copied to @c dest (if provided)
  * @v remove		Remove data from queue
  * @ret len		Length of data processed
  *
  * This processes at most @c max_len bytes from the TCP connection's
  * transmit queue.  Data will be copied into the @c dest I/O buffer
  * (if provided) and, if @c remove is true, removed from the transmit
- * queue.
+ * queue.  If @c dest is provided then @c csum must also be provided,
+ * and will be filled in with the checksum of the copied data
+ * (calculated as part of the copy).
  */
 static size_t tcp_process_tx_queue ( struct tcp_connection *tcp, size_t max_len,
-				     struct io_buffer *dest, int remove ) {
+				     struct io_buffer *dest, uint16_t *csum,
+				     int remove ) {
 	struct io_buffer *iobuf;
 	struct io_buffer *tmp;
 	size_t frag_len;
 	size_t len = 0;
+	uint16_t frag_sum;
 
+	if ( dest )
+		*csum = TCPIP_EMPTY_CSUM;
 	list_for_each_entry_safe ( iobuf, tmp, &tcp->tx_queue, list ) {
 		frag_len = iob_len ( iobuf );
 		if ( frag_len > max_len )
 			frag_len = max_len;
 		if ( dest ) {
-			memcpy ( iob_put ( dest, frag_len ), iobuf->data,
-				 frag_len );
+			frag_sum = tcpip_copy_chksum ( TCPIP_EMPTY_CSUM,
+						       iob_put ( dest,
+								 frag_len ),
+						       iobuf->data, frag_len );
+			*csum = tcpip_combine_chksum ( *csum, frag_sum, len );
 		}
 		if ( remove ) {
 			iob_pull ( iobuf, frag_len );
@@ -616,6 +810,7 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	struct tcp_sack_padded_option *sackopt;
 	struct tcp_sack_block *sack;
 	void *payload;
+	uint16_t payload_csum;
 	unsigned int flags;
 	unsigned int sack_count;
 	unsigned int i;
@@ -624,6 +819,8 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	uint32_t seq_len;
 	uint32_t max_rcv_win;
 	uint32_t max_representable_win;
+	unsigned int win_scale;
+	int offer;
 	int rc;
 
 	/* Start profiling */
@@ -638,7 +835,7 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	 */
 	if ( TCP_CAN_SEND_DATA ( tcp->tcp_state ) ) {
 		len = tcp_process_tx_queue ( tcp, tcp_xmit_win ( tcp ),
-					     NULL, 0 );
+					     NULL, NULL, 0 );
 	}
 	seq_len = len;
 	flags = TCP_FLAGS_SENDING ( tcp->tcp_state );
@@ -672,37 +869,47 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	iob_reserve ( iobuf, TCP_MAX_HEADER_LEN );
 
 	/* Fill data payload from transmit queue */
-	tcp_process_tx_queue ( tcp, len, iobuf, 0 );
+	tcp_process_tx_queue ( tcp, len, iobuf, &payload_csum, 0 );
 
 	/* Expand receive window if possible */
 	max_rcv_win = xfer_window ( &tcp->xfer );
 	if ( max_rcv_win > TCP_MAX_WINDOW_SIZE )
 		max_rcv_win = TCP_MAX_WINDOW_SIZE;
-	max_representable_win = ( 0xffff << tcp->rcv_win_scale );
+	win_scale = ( ( flags & TCP_SYN ) ? 0 : tcp->rcv_win_scale );
+	max_representable_win = ( 0xffff << win_scale );
 	if ( max_rcv_win > max_representable_win )
 		max_rcv_win = max_representable_win;
 	max_rcv_win &= ~0x03; /* Keep everything dword-aligned */
 	if ( tcp->rcv_win < max_rcv_win )
 		tcp->rcv_win = max_rcv_win;
 
-	/* Fill up the TCP header */
+	/* Fill up the TCP header.  A SYN sent in response to a
+	 * received SYN may include only those options which were
+	 * offered by the peer.
+	 */
 	payload = iobuf->data;
+	offer = ( ( flags & TCP_SYN ) && ! ( tcp->flags & TCP_PASSIVE ) );
 	if ( flags & TCP_SYN ) {
 		mssopt = iob_push ( iobuf, sizeof ( *mssopt ) );
 		mssopt->kind = TCP_OPTION_MSS;
 		mssopt->length = sizeof ( *mssopt );
 		mssopt->mss = htons ( tcp->mss );
+	}
+	if ( offer || ( ( flags & TCP_SYN ) && tcp->rcv_win_scale ) ) {
 		wsopt = iob_push ( iobuf, sizeof ( *wsopt ) );
 		wsopt->nop = TCP_OPTION_NOP;
 		wsopt->wsopt.kind = TCP_OPTION_WS;
 		wsopt->wsopt.length = sizeof ( wsopt->wsopt );
 		wsopt->wsopt.scale = TCP_RX_WINDOW_SCALE;
+	}
+	if ( offer || ( ( flags & TCP_SYN ) &&
+			( tcp->flags & TCP_SACK_ENABLED ) ) ) {
 		spopt = iob_push ( iobuf, sizeof ( *spopt ) );
 		memset ( spopt->nop, TCP_OPTION_NOP, sizeof ( spopt->nop ) );
 		spopt->spopt.kind = TCP_OPTION_SACK_PERMITTED;
 		spopt->spopt.length = sizeof ( spopt->spopt );
 	}
-	if ( ( flags & TCP_SYN ) || ( tcp->flags & TCP_TS_ENABLED ) ) {
+	if ( offer || ( tcp->flags & TCP_TS_ENABLED ) ) {
 		tsopt = iob_push ( iobuf, sizeof ( *tsopt ) );
 		memset ( tsopt->nop, TCP_OPTION_NOP, sizeof ( tsopt->nop ) );
 		tsopt->tsopt.kind = TCP_OPTION_TS;
@@ -735,8 +942,9 @@ static void tcp_xmit_sack ( struct tcp_connection *tcp, uint32_t sack_seq ) {
 	tcphdr->ack = htonl ( tcp->rcv_ack );
 	tcphdr->hlen = ( ( payload - iobuf->data ) << 2 );
 	tcphdr->flags = flags;
-	tcphdr->win = htons ( tcp->rcv_win >> tcp->rcv_win_scale );
-	tcphdr->csum = tcpip_chksum ( iobuf->data, iob_len ( iobuf ) );
+	tcphdr->win = htons ( tcp->rcv_win >> win_scale );
+	tcphdr->csum = tcpip_continue_chksum ( payload_csum, iobuf->data,
+					       ( payload - iobuf->data ) );
 
 	/* Dump header */
 	DBGC2 ( tcp, "TCP %p TX %d->%d %08x..%08x           %08x %4zd",
@@ -805,7 +1013,11 @@ static void tcp_expired ( struct retry_timer *timer, int over ) {
 		tcp_dump_state ( tcp );
 		tcp_close ( tcp, -ETIMEDOUT );
 	} else {
-		/* Otherwise, retransmit the packet */
+		/* Otherwise, retransmit the packet (or transmit the
+		 * initial SYN, if nothing has yet been sent)
+		 */
+		if ( tcp->snd_sent )
+			metric_inc ( &tcp_retransmit_metric );
 		tcp_xmit ( tcp );
 	}
 }
@@ -924,14 +1136,26 @@ static int tcp_xmit_reset ( struct tcp_connection *tcp,
  * Identify TCP connection by local port number
  *
  * @v local_port	Local port
+ * @v peer		Peer socket address, or NULL to match any peer
  * @ret tcp		TCP connection, or NULL
+ *
+ * Connections accepted from a listener share the listener's local
+ * port, and so must also be identified by the peer socket address.
  */
-static struct tcp_connection * tcp_demux ( unsigned int local_port ) {
+static struct tcp_connection * tcp_demux ( unsigned int local_port,
+					   struct sockaddr_tcpip *peer ) {
 	struct tcp_connection *tcp;
 
-	list_for_each_entry ( tcp, &tcp_conns, list ) {
-		if ( tcp->local_port == local_port )
-			return tcp;
+	list_for_each_entry ( tcp, tcp_hash_chain ( local_port ), hash ) {
+		if ( tcp->local_port != local_port )
+			continue;
+		if ( peer && ( tcp->flags & TCP_PASSIVE ) &&
+		     ( ( tcp->peer.st_family != peer->st_family ) ||
+		       ( tcp->peer.st_port != peer->st_port ) ||
+		       ( memcmp ( tcp->peer.pad, peer->pad,
+				  sizeof ( tcp->peer.pad ) ) != 0 ) ) )
+			continue;
+		return tcp;
 	}
 	return NULL;
 }
@@ -1082,6 +1306,8 @@ static int tcp_rx_syn ( struct tcp_connection *tcp, uint32_t seq,
 			tcp->snd_win_scale = options->wsopt->scale;
 			tcp->rcv_win_scale = TCP_RX_WINDOW_SCALE;
 		}
+		if ( ! ( tcp->flags & TCP_PASSIVE ) )
+			timeline_end ( "tcp", tcp, 0 );
 		DBGC ( tcp, "TCP %p using %stimestamps, %sSACK, TX window "
 		       "x%d, RX window x%d\n", tcp,
 		       ( ( tcp->flags & TCP_TS_ENABLED ) ? "" : "no " ),
@@ -1170,7 +1396,7 @@ static int tcp_rx_ack ( struct tcp_connection *tcp, uint32_t ack,
 	tcp->snd_sent = 0;
 
 	/* Remove any acknowledged data from transmit queue */
-	tcp_process_tx_queue ( tcp, len, NULL, 1 );
+	tcp_process_tx_queue ( tcp, len, NULL, NULL, 1 );
 		
 	/* Mark SYN/FIN as acknowledged if applicable. */
 	if ( acked_flags )
@@ -1228,6 +1454,49 @@ static int tcp_rx_data ( struct tcp_connection *tcp, uint32_t seq,
 	return 0;
 }
 
+/**
+ * Handle TCP received data that has already been placed
+ *
+ * @v tcp		TCP connection
+ * @v seq		SEQ value (in host-endian order)
+ * @v len		Length of placed data
+ * @v iobuf		Empty I/O buffer
+ * @ret rc		Return status code
+ *
+ * This function takes ownership of the I/O buffer.
+ */
+static int tcp_rx_placed ( struct tcp_connection *tcp, uint32_t seq,
+			   uint32_t len, struct io_buffer *iobuf ) {
+	struct xfer_metadata meta;
+	uint32_t already_rcvd;
+	int rc;
+
+	/* Ignore duplicate data */
+	already_rcvd = ( tcp->rcv_ack - seq );
+	if ( already_rcvd >= len ) {
+		free_iob ( iobuf );
+		return 0;
+	}
+	len -= already_rcvd;
+
+	/* Acknowledge new data */
+	tcp_rx_seq ( tcp, len );
+
+	/* Notify application that data is present */
+	memset ( &meta, 0, sizeof ( meta ) );
+	meta.flags = XFER_FL_PLACED;
+	meta.offset = len;
+	if ( ( rc = xfer_deliver ( &tcp->xfer, iobuf, &meta ) ) != 0 ) {
+		DBGC ( tcp, "TCP %p could not deliver placed %08x..%08x: "
+		       "%s\n", tcp, ( seq + already_rcvd ),
+		       ( seq + already_rcvd + len ),
+		       strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
 /**
  * Handle TCP received FIN
  *
@@ -1284,6 +1553,59 @@ static int tcp_rx_rst ( struct tcp_connection *tcp, uint32_t seq ) {
 	return -ECONNRESET;
 }
 
+/**
+ * Place out-of-order received data directly into data transfer buffer
+ *
+ * @v tcp		TCP connection
+ * @v seq		SEQ value (in host-endian order)
+ * @v iobuf		I/O buffer
+ * @ret placeholder	Empty placeholder I/O buffer, or NULL
+ *
+ * An out-of-order packet would otherwise hold on to a full-sized
+ * receive buffer until the preceding gap is filled.  If the data
+ * transfer interface exposes a buffer into which the received
+ * stream maps directly, then copy the data straight to its final
+ * location so that the receive buffer can be freed immediately.
+ */
+static struct io_buffer * tcp_rx_place ( struct tcp_connection *tcp,
+					 uint32_t seq,
+					 struct io_buffer *iobuf ) {
+	struct xfer_buffer *xferbuf;
+	struct io_buffer *placeholder;
+	size_t len = iob_len ( iobuf );
+	size_t offset;
+
+	/* Get underlying data transfer buffer, if any */
+	xferbuf = xfer_buffer ( &tcp->xfer );
+	if ( ! xferbuf )
+		return NULL;
+
+	/* The data transfer buffer position corresponds to the
+	 * current acknowledgement number, since all data up to that
+	 * point has already been delivered.  Place data only within
+	 * the existing buffer, to avoid any reallocation.
+	 */
+	offset = ( xferbuf->pos + ( seq - tcp->rcv_ack ) );
+	if ( ( offset > xferbuf->len ) || ( len > ( xferbuf->len - offset ) ) )
+		return NULL;
+
+	/* Allocate placeholder, with room for the internal header */
+	placeholder = alloc_iob ( sizeof ( struct tcp_rx_queued_header ) );
+	if ( ! placeholder )
+		return NULL;
+	iob_reserve ( placeholder, sizeof ( struct tcp_rx_queued_header ) );
+
+	/* Place data */
+	if ( xferbuf_write ( xferbuf, offset, iobuf->data, len ) != 0 ) {
+		free_iob ( placeholder );
+		return NULL;
+	}
+	DBGC2 ( tcp, "TCP %p placed %08x..%08x at %#zx\n",
+		tcp, seq, ( seq + ( uint32_t ) len ), offset );
+
+	return placeholder;
+}
+
 /**
  * Enqueue received TCP packet
  *
@@ -1295,10 +1617,12 @@ static int tcp_rx_rst ( struct tcp_connection *tcp, uint32_t seq ) {
 static void tcp_rx_enqueue ( struct tcp_connection *tcp, uint32_t seq,
 			     uint8_t flags, struct io_buffer *iobuf ) {
 	struct tcp_rx_queued_header *tcpqhdr;
+	struct io_buffer *placeholder;
 	struct io_buffer *queued;
 	size_t len;
 	uint32_t seq_len;
 	uint32_t nxt;
+	int placed = 0;
 
 	/* Calculate remaining flags and sequence length.  Note that
 	 * SYN, if present, has already been processed by this point.
@@ -1323,11 +1647,20 @@ static void tcp_rx_enqueue ( struct tcp_connection *tcp, uint32_t seq,
 		return;
 	}
 
+	/* Place out-of-order data directly, if possible */
+	if ( len && ( tcp_cmp ( seq, tcp->rcv_ack ) > 0 ) &&
+	     ( ( placeholder = tcp_rx_place ( tcp, seq, iobuf ) ) != NULL ) ) {
+		free_iob ( iobuf );
+		iobuf = placeholder;
+		placed = 1;
+	}
+
 	/* Add internal header */
 	tcpqhdr = iob_push ( iobuf, sizeof ( *tcpqhdr ) );
 	tcpqhdr->seq = seq;
 	tcpqhdr->nxt = nxt;
 	tcpqhdr->flags = flags;
+	tcpqhdr->placed = placed;
 
 	/* Add to RX queue */
 	list_for_each_entry ( queued, &tcp->rx_queue, list ) {
@@ -1349,6 +1682,7 @@ static void tcp_process_rx_queue ( struct tcp_connection *tcp ) {
 	uint32_t seq;
 	unsigned int flags;
 	size_t len;
+	int placed;
 
 	/* Process all applicable received buffers.  Note that we
 	 * cannot use list_for_each_entry() to iterate over the RX
@@ -1367,11 +1701,16 @@ static void tcp_process_rx_queue ( struct tcp_connection *tcp ) {
 		list_del ( &iobuf->list );
 		seq = tcpqhdr->seq;
 		flags = tcpqhdr->flags;
+		placed = tcpqhdr->placed;
+		len = ( tcpqhdr->nxt - seq - ( ( flags & TCP_FIN ) ? 1 : 0 ) );
 		iob_pull ( iobuf, sizeof ( *tcpqhdr ) );
-		len = iob_len ( iobuf );
 
 		/* Handle new data, if any */
-		tcp_rx_data ( tcp, seq, iob_disown ( iobuf ) );
+		if ( placed ) {
+			tcp_rx_placed ( tcp, seq, len, iob_disown ( iobuf ) );
+		} else {
+			tcp_rx_data ( tcp, seq, iob_disown ( iobuf ) );
+		}
 		seq += len;
 
 		/* Handle FIN, if present */
@@ -1382,6 +1721,42 @@ static void tcp_process_rx_queue ( struct tcp_connection *tcp ) {
 	}
 }
 
+/**
+ * Verify checksum of received packet
+ *
+ * @v iobuf		I/O buffer (may be replaced)
+ * @v hlen		Length of TCP header
+ * @v pshdr_csum	Pseudo-header checksum
+ * @ret csum		Checksum (zero if correct)
+ *
+ * A small segment carrying data may have been received into a
+ * full-sized buffer, and may then sit on the receive queue for some
+ * time.  Such segments are copied into an appropriately sized buffer
+ * as part of the checksum calculation, which has to read every byte
+ * anyway.
+ */
+static uint16_t tcp_rx_chksum ( struct io_buffer **iobuf, size_t hlen,
+				uint16_t pshdr_csum ) {
+	struct io_buffer *compact;
+	size_t len = iob_len ( *iobuf );
+	size_t size = ( (*iobuf)->end - (*iobuf)->head );
+	uint16_t csum;
+
+	/* Verify checksum in place unless compaction is worthwhile */
+	if ( ( len == hlen ) || ( ( len * TCP_RX_COMPACT_RATIO ) >= size ) ||
+	     ( ( compact = alloc_iob ( len ) ) == NULL ) ) {
+		return tcpip_continue_chksum ( pshdr_csum, (*iobuf)->data,
+					       len );
+	}
+
+	/* Copy and verify checksum in a single pass */
+	csum = tcpip_copy_chksum ( pshdr_csum, iob_put ( compact, len ),
+				   (*iobuf)->data, len );
+	free_iob ( *iobuf );
+	*iobuf = compact;
+	return csum;
+}
+
 /**
  * Process received packet
  *
@@ -1435,8 +1810,8 @@ static int tcp_rx ( struct io_buffer *iobuf,
 		rc = -EINVAL;
 		goto discard;
 	}
-	csum = tcpip_continue_chksum ( pshdr_csum, iobuf->data,
-				       iob_len ( iobuf ) );
+	csum = tcp_rx_chksum ( &iobuf, hlen, pshdr_csum );
+	tcphdr = iobuf->data;
 	if ( csum != 0 ) {
 		DBG ( "TCP checksum incorrect (is %04x including checksum "
 		      "field, should be 0000)\n", csum );
@@ -1445,13 +1820,18 @@ static int tcp_rx ( struct io_buffer *iobuf,
 	}
 	
 	/* Parse parameters from header and strip header */
-	tcp = tcp_demux ( ntohs ( tcphdr->dest ) );
+	st_src->st_port = tcphdr->src;
+	tcp = tcp_demux ( ntohs ( tcphdr->dest ), st_src );
 	seq = ntohl ( tcphdr->seq );
 	ack = ntohl ( tcphdr->ack );
 	raw_win = ntohs ( tcphdr->win );
 	flags = tcphdr->flags;
 	if ( ( rc = tcp_rx_opts ( tcp, tcphdr, hlen, &options ) ) != 0 )
 		goto discard;
+	if ( ( ! tcp ) &&
+	     ( ( flags & ( TCP_SYN | TCP_ACK | TCP_RST ) ) == TCP_SYN ) ) {
+		tcp = tcp_accept ( ntohs ( tcphdr->dest ), st_src );
+	}
 	if ( tcp && options.tsopt )
 		tcp->ts_val = ntohl ( options.tsopt->tsval );
 	iob_pull ( iobuf, hlen );
@@ -1659,6 +2039,22 @@ struct startup_fn tcp_startup_fn __startup_fn ( STARTUP_LATE ) = {
 	.shutdown = tcp_shutdown,
 };
 
+/**
+ * Initialise TCP
+ *
+ */
+static void tcp_init ( void ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < TCP_HASH_SIZE ; i++ )
+		INIT_LIST_HEAD ( &tcp_hash[i] );
+}
+
+/** TCP initialisation function */
+struct init_fn tcp_init_fn __init_fn ( INIT_NORMAL ) = {
+	.initialise = tcp_init,
+};
+
 /***************************************************************************
  *
  * Data transfer interface
@@ -38,6 +38,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/uri.h>
 #include <ipxe/timer.h>
 #include <ipxe/xfer.h>
+#include <ipxe/xferbuf.h>
 #include <ipxe/open.h>
 #include <ipxe/pool.h>
 #include <ipxe/http.h>
@@ -140,6 +141,19 @@ static int http_conn_socket_deliver ( struct http_connection *conn,
 	return xfer_deliver ( &conn->xfer, iobuf, meta );
 }
 
+/**
+ * Get underlying data transfer buffer
+ *
+ * @v conn		HTTP connection
+ * @ret xferbuf		Data transfer buffer, or NULL on error
+ */
+static struct xfer_buffer *
+http_conn_socket_buffer ( struct http_connection *conn ) {
+
+	/* Hand off to data transfer interface */
+	return xfer_buffer ( &conn->xfer );
+}
+
 /**
  * Close HTTP connection transport layer interface
  *
@@ -200,6 +214,8 @@ static void http_conn_xfer_close ( struct http_connection *conn, int rc ) {
 static struct interface_operation http_conn_socket_operations[] = {
 	INTF_OP ( xfer_deliver, struct http_connection *,
 		  http_conn_socket_deliver ),
+	INTF_OP ( xfer_buffer, struct http_connection *,
+		  http_conn_socket_buffer ),
 	INTF_OP ( intf_close, struct http_connection *,
 		  http_conn_socket_close ),
 };
@@ -388,11 +388,24 @@ static void http_step ( struct http_transaction *http ) {
  */
 static int http_conn_deliver ( struct http_transaction *http,
 			       struct io_buffer *iobuf,
-			       struct xfer_metadata *meta __unused ) {
+			       struct xfer_metadata *meta ) {
 	int rc;
 
 	/* Handle received data */
 	profile_start ( &http_rx_profiler );
+
+	/* Handle data placed directly into data transfer buffer */
+	if ( meta->flags & XFER_FL_PLACED ) {
+		if ( ( ! http->state ) || ( ! http->state->placed ) ) {
+			DBGC ( http, "HTTP %p unexpected placed data\n", http );
+			rc = -EPROTO_UNSOLICITED;
+			goto err;
+		}
+		if ( ( rc = http->state->placed ( http, iob_disown ( iobuf ),
+						  meta ) ) != 0 )
+			goto err;
+	}
+
 	while ( iobuf && iob_len ( iobuf ) ) {
 
 		/* Sanity check */
@@ -487,6 +500,30 @@ http_content_buffer ( struct http_transaction *http ) {
 	return xfer_buffer ( &http->xfer );
 }
 
+/**
+ * Get data transfer buffer for received data
+ *
+ * @v http		HTTP transaction
+ * @ret xferbuf		Data transfer buffer, or NULL on error
+ *
+ * The server connection may write received data directly to the
+ * data transfer buffer only while that data maps directly onto the
+ * content, i.e. while in a state that can accept placed data, with
+ * a known content length and no content encoding.
+ */
+static struct xfer_buffer *
+http_conn_buffer ( struct http_transaction *http ) {
+
+	/* Deny access unless received data maps directly onto content */
+	if ( ( ! http->state ) || ( ! http->state->placed ) ||
+	     ( ! ( http->response.flags & HTTP_RESPONSE_CONTENT_LEN ) ) ||
+	     http->response.content.encoding )
+		return NULL;
+
+	/* Hand off to content-decoded interface */
+	return http_content_buffer ( http );
+}
+
 /**
  * Read from block device (when HTTP block device support is not present)
  *
@@ -559,6 +596,7 @@ static struct interface_descriptor http_transfer_desc =
 /** HTTP server connection interface operations */
 static struct interface_operation http_conn_operations[] = {
 	INTF_OP ( xfer_deliver, struct http_transaction *, http_conn_deliver ),
+	INTF_OP ( xfer_buffer, struct http_transaction *, http_conn_buffer ),
 	INTF_OP ( xfer_window_changed, struct http_transaction *, http_step ),
 	INTF_OP ( pool_reopen, struct http_transaction *, http_reopen ),
 	INTF_OP ( intf_close, struct http_transaction *, http_conn_close ),
@@ -1541,15 +1579,18 @@ static int http_init_transfer_identity ( struct http_transaction *http ) {
 }
 
 /**
- * Handle received data
+ * Hand off received data to content encoding
  *
  * @v http		HTTP transaction
- * @v iobuf		I/O buffer (may be claimed)
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @v len		Length of received data
  * @ret rc		Return status code
  */
-static int http_rx_transfer_identity ( struct http_transaction *http,
-				       struct io_buffer **iobuf ) {
-	size_t len = iob_len ( *iobuf );
+static int http_deliver_transfer_identity ( struct http_transaction *http,
+					    struct io_buffer *iobuf,
+					    struct xfer_metadata *meta,
+					    size_t len ) {
 	int rc;
 
 	/* Update lengths */
@@ -1561,12 +1602,12 @@ static int http_rx_transfer_identity ( struct http_transaction *http,
 	if ( ( http->response.flags & HTTP_RESPONSE_CONTENT_LEN ) &&
 	     ( http->len > http->response.content.len ) ) {
 		DBGC ( http, "HTTP %p content length overrun\n", http );
+		free_iob ( iobuf );
 		return -EIO_CONTENT_LENGTH;
 	}
 
 	/* Hand off to content encoding */
-	if ( ( rc = xfer_deliver_iob ( &http->transfer,
-				       iob_disown ( *iobuf ) ) ) != 0 )
+	if ( ( rc = xfer_deliver ( &http->transfer, iobuf, meta ) ) != 0 )
 		return rc;
 
 	/* Complete transfer if we have received the expected content
@@ -1580,6 +1621,39 @@ static int http_rx_transfer_identity ( struct http_transaction *http,
 	return 0;
 }
 
+/**
+ * Handle received data
+ *
+ * @v http		HTTP transaction
+ * @v iobuf		I/O buffer (may be claimed)
+ * @ret rc		Return status code
+ */
+static int http_rx_transfer_identity ( struct http_transaction *http,
+				       struct io_buffer **iobuf ) {
+	struct xfer_metadata meta;
+	size_t len = iob_len ( *iobuf );
+
+	memset ( &meta, 0, sizeof ( meta ) );
+	return http_deliver_transfer_identity ( http, iob_disown ( *iobuf ),
+						&meta, len );
+}
+
+/**
+ * Handle received data placed directly into data transfer buffer
+ *
+ * @v http		HTTP transaction
+ * @v iobuf		Empty I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int http_placed_transfer_identity ( struct http_transaction *http,
+					   struct io_buffer *iobuf,
+					   struct xfer_metadata *meta ) {
+
+	return http_deliver_transfer_identity ( http, iobuf, meta,
+						meta->offset );
+}
+
 /**
  * Handle server connection close
  *
@@ -1619,6 +1693,7 @@ static struct http_transfer_encoding http_transfer_identity = {
 	.init = http_init_transfer_identity,
 	.state = {
 		.rx = http_rx_transfer_identity,
+		.placed = http_placed_transfer_identity,
 		.close = http_close_transfer_identity,
 	},
 };
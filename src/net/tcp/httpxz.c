@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/**
+ * @file
+ *
+ * Hyper Text Transfer Protocol (HTTP) xz content encoding
+ *
+ */
+
+#include <ipxe/http.h>
+#include <ipxe/inflate.h>
+#include <ipxe/xz.h>
+
+/**
+ * Check whether or not to support xz content for this request
+ *
+ * @v http		HTTP transaction
+ * @ret supported	xz content is supported for this request
+ */
+static int http_xz_supported ( struct http_transaction *http ) {
+
+	/* Do not request compression for range requests */
+	return ( http->request.range.len == 0 );
+}
+
+/**
+ * Initialise xz content encoding
+ *
+ * @v http		HTTP transaction
+ * @ret rc		Return status code
+ */
+static int http_xz_init ( struct http_transaction *http ) {
+
+	return inflate_filter ( &http->content, &http->transfer,
+				&xz_algorithm );
+}
+
+/** xz HTTP content encoding */
+struct http_content_encoding http_xz_encoding __http_content_encoding = {
+	.name = "xz",
+	.supported = http_xz_supported,
+	.init = http_xz_init,
+};
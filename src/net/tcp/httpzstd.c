@@ -0,0 +1,66 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/**
+ * @file
+ *
+ * Hyper Text Transfer Protocol (HTTP) zstd content encoding
+ *
+ */
+
+#include <ipxe/http.h>
+#include <ipxe/inflate.h>
+#include <ipxe/zstd.h>
+
+/**
+ * Check whether or not to support zstd content for this request
+ *
+ * @v http		HTTP transaction
+ * @ret supported	zstd content is supported for this request
+ */
+static int http_zstd_supported ( struct http_transaction *http ) {
+
+	/* Do not request compression for range requests */
+	return ( http->request.range.len == 0 );
+}
+
+/**
+ * Initialise zstd content encoding
+ *
+ * @v http		HTTP transaction
+ * @ret rc		Return status code
+ */
+static int http_zstd_init ( struct http_transaction *http ) {
+
+	return inflate_filter ( &http->content, &http->transfer,
+				&zstd_algorithm );
+}
+
+/** zstd HTTP content encoding */
+struct http_content_encoding http_zstd_encoding __http_content_encoding = {
+	.name = "zstd",
+	.supported = http_zstd_supported,
+	.init = http_zstd_init,
+};
@@ -149,6 +149,128 @@ size_t tcpip_mtu ( struct sockaddr_tcpip *st_dest ) {
 	return mtu;
 }
 
+/** Number of bytes summed in each iteration of the unrolled loop */
+#define TCPIP_CHKSUM_BLOCK 32
+
+/**
+ * Sum (and optionally copy) a 32-bit word within the unrolled loop
+ *
+ * @v i			Word index
+ */
+#define TCPIP_SUM_WORD( i ) do {					\
+	memcpy ( &word, ( bytes + ( 4 * (i) ) ), 4 );			\
+	sum += word;							\
+	if ( copy )							\
+		memcpy ( ( copy + ( 4 * (i) ) ), &word, 4 );		\
+	} while ( 0 )
+
+/**
+ * Calculate (and optionally copy) continued TCP/IP checksum
+ *
+ * @v partial		Checksum of already-summed data, in network byte order
+ * @v dest		Destination buffer, or NULL
+ * @v src		Data buffer
+ * @v len		Length of data buffer
+ * @ret cksum		Updated checksum, in network byte order
+ *
+ * Data is summed as 32-bit words into a 64-bit accumulator, so that
+ * carries need to be folded only once at the end.  If the data starts
+ * on an odd address then the sum is calculated over byte-swapped
+ * words and swapped back afterwards.
+ */
+static inline __attribute__ (( always_inline )) uint16_t
+tcpip_sum ( uint16_t partial, void *dest, const void *src, size_t len ) {
+	const uint8_t *bytes = src;
+	uint8_t *copy = dest;
+	uint64_t sum = 0;
+	uint32_t word;
+	uint16_t half;
+	unsigned int odd;
+
+	/* Sum any initial odd byte into the upper half of a word */
+	odd = ( ( ( intptr_t ) bytes ) & 1 );
+	if ( odd && len ) {
+		sum = be16_to_cpu ( *bytes );
+		if ( copy )
+			*(copy++) = *bytes;
+		bytes++;
+		len--;
+	}
+
+	/* Sum any initial 16-bit word to reach 32-bit alignment */
+	if ( ( ( ( intptr_t ) bytes ) & 2 ) && ( len >= 2 ) ) {
+		memcpy ( &half, bytes, 2 );
+		sum += half;
+		if ( copy ) {
+			memcpy ( copy, &half, 2 );
+			copy += 2;
+		}
+		bytes += 2;
+		len -= 2;
+	}
+
+	/* Sum 32-bit words, unrolled */
+	while ( len >= TCPIP_CHKSUM_BLOCK ) {
+		TCPIP_SUM_WORD ( 0 );
+		TCPIP_SUM_WORD ( 1 );
+		TCPIP_SUM_WORD ( 2 );
+		TCPIP_SUM_WORD ( 3 );
+		TCPIP_SUM_WORD ( 4 );
+		TCPIP_SUM_WORD ( 5 );
+		TCPIP_SUM_WORD ( 6 );
+		TCPIP_SUM_WORD ( 7 );
+		if ( copy )
+			copy += TCPIP_CHKSUM_BLOCK;
+		bytes += TCPIP_CHKSUM_BLOCK;
+		len -= TCPIP_CHKSUM_BLOCK;
+	}
+
+	/* Sum remaining 32-bit words */
+	while ( len >= 4 ) {
+		memcpy ( &word, bytes, 4 );
+		sum += word;
+		if ( copy ) {
+			memcpy ( copy, &word, 4 );
+			copy += 4;
+		}
+		bytes += 4;
+		len -= 4;
+	}
+
+	/* Sum any remaining 16-bit word */
+	if ( len >= 2 ) {
+		memcpy ( &half, bytes, 2 );
+		sum += half;
+		if ( copy ) {
+			memcpy ( copy, &half, 2 );
+			copy += 2;
+		}
+		bytes += 2;
+		len -= 2;
+	}
+
+	/* Sum any final byte into the lower half of a word */
+	if ( len ) {
+		sum += le16_to_cpu ( *bytes );
+		if ( copy )
+			*copy = *bytes;
+	}
+
+	/* Fold down to 16 bits, undo any byte swapping, and add in
+	 * the existing partial checksum
+	 */
+	sum = ( ( sum & 0xffffffffUL ) + ( sum >> 32 ) );
+	sum = ( ( sum & 0xffffffffUL ) + ( sum >> 32 ) );
+	sum = ( ( sum & 0xffff ) + ( sum >> 16 ) );
+	sum = ( ( sum & 0xffff ) + ( sum >> 16 ) );
+	if ( odd )
+		sum = bswap_16 ( sum );
+	sum += ( ( ~partial ) & 0xffff );
+	sum = ( ( sum & 0xffff ) + ( sum >> 16 ) );
+
+	return ( ~sum );
+}
+
 /**
  * Calculate continued TCP/IP checkum
  *
@@ -169,25 +291,26 @@ size_t tcpip_mtu ( struct sockaddr_tcpip *st_dest ) {
  */
 uint16_t generic_tcpip_continue_chksum ( uint16_t partial,
 					 const void *data, size_t len ) {
-	unsigned int cksum = ( ( ~partial ) & 0xffff );
-	unsigned int value;
-	unsigned int i;
-	
-	for ( i = 0 ; i < len ; i++ ) {
-		value = * ( ( uint8_t * ) data + i );
-		if ( i & 1 ) {
-			/* Odd bytes: swap on little-endian systems */
-			value = be16_to_cpu ( value );
-		} else {
-			/* Even bytes: swap on big-endian systems */
-			value = le16_to_cpu ( value );
-		}
-		cksum += value;
-		if ( cksum > 0xffff )
-			cksum -= 0xffff;
-	}
-	
-	return ( ~cksum );
+
+	return tcpip_sum ( partial, NULL, data, len );
+}
+
+/**
+ * Copy data and calculate continued TCP/IP checksum
+ *
+ * @v partial		Checksum of already-summed data, in network byte order
+ * @v dest		Destination buffer
+ * @v src		Source buffer
+ * @v len		Length of data
+ * @ret cksum		Updated checksum, in network byte order
+ *
+ * Copies the data and calculates the checksum in a single pass, with
+ * the same semantics as generic_tcpip_continue_chksum().
+ */
+uint16_t generic_tcpip_copy_chksum ( uint16_t partial, void *dest,
+				     const void *src, size_t len ) {
+
+	return tcpip_sum ( partial, dest, src, len );
 }
 
 /**
@@ -204,6 +327,27 @@ uint16_t tcpip_chksum ( const void *data, size_t len ) {
 	return tcpip_continue_chksum ( TCPIP_EMPTY_CSUM, data, len );
 }
 
+/**
+ * Combine checksum of a separately summed fragment
+ *
+ * @v partial		Checksum of preceding data, in network byte order
+ * @v frag		Checksum of fragment, in network byte order
+ * @v offset		Offset of fragment within checksummed data
+ * @ret cksum		Updated checksum, in network byte order
+ *
+ * The fragment checksum must have been calculated starting from
+ * TCPIP_EMPTY_CSUM.  A fragment starting at an odd offset contributes
+ * a byte-swapped sum.
+ */
+uint16_t tcpip_combine_chksum ( uint16_t partial, uint16_t frag,
+				size_t offset ) {
+	uint16_t sum = ~frag;
+
+	if ( offset & 1 )
+		sum = bswap_16 ( sum );
+	return tcpip_continue_chksum ( partial, &sum, sizeof ( sum ) );
+}
+
 /**
  * Bind to local TCP/IP port
  *
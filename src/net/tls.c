@@ -37,6 +37,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/md5.h>
 #include <ipxe/sha1.h>
 #include <ipxe/sha256.h>
+#include <ipxe/sha512.h>
 #include <ipxe/aes.h>
 #include <ipxe/rsa.h>
 #include <ipxe/iobuf.h>
@@ -49,6 +50,7 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #include <ipxe/validator.h>
 #include <ipxe/job.h>
 #include <ipxe/tls.h>
+#include <ipxe/timeline.h>
 
 /* Disambiguate the various error causes */
 #define EINVAL_CHANGE_CIPHER __einfo_error ( EINFO_EINVAL_CHANGE_CIPHER )
@@ -107,6 +109,19 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define EINFO_EINVAL_TICKET						\
 	__einfo_uniqify ( EINFO_EINVAL, 0x0e,				\
 			  "Invalid New Session Ticket record")
+#define EINVAL_KEY_UPDATE __einfo_error ( EINFO_EINVAL_KEY_UPDATE )
+#define EINFO_EINVAL_KEY_UPDATE						\
+	__einfo_uniqify ( EINFO_EINVAL, 0x0f,				\
+			  "Invalid Key Update record" )
+#define EINVAL_CERTIFICATE_VERIFY					\
+	__einfo_error ( EINFO_EINVAL_CERTIFICATE_VERIFY )
+#define EINFO_EINVAL_CERTIFICATE_VERIFY					\
+	__einfo_uniqify ( EINFO_EINVAL, 0x10,				\
+			  "Invalid Certificate Verify record" )
+#define EINVAL_AEAD __einfo_error ( EINFO_EINVAL_AEAD )
+#define EINFO_EINVAL_AEAD						\
+	__einfo_uniqify ( EINFO_EINVAL, 0x11,				\
+			  "Invalid AEAD-protected record" )
 #define EIO_ALERT __einfo_error ( EINFO_EIO_ALERT )
 #define EINFO_EIO_ALERT							\
 	__einfo_uniqify ( EINFO_EIO, 0x01,				\
@@ -155,6 +170,10 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define EINFO_ENOTSUP_VERSION						\
 	__einfo_uniqify ( EINFO_ENOTSUP, 0x04,				\
 			  "Unsupported protocol version" )
+#define ENOTSUP_RETRY __einfo_error ( EINFO_ENOTSUP_RETRY )
+#define EINFO_ENOTSUP_RETRY						\
+	__einfo_uniqify ( EINFO_ENOTSUP, 0x05,				\
+			  "Hello Retry Request not supported" )
 #define EPERM_ALERT __einfo_error ( EINFO_EPERM_ALERT )
 #define EINFO_EPERM_ALERT						\
 	__einfo_uniqify ( EINFO_EPERM, 0x01,				\
@@ -175,6 +194,10 @@ FILE_LICENCE ( GPL2_OR_LATER );
 #define EINFO_EPERM_RENEG_VERIFY					\
 	__einfo_uniqify ( EINFO_EPERM, 0x05,				\
 			  "Secure renegotiation verification failed" )
+#define EPERM_DOWNGRADE __einfo_error ( EINFO_EPERM_DOWNGRADE )
+#define EINFO_EPERM_DOWNGRADE						\
+	__einfo_uniqify ( EINFO_EPERM, 0x06,				\
+			  "Protocol version downgrade detected" )
 #define EPROTO_VERSION __einfo_error ( EINFO_EPROTO_VERSION )
 #define EINFO_EPROTO_VERSION						\
 	__einfo_uniqify ( EINFO_EPROTO, 0x01,				\
@@ -379,6 +402,10 @@ static void free_tls ( struct refcnt *refcnt ) {
  */
 static void tls_close ( struct tls_connection *tls, int rc ) {
 
+	/* Record failure to negotiate, if applicable */
+	if ( ! tls_ready ( tls ) )
+		timeline_end ( "tls", tls, rc );
+
 	/* Remove pending operations, if applicable */
 	pending_put ( &tls->client_negotiation );
 	pending_put ( &tls->server_negotiation );
@@ -588,6 +615,100 @@ static void tls_prf ( struct tls_connection *tls, void *secret,
 	tls_prf ( (tls), (secret), (secret_len), (out), (out_len),	   \
 		  label, ( sizeof ( label ) - 1 ), __VA_ARGS__, NULL )
 
+/**
+ * Extract pseudorandom key (HKDF-Extract)
+ *
+ * @v digest		Hash function to use
+ * @v salt		Salt (of the hash function's output length)
+ * @v ikm		Input keying material
+ * @v ikm_len		Length of input keying material
+ * @v prk		Pseudorandom key to fill in
+ */
+static void tls_hkdf_extract ( struct digest_algorithm *digest,
+			       const void *salt, const void *ikm,
+			       size_t ikm_len, void *prk ) {
+	uint8_t ctx[digest->ctxsize];
+	uint8_t key[digest->digestsize];
+	size_t key_len = sizeof ( key );
+
+	/* Copy the salt, in case HMAC modifies it */
+	memcpy ( key, salt, sizeof ( key ) );
+
+	/* Calculate HMAC of input keying material */
+	hmac_init ( digest, ctx, key, &key_len );
+	hmac_update ( digest, ctx, ikm, ikm_len );
+	hmac_final ( digest, ctx, key, &key_len, prk );
+}
+
+/**
+ * Expand labelled secret (HKDF-Expand-Label)
+ *
+ * @v tls		TLS connection
+ * @v digest		Hash function to use
+ * @v secret		Secret (of the hash function's output length)
+ * @v label		Label (excluding the "tls13 " prefix)
+ * @v context		Context
+ * @v context_len	Length of context
+ * @v out		Output buffer
+ * @v out_len		Length of output buffer
+ */
+static void tls_hkdf_expand_label ( struct tls_connection *tls,
+				    struct digest_algorithm *digest,
+				    const void *secret, const char *label,
+				    const void *context, size_t context_len,
+				    void *out, size_t out_len ) {
+	static const char prefix[] = "tls13 ";
+	size_t label_len = strlen ( label );
+	struct {
+		uint16_t length;
+		uint8_t label_len;
+		char prefix[ sizeof ( prefix ) - 1 /* NUL */ ];
+		char label[label_len];
+		uint8_t context_len;
+		uint8_t context[context_len];
+	} __attribute__ (( packed )) info;
+	uint8_t ctx[digest->ctxsize];
+	uint8_t key[digest->digestsize];
+	uint8_t block[digest->digestsize];
+	size_t key_len;
+	size_t frag_len;
+	uint8_t counter;
+
+	/* Construct HkdfLabel */
+	info.length = htons ( out_len );
+	info.label_len = ( sizeof ( info.prefix ) + sizeof ( info.label ) );
+	memcpy ( info.prefix, prefix, sizeof ( info.prefix ) );
+	memcpy ( info.label, label, sizeof ( info.label ) );
+	info.context_len = sizeof ( info.context );
+	memcpy ( info.context, context, sizeof ( info.context ) );
+
+	/* Generate as much data as required */
+	for ( counter = 1 ; out_len ; counter++ ) {
+
+		/* Calculate T(i) = HMAC ( T(i-1) | info | i ) */
+		memcpy ( key, secret, sizeof ( key ) );
+		key_len = sizeof ( key );
+		hmac_init ( digest, ctx, key, &key_len );
+		if ( counter > 1 )
+			hmac_update ( digest, ctx, block, sizeof ( block ) );
+		hmac_update ( digest, ctx, &info, sizeof ( info ) );
+		hmac_update ( digest, ctx, &counter, sizeof ( counter ) );
+		hmac_final ( digest, ctx, key, &key_len, block );
+
+		/* Copy output */
+		frag_len = sizeof ( block );
+		if ( frag_len > out_len )
+			frag_len = out_len;
+		memcpy ( out, block, frag_len );
+		out += frag_len;
+		out_len -= frag_len;
+	}
+
+	DBGC2 ( tls, "TLS %p %s \"%s\" output:\n", tls, digest->name, label );
+	DBGC2_HD ( tls, ( out - ntohs ( info.length ) ),
+		   ntohs ( info.length ) );
+}
+
 /******************************************************************************
  *
  * Secret management
@@ -821,6 +942,16 @@ static int tls_select_cipher ( struct tls_connection *tls,
 		return -ENOTSUP_CIPHER;
 	}
 
+	/* TLSv1.3 cipher suites are not interchangeable with those
+	 * for earlier protocol versions.
+	 */
+	if ( ( tls->version >= TLS_VERSION_TLS_1_3 ) !=
+	     ( suite->version >= TLS_VERSION_TLS_1_3 ) ) {
+		DBGC ( tls, "TLS %p cannot use cipher %04x with version "
+		       "%04x\n", tls, ntohs ( cipher_suite ), tls->version );
+		return -ENOTSUP_CIPHER;
+	}
+
 	/* Set ciphers */
 	if ( ( rc = tls_set_cipher ( tls, &tls->tx_cipherspec_pending,
 				     suite ) ) != 0 )
@@ -859,6 +990,221 @@ static int tls_change_cipher ( struct tls_connection *tls,
 	return 0;
 }
 
+/******************************************************************************
+ *
+ * TLSv1.3 key schedule
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Derive TLSv1.3 secret
+ *
+ * @v tls		TLS connection
+ * @v digest		Hash function to use
+ * @v secret		Secret
+ * @v label		Label
+ * @v hash		Transcript hash, or NULL for an empty transcript
+ * @v out		Derived secret to fill in
+ */
+static void tls13_derive_secret ( struct tls_connection *tls,
+				  struct digest_algorithm *digest,
+				  const void *secret, const char *label,
+				  const void *hash, void *out ) {
+	uint8_t ctx[digest->ctxsize];
+	uint8_t empty[digest->digestsize];
+
+	/* Calculate hash of empty transcript, if applicable */
+	if ( ! hash ) {
+		digest_init ( digest, ctx );
+		digest_final ( digest, ctx, empty );
+		hash = empty;
+	}
+
+	/* Derive secret */
+	tls_hkdf_expand_label ( tls, digest, secret, label, hash,
+				digest->digestsize, out, digest->digestsize );
+}
+
+/**
+ * Generate TLSv1.3 early secret
+ *
+ * @v tls		TLS connection
+ * @v digest		Hash function to use
+ * @v psk		Pre-shared key, or NULL
+ *
+ * The early secret is stored in the master secret field.
+ */
+static void tls13_early_secret ( struct tls_connection *tls,
+				 struct digest_algorithm *digest,
+				 const void *psk ) {
+	uint8_t zero[digest->digestsize];
+
+	/* Use an all-zero salt, and an all-zero key if no PSK is used */
+	memset ( zero, 0, sizeof ( zero ) );
+	tls_hkdf_extract ( digest, zero, ( psk ? psk : zero ),
+			   sizeof ( zero ), tls->master_secret );
+
+	DBGC ( tls, "TLS %p early secret:\n", tls );
+	DBGC_HD ( tls, tls->master_secret, digest->digestsize );
+}
+
+/**
+ * Advance TLSv1.3 key schedule
+ *
+ * @v tls		TLS connection
+ * @v digest		Hash function to use
+ * @v ikm		Input keying material, or NULL for an all-zero key
+ * @v ikm_len		Length of input keying material
+ *
+ * The current secret (held in the master secret field) is replaced
+ * by the next secret in the key schedule, i.e. the early secret
+ * becomes the handshake secret and the handshake secret becomes the
+ * master secret.
+ */
+static void tls13_next_secret ( struct tls_connection *tls,
+				struct digest_algorithm *digest,
+				const void *ikm, size_t ikm_len ) {
+	uint8_t salt[digest->digestsize];
+	uint8_t zero[digest->digestsize];
+
+	/* Derive salt from current secret */
+	tls13_derive_secret ( tls, digest, tls->master_secret, "derived",
+			      NULL, salt );
+
+	/* Extract next secret */
+	if ( ! ikm ) {
+		memset ( zero, 0, sizeof ( zero ) );
+		ikm = zero;
+		ikm_len = sizeof ( zero );
+	}
+	tls_hkdf_extract ( digest, salt, ikm, ikm_len, tls->master_secret );
+
+	DBGC ( tls, "TLS %p next secret:\n", tls );
+	DBGC_HD ( tls, tls->master_secret, digest->digestsize );
+}
+
+/**
+ * Set TLSv1.3 traffic secret
+ *
+ * @v tls		TLS connection
+ * @v cipherspec	TLS cipher specification
+ * @v secret		Traffic secret
+ * @ret rc		Return status code
+ *
+ * The traffic secret is retained (in place of the MAC secret) to
+ * allow for key updates and for the calculation of Finished messages.
+ */
+static int tls13_set_secret ( struct tls_connection *tls,
+			      struct tls_cipherspec *cipherspec,
+			      const void *secret ) {
+	struct tls_cipher_suite *suite = cipherspec->suite;
+	struct digest_algorithm *digest = suite->digest;
+	uint8_t key[suite->key_len];
+	int rc;
+
+	/* Record traffic secret */
+	memmove ( cipherspec->mac_secret, secret, digest->digestsize );
+
+	/* Derive key and initialisation vector */
+	tls_hkdf_expand_label ( tls, digest, cipherspec->mac_secret, "key",
+				NULL, 0, key, sizeof ( key ) );
+	tls_hkdf_expand_label ( tls, digest, cipherspec->mac_secret, "iv",
+				NULL, 0, cipherspec->iv,
+				sizeof ( cipherspec->iv ) );
+
+	/* Set key */
+	if ( ( rc = cipher_setkey ( suite->cipher, cipherspec->cipher_ctx,
+				    key, sizeof ( key ) ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not set key: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+
+	return 0;
+}
+
+/**
+ * Activate TLSv1.3 traffic secret
+ *
+ * @v tls		TLS connection
+ * @v pending		Pending cipher specification
+ * @v active		Active cipher specification to replace
+ * @v label		Traffic secret label
+ * @v hash		Transcript hash
+ * @ret rc		Return status code
+ *
+ * The pending cipher specification must already have been assigned a
+ * cipher suite.
+ */
+static int tls13_change_secret ( struct tls_connection *tls,
+				 struct tls_cipherspec *pending,
+				 struct tls_cipherspec *active,
+				 const char *label, const void *hash ) {
+	struct digest_algorithm *digest = pending->suite->digest;
+	uint8_t secret[digest->digestsize];
+	int rc;
+
+	/* Derive and set traffic secret */
+	tls13_derive_secret ( tls, digest, tls->master_secret, label, hash,
+			      secret );
+	if ( ( rc = tls13_set_secret ( tls, pending, secret ) ) != 0 )
+		return rc;
+
+	/* Activate cipher specification, if applicable */
+	if ( active && ( ( rc = tls_change_cipher ( tls, pending,
+						    active ) ) != 0 ) )
+		return rc;
+
+	return 0;
+}
+
+/**
+ * Update TLSv1.3 traffic secret
+ *
+ * @v tls		TLS connection
+ * @v cipherspec	Active cipher specification
+ * @ret rc		Return status code
+ */
+static int tls13_update_secret ( struct tls_connection *tls,
+				 struct tls_cipherspec *cipherspec ) {
+	struct digest_algorithm *digest = cipherspec->suite->digest;
+	uint8_t secret[digest->digestsize];
+
+	/* Derive next generation of traffic secret */
+	tls_hkdf_expand_label ( tls, digest, cipherspec->mac_secret,
+				"traffic upd", NULL, 0, secret,
+				sizeof ( secret ) );
+	return tls13_set_secret ( tls, cipherspec, secret );
+}
+
+/**
+ * Calculate TLSv1.3 Finished verification data
+ *
+ * @v tls		TLS connection
+ * @v digest		Hash function to use
+ * @v secret		Base secret
+ * @v hash		Transcript hash
+ * @v out		Verification data to fill in
+ */
+static void tls13_verify_data ( struct tls_connection *tls,
+				struct digest_algorithm *digest,
+				const void *secret, const void *hash,
+				void *out ) {
+	uint8_t ctx[digest->ctxsize];
+	uint8_t key[digest->digestsize];
+	size_t key_len = sizeof ( key );
+
+	/* Derive finished key */
+	tls_hkdf_expand_label ( tls, digest, secret, "finished", NULL, 0,
+				key, sizeof ( key ) );
+
+	/* Calculate HMAC of transcript hash */
+	hmac_init ( digest, ctx, key, &key_len );
+	hmac_update ( digest, ctx, hash, digest->digestsize );
+	hmac_final ( digest, ctx, key, &key_len, out );
+}
+
 /******************************************************************************
  *
  * Signature and hash algorithms
@@ -893,6 +1239,77 @@ tls_signature_hash_algorithm ( struct pubkey_algorithm *pubkey,
 	return NULL;
 }
 
+/**
+ * Identify TLS signature and hash algorithm
+ *
+ * @v code		Numeric code
+ * @ret sig_hash	Signature and hash algorithm, or NULL
+ */
+static struct tls_signature_hash_algorithm *
+tls_find_signature_hash ( const struct tls_signature_hash_id *code ) {
+	struct tls_signature_hash_algorithm *sig_hash;
+
+	/* Identify signature and hash algorithm */
+	for_each_table_entry ( sig_hash, TLS_SIG_HASH_ALGORITHMS ) {
+		if ( memcmp ( &sig_hash->code, code,
+			      sizeof ( sig_hash->code ) ) == 0 )
+			return sig_hash;
+	}
+
+	return NULL;
+}
+
+/**
+ * Find TLSv1.3 signature scheme
+ *
+ * @v digest		Digest algorithm
+ * @ret sig_hash	Signature and hash algorithm, or NULL
+ *
+ * TLSv1.3 does not permit PKCS#1 v1.5 signatures in Certificate
+ * Verify messages, and so we select a signature scheme (such as
+ * RSA-PSS) that uses the digest algorithm intrinsically.
+ */
+static struct tls_signature_hash_algorithm *
+tls13_signature_hash_algorithm ( struct digest_algorithm *digest ) {
+	struct tls_signature_hash_algorithm *sig_hash;
+
+	/* Identify signature scheme */
+	for_each_table_entry ( sig_hash, TLS_SIG_HASH_ALGORITHMS ) {
+		if ( ( sig_hash->code.hash == TLS_INTRINSIC_ALGORITHM ) &&
+		     ( sig_hash->digest == digest ) ) {
+			return sig_hash;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Calculate digest of TLSv1.3 Certificate Verify signed content
+ *
+ * @v digest		Signature digest algorithm
+ * @v context		Context string
+ * @v hash		Transcript hash
+ * @v hash_len		Length of transcript hash
+ * @v out		Output buffer
+ */
+static void tls13_signed_digest ( struct digest_algorithm *digest,
+				  const char *context, const void *hash,
+				  size_t hash_len, void *out ) {
+	uint8_t ctx[digest->ctxsize];
+	uint8_t pad[64];
+
+	/* Signed content is 64 spaces, the context string (including
+	 * the terminating NUL), and the transcript hash.
+	 */
+	memset ( pad, ' ', sizeof ( pad ) );
+	digest_init ( digest, ctx );
+	digest_update ( digest, ctx, pad, sizeof ( pad ) );
+	digest_update ( digest, ctx, context, ( strlen ( context ) + 1 ) );
+	digest_update ( digest, ctx, hash, hash_len );
+	digest_final ( digest, ctx, out );
+}
+
 /******************************************************************************
  *
  * Handshake verification
@@ -914,6 +1331,8 @@ static void tls_add_handshake ( struct tls_connection *tls,
 			data, len );
 	digest_update ( &sha256_algorithm, tls->handshake_sha256_ctx,
 			data, len );
+	digest_update ( &sha384_algorithm, tls->handshake_sha384_ctx,
+			data, len );
 }
 
 /**
@@ -933,6 +1352,35 @@ static void tls_verify_handshake ( struct tls_connection *tls, void *out ) {
 	digest_final ( digest, ctx, out );
 }
 
+/**
+ * Calculate TLSv1.3 transcript hash including a received message
+ *
+ * @v tls		TLS connection
+ * @v type		Handshake message type
+ * @v data		Handshake message body
+ * @v len		Length of handshake message body
+ * @v out		Output buffer
+ *
+ * Received handshake messages are added to the transcript only after
+ * they have been processed.  This function allows a handler to
+ * calculate the transcript hash including the message currently
+ * being processed.
+ */
+static void tls13_transcript_hash ( struct tls_connection *tls,
+				    unsigned int type, const void *data,
+				    size_t len, void *out ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	uint8_t ctx[ digest->ctxsize ];
+	uint32_t type_length;
+
+	/* Add message to a copy of the transcript */
+	type_length = ( cpu_to_le32 ( type ) | htonl ( len ) );
+	memcpy ( ctx, tls->handshake_ctx, sizeof ( ctx ) );
+	digest_update ( digest, ctx, &type_length, sizeof ( type_length ) );
+	digest_update ( digest, ctx, data, len );
+	digest_final ( digest, ctx, out );
+}
+
 /******************************************************************************
  *
  * Record handling
@@ -977,6 +1425,7 @@ static void tls_restart ( struct tls_connection *tls ) {
 	/* (Re)initialise handshake context */
 	digest_init ( &md5_sha1_algorithm, tls->handshake_md5_sha1_ctx );
 	digest_init ( &sha256_algorithm, tls->handshake_sha256_ctx );
+	digest_init ( &sha384_algorithm, tls->handshake_sha384_ctx );
 	tls->handshake_digest = &sha256_algorithm;
 	tls->handshake_ctx = tls->handshake_sha256_ctx;
 
@@ -985,6 +1434,7 @@ static void tls_restart ( struct tls_connection *tls ) {
 	tls_tx_resume ( tls );
 	pending_get ( &tls->client_negotiation );
 	pending_get ( &tls->server_negotiation );
+	timeline_begin ( "tls", tls );
 }
 
 /**
@@ -1005,6 +1455,31 @@ static int tls_send_handshake ( struct tls_connection *tls,
 	return tls_send_plaintext ( tls, TLS_TYPE_HANDSHAKE, data, len );
 }
 
+/**
+ * Identify usable TLSv1.3 pre-shared key
+ *
+ * @v tls		TLS connection
+ * @ret suite		Pre-shared key cipher suite, or NULL
+ */
+static struct tls_cipher_suite *
+tls13_psk_suite ( struct tls_connection *tls ) {
+	struct tls_session *session = tls->session;
+	time_t age;
+
+	/* Do nothing unless we have a TLSv1.3 session ticket */
+	if ( ! session->psk_suite )
+		return NULL;
+
+	/* Check that ticket has not expired */
+	age = ( time ( NULL ) - session->ticket_time );
+	if ( ( age < 0 ) || ( age >= ( time_t ) session->ticket_lifetime ) ) {
+		DBGC ( tls, "TLS %p session ticket has expired\n", tls );
+		return NULL;
+	}
+
+	return session->psk_suite;
+}
+
 /**
  * Transmit Client Hello record
  *
@@ -1013,7 +1488,13 @@ static int tls_send_handshake ( struct tls_connection *tls,
  */
 static int tls_send_client_hello ( struct tls_connection *tls ) {
 	struct tls_session *session = tls->session;
+	struct tls_cipher_suite *psk_suite = tls13_psk_suite ( tls );
+	struct digest_algorithm *psk_digest =
+		( psk_suite ? psk_suite->digest : &digest_null );
 	size_t name_len = strlen ( session->name );
+	size_t ticket_len = ( session->psk_suite ? 0 : session->ticket_len );
+	size_t identity_len = ( psk_suite ? session->ticket_len : 0 );
+	int use_psk = ( psk_suite ? 1 : 0 );
 	struct {
 		uint32_t type_length;
 		uint16_t version;
@@ -1058,13 +1539,71 @@ static int tls_send_client_hello ( struct tls_connection *tls ) {
 			uint16_t session_ticket_type;
 			uint16_t session_ticket_len;
 			struct {
-				uint8_t data[session->ticket_len];
+				uint8_t data[ticket_len];
 			} __attribute__ (( packed )) session_ticket;
+			uint16_t supported_versions_type;
+			uint16_t supported_versions_len;
+			struct {
+				uint8_t len;
+				uint16_t code[4];
+			} __attribute__ (( packed )) supported_versions;
+			uint16_t supported_groups_type;
+			uint16_t supported_groups_len;
+			struct {
+				uint16_t len;
+				uint16_t code[1];
+			} __attribute__ (( packed )) supported_groups;
+			uint16_t key_share_type;
+			uint16_t key_share_len;
+			struct {
+				uint16_t len;
+				struct {
+					uint16_t group;
+					uint16_t len;
+					struct x25519_value key;
+				} __attribute__ (( packed )) shares[1];
+			} __attribute__ (( packed )) key_share;
+			uint16_t psk_key_exchange_modes_type;
+			uint16_t psk_key_exchange_modes_len;
+			struct {
+				uint8_t len;
+				uint8_t mode[1];
+			} __attribute__ (( packed )) psk_key_exchange_modes;
+			struct {
+				uint16_t type;
+				uint16_t len;
+				struct {
+					uint16_t len;
+					struct {
+						uint16_t len;
+						uint8_t identity[identity_len];
+						uint32_t age;
+					} __attribute__ (( packed )) list[1];
+				} __attribute__ (( packed )) identities;
+				struct {
+					uint16_t len;
+					struct {
+						uint8_t len;
+						uint8_t binder[psk_digest->
+							       digestsize];
+					} __attribute__ (( packed )) list[1];
+				} __attribute__ (( packed )) binders;
+			} __attribute__ (( packed )) pre_shared_key[use_psk];
 		} __attribute__ (( packed )) extensions;
 	} __attribute__ (( packed )) hello;
 	struct tls_cipher_suite *suite;
 	struct tls_signature_hash_algorithm *sighash;
+	uint8_t ctx[psk_digest->ctxsize];
+	uint8_t hash[psk_digest->digestsize];
+	uint8_t binder_key[psk_digest->digestsize];
+	unsigned long age;
 	unsigned int i;
+	int rc;
+
+	/* Generate ephemeral key pair */
+	if ( ( rc = tls_generate_random ( tls, &tls->x25519_private,
+					  sizeof ( tls->x25519_private ) ) ) != 0)
+		return rc;
 
 	/* Construct record */
 	memset ( &hello, 0, sizeof ( hello ) );
@@ -1118,6 +1657,98 @@ static int tls_send_client_hello ( struct tls_connection *tls ) {
 		= htons ( sizeof ( hello.extensions.session_ticket ) );
 	memcpy ( hello.extensions.session_ticket.data, session->ticket,
 		 sizeof ( hello.extensions.session_ticket.data ) );
+	hello.extensions.supported_versions_type
+		= htons ( TLS_SUPPORTED_VERSIONS );
+	hello.extensions.supported_versions_len
+		= htons ( sizeof ( hello.extensions.supported_versions ) );
+	hello.extensions.supported_versions.len
+		= sizeof ( hello.extensions.supported_versions.code );
+	hello.extensions.supported_versions.code[0]
+		= htons ( TLS_VERSION_TLS_1_3 );
+	hello.extensions.supported_versions.code[1]
+		= htons ( TLS_VERSION_TLS_1_2 );
+	hello.extensions.supported_versions.code[2]
+		= htons ( TLS_VERSION_TLS_1_1 );
+	hello.extensions.supported_versions.code[3]
+		= htons ( TLS_VERSION_TLS_1_0 );
+	hello.extensions.supported_groups_type
+		= htons ( TLS_SUPPORTED_GROUPS );
+	hello.extensions.supported_groups_len
+		= htons ( sizeof ( hello.extensions.supported_groups ) );
+	hello.extensions.supported_groups.len
+		= htons ( sizeof ( hello.extensions.supported_groups.code ) );
+	hello.extensions.supported_groups.code[0]
+		= htons ( TLS_NAMED_GROUP_X25519 );
+	hello.extensions.key_share_type = htons ( TLS_KEY_SHARE );
+	hello.extensions.key_share_len
+		= htons ( sizeof ( hello.extensions.key_share ) );
+	hello.extensions.key_share.len
+		= htons ( sizeof ( hello.extensions.key_share.shares ) );
+	hello.extensions.key_share.shares[0].group
+		= htons ( TLS_NAMED_GROUP_X25519 );
+	hello.extensions.key_share.shares[0].len
+		= htons ( sizeof ( hello.extensions.key_share.shares[0].key ) );
+	if ( ( rc = x25519_key ( &x25519_generator, &tls->x25519_private,
+			&hello.extensions.key_share.shares[0].key ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not generate key share: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+	hello.extensions.psk_key_exchange_modes_type
+		= htons ( TLS_PSK_KEY_EXCHANGE_MODES );
+	hello.extensions.psk_key_exchange_modes_len
+		= htons ( sizeof ( hello.extensions.psk_key_exchange_modes ) );
+	hello.extensions.psk_key_exchange_modes.len
+		= sizeof ( hello.extensions.psk_key_exchange_modes.mode );
+	hello.extensions.psk_key_exchange_modes.mode[0] = TLS_PSK_DHE_KE;
+
+	/* Offer TLSv1.3 session ticket as a pre-shared key, if
+	 * applicable.  The pre-shared key extension must be the last
+	 * extension, since the binder is calculated over the
+	 * preceding portion of the record.
+	 */
+	tls->psk_suite = psk_suite;
+	if ( use_psk ) {
+		age = ( ( time ( NULL ) - session->ticket_time ) * 1000 );
+		hello.extensions.pre_shared_key[0].type
+			= htons ( TLS_PRE_SHARED_KEY );
+		hello.extensions.pre_shared_key[0].len
+			= htons ( sizeof ( hello.extensions.pre_shared_key[0] )
+				  - sizeof ( hello.extensions.
+					     pre_shared_key[0].type )
+				  - sizeof ( hello.extensions.
+					     pre_shared_key[0].len ) );
+		hello.extensions.pre_shared_key[0].identities.len
+			= htons ( sizeof ( hello.extensions.pre_shared_key[0].
+					   identities.list ) );
+		hello.extensions.pre_shared_key[0].identities.list[0].len
+			= htons ( identity_len );
+		memcpy ( hello.extensions.pre_shared_key[0].identities.list[0].
+			 identity, session->ticket, identity_len );
+		hello.extensions.pre_shared_key[0].identities.list[0].age
+			= htonl ( age + session->ticket_age_add );
+		hello.extensions.pre_shared_key[0].binders.len
+			= htons ( sizeof ( hello.extensions.pre_shared_key[0].
+					   binders.list ) );
+		hello.extensions.pre_shared_key[0].binders.list[0].len
+			= psk_digest->digestsize;
+
+		/* Calculate binder over truncated record */
+		tls13_early_secret ( tls, psk_digest, session->psk );
+		tls13_derive_secret ( tls, psk_digest, tls->master_secret,
+				      "res binder", NULL, binder_key );
+		digest_init ( psk_digest, ctx );
+		digest_update ( psk_digest, ctx, &hello,
+				( ( ( void * ) &hello.extensions.
+				    pre_shared_key[0].binders ) -
+				  ( ( void * ) &hello ) ) );
+		digest_final ( psk_digest, ctx, hash );
+		tls13_verify_data ( tls, psk_digest, binder_key, hash,
+				    hello.extensions.pre_shared_key[0].
+				    binders.list[0].binder );
+		DBGC ( tls, "TLS %p offering %s pre-shared key\n",
+		       tls, psk_digest->name );
+	}
 
 	return tls_send_handshake ( tls, &hello, sizeof ( hello ) );
 }
@@ -1129,12 +1760,15 @@ static int tls_send_client_hello ( struct tls_connection *tls ) {
  * @ret rc		Return status code
  */
 static int tls_send_certificate ( struct tls_connection *tls ) {
+	int tls13 = ( ( tls->version >= TLS_VERSION_TLS_1_3 ) ? 1 : 0 );
 	struct {
 		uint32_t type_length;
+		uint8_t context_len[tls13];
 		tls24_t length;
 		struct {
 			tls24_t length;
 			uint8_t data[ tls->cert->raw.len ];
+			uint16_t extensions_len[tls13];
 		} __attribute__ (( packed )) certificates[1];
 	} __attribute__ (( packed )) *certificate;
 	int rc;
@@ -1212,6 +1846,92 @@ static int tls_send_client_key_exchange ( struct tls_connection *tls ) {
 				    ( sizeof ( key_xchg ) - unused ) );
 }
 
+/**
+ * Transmit TLSv1.3 Certificate Verify record
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ */
+static int tls13_send_certificate_verify ( struct tls_connection *tls ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	struct tls_signature_hash_algorithm *sig_hash =
+		tls13_signature_hash_algorithm ( digest );
+	struct pubkey_algorithm *pubkey =
+		( sig_hash ? sig_hash->pubkey : &pubkey_null );
+	uint8_t hash[ digest->digestsize ];
+	uint8_t digest_out[ digest->digestsize ];
+	uint8_t ctx[ pubkey->ctxsize ];
+	int rc;
+
+	/* Check signature scheme */
+	if ( ! sig_hash ) {
+		DBGC ( tls, "TLS %p could not identify %s signature scheme\n",
+		       tls, digest->name );
+		rc = -ENOTSUP_SIG_HASH;
+		goto err_sig_hash;
+	}
+
+	/* Generate digest to be signed */
+	tls_verify_handshake ( tls, hash );
+	tls13_signed_digest ( digest, "TLS 1.3, client CertificateVerify",
+			      hash, sizeof ( hash ), digest_out );
+
+	/* Initialise public-key algorithm */
+	if ( ( rc = pubkey_init ( pubkey, ctx, private_key.data,
+				  private_key.len ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not initialise %s client private "
+		       "key: %s\n", tls, pubkey->name, strerror ( rc ) );
+		goto err_pubkey_init;
+	}
+
+	/* Generate and transmit record */
+	{
+		size_t max_len = pubkey_max_len ( pubkey, ctx );
+		struct {
+			uint32_t type_length;
+			struct tls_signature_hash_id sig_hash;
+			uint16_t signature_len;
+			uint8_t signature[max_len];
+		} __attribute__ (( packed )) certificate_verify;
+		size_t unused;
+		int len;
+
+		/* Sign digest */
+		len = pubkey_sign ( pubkey, ctx, digest, digest_out,
+				    certificate_verify.signature );
+		if ( len < 0 ) {
+			rc = len;
+			DBGC ( tls, "TLS %p could not sign %s digest using %s "
+			       "client private key: %s\n", tls, digest->name,
+			       pubkey->name, strerror ( rc ) );
+			goto err_pubkey_sign;
+		}
+		unused = ( max_len - len );
+
+		/* Construct Certificate Verify record */
+		certificate_verify.type_length =
+			( cpu_to_le32 ( TLS_CERTIFICATE_VERIFY ) |
+			  htonl ( sizeof ( certificate_verify ) -
+				  sizeof ( certificate_verify.type_length ) -
+				  unused ) );
+		memcpy ( &certificate_verify.sig_hash, &sig_hash->code,
+			 sizeof ( certificate_verify.sig_hash ) );
+		certificate_verify.signature_len =
+			htons ( sizeof ( certificate_verify.signature ) -
+				unused );
+
+		/* Transmit record */
+		rc = tls_send_handshake ( tls, &certificate_verify,
+				   ( sizeof ( certificate_verify ) - unused ) );
+	}
+
+ err_pubkey_sign:
+	pubkey_final ( pubkey, ctx );
+ err_pubkey_init:
+ err_sig_hash:
+	return rc;
+}
+
 /**
  * Transmit Certificate Verify record
  *
@@ -1227,6 +1947,10 @@ static int tls_send_certificate_verify ( struct tls_connection *tls ) {
 	struct tls_signature_hash_algorithm *sig_hash = NULL;
 	int rc;
 
+	/* TLSv1.3 uses a different signature construction */
+	if ( tls->version >= TLS_VERSION_TLS_1_3 )
+		return tls13_send_certificate_verify ( tls );
+
 	/* Generate digest to be signed */
 	tls_verify_handshake ( tls, digest_out );
 
@@ -1314,6 +2038,58 @@ static int tls_send_change_cipher ( struct tls_connection *tls ) {
 				    change_cipher, sizeof ( change_cipher ) );
 }
 
+/**
+ * Transmit TLSv1.3 Finished record
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ */
+static int tls13_send_finished ( struct tls_connection *tls ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	struct {
+		uint32_t type_length;
+		uint8_t verify_data[ digest->digestsize ];
+	} __attribute__ (( packed )) finished;
+	uint8_t hash[ digest->digestsize ];
+	uint8_t secret[ digest->digestsize ];
+	int rc;
+
+	/* Construct record */
+	finished.type_length = ( cpu_to_le32 ( TLS_FINISHED ) |
+				 htonl ( sizeof ( finished ) -
+					 sizeof ( finished.type_length ) ) );
+	tls_verify_handshake ( tls, hash );
+	tls13_verify_data ( tls, digest, tls->tx_cipherspec.mac_secret, hash,
+			    finished.verify_data );
+
+	/* Transmit record */
+	if ( ( rc = tls_send_handshake ( tls, &finished,
+					 sizeof ( finished ) ) ) != 0 )
+		return rc;
+
+	/* Derive resumption master secret */
+	tls_verify_handshake ( tls, hash );
+	tls13_derive_secret ( tls, digest, tls->master_secret, "res master",
+			      hash, secret );
+	memcpy ( tls->master_secret, secret, sizeof ( secret ) );
+
+	/* Activate client application traffic secret */
+	if ( ( rc = tls_change_cipher ( tls, &tls->tx_cipherspec_pending,
+					&tls->tx_cipherspec ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not activate TX cipher: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+	tls->tx_seq = 0;
+
+	/* Mark client as finished */
+	pending_put ( &tls->client_negotiation );
+	if ( tls_ready ( tls ) )
+		timeline_end ( "tls", tls, 0 );
+
+	return 0;
+}
+
 /**
  * Transmit Finished record
  *
@@ -1329,6 +2105,10 @@ static int tls_send_finished ( struct tls_connection *tls ) {
 	uint8_t digest_out[ digest->digestsize ];
 	int rc;
 
+	/* TLSv1.3 uses a different verification data construction */
+	if ( tls->version >= TLS_VERSION_TLS_1_3 )
+		return tls13_send_finished ( tls );
+
 	/* Construct client verification data */
 	tls_verify_handshake ( tls, digest_out );
 	tls_prf_label ( tls, &tls->master_secret, sizeof ( tls->master_secret ),
@@ -1350,6 +2130,40 @@ static int tls_send_finished ( struct tls_connection *tls ) {
 
 	/* Mark client as finished */
 	pending_put ( &tls->client_negotiation );
+	if ( tls_ready ( tls ) )
+		timeline_end ( "tls", tls, 0 );
+
+	return 0;
+}
+
+/**
+ * Transmit Key Update record
+ *
+ * @v tls		TLS connection
+ * @ret rc		Return status code
+ */
+static int tls_send_key_update ( struct tls_connection *tls ) {
+	struct {
+		uint32_t type_length;
+		uint8_t request_update;
+	} __attribute__ (( packed )) key_update;
+	int rc;
+
+	/* Construct record */
+	key_update.type_length = ( cpu_to_le32 ( TLS_KEY_UPDATE ) |
+				   htonl ( sizeof ( key_update ) -
+					   sizeof ( key_update.type_length ) ));
+	key_update.request_update = 0;
+
+	/* Transmit record (which is not part of the handshake) */
+	if ( ( rc = tls_send_plaintext ( tls, TLS_TYPE_HANDSHAKE, &key_update,
+					 sizeof ( key_update ) ) ) != 0 )
+		return rc;
+
+	/* Update TX traffic secret */
+	if ( ( rc = tls13_update_secret ( tls, &tls->tx_cipherspec ) ) != 0 )
+		return rc;
+	tls->tx_seq = 0;
 
 	return 0;
 }
@@ -1366,7 +2180,8 @@ static int tls_new_change_cipher ( struct tls_connection *tls,
 				   const void *data, size_t len ) {
 	int rc;
 
-	if ( ( len != 1 ) || ( *( ( uint8_t * ) data ) != 1 ) ) {
+	if ( ( len != 1 ) || ( *( ( uint8_t * ) data ) != 1 ) ||
+	     ( tls->version >= TLS_VERSION_TLS_1_3 ) ) {
 		DBGC ( tls, "TLS %p received invalid Change Cipher\n", tls );
 		DBGC_HD ( tls, data, len );
 		return -EINVAL_CHANGE_CIPHER;
@@ -1378,7 +2193,7 @@ static int tls_new_change_cipher ( struct tls_connection *tls,
 		       tls, strerror ( rc ) );
 		return rc;
 	}
-	tls->rx_seq = ~( ( uint64_t ) 0 );
+	tls->rx_seq = 0;
 
 	return 0;
 }
@@ -1453,6 +2268,95 @@ static int tls_new_hello_request ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Complete TLSv1.3 Server Hello handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @v cipher_suite	Cipher suite specification
+ * @v key		Server key share, or NULL
+ * @v identity		Selected pre-shared key identity, or NULL
+ * @ret rc		Return status code
+ */
+static int tls13_new_server_hello ( struct tls_connection *tls,
+				    const void *data, size_t len,
+				    unsigned int cipher_suite,
+				    const struct x25519_value *key,
+				    const uint16_t *identity ) {
+	struct tls_cipher_suite *suite;
+	struct digest_algorithm *digest;
+	struct x25519_value shared;
+	int rc;
+
+	/* Select cipher suite */
+	if ( ( rc = tls_select_cipher ( tls, cipher_suite ) ) != 0 )
+		return rc;
+	suite = tls->rx_cipherspec_pending.suite;
+	digest = suite->digest;
+
+	/* Use cipher suite's digest algorithm for handshake verification */
+	tls->handshake_digest = digest;
+	if ( digest == &sha384_algorithm ) {
+		tls->handshake_ctx = tls->handshake_sha384_ctx;
+	} else {
+		assert ( digest == &sha256_algorithm );
+		tls->handshake_ctx = tls->handshake_sha256_ctx;
+	}
+
+	/* Generate early secret */
+	if ( identity ) {
+		/* Pre-shared key accepted: early secret was generated
+		 * while constructing the Client Hello.
+		 */
+		if ( ( ! tls->psk_suite ) || ( *identity != 0 ) ||
+		     ( tls->psk_suite->digest != digest ) ) {
+			DBGC ( tls, "TLS %p server selected invalid "
+			       "pre-shared key\n", tls );
+			return -EINVAL_HELLO;
+		}
+		DBGC ( tls, "TLS %p resuming using pre-shared key\n", tls );
+	} else {
+		tls->psk_suite = NULL;
+		tls13_early_secret ( tls, digest, NULL );
+	}
+
+	/* Calculate shared secret and generate handshake secret */
+	if ( ! key ) {
+		DBGC ( tls, "TLS %p received no key share\n", tls );
+		return -EINVAL_HELLO;
+	}
+	if ( ( rc = x25519_key ( key, &tls->x25519_private,
+				 &shared ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not calculate shared secret: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+	tls13_next_secret ( tls, digest, &shared, sizeof ( shared ) );
+
+	/* Activate handshake traffic secrets */
+	{
+		uint8_t hash[digest->digestsize];
+
+		tls13_transcript_hash ( tls, TLS_SERVER_HELLO, data, len,
+					hash );
+		if ( ( rc = tls13_change_secret ( tls,
+						  &tls->rx_cipherspec_pending,
+						  &tls->rx_cipherspec,
+						  "s hs traffic", hash ) ) != 0 )
+			return rc;
+		tls->rx_seq = 0;
+		if ( ( rc = tls13_change_secret ( tls,
+						  &tls->tx_cipherspec_pending,
+						  &tls->tx_cipherspec,
+						  "c hs traffic", hash ) ) != 0 )
+			return rc;
+		tls->tx_seq = 0;
+	}
+
+	return 0;
+}
+
 /**
  * Receive new Server Hello handshake record
  *
@@ -1488,6 +2392,27 @@ static int tls_new_server_hello ( struct tls_connection *tls,
 		uint8_t len;
 		uint8_t data[0];
 	} __attribute__ (( packed )) *reneg = NULL;
+	const struct {
+		uint16_t version;
+	} __attribute__ (( packed )) *supported_version = NULL;
+	const struct {
+		uint16_t group;
+		uint16_t len;
+		struct x25519_value key;
+	} __attribute__ (( packed )) *key_share = NULL;
+	const struct {
+		uint16_t identity;
+	} __attribute__ (( packed )) *psk = NULL;
+	static const uint8_t retry[32] = {
+		0xcf, 0x21, 0xad, 0x74, 0xe5, 0x9a, 0x61, 0x11,
+		0xbe, 0x1d, 0x8c, 0x02, 0x1e, 0x65, 0xb8, 0x91,
+		0xc2, 0xa2, 0x11, 0x16, 0x7a, 0xbb, 0x8c, 0x5e,
+		0x07, 0x9e, 0x09, 0xe2, 0xc8, 0xa8, 0x33, 0x9c,
+	};
+	static const uint8_t downgrade[7] = {
+		'D', 'O', 'W', 'N', 'G', 'R', 'D'
+	};
+	const uint8_t *sentinel;
 	uint16_t version;
 	size_t exts_len;
 	size_t ext_len;
@@ -1552,22 +2477,90 @@ static int tls_new_server_hello ( struct tls_connection *tls,
 					return -EINVAL_HELLO;
 				}
 				break;
+			case htons ( TLS_SUPPORTED_VERSIONS ) :
+				supported_version = ( ( void * ) ext->data );
+				if ( sizeof ( *supported_version ) != ext_len ){
+					DBGC ( tls, "TLS %p received invalid "
+					       "supported version\n", tls );
+					DBGC_HD ( tls, data, len );
+					return -EINVAL_HELLO;
+				}
+				break;
+			case htons ( TLS_KEY_SHARE ) :
+				key_share = ( ( void * ) ext->data );
+				if ( ( sizeof ( *key_share ) != ext_len ) ||
+				     ( key_share->group !=
+				       htons ( TLS_NAMED_GROUP_X25519 ) ) ||
+				     ( ntohs ( key_share->len ) !=
+				       sizeof ( key_share->key ) ) ) {
+					DBGC ( tls, "TLS %p received invalid "
+					       "key share\n", tls );
+					DBGC_HD ( tls, data, len );
+					return -EINVAL_HELLO;
+				}
+				break;
+			case htons ( TLS_PRE_SHARED_KEY ) :
+				psk = ( ( void * ) ext->data );
+				if ( sizeof ( *psk ) != ext_len ) {
+					DBGC ( tls, "TLS %p received invalid "
+					       "pre-shared key\n", tls );
+					DBGC_HD ( tls, data, len );
+					return -EINVAL_HELLO;
+				}
+				break;
 			}
 		}
 	}
 
+	/* Reject Hello Retry Request, since we have no alternative
+	 * key share to offer.
+	 */
+	if ( memcmp ( hello_a->random, retry, sizeof ( retry ) ) == 0 ) {
+		DBGC ( tls, "TLS %p received unsupported Hello Retry "
+		       "Request\n", tls );
+		return -ENOTSUP_RETRY;
+	}
+
 	/* Check and store protocol version */
-	version = ntohs ( hello_a->version );
-	if ( version < TLS_VERSION_TLS_1_0 ) {
-		DBGC ( tls, "TLS %p does not support protocol version %d.%d\n",
-		       tls, ( version >> 8 ), ( version & 0xff ) );
-		return -ENOTSUP_VERSION;
-	}
-	if ( version > tls->version ) {
-		DBGC ( tls, "TLS %p server attempted to illegally upgrade to "
-		       "protocol version %d.%d\n",
-		       tls, ( version >> 8 ), ( version & 0xff ) );
-		return -EPROTO_VERSION;
+	if ( supported_version ) {
+		/* Only TLSv1.3 may be selected via the supported
+		 * versions extension, and only during the initial
+		 * negotiation.
+		 */
+		version = ntohs ( supported_version->version );
+		if ( ( version != TLS_VERSION_TLS_1_3 ) ||
+		     ( tls->rx_cipherspec.suite != &tls_cipher_suite_null ) ){
+			DBGC ( tls, "TLS %p server attempted to illegally "
+			       "select protocol version %d.%d\n",
+			       tls, ( version >> 8 ), ( version & 0xff ) );
+			return -EPROTO_VERSION;
+		}
+	} else {
+		version = ntohs ( hello_a->version );
+		if ( version < TLS_VERSION_TLS_1_0 ) {
+			DBGC ( tls, "TLS %p does not support protocol version "
+			       "%d.%d\n", tls, ( version >> 8 ),
+			       ( version & 0xff ) );
+			return -ENOTSUP_VERSION;
+		}
+		if ( version > tls->version ) {
+			DBGC ( tls, "TLS %p server attempted to illegally "
+			       "upgrade to protocol version %d.%d\n",
+			       tls, ( version >> 8 ), ( version & 0xff ) );
+			return -EPROTO_VERSION;
+		}
+
+		/* Check for downgrade sentinel, since we offered TLSv1.3 */
+		sentinel = ( hello_a->random + sizeof ( hello_a->random ) -
+			     sizeof ( downgrade ) - 1 );
+		if ( ( memcmp ( sentinel, downgrade,
+				sizeof ( downgrade ) ) == 0 ) &&
+		     ( sentinel[ sizeof ( downgrade ) ] <= 1 ) ) {
+			DBGC ( tls, "TLS %p detected downgrade to protocol "
+			       "version %d.%d\n",
+			       tls, ( version >> 8 ), ( version & 0xff ) );
+			return -EPERM_DOWNGRADE;
+		}
 	}
 	tls->version = version;
 	DBGC ( tls, "TLS %p using protocol version %d.%d\n",
@@ -1585,6 +2578,26 @@ static int tls_new_server_hello ( struct tls_connection *tls,
 	memcpy ( &tls->server_random, &hello_a->random,
 		 sizeof ( tls->server_random ) );
 
+	/* Complete negotiation separately for TLSv1.3 */
+	if ( tls->version >= TLS_VERSION_TLS_1_3 ) {
+
+		/* Check that our legacy session ID was echoed */
+		if ( ( hello_a->session_id_len != tls->session_id_len ) ||
+		     ( memcmp ( session_id, tls->session_id,
+				tls->session_id_len ) != 0 ) ) {
+			DBGC ( tls, "TLS %p received mismatched session "
+			       "ID\n", tls );
+			DBGC_HD ( tls, data, len );
+			return -EINVAL_HELLO;
+		}
+
+		return tls13_new_server_hello ( tls, data, len,
+						hello_b->cipher_suite,
+						( key_share ?
+						  &key_share->key : NULL ),
+						( psk ? &psk->identity : NULL ));
+	}
+
 	/* Select cipher suite */
 	if ( ( rc = tls_select_cipher ( tls, hello_b->cipher_suite ) ) != 0 )
 		return rc;
@@ -1647,6 +2660,93 @@ static int tls_new_server_hello ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive TLSv1.3 New Session Ticket handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ */
+static int tls13_new_session_ticket ( struct tls_connection *tls,
+				      const void *data, size_t len ) {
+	struct tls_session *session = tls->session;
+	struct tls_cipher_suite *suite = tls->rx_cipherspec.suite;
+	struct digest_algorithm *digest = suite->digest;
+	const struct {
+		uint32_t lifetime;
+		uint32_t age_add;
+		uint8_t nonce_len;
+		uint8_t nonce[0];
+	} __attribute__ (( packed )) *new_session_ticket = data;
+	const struct {
+		uint16_t len;
+		uint8_t ticket[0];
+	} __attribute__ (( packed )) *ticket;
+	uint32_t lifetime;
+	size_t remaining;
+	size_t ticket_len;
+	void *copy;
+
+	/* Parse header */
+	if ( ( sizeof ( *new_session_ticket ) > len ) ||
+	     ( new_session_ticket->nonce_len >
+	       ( len - sizeof ( *new_session_ticket ) ) ) ) {
+		DBGC ( tls, "TLS %p received underlength New Session Ticket\n",
+		       tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_TICKET;
+	}
+	ticket = ( ( void * ) ( new_session_ticket->nonce +
+				new_session_ticket->nonce_len ) );
+	remaining = ( len - sizeof ( *new_session_ticket ) -
+		      new_session_ticket->nonce_len );
+	if ( ( sizeof ( *ticket ) > remaining ) ||
+	     ( ( ticket_len = ntohs ( ticket->len ) ) >
+	       ( remaining - sizeof ( *ticket ) ) ) || ( ! ticket_len ) ) {
+		DBGC ( tls, "TLS %p received overlength New Session Ticket\n",
+		       tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_TICKET;
+	}
+
+	/* Ignore tickets that cannot be used.  The resumption master
+	 * secret is not known until our Finished has been sent.
+	 */
+	lifetime = ntohl ( new_session_ticket->lifetime );
+	if ( ( ! lifetime ) || is_pending ( &tls->client_negotiation ) ) {
+		DBGC ( tls, "TLS %p ignoring unusable New Session Ticket\n",
+		       tls );
+		return 0;
+	}
+	if ( lifetime > TLS_TICKET_LIFETIME_MAX )
+		lifetime = TLS_TICKET_LIFETIME_MAX;
+
+	/* Record ticket */
+	copy = malloc ( ticket_len );
+	if ( ! copy )
+		return -ENOMEM;
+	memcpy ( copy, ticket->ticket, ticket_len );
+	free ( session->ticket );
+	session->ticket = copy;
+	session->ticket_len = ticket_len;
+	session->id_len = 0;
+
+	/* Record pre-shared key */
+	session->psk_suite = suite;
+	session->ticket_age_add = ntohl ( new_session_ticket->age_add );
+	session->ticket_lifetime = lifetime;
+	session->ticket_time = time ( NULL );
+	tls_hkdf_expand_label ( tls, digest, tls->master_secret, "resumption",
+				new_session_ticket->nonce,
+				new_session_ticket->nonce_len, session->psk,
+				digest->digestsize );
+	DBGC ( tls, "TLS %p new session ticket:\n", tls );
+	DBGC_HDA ( tls, 0, session->ticket, session->ticket_len );
+
+	return 0;
+}
+
 /**
  * Receive New Session Ticket handshake record
  *
@@ -1664,6 +2764,10 @@ static int tls_new_session_ticket ( struct tls_connection *tls,
 	} __attribute__ (( packed )) *new_session_ticket = data;
 	size_t ticket_len;
 
+	/* TLSv1.3 uses a different ticket format */
+	if ( tls->version >= TLS_VERSION_TLS_1_3 )
+		return tls13_new_session_ticket ( tls, data, len );
+
 	/* Parse header */
 	if ( sizeof ( *new_session_ticket ) > len ) {
 		DBGC ( tls, "TLS %p received underlength New Session Ticket\n",
@@ -1748,6 +2852,29 @@ static int tls_parse_chain ( struct tls_connection *tls,
 		}
 		record_len = ( sizeof ( *certificate ) + certificate_len );
 
+		/* Skip certificate extensions (TLSv1.3 only) */
+		if ( tls->version >= TLS_VERSION_TLS_1_3 ) {
+			const struct {
+				uint16_t len;
+				uint8_t data[0];
+			} __attribute__ (( packed )) *exts =
+				  ( data + record_len );
+
+			if ( ( sizeof ( *exts ) >
+			       ( remaining - record_len ) ) ||
+			     ( ntohs ( exts->len ) >
+			       ( remaining - record_len -
+				 sizeof ( *exts ) ) ) ) {
+				DBGC ( tls, "TLS %p overlength certificate "
+				       "extensions:\n", tls );
+				DBGC_HDA ( tls, 0, data, remaining );
+				rc = -EINVAL_CERTIFICATE;
+				goto err_overlength;
+			}
+			record_len += ( sizeof ( *exts ) +
+					ntohs ( exts->len ) );
+		}
+
 		/* Add certificate to chain */
 		if ( ( rc = x509_append_raw ( tls->chain, certificate->data,
 					      certificate_len ) ) != 0 ) {
@@ -1791,8 +2918,23 @@ static int tls_new_certificate ( struct tls_connection *tls,
 		uint8_t certificates[0];
 	} __attribute__ (( packed )) *certificate = data;
 	size_t certificates_len;
+	size_t context_len;
 	int rc;
 
+	/* Skip certificate request context (TLSv1.3 only) */
+	if ( tls->version >= TLS_VERSION_TLS_1_3 ) {
+		context_len = ( len ? *( ( uint8_t * ) data ) : 0 );
+		if ( ( len == 0 ) || ( context_len >= len ) ) {
+			DBGC ( tls, "TLS %p received underlength Server "
+			       "Certificate\n", tls );
+			DBGC_HD ( tls, data, len );
+			return -EINVAL_CERTIFICATES;
+		}
+		certificate = ( data + 1 + context_len );
+		len -= ( 1 + context_len );
+		tls->certificate_verified = 0;
+	}
+
 	/* Parse header */
 	if ( sizeof ( *certificate ) > len ) {
 		DBGC ( tls, "TLS %p received underlength Server Certificate\n",
@@ -1849,6 +2991,94 @@ static int tls_new_certificate_request ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive new Certificate Verify handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ *
+ * Servers send a Certificate Verify record only in TLSv1.3.
+ */
+static int tls_new_certificate_verify ( struct tls_connection *tls,
+					const void *data, size_t len ) {
+	struct digest_algorithm *digest = tls->handshake_digest;
+	const struct {
+		struct tls_signature_hash_id sig_hash;
+		uint16_t signature_len;
+		uint8_t signature[0];
+	} __attribute__ (( packed )) *certificate_verify = data;
+	struct tls_signature_hash_algorithm *sig_hash;
+	struct x509_certificate *cert;
+	uint8_t hash[ digest->digestsize ];
+	int rc;
+
+	/* Parse header */
+	if ( ( tls->version < TLS_VERSION_TLS_1_3 ) ||
+	     ( sizeof ( *certificate_verify ) > len ) ||
+	     ( ntohs ( certificate_verify->signature_len ) !=
+	       ( len - sizeof ( *certificate_verify ) ) ) ) {
+		DBGC ( tls, "TLS %p received invalid Certificate Verify\n",
+		       tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_CERTIFICATE_VERIFY;
+	}
+
+	/* Identify server certificate */
+	cert = x509_first ( tls->chain );
+	if ( ! cert ) {
+		DBGC ( tls, "TLS %p received Certificate Verify without "
+		       "Certificate\n", tls );
+		return -EINVAL_CERTIFICATE_VERIFY;
+	}
+
+	/* Identify signature scheme */
+	sig_hash = tls_find_signature_hash ( &certificate_verify->sig_hash );
+	if ( ! sig_hash ) {
+		DBGC ( tls, "TLS %p does not support signature scheme "
+		       "%02x%02x\n", tls, certificate_verify->sig_hash.hash,
+		       certificate_verify->sig_hash.signature );
+		return -ENOTSUP_SIG_HASH;
+	}
+
+	/* Verify signature */
+	tls_verify_handshake ( tls, hash );
+	{
+		struct pubkey_algorithm *pubkey = sig_hash->pubkey;
+		struct digest_algorithm *sig_digest = sig_hash->digest;
+		uint8_t ctx[ pubkey->ctxsize ];
+		uint8_t digest_out[ sig_digest->digestsize ];
+
+		tls13_signed_digest ( sig_digest,
+				      "TLS 1.3, server CertificateVerify",
+				      hash, sizeof ( hash ), digest_out );
+		if ( ( rc = pubkey_init ( pubkey, ctx,
+					  cert->subject.public_key.raw.data,
+					  cert->subject.public_key.raw.len ) )
+		     != 0 ) {
+			DBGC ( tls, "TLS %p cannot initialise public key: "
+			       "%s\n", tls, strerror ( rc ) );
+			return rc;
+		}
+		rc = pubkey_verify ( pubkey, ctx, sig_digest, digest_out,
+				     certificate_verify->signature,
+				     ntohs ( certificate_verify->
+					     signature_len ) );
+		pubkey_final ( pubkey, ctx );
+		if ( rc != 0 ) {
+			DBGC ( tls, "TLS %p server signature verification "
+			       "failed: %s\n", tls, strerror ( rc ) );
+			return rc;
+		}
+	}
+	DBGC ( tls, "TLS %p verified %s-%s server signature\n",
+	       tls, sig_hash->pubkey->name, sig_hash->digest->name );
+	tls->certificate_verified = 1;
+
+	return 0;
+}
+
 /**
  * Receive new Server Hello Done handshake record
  *
@@ -1865,8 +3095,9 @@ static int tls_new_server_hello_done ( struct tls_connection *tls,
 	int rc;
 
 	/* Sanity check */
-	if ( sizeof ( *hello_done ) != len ) {
-		DBGC ( tls, "TLS %p received overlength Server Hello Done\n",
+	if ( ( sizeof ( *hello_done ) != len ) ||
+	     ( tls->version >= TLS_VERSION_TLS_1_3 ) ) {
+		DBGC ( tls, "TLS %p received invalid Server Hello Done\n",
 		       tls );
 		DBGC_HD ( tls, data, len );
 		return -EINVAL_HELLO_DONE;
@@ -1883,6 +3114,101 @@ static int tls_new_server_hello_done ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive new TLSv1.3 Finished handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ */
+static int tls13_new_finished ( struct tls_connection *tls,
+				const void *data, size_t len ) {
+	struct tls_session *session = tls->session;
+	struct tls_cipher_suite *suite = tls->rx_cipherspec.suite;
+	struct digest_algorithm *digest = tls->handshake_digest;
+	uint8_t hash[ digest->digestsize ];
+	uint8_t verify_data[ digest->digestsize ];
+	int rc;
+
+	/* Sanity check */
+	if ( sizeof ( verify_data ) != len ) {
+		DBGC ( tls, "TLS %p received invalid Finished\n", tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_FINISHED;
+	}
+
+	/* Verify data */
+	tls_verify_handshake ( tls, hash );
+	tls13_verify_data ( tls, digest, tls->rx_cipherspec.mac_secret, hash,
+			    verify_data );
+	if ( memcmp ( verify_data, data, sizeof ( verify_data ) ) != 0 ) {
+		DBGC ( tls, "TLS %p verification failed\n", tls );
+		return -EPERM_VERIFY;
+	}
+
+	/* The server must have proven possession of its private key,
+	 * unless we are resuming using a pre-shared key.
+	 */
+	if ( ! ( tls->psk_suite || tls->certificate_verified ) ) {
+		DBGC ( tls, "TLS %p server did not verify certificate\n",
+		       tls );
+		return -EPERM_VERIFY;
+	}
+
+	/* Generate master secret */
+	tls13_next_secret ( tls, digest, NULL, 0 );
+
+	/* Activate server application traffic secret, and prepare
+	 * client application traffic secret for activation once our
+	 * own Finished has been sent.
+	 */
+	tls13_transcript_hash ( tls, TLS_FINISHED, data, len, hash );
+	if ( ( rc = tls_set_cipher ( tls, &tls->rx_cipherspec_pending,
+				     suite ) ) != 0 )
+		return rc;
+	if ( ( rc = tls13_change_secret ( tls, &tls->rx_cipherspec_pending,
+					  &tls->rx_cipherspec, "s ap traffic",
+					  hash ) ) != 0 )
+		return rc;
+	tls->rx_seq = 0;
+	if ( ( rc = tls_set_cipher ( tls, &tls->tx_cipherspec_pending,
+				     suite ) ) != 0 )
+		return rc;
+	if ( ( rc = tls13_change_secret ( tls, &tls->tx_cipherspec_pending,
+					  NULL, "c ap traffic", hash ) ) != 0 )
+		return rc;
+
+	/* Mark server as finished */
+	pending_put ( &tls->server_negotiation );
+
+	/* Begin certificate validation, unless resuming using a
+	 * pre-shared key (in which case the server was validated
+	 * during the original negotiation).
+	 */
+	if ( tls->psk_suite ) {
+		tls->tx_pending |= TLS_TX_FINISHED;
+		tls_tx_resume ( tls );
+	} else {
+		if ( ( rc = create_validator ( &tls->validator,
+					       tls->chain ) ) != 0 ) {
+			DBGC ( tls, "TLS %p could not start certificate "
+			       "validation: %s\n", tls, strerror ( rc ) );
+			return rc;
+		}
+		pending_get ( &tls->validation );
+	}
+
+	/* Move to end of session's connection list and allow other
+	 * connections to start making progress.
+	 */
+	list_del ( &tls->list );
+	list_add_tail ( &tls->list, &session->conn );
+	tls_tx_resume_all ( session );
+
+	return 0;
+}
+
 /**
  * Receive new Finished handshake record
  *
@@ -1901,6 +3227,10 @@ static int tls_new_finished ( struct tls_connection *tls,
 	} __attribute__ (( packed )) *finished = data;
 	uint8_t digest_out[ digest->digestsize ];
 
+	/* TLSv1.3 uses a different verification data construction */
+	if ( tls->version >= TLS_VERSION_TLS_1_3 )
+		return tls13_new_finished ( tls, data, len );
+
 	/* Sanity check */
 	if ( sizeof ( *finished ) != len ) {
 		DBGC ( tls, "TLS %p received overlength Finished\n", tls );
@@ -1921,6 +3251,8 @@ static int tls_new_finished ( struct tls_connection *tls,
 
 	/* Mark server as finished */
 	pending_put ( &tls->server_negotiation );
+	if ( tls_ready ( tls ) )
+		timeline_end ( "tls", tls, 0 );
 
 	/* If we are resuming a session (i.e. if the server Finished
 	 * arrives before the client Finished is sent), then schedule
@@ -1939,8 +3271,10 @@ static int tls_new_finished ( struct tls_connection *tls,
 	if ( tls->session_id_len ) {
 		session->id_len = tls->session_id_len;
 		memcpy ( session->id, tls->session_id, sizeof ( session->id ) );
+		session->psk_suite = NULL;
 	}
 	if ( tls->new_session_ticket_len ) {
+		session->psk_suite = NULL;
 		free ( session->ticket );
 		session->ticket = tls->new_session_ticket;
 		session->ticket_len = tls->new_session_ticket_len;
@@ -1961,6 +3295,46 @@ static int tls_new_finished ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive new Key Update handshake record
+ *
+ * @v tls		TLS connection
+ * @v data		Plaintext handshake record
+ * @v len		Length of plaintext handshake record
+ * @ret rc		Return status code
+ */
+static int tls_new_key_update ( struct tls_connection *tls,
+				const void *data, size_t len ) {
+	const struct {
+		uint8_t request_update;
+		char next[0];
+	} __attribute__ (( packed )) *key_update = data;
+	int rc;
+
+	/* Sanity check */
+	if ( ( tls->version < TLS_VERSION_TLS_1_3 ) ||
+	     ( sizeof ( *key_update ) != len ) ||
+	     ( key_update->request_update > 1 ) ||
+	     is_pending ( &tls->server_negotiation ) ) {
+		DBGC ( tls, "TLS %p received invalid Key Update\n", tls );
+		DBGC_HD ( tls, data, len );
+		return -EINVAL_KEY_UPDATE;
+	}
+
+	/* Update RX traffic secret */
+	if ( ( rc = tls13_update_secret ( tls, &tls->rx_cipherspec ) ) != 0 )
+		return rc;
+	tls->rx_seq = 0;
+
+	/* Schedule Key Update of our own, if requested */
+	if ( key_update->request_update ) {
+		tls->tx_pending |= TLS_TX_KEY_UPDATE;
+		tls_tx_resume ( tls );
+	}
+
+	return 0;
+}
+
 /**
  * Receive new Handshake record
  *
@@ -2025,9 +3399,16 @@ static int tls_new_handshake ( struct tls_connection *tls,
 			rc = tls_new_server_hello_done ( tls, payload,
 							 payload_len );
 			break;
+		case TLS_CERTIFICATE_VERIFY:
+			rc = tls_new_certificate_verify ( tls, payload,
+							  payload_len );
+			break;
 		case TLS_FINISHED:
 			rc = tls_new_finished ( tls, payload, payload_len );
 			break;
+		case TLS_KEY_UPDATE:
+			rc = tls_new_key_update ( tls, payload, payload_len );
+			break;
 		default:
 			DBGC ( tls, "TLS %p ignoring handshake type %d\n",
 			       tls, handshake->type );
@@ -2036,10 +3417,15 @@ static int tls_new_handshake ( struct tls_connection *tls,
 		}
 
 		/* Add to handshake digest (except for Hello Requests,
-		 * which are explicitly excluded).
+		 * which are explicitly excluded, and for TLSv1.3
+		 * post-handshake messages).
 		 */
-		if ( handshake->type != TLS_HELLO_REQUEST )
+		if ( ( handshake->type != TLS_HELLO_REQUEST ) &&
+		     ! ( ( tls->version >= TLS_VERSION_TLS_1_3 ) &&
+			 ( ( handshake->type == TLS_NEW_SESSION_TICKET ) ||
+			   ( handshake->type == TLS_KEY_UPDATE ) ) ) ) {
 			tls_add_handshake ( tls, data, record_len );
+		}
 
 		/* Abort on failure */
 		if ( rc != 0 )
@@ -2282,6 +3668,93 @@ static void * tls_assemble_block ( struct tls_connection *tls,
 	return plaintext;
 }
 
+/**
+ * Construct TLSv1.3 AEAD nonce
+ *
+ * @v cipherspec	Cipher specification
+ * @v seq		Sequence number
+ * @v nonce		Nonce to fill in
+ */
+static void tls_aead_nonce ( struct tls_cipherspec *cipherspec,
+			     uint64_t seq, uint8_t *nonce ) {
+	uint64_t seq_be = cpu_to_be64 ( seq );
+	const uint8_t *bytes = ( ( const uint8_t * ) &seq_be );
+	unsigned int i;
+
+	/* XOR the padded sequence number into the fixed IV */
+	memcpy ( nonce, cipherspec->iv, sizeof ( cipherspec->iv ) );
+	nonce += ( sizeof ( cipherspec->iv ) - sizeof ( seq_be ) );
+	for ( i = 0 ; i < sizeof ( seq_be ) ; i++ )
+		nonce[i] ^= bytes[i];
+}
+
+/**
+ * Send AEAD-protected record (TLSv1.3)
+ *
+ * @v tls		TLS connection
+ * @v type		Record type
+ * @v data		Plaintext record
+ * @v len		Length of plaintext record
+ * @ret rc		Return status code
+ */
+static int tls_send_aead ( struct tls_connection *tls, unsigned int type,
+			   const void *data, size_t len ) {
+	struct tls_cipherspec *cipherspec = &tls->tx_cipherspec;
+	struct cipher_algorithm *cipher = cipherspec->suite->cipher;
+	struct tls_header *tlshdr;
+	struct io_buffer *ciphertext;
+	uint8_t nonce[ sizeof ( cipherspec->iv ) ];
+	size_t ciphertext_len;
+	uint8_t *content;
+	int rc;
+
+	/* Allocate ciphertext */
+	ciphertext_len = ( sizeof ( *tlshdr ) + len + 1 /* type */ +
+			   cipher->authsize );
+	ciphertext = xfer_alloc_iob ( &tls->cipherstream, ciphertext_len );
+	if ( ! ciphertext ) {
+		DBGC ( tls, "TLS %p could not allocate %zd bytes for "
+		       "ciphertext\n", tls, ciphertext_len );
+		return -ENOMEM_TX_CIPHERTEXT;
+	}
+
+	/* Construct header, which forms the additional data */
+	tlshdr = iob_put ( ciphertext, sizeof ( *tlshdr ) );
+	tlshdr->type = TLS_TYPE_DATA;
+	tlshdr->version = htons ( TLS_VERSION_TLS_1_2 );
+	tlshdr->length = htons ( ciphertext_len - sizeof ( *tlshdr ) );
+
+	/* Construct inner plaintext (with no padding) */
+	content = iob_put ( ciphertext, ( len + 1 ) );
+	memcpy ( content, data, len );
+	content[len] = type;
+	DBGC2 ( tls, "Sending plaintext data:\n" );
+	DBGC2_HD ( tls, content, ( len + 1 ) );
+
+	/* Encrypt in place and append authentication tag */
+	tls_aead_nonce ( cipherspec, tls->tx_seq, nonce );
+	cipher_setiv ( cipher, cipherspec->cipher_ctx, nonce );
+	cipher_encrypt ( cipher, cipherspec->cipher_ctx, tlshdr, NULL,
+			 sizeof ( *tlshdr ) );
+	cipher_encrypt ( cipher, cipherspec->cipher_ctx, content, content,
+			 ( len + 1 ) );
+	cipher_auth ( cipher, cipherspec->cipher_ctx,
+		      iob_put ( ciphertext, cipher->authsize ) );
+
+	/* Send ciphertext */
+	if ( ( rc = xfer_deliver_iob ( &tls->cipherstream,
+				       ciphertext ) ) != 0 ) {
+		DBGC ( tls, "TLS %p could not deliver ciphertext: %s\n",
+		       tls, strerror ( rc ) );
+		return rc;
+	}
+
+	/* Update TX state machine to next record */
+	tls->tx_seq += 1;
+
+	return 0;
+}
+
 /**
  * Send plaintext record
  *
@@ -2305,6 +3778,10 @@ static int tls_send_plaintext ( struct tls_connection *tls, unsigned int type,
 	uint8_t mac[mac_len];
 	int rc;
 
+	/* Use AEAD record protection for TLSv1.3 */
+	if ( is_auth_cipher ( cipher ) )
+		return tls_send_aead ( tls, type, data, len );
+
 	/* Construct header */
 	plaintext_tlshdr.type = type;
 	plaintext_tlshdr.version = htons ( tls->version );
@@ -2459,6 +3936,96 @@ static int tls_split_block ( struct tls_connection *tls,
 	return 0;
 }
 
+/**
+ * Receive new AEAD-protected record (TLSv1.3)
+ *
+ * @v tls		TLS connection
+ * @v tlshdr		Record header
+ * @v rx_data		List of received data buffers
+ * @ret rc		Return status code
+ */
+static int tls_new_aead ( struct tls_connection *tls,
+			  struct tls_header *tlshdr,
+			  struct list_head *rx_data ) {
+	struct tls_cipherspec *cipherspec = &tls->rx_cipherspec;
+	struct cipher_algorithm *cipher = cipherspec->suite->cipher;
+	uint8_t nonce[ sizeof ( cipherspec->iv ) ];
+	uint8_t auth[ cipher->authsize ];
+	struct io_buffer *iobuf;
+	struct io_buffer *tmp;
+	unsigned int type;
+	void *tag;
+
+	/* Ignore unprotected Change Cipher records, which may be sent
+	 * for middlebox compatibility.
+	 */
+	if ( tlshdr->type == TLS_TYPE_CHANGE_CIPHER ) {
+		DBGC2 ( tls, "TLS %p ignoring Change Cipher\n", tls );
+		list_for_each_entry_safe ( iobuf, tmp, rx_data, list ) {
+			list_del ( &iobuf->list );
+			free_iob ( iobuf );
+		}
+		return 0;
+	}
+
+	/* Extract authentication tag */
+	iobuf = list_last_entry ( rx_data, struct io_buffer, list );
+	if ( ( tlshdr->type != TLS_TYPE_DATA ) || ( ! iobuf ) ||
+	     ( iob_len ( iobuf ) < sizeof ( auth ) ) ) {
+		DBGC ( tls, "TLS %p received invalid protected record\n",
+		       tls );
+		return -EINVAL_AEAD;
+	}
+	iob_unput ( iobuf, sizeof ( auth ) );
+	tag = iobuf->tail;
+
+	/* Decrypt the received data */
+	tls_aead_nonce ( cipherspec, tls->rx_seq, nonce );
+	cipher_setiv ( cipher, cipherspec->cipher_ctx, nonce );
+	cipher_decrypt ( cipher, cipherspec->cipher_ctx, tlshdr, NULL,
+			 sizeof ( *tlshdr ) );
+	list_for_each_entry ( iobuf, rx_data, list ) {
+		cipher_decrypt ( cipher, cipherspec->cipher_ctx,
+				 iobuf->data, iobuf->data, iob_len ( iobuf ) );
+	}
+
+	/* Verify authentication tag */
+	cipher_auth ( cipher, cipherspec->cipher_ctx, auth );
+	if ( memcmp ( tag, auth, sizeof ( auth ) ) != 0 ) {
+		DBGC ( tls, "TLS %p failed authentication\n", tls );
+		return -EINVAL_MAC;
+	}
+
+	/* Strip padding and extract the true content type */
+	while ( ( iobuf = list_last_entry ( rx_data, struct io_buffer,
+					    list ) ) ) {
+		while ( iob_len ( iobuf ) &&
+			( ! *( ( uint8_t * ) iobuf->tail - 1 ) ) ) {
+			iob_unput ( iobuf, 1 );
+		}
+		if ( iob_len ( iobuf ) )
+			break;
+		list_del ( &iobuf->list );
+		free_iob ( iobuf );
+	}
+	if ( ! iobuf ) {
+		DBGC ( tls, "TLS %p received record with no content type\n",
+		       tls );
+		return -EINVAL_AEAD;
+	}
+	iob_unput ( iobuf, 1 );
+	type = *( ( uint8_t * ) iobuf->tail );
+	DBGC2 ( tls, "Received plaintext data:\n" );
+	list_for_each_entry ( iobuf, rx_data, list )
+		DBGC2_HD ( tls, iobuf->data, iob_len ( iobuf ) );
+
+	/* Increment RX sequence number */
+	tls->rx_seq += 1;
+
+	/* Process plaintext record */
+	return tls_new_record ( tls, type, rx_data );
+}
+
 /**
  * Receive new ciphertext record
  *
@@ -2481,6 +4048,10 @@ static int tls_new_ciphertext ( struct tls_connection *tls,
 	size_t len = 0;
 	int rc;
 
+	/* Use AEAD record protection for TLSv1.3 */
+	if ( is_auth_cipher ( cipher ) )
+		return tls_new_aead ( tls, tlshdr, rx_data );
+
 	/* Decrypt the received data */
 	list_for_each_entry ( iobuf, &tls->rx_data, list ) {
 		cipher_decrypt ( cipher, cipherspec->cipher_ctx,
@@ -2518,6 +4089,9 @@ static int tls_new_ciphertext ( struct tls_connection *tls,
 		return -EINVAL_MAC;
 	}
 
+	/* Increment RX sequence number */
+	tls->rx_seq += 1;
+
 	/* Process plaintext record */
 	if ( ( rc = tls_new_record ( tls, tlshdr->type, rx_data ) ) != 0 )
 		return rc;
@@ -2705,9 +4279,6 @@ static int tls_newdata_process_data ( struct tls_connection *tls ) {
 					 &tls->rx_data ) ) != 0 )
 		return rc;
 
-	/* Increment RX sequence number */
-	tls->rx_seq += 1;
-
 	/* Return to header state */
 	assert ( list_empty ( &tls->rx_data ) );
 	tls->rx_state = TLS_RX_HEADER;
@@ -2849,19 +4420,31 @@ static void tls_validator_done ( struct tls_connection *tls, int rc ) {
 		goto err;
 	}
 
-	/* Initialise public key algorithm */
-	if ( ( rc = pubkey_init ( pubkey, cipherspec->pubkey_ctx,
-				  cert->subject.public_key.raw.data,
-				  cert->subject.public_key.raw.len ) ) != 0 ) {
-		DBGC ( tls, "TLS %p cannot initialise public key: %s\n",
-		       tls, strerror ( rc ) );
-		goto err;
+	/* TLSv1.3 has no key exchange following certificate
+	 * validation, since the server's signature has already been
+	 * verified.
+	 */
+	if ( tls->version < TLS_VERSION_TLS_1_3 ) {
+
+		/* Initialise public key algorithm */
+		if ( ( rc = pubkey_init ( pubkey, cipherspec->pubkey_ctx,
+					  cert->subject.public_key.raw.data,
+					  cert->subject.public_key.raw.len ) )
+		     != 0 ) {
+			DBGC ( tls, "TLS %p cannot initialise public key: "
+			       "%s\n", tls, strerror ( rc ) );
+			goto err;
+		}
+
+		/* Schedule Client Key Exchange and Change Cipher */
+		tls->tx_pending |= ( TLS_TX_CLIENT_KEY_EXCHANGE |
+				     TLS_TX_CHANGE_CIPHER );
 	}
 
-	/* Schedule Client Key Exchange, Change Cipher, and Finished */
-	tls->tx_pending |= ( TLS_TX_CLIENT_KEY_EXCHANGE |
-			     TLS_TX_CHANGE_CIPHER |
-			     TLS_TX_FINISHED );
+	/* Schedule Finished, and Certificate and Certificate Verify
+	 * if applicable
+	 */
+	tls->tx_pending |= TLS_TX_FINISHED;
 	if ( tls->cert ) {
 		tls->tx_pending |= ( TLS_TX_CERTIFICATE |
 				     TLS_TX_CERTIFICATE_VERIFY );
@@ -2988,6 +4571,14 @@ static void tls_tx_step ( struct tls_connection *tls ) {
 			goto err;
 		}
 		tls->tx_pending &= ~TLS_TX_FINISHED;
+	} else if ( tls->tx_pending & TLS_TX_KEY_UPDATE ) {
+		/* Send Key Update */
+		if ( ( rc = tls_send_key_update ( tls ) ) != 0 ) {
+			DBGC ( tls, "TLS %p could not send Key Update: %s\n",
+			       tls, strerror ( rc ) );
+			goto err;
+		}
+		tls->tx_pending &= ~TLS_TX_KEY_UPDATE;
 	}
 
 	/* Reschedule process if pending transmissions remain,
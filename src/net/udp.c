@@ -10,6 +10,7 @@
 #include <ipxe/open.h>
 #include <ipxe/uri.h>
 #include <ipxe/netdevice.h>
+#include <ipxe/init.h>
 #include <ipxe/udp.h>
 
 /** @file
@@ -26,7 +27,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 struct udp_connection {
 	/** Reference counter */
 	struct refcnt refcnt;
-	/** List of UDP connections */
+	/** Hash chain of UDP connections sharing a local port hash */
 	struct list_head list;
 
 	/** Data transfer interface */
@@ -38,15 +39,32 @@ struct udp_connection {
 	struct sockaddr_tcpip peer;
 };
 
+/** Number of UDP connection hash chains (must be a power of two) */
+#define UDP_HASH_SIZE 32
+
 /**
- * List of registered UDP connections
+ * UDP connections hashed by local port
+ *
+ * Promiscuous connections (with no local port) are held on the chain
+ * for port zero.
  */
-static LIST_HEAD ( udp_conns );
+static struct list_head udp_hash[UDP_HASH_SIZE];
 
 /* Forward declatations */
 static struct interface_descriptor udp_xfer_desc;
 struct tcpip_protocol udp_protocol __tcpip_protocol;
 
+/**
+ * Get UDP connection hash chain
+ *
+ * @v port		Local port number, in network-byte order
+ * @ret chain		Hash chain
+ */
+static inline __attribute__ (( always_inline )) struct list_head *
+udp_hash_chain ( uint16_t port ) {
+	return &udp_hash[ ntohs ( port ) & ( UDP_HASH_SIZE - 1 ) ];
+}
+
 /**
  * Check if local UDP port is available
  *
@@ -56,7 +74,7 @@ struct tcpip_protocol udp_protocol __tcpip_protocol;
 static int udp_port_available ( int port ) {
 	struct udp_connection *udp;
 
-	list_for_each_entry ( udp, &udp_conns, list ) {
+	list_for_each_entry ( udp, udp_hash_chain ( htons ( port ) ), list ) {
 		if ( udp->local.st_port == htons ( port ) )
 			return -EADDRINUSE;
 	}
@@ -111,7 +129,7 @@ static int udp_open_common ( struct interface *xfer,
 	 * list and return
 	 */
 	intf_plug_plug ( &udp->xfer, xfer );
-	list_add ( &udp->list, &udp_conns );
+	list_add ( &udp->list, udp_hash_chain ( udp->local.st_port ) );
 	return 0;
 
  err:
@@ -219,16 +237,18 @@ static int udp_tx ( struct udp_connection *udp, struct io_buffer *iobuf,
 }
 
 /**
- * Identify UDP connection by local address
+ * Identify UDP connection by local address within a hash chain
  *
+ * @v chain		Hash chain
  * @v local		Local address
  * @ret udp		UDP connection, or NULL
  */
-static struct udp_connection * udp_demux ( struct sockaddr_tcpip *local ) {
+static struct udp_connection * udp_demux_chain ( struct list_head *chain,
+						 struct sockaddr_tcpip *local ) {
 	static const struct sockaddr_tcpip empty_sockaddr = { .pad = { 0, } };
 	struct udp_connection *udp;
 
-	list_for_each_entry ( udp, &udp_conns, list ) {
+	list_for_each_entry ( udp, chain, list ) {
 		if ( ( ( udp->local.st_family == local->st_family ) ||
 		       ( udp->local.st_family == 0 ) ) &&
 		     ( ( udp->local.st_port == local->st_port ) ||
@@ -243,6 +263,31 @@ static struct udp_connection * udp_demux ( struct sockaddr_tcpip *local ) {
 	return NULL;
 }
 
+/**
+ * Identify UDP connection by local address
+ *
+ * @v local		Local address
+ * @ret udp		UDP connection, or NULL
+ *
+ * Connections bound to the local port take precedence over
+ * promiscuous connections.
+ */
+static struct udp_connection * udp_demux ( struct sockaddr_tcpip *local ) {
+	struct list_head *chain = udp_hash_chain ( local->st_port );
+	struct list_head *promisc = udp_hash_chain ( 0 );
+	struct udp_connection *udp;
+
+	/* Try connections bound to this local port */
+	if ( ( udp = udp_demux_chain ( chain, local ) ) != NULL )
+		return udp;
+
+	/* Try promiscuous connections, if on a different chain */
+	if ( promisc != chain )
+		return udp_demux_chain ( promisc, local );
+
+	return NULL;
+}
+
 /**
  * Process a received packet
  *
@@ -332,6 +377,22 @@ struct tcpip_protocol udp_protocol __tcpip_protocol = {
 	.tcpip_proto = IP_UDP,
 };
 
+/**
+ * Initialise UDP
+ *
+ */
+static void udp_init ( void ) {
+	unsigned int i;
+
+	for ( i = 0 ; i < UDP_HASH_SIZE ; i++ )
+		INIT_LIST_HEAD ( &udp_hash[i] );
+}
+
+/** UDP initialisation function */
+struct init_fn udp_init_fn __init_fn ( INIT_NORMAL ) = {
+	.initialise = udp_init,
+};
+
 /***************************************************************************
  *
  * Data transfer interface
@@ -114,6 +114,15 @@ const struct setting dhcp_server_setting __setting ( SETTING_MISC,
 	.type = &setting_type_ipv4,
 };
 
+/** Skip ProxyDHCP wait setting */
+const struct setting skip_proxy_wait_setting
+	__setting ( SETTING_MISC, skip-proxydhcp-wait ) = {
+	.name = "skip-proxydhcp-wait",
+	.description = "Skip ProxyDHCP wait when filename is known",
+	.tag = DHCP_EB_SKIP_PROXY_WAIT,
+	.type = &setting_type_uint8,
+};
+
 /**
  * Most recent DHCP transaction ID
  *
@@ -219,6 +228,10 @@ struct dhcp_session {
 	struct in_addr server;
 	/** DHCP offer priority */
 	int priority;
+	/** Rapid Commit DHCPACK, if any */
+	struct dhcp_packet *rapid_ack;
+	/** Waiting for ProxyDHCP offers may be skipped */
+	int skip_proxy_wait;
 
 	/** ProxyDHCP protocol extensions should be ignored */
 	int no_pxedhcp;
@@ -254,6 +267,7 @@ static void dhcp_free ( struct refcnt *refcnt ) {
 		container_of ( refcnt, struct dhcp_session, refcnt );
 
 	netdev_put ( dhcp->netdev );
+	dhcppkt_put ( dhcp->rapid_ack );
 	dhcppkt_put ( dhcp->proxy_offer );
 	free ( dhcp );
 }
@@ -316,12 +330,26 @@ static int dhcp_has_pxeopts ( struct dhcp_packet *dhcppkt ) {
 	return 0;
 }
 
+/**
+ * Check if DHCP packet contains a boot filename
+ *
+ * @v dhcppkt		DHCP packet
+ * @ret has_bootfile	DHCP packet contains a boot filename
+ */
+static int dhcp_has_bootfile ( struct dhcp_packet *dhcppkt ) {
+
+	return ( dhcppkt_fetch ( dhcppkt, DHCP_BOOTFILE_NAME, NULL, 0 ) > 0 );
+}
+
 /****************************************************************************
  *
  * DHCP state machine
  *
  */
 
+static void dhcp_lease ( struct dhcp_session *dhcp,
+			 struct dhcp_packet *dhcppkt );
+
 /**
  * Construct transmitted packet for DHCP discovery
  *
@@ -330,11 +358,18 @@ static int dhcp_has_pxeopts ( struct dhcp_packet *dhcppkt ) {
  * @v peer		Destination address
  */
 static int dhcp_discovery_tx ( struct dhcp_session *dhcp,
-			       struct dhcp_packet *dhcppkt __unused,
+			       struct dhcp_packet *dhcppkt,
 			       struct sockaddr_in *peer ) {
+	int rc;
 
 	DBGC ( dhcp, "DHCP %p DHCPDISCOVER\n", dhcp );
 
+	/* Request Rapid Commit, if enabled */
+	if ( DHCP_DISC_RAPID_COMMIT &&
+	     ( ( rc = dhcppkt_store ( dhcppkt, DHCP_RAPID_COMMIT,
+				      "", 0 ) ) != 0 ) )
+		return rc;
+
 	/* Set server address */
 	peer->sin_addr.s_addr = INADDR_BROADCAST;
 	peer->sin_port = htons ( BOOTPS_PORT );
@@ -342,6 +377,26 @@ static int dhcp_discovery_tx ( struct dhcp_session *dhcp,
 	return 0;
 }
 
+/**
+ * Complete DHCP discovery
+ *
+ * @v dhcp		DHCP session
+ *
+ * A Rapid Commit DHCPACK completes the lease immediately; otherwise
+ * we must request the offered address.
+ */
+static void dhcp_discovery_complete ( struct dhcp_session *dhcp ) {
+
+	/* Use Rapid Commit DHCPACK, if applicable */
+	if ( dhcp->rapid_ack ) {
+		dhcp_lease ( dhcp, dhcp->rapid_ack );
+		return;
+	}
+
+	/* Transition to DHCPREQUEST */
+	dhcp_set_state ( dhcp, &dhcp_state_request );
+}
+
 /**
  * Handle received packet during DHCP discovery
  *
@@ -363,6 +418,8 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 	int has_pxeclient;
 	int8_t priority = 0;
 	uint8_t no_pxedhcp = 0;
+	uint8_t skip_proxy_wait = 0;
+	int rapid;
 	unsigned long elapsed;
 
 	DBGC ( dhcp, "DHCP %p %s from %s:%d", dhcp,
@@ -400,16 +457,40 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 			sizeof ( no_pxedhcp ) );
 	if ( no_pxedhcp )
 		DBGC ( dhcp, " nopxe" );
+
+	/* Identify Rapid Commit DHCPACK */
+	rapid = ( ( msgtype == DHCPACK ) &&
+		  ( dhcppkt_fetch ( dhcppkt, DHCP_RAPID_COMMIT,
+				    NULL, 0 ) >= 0 ) );
+	if ( rapid )
+		DBGC ( dhcp, " rapid" );
+
+	/* Identify skip-ProxyDHCP-wait flag */
+	dhcppkt_fetch ( dhcppkt, DHCP_EB_SKIP_PROXY_WAIT, &skip_proxy_wait,
+			sizeof ( skip_proxy_wait ) );
+	if ( ! skip_proxy_wait )
+		skip_proxy_wait = fetch_uintz_setting ( NULL,
+						&skip_proxy_wait_setting );
 	DBGC ( dhcp, "\n" );
 
-	/* Select as DHCP offer, if applicable */
+	/* Select as DHCP offer, if applicable.  A Rapid Commit
+	 * DHCPACK is preferred over a DHCPOFFER of equal priority,
+	 * since the server has already committed to the lease.
+	 */
 	if ( ip.s_addr && ( peer->sin_port == htons ( BOOTPS_PORT ) ) &&
-	     ( ( msgtype == DHCPOFFER ) || ( ! msgtype /* BOOTP */ ) ) &&
-	     ( priority >= dhcp->priority ) ) {
+	     ( ( msgtype == DHCPOFFER ) || rapid ||
+	       ( ! msgtype /* BOOTP */ ) ) &&
+	     ( ( priority > dhcp->priority ) ||
+	       ( ( priority == dhcp->priority ) &&
+		 ( rapid || ( ! dhcp->rapid_ack ) ) ) ) ) {
 		dhcp->offer = ip;
 		dhcp->server = server_id;
 		dhcp->priority = priority;
 		dhcp->no_pxedhcp = no_pxedhcp;
+		dhcp->skip_proxy_wait = ( skip_proxy_wait &&
+					  dhcp_has_bootfile ( dhcppkt ) );
+		dhcppkt_put ( dhcp->rapid_ack );
+		dhcp->rapid_ack = ( rapid ? dhcppkt_get ( dhcppkt ) : NULL );
 	}
 
 	/* Select as ProxyDHCP offer, if applicable */
@@ -422,9 +503,11 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 	}
 
 	/* We can exit the discovery state when we have a valid
-	 * DHCPOFFER, and either:
+	 * DHCPOFFER (or Rapid Commit DHCPACK), and either:
 	 *
 	 *  o  The DHCPOFFER instructs us to ignore ProxyDHCPOFFERs, or
+	 *  o  The DHCPOFFER already specifies a boot filename and we
+	 *     have been told not to wait for ProxyDHCPOFFERs, or
 	 *  o  We have a valid ProxyDHCPOFFER, or
 	 *  o  We have allowed sufficient time for ProxyDHCPOFFERs.
 	 */
@@ -433,14 +516,15 @@ static void dhcp_discovery_rx ( struct dhcp_session *dhcp,
 	if ( ! dhcp->offer.s_addr )
 		return;
 
-	/* If we can't yet transition to DHCPREQUEST, do nothing */
+	/* If we can't yet leave the discovery state, do nothing */
 	elapsed = ( currticks() - dhcp->start );
-	if ( ! ( dhcp->no_pxedhcp || dhcp->proxy_offer ||
+	if ( ! ( dhcp->no_pxedhcp || dhcp->skip_proxy_wait ||
+		 dhcp->proxy_offer ||
 		 ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) ) )
 		return;
 
-	/* Transition to DHCPREQUEST */
-	dhcp_set_state ( dhcp, &dhcp_state_request );
+	/* Leave the discovery state */
+	dhcp_discovery_complete ( dhcp );
 }
 
 /**
@@ -465,7 +549,7 @@ static void dhcp_discovery_expired ( struct dhcp_session *dhcp ) {
 	/* Give up waiting for ProxyDHCP before we reach the failure point */
 	if ( dhcp->offer.s_addr &&
 	     ( elapsed > DHCP_DISC_PROXY_TIMEOUT_SEC * TICKS_PER_SEC ) ) {
-		dhcp_set_state ( dhcp, &dhcp_state_request );
+		dhcp_discovery_complete ( dhcp );
 		return;
 	}
 
@@ -535,9 +619,6 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
 			      struct in_addr server_id,
 			      struct in_addr pseudo_id ) {
 	struct in_addr ip;
-	struct settings *parent;
-	struct settings *settings;
-	int rc;
 
 	DBGC ( dhcp, "DHCP %p %s from %s:%d", dhcp,
 	       dhcp_msgtype_name ( msgtype ), inet_ntoa ( peer->sin_addr ),
@@ -564,8 +645,24 @@ static void dhcp_request_rx ( struct dhcp_session *dhcp,
 	if ( ip.s_addr != dhcp->offer.s_addr )
 		return;
 
+	/* Record lease */
+	dhcp_lease ( dhcp, dhcppkt );
+}
+
+/**
+ * Record DHCP lease
+ *
+ * @v dhcp		DHCP session
+ * @v dhcppkt		DHCPACK (or BOOTP reply) packet
+ */
+static void dhcp_lease ( struct dhcp_session *dhcp,
+			 struct dhcp_packet *dhcppkt ) {
+	struct settings *parent;
+	struct settings *settings;
+	int rc;
+
 	/* Record assigned address */
-	dhcp->local.sin_addr = ip;
+	dhcp->local.sin_addr = dhcppkt->dhcphdr->yiaddr;
 
 	/* Register settings */
 	parent = netdev_settings ( dhcp->netdev );
@@ -42,6 +42,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/ipv6.h>
 #include <ipxe/dhcp_arch.h>
 #include <ipxe/dhcpv6.h>
+#include <config/dhcp.h>
 
 /** @file
  *
@@ -462,6 +463,8 @@ enum dhcpv6_session_state_flags {
 	DHCPV6_RX_RECORD_SERVER_ID = 0x04,
 	/** Record received IPv6 address */
 	DHCPV6_RX_RECORD_IAADDR = 0x08,
+	/** Request Rapid Commit (and accept an immediate reply) */
+	DHCPV6_TX_RAPID_COMMIT = 0x10,
 };
 
 /** DHCPv6 request state */
@@ -478,7 +481,8 @@ static struct dhcpv6_session_state dhcpv6_solicit = {
 	.tx_type = DHCPV6_SOLICIT,
 	.rx_type = DHCPV6_ADVERTISE,
 	.flags = ( DHCPV6_TX_IA_NA | DHCPV6_RX_RECORD_SERVER_ID |
-		   DHCPV6_RX_RECORD_IAADDR ),
+		   DHCPV6_RX_RECORD_IAADDR |
+		   ( DHCP_DISC_RAPID_COMMIT ? DHCPV6_TX_RAPID_COMMIT : 0 ) ),
 	.next = &dhcpv6_request,
 };
 
@@ -613,6 +617,7 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 	struct dhcpv6_iaaddr_option *iaaddr;
 	struct dhcpv6_user_class_option *user_class;
 	struct dhcpv6_elapsed_time_option *elapsed;
+	struct dhcpv6_option *rapid_commit;
 	struct dhcpv6_header *dhcphdr;
 	struct io_buffer *iobuf;
 	void *options;
@@ -622,6 +627,7 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 	size_t user_class_string_len;
 	size_t user_class_len;
 	size_t elapsed_len;
+	size_t rapid_commit_len;
 	size_t total_len;
 	int rc;
 
@@ -642,9 +648,11 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 			   sizeof ( user_class->user_class[0] ) +
 			   user_class_string_len );
 	elapsed_len = sizeof ( *elapsed );
+	rapid_commit_len = ( ( dhcpv6->state->flags & DHCPV6_TX_RAPID_COMMIT ) ?
+			     sizeof ( *rapid_commit ) : 0 );
 	total_len = ( sizeof ( *dhcphdr ) + client_id_len + server_id_len +
 		      ia_na_len + sizeof ( dhcpv6_request_options_data ) +
-		      user_class_len + elapsed_len );
+		      user_class_len + elapsed_len + rapid_commit_len );
 
 	/* Allocate packet */
 	iobuf = xfer_alloc_iob ( &dhcpv6->xfer, total_len );
@@ -717,6 +725,13 @@ static int dhcpv6_tx ( struct dhcpv6_session *dhcpv6 ) {
 	elapsed->elapsed = htons ( ( ( currticks() - dhcpv6->start ) * 100 ) /
 				   TICKS_PER_SEC );
 
+	/* Construct rapid commit, if applicable */
+	if ( rapid_commit_len ) {
+		rapid_commit = iob_put ( iobuf, rapid_commit_len );
+		rapid_commit->code = htons ( DHCPV6_RAPID_COMMIT );
+		rapid_commit->len = htons ( 0 );
+	}
+
 	/* Sanity check */
 	assert ( iob_len ( iobuf ) == total_len );
 
@@ -769,6 +784,7 @@ static int dhcpv6_rx ( struct dhcpv6_session *dhcpv6,
 	struct dhcpv6_header *dhcphdr = iobuf->data;
 	struct dhcpv6_option_list options;
 	const union dhcpv6_any_option *option;
+	int rapid;
 	int rc;
 
 	/* Sanity checks */
@@ -811,8 +827,18 @@ static int dhcpv6_rx ( struct dhcpv6_session *dhcpv6,
 		goto done;
 	}
 
+	/* Identify a rapid commit reply, if applicable */
+	rapid = ( ( dhcpv6->state->flags & DHCPV6_TX_RAPID_COMMIT ) &&
+		  ( dhcphdr->type == DHCPV6_REPLY ) &&
+		  ( dhcpv6_option ( &options, DHCPV6_RAPID_COMMIT ) != NULL ) );
+	if ( rapid ) {
+		DBGC ( dhcpv6, "DHCPv6 %s received %s with rapid commit\n",
+		       dhcpv6->netdev->name,
+		       dhcpv6_type_name ( dhcphdr->type ) );
+	}
+
 	/* Check message type */
-	if ( dhcphdr->type != dhcpv6->state->rx_type ) {
+	if ( ( dhcphdr->type != dhcpv6->state->rx_type ) && ( ! rapid ) ) {
 		DBGC ( dhcpv6, "DHCPv6 %s received %s while expecting %s\n",
 		       dhcpv6->netdev->name, dhcpv6_type_name ( dhcphdr->type ),
 		       dhcpv6_type_name ( dhcpv6->state->rx_type ) );
@@ -868,8 +894,10 @@ static int dhcpv6_rx ( struct dhcpv6_session *dhcpv6,
 			 dhcpv6->server_duid_len );
 	}
 
-	/* Transition to next state, if applicable */
-	if ( dhcpv6->state->next ) {
+	/* Transition to next state, if applicable.  A rapid commit
+	 * reply completes the exchange immediately.
+	 */
+	if ( dhcpv6->state->next && ( ! rapid ) ) {
 		dhcpv6_set_state ( dhcpv6, dhcpv6->state->next );
 		rc = 0;
 		goto done;
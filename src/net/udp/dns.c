@@ -46,6 +46,9 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/dhcp.h>
 #include <ipxe/dhcpv6.h>
 #include <ipxe/dns.h>
+#include <ipxe/timer.h>
+#include <ipxe/timeline.h>
+#include <ipxe/metrics.h>
 
 /** @file
  *
@@ -78,6 +81,17 @@ static union {
 /** The DNS search list */
 static struct dns_name dns_search;
 
+/** Resolution latency metric */
+static struct metric dns_latency_metric __metric = {
+	.name = "dns.latency",
+	.unit = "ms",
+};
+
+/** Resolution failure metric */
+static struct metric dns_failure_metric __metric = {
+	.name = "dns.failure",
+};
+
 /**
  * Encode a DNS name using RFC1035 encoding
  *
@@ -446,6 +460,8 @@ struct dns_request {
 	struct interface socket;
 	/** Retry timer */
 	struct retry_timer timer;
+	/** Time at which resolution started */
+	unsigned long started;
 
 	/** Socket address to fill in with resolved address */
 	union {
@@ -489,6 +505,16 @@ static void dns_done ( struct dns_request *dns, int rc ) {
 	/* Stop the retry timer */
 	stop_timer ( &dns->timer );
 
+	/* Record end of resolution */
+	timeline_end ( "dns", dns, rc );
+	if ( rc == 0 ) {
+		metric_sample ( &dns_latency_metric,
+				( ( currticks() - dns->started ) /
+				  TICKS_PER_MS ) );
+	} else {
+		metric_inc ( &dns_failure_metric );
+	}
+
 	/* Shut down interfaces */
 	intf_shutdown ( &dns->socket, rc );
 	intf_shutdown ( &dns->resolv, rc );
@@ -992,6 +1018,8 @@ static int dns_resolv ( struct interface *resolv,
 
 	/* Start timer to trigger first packet */
 	start_timer_nodelay ( &dns->timer );
+	dns->started = currticks();
+	timeline_begin ( "dns", dns );
 
 	/* Attach parent interface, mortalise self, and return */
 	intf_plug_plug ( &dns->resolv, resolv );
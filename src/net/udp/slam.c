@@ -39,6 +39,8 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/tcpip.h>
 #include <ipxe/timer.h>
 #include <ipxe/retry.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/fec.h>
 
 /** @file
  *
@@ -83,6 +85,23 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *  ....
  *  Nul
  *
+ * The forward-error-corrected variant (using the x-slam-fec:// URI
+ * scheme) adds a fourth header field:
+ *
+ *  Int : FEC group size, in blocks.
+ *
+ * Consecutive runs of this many blocks form FEC groups (with the
+ * final group being implicitly padded with all-zeroes blocks).  The
+ * server may send repair packets with sequence numbers beyond the end
+ * of the transfer.  The repair packet with sequence number
+ * (num_blocks+n) is repair symbol (n/num_groups) for FEC group
+ * (n%num_groups), as constructed by fec_encode() using all-zeroes
+ * padding for any short final block.  A client can therefore
+ * reconstruct a group from any sufficient subset of its data and
+ * repair packets, without requesting retransmission of the specific
+ * packets that it has lost.  NACKs are still used to recover from
+ * any losses that exceed the repair capacity.
+ *
  */
 
 FEATURE ( FEATURE_PROTOCOL, "SLAM", DHCP_EB_FEATURE_SLAM, 1 );
@@ -99,7 +118,7 @@ FEATURE ( FEATURE_PROTOCOL, "SLAM", DHCP_EB_FEATURE_SLAM, 1 );
 
 /** Maximum SLAM header length */
 #define SLAM_MAX_HEADER_LEN ( 7 /* transaction id */ + 7 /* total_bytes */ + \
-			      7 /* block_size */ )
+			      7 /* block_size */ + 7 /* FEC group size */ )
 
 /** Maximum number of blocks to request per NACK
  *
@@ -118,6 +137,26 @@ FEATURE ( FEATURE_PROTOCOL, "SLAM", DHCP_EB_FEATURE_SLAM, 1 );
 /** SLAM slave timeout */
 #define SLAM_SLAVE_TIMEOUT ( 1 * TICKS_PER_SEC )
 
+/** SLAM FEC group state */
+struct slam_fec_group {
+	/** Number of received data blocks */
+	uint8_t received;
+	/** Number of stored repair symbols */
+	uint8_t repairs;
+};
+
+/** A stored SLAM FEC repair symbol */
+struct slam_fec_repair {
+	/** List of stored repair symbols */
+	struct list_head list;
+	/** FEC group */
+	unsigned long group;
+	/** Repair symbol index */
+	unsigned int row;
+	/** Repair symbol */
+	uint8_t data[0];
+};
+
 /** A SLAM request */
 struct slam_request {
 	/** Reference counter */
@@ -149,8 +188,39 @@ struct slam_request {
 	struct bitmap bitmap;
 	/** NACK sent flag */
 	int nack_sent;
+
+	/** Forward error correction is in use */
+	int fec;
+	/** FEC group size (in blocks) */
+	unsigned int fec_k;
+	/** Number of FEC groups */
+	unsigned long num_groups;
+	/** FEC group states */
+	struct slam_fec_group *groups;
+	/** Stored FEC repair symbols */
+	struct list_head repairs;
 };
 
+/**
+ * Discard stored SLAM FEC repair symbols
+ *
+ * @v slam		SLAM request
+ * @v group		FEC group, or -1UL for all groups
+ */
+static void slam_fec_discard ( struct slam_request *slam,
+			       unsigned long group ) {
+	struct slam_fec_repair *repair;
+	struct slam_fec_repair *tmp;
+
+	list_for_each_entry_safe ( repair, tmp, &slam->repairs, list ) {
+		if ( ( group != -1UL ) && ( repair->group != group ) )
+			continue;
+		slam->groups[repair->group].repairs--;
+		list_del ( &repair->list );
+		free ( repair );
+	}
+}
+
 /**
  * Free a SLAM request
  *
@@ -160,6 +230,9 @@ static void slam_free ( struct refcnt *refcnt ) {
 	struct slam_request *slam =
 		container_of ( refcnt, struct slam_request, refcnt );
 
+	if ( slam->groups )
+		slam_fec_discard ( slam, -1UL );
+	free ( slam->groups );
 	bitmap_free ( &slam->bitmap );
 	free ( slam );
 }
@@ -427,6 +500,7 @@ static int slam_pull_header ( struct slam_request *slam,
 	void *header = iobuf->data;
 	unsigned long total_bytes;
 	unsigned long block_size;
+	unsigned long fec_k = 0;
 	int rc;
 
 	/* If header matches cached header, just pull it and return */
@@ -448,11 +522,21 @@ static int slam_pull_header ( struct slam_request *slam,
 	if ( ( rc = slam_pull_value ( slam, iobuf, &block_size ) ) != 0 )
 		return rc;
 
+	/* Read and strip FEC group size, if applicable */
+	if ( slam->fec &&
+	     ( ( rc = slam_pull_value ( slam, iobuf, &fec_k ) ) != 0 ) )
+		return rc;
+
 	/* Sanity check */
 	if ( block_size == 0 ) {
 		DBGC ( slam, "SLAM %p ignoring zero block size\n", slam );
 		return -EINVAL;
 	}
+	if ( slam->fec && ( ( fec_k == 0 ) || ( fec_k >= FEC_MAX_SYMBOLS ) ) ){
+		DBGC ( slam, "SLAM %p ignoring invalid FEC group size %ld\n",
+		       slam, fec_k );
+		return -EINVAL;
+	}
 
 	/* Update the cached header */
 	slam->header_len = ( iobuf->data - header );
@@ -467,9 +551,32 @@ static int slam_pull_header ( struct slam_request *slam,
 	       "blocks %ld\n", slam, slam->total_bytes, slam->block_size,
 	       slam->num_blocks );
 
-	/* Discard and reset the bitmap */
+	/* Discard and reset the bitmap and FEC state */
 	bitmap_free ( &slam->bitmap );
 	memset ( &slam->bitmap, 0, sizeof ( slam->bitmap ) );
+	if ( slam->groups )
+		slam_fec_discard ( slam, -1UL );
+	free ( slam->groups );
+	slam->groups = NULL;
+	slam->fec_k = fec_k;
+	slam->num_groups = 0;
+
+	/* Allocate FEC group states, if applicable */
+	if ( fec_k ) {
+		slam->num_groups = ( ( slam->num_blocks + fec_k - 1 ) / fec_k );
+		slam->groups = zalloc ( slam->num_groups *
+					sizeof ( slam->groups[0] ) );
+		if ( ! slam->groups ) {
+			/* Failure to allocate group states is fatal */
+			DBGC ( slam, "SLAM %p could not allocate %ld FEC "
+			       "groups\n", slam, slam->num_groups );
+			rc = -ENOMEM;
+			slam_finished ( slam, rc );
+			return rc;
+		}
+		DBGC ( slam, "SLAM %p has FEC group size %ld (%ld groups)\n",
+		       slam, fec_k, slam->num_groups );
+	}
 
 	/* Allocate a new bitmap */
 	if ( ( rc = bitmap_resize ( &slam->bitmap,
@@ -488,6 +595,240 @@ static int slam_pull_header ( struct slam_request *slam,
 	return 0;
 }
 
+/**
+ * Get number of data blocks within SLAM FEC group
+ *
+ * @v slam		SLAM request
+ * @v group		FEC group
+ * @ret count		Number of data blocks
+ */
+static unsigned int slam_fec_blocks ( struct slam_request *slam,
+				      unsigned long group ) {
+	unsigned long first = ( group * slam->fec_k );
+	unsigned long remaining = ( slam->num_blocks - first );
+
+	return ( ( remaining < slam->fec_k ) ? remaining : slam->fec_k );
+}
+
+/**
+ * Deliver SLAM data block
+ *
+ * @v slam		SLAM request
+ * @v iobuf		I/O buffer
+ * @v packet		Block number
+ * @ret rc		Return status code
+ */
+static int slam_deliver_block ( struct slam_request *slam,
+				struct io_buffer *iobuf,
+				unsigned long packet ) {
+	struct xfer_metadata meta;
+	int rc;
+
+	/* Pass to recipient */
+	memset ( &meta, 0, sizeof ( meta ) );
+	meta.flags = XFER_FL_ABS_OFFSET;
+	meta.offset = ( packet * slam->block_size );
+	if ( ( rc = xfer_deliver ( &slam->xfer, iobuf, &meta ) ) != 0 )
+		return rc;
+
+	/* Mark block as received */
+	bitmap_set ( &slam->bitmap, packet );
+	if ( slam->fec_k )
+		slam->groups[ packet / slam->fec_k ].received++;
+
+	return 0;
+}
+
+/**
+ * Reconstruct SLAM FEC group
+ *
+ * @v slam		SLAM request
+ * @v group		FEC group
+ * @ret rc		Return status code
+ */
+static int slam_fec_decode ( struct slam_request *slam,
+			     unsigned long group ) {
+	unsigned int k = slam->fec_k;
+	unsigned int blocks = slam_fec_blocks ( slam, group );
+	unsigned int count =
+		( blocks - slam->groups[group].received );
+	unsigned long first = ( group * k );
+	unsigned int rows[count];
+	unsigned int missing[count];
+	void *data[count];
+	struct slam_fec_repair *repair;
+	struct xfer_buffer *xferbuf;
+	struct io_buffer *iobuf;
+	unsigned long packet;
+	size_t offset;
+	size_t len;
+	void *known;
+	unsigned int i;
+	unsigned int j;
+	int rc;
+
+	/* Identify missing blocks and available repair symbols */
+	for ( i = 0, j = 0 ; i < blocks ; i++ ) {
+		if ( ! bitmap_test ( &slam->bitmap, ( first + i ) ) )
+			missing[j++] = i;
+	}
+	assert ( j == count );
+	j = 0;
+	list_for_each_entry ( repair, &slam->repairs, list ) {
+		if ( ( repair->group == group ) && ( j < count ) ) {
+			rows[j] = repair->row;
+			data[j++] = repair->data;
+		}
+	}
+	assert ( j == count );
+
+	/* Reconstruction requires the received data blocks to be
+	 * readable from the underlying data transfer buffer.
+	 */
+	xferbuf = xfer_buffer ( &slam->xfer );
+	if ( ! xferbuf ) {
+		DBGC ( slam, "SLAM %p has no underlying data transfer "
+		       "buffer\n", slam );
+		rc = -ENOTSUP;
+		goto err_xferbuf;
+	}
+
+	/* Allocate temporary block buffer */
+	known = malloc ( slam->block_size );
+	if ( ! known ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Remove contributions of received data blocks */
+	for ( i = 0 ; i < blocks ; i++ ) {
+		packet = ( first + i );
+		if ( ! bitmap_test ( &slam->bitmap, packet ) )
+			continue;
+		offset = ( packet * slam->block_size );
+		len = ( slam->total_bytes - offset );
+		if ( len > slam->block_size )
+			len = slam->block_size;
+		memset ( ( known + len ), 0, ( slam->block_size - len ) );
+		if ( ( rc = xferbuf_read ( xferbuf, offset, known,
+					   len ) ) != 0 ) {
+			DBGC ( slam, "SLAM %p could not read block %ld: %s\n",
+			       slam, packet, strerror ( rc ) );
+			goto err_read;
+		}
+		for ( j = 0 ; j < count ; j++ ) {
+			fec_mul_add ( fec_coefficient ( k, rows[j], i ), known,
+				      data[j], slam->block_size );
+		}
+	}
+
+	/* Recover missing data blocks */
+	if ( ( rc = fec_recover ( k, count, rows, missing, data,
+				  slam->block_size ) ) != 0 ) {
+		DBGC ( slam, "SLAM %p could not recover group %ld: %s\n",
+		       slam, group, strerror ( rc ) );
+		goto err_recover;
+	}
+	DBGC2 ( slam, "SLAM %p recovered %d blocks of group %ld\n",
+		slam, count, group );
+
+	/* Deliver recovered data blocks */
+	for ( i = 0 ; i < count ; i++ ) {
+		packet = ( first + missing[i] );
+		offset = ( packet * slam->block_size );
+		len = ( slam->total_bytes - offset );
+		if ( len > slam->block_size )
+			len = slam->block_size;
+		iobuf = xfer_alloc_iob ( &slam->xfer, len );
+		if ( ! iobuf ) {
+			rc = -ENOMEM;
+			goto err_deliver;
+		}
+		memcpy ( iob_put ( iobuf, len ), data[i], len );
+		if ( ( rc = slam_deliver_block ( slam, iobuf, packet ) ) != 0 )
+			goto err_deliver;
+	}
+
+ err_deliver:
+ err_recover:
+ err_read:
+	free ( known );
+ err_alloc:
+ err_xferbuf:
+	slam_fec_discard ( slam, group );
+	return rc;
+}
+
+/**
+ * Receive SLAM FEC repair packet
+ *
+ * @v slam		SLAM request
+ * @v index		Repair packet index
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int slam_fec_rx ( struct slam_request *slam, unsigned long index,
+			 struct io_buffer *iobuf ) {
+	unsigned long group = ( index % slam->num_groups );
+	unsigned long row = ( index / slam->num_groups );
+	struct slam_fec_group *state = &slam->groups[group];
+	struct slam_fec_repair *repair;
+	size_t len = iob_len ( iobuf );
+	unsigned int missing;
+	int rc;
+
+	/* Sanity checks */
+	if ( row >= fec_max_rows ( slam->fec_k ) ) {
+		DBGC ( slam, "SLAM %p received out-of-range repair packet "
+		       "%ld\n", slam, index );
+		rc = -EINVAL;
+		goto err;
+	}
+	if ( len != slam->block_size ) {
+		DBGC ( slam, "SLAM %p received repair packet of %zd bytes "
+		       "(block_size=%ld)\n", slam, len, slam->block_size );
+		rc = -EINVAL;
+		goto err;
+	}
+
+	/* Ignore repair symbol if not needed */
+	missing = ( slam_fec_blocks ( slam, group ) - state->received );
+	if ( state->repairs >= missing ) {
+		rc = 0;
+		goto discard;
+	}
+	list_for_each_entry ( repair, &slam->repairs, list ) {
+		if ( ( repair->group == group ) && ( repair->row == row ) ) {
+			rc = 0;
+			goto discard;
+		}
+	}
+
+	/* Store repair symbol */
+	repair = malloc ( sizeof ( *repair ) + len );
+	if ( ! repair ) {
+		rc = -ENOMEM;
+		goto err;
+	}
+	repair->group = group;
+	repair->row = row;
+	memcpy ( repair->data, iobuf->data, len );
+	list_add_tail ( &repair->list, &slam->repairs );
+	state->repairs++;
+	free_iob ( iobuf );
+
+	/* Reconstruct group if we now have enough repair symbols */
+	if ( state->repairs >= missing )
+		return slam_fec_decode ( slam, group );
+
+	return 0;
+
+ err:
+ discard:
+	free_iob ( iobuf );
+	return rc;
+}
+
 /**
  * Receive SLAM data packet
  *
@@ -498,8 +839,10 @@ static int slam_pull_header ( struct slam_request *slam,
 static int slam_mc_socket_deliver ( struct slam_request *slam,
 				    struct io_buffer *iobuf,
 				    struct xfer_metadata *rx_meta __unused ) {
-	struct xfer_metadata meta;
+	struct slam_fec_group *state;
 	unsigned long packet;
+	unsigned long group;
+	unsigned int missing;
 	size_t len;
 	int rc;
 
@@ -516,6 +859,14 @@ static int slam_mc_socket_deliver ( struct slam_request *slam,
 	if ( ( rc = slam_pull_value ( slam, iobuf, &packet ) ) != 0 )
 		goto err_discard;
 
+	/* Handle FEC repair packets */
+	if ( slam->fec_k && ( packet >= slam->num_blocks ) ) {
+		if ( ( rc = slam_fec_rx ( slam, ( packet - slam->num_blocks ),
+					  iob_disown ( iobuf ) ) ) != 0 )
+			goto err;
+		goto check;
+	}
+
 	/* Sanity check packet number */
 	if ( packet >= slam->num_blocks ) {
 		DBGC ( slam, "SLAM %p received out-of-range packet %ld "
@@ -546,15 +897,26 @@ static int slam_mc_socket_deliver ( struct slam_request *slam,
 	}
 
 	/* Pass to recipient */
-	memset ( &meta, 0, sizeof ( meta ) );
-	meta.flags = XFER_FL_ABS_OFFSET;
-	meta.offset = ( packet * slam->block_size );
-	if ( ( rc = xfer_deliver ( &slam->xfer, iobuf, &meta ) ) != 0 )
+	if ( ( rc = slam_deliver_block ( slam, iob_disown ( iobuf ),
+					 packet ) ) != 0 )
 		goto err;
 
-	/* Mark block as received */
-	bitmap_set ( &slam->bitmap, packet );
+	/* Reconstruct FEC group if we now have enough repair symbols,
+	 * or discard any unneeded repair symbols.
+	 */
+	if ( slam->fec_k ) {
+		group = ( packet / slam->fec_k );
+		state = &slam->groups[group];
+		missing = ( slam_fec_blocks ( slam, group ) - state->received );
+		if ( ! missing ) {
+			slam_fec_discard ( slam, group );
+		} else if ( state->repairs >= missing ) {
+			if ( ( rc = slam_fec_decode ( slam, group ) ) != 0 )
+				goto err;
+		}
+	}
 
+ check:
 	/* If we have received all blocks, terminate */
 	if ( bitmap_full ( &slam->bitmap ) )
 		slam_finished ( slam, 0 );
@@ -691,9 +1053,11 @@ static int slam_parse_multicast_address ( struct slam_request *slam,
  *
  * @v xfer		Data transfer interface
  * @v uri		Uniform Resource Identifier
+ * @v fec		Use forward error correction
  * @ret rc		Return status code
  */
-static int slam_open ( struct interface *xfer, struct uri *uri ) {
+static int slam_open_fec ( struct interface *xfer, struct uri *uri,
+			   int fec ) {
 	static const struct sockaddr_in default_multicast = {
 		.sin_family = AF_INET,
 		.sin_port = htons ( SLAM_DEFAULT_MULTICAST_PORT ),
@@ -720,6 +1084,8 @@ static int slam_open ( struct interface *xfer, struct uri *uri ) {
 		     &slam->refcnt );
 	timer_init ( &slam->slave_timer, slam_slave_timer_expired,
 		     &slam->refcnt );
+	INIT_LIST_HEAD ( &slam->repairs );
+	slam->fec = fec;
 	/* Fake an invalid cached header of { 0x00, ... } */
 	slam->header_len = 1;
 	/* Fake parameters for initial NACK */
@@ -770,8 +1136,36 @@ static int slam_open ( struct interface *xfer, struct uri *uri ) {
 	return rc;
 }
 
+/**
+ * Initiate a SLAM request
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Uniform Resource Identifier
+ * @ret rc		Return status code
+ */
+static int slam_open ( struct interface *xfer, struct uri *uri ) {
+	return slam_open_fec ( xfer, uri, 0 );
+}
+
+/**
+ * Initiate a forward-error-corrected SLAM request
+ *
+ * @v xfer		Data transfer interface
+ * @v uri		Uniform Resource Identifier
+ * @ret rc		Return status code
+ */
+static int slam_fec_open ( struct interface *xfer, struct uri *uri ) {
+	return slam_open_fec ( xfer, uri, 1 );
+}
+
 /** SLAM URI opener */
 struct uri_opener slam_uri_opener __uri_opener = {
 	.scheme	= "x-slam",
 	.open	= slam_open,
 };
+
+/** Forward-error-corrected SLAM URI opener */
+struct uri_opener slam_fec_uri_opener __uri_opener = {
+	.scheme	= "x-slam-fec",
+	.open	= slam_fec_open,
+};
@@ -42,6 +42,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/ocsp.h>
 #include <ipxe/job.h>
 #include <ipxe/validator.h>
+#include <ipxe/timeline.h>
 #include <config/crypto.h>
 
 /** @file
@@ -128,6 +129,9 @@ static void validator_free ( struct refcnt *refcnt ) {
  */
 static void validator_finished ( struct validator *validator, int rc ) {
 
+	/* Record end of validation */
+	timeline_end ( "validate", validator, rc );
+
 	/* Remove process */
 	process_del ( &validator->process );
 
@@ -648,6 +652,7 @@ int create_validator ( struct interface *job, struct x509_chain *chain ) {
 		       &validator->refcnt );
 	validator->chain = x509_chain_get ( chain );
 	xferbuf_malloc_init ( &validator->buffer );
+	timeline_begin ( "validate", validator );
 
 	/* Attach parent interface, mortalise self, and return */
 	intf_plug_plug ( &validator->job, job );
@@ -0,0 +1,140 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Benchmark infrastructure
+ *
+ * Each benchmark is reported as a single line containing a JSON
+ * object, in the same style as exported metrics.  Times are given in
+ * profiler timestamp units (i.e. CPU cycles where available), along
+ * with the length of data processed by each iteration so that a cost
+ * per byte may be calculated.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/profile.h>
+#include <ipxe/bench.h>
+
+/**
+ * Run benchmark
+ *
+ * @v bench		Benchmark
+ * @ret rc		Return status code
+ */
+static int bench_exec ( struct benchmark *bench ) {
+	unsigned int count = ( bench->count ? bench->count : BENCH_COUNT );
+	struct profiler profiler;
+	unsigned long started;
+	unsigned int i;
+	int rc;
+
+	/* Prepare benchmark, if applicable */
+	if ( bench->setup && ( ( rc = bench->setup() ) != 0 ) )
+		goto err_setup;
+
+	/* Run one untimed iteration to warm up caches */
+	if ( ( rc = bench->exec() ) != 0 )
+		goto err_exec;
+
+	/* Profile iterations */
+	memset ( &profiler, 0, sizeof ( profiler ) );
+	for ( i = 0 ; i < count ; i++ ) {
+		started = profile_timestamp();
+		rc = bench->exec();
+		profile_update ( &profiler, ( profile_timestamp() - started ) );
+		if ( rc != 0 )
+			goto err_exec;
+	}
+
+ err_exec:
+	/* Clean up benchmark, if applicable */
+	if ( bench->teardown )
+		bench->teardown();
+ err_setup:
+
+	/* Report results */
+	if ( rc == 0 ) {
+		printf ( "{\"type\":\"bench\",\"name\":\"%s\",\"count\":%d,"
+			 "\"len\":%zd,\"mean\":%ld,\"stddev\":%ld}\n",
+			 bench->name, profiler.count, bench->len,
+			 profile_mean ( &profiler ),
+			 profile_stddev ( &profiler ) );
+	} else {
+		printf ( "{\"type\":\"bench\",\"name\":\"%s\","
+			 "\"error\":\"%s\"}\n", bench->name, strerror ( rc ) );
+	}
+
+	return rc;
+}
+
+/**
+ * Run named benchmarks
+ *
+ * @v name		Benchmark name or name prefix
+ * @ret rc		Return status code
+ *
+ * All benchmarks whose names begin with @c name will be run.
+ */
+int bench_run ( const char *name ) {
+	struct benchmark *bench;
+	size_t len = strlen ( name );
+	int rc = -ENOENT;
+
+	/* Run all matching benchmarks */
+	for_each_table_entry ( bench, BENCHMARKS ) {
+		if ( strncmp ( bench->name, name, len ) != 0 )
+			continue;
+		if ( ( ( rc = bench_exec ( bench ) ) != 0 ) )
+			return rc;
+	}
+
+	return rc;
+}
+
+/**
+ * Run all benchmarks
+ *
+ * @ret rc		Return status code
+ *
+ * All benchmarks will be run even if some fail.  The first failure
+ * (if any) is returned.
+ */
+int bench_run_all ( void ) {
+	struct benchmark *bench;
+	int first_rc = 0;
+	int rc;
+
+	/* Run all benchmarks */
+	for_each_table_entry ( bench, BENCHMARKS ) {
+		if ( ( ( rc = bench_exec ( bench ) ) != 0 ) && ( ! first_rc ) )
+			first_rc = rc;
+	}
+
+	return first_rc;
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Benchmark runner
+ *
+ * This registers an image which runs all benchmarks when executed.
+ * Building this object as a standalone binary (e.g. as
+ * bin-x86_64-linux/benchrun.linux) will therefore run all benchmarks
+ * at startup.
+ *
+ */
+
+#include <errno.h>
+#include <ipxe/init.h>
+#include <ipxe/image.h>
+#include <ipxe/bench.h>
+
+/**
+ * Probe benchmark runner image
+ *
+ * @v image		Image
+ * @ret rc		Return status code
+ */
+static int benchrun_image_probe ( struct image *image __unused ) {
+	return -ENOTTY;
+}
+
+/**
+ * Execute benchmark runner image
+ *
+ * @v image		Image
+ * @ret rc		Return status code
+ */
+static int benchrun_image_exec ( struct image *image __unused ) {
+	return bench_run_all();
+}
+
+/** Benchmark runner image type */
+static struct image_type benchrun_image_type = {
+	.name = "benchmarks",
+	.probe = benchrun_image_probe,
+	.exec = benchrun_image_exec,
+};
+
+/** Benchmark runner image */
+static struct image benchrun_image = {
+	.refcnt = REF_INIT ( ref_no_free ),
+	.name = "<BENCH>",
+	.type = &benchrun_image_type,
+};
+
+/**
+ * Initialise benchmark runner
+ *
+ */
+static void benchrun_init ( void ) {
+	int rc;
+
+	/* Register benchmark runner image */
+	if ( ( rc = register_image ( &benchrun_image ) ) != 0 ) {
+		DBG ( "Could not register benchmark image: %s\n",
+		      strerror ( rc ) );
+		/* No way to report failure */
+		return;
+	}
+}
+
+/** Benchmark runner initialisation function */
+struct init_fn benchrun_init_fn __init_fn ( INIT_EARLY ) = {
+	.initialise = benchrun_init,
+};
+
+/* Drag in all applicable benchmarks */
+REQUIRING_SYMBOL ( benchrun_init_fn );
+REQUIRE_OBJECT ( benchmarks );
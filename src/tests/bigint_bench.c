@@ -0,0 +1,163 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Big integer benchmarks
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <assert.h>
+#include <ipxe/bigint.h>
+#include <ipxe/bench.h>
+
+/** Modulus length used by modular exponentiation benchmarks */
+#define MODEXP_BENCH_LEN ( 2048 / 8 )
+
+/** Number of iterations for private-key-sized exponents
+ *
+ * A full-length modular exponentiation is slow enough that only a
+ * few iterations are needed.
+ */
+#define MODEXP_BENCH_PRIVATE_COUNT 2
+
+/** Base */
+static bigint_t ( bigint_required_size ( MODEXP_BENCH_LEN ) ) modexp_bench_base;
+
+/** Modulus */
+static bigint_t ( bigint_required_size ( MODEXP_BENCH_LEN ) )
+	modexp_bench_modulus;
+
+/** Full-length exponent */
+static bigint_t ( bigint_required_size ( MODEXP_BENCH_LEN ) )
+	modexp_bench_private;
+
+/** Public exponent */
+static bigint_t ( bigint_required_size ( 3 ) ) modexp_bench_public;
+
+/** Result */
+static bigint_t ( bigint_required_size ( MODEXP_BENCH_LEN ) )
+	modexp_bench_result;
+
+/** Temporary working space */
+static void *modexp_bench_tmp;
+
+/**
+ * Prepare modular exponentiation benchmark
+ *
+ * @ret rc		Return status code
+ */
+static int modexp_bench_setup ( void ) {
+	static const uint8_t public[] = { 0x01, 0x00, 0x01 };
+	uint8_t raw[MODEXP_BENCH_LEN];
+	unsigned int i;
+
+	/* Allocate temporary working space (sufficient for any exponent) */
+	modexp_bench_tmp = malloc ( bigint_mod_exp_tmp_len (
+					&modexp_bench_modulus,
+					&modexp_bench_private ) );
+	if ( ! modexp_bench_tmp )
+		return -ENOMEM;
+
+	/* Construct pseudo-random odd full-length modulus */
+	srand ( 0x1234568 );
+	for ( i = 0 ; i < sizeof ( raw ) ; i++ )
+		raw[i] = rand();
+	raw[0] |= 0x80;
+	raw[ sizeof ( raw ) - 1 ] |= 0x01;
+	bigint_init ( &modexp_bench_modulus, raw, sizeof ( raw ) );
+
+	/* Construct pseudo-random base less than the modulus */
+	for ( i = 0 ; i < sizeof ( raw ) ; i++ )
+		raw[i] = rand();
+	raw[0] &= 0x7f;
+	bigint_init ( &modexp_bench_base, raw, sizeof ( raw ) );
+
+	/* Construct pseudo-random full-length exponent */
+	for ( i = 0 ; i < sizeof ( raw ) ; i++ )
+		raw[i] = rand();
+	raw[0] |= 0x80;
+	bigint_init ( &modexp_bench_private, raw, sizeof ( raw ) );
+
+	/* Construct public exponent */
+	bigint_init ( &modexp_bench_public, public, sizeof ( public ) );
+
+	return 0;
+}
+
+/**
+ * Run full-length modular exponentiation benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int modexp_bench_private_exec ( void ) {
+
+	bigint_mod_exp ( &modexp_bench_base, &modexp_bench_modulus,
+			 &modexp_bench_private, &modexp_bench_result,
+			 modexp_bench_tmp );
+	return 0;
+}
+
+/**
+ * Run public exponent modular exponentiation benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int modexp_bench_public_exec ( void ) {
+
+	bigint_mod_exp ( &modexp_bench_base, &modexp_bench_modulus,
+			 &modexp_bench_public, &modexp_bench_result,
+			 modexp_bench_tmp );
+	return 0;
+}
+
+/**
+ * Clean up after modular exponentiation benchmark
+ *
+ */
+static void modexp_bench_teardown ( void ) {
+
+	free ( modexp_bench_tmp );
+}
+
+/** Full-length modular exponentiation benchmark */
+struct benchmark modexp_private_benchmark __benchmark = {
+	.name = "modexp2048",
+	.count = MODEXP_BENCH_PRIVATE_COUNT,
+	.setup = modexp_bench_setup,
+	.exec = modexp_bench_private_exec,
+	.teardown = modexp_bench_teardown,
+};
+
+/** Public exponent modular exponentiation benchmark */
+struct benchmark modexp_public_benchmark __benchmark = {
+	.name = "modexp2048_e65537",
+	.setup = modexp_bench_setup,
+	.exec = modexp_bench_public_exec,
+	.teardown = modexp_bench_teardown,
+};
@@ -0,0 +1,133 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Cipher algorithm benchmarks
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <ipxe/crypto.h>
+#include <ipxe/aes.h>
+#include <ipxe/bench.h>
+
+/** Length of data used by cipher benchmarks */
+#define CIPHER_BENCH_LEN 8192
+
+/** Pseudo-random data (too large for stack) */
+static uint8_t cipher_bench_data[CIPHER_BENCH_LEN];
+
+/** Cipher context */
+static void *cipher_bench_ctx;
+
+/**
+ * Define a cipher algorithm benchmark
+ *
+ * @v _name		Benchmark name
+ * @v _cipher		Cipher algorithm
+ * @v _key_len		Key length
+ * @v _op		Encryption or decryption operation
+ */
+#define CIPHER_BENCH( _name, _cipher, _key_len, _op )			\
+	static int _name ## _bench_setup ( void ) {			\
+		return cipher_bench_setup ( _cipher, _key_len );	\
+	}								\
+	static int _name ## _bench_exec ( void ) {			\
+		_op ( _cipher, cipher_bench_ctx, cipher_bench_data,	\
+		      cipher_bench_data, sizeof ( cipher_bench_data ) );\
+		return 0;						\
+	}								\
+	struct benchmark _name ## _benchmark __benchmark = {		\
+		.name = #_name,						\
+		.len = CIPHER_BENCH_LEN,				\
+		.setup = _name ## _bench_setup,				\
+		.exec = _name ## _bench_exec,				\
+		.teardown = cipher_bench_teardown,			\
+	}
+
+/**
+ * Prepare cipher benchmark
+ *
+ * @v cipher		Cipher algorithm
+ * @v key_len		Key length
+ * @ret rc		Return status code
+ */
+static int cipher_bench_setup ( struct cipher_algorithm *cipher,
+				size_t key_len ) {
+	uint8_t key[key_len];
+	uint8_t iv[cipher->blocksize];
+	unsigned int i;
+	int rc;
+
+	/* Allocate context */
+	cipher_bench_ctx = malloc ( cipher->ctxsize );
+	if ( ! cipher_bench_ctx ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Fill buffers with pseudo-random data */
+	srand ( 0x1234568 );
+	for ( i = 0 ; i < sizeof ( cipher_bench_data ) ; i++ )
+		cipher_bench_data[i] = rand();
+	for ( i = 0 ; i < sizeof ( key ) ; i++ )
+		key[i] = rand();
+	for ( i = 0 ; i < sizeof ( iv ) ; i++ )
+		iv[i] = rand();
+
+	/* Initialise cipher */
+	if ( ( rc = cipher_setkey ( cipher, cipher_bench_ctx, key,
+				    key_len ) ) != 0 )
+		goto err_setkey;
+	cipher_setiv ( cipher, cipher_bench_ctx, iv );
+
+	return 0;
+
+ err_setkey:
+	free ( cipher_bench_ctx );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Clean up after cipher benchmark
+ *
+ */
+static void cipher_bench_teardown ( void ) {
+
+	free ( cipher_bench_ctx );
+}
+
+CIPHER_BENCH ( aes128_cbc_encrypt, &aes_cbc_algorithm, ( 128 / 8 ),
+	       cipher_encrypt );
+CIPHER_BENCH ( aes128_cbc_decrypt, &aes_cbc_algorithm, ( 128 / 8 ),
+	       cipher_decrypt );
+CIPHER_BENCH ( aes256_cbc_encrypt, &aes_cbc_algorithm, ( 256 / 8 ),
+	       cipher_encrypt );
+CIPHER_BENCH ( aes256_cbc_decrypt, &aes_cbc_algorithm, ( 256 / 8 ),
+	       cipher_decrypt );
@@ -57,17 +57,32 @@ void cipher_encrypt_okx ( struct cipher_test *test, const char *file,
 	size_t len = test->len;
 	uint8_t ctx[cipher->ctxsize];
 	uint8_t ciphertext[len];
+	uint8_t auth[cipher->authsize];
 
 	/* Initialise cipher */
 	okx ( cipher_setkey ( cipher, ctx, test->key, test->key_len ) == 0,
 	      file, line );
 	cipher_setiv ( cipher, ctx, test->iv );
 
+	/* Process additional data, if applicable */
+	if ( test->additional_len ) {
+		cipher_encrypt ( cipher, ctx, test->additional, NULL,
+				 test->additional_len );
+	}
+
 	/* Perform encryption */
 	cipher_encrypt ( cipher, ctx, test->plaintext, ciphertext, len );
 
 	/* Compare against expected ciphertext */
 	okx ( memcmp ( ciphertext, test->ciphertext, len ) == 0, file, line );
+
+	/* Compare against expected authentication tag, if applicable */
+	if ( cipher->authsize ) {
+		okx ( test->auth_len == cipher->authsize, file, line );
+		cipher_auth ( cipher, ctx, auth );
+		okx ( memcmp ( auth, test->auth, cipher->authsize ) == 0,
+		      file, line );
+	}
 }
 
 /**
@@ -83,17 +98,32 @@ void cipher_decrypt_okx ( struct cipher_test *test, const char *file,
 	size_t len = test->len;
 	uint8_t ctx[cipher->ctxsize];
 	uint8_t plaintext[len];
+	uint8_t auth[cipher->authsize];
 
 	/* Initialise cipher */
 	okx ( cipher_setkey ( cipher, ctx, test->key, test->key_len ) == 0,
 	      file, line );
 	cipher_setiv ( cipher, ctx, test->iv );
 
-	/* Perform encryption */
+	/* Process additional data, if applicable */
+	if ( test->additional_len ) {
+		cipher_decrypt ( cipher, ctx, test->additional, NULL,
+				 test->additional_len );
+	}
+
+	/* Perform decryption */
 	cipher_decrypt ( cipher, ctx, test->ciphertext, plaintext, len );
 
 	/* Compare against expected plaintext */
 	okx ( memcmp ( plaintext, test->plaintext, len ) == 0, file, line );
+
+	/* Compare against expected authentication tag, if applicable */
+	if ( cipher->authsize ) {
+		okx ( test->auth_len == cipher->authsize, file, line );
+		cipher_auth ( cipher, ctx, auth );
+		okx ( memcmp ( auth, test->auth, cipher->authsize ) == 0,
+		      file, line );
+	}
 }
 
 /**
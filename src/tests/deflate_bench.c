@@ -0,0 +1,280 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * DEFLATE benchmarks
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/deflate.h>
+#include <ipxe/bench.h>
+#include "deflate_bench.h"
+
+/** Generated benchmark uncompressed data */
+uint8_t deflate_bench_expected[DEFLATE_BENCH_LEN];
+
+/** Generated benchmark compressed data */
+uint8_t deflate_bench_compressed[DEFLATE_BENCH_MAX_COMPRESSED_LEN];
+
+/** Length of generated benchmark compressed data */
+size_t deflate_bench_compressed_len;
+
+/** Benchmark pseudo-random number generator state */
+static uint32_t deflate_bench_seed;
+
+/** Literal/length code base lengths (codes 257-285) */
+static const uint16_t deflate_bench_len_base[29] = {
+	3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43,
+	51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+/** Distance code base distances (codes 0-29) */
+static const uint16_t deflate_bench_dist_base[30] = {
+	1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385,
+	513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385,
+	24577
+};
+
+/**
+ * Generate pseudo-random number
+ *
+ * @v limit		Upper limit (exclusive)
+ * @ret value		Pseudo-random value
+ */
+static unsigned int deflate_bench_random ( unsigned int limit ) {
+
+	deflate_bench_seed = ( ( deflate_bench_seed * 1103515245 ) + 12345 );
+	return ( ( deflate_bench_seed >> 8 ) % limit );
+}
+
+/**
+ * Append bits to generated compressed data
+ *
+ * @v offset		Current offset (in bits)
+ * @v value		Value
+ * @v bits		Length of value (in bits)
+ * @ret offset		New offset (in bits)
+ */
+static size_t deflate_bench_bits ( size_t offset, unsigned int value,
+				   unsigned int bits ) {
+
+	for ( ; bits-- ; offset++, value >>= 1 ) {
+		if ( value & 1 ) {
+			deflate_bench_compressed[ offset / 8 ] |=
+				( 1 << ( offset % 8 ) );
+		}
+	}
+	return offset;
+}
+
+/**
+ * Append static Huffman code to generated compressed data
+ *
+ * @v offset		Current offset (in bits)
+ * @v code		Huffman code
+ * @v bits		Length of code (in bits)
+ * @ret offset		New offset (in bits)
+ */
+static size_t deflate_bench_huf ( size_t offset, unsigned int code,
+				  unsigned int bits ) {
+
+	/* Huffman codes are stored most significant bit first */
+	while ( bits-- )
+		offset = deflate_bench_bits ( offset, ( code >> bits ), 1 );
+	return offset;
+}
+
+/**
+ * Append static literal/length symbol to generated compressed data
+ *
+ * @v offset		Current offset (in bits)
+ * @v sym		Literal/length symbol
+ * @ret offset		New offset (in bits)
+ */
+static size_t deflate_bench_litlen ( size_t offset, unsigned int sym ) {
+
+	if ( sym < 144 )
+		return deflate_bench_huf ( offset, ( 0x30 + sym ), 8 );
+	if ( sym < 256 )
+		return deflate_bench_huf ( offset, ( 0x190 + sym - 144 ), 9 );
+	if ( sym < 280 )
+		return deflate_bench_huf ( offset, ( sym - 256 ), 7 );
+	return deflate_bench_huf ( offset, ( 0xc0 + sym - 280 ), 8 );
+}
+
+/**
+ * Generate benchmark data
+ *
+ * The data is a single static Huffman block containing a mixture of
+ * short literal runs and duplicated strings (including overlapping
+ * strings), with the uncompressed data recorded for comparison.
+ */
+void deflate_bench_generate ( void ) {
+	size_t len = 0;
+	size_t offset;
+	unsigned int dup_len;
+	unsigned int distance;
+	unsigned int code;
+	unsigned int i;
+
+	/* Construct block header (final block, static Huffman) */
+	memset ( deflate_bench_compressed, 0,
+		 sizeof ( deflate_bench_compressed ) );
+	deflate_bench_seed = 0;
+	offset = deflate_bench_bits ( 0, 0x3, 3 );
+
+	/* Construct block contents */
+	while ( len < DEFLATE_BENCH_LEN ) {
+
+		/* Duplicate a string, or append a short literal run */
+		dup_len = ( deflate_bench_random ( 16 ) ?
+			    ( 3 + deflate_bench_random ( 30 ) ) :
+			    ( 3 + deflate_bench_random ( 256 ) ) );
+		if ( ( len > 0 ) && ( dup_len <= ( DEFLATE_BENCH_LEN - len ) )
+		     && deflate_bench_random ( 2 ) ) {
+
+			/* Choose distance (sometimes overlapping) */
+			distance = ( deflate_bench_random ( 4 ) ?
+				     ( 1 + deflate_bench_random ( 32768 ) ) :
+				     ( 1 + deflate_bench_random ( 8 ) ) );
+			if ( distance > len )
+				distance = len;
+
+			/* Encode length */
+			for ( code = 28 ; deflate_bench_len_base[code] > dup_len ;
+			      code-- ) {}
+			offset = deflate_bench_litlen ( offset, ( 257 + code ));
+			if ( ( code >= 8 ) && ( code < 28 ) ) {
+				offset = deflate_bench_bits ( offset,
+					( dup_len - deflate_bench_len_base[code] ),
+					( ( code / 4 ) - 1 ) );
+			}
+
+			/* Encode distance */
+			for ( code = 29 ; deflate_bench_dist_base[code] > distance ;
+			      code-- ) {}
+			offset = deflate_bench_huf ( offset, code, 5 );
+			if ( code >= 4 ) {
+				offset = deflate_bench_bits ( offset,
+					( distance - deflate_bench_dist_base[code] ),
+					( ( code / 2 ) - 1 ) );
+			}
+
+			/* Record duplicated string (byte-by-byte, to allow
+			 * for overlap).
+			 */
+			for ( i = 0 ; i < dup_len ; i++, len++ ) {
+				deflate_bench_expected[len] =
+					deflate_bench_expected[ len - distance ];
+			}
+
+		} else {
+
+			/* Append literal run */
+			for ( i = deflate_bench_random ( 8 ) ;
+			      ( i-- && ( len < DEFLATE_BENCH_LEN ) ) ; len++ ) {
+				code = ( 'a' + deflate_bench_random ( 27 ) );
+				if ( code > 'z' )
+					code = ' ';
+				offset = deflate_bench_litlen ( offset, code );
+				deflate_bench_expected[len] = code;
+			}
+		}
+	}
+
+	/* Construct end of block */
+	offset = deflate_bench_litlen ( offset, DEFLATE_LITLEN_END );
+	deflate_bench_compressed_len = ( ( offset + 7 ) / 8 );
+}
+
+/** Decompressor */
+static struct deflate *deflate_bench_deflate;
+
+/** Decompressed data */
+static uint8_t *deflate_bench_data;
+
+/**
+ * Prepare DEFLATE benchmark
+ *
+ * @ret rc		Return status code
+ */
+static int deflate_bench_setup ( void ) {
+
+	/* Allocate decompressor and output buffer */
+	deflate_bench_deflate = malloc ( sizeof ( *deflate_bench_deflate ) );
+	deflate_bench_data = malloc ( DEFLATE_BENCH_LEN );
+	if ( ! ( deflate_bench_deflate && deflate_bench_data ) ) {
+		free ( deflate_bench_deflate );
+		free ( deflate_bench_data );
+		return -ENOMEM;
+	}
+
+	/* Generate compressed data */
+	deflate_bench_generate();
+
+	return 0;
+}
+
+/**
+ * Run DEFLATE benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int deflate_bench_exec ( void ) {
+	struct deflate_chunk in;
+	struct deflate_chunk out;
+
+	/* Decompress generated data */
+	deflate_chunk_init ( &in, virt_to_user ( deflate_bench_compressed ),
+			     0, deflate_bench_compressed_len );
+	deflate_chunk_init ( &out, virt_to_user ( deflate_bench_data ),
+			     0, DEFLATE_BENCH_LEN );
+	deflate_init ( deflate_bench_deflate, DEFLATE_RAW );
+	return deflate_inflate ( deflate_bench_deflate, &in, &out );
+}
+
+/**
+ * Clean up after DEFLATE benchmark
+ *
+ */
+static void deflate_bench_teardown ( void ) {
+
+	free ( deflate_bench_data );
+	free ( deflate_bench_deflate );
+}
+
+/** DEFLATE decompression benchmark */
+struct benchmark deflate_benchmark __benchmark = {
+	.name = "inflate",
+	.len = DEFLATE_BENCH_LEN,
+	.setup = deflate_bench_setup,
+	.exec = deflate_bench_exec,
+	.teardown = deflate_bench_teardown,
+};
@@ -0,0 +1,27 @@
+#ifndef _DEFLATE_BENCH_H
+#define _DEFLATE_BENCH_H
+
+/** @file
+ *
+ * DEFLATE benchmarks
+ *
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdint.h>
+
+/** Length of generated benchmark data */
+#define DEFLATE_BENCH_LEN 65536
+
+/** Maximum length of generated benchmark compressed data */
+#define DEFLATE_BENCH_MAX_COMPRESSED_LEN \
+	( DEFLATE_BENCH_LEN + ( DEFLATE_BENCH_LEN / 8 ) + 16 )
+
+extern uint8_t deflate_bench_expected[DEFLATE_BENCH_LEN];
+extern uint8_t deflate_bench_compressed[DEFLATE_BENCH_MAX_COMPRESSED_LEN];
+extern size_t deflate_bench_compressed_len;
+
+extern void deflate_bench_generate ( void );
+
+#endif /* _DEFLATE_BENCH_H */
@@ -36,7 +36,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdlib.h>
 #include <string.h>
 #include <ipxe/deflate.h>
+#include <ipxe/profile.h>
 #include <ipxe/test.h>
+#include "deflate_bench.h"
+
+/** Number of sample iterations for profiling */
+#define PROFILE_COUNT 16
 
 /** A DEFLATE test */
 struct deflate_test {
@@ -133,6 +138,32 @@ DEFLATE ( zlib, DEFLATE_ZLIB,
 		 0x65, 0x63, 0x69, 0x66, 0x69, 0x63, 0x61, 0x74, 0x69, 0x6f,
 		 0x6e ) );
 
+/* "GZIP file format specification version 4.3" (with file name) */
+DEFLATE ( gzip, DEFLATE_GZIP,
+	  DATA ( 0x1f, 0x8b, 0x08, 0x08, 0x00, 0x00, 0x00, 0x00, 0x02, 0xff,
+		 0x72, 0x66, 0x63, 0x31, 0x39, 0x35, 0x32, 0x2e, 0x74, 0x78,
+		 0x74, 0x00, 0x73, 0x8f, 0xf2, 0x0c, 0x50, 0x48, 0xcb, 0xcc,
+		 0x49, 0x55, 0x48, 0xcb, 0x2f, 0xca, 0x4d, 0x2c, 0x51, 0x28,
+		 0x2e, 0x48, 0x4d, 0xce, 0x4c, 0xcb, 0x4c, 0x4e, 0x2c, 0xc9,
+		 0xcc, 0xcf, 0x53, 0x28, 0x4b, 0x2d, 0x2a, 0x06, 0xd1, 0x26,
+		 0x7a, 0xc6, 0x00, 0xde, 0x2b, 0xcf, 0xca, 0x2a, 0x00, 0x00,
+		 0x00 ),
+	  DATA ( 0x47, 0x5a, 0x49, 0x50, 0x20, 0x66, 0x69, 0x6c, 0x65, 0x20,
+		 0x66, 0x6f, 0x72, 0x6d, 0x61, 0x74, 0x20, 0x73, 0x70, 0x65,
+		 0x63, 0x69, 0x66, 0x69, 0x63, 0x61, 0x74, 0x69, 0x6f, 0x6e,
+		 0x20, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6f, 0x6e, 0x20, 0x34,
+		 0x2e, 0x33 ) );
+
+/* "iPXE iPXE iPXE" (with extra field, file name, comment and header CRC) */
+DEFLATE ( gzip_fields, DEFLATE_GZIP,
+	  DATA ( 0x1f, 0x8b, 0x08, 0x1e, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03,
+		 0x04, 0x00, 0x61, 0x62, 0x00, 0x01, 0x6e, 0x61, 0x6d, 0x65,
+		 0x00, 0x63, 0x6f, 0x6d, 0x6d, 0x65, 0x6e, 0x74, 0x00, 0x3c,
+		 0x86, 0xcb, 0x0c, 0x88, 0x70, 0x55, 0xc8, 0x84, 0x11, 0x00,
+		 0x18, 0x87, 0x41, 0x5d, 0x0e, 0x00, 0x00, 0x00 ),
+	  DATA ( 0x69, 0x50, 0x58, 0x45, 0x20, 0x69, 0x50, 0x58, 0x45, 0x20,
+		 0x69, 0x50, 0x58, 0x45 ) );
+
 /* "ZLIB Compressed Data Format Specification" fragment list */
 static struct deflate_test_fragments zlib_fragments[] = {
 	{ { -1UL, } },
@@ -143,6 +174,14 @@ static struct deflate_test_fragments zlib_fragments[] = {
 	{ { 48, -1UL } },
 };
 
+/* "iPXE iPXE iPXE" (with all header fields) fragment list */
+static struct deflate_test_fragments gzip_fields_fragments[] = {
+	{ { 1, 1, 1, 1, 1, 1, 1, -1UL } },
+	{ { 11, 1, 3, 5, 7, 1, 1, -1UL } },
+	{ { 0, 14, 0, 15, 1, 9, 1, -1UL } },
+	{ { 47, -1UL } },
+};
+
 /**
  * Report DEFLATE test result
  *
@@ -207,6 +246,81 @@ static void deflate_okx ( struct deflate *deflate,
 #define deflate_ok( deflate, test, frags ) \
 	deflate_okx ( deflate, test, frags, __FILE__, __LINE__ )
 
+/** Benchmark decompressed data */
+static uint8_t deflate_bench_out[DEFLATE_BENCH_LEN];
+
+/**
+ * Report a DEFLATE benchmark data test result
+ *
+ * @v deflate		Decompressor
+ * @v frag_len		Input fragment length
+ * @v out_len		Output buffer length
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void deflate_bench_okx ( struct deflate *deflate, size_t frag_len,
+				size_t out_len, const char *file,
+				unsigned int line ) {
+	struct deflate_chunk in;
+	struct deflate_chunk out;
+	size_t offset;
+
+	/* Decompress in fragments */
+	deflate_init ( deflate, DEFLATE_RAW );
+	memset ( deflate_bench_out, 0, sizeof ( deflate_bench_out ) );
+	deflate_chunk_init ( &out, virt_to_user ( deflate_bench_out ), 0,
+			     out_len );
+	for ( offset = 0 ; offset < deflate_bench_compressed_len ;
+	      offset += frag_len ) {
+		if ( frag_len > ( deflate_bench_compressed_len - offset ) )
+			frag_len = ( deflate_bench_compressed_len - offset );
+		deflate_chunk_init ( &in,
+				     virt_to_user ( deflate_bench_compressed ),
+				     offset, ( offset + frag_len ) );
+		okx ( deflate_inflate ( deflate, &in, &out ) == 0, file, line );
+		okx ( in.offset == in.len, file, line );
+	}
+
+	/* Check result */
+	okx ( deflate_finished ( deflate ), file, line );
+	okx ( out.offset == DEFLATE_BENCH_LEN, file, line );
+	okx ( memcmp ( deflate_bench_out, deflate_bench_expected,
+		       out_len ) == 0, file, line );
+}
+#define deflate_bench_ok( deflate, frag_len, out_len )			\
+	deflate_bench_okx ( deflate, frag_len, out_len, __FILE__, __LINE__ )
+
+/**
+ * Calculate DEFLATE decompression cost
+ *
+ * @v deflate		Decompressor
+ * @ret cost		Cost (in cycles per decompressed byte)
+ */
+static unsigned long deflate_cost ( struct deflate *deflate ) {
+	struct profiler profiler;
+	struct deflate_chunk in;
+	struct deflate_chunk out;
+	unsigned int i;
+
+	/* Profile decompression */
+	memset ( &profiler, 0, sizeof ( profiler ) );
+	for ( i = 0 ; i < PROFILE_COUNT ; i++ ) {
+		deflate_chunk_init ( &in,
+				     virt_to_user ( deflate_bench_compressed ),
+				     0, deflate_bench_compressed_len );
+		deflate_chunk_init ( &out, virt_to_user ( deflate_bench_out ),
+				     0, sizeof ( deflate_bench_out ) );
+		profile_start ( &profiler );
+		deflate_init ( deflate, DEFLATE_RAW );
+		deflate_inflate ( deflate, &in, &out );
+		profile_stop ( &profiler );
+	}
+
+	/* Round to nearest whole number of cycles per byte */
+	return ( ( profile_mean ( &profiler ) + ( DEFLATE_BENCH_LEN / 2 ) ) /
+		 DEFLATE_BENCH_LEN );
+}
+
 /**
  * Perform DEFLATE self-test
  *
@@ -231,12 +345,32 @@ static void deflate_test_exec ( void ) {
 		deflate_ok ( deflate, &hello_hello_world, NULL );
 		deflate_ok ( deflate, &rfc_sentence, NULL );
 		deflate_ok ( deflate, &zlib, NULL );
+		deflate_ok ( deflate, &gzip, NULL );
+		deflate_ok ( deflate, &gzip_fields, NULL );
 
 		/* Test fragmentation */
 		for ( i = 0 ; i < ( sizeof ( zlib_fragments ) /
 				    sizeof ( zlib_fragments[0] ) ) ; i++ ) {
 			deflate_ok ( deflate, &zlib, &zlib_fragments[i] );
 		}
+		for ( i = 0 ; i < ( sizeof ( gzip_fields_fragments ) /
+				    sizeof ( gzip_fields_fragments[0] ) ) ; i++ ) {
+			deflate_ok ( deflate, &gzip_fields,
+				     &gzip_fields_fragments[i] );
+		}
+
+		/* Test generated data */
+		deflate_bench_generate();
+		deflate_bench_ok ( deflate, -1UL, DEFLATE_BENCH_LEN );
+		deflate_bench_ok ( deflate, 1, DEFLATE_BENCH_LEN );
+		deflate_bench_ok ( deflate, 7, DEFLATE_BENCH_LEN );
+		deflate_bench_ok ( deflate, 1000, DEFLATE_BENCH_LEN );
+		deflate_bench_ok ( deflate, -1UL, ( DEFLATE_BENCH_LEN / 3 ) );
+		deflate_bench_ok ( deflate, -1UL, 0 );
+
+		/* Speed test */
+		DBG ( "DEFLATE required %ld cycles per byte\n",
+		      deflate_cost ( deflate ) );
 	}
 
 	/* Free shared structure */
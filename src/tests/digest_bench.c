@@ -0,0 +1,102 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Digest algorithm benchmarks
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <ipxe/crypto.h>
+#include <ipxe/md5.h>
+#include <ipxe/sha1.h>
+#include <ipxe/sha256.h>
+#include <ipxe/sha512.h>
+#include <ipxe/bench.h>
+
+/** Length of data used by digest benchmarks */
+#define DIGEST_BENCH_LEN 8192
+
+/** Pseudo-random data (too large for stack) */
+static uint8_t digest_bench_data[DIGEST_BENCH_LEN];
+
+/**
+ * Define a digest algorithm benchmark
+ *
+ * @v _name		Benchmark name
+ * @v _digest		Digest algorithm
+ */
+#define DIGEST_BENCH( _name, _digest )					\
+	static int _name ## _bench_exec ( void ) {			\
+		return digest_bench_exec ( _digest );			\
+	}								\
+	struct benchmark _name ## _benchmark __benchmark = {		\
+		.name = #_name,						\
+		.len = DIGEST_BENCH_LEN,				\
+		.setup = digest_bench_setup,				\
+		.exec = _name ## _bench_exec,				\
+	}
+
+/**
+ * Prepare digest benchmark
+ *
+ * @ret rc		Return status code
+ */
+static int digest_bench_setup ( void ) {
+	unsigned int i;
+
+	/* Fill buffer with pseudo-random data */
+	srand ( 0x1234568 );
+	for ( i = 0 ; i < sizeof ( digest_bench_data ) ; i++ )
+		digest_bench_data[i] = rand();
+
+	return 0;
+}
+
+/**
+ * Run digest benchmark iteration
+ *
+ * @v digest		Digest algorithm
+ * @ret rc		Return status code
+ */
+static int digest_bench_exec ( struct digest_algorithm *digest ) {
+	uint8_t ctx[digest->ctxsize];
+	uint8_t out[digest->digestsize];
+
+	/* Calculate digest */
+	digest_init ( digest, ctx );
+	digest_update ( digest, ctx, digest_bench_data,
+			sizeof ( digest_bench_data ) );
+	digest_final ( digest, ctx, out );
+
+	return 0;
+}
+
+DIGEST_BENCH ( md5, &md5_algorithm );
+DIGEST_BENCH ( sha1, &sha1_algorithm );
+DIGEST_BENCH ( sha256, &sha256_algorithm );
+DIGEST_BENCH ( sha512, &sha512_algorithm );
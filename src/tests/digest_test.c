@@ -57,6 +57,21 @@ static struct digest_test_fragments digest_test_fragments[] = {
 /** Number of sample iterations for profiling */
 #define PROFILE_COUNT 16
 
+/** Pseudo-random data for bulk tests and profiling (too large for stack) */
+static uint8_t digest_random[8192];
+
+/**
+ * Fill buffer with pseudo-random data
+ *
+ */
+static void digest_random_fill ( void ) {
+	unsigned int i;
+
+	srand ( 0x1234568 );
+	for ( i = 0 ; i < sizeof ( digest_random ) ; i++ )
+		digest_random[i] = rand();
+}
+
 /**
  * Report a digest fragmented test result
  *
@@ -122,6 +137,44 @@ void digest_okx ( struct digest_test *test, const char *file,
 	}
 }
 
+/**
+ * Report a digest bulk data test result
+ *
+ * @v digest		Digest algorithm
+ * @v file		Test code file
+ * @v line		Test code line
+ *
+ * Whole blocks passed in a single update may be digested by an
+ * architecture-specific implementation (e.g. using CPU extensions),
+ * while data passed one byte at a time is always accumulated and
+ * digested by the generic implementation.  Check that both produce
+ * the same result.
+ */
+void digest_bulk_okx ( struct digest_algorithm *digest, const char *file,
+		       unsigned int line ) {
+	uint8_t ctx[digest->ctxsize];
+	uint8_t bulk[digest->digestsize];
+	uint8_t bytewise[digest->digestsize];
+	unsigned int i;
+
+	/* Fill buffer with pseudo-random data */
+	digest_random_fill();
+
+	/* Digest as a single update */
+	digest_init ( digest, ctx );
+	digest_update ( digest, ctx, digest_random, sizeof ( digest_random ) );
+	digest_final ( digest, ctx, bulk );
+
+	/* Digest one byte at a time */
+	digest_init ( digest, ctx );
+	for ( i = 0 ; i < sizeof ( digest_random ) ; i++ )
+		digest_update ( digest, ctx, &digest_random[i], 1 );
+	digest_final ( digest, ctx, bytewise );
+
+	/* Compare results */
+	okx ( memcmp ( bulk, bytewise, sizeof ( bulk ) ) == 0, file, line );
+}
+
 /**
  * Calculate digest algorithm cost
  *
@@ -129,7 +182,8 @@ void digest_okx ( struct digest_test *test, const char *file,
  * @ret cost		Cost (in cycles per byte)
  */
 unsigned long digest_cost ( struct digest_algorithm *digest ) {
-	static uint8_t random[8192]; /* Too large for stack */
+	uint8_t *random = digest_random;
+	size_t len = sizeof ( digest_random );
 	uint8_t ctx[digest->ctxsize];
 	uint8_t out[digest->digestsize];
 	struct profiler profiler;
@@ -137,23 +191,20 @@ unsigned long digest_cost ( struct digest_algorithm *digest ) {
 	unsigned int i;
 
 	/* Fill buffer with pseudo-random data */
-	srand ( 0x1234568 );
-	for ( i = 0 ; i < sizeof ( random ) ; i++ )
-		random[i] = rand();
+	digest_random_fill();
 
 	/* Profile digest calculation */
 	memset ( &profiler, 0, sizeof ( profiler ) );
 	for ( i = 0 ; i < PROFILE_COUNT ; i++ ) {
 		profile_start ( &profiler );
 		digest_init ( digest, ctx );
-		digest_update ( digest, ctx, random, sizeof ( random ) );
+		digest_update ( digest, ctx, random, len );
 		digest_final ( digest, ctx, out );
 		profile_stop ( &profiler );
 	}
 
 	/* Round to nearest whole number of cycles per byte */
-	cost = ( ( profile_mean ( &profiler ) + ( sizeof ( random ) / 2 ) ) /
-		 sizeof ( random ) );
+	cost = ( ( profile_mean ( &profiler ) + ( len / 2 ) ) / len );
 
 	return cost;
 }
@@ -108,8 +108,17 @@ struct digest_test {
  */
 #define digest_ok(test) digest_okx ( test, __FILE__, __LINE__ )
 
+/**
+ * Report a digest bulk data test result
+ *
+ * @v digest		Digest algorithm
+ */
+#define digest_bulk_ok(digest) digest_bulk_okx ( digest, __FILE__, __LINE__ )
+
 extern void digest_okx ( struct digest_test *test, const char *file,
 			 unsigned int line );
+extern void digest_bulk_okx ( struct digest_algorithm *digest,
+			      const char *file, unsigned int line );
 extern unsigned long digest_cost ( struct digest_algorithm *digest );
 
 #endif /* _DIGEST_TEST_H */
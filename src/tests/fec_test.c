@@ -0,0 +1,149 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Forward error correction self-tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/fec.h>
+#include <ipxe/test.h>
+
+/** Maximum number of data symbols used in tests */
+#define FEC_TEST_MAX_K 16
+
+/** Symbol length used in tests */
+#define FEC_TEST_LEN 37
+
+/** Data symbols */
+static uint8_t fec_data[FEC_TEST_MAX_K][FEC_TEST_LEN];
+
+/** Repair symbols */
+static uint8_t fec_repair[FEC_TEST_MAX_K][FEC_TEST_LEN];
+
+/**
+ * Report a recovery test result
+ *
+ * @v k			Number of data symbols
+ * @v count		Number of missing data symbols
+ * @v rows		Repair symbols to use
+ * @v missing		Missing data symbols
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void fec_recover_okx ( unsigned int k, unsigned int count,
+			      const unsigned int *rows,
+			      const unsigned int *missing,
+			      const char *file, unsigned int line ) {
+	const void *data[k];
+	void *blocks[count];
+	unsigned int i;
+	unsigned int j;
+	int known;
+
+	/* Construct repair symbols */
+	for ( i = 0 ; i < k ; i++ )
+		data[i] = fec_data[i];
+	for ( i = 0 ; i < count ; i++ ) {
+		fec_encode ( k, rows[i], data, fec_repair[i], FEC_TEST_LEN );
+		blocks[i] = fec_repair[i];
+	}
+
+	/* Remove contributions of known data symbols */
+	for ( i = 0 ; i < k ; i++ ) {
+		known = 1;
+		for ( j = 0 ; j < count ; j++ ) {
+			if ( missing[j] == i )
+				known = 0;
+		}
+		if ( ! known )
+			continue;
+		for ( j = 0 ; j < count ; j++ ) {
+			fec_mul_add ( fec_coefficient ( k, rows[j], i ),
+				      fec_data[i], blocks[j], FEC_TEST_LEN );
+		}
+	}
+
+	/* Recover missing data symbols */
+	okx ( fec_recover ( k, count, rows, missing, blocks,
+			    FEC_TEST_LEN ) == 0, file, line );
+	for ( i = 0 ; i < count ; i++ ) {
+		okx ( memcmp ( blocks[i], fec_data[ missing[i] ],
+			       FEC_TEST_LEN ) == 0, file, line );
+	}
+}
+#define fec_recover_ok( k, rows, missing )				\
+	fec_recover_okx ( k, ( sizeof ( rows ) / sizeof ( rows[0] ) ),	\
+			  rows, missing, __FILE__, __LINE__ )
+
+/**
+ * Perform forward error correction self-tests
+ *
+ */
+static void fec_test_exec ( void ) {
+	static const unsigned int rows_one[] = { 0 };
+	static const unsigned int missing_one[] = { 0 };
+	static const unsigned int rows_some[] = { 7, 0, 3 };
+	static const unsigned int missing_some[] = { 5, 1, 6 };
+	static const unsigned int rows_all[] = { 3, 2, 1, 0 };
+	static const unsigned int missing_all[] = { 0, 1, 2, 3 };
+	static const unsigned int rows_high[] = { 239, 100 };
+	static const unsigned int missing_high[] = { 15, 0 };
+	static const unsigned int rows_dup[] = { 1, 1 };
+	static const unsigned int missing_dup[] = { 0, 1 };
+	void *blocks[2] = { fec_repair[0], fec_repair[1] };
+	unsigned int i;
+	unsigned int j;
+
+	/* Construct data symbols */
+	for ( i = 0 ; i < FEC_TEST_MAX_K ; i++ ) {
+		for ( j = 0 ; j < FEC_TEST_LEN ; j++ )
+			fec_data[i][j] = ( ( i * 71 ) + ( j * 13 ) + 5 );
+	}
+	fec_data[2][0] = 0;
+
+	/* Recover from various combinations of losses */
+	fec_recover_ok ( 1, rows_one, missing_one );
+	fec_recover_ok ( 8, rows_some, missing_some );
+	fec_recover_ok ( 4, rows_all, missing_all );
+	fec_recover_ok ( 16, rows_high, missing_high );
+
+	/* Duplicate repair symbols are rejected */
+	ok ( fec_recover ( 4, 2, rows_dup, missing_dup, blocks,
+			   FEC_TEST_LEN ) != 0 );
+}
+
+/** Forward error correction self-test */
+struct self_test fec_test __self_test = {
+	.name = "fec",
+	.exec = fec_test_exec,
+};
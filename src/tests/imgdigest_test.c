@@ -0,0 +1,170 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Image digest self-tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/uaccess.h>
+#include <ipxe/image.h>
+#include <ipxe/md5.h>
+#include <ipxe/sha256.h>
+#include <ipxe/imgdigest.h>
+#include <ipxe/test.h>
+
+/** Image contents */
+static uint8_t imgdigest_data[1000];
+
+/** Data delivered during "download" (differs from image contents) */
+static uint8_t imgdigest_delivered[ sizeof ( imgdigest_data ) ];
+
+/**
+ * Calculate digest directly
+ *
+ * @v algorithm		Digest algorithm
+ * @v data		Data
+ * @v len		Length of data
+ * @v out		Digest output
+ */
+static void imgdigest_calculate ( struct digest_algorithm *algorithm,
+				  const void *data, size_t len, void *out ) {
+	uint8_t ctx[algorithm->ctxsize];
+
+	digest_init ( algorithm, ctx );
+	digest_update ( algorithm, ctx, data, len );
+	digest_final ( algorithm, ctx, out );
+}
+
+/**
+ * Perform image digest self-tests
+ *
+ */
+static void imgdigest_test_exec ( void ) {
+	struct image_digest *digest;
+	struct image image;
+	uint8_t image_sha256[SHA256_DIGEST_SIZE];
+	uint8_t delivered_sha256[SHA256_DIGEST_SIZE];
+	uint8_t delivered_md5[MD5_DIGEST_SIZE];
+	uint8_t out[SHA256_DIGEST_SIZE];
+	unsigned int i;
+
+	/* Construct image whose contents differ from the delivered
+	 * data, so that we can tell whether or not the cached digest
+	 * was used.
+	 */
+	for ( i = 0 ; i < sizeof ( imgdigest_data ) ; i++ ) {
+		imgdigest_data[i] = i;
+		imgdigest_delivered[i] = ( i ^ 0x5a );
+	}
+	memset ( &image, 0, sizeof ( image ) );
+	image.name = "test";
+	image.data = virt_to_user ( imgdigest_data );
+	image.len = sizeof ( imgdigest_data );
+	imgdigest_calculate ( &sha256_algorithm, imgdigest_data,
+			      sizeof ( imgdigest_data ), image_sha256 );
+	imgdigest_calculate ( &sha256_algorithm, imgdigest_delivered,
+			      sizeof ( imgdigest_delivered ), delivered_sha256 );
+	imgdigest_calculate ( &md5_algorithm, imgdigest_delivered,
+			      sizeof ( imgdigest_delivered ), delivered_md5 );
+
+	/* No cached digests: digest is calculated from image */
+	image_digest ( &image, &sha256_algorithm, out );
+	ok ( memcmp ( out, image_sha256, sizeof ( out ) ) == 0 );
+
+	/* In-order delivery: cached digests are used */
+	ok ( image_digest_add ( &image, &sha256_algorithm ) == 0 );
+	ok ( image_digest_add ( &image, &md5_algorithm ) == 0 );
+	image_digest_update ( &image, 0, imgdigest_delivered, 100 );
+	image_digest_update ( &image, 100, ( imgdigest_delivered + 100 ),
+			      ( sizeof ( imgdigest_delivered ) - 100 ) );
+	ok ( image.digests != NULL );
+	image_digest_final ( &image );
+	image_digest ( &image, &sha256_algorithm, out );
+	ok ( memcmp ( out, delivered_sha256, sizeof ( out ) ) == 0 );
+	image_digest ( &image, &md5_algorithm, out );
+	ok ( memcmp ( out, delivered_md5, sizeof ( delivered_md5 ) ) == 0 );
+
+	/* Finalised digests must not be updated further */
+	image_digest_update ( &image, sizeof ( imgdigest_delivered ),
+			      imgdigest_delivered, 1 );
+	ok ( image.digests == NULL );
+
+	/* Unfinalised digest is not used */
+	ok ( image_digest_add ( &image, &sha256_algorithm ) == 0 );
+	image_digest_update ( &image, 0, imgdigest_delivered,
+			      sizeof ( imgdigest_delivered ) );
+	image_digest ( &image, &sha256_algorithm, out );
+	ok ( memcmp ( out, image_sha256, sizeof ( out ) ) == 0 );
+	image_digest_discard ( &image );
+	ok ( image.digests == NULL );
+
+	/* Gap in delivered data discards digests */
+	ok ( image_digest_add ( &image, &sha256_algorithm ) == 0 );
+	image_digest_update ( &image, 0, imgdigest_delivered, 100 );
+	image_digest_update ( &image, 200, ( imgdigest_delivered + 200 ),
+			      ( sizeof ( imgdigest_delivered ) - 200 ) );
+	ok ( image.digests == NULL );
+	image_digest_final ( &image );
+	image_digest ( &image, &sha256_algorithm, out );
+	ok ( memcmp ( out, image_sha256, sizeof ( out ) ) == 0 );
+
+	/* Repeated (non-sequential) data discards digests */
+	ok ( image_digest_add ( &image, &sha256_algorithm ) == 0 );
+	image_digest_update ( &image, 0, imgdigest_delivered, 100 );
+	image_digest_update ( &image, 50, ( imgdigest_delivered + 50 ),
+			      ( sizeof ( imgdigest_delivered ) - 50 ) );
+	ok ( image.digests == NULL );
+
+	/* Digest covering only part of the image is not used */
+	ok ( image_digest_add ( &image, &sha256_algorithm ) == 0 );
+	image_digest_update ( &image, 0, imgdigest_delivered,
+			      ( sizeof ( imgdigest_delivered ) - 1 ) );
+	image_digest_final ( &image );
+	image_digest ( &image, &sha256_algorithm, out );
+	ok ( memcmp ( out, image_sha256, sizeof ( out ) ) == 0 );
+	image_digest_discard ( &image );
+
+	/* Starting afresh discards any existing digests */
+	ok ( image_digest_add ( &image, &sha256_algorithm ) == 0 );
+	image_digest_update ( &image, 0, imgdigest_delivered, 100 );
+	ok ( image_digest_start ( &image ) == 0 );
+	for ( digest = image.digests ; digest ; digest = digest->next )
+		ok ( digest->len == 0 );
+	image_digest_discard ( &image );
+	ok ( image.digests == NULL );
+}
+
+/** Image digest self-test */
+struct self_test imgdigest_test __self_test = {
+	.name = "imgdigest",
+	.exec = imgdigest_test_exec,
+};
@@ -89,6 +89,19 @@ __attribute__ (( noinline )) void * memcpy_var ( void *dest, const void *src,
 	return memcpy ( dest, src, len );
 }
 
+/**
+ * Force a call to the variable-length implementation of memmove()
+ *
+ * @v dest		Destination address
+ * @v src		Source address
+ * @v len		Length of data
+ * @ret dest		Destination address
+ */
+__attribute__ (( noinline )) void * memmove_var ( void *dest, const void *src,
+						  size_t len ) {
+	return memmove ( dest, src, len );
+}
+
 /**
  * Perform a constant-length memcpy() test
  *
@@ -164,6 +177,69 @@ static void memcpy_test_speed ( unsigned int dest_offset,
 	      profile_stddev ( &profiler ) );
 }
 
+/**
+ * Test overlapping memmove() correctness
+ *
+ * @v dest_offset	Destination offset within buffer
+ * @v src_offset	Source offset within buffer
+ * @v len		Length of data to move
+ */
+static void memmove_test_overlap ( unsigned int dest_offset,
+				   unsigned int src_offset, size_t len ) {
+	uint8_t buf[ 64 ];
+	uint8_t expected[ sizeof ( buf ) ];
+	unsigned int i;
+
+	/* Sanity check */
+	assert ( ( dest_offset + len ) <= sizeof ( buf ) );
+	assert ( ( src_offset + len ) <= sizeof ( buf ) );
+
+	/* Construct buffer and expected result */
+	for ( i = 0 ; i < sizeof ( buf ) ; i++ )
+		buf[i] = expected[i] = ( i ^ 0xa5 );
+	for ( i = 0 ; i < len ; i++ )
+		expected[ dest_offset + i ] = buf[ src_offset + i ];
+
+	/* Move data and compare whole buffer */
+	memmove_var ( ( buf + dest_offset ), ( buf + src_offset ), len );
+	ok ( memcmp ( buf, expected, sizeof ( buf ) ) == 0 );
+}
+
+/**
+ * Test memmove() speed
+ *
+ * @v offset		Destination offset relative to source
+ * @v len		Length of data to move
+ */
+static void memmove_test_speed ( unsigned int offset, size_t len ) {
+	struct profiler profiler;
+	uint8_t *buf;
+	unsigned int i;
+
+	/* Allocate block */
+	buf = malloc ( len + offset );
+	assert ( buf != NULL );
+
+	/* Generate random data */
+	for ( i = 0 ; i < len ; i++ )
+		buf[i] = random();
+
+	/* Profile backwards memmove() */
+	memset ( &profiler, 0, sizeof ( profiler ) );
+	for ( i = 0 ; i < PROFILE_COUNT ; i++ ) {
+		profile_start ( &profiler );
+		memmove ( ( buf + offset ), buf, len );
+		profile_stop ( &profiler );
+	}
+
+	/* Free block */
+	free ( buf );
+
+	DBG ( "MEMMOVE moved %zd bytes (+%d) in %ld +/- %ld ticks\n",
+	      len, offset, profile_mean ( &profiler ),
+	      profile_stddev ( &profiler ) );
+}
+
 /**
  * Perform memcpy() self-tests
  *
@@ -171,6 +247,7 @@ static void memcpy_test_speed ( unsigned int dest_offset,
 static void memcpy_test_exec ( void ) {
 	unsigned int dest_offset;
 	unsigned int src_offset;
+	unsigned int len;
 
 	/* Constant-length tests */
 	MEMCPY_TEST_CONSTANT ( );
@@ -264,6 +341,24 @@ static void memcpy_test_exec ( void ) {
 			memcpy_test_speed ( dest_offset, src_offset, 4096 );
 		}
 	}
+	memcpy_test_speed ( 0, 0, 65536 );
+
+	/* Overlapping memmove() tests */
+	for ( len = 0 ; len <= 33 ; len++ ) {
+		for ( src_offset = 0 ; src_offset < 10 ; src_offset++ ) {
+			memmove_test_overlap ( ( src_offset + 1 ), src_offset,
+					       len );
+			memmove_test_overlap ( ( src_offset + 9 ), src_offset,
+					       len );
+			memmove_test_overlap ( src_offset, ( src_offset + 3 ),
+					       len );
+		}
+	}
+
+	/* memmove() speed tests */
+	memmove_test_speed ( 1, 4096 );
+	memmove_test_speed ( 8, 4096 );
+	memmove_test_speed ( 8, 65536 );
 }
 
 /** memcpy() self-test */
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Peer Content Caching and Retrieval: Discovery Protocol [MS-PCCRD] tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdlib.h>
+#include <string.h>
+#include <ipxe/pccrd.h>
+#include <ipxe/test.h>
+
+/** Segment identifier used in tests */
+#define PCCRD_TEST_ID							\
+	"9B7F8A2C4D3E1F0A9B7F8A2C4D3E1F0A9B7F8A2C4D3E1F0A9B7F8A2C4D3E1F0A"
+
+/**
+ * Perform discovery protocol self-tests
+ *
+ */
+static void pccrd_test_exec ( void ) {
+	struct peerdist_discovery_probe probe;
+	struct peerdist_discovery_reply reply;
+	char *request;
+	char *match;
+
+	/* Discovery request is parsed as a probe */
+	request = peerdist_discovery_request ( "request-uuid", PCCRD_TEST_ID );
+	ok ( request != NULL );
+	ok ( peerdist_discovery_probe ( request, strlen ( request ),
+					&probe ) == 0 );
+	ok ( strcmp ( probe.message, "urn:uuid:request-uuid" ) == 0 );
+	ok ( strcmp ( probe.ids, PCCRD_TEST_ID ) == 0 );
+	ok ( probe.ids[ strlen ( probe.ids ) + 1 ] == '\0' );
+	free ( request );
+
+	/* Probe match is parsed as a reply, and segments with a zero
+	 * block count are omitted.
+	 */
+	match = peerdist_discovery_match ( "match-uuid",
+					   "urn:uuid:request-uuid",
+					   PCCRD_TEST_ID " 00", "192.168.0.1:80",
+					   "0000000400000000" );
+	ok ( match != NULL );
+	ok ( peerdist_discovery_reply ( match, strlen ( match ),
+					&reply ) == 0 );
+	ok ( strcmp ( reply.ids, PCCRD_TEST_ID ) == 0 );
+	ok ( reply.ids[ strlen ( reply.ids ) + 1 ] == '\0' );
+	ok ( strcmp ( reply.locations, "192.168.0.1:80" ) == 0 );
+
+	/* Probe match is not parsed as a probe */
+	ok ( peerdist_discovery_probe ( match, strlen ( match ),
+					&probe ) != 0 );
+	free ( match );
+}
+
+/** Discovery protocol self-test */
+struct self_test pccrd_test __self_test = {
+	.name = "pccrd",
+	.exec = pccrd_test_exec,
+};
@@ -205,6 +205,55 @@ struct rsa_signature_test {
 				sizeof ( bad_signature ) );		\
 	} while ( 0 )
 
+/**
+ * Report RSA-PSS signature test result
+ *
+ * @v test		RSA signature test
+ *
+ * RSA-PSS signatures are randomised, so the generated signature
+ * cannot be compared against the expected signature.  Instead, the
+ * expected signature is verified and the generated signature is
+ * checked by verifying it in turn.
+ */
+#define rsa_pss_signature_ok( test ) do {				\
+	struct pubkey_algorithm *pubkey = &rsa_pss_algorithm;		\
+	struct digest_algorithm *digest = (test)->digest;		\
+	uint8_t ctx[ pubkey->ctxsize ];					\
+	uint8_t digestctx[ digest->ctxsize ];				\
+	uint8_t digestout[ digest->digestsize ];			\
+	uint8_t signature[ (test)->signature_len ];			\
+	int signature_len;						\
+	pubkey_verify_ok ( pubkey, (test)->public, (test)->public_len,	\
+			   digest, (test)->plaintext,			\
+			   (test)->plaintext_len, (test)->signature,	\
+			   (test)->signature_len );			\
+	memset ( signature, 0, sizeof ( signature ) );			\
+	pubkey_verify_fail_ok ( pubkey, (test)->public,			\
+				(test)->public_len, digest,		\
+				(test)->plaintext,			\
+				(test)->plaintext_len, signature,	\
+				sizeof ( signature ) );			\
+	digest_init ( digest, digestctx );				\
+	digest_update ( digest, digestctx, (test)->plaintext,		\
+			(test)->plaintext_len );			\
+	digest_final ( digest, digestctx, digestout );			\
+	ok ( pubkey_init ( pubkey, ctx, (test)->private,		\
+			   (test)->private_len ) == 0 );		\
+	signature_len = pubkey_sign ( pubkey, ctx, digest, digestout,	\
+				      signature );			\
+	ok ( signature_len == ( ( int ) sizeof ( signature ) ) );	\
+	pubkey_final ( pubkey, ctx );					\
+	pubkey_verify_ok ( pubkey, (test)->public, (test)->public_len,	\
+			   digest, (test)->plaintext,			\
+			   (test)->plaintext_len, signature,		\
+			   sizeof ( signature ) );			\
+	pubkey_verify_fail_ok ( &rsa_algorithm, (test)->public,		\
+				(test)->public_len, digest,		\
+				(test)->plaintext,			\
+				(test)->plaintext_len, signature,	\
+				sizeof ( signature ) );			\
+	} while ( 0 )
+
 /** "Hello world" encryption and decryption test */
 RSA_ENCRYPT_DECRYPT_TEST ( hw_test,
 	PRIVATE ( 0x30, 0x82, 0x01, 0x3b, 0x02, 0x01, 0x00, 0x02, 0x41, 0x00,
@@ -478,6 +527,111 @@ RSA_SIGNATURE_TEST ( sha256_test,
 		    0x7d, 0x38, 0x37, 0xc4, 0xea, 0xdd, 0x3a, 0x6f, 0xa8, 0x65,
 		    0x60, 0x73, 0x77, 0x3c ) );
 
+/** Random message SHA-256 RSA-PSS signature test */
+RSA_SIGNATURE_TEST ( pss_sha256_test,
+	PRIVATE ( 0x30, 0x82, 0x02, 0x5d, 0x02, 0x01, 0x00, 0x02, 0x81, 0x81,
+		  0x00, 0xb4, 0xee, 0x81, 0xe8, 0xce, 0x53, 0x68, 0x58, 0xe8,
+		  0xc5, 0x27, 0x82, 0x59, 0x28, 0x20, 0x03, 0x44, 0x68, 0xe7,
+		  0x4a, 0x4e, 0xef, 0xe7, 0xfe, 0xc5, 0x6d, 0x8e, 0xbd, 0x8b,
+		  0xae, 0x26, 0xef, 0xe9, 0x7a, 0x32, 0xab, 0x8d, 0x59, 0x04,
+		  0x6a, 0xc9, 0x38, 0xf4, 0x5b, 0x3f, 0x32, 0x46, 0x15, 0x89,
+		  0xd0, 0x6e, 0xeb, 0x27, 0x4b, 0x74, 0x95, 0x6c, 0x2a, 0x63,
+		  0x35, 0xc8, 0x10, 0x2a, 0xf5, 0x2f, 0x17, 0x99, 0x83, 0xe9,
+		  0xbd, 0xfa, 0x7f, 0x64, 0x92, 0xa2, 0xbf, 0x34, 0xf7, 0xcb,
+		  0xab, 0xef, 0x1b, 0xc6, 0x97, 0x2c, 0xab, 0x9e, 0x99, 0x85,
+		  0x0f, 0x11, 0x22, 0x6c, 0x0e, 0xb9, 0x0d, 0xb3, 0xd5, 0x5c,
+		  0x4c, 0x86, 0x63, 0x59, 0xaf, 0xe3, 0xd9, 0x29, 0x2c, 0xa1,
+		  0x6d, 0x51, 0xa0, 0xb5, 0x78, 0xd8, 0x59, 0x0b, 0x7f, 0x4a,
+		  0xdf, 0x23, 0xae, 0x69, 0xe6, 0xff, 0x36, 0x7c, 0xcb, 0x02,
+		  0x03, 0x01, 0x00, 0x01, 0x02, 0x81, 0x80, 0x09, 0x6e, 0xfa,
+		  0x15, 0x02, 0x54, 0xf4, 0xf6, 0xd5, 0xc4, 0x19, 0xc8, 0x41,
+		  0x0f, 0xc7, 0x83, 0x84, 0x18, 0x98, 0x1e, 0x96, 0xb9, 0x09,
+		  0x76, 0x8e, 0x22, 0xa5, 0x33, 0x9a, 0xc9, 0xcc, 0xbb, 0xeb,
+		  0x87, 0x74, 0x86, 0xdf, 0x4a, 0xc9, 0xe1, 0x2b, 0x76, 0xad,
+		  0xbe, 0xe8, 0x2f, 0x9d, 0xd9, 0xd7, 0xa2, 0xa7, 0x75, 0xd9,
+		  0x49, 0xa4, 0xdd, 0x79, 0x93, 0x48, 0x32, 0xf0, 0xa8, 0x6f,
+		  0x24, 0xdc, 0xe9, 0xbd, 0xb1, 0x49, 0x77, 0x01, 0x10, 0x95,
+		  0x40, 0x90, 0xfd, 0x5c, 0x3f, 0x42, 0x2e, 0x98, 0x4a, 0x8d,
+		  0x9c, 0x74, 0xb5, 0x9e, 0x78, 0xa9, 0x7e, 0xab, 0xcc, 0xfb,
+		  0x30, 0x47, 0xc9, 0xa5, 0x52, 0x03, 0xee, 0x74, 0xe6, 0x4f,
+		  0x89, 0x72, 0xa4, 0x8d, 0x59, 0x5c, 0x9f, 0xaa, 0x43, 0x49,
+		  0x53, 0xcd, 0x8a, 0x5a, 0x34, 0x1b, 0x3a, 0xf7, 0x15, 0xd4,
+		  0x12, 0xd2, 0x6e, 0x92, 0x19, 0x02, 0x41, 0x00, 0xef, 0xd0,
+		  0x47, 0x99, 0xdc, 0x8d, 0xcc, 0xc3, 0x0c, 0x5f, 0x26, 0x6c,
+		  0x53, 0xf0, 0x60, 0x63, 0xc8, 0xb1, 0xc5, 0x71, 0x7e, 0x40,
+		  0x35, 0x88, 0x39, 0x0f, 0x2e, 0x30, 0xf9, 0x0a, 0x9f, 0x20,
+		  0x82, 0xba, 0x8c, 0xb7, 0x85, 0xa4, 0xc5, 0x45, 0x4b, 0xa2,
+		  0x58, 0x25, 0x57, 0xf7, 0xdf, 0x32, 0x7a, 0x8e, 0x82, 0x94,
+		  0x2b, 0x84, 0x34, 0xd0, 0xda, 0x70, 0xc8, 0xdd, 0x7f, 0x51,
+		  0xea, 0x9f, 0x02, 0x41, 0x00, 0xc1, 0x24, 0xcf, 0xc6, 0xe7,
+		  0x08, 0x48, 0x23, 0x68, 0xf8, 0xce, 0x37, 0x5d, 0xa6, 0x11,
+		  0x03, 0xc9, 0xba, 0x40, 0x27, 0x61, 0x65, 0x8d, 0x9b, 0x73,
+		  0x75, 0x09, 0xda, 0x39, 0x9b, 0xaa, 0x4d, 0x4e, 0x32, 0xea,
+		  0x84, 0x88, 0x84, 0x1c, 0x1d, 0x1d, 0x45, 0x6d, 0x2a, 0xcd,
+		  0x03, 0xf3, 0xd1, 0xfa, 0x8d, 0x85, 0x08, 0x18, 0xcf, 0x73,
+		  0x53, 0x43, 0x69, 0x98, 0x4c, 0x37, 0x0a, 0xaa, 0x55, 0x02,
+		  0x41, 0x00, 0xaf, 0xf9, 0x9b, 0x81, 0x09, 0x3a, 0x38, 0xa6,
+		  0x6c, 0x3e, 0xaa, 0x38, 0x55, 0xc4, 0x0f, 0x47, 0x49, 0xaf,
+		  0x41, 0x9e, 0x8d, 0xb1, 0x5a, 0x56, 0xf2, 0xdf, 0xf3, 0xda,
+		  0x55, 0xf5, 0x78, 0x5d, 0x67, 0xf0, 0xb2, 0x6f, 0xbd, 0x2e,
+		  0xf2, 0xdf, 0x6d, 0xa7, 0xdc, 0x9c, 0xd2, 0x97, 0x7e, 0x7e,
+		  0x51, 0x36, 0xa0, 0x15, 0x50, 0x75, 0x7c, 0x38, 0x42, 0x02,
+		  0xff, 0x32, 0xa2, 0x4a, 0x1f, 0x2b, 0x02, 0x40, 0x0c, 0xbe,
+		  0x45, 0x07, 0x36, 0x8f, 0x11, 0x53, 0x64, 0xc5, 0xa5, 0xb5,
+		  0x79, 0x74, 0x4f, 0x83, 0x14, 0x78, 0x39, 0x6b, 0x5f, 0xbd,
+		  0xb7, 0x8e, 0x1e, 0x1c, 0x06, 0xbe, 0x63, 0x36, 0xa6, 0x11,
+		  0xdb, 0xaa, 0xf8, 0x56, 0x2e, 0x3b, 0xa9, 0x2f, 0x32, 0x93,
+		  0x36, 0x14, 0xb0, 0xda, 0x25, 0xe8, 0x20, 0xc3, 0xdd, 0x97,
+		  0x1f, 0x2b, 0xf0, 0xcb, 0xf9, 0x92, 0xa9, 0xfd, 0xbd, 0x53,
+		  0xf2, 0xd1, 0x02, 0x41, 0x00, 0x96, 0x9f, 0x9e, 0xe3, 0xd6,
+		  0x6f, 0xbd, 0xbc, 0xb7, 0x73, 0x4d, 0x1f, 0x84, 0x48, 0x6e,
+		  0xc1, 0x72, 0xdf, 0x49, 0x2d, 0xfa, 0xfe, 0x27, 0x93, 0xc4,
+		  0x58, 0xa2, 0xe0, 0x21, 0x7e, 0xad, 0xc0, 0x89, 0x04, 0xec,
+		  0x7a, 0x92, 0x58, 0xc0, 0xa9, 0x9e, 0xc6, 0xd9, 0xf5, 0x62,
+		  0x31, 0x1a, 0x50, 0x19, 0x8b, 0xb2, 0x28, 0xed, 0x52, 0x5f,
+		  0x99, 0xf0, 0x1b, 0xdb, 0xb9, 0xa8, 0xec, 0x2b, 0x4d ),
+	PUBLIC ( 0x30, 0x81, 0x9f, 0x30, 0x0d, 0x06, 0x09, 0x2a, 0x86, 0x48,
+		 0x86, 0xf7, 0x0d, 0x01, 0x01, 0x01, 0x05, 0x00, 0x03, 0x81,
+		 0x8d, 0x00, 0x30, 0x81, 0x89, 0x02, 0x81, 0x81, 0x00, 0xb4,
+		 0xee, 0x81, 0xe8, 0xce, 0x53, 0x68, 0x58, 0xe8, 0xc5, 0x27,
+		 0x82, 0x59, 0x28, 0x20, 0x03, 0x44, 0x68, 0xe7, 0x4a, 0x4e,
+		 0xef, 0xe7, 0xfe, 0xc5, 0x6d, 0x8e, 0xbd, 0x8b, 0xae, 0x26,
+		 0xef, 0xe9, 0x7a, 0x32, 0xab, 0x8d, 0x59, 0x04, 0x6a, 0xc9,
+		 0x38, 0xf4, 0x5b, 0x3f, 0x32, 0x46, 0x15, 0x89, 0xd0, 0x6e,
+		 0xeb, 0x27, 0x4b, 0x74, 0x95, 0x6c, 0x2a, 0x63, 0x35, 0xc8,
+		 0x10, 0x2a, 0xf5, 0x2f, 0x17, 0x99, 0x83, 0xe9, 0xbd, 0xfa,
+		 0x7f, 0x64, 0x92, 0xa2, 0xbf, 0x34, 0xf7, 0xcb, 0xab, 0xef,
+		 0x1b, 0xc6, 0x97, 0x2c, 0xab, 0x9e, 0x99, 0x85, 0x0f, 0x11,
+		 0x22, 0x6c, 0x0e, 0xb9, 0x0d, 0xb3, 0xd5, 0x5c, 0x4c, 0x86,
+		 0x63, 0x59, 0xaf, 0xe3, 0xd9, 0x29, 0x2c, 0xa1, 0x6d, 0x51,
+		 0xa0, 0xb5, 0x78, 0xd8, 0x59, 0x0b, 0x7f, 0x4a, 0xdf, 0x23,
+		 0xae, 0x69, 0xe6, 0xff, 0x36, 0x7c, 0xcb, 0x02, 0x03, 0x01,
+		 0x00, 0x01 ),
+	PLAINTEXT ( 0x27, 0x32, 0x28, 0x6a, 0x7f, 0xe8, 0x0c, 0xb9, 0xbb, 0x42,
+		    0xc3, 0xbe, 0x97, 0xf0, 0xf2, 0xaf, 0x02, 0x4a, 0x10, 0x1a,
+		    0xde, 0x80, 0xe2, 0x54, 0xd9, 0x4c, 0x94, 0x8f, 0x16, 0x58,
+		    0x18, 0x90, 0xf6, 0xc1, 0xf6, 0x7f, 0xad, 0xd3, 0x65, 0x0f,
+		    0x7a, 0x76, 0x87, 0x32, 0xe2, 0x77, 0x43, 0x05, 0x37, 0x3b,
+		    0xfb, 0xee, 0xfd, 0x41, 0xed, 0x22, 0x3b, 0x27, 0xbe, 0xe4,
+		    0xd2, 0xe9, 0x08, 0x3a, 0x93, 0xc0, 0xca, 0x60, 0xe0, 0x92,
+		    0x8b, 0xfd, 0x35, 0x76, 0x32, 0x86, 0x82, 0x5d, 0xd6, 0xc3,
+		    0x92, 0x14, 0x13, 0xdb, 0xbe, 0x71, 0xaa, 0x56, 0xf3, 0x30,
+		    0x32, 0xd9, 0x41, 0xb0, 0x0d, 0x4c, 0x58, 0x06, 0x1b, 0xa5 ),
+	&sha256_algorithm,
+	SIGNATURE ( 0x4d, 0xa8, 0x23, 0xe5, 0x53, 0xf1, 0x1b, 0x63, 0x73, 0xbd,
+		    0x2b, 0x73, 0x40, 0xbb, 0xd8, 0x2c, 0x45, 0x7d, 0xbf, 0x59,
+		    0x90, 0xa0, 0x2d, 0x62, 0xb2, 0x39, 0x01, 0xaa, 0xca, 0xcc,
+		    0xc3, 0x65, 0x33, 0x89, 0xcb, 0xad, 0xa3, 0x1d, 0xff, 0x24,
+		    0x8f, 0x66, 0xda, 0x21, 0x04, 0xfa, 0xce, 0xf9, 0x39, 0xa5,
+		    0x31, 0x8c, 0xe3, 0x1e, 0x93, 0xf2, 0x76, 0xd6, 0x1d, 0x2d,
+		    0x14, 0x36, 0xba, 0x3f, 0x7f, 0xd3, 0xb9, 0xcb, 0x9f, 0x0d,
+		    0xd0, 0xfb, 0x2a, 0x05, 0x18, 0x10, 0x43, 0x93, 0xf3, 0x5c,
+		    0x78, 0x62, 0xb0, 0x63, 0xa8, 0xff, 0xc4, 0x35, 0x5b, 0xa3,
+		    0x20, 0xbf, 0x85, 0xc4, 0x5a, 0x3e, 0x03, 0x10, 0x9d, 0x77,
+		    0x99, 0xfc, 0xd8, 0x2f, 0x10, 0xb2, 0x5e, 0xc2, 0x80, 0x28,
+		    0xea, 0x2a, 0xbf, 0xc7, 0x31, 0xd7, 0x53, 0x1e, 0xcd, 0xe0,
+		    0xf2, 0x9f, 0xcf, 0xe1, 0x53, 0xcc, 0x43, 0x75 ) );
+
 /**
  * Perform RSA self-tests
  *
@@ -488,6 +642,7 @@ static void rsa_test_exec ( void ) {
 	rsa_signature_ok ( &md5_test );
 	rsa_signature_ok ( &sha1_test );
 	rsa_signature_ok ( &sha256_test );
+	rsa_pss_signature_ok ( &pss_sha256_test );
 }
 
 /** RSA self-test */
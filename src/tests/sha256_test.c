@@ -62,6 +62,13 @@ DIGEST_TEST ( sha256_nist_abc_opq, &sha256_algorithm, DIGEST_NIST_ABC_OPQ,
 		       0xe4, 0x59, 0x64, 0xff, 0x21, 0x67, 0xf6, 0xec, 0xed,
 		       0xd4, 0x19, 0xdb, 0x06, 0xc1 ) );
 
+/* NIST test vector "abc...stu" */
+DIGEST_TEST ( sha256_nist_abc_stu, &sha256_algorithm, DIGEST_NIST_ABC_STU,
+	      DIGEST ( 0xcf, 0x5b, 0x16, 0xa7, 0x78, 0xaf, 0x83, 0x80, 0x03,
+		       0x6c, 0xe5, 0x9e, 0x7b, 0x04, 0x92, 0x37, 0x0b, 0x24,
+		       0x9b, 0x11, 0xe8, 0xf0, 0x7a, 0x51, 0xaf, 0xac, 0x45,
+		       0x03, 0x7a, 0xfe, 0xe9, 0xd1 ) );
+
 /* Empty test vector (digest obtained from "sha224sum /dev/null") */
 DIGEST_TEST ( sha224_empty, &sha224_algorithm, DIGEST_EMPTY,
 	      DIGEST ( 0xd1, 0x4a, 0x02, 0x8c, 0x2a, 0x3a, 0x2b, 0xc9, 0x47,
@@ -83,6 +90,13 @@ DIGEST_TEST ( sha224_nist_abc_opq, &sha224_algorithm, DIGEST_NIST_ABC_OPQ,
 		       0x45, 0x5c, 0xb4, 0xf5, 0x8b, 0x19, 0x52, 0x52, 0x25,
 		       0x25 ) );
 
+/* NIST test vector "abc...stu" */
+DIGEST_TEST ( sha224_nist_abc_stu, &sha224_algorithm, DIGEST_NIST_ABC_STU,
+	      DIGEST ( 0xc9, 0x7c, 0xa9, 0xa5, 0x59, 0x85, 0x0c, 0xe9, 0x7a,
+		       0x04, 0xa9, 0x6d, 0xef, 0x6d, 0x99, 0xa9, 0xe0, 0xe0,
+		       0xe2, 0xab, 0x14, 0xe6, 0xb8, 0xdf, 0x26, 0x5f, 0xc0,
+		       0xb3 ) );
+
 /**
  * Perform SHA-256 family self-test
  *
@@ -93,9 +107,15 @@ static void sha256_test_exec ( void ) {
 	digest_ok ( &sha256_empty );
 	digest_ok ( &sha256_nist_abc );
 	digest_ok ( &sha256_nist_abc_opq );
+	digest_ok ( &sha256_nist_abc_stu );
 	digest_ok ( &sha224_empty );
 	digest_ok ( &sha224_nist_abc );
 	digest_ok ( &sha224_nist_abc_opq );
+	digest_ok ( &sha224_nist_abc_stu );
+
+	/* Bulk data tests */
+	digest_bulk_ok ( &sha256_algorithm );
+	digest_bulk_ok ( &sha224_algorithm );
 
 	/* Speed tests */
 	DBG ( "SHA256 required %ld cycles per byte\n",
@@ -167,6 +167,9 @@ static void sha512_test_exec ( void ) {
 	digest_ok ( &sha512_224_nist_abc );
 	digest_ok ( &sha512_224_nist_abc_stu );
 
+	/* Bulk data tests */
+	digest_bulk_ok ( &sha512_algorithm );
+
 	/* Speed tests */
 	DBG ( "SHA512 required %ld cycles per byte\n",
 	      digest_cost ( &sha512_algorithm ) );
@@ -0,0 +1,124 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * String function benchmarks
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <ipxe/bench.h>
+
+/** Length of data used by string function benchmarks */
+#define STRING_BENCH_LEN 4096
+
+/** Source buffer */
+static uint8_t __attribute__ (( aligned ( 16 ) ))
+	string_bench_src[ STRING_BENCH_LEN + 16 ];
+
+/** Destination buffer */
+static uint8_t __attribute__ (( aligned ( 16 ) ))
+	string_bench_dest[ STRING_BENCH_LEN + 16 ];
+
+/**
+ * Run aligned memcpy() benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int memcpy_bench_exec ( void ) {
+
+	memcpy ( string_bench_dest, string_bench_src, STRING_BENCH_LEN );
+
+	return 0;
+}
+
+/**
+ * Run unaligned memcpy() benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int memcpy_unaligned_bench_exec ( void ) {
+
+	memcpy ( ( string_bench_dest + 1 ), ( string_bench_src + 3 ),
+		 STRING_BENCH_LEN );
+
+	return 0;
+}
+
+/**
+ * Run memset() benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int memset_bench_exec ( void ) {
+
+	memset ( string_bench_dest, 0x5a, STRING_BENCH_LEN );
+
+	return 0;
+}
+
+/**
+ * Run overlapping memmove() benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int memmove_bench_exec ( void ) {
+
+	/* Destination above source, requiring a backwards copy */
+	memmove ( ( string_bench_dest + 8 ), string_bench_dest,
+		  STRING_BENCH_LEN );
+
+	return 0;
+}
+
+/** Aligned memcpy() benchmark */
+struct benchmark memcpy_benchmark __benchmark = {
+	.name = "memcpy",
+	.len = STRING_BENCH_LEN,
+	.exec = memcpy_bench_exec,
+};
+
+/** Unaligned memcpy() benchmark */
+struct benchmark memcpy_unaligned_benchmark __benchmark = {
+	.name = "memcpy_unaligned",
+	.len = STRING_BENCH_LEN,
+	.exec = memcpy_unaligned_bench_exec,
+};
+
+/** memset() benchmark */
+struct benchmark memset_benchmark __benchmark = {
+	.name = "memset",
+	.len = STRING_BENCH_LEN,
+	.exec = memset_bench_exec,
+};
+
+/** Overlapping memmove() benchmark */
+struct benchmark memmove_benchmark __benchmark = {
+	.name = "memmove",
+	.len = STRING_BENCH_LEN,
+	.exec = memmove_bench_exec,
+};
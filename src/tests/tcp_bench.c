@@ -0,0 +1,397 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * TCP loopback benchmark
+ *
+ * A loopback network device is created, and data is transferred via
+ * a TCP connection from this device to itself.  This exercises the
+ * complete transmit and receive paths through TCP, IPv4 and the
+ * network device core.
+ *
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/device.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/if_ether.h>
+#include <ipxe/ethernet.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/interface.h>
+#include <ipxe/xfer.h>
+#include <ipxe/open.h>
+#include <ipxe/in.h>
+#include <ipxe/tcp.h>
+#include <ipxe/settings.h>
+#include <ipxe/process.h>
+#include <ipxe/timer.h>
+#include <ipxe/bench.h>
+
+/** Length of data transferred by each iteration */
+#define TCP_BENCH_LEN ( 256 * 1024 )
+
+/** Maximum length of data delivered to TCP at once */
+#define TCP_BENCH_CHUNK_LEN 8192
+
+/** Number of iterations */
+#define TCP_BENCH_COUNT 16
+
+/** TCP port */
+#define TCP_BENCH_PORT 9
+
+/** Timeout for each stage */
+#define TCP_BENCH_TIMEOUT ( 5 * TICKS_PER_SEC )
+
+/** Loopback device address */
+static const struct in_addr tcp_bench_address = {
+	.s_addr = htonl ( 0xc0000201 ), /* 192.0.2.1 (TEST-NET-1) */
+};
+
+/** Loopback device netmask */
+static const struct in_addr tcp_bench_netmask = {
+	.s_addr = htonl ( 0xffffff00 ),
+};
+
+/** Loopback device MAC address */
+static const uint8_t tcp_bench_hw_addr[ETH_ALEN] = {
+	0x02, 0x00, 0x00, 0xbe, 0x0c, 0x00
+};
+
+/** Loopback underlying device */
+static struct device tcp_bench_dev = {
+	.name = "bench",
+	.siblings = LIST_HEAD_INIT ( tcp_bench_dev.siblings ),
+	.children = LIST_HEAD_INIT ( tcp_bench_dev.children ),
+};
+
+/** Loopback network device */
+static struct net_device *tcp_bench_netdev;
+
+/** Length of data received by server */
+static size_t tcp_bench_received;
+
+/** Server connection has been accepted */
+static int tcp_bench_accepted;
+
+/******************************************************************************
+ *
+ * Loopback network device
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Open loopback device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+static int tcp_bench_open ( struct net_device *netdev __unused ) {
+	return 0;
+}
+
+/**
+ * Close loopback device
+ *
+ * @v netdev		Network device
+ */
+static void tcp_bench_close ( struct net_device *netdev __unused ) {
+	/* Nothing to do */
+}
+
+/**
+ * Transmit packet via loopback device
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int tcp_bench_transmit ( struct net_device *netdev,
+				struct io_buffer *iobuf ) {
+	struct io_buffer *copy;
+	size_t len = iob_len ( iobuf );
+
+	/* Hand a copy of the packet back to the receive path */
+	copy = alloc_iob ( len );
+	if ( copy ) {
+		memcpy ( iob_put ( copy, len ), iobuf->data, len );
+		netdev_rx ( netdev, copy );
+	} else {
+		netdev_rx_err ( netdev, NULL, -ENOMEM );
+	}
+	netdev_tx_complete ( netdev, iobuf );
+
+	return 0;
+}
+
+/**
+ * Poll loopback device
+ *
+ * @v netdev		Network device
+ */
+static void tcp_bench_poll ( struct net_device *netdev __unused ) {
+	/* Nothing to do */
+}
+
+/** Loopback device operations */
+static struct net_device_operations tcp_bench_operations = {
+	.open = tcp_bench_open,
+	.close = tcp_bench_close,
+	.transmit = tcp_bench_transmit,
+	.poll = tcp_bench_poll,
+};
+
+/******************************************************************************
+ *
+ * Connections
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Receive data at server
+ *
+ * @v intf		Interface
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int tcp_bench_server_deliver ( struct interface *intf __unused,
+				      struct io_buffer *iobuf,
+				      struct xfer_metadata *meta __unused ) {
+
+	tcp_bench_received += iob_len ( iobuf );
+	free_iob ( iobuf );
+	return 0;
+}
+
+/** Server interface operations */
+static struct interface_operation tcp_bench_server_operations[] = {
+	INTF_OP ( xfer_deliver, struct interface *, tcp_bench_server_deliver ),
+};
+
+/** Server interface descriptor */
+static struct interface_descriptor tcp_bench_server_desc =
+	INTF_DESC_PURE ( tcp_bench_server_operations );
+
+/** Server interface */
+static struct interface tcp_bench_server =
+	INTF_INIT ( tcp_bench_server_desc );
+
+/** Client interface */
+static struct interface tcp_bench_client = INTF_INIT ( null_intf_desc );
+
+/**
+ * Accept connection
+ *
+ * @v xfer		Data transfer interface of new connection
+ * @v peer		Peer socket address
+ * @ret rc		Return status code
+ */
+static int tcp_bench_accept ( struct interface *xfer,
+			      struct sockaddr *peer __unused ) {
+
+	/* Accept only a single connection */
+	if ( tcp_bench_accepted )
+		return -EBUSY;
+	tcp_bench_accepted = 1;
+
+	/* Attach to server interface */
+	intf_plug_plug ( &tcp_bench_server, xfer );
+	return 0;
+}
+
+/** TCP listener */
+static struct tcp_listener tcp_bench_listener = {
+	.port = TCP_BENCH_PORT,
+	.accept = tcp_bench_accept,
+};
+
+/******************************************************************************
+ *
+ * Benchmark
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Prepare TCP loopback benchmark
+ *
+ * @ret rc		Return status code
+ */
+static int tcp_bench_setup ( void ) {
+	struct sockaddr_in peer;
+	struct settings *settings;
+	unsigned long start;
+	int rc;
+
+	/* Allocate and register loopback device */
+	tcp_bench_netdev = alloc_etherdev ( 0 );
+	if ( ! tcp_bench_netdev ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	netdev_init ( tcp_bench_netdev, &tcp_bench_operations );
+	tcp_bench_netdev->dev = &tcp_bench_dev;
+	memcpy ( tcp_bench_netdev->hw_addr, tcp_bench_hw_addr, ETH_ALEN );
+	if ( ( rc = register_netdev ( tcp_bench_netdev ) ) != 0 )
+		goto err_register;
+	if ( ( rc = netdev_open ( tcp_bench_netdev ) ) != 0 )
+		goto err_open;
+
+	/* Configure address */
+	settings = netdev_settings ( tcp_bench_netdev );
+	if ( ( rc = store_setting ( settings, &netmask_setting,
+				    &tcp_bench_netmask,
+				    sizeof ( tcp_bench_netmask ) ) ) != 0 )
+		goto err_netmask;
+	if ( ( rc = store_setting ( settings, &ip_setting, &tcp_bench_address,
+				    sizeof ( tcp_bench_address ) ) ) != 0 )
+		goto err_ip;
+
+	/* Start listening */
+	tcp_bench_accepted = 0;
+	if ( ( rc = tcp_listen ( &tcp_bench_listener ) ) != 0 )
+		goto err_listen;
+
+	/* Open connection to self */
+	memset ( &peer, 0, sizeof ( peer ) );
+	peer.sin_family = AF_INET;
+	peer.sin_addr = tcp_bench_address;
+	peer.sin_port = htons ( TCP_BENCH_PORT );
+	if ( ( rc = xfer_open_socket ( &tcp_bench_client, SOCK_STREAM,
+				       ( struct sockaddr * ) &peer,
+				       NULL ) ) != 0 )
+		goto err_connect;
+
+	/* Wait for connection to be established */
+	start = currticks();
+	while ( ! ( tcp_bench_accepted && xfer_window ( &tcp_bench_client ) ) ){
+		if ( ( currticks() - start ) > TCP_BENCH_TIMEOUT ) {
+			rc = -ETIMEDOUT;
+			goto err_established;
+		}
+		step();
+	}
+
+	return 0;
+
+ err_established:
+	intf_restart ( &tcp_bench_server, rc );
+	intf_restart ( &tcp_bench_client, rc );
+ err_connect:
+	tcp_unlisten ( &tcp_bench_listener );
+ err_listen:
+ err_ip:
+ err_netmask:
+	netdev_close ( tcp_bench_netdev );
+ err_open:
+	unregister_netdev ( tcp_bench_netdev );
+ err_register:
+	netdev_nullify ( tcp_bench_netdev );
+	netdev_put ( tcp_bench_netdev );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Run TCP loopback benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int tcp_bench_exec ( void ) {
+	struct io_buffer *iobuf;
+	unsigned long start;
+	size_t remaining;
+	size_t len;
+	int rc;
+
+	/* Transfer data */
+	tcp_bench_received = 0;
+	remaining = TCP_BENCH_LEN;
+	start = currticks();
+	while ( tcp_bench_received < TCP_BENCH_LEN ) {
+
+		/* Deliver as much data as TCP will accept */
+		len = xfer_window ( &tcp_bench_client );
+		if ( len > remaining )
+			len = remaining;
+		if ( len > TCP_BENCH_CHUNK_LEN )
+			len = TCP_BENCH_CHUNK_LEN;
+		if ( len ) {
+			iobuf = xfer_alloc_iob ( &tcp_bench_client, len );
+			if ( ! iobuf )
+				return -ENOMEM;
+			memset ( iob_put ( iobuf, len ), 0, len );
+			if ( ( rc = xfer_deliver_iob ( &tcp_bench_client,
+						       iobuf ) ) != 0 )
+				return rc;
+			remaining -= len;
+		}
+
+		/* Allow packets to be transmitted and received */
+		if ( ( currticks() - start ) > TCP_BENCH_TIMEOUT )
+			return -ETIMEDOUT;
+		step();
+	}
+
+	return 0;
+}
+
+/**
+ * Clean up after TCP loopback benchmark
+ *
+ */
+static void tcp_bench_teardown ( void ) {
+	unsigned long start;
+
+	/* Close connections, and allow time for the close to complete */
+	intf_restart ( &tcp_bench_client, 0 );
+	intf_restart ( &tcp_bench_server, 0 );
+	start = currticks();
+	while ( ( currticks() - start ) < ( TICKS_PER_SEC / 10 ) )
+		step();
+
+	/* Stop listening and remove loopback device */
+	tcp_unlisten ( &tcp_bench_listener );
+	netdev_close ( tcp_bench_netdev );
+	unregister_netdev ( tcp_bench_netdev );
+	netdev_nullify ( tcp_bench_netdev );
+	netdev_put ( tcp_bench_netdev );
+}
+
+/** TCP loopback benchmark */
+struct benchmark tcp_benchmark __benchmark = {
+	.name = "tcp",
+	.len = TCP_BENCH_LEN,
+	.count = TCP_BENCH_COUNT,
+	.setup = tcp_bench_setup,
+	.exec = tcp_bench_exec,
+	.teardown = tcp_bench_teardown,
+};
@@ -0,0 +1,493 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * TCP self-tests
+ *
+ * A test network device is created, and a TCP connection is opened
+ * to a simulated peer.  The peer's segments are constructed by the
+ * test and delivered out of order, so that the receive path must
+ * handle reordering.
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <stdint.h>
+#include <string.h>
+#include <byteswap.h>
+#include <ipxe/device.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/if_ether.h>
+#include <ipxe/ethernet.h>
+#include <ipxe/neighbour.h>
+#include <ipxe/iobuf.h>
+#include <ipxe/interface.h>
+#include <ipxe/xfer.h>
+#include <ipxe/xferbuf.h>
+#include <ipxe/open.h>
+#include <ipxe/in.h>
+#include <ipxe/ip.h>
+#include <ipxe/ipstat.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/tcp.h>
+#include <ipxe/settings.h>
+#include <ipxe/process.h>
+#include <ipxe/timer.h>
+#include <ipxe/test.h>
+
+/** Length of data transferred by each test */
+#define TCP_TEST_LEN ( 32 * 1024 )
+
+/** Length of each data segment */
+#define TCP_TEST_SEGMENT_LEN 1024
+
+/** Peer initial sequence number
+ *
+ * This is chosen so that the sequence number wraps during the test.
+ */
+#define TCP_TEST_PEER_ISS 0xfffff000UL
+
+/** Peer TCP port */
+#define TCP_TEST_PEER_PORT 7
+
+/** Peer advertised window */
+#define TCP_TEST_PEER_WIN 0xffff
+
+/** Timeout for each stage */
+#define TCP_TEST_TIMEOUT ( 5 * TICKS_PER_SEC )
+
+/** Local address */
+static const struct in_addr tcp_test_local = {
+	.s_addr = htonl ( 0xc0000202 ), /* 192.0.2.2 (TEST-NET-1) */
+};
+
+/** Peer address */
+static const struct in_addr tcp_test_peer = {
+	.s_addr = htonl ( 0xc0000203 ), /* 192.0.2.3 (TEST-NET-1) */
+};
+
+/** Netmask */
+static const struct in_addr tcp_test_netmask = {
+	.s_addr = htonl ( 0xffffff00 ),
+};
+
+/** Local MAC address */
+static const uint8_t tcp_test_local_hw_addr[ETH_ALEN] = {
+	0x02, 0x00, 0x00, 0x7e, 0x57, 0x00
+};
+
+/** Peer MAC address */
+static const uint8_t tcp_test_peer_hw_addr[ETH_ALEN] = {
+	0x02, 0x00, 0x00, 0x7e, 0x57, 0x01
+};
+
+/** Test underlying device */
+static struct device tcp_test_dev = {
+	.name = "tcptest",
+	.siblings = LIST_HEAD_INIT ( tcp_test_dev.siblings ),
+	.children = LIST_HEAD_INIT ( tcp_test_dev.children ),
+};
+
+/** Local initial sequence number (valid once SYN has been seen) */
+static uint32_t tcp_test_iss;
+
+/** Local TCP port (valid once SYN has been seen) */
+static unsigned int tcp_test_port;
+
+/** A SYN has been transmitted */
+static int tcp_test_syn;
+
+/** Most recently transmitted acknowledgement number */
+static uint32_t tcp_test_ack;
+
+/** Receive buffer */
+static struct xfer_buffer tcp_test_buffer;
+
+/** Receive buffer may be written to directly */
+static int tcp_test_placement;
+
+/** Length of data placed directly into receive buffer */
+static size_t tcp_test_placed;
+
+/******************************************************************************
+ *
+ * Test network device
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Open test device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+static int tcp_test_open ( struct net_device *netdev __unused ) {
+	return 0;
+}
+
+/**
+ * Close test device
+ *
+ * @v netdev		Network device
+ */
+static void tcp_test_close ( struct net_device *netdev __unused ) {
+	/* Nothing to do */
+}
+
+/**
+ * Transmit packet via test device
+ *
+ * @v netdev		Network device
+ * @v iobuf		I/O buffer
+ * @ret rc		Return status code
+ */
+static int tcp_test_transmit ( struct net_device *netdev,
+			       struct io_buffer *iobuf ) {
+	struct ethhdr *ethhdr = iobuf->data;
+	struct iphdr *iphdr = ( ( ( void * ) ethhdr ) + sizeof ( *ethhdr ) );
+	struct tcp_header *tcphdr;
+	size_t hlen;
+
+	/* Record sequence and acknowledgement numbers of TCP packets */
+	assert ( iob_len ( iobuf ) >= ( sizeof ( *ethhdr ) + sizeof ( *iphdr ) ));
+	hlen = ( ( iphdr->verhdrlen & IP_MASK_HLEN ) * 4 );
+	tcphdr = ( ( ( void * ) iphdr ) + hlen );
+	if ( ( ethhdr->h_protocol == htons ( ETH_P_IP ) ) &&
+	     ( iphdr->protocol == IP_TCP ) ) {
+		assert ( iob_len ( iobuf ) >= ( sizeof ( *ethhdr ) + hlen +
+						sizeof ( *tcphdr ) ) );
+		if ( tcphdr->flags & TCP_SYN ) {
+			tcp_test_iss = ntohl ( tcphdr->seq );
+			tcp_test_port = ntohs ( tcphdr->src );
+			tcp_test_syn = 1;
+		}
+		if ( tcphdr->flags & TCP_ACK )
+			tcp_test_ack = ntohl ( tcphdr->ack );
+	}
+
+	/* Discard packet */
+	netdev_tx_complete ( netdev, iobuf );
+
+	return 0;
+}
+
+/**
+ * Poll test device
+ *
+ * @v netdev		Network device
+ */
+static void tcp_test_poll ( struct net_device *netdev __unused ) {
+	/* Nothing to do */
+}
+
+/** Test device operations */
+static struct net_device_operations tcp_test_operations = {
+	.open = tcp_test_open,
+	.close = tcp_test_close,
+	.transmit = tcp_test_transmit,
+	.poll = tcp_test_poll,
+};
+
+/******************************************************************************
+ *
+ * Simulated peer
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Get test data byte
+ *
+ * @v offset		Offset within test data
+ * @ret byte		Test data byte
+ */
+static uint8_t tcp_test_byte ( size_t offset ) {
+	return ( ( offset * 13 ) + ( offset >> 8 ) + 7 );
+}
+
+/**
+ * Deliver segment from simulated peer
+ *
+ * @v netdev		Network device
+ * @v flags		TCP flags
+ * @v seq		Sequence number
+ * @v offset		Offset of data within test data
+ * @v len		Length of data
+ * @ret rc		Return status code
+ */
+static int tcp_test_inject ( struct net_device *netdev, unsigned int flags,
+			      uint32_t seq, size_t offset, size_t len ) {
+	struct ipv4_pseudo_header pshdr;
+	struct sockaddr_in st_src;
+	struct sockaddr_in st_dest;
+	struct ip_statistics stats;
+	struct tcp_header *tcphdr;
+	struct io_buffer *iobuf;
+	uint16_t pshdr_csum;
+	uint8_t *data;
+	size_t i;
+
+	/* Construct segment */
+	iobuf = alloc_iob ( sizeof ( *tcphdr ) + len );
+	assert ( iobuf != NULL );
+	tcphdr = iob_put ( iobuf, sizeof ( *tcphdr ) );
+	memset ( tcphdr, 0, sizeof ( *tcphdr ) );
+	tcphdr->src = htons ( TCP_TEST_PEER_PORT );
+	tcphdr->dest = htons ( tcp_test_port );
+	tcphdr->seq = htonl ( seq );
+	tcphdr->ack = htonl ( tcp_test_iss + 1 );
+	tcphdr->hlen = ( ( sizeof ( *tcphdr ) / 4 ) << 4 );
+	tcphdr->flags = ( flags | TCP_ACK );
+	tcphdr->win = htons ( TCP_TEST_PEER_WIN );
+	data = iob_put ( iobuf, len );
+	for ( i = 0 ; i < len ; i++ )
+		data[i] = tcp_test_byte ( offset + i );
+
+	/* Calculate checksum */
+	memset ( &pshdr, 0, sizeof ( pshdr ) );
+	pshdr.src = tcp_test_peer;
+	pshdr.dest = tcp_test_local;
+	pshdr.protocol = IP_TCP;
+	pshdr.len = htons ( iob_len ( iobuf ) );
+	pshdr_csum = tcpip_continue_chksum ( TCPIP_EMPTY_CSUM, &pshdr,
+					     sizeof ( pshdr ) );
+	tcphdr->csum = tcpip_continue_chksum ( pshdr_csum, iobuf->data,
+					       iob_len ( iobuf ) );
+
+	/* Hand off to TCP */
+	memset ( &st_src, 0, sizeof ( st_src ) );
+	st_src.sin_family = AF_INET;
+	st_src.sin_addr = tcp_test_peer;
+	memset ( &st_dest, 0, sizeof ( st_dest ) );
+	st_dest.sin_family = AF_INET;
+	st_dest.sin_addr = tcp_test_local;
+	memset ( &stats, 0, sizeof ( stats ) );
+	return tcpip_rx ( iobuf, netdev, IP_TCP,
+			  ( struct sockaddr_tcpip * ) &st_src,
+			  ( struct sockaddr_tcpip * ) &st_dest,
+			  pshdr_csum, &stats );
+}
+
+/******************************************************************************
+ *
+ * Connection
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Receive data
+ *
+ * @v intf		Interface
+ * @v iobuf		I/O buffer
+ * @v meta		Data transfer metadata
+ * @ret rc		Return status code
+ */
+static int tcp_test_deliver ( struct interface *intf __unused,
+			      struct io_buffer *iobuf,
+			      struct xfer_metadata *meta ) {
+
+	/* Record placed data */
+	if ( meta->flags & XFER_FL_PLACED ) {
+		ok ( tcp_test_placement );
+		ok ( iob_len ( iobuf ) == 0 );
+		tcp_test_placed += meta->offset;
+	}
+
+	/* Add data to buffer */
+	return xferbuf_deliver ( &tcp_test_buffer, iobuf, meta );
+}
+
+/**
+ * Get data transfer buffer
+ *
+ * @v intf		Interface
+ * @ret xferbuf		Data transfer buffer, or NULL
+ */
+static struct xfer_buffer * tcp_test_buffer_op ( struct interface *intf
+						 __unused ) {
+
+	return ( tcp_test_placement ? &tcp_test_buffer : NULL );
+}
+
+/** Connection interface operations */
+static struct interface_operation tcp_test_xfer_operations[] = {
+	INTF_OP ( xfer_deliver, struct interface *, tcp_test_deliver ),
+	INTF_OP ( xfer_buffer, struct interface *, tcp_test_buffer_op ),
+};
+
+/** Connection interface descriptor */
+static struct interface_descriptor tcp_test_xfer_desc =
+	INTF_DESC_PURE ( tcp_test_xfer_operations );
+
+/** Connection interface */
+static struct interface tcp_test_xfer = INTF_INIT ( tcp_test_xfer_desc );
+
+/******************************************************************************
+ *
+ * Tests
+ *
+ ******************************************************************************
+ */
+
+/**
+ * Transfer data from simulated peer with reordering
+ *
+ * @v netdev		Network device
+ * @v placement		Allow data to be placed directly into buffer
+ */
+static void tcp_test_transfer ( struct net_device *netdev, int placement ) {
+	struct sockaddr_in peer;
+	unsigned long start;
+	unsigned int count = ( TCP_TEST_LEN / TCP_TEST_SEGMENT_LEN );
+	unsigned int parity;
+	unsigned int i;
+	uint32_t seq;
+	size_t offset;
+	uint8_t *data;
+	uint8_t zero = 0;
+
+	/* Initialise and presize receive buffer */
+	memset ( &tcp_test_buffer, 0, sizeof ( tcp_test_buffer ) );
+	xferbuf_malloc_init ( &tcp_test_buffer );
+	ok ( xferbuf_write ( &tcp_test_buffer, ( TCP_TEST_LEN - 1 ),
+			     &zero, sizeof ( zero ) ) == 0 );
+	tcp_test_placement = placement;
+	tcp_test_placed = 0;
+	tcp_test_syn = 0;
+
+	/* Open connection and wait for SYN */
+	memset ( &peer, 0, sizeof ( peer ) );
+	peer.sin_family = AF_INET;
+	peer.sin_addr = tcp_test_peer;
+	peer.sin_port = htons ( TCP_TEST_PEER_PORT );
+	ok ( xfer_open_socket ( &tcp_test_xfer, SOCK_STREAM,
+				( struct sockaddr * ) &peer, NULL ) == 0 );
+	start = currticks();
+	while ( ( ! tcp_test_syn ) &&
+		( ( currticks() - start ) < TCP_TEST_TIMEOUT ) ) {
+		step();
+	}
+	ok ( tcp_test_syn );
+
+	/* Complete handshake */
+	ok ( tcp_test_inject ( netdev, TCP_SYN, TCP_TEST_PEER_ISS,
+				0, 0 ) == 0 );
+	seq = ( TCP_TEST_PEER_ISS + 1 );
+
+	/* Deliver odd-numbered segments, then even-numbered segments */
+	for ( parity = 1 ; parity <= 2 ; parity++ ) {
+		for ( i = ( parity & 1 ) ; i < count ; i += 2 ) {
+			offset = ( i * TCP_TEST_SEGMENT_LEN );
+			ok ( tcp_test_inject ( netdev, 0, ( seq + offset ),
+					       offset,
+					       TCP_TEST_SEGMENT_LEN ) == 0 );
+		}
+		if ( parity == 1 ) {
+			ok ( tcp_test_buffer.pos == 0 );
+			ok ( tcp_test_placed == 0 );
+		}
+	}
+
+	/* Wait for final acknowledgement */
+	start = currticks();
+	while ( ( tcp_test_ack != ( seq + TCP_TEST_LEN ) ) &&
+		( ( currticks() - start ) < TCP_TEST_TIMEOUT ) ) {
+		step();
+	}
+	ok ( tcp_test_ack == ( seq + TCP_TEST_LEN ) );
+
+	/* Check received data */
+	ok ( tcp_test_buffer.pos == TCP_TEST_LEN );
+	ok ( tcp_test_buffer.len == TCP_TEST_LEN );
+	data = tcp_test_buffer.data;
+	for ( i = 0 ; i < TCP_TEST_LEN ; i++ ) {
+		if ( data[i] != tcp_test_byte ( i ) )
+			break;
+	}
+	ok ( i == TCP_TEST_LEN );
+
+	/* Check that data was placed directly if (and only if)
+	 * permitted.  All odd-numbered segments arrived out of order.
+	 */
+	if ( placement ) {
+		ok ( tcp_test_placed == ( TCP_TEST_LEN / 2 ) );
+	} else {
+		ok ( tcp_test_placed == 0 );
+	}
+
+	/* Reset connection from peer and free receive buffer */
+	ok ( tcp_test_inject ( netdev, TCP_RST, ( seq + TCP_TEST_LEN ),
+				0, 0 ) != 0 );
+	intf_restart ( &tcp_test_xfer, 0 );
+	xferbuf_free ( &tcp_test_buffer );
+}
+
+/**
+ * Perform TCP self-tests
+ *
+ */
+static void tcp_test_exec ( void ) {
+	struct net_device *netdev;
+	struct settings *settings;
+
+	/* Allocate and register test device */
+	netdev = alloc_etherdev ( 0 );
+	assert ( netdev != NULL );
+	netdev_init ( netdev, &tcp_test_operations );
+	netdev->dev = &tcp_test_dev;
+	memcpy ( netdev->hw_addr, tcp_test_local_hw_addr, ETH_ALEN );
+	ok ( register_netdev ( netdev ) == 0 );
+	ok ( netdev_open ( netdev ) == 0 );
+
+	/* Configure address and peer */
+	settings = netdev_settings ( netdev );
+	ok ( store_setting ( settings, &netmask_setting, &tcp_test_netmask,
+			     sizeof ( tcp_test_netmask ) ) == 0 );
+	ok ( store_setting ( settings, &ip_setting, &tcp_test_local,
+			     sizeof ( tcp_test_local ) ) == 0 );
+	ok ( neighbour_define ( netdev, &ipv4_protocol, &tcp_test_peer,
+				tcp_test_peer_hw_addr ) == 0 );
+
+	/* Transfer with and without direct placement */
+	tcp_test_transfer ( netdev, 0 );
+	tcp_test_transfer ( netdev, 1 );
+
+	/* Remove test device */
+	netdev_close ( netdev );
+	unregister_netdev ( netdev );
+	netdev_nullify ( netdev );
+	netdev_put ( netdev );
+}
+
+/** TCP self-test */
+struct self_test tcp_test __self_test = {
+	.name = "tcp",
+	.exec = tcp_test_exec,
+};
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * TCP/IP checksum benchmarks
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <ipxe/tcpip.h>
+#include <ipxe/bench.h>
+
+/** Length of data used by checksum benchmarks */
+#define TCPIP_BENCH_LEN 4096
+
+/** Pseudo-random data (too large for stack) */
+static uint8_t __attribute__ (( aligned ( 16 ) ))
+	tcpip_bench_data[ TCPIP_BENCH_LEN + 1 ];
+
+/**
+ * Prepare checksum benchmark
+ *
+ * @ret rc		Return status code
+ */
+static int tcpip_bench_setup ( void ) {
+	unsigned int i;
+
+	/* Fill buffer with pseudo-random data */
+	srand ( 0x1234568 );
+	for ( i = 0 ; i < sizeof ( tcpip_bench_data ) ; i++ )
+		tcpip_bench_data[i] = rand();
+
+	return 0;
+}
+
+/**
+ * Run aligned checksum benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int tcpip_bench_exec ( void ) {
+
+	tcpip_chksum ( tcpip_bench_data, TCPIP_BENCH_LEN );
+	return 0;
+}
+
+/**
+ * Run unaligned checksum benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int tcpip_unaligned_bench_exec ( void ) {
+
+	tcpip_chksum ( ( tcpip_bench_data + 1 ), TCPIP_BENCH_LEN );
+	return 0;
+}
+
+/** Aligned checksum benchmark */
+struct benchmark tcpip_benchmark __benchmark = {
+	.name = "chksum",
+	.len = TCPIP_BENCH_LEN,
+	.setup = tcpip_bench_setup,
+	.exec = tcpip_bench_exec,
+};
+
+/** Unaligned checksum benchmark */
+struct benchmark tcpip_unaligned_benchmark __benchmark = {
+	.name = "chksum_unaligned",
+	.len = TCPIP_BENCH_LEN,
+	.setup = tcpip_bench_setup,
+	.exec = tcpip_unaligned_bench_exec,
+};
@@ -61,6 +61,18 @@ struct tcpip_random_test {
 	size_t offset;
 };
 
+/** A TCP/IP fragmented-segment test */
+struct tcpip_fragment_test {
+	/** Seed */
+	unsigned int seed;
+	/** Length of header */
+	size_t hlen;
+	/** Fragment lengths */
+	const size_t *frags;
+	/** Number of fragments */
+	unsigned int count;
+};
+
 /** Define inline data */
 #define DATA(...) { __VA_ARGS__ }
 
@@ -81,10 +93,25 @@ struct tcpip_random_test {
 		.offset = OFFSET,					\
 	}
 
+/** Define a TCP/IP fragmented-segment test */
+#define TCPIP_FRAGMENT_TEST( name, SEED, HLEN, FRAGS )			\
+	static const size_t name ## _frags[] = FRAGS;			\
+	static struct tcpip_fragment_test name = {			\
+		.seed = SEED,						\
+		.hlen = HLEN,						\
+		.frags = name ## _frags,				\
+		.count = ( sizeof ( name ## _frags ) /			\
+			   sizeof ( name ## _frags[0] ) ),		\
+	}
+
 /** Buffer for pseudorandom-data tests */
 static uint8_t __attribute__ (( aligned ( 16 ) ))
 	tcpip_data[ 4096 + 7 /* offset */ ];
 
+/** Buffer for copy-and-checksum tests */
+static uint8_t __attribute__ (( aligned ( 16 ) ))
+	tcpip_copy[ 4096 + 7 /* offset */ ];
+
 /** Empty data */
 TCPIP_TEST ( empty, DATA() );
 
@@ -182,6 +209,13 @@ static void tcpip_okx ( struct tcpip_test *test, const char *file,
 	/* Verify optimised tcpip_continue_chksum() result */
 	sum = tcpip_continue_chksum ( TCPIP_EMPTY_CSUM, test->data, test->len );
 	okx ( sum == expected, file, line );
+
+	/* Verify tcpip_copy_chksum() result */
+	memset ( tcpip_copy, 0, sizeof ( tcpip_copy ) );
+	sum = tcpip_copy_chksum ( TCPIP_EMPTY_CSUM, tcpip_copy, test->data,
+				  test->len );
+	okx ( sum == expected, file, line );
+	okx ( memcmp ( tcpip_copy, test->data, test->len ) == 0, file, line );
 }
 #define tcpip_ok( test ) tcpip_okx ( test, __FILE__, __LINE__ )
 
@@ -195,6 +229,7 @@ static void tcpip_okx ( struct tcpip_test *test, const char *file,
 static void tcpip_random_okx ( struct tcpip_random_test *test,
 			       const char *file, unsigned int line ) {
 	uint8_t *data = ( tcpip_data + test->offset );
+	uint8_t *copy = ( tcpip_copy + ( sizeof ( tcpip_copy ) - test->len ) );
 	struct profiler profiler;
 	uint16_t expected;
 	uint16_t generic_sum;
@@ -219,6 +254,26 @@ static void tcpip_random_okx ( struct tcpip_random_test *test,
 	sum = tcpip_continue_chksum ( TCPIP_EMPTY_CSUM, data, test->len );
 	okx ( sum == expected, file, line );
 
+	/* Verify tcpip_copy_chksum() result (with destination
+	 * alignment differing from source alignment)
+	 */
+	memset ( tcpip_copy, 0, sizeof ( tcpip_copy ) );
+	sum = tcpip_copy_chksum ( TCPIP_EMPTY_CSUM, copy, data, test->len );
+	okx ( sum == expected, file, line );
+	okx ( memcmp ( copy, data, test->len ) == 0, file, line );
+
+	/* Profile generic calculation */
+	memset ( &profiler, 0, sizeof ( profiler ) );
+	for ( i = 0 ; i < PROFILE_COUNT ; i++ ) {
+		profile_start ( &profiler );
+		sum = generic_tcpip_continue_chksum ( TCPIP_EMPTY_CSUM, data,
+						      test->len );
+		profile_stop ( &profiler );
+	}
+	DBG ( "TCPIP generic checksummed %zd bytes (+%zd) in %ld +/- %ld "
+	      "ticks\n", test->len, test->offset, profile_mean ( &profiler ),
+	      profile_stddev ( &profiler ) );
+
 	/* Profile optimised calculation */
 	memset ( &profiler, 0, sizeof ( profiler ) );
 	for ( i = 0 ; i < PROFILE_COUNT ; i++ ) {
@@ -230,9 +285,113 @@ static void tcpip_random_okx ( struct tcpip_random_test *test,
 	DBG ( "TCPIP checksummed %zd bytes (+%zd) in %ld +/- %ld ticks\n",
 	      test->len, test->offset, profile_mean ( &profiler ),
 	      profile_stddev ( &profiler ) );
+
+	/* Profile separate copy and calculation */
+	memset ( &profiler, 0, sizeof ( profiler ) );
+	for ( i = 0 ; i < PROFILE_COUNT ; i++ ) {
+		profile_start ( &profiler );
+		memcpy ( copy, data, test->len );
+		sum = tcpip_continue_chksum ( TCPIP_EMPTY_CSUM, copy,
+					      test->len );
+		profile_stop ( &profiler );
+	}
+	DBG ( "TCPIP copied then checksummed %zd bytes (+%zd) in %ld +/- %ld "
+	      "ticks\n", test->len, test->offset, profile_mean ( &profiler ),
+	      profile_stddev ( &profiler ) );
+
+	/* Profile combined copy and calculation */
+	memset ( &profiler, 0, sizeof ( profiler ) );
+	for ( i = 0 ; i < PROFILE_COUNT ; i++ ) {
+		profile_start ( &profiler );
+		sum = tcpip_copy_chksum ( TCPIP_EMPTY_CSUM, copy, data,
+					  test->len );
+		profile_stop ( &profiler );
+	}
+	DBG ( "TCPIP copy-checksummed %zd bytes (+%zd) in %ld +/- %ld "
+	      "ticks\n", test->len, test->offset, profile_mean ( &profiler ),
+	      profile_stddev ( &profiler ) );
 }
 #define tcpip_random_ok( test ) tcpip_random_okx ( test, __FILE__, __LINE__ )
 
+/** Segment built from odd-length fragments (at odd offsets) */
+TCPIP_FRAGMENT_TEST ( fragments_odd, 0x5eed1e55, 20,
+		      DATA ( 1, 3, 512, 7, 1400, 2, 5 ) );
+
+/** Segment built from even-length fragments */
+TCPIP_FRAGMENT_TEST ( fragments_even, 0xdeadbeef, 32, DATA ( 536, 1024 ) );
+
+/** Segment built from single-byte fragments */
+TCPIP_FRAGMENT_TEST ( fragments_bytes, 0x0ddba11, 20,
+		      DATA ( 1, 1, 1, 1, 1 ) );
+
+/**
+ * Report TCP/IP fragmented-segment test result
+ *
+ * @v test		TCP/IP test
+ * @v file		Test code file
+ * @v line		Test code line
+ *
+ * Assemble a segment in the same way as TCP transmission (copying and
+ * checksumming each transmit queue fragment in turn, then adding the
+ * header), and verify the result against a checksum calculated over
+ * the finished segment.
+ */
+static void tcpip_fragment_okx ( struct tcpip_fragment_test *test,
+				 const char *file, unsigned int line ) {
+	uint8_t *header = tcpip_copy;
+	uint8_t *payload = ( tcpip_copy + test->hlen );
+	uint8_t *src = tcpip_data;
+	uint16_t *hdr_csum = ( ( void * ) ( header + 16 ) );
+	uint16_t frag_sum;
+	uint16_t expected;
+	uint16_t sum;
+	size_t len = 0;
+	size_t frag_len;
+	unsigned int i;
+
+	/* Generate random header and fragment data */
+	srandom ( test->seed );
+	for ( i = 0 ; i < sizeof ( tcpip_data ) ; i++ )
+		tcpip_data[i] = random();
+	memset ( tcpip_copy, 0, sizeof ( tcpip_copy ) );
+	for ( i = 0 ; i < test->hlen ; i++ )
+		header[i] = random();
+	*hdr_csum = 0;
+
+	/* Copy and checksum each fragment, varying source alignment */
+	sum = TCPIP_EMPTY_CSUM;
+	for ( i = 0 ; i < test->count ; i++ ) {
+		frag_len = test->frags[i];
+		src += ( i & 3 );
+		assert ( ( src + frag_len ) <=
+			 ( tcpip_data + sizeof ( tcpip_data ) ) );
+		assert ( ( test->hlen + len + frag_len ) <=
+			 sizeof ( tcpip_copy ) );
+		frag_sum = tcpip_copy_chksum ( TCPIP_EMPTY_CSUM,
+					       ( payload + len ), src,
+					       frag_len );
+		sum = tcpip_combine_chksum ( sum, frag_sum, len );
+		okx ( memcmp ( ( payload + len ), src, frag_len ) == 0,
+		      file, line );
+		src += frag_len;
+		len += frag_len;
+	}
+
+	/* Add header and compare against checksum over whole segment */
+	sum = tcpip_continue_chksum ( sum, header, test->hlen );
+	expected = tcpip_chksum ( tcpip_copy, ( test->hlen + len ) );
+	okx ( sum == expected, file, line );
+	okx ( sum == rfc_tcpip_chksum ( tcpip_copy, ( test->hlen + len ) ),
+	      file, line );
+
+	/* Verify that the completed segment checksums to zero */
+	*hdr_csum = sum;
+	okx ( tcpip_chksum ( tcpip_copy, ( test->hlen + len ) ) == 0,
+	      file, line );
+}
+#define tcpip_fragment_ok( test ) \
+	tcpip_fragment_okx ( test, __FILE__, __LINE__ )
+
 /**
  * Perform TCP/IP self-tests
  *
@@ -251,6 +410,9 @@ static void tcpip_test_exec ( void ) {
 	tcpip_random_ok ( &random_unaligned_2 );
 	tcpip_random_ok ( &random_aligned_truncated );
 	tcpip_random_ok ( &partial );
+	tcpip_fragment_ok ( &fragments_odd );
+	tcpip_fragment_ok ( &fragments_even );
+	tcpip_fragment_ok ( &fragments_bytes );
 }
 
 /** TCP/IP self-test */
@@ -0,0 +1,96 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Boot timeline self-tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <string.h>
+#include <ipxe/timer.h>
+#include <ipxe/timeline.h>
+#include <ipxe/test.h>
+
+/** Phase instances */
+static int timeline_test_a;
+static int timeline_test_b;
+
+/**
+ * Perform boot timeline self-tests
+ *
+ */
+static void timeline_test_exec ( void ) {
+	struct timeline_event event;
+	unsigned int first = timeline_count();
+	unsigned int count;
+	char buf[160];
+
+	/* Overlapping phase instances are matched correctly */
+	timeline_record ( "test", &timeline_test_a, TIMELINE_BEGIN, 0 );
+	timeline_record ( "test", &timeline_test_b, TIMELINE_BEGIN, 0 );
+	timeline_record ( "other", &timeline_test_a, TIMELINE_END, 0 );
+	timeline_record ( "test", &timeline_test_a, TIMELINE_END, 0 );
+	timeline_record ( "test", &timeline_test_b, TIMELINE_END, -1 );
+	timeline_record ( "test", &timeline_test_b, TIMELINE_END, 0 );
+	count = timeline_count();
+	ok ( count == ( first + 6 ) );
+	ok ( timeline_begin_of ( first + 2 ) == NULL );
+	ok ( timeline_begin_of ( first + 3 ) == timeline_event ( first ) );
+	ok ( timeline_begin_of ( first + 4 ) ==
+	     timeline_event ( first + 1 ) );
+	ok ( timeline_begin_of ( first + 5 ) == NULL );
+	ok ( timeline_event ( first + 4 )->rc == -1 );
+
+	/* Chrome trace event format */
+	memset ( &event, 0, sizeof ( event ) );
+	event.name = "dhcp";
+	event.ticks = ( 3 * TICKS_PER_SEC );
+	event.type = TIMELINE_BEGIN;
+	ok ( timeline_json_event ( &event, buf, sizeof ( buf ) ) ==
+	     strlen ( buf ) );
+	ok ( strcmp ( buf, "{\"name\":\"dhcp\",\"cat\":\"ipxe\",\"ph\":\"b\","
+		      "\"id\":\"0x0\",\"ts\":3000000,\"pid\":1,"
+		      "\"tid\":1}" ) == 0 );
+	event.type = TIMELINE_END;
+	event.rc = 0x12345678;
+	ok ( timeline_json_event ( &event, NULL, 0 ) ==
+	     timeline_json_event ( &event, buf, sizeof ( buf ) ) );
+	ok ( strcmp ( buf, "{\"name\":\"dhcp\",\"cat\":\"ipxe\",\"ph\":\"e\","
+		      "\"id\":\"0x0\",\"ts\":3000000,\"pid\":1,\"tid\":1,"
+		      "\"args\":{\"rc\":\"0x12345678\"}}" ) == 0 );
+
+	/* Complete trace length is calculated consistently */
+	ok ( timeline_json ( NULL, 0 ) > 0 );
+}
+
+/** Boot timeline self-test */
+struct self_test timeline_test __self_test = {
+	.name = "timeline",
+	.exec = timeline_test_exec,
+};
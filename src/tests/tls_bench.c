@@ -0,0 +1,249 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * TLS record processing benchmarks
+ *
+ * The TLS record layer is not directly accessible, so these
+ * benchmarks perform the same bulk operations as are used for an
+ * application data record by the TLS_RSA_WITH_AES_128_CBC_SHA256
+ * cipher suite: calculating (or verifying) the MAC, and encrypting
+ * (or decrypting) the record.
+ *
+ */
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <byteswap.h>
+#include <ipxe/crypto.h>
+#include <ipxe/hmac.h>
+#include <ipxe/aes.h>
+#include <ipxe/sha256.h>
+#include <ipxe/tls.h>
+#include <ipxe/bench.h>
+
+/** Length of plaintext in each record */
+#define TLS_BENCH_LEN 16384
+
+/** Cipher algorithm */
+#define TLS_BENCH_CIPHER ( &aes_cbc_algorithm )
+
+/** Cipher key length */
+#define TLS_BENCH_KEY_LEN ( 128 / 8 )
+
+/** MAC digest algorithm */
+#define TLS_BENCH_DIGEST ( &sha256_algorithm )
+
+/** Length of record (including MAC and padding) */
+#define TLS_BENCH_RECORD_LEN						\
+	( ( TLS_BENCH_LEN + SHA256_DIGEST_SIZE + AES_BLOCKSIZE ) &	\
+	  ~( AES_BLOCKSIZE - 1 ) )
+
+/** MAC pseudo-header */
+struct tls_bench_mac_header {
+	/** Sequence number */
+	uint64_t seq;
+	/** TLS header */
+	struct tls_header header;
+} __attribute__ (( packed ));
+
+/** Plaintext */
+static uint8_t tls_bench_plaintext[TLS_BENCH_LEN];
+
+/** Record */
+static uint8_t tls_bench_record[TLS_BENCH_RECORD_LEN];
+
+/** Encrypted record */
+static uint8_t tls_bench_ciphertext[TLS_BENCH_RECORD_LEN];
+
+/** MAC secret */
+static uint8_t tls_bench_mac_secret[SHA256_DIGEST_SIZE];
+
+/** Initialisation vector */
+static uint8_t tls_bench_iv[AES_BLOCKSIZE];
+
+/** Transmit cipher context */
+static void *tls_bench_tx_ctx;
+
+/** Receive cipher context */
+static void *tls_bench_rx_ctx;
+
+/**
+ * Calculate record MAC
+ *
+ * @v data		Plaintext
+ * @v mac		MAC to fill in
+ */
+static void tls_bench_hmac ( const void *data, void *mac ) {
+	struct digest_algorithm *digest = TLS_BENCH_DIGEST;
+	struct tls_bench_mac_header machdr;
+	uint8_t ctx[digest->ctxsize];
+	size_t secret_len = sizeof ( tls_bench_mac_secret );
+
+	/* Construct pseudo-header */
+	machdr.seq = cpu_to_be64 ( 0 );
+	machdr.header.type = TLS_TYPE_DATA;
+	machdr.header.version = htons ( TLS_VERSION_TLS_1_2 );
+	machdr.header.length = htons ( TLS_BENCH_LEN );
+
+	/* Calculate MAC */
+	hmac_init ( digest, ctx, tls_bench_mac_secret, &secret_len );
+	hmac_update ( digest, ctx, &machdr, sizeof ( machdr ) );
+	hmac_update ( digest, ctx, data, TLS_BENCH_LEN );
+	hmac_final ( digest, ctx, tls_bench_mac_secret, &secret_len, mac );
+}
+
+/**
+ * Run TLS transmit benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int tls_bench_tx_exec ( void ) {
+	size_t pad_len = ( TLS_BENCH_RECORD_LEN - TLS_BENCH_LEN -
+			   SHA256_DIGEST_SIZE );
+
+	/* Construct record */
+	memcpy ( tls_bench_record, tls_bench_plaintext, TLS_BENCH_LEN );
+	tls_bench_hmac ( tls_bench_plaintext,
+			 ( tls_bench_record + TLS_BENCH_LEN ) );
+	memset ( ( tls_bench_record + TLS_BENCH_RECORD_LEN - pad_len ),
+		 ( pad_len - 1 ), pad_len );
+
+	/* Encrypt record */
+	cipher_encrypt ( TLS_BENCH_CIPHER, tls_bench_tx_ctx, tls_bench_record,
+			 tls_bench_ciphertext, TLS_BENCH_RECORD_LEN );
+
+	return 0;
+}
+
+/**
+ * Run TLS receive benchmark iteration
+ *
+ * @ret rc		Return status code
+ */
+static int tls_bench_rx_exec ( void ) {
+	uint8_t mac[SHA256_DIGEST_SIZE];
+	size_t pad_len;
+
+	/* Decrypt record */
+	cipher_setiv ( TLS_BENCH_CIPHER, tls_bench_rx_ctx, tls_bench_iv );
+	cipher_decrypt ( TLS_BENCH_CIPHER, tls_bench_rx_ctx,
+			 tls_bench_ciphertext, tls_bench_record,
+			 TLS_BENCH_RECORD_LEN );
+
+	/* Check padding and MAC */
+	pad_len = ( tls_bench_record[ TLS_BENCH_RECORD_LEN - 1 ] + 1 );
+	if ( pad_len != ( TLS_BENCH_RECORD_LEN - TLS_BENCH_LEN -
+			  SHA256_DIGEST_SIZE ) )
+		return -EINVAL;
+	tls_bench_hmac ( tls_bench_record, mac );
+	if ( memcmp ( mac, ( tls_bench_record + TLS_BENCH_LEN ),
+		      sizeof ( mac ) ) != 0 )
+		return -EINVAL;
+
+	return 0;
+}
+
+/**
+ * Prepare TLS benchmark
+ *
+ * @ret rc		Return status code
+ */
+static int tls_bench_setup ( void ) {
+	struct cipher_algorithm *cipher = TLS_BENCH_CIPHER;
+	uint8_t key[TLS_BENCH_KEY_LEN];
+	unsigned int i;
+	int rc;
+
+	/* Allocate cipher contexts */
+	tls_bench_tx_ctx = malloc ( cipher->ctxsize );
+	tls_bench_rx_ctx = malloc ( cipher->ctxsize );
+	if ( ! ( tls_bench_tx_ctx && tls_bench_rx_ctx ) ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+
+	/* Fill buffers with pseudo-random data */
+	srand ( 0x1234568 );
+	for ( i = 0 ; i < sizeof ( tls_bench_plaintext ) ; i++ )
+		tls_bench_plaintext[i] = rand();
+	for ( i = 0 ; i < sizeof ( tls_bench_mac_secret ) ; i++ )
+		tls_bench_mac_secret[i] = rand();
+	for ( i = 0 ; i < sizeof ( key ) ; i++ )
+		key[i] = rand();
+	for ( i = 0 ; i < sizeof ( tls_bench_iv ) ; i++ )
+		tls_bench_iv[i] = rand();
+
+	/* Initialise ciphers */
+	if ( ( rc = cipher_setkey ( cipher, tls_bench_tx_ctx, key,
+				    sizeof ( key ) ) ) != 0 )
+		goto err_setkey;
+	if ( ( rc = cipher_setkey ( cipher, tls_bench_rx_ctx, key,
+				    sizeof ( key ) ) ) != 0 )
+		goto err_setkey;
+	cipher_setiv ( cipher, tls_bench_tx_ctx, tls_bench_iv );
+
+	/* Construct an encrypted record for the receive benchmark */
+	tls_bench_tx_exec();
+
+	return 0;
+
+ err_setkey:
+ err_alloc:
+	free ( tls_bench_rx_ctx );
+	free ( tls_bench_tx_ctx );
+	return rc;
+}
+
+/**
+ * Clean up after TLS benchmark
+ *
+ */
+static void tls_bench_teardown ( void ) {
+
+	free ( tls_bench_rx_ctx );
+	free ( tls_bench_tx_ctx );
+}
+
+/** TLS transmit benchmark */
+struct benchmark tls_tx_benchmark __benchmark = {
+	.name = "tls_tx",
+	.len = TLS_BENCH_LEN,
+	.setup = tls_bench_setup,
+	.exec = tls_bench_tx_exec,
+	.teardown = tls_bench_teardown,
+};
+
+/** TLS receive benchmark */
+struct benchmark tls_rx_benchmark __benchmark = {
+	.name = "tls_rx",
+	.len = TLS_BENCH_LEN,
+	.setup = tls_bench_setup,
+	.exec = tls_bench_rx_exec,
+	.teardown = tls_bench_teardown,
+};
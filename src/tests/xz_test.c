@@ -0,0 +1,400 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * XZ decompression tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ipxe/xz.h>
+#include <ipxe/test.h>
+
+/** Number of lines in generated test data */
+#define XZ_LINES_COUNT 12000
+
+/** Length of generated test data */
+#define XZ_LINES_LEN 310680
+
+/** A XZ test */
+struct xz_test {
+	/** Compressed data */
+	const void *compressed;
+	/** Length of compressed data */
+	size_t compressed_len;
+	/** Expected uncompressed data */
+	const void *expected;
+	/** Length of expected uncompressed data */
+	size_t expected_len;
+};
+
+/** A XZ fragment list */
+struct xz_test_fragments {
+	/** Fragment lengths */
+	size_t len[8];
+};
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define an XZ test */
+#define XZ( name, COMPRESSED, EXPECTED )				\
+	static const uint8_t name ## _compressed[] = COMPRESSED;	\
+	static const uint8_t name ## _expected[] = EXPECTED;		\
+	static struct xz_test name = {				\
+		.compressed = name ## _compressed,			\
+		.compressed_len = sizeof ( name ## _compressed ),	\
+		.expected = name ## _expected,				\
+		.expected_len = sizeof ( name ## _expected ),		\
+	};
+
+/** Define an XZ test with generated expected data */
+#define XZ_LINES( name, COMPRESSED )					\
+	static const uint8_t name ## _compressed[] = COMPRESSED;	\
+	static struct xz_test name = {				\
+		.compressed = name ## _compressed,			\
+		.compressed_len = sizeof ( name ## _compressed ),	\
+		.expected = xz_lines_expected,			\
+		.expected_len = sizeof ( xz_lines_expected ),		\
+	};
+
+/** Generated expected data */
+static uint8_t xz_lines_expected[XZ_LINES_LEN];
+
+/** Decompressed data */
+static uint8_t xz_out[XZ_LINES_LEN];
+
+/* Empty file */
+XZ ( empty,
+	  DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x04, 0xe6, 0xd6,
+		 0xb4, 0x46, 0x00, 0x00, 0x00, 0x00, 0x1c, 0xdf, 0x44, 0x21,
+		 0x1f, 0xb6, 0xf3, 0x7d, 0x01, 0x00, 0x00, 0x00, 0x00, 0x04,
+		 0x59, 0x5a ),
+	  DATA() );
+
+/* "Hello world" (with CRC32 check) */
+XZ ( hello,
+	  DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x01, 0x69, 0x22,
+		 0xde, 0x36, 0x04, 0xc0, 0x0f, 0x0b, 0x21, 0x01, 0x16, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb9, 0x3e,
+		 0x01, 0x65, 0x01, 0x00, 0x0a, 0x48, 0x65, 0x6c, 0x6c, 0x6f,
+		 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64, 0x00, 0x00, 0x52, 0x9e,
+		 0xd6, 0x8b, 0x00, 0x01, 0x27, 0x0b, 0xc6, 0xde, 0x91, 0x6d,
+		 0x90, 0x42, 0x99, 0x0d, 0x01, 0x00, 0x00, 0x00, 0x00, 0x01,
+		 0x59, 0x5a ),
+	  DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+		 0x64 ) );
+
+/* GPL notice at preset 9 (with LZMA chunk and CRC64 check) */
+XZ ( gpl,
+	  DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x04, 0xe6, 0xd6,
+		 0xb4, 0x46, 0x04, 0xc0, 0xaf, 0x01, 0xde, 0x01, 0x21, 0x01,
+		 0x1c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xa6, 0x17,
+		 0x10, 0x91, 0xe0, 0x00, 0xdd, 0x00, 0xa7, 0x5d, 0x00, 0x2a,
+		 0x1a, 0x09, 0x27, 0x64, 0x19, 0xdd, 0x58, 0x40, 0x54, 0xec,
+		 0x31, 0xa6, 0x30, 0x86, 0xc2, 0x78, 0x49, 0xe5, 0x47, 0x34,
+		 0x88, 0xaa, 0x17, 0xb8, 0x0d, 0xf1, 0x1f, 0x5a, 0xbc, 0x55,
+		 0x36, 0x90, 0xd6, 0x8d, 0x0c, 0x08, 0x7b, 0x5a, 0x16, 0x67,
+		 0x85, 0x66, 0xc5, 0xa3, 0x5d, 0x5d, 0x5a, 0x9c, 0x09, 0x71,
+		 0x7a, 0x56, 0x2e, 0xb1, 0x30, 0x00, 0x7b, 0x74, 0x73, 0xc4,
+		 0x7b, 0xb1, 0xe8, 0xc5, 0xa5, 0x9a, 0xa4, 0x5d, 0x20, 0xf4,
+		 0xa8, 0x20, 0x14, 0x0f, 0x2b, 0xd8, 0xe2, 0xea, 0x67, 0xc6,
+		 0x02, 0xc3, 0x3c, 0x11, 0x86, 0x21, 0x84, 0xfb, 0xa4, 0x09,
+		 0xaf, 0xfd, 0x45, 0xa7, 0xd1, 0x92, 0xf0, 0xd6, 0xd6, 0x68,
+		 0x02, 0x11, 0x94, 0x7d, 0xb7, 0x12, 0x79, 0xa0, 0xbd, 0x0b,
+		 0xb5, 0x43, 0xc1, 0x06, 0x10, 0x05, 0xde, 0x63, 0x91, 0xa8,
+		 0x66, 0xfb, 0x02, 0xb1, 0x90, 0x56, 0x1a, 0x36, 0x42, 0x15,
+		 0xd7, 0xbb, 0xd0, 0x11, 0x17, 0xec, 0x77, 0x3c, 0xfd, 0x72,
+		 0x90, 0x38, 0x4c, 0xf6, 0xf6, 0x20, 0x29, 0x30, 0x65, 0xe4,
+		 0x03, 0xf5, 0x8e, 0xca, 0x07, 0xa6, 0x0c, 0x11, 0x2f, 0xf9,
+		 0x3b, 0x22, 0x1e, 0xff, 0xbf, 0xd5, 0x00, 0x00, 0x58, 0x1f,
+		 0xc6, 0xa3, 0x32, 0xa1, 0xac, 0x53, 0x00, 0x01, 0xcb, 0x01,
+		 0xde, 0x01, 0x00, 0x00, 0x87, 0xb7, 0x53, 0x42, 0xb1, 0xc4,
+		 0x67, 0xfb, 0x02, 0x00, 0x00, 0x00, 0x00, 0x04, 0x59, 0x5a ),
+	  DATA ( 0x54, 0x68, 0x69, 0x73, 0x20, 0x70, 0x72, 0x6f, 0x67, 0x72,
+		 0x61, 0x6d, 0x20, 0x69, 0x73, 0x20, 0x66, 0x72, 0x65, 0x65,
+		 0x20, 0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72, 0x65, 0x3b,
+		 0x20, 0x79, 0x6f, 0x75, 0x20, 0x63, 0x61, 0x6e, 0x20, 0x72,
+		 0x65, 0x64, 0x69, 0x73, 0x74, 0x72, 0x69, 0x62, 0x75, 0x74,
+		 0x65, 0x20, 0x69, 0x74, 0x20, 0x61, 0x6e, 0x64, 0x2f, 0x6f,
+		 0x72, 0x20, 0x6d, 0x6f, 0x64, 0x69, 0x66, 0x79, 0x20, 0x69,
+		 0x74, 0x20, 0x75, 0x6e, 0x64, 0x65, 0x72, 0x20, 0x74, 0x68,
+		 0x65, 0x20, 0x74, 0x65, 0x72, 0x6d, 0x73, 0x20, 0x6f, 0x66,
+		 0x20, 0x74, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47,
+		 0x65, 0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62,
+		 0x6c, 0x69, 0x63, 0x20, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73,
+		 0x65, 0x20, 0x61, 0x73, 0x20, 0x70, 0x75, 0x62, 0x6c, 0x69,
+		 0x73, 0x68, 0x65, 0x64, 0x20, 0x62, 0x79, 0x20, 0x74, 0x68,
+		 0x65, 0x20, 0x46, 0x72, 0x65, 0x65, 0x20, 0x53, 0x6f, 0x66,
+		 0x74, 0x77, 0x61, 0x72, 0x65, 0x20, 0x46, 0x6f, 0x75, 0x6e,
+		 0x64, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x3b, 0x20, 0x65, 0x69,
+		 0x74, 0x68, 0x65, 0x72, 0x20, 0x76, 0x65, 0x72, 0x73, 0x69,
+		 0x6f, 0x6e, 0x20, 0x32, 0x20, 0x6f, 0x66, 0x20, 0x74, 0x68,
+		 0x65, 0x20, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65, 0x2c,
+		 0x20, 0x6f, 0x72, 0x20, 0x61, 0x6e, 0x79, 0x20, 0x6c, 0x61,
+		 0x74, 0x65, 0x72, 0x20, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6f,
+		 0x6e, 0x2e ) );
+
+/* Generated lines at preset 9 (no check) */
+XZ_LINES ( lines,
+	  DATA ( 0xfd, 0x37, 0x7a, 0x58, 0x5a, 0x00, 0x00, 0x00, 0xff, 0x12,
+		 0xd9, 0x41, 0x04, 0xc0, 0x97, 0x06, 0x98, 0xfb, 0x12, 0x21,
+		 0x01, 0x1c, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x5c, 0x0f,
+		 0x2b, 0x86, 0xe4, 0xbd, 0x97, 0x03, 0x0f, 0x5d, 0x00, 0x34,
+		 0x94, 0x07, 0x04, 0x55, 0x16, 0xcb, 0x33, 0x7d, 0xe2, 0x3a,
+		 0x98, 0xe2, 0x0c, 0x0f, 0x66, 0xff, 0xf9, 0x86, 0x41, 0x7b,
+		 0xf8, 0x9a, 0x21, 0xf8, 0xc9, 0x6a, 0x79, 0x06, 0x6e, 0x93,
+		 0xbb, 0xbb, 0xc6, 0x0a, 0xa8, 0x4b, 0x6c, 0x86, 0xfd, 0x9f,
+		 0xee, 0xe3, 0x31, 0x76, 0x70, 0x85, 0x6a, 0x3b, 0xa2, 0x7e,
+		 0xc1, 0x99, 0xa8, 0xbd, 0x1a, 0x9e, 0x56, 0x56, 0x71, 0x51,
+		 0x59, 0xa3, 0xd9, 0xc7, 0xd7, 0xe4, 0x89, 0x05, 0x8a, 0xaa,
+		 0x97, 0xa6, 0xa3, 0xd1, 0xbd, 0x36, 0x7c, 0xc3, 0xca, 0x6e,
+		 0x2c, 0xb9, 0x41, 0x93, 0xff, 0xd5, 0xdb, 0xee, 0xe8, 0x19,
+		 0x10, 0x0c, 0xca, 0xe3, 0xb1, 0x46, 0x6f, 0x63, 0x06, 0x64,
+		 0x5c, 0xe2, 0x4d, 0x42, 0x6d, 0xfc, 0x61, 0x38, 0xf7, 0x29,
+		 0xe6, 0x7e, 0x89, 0xd3, 0x20, 0xde, 0x9a, 0xa8, 0x72, 0x0c,
+		 0x91, 0x25, 0x9d, 0x7a, 0xa6, 0x49, 0xdf, 0x74, 0xe9, 0x74,
+		 0xb1, 0xf8, 0xe2, 0xc3, 0xc7, 0x83, 0xab, 0x3d, 0x61, 0xb4,
+		 0x9f, 0x4f, 0x27, 0xcc, 0xc5, 0xb3, 0x99, 0xf6, 0x74, 0xda,
+		 0x43, 0x58, 0xf3, 0x3b, 0xd3, 0x11, 0xa0, 0x53, 0x1b, 0x18,
+		 0x7e, 0x70, 0xad, 0x67, 0xa9, 0xb5, 0x42, 0xd9, 0xdd, 0xd1,
+		 0xfa, 0xd7, 0xe3, 0x0e, 0x6c, 0x25, 0x8d, 0xcd, 0x0b, 0x1c,
+		 0x52, 0xce, 0x89, 0xa4, 0x33, 0x4b, 0x6a, 0xd9, 0x9a, 0x7d,
+		 0x06, 0xe0, 0x06, 0x6d, 0x31, 0xa9, 0xca, 0x87, 0xda, 0x3c,
+		 0x92, 0xd1, 0xcb, 0x95, 0x30, 0x9f, 0xca, 0xc8, 0x03, 0x75,
+		 0x3e, 0x5f, 0x00, 0xc2, 0xb7, 0x58, 0x18, 0xb9, 0x5a, 0xd1,
+		 0xeb, 0x64, 0x34, 0xc4, 0x5d, 0x2b, 0x36, 0x48, 0xbb, 0xae,
+		 0xba, 0xf8, 0xf4, 0x79, 0x47, 0x04, 0xf5, 0xe3, 0x1a, 0x93,
+		 0x17, 0xa6, 0xc4, 0x47, 0xa8, 0xd7, 0xc7, 0xf9, 0x67, 0xbf,
+		 0x91, 0xf5, 0xd7, 0x27, 0xb3, 0xb4, 0x03, 0x41, 0x95, 0x0e,
+		 0xb7, 0x32, 0x32, 0x95, 0xcf, 0x0a, 0xfc, 0x84, 0x8b, 0xad,
+		 0x35, 0xae, 0x2a, 0x2d, 0x02, 0xf3, 0xca, 0x2e, 0xef, 0xda,
+		 0x44, 0x6f, 0x10, 0xbc, 0xd5, 0x0c, 0x9d, 0xb9, 0xdf, 0x12,
+		 0x40, 0x3c, 0x36, 0xec, 0xd4, 0x3b, 0x78, 0xad, 0xcf, 0x9b,
+		 0xba, 0x46, 0x6c, 0xeb, 0x40, 0xff, 0x74, 0x85, 0x6e, 0x63,
+		 0x4b, 0x6c, 0xe1, 0xa8, 0x52, 0xf0, 0x80, 0x08, 0xc7, 0xa5,
+		 0xf8, 0xd1, 0x32, 0x28, 0x95, 0xf3, 0xe4, 0x01, 0xca, 0x55,
+		 0x09, 0xf2, 0x07, 0xcf, 0xf9, 0xa1, 0x9f, 0xe7, 0x31, 0x4e,
+		 0xd7, 0xaf, 0xa2, 0xc3, 0x19, 0xf6, 0x86, 0x23, 0xb4, 0x7b,
+		 0xb0, 0x43, 0x62, 0x91, 0x51, 0x32, 0xe5, 0x71, 0xe3, 0x7b,
+		 0xc6, 0xdc, 0x79, 0x69, 0x6c, 0x72, 0xc4, 0x43, 0x60, 0x59,
+		 0x99, 0xf7, 0x88, 0x76, 0x4e, 0xdc, 0x3b, 0xad, 0x65, 0x33,
+		 0x56, 0x9d, 0x3f, 0xdd, 0x38, 0x12, 0x11, 0x19, 0x5a, 0x1f,
+		 0x53, 0x06, 0x69, 0xcf, 0xa3, 0x22, 0x04, 0x0e, 0x62, 0x2c,
+		 0xdd, 0x45, 0x09, 0x6c, 0x43, 0xbb, 0xff, 0x37, 0x5d, 0xc5,
+		 0xf2, 0x7f, 0xa3, 0xda, 0xf6, 0x9a, 0x4c, 0x07, 0x77, 0x00,
+		 0xcd, 0x3c, 0x9c, 0xf8, 0xa8, 0xb8, 0xeb, 0x60, 0xdd, 0x62,
+		 0x7a, 0x2e, 0x5f, 0x12, 0x55, 0xe1, 0x14, 0x80, 0x2d, 0xc7,
+		 0xbe, 0x62, 0x77, 0xaa, 0xca, 0x8b, 0x1a, 0x9b, 0xe2, 0xd1,
+		 0x0e, 0x3a, 0xbd, 0x2e, 0x85, 0x46, 0x38, 0x30, 0x0d, 0x3a,
+		 0xcb, 0xb5, 0x13, 0x12, 0xa7, 0x7b, 0xcb, 0x2e, 0x75, 0xb2,
+		 0xbe, 0x4f, 0x99, 0xf5, 0xdf, 0x57, 0x69, 0x60, 0xd3, 0x51,
+		 0x28, 0xa3, 0x4c, 0x74, 0x1b, 0xca, 0x37, 0x27, 0xb7, 0x90,
+		 0xb0, 0x1b, 0xc1, 0xdb, 0x69, 0x66, 0xf5, 0xbe, 0x19, 0xda,
+		 0x46, 0xe7, 0xc9, 0xc4, 0xd9, 0xbc, 0x8c, 0x1c, 0x9e, 0x1f,
+		 0xc3, 0xdd, 0xc0, 0x2b, 0xda, 0x9f, 0x75, 0xc8, 0x5b, 0x19,
+		 0x67, 0x5d, 0xe6, 0x28, 0xda, 0x92, 0x33, 0x37, 0x44, 0x26,
+		 0xb7, 0x96, 0x4b, 0xeb, 0xe4, 0xe5, 0xea, 0x1e, 0x22, 0x02,
+		 0x43, 0xc3, 0x02, 0x8a, 0xf0, 0x64, 0x2c, 0xb7, 0x15, 0x1c,
+		 0x3d, 0x0b, 0x3b, 0x30, 0xe8, 0xc9, 0x0c, 0x9a, 0x84, 0x71,
+		 0x24, 0x16, 0xb9, 0xdb, 0xd0, 0xf3, 0x59, 0x5b, 0x19, 0x6e,
+		 0xfe, 0xc0, 0xa9, 0x32, 0x6c, 0x48, 0xfa, 0x1e, 0xa7, 0xcf,
+		 0xed, 0x59, 0x85, 0x36, 0x0d, 0x4f, 0xa1, 0x9e, 0x0d, 0x01,
+		 0x4b, 0xee, 0xb1, 0x12, 0x2f, 0x7e, 0x01, 0x58, 0x19, 0x0b,
+		 0x7e, 0x8e, 0xe4, 0x5b, 0xd3, 0xfa, 0xe6, 0xcf, 0x1e, 0x94,
+		 0x96, 0x8e, 0x5e, 0x35, 0xff, 0x68, 0xd8, 0x85, 0xd2, 0xee,
+		 0x1d, 0xd2, 0xe0, 0x89, 0xa3, 0xd3, 0x59, 0xa5, 0xc5, 0x7e,
+		 0xbc, 0xcf, 0x26, 0x5b, 0xed, 0x52, 0x78, 0x83, 0x08, 0x1d,
+		 0xe0, 0xfb, 0xfb, 0xa3, 0xf2, 0xaa, 0x83, 0x2a, 0xa9, 0x7a,
+		 0x9a, 0xa3, 0x2e, 0xf9, 0x1b, 0xb9, 0x6c, 0x50, 0x51, 0xaf,
+		 0xa4, 0x37, 0xa5, 0xd6, 0x8b, 0x6e, 0x7d, 0xc7, 0xa9, 0x10,
+		 0x96, 0x61, 0x1f, 0x09, 0xe7, 0x57, 0xb9, 0x05, 0xab, 0xd7,
+		 0x1d, 0x72, 0x32, 0x17, 0x0a, 0xb9, 0x6d, 0xdf, 0x99, 0x50,
+		 0x38, 0x4a, 0x34, 0xd0, 0x89, 0x06, 0x08, 0xbb, 0xc2, 0x7a,
+		 0x4f, 0xc6, 0x48, 0xbc, 0x5a, 0xe0, 0x8f, 0xab, 0xd7, 0x49,
+		 0xd4, 0x23, 0x90, 0x47, 0xcb, 0x33, 0x63, 0x8f, 0x1e, 0xea,
+		 0x27, 0x48, 0x1e, 0x20, 0xe2, 0xc7, 0xa5, 0xf3, 0x9a, 0x1e,
+		 0x54, 0xac, 0x87, 0xdb, 0xbc, 0x08, 0x57, 0x39, 0x8a, 0x41,
+		 0xc6, 0x88, 0x46, 0xa0, 0x87, 0x8c, 0x3e, 0xec, 0xf1, 0x43,
+		 0xf7, 0x25, 0x7f, 0xee, 0x56, 0x15, 0x9f, 0x95, 0x0b, 0xe1,
+		 0xe0, 0x58, 0x2b, 0xc5, 0x5e, 0x51, 0xa2, 0xe7, 0xbb, 0xd5,
+		 0x78, 0xe5, 0xf4, 0x01, 0x7d, 0xdc, 0x9c, 0xf0, 0xee, 0x70,
+		 0xf7, 0x00, 0x00, 0x00, 0x00, 0x01, 0xab, 0x06, 0x98, 0xfb,
+		 0x12, 0x00, 0xf9, 0xe5, 0x5f, 0x86, 0xa8, 0x00, 0x0a, 0xfc,
+		 0x02, 0x00, 0x00, 0x00, 0x00, 0x00, 0x59, 0x5a ) );
+
+/* GPL notice fragment list */
+static struct xz_test_fragments gpl_fragments[] = {
+	{ { 1, 1, 1, 1, 1, 1, 1, -1UL } },
+	{ { 4, 1, 3, 5, 7, 11, 13, -1UL } },
+	{ { 0, 17, 0, 30, 1, 100, 1, -1UL } },
+	{ { 239, -1UL } },
+};
+
+/* Generated lines fragment list */
+static struct xz_test_fragments lines_fragments[] = {
+	{ { 1, 2, 3, 4, 5, 6, 7, -1UL } },
+	{ { 100, 100, 100, 100, 100, -1UL } },
+	{ { 847, -1UL } },
+};
+
+/**
+ * Generate expected data
+ *
+ */
+static void xz_lines_generate ( void ) {
+	char *data = ( ( char * ) xz_lines_expected );
+	char buf[32];
+	size_t len = 0;
+	size_t frag_len;
+	unsigned int i;
+
+	for ( i = 0 ; i < XZ_LINES_COUNT ; i++ ) {
+		frag_len = snprintf ( buf, sizeof ( buf ),
+				      "iPXE line %d of the test\n",
+				      ( i % 1000 ) );
+		assert ( ( len + frag_len ) <= sizeof ( xz_lines_expected ) );
+		memcpy ( ( data + len ), buf, frag_len );
+		len += frag_len;
+	}
+	assert ( len == sizeof ( xz_lines_expected ) );
+}
+
+/**
+ * Report XZ test result
+ *
+ * @v xz		Decompressor
+ * @v test		XZ test
+ * @v frags		Fragment list, or NULL
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void xz_okx ( struct xz *xz, struct xz_test *test,
+		       struct xz_test_fragments *frags,
+		       const char *file, unsigned int line ) {
+	struct deflate_chunk in;
+	struct deflate_chunk out;
+	size_t frag_len = -1UL;
+	size_t offset = 0;
+	size_t remaining = test->compressed_len;
+	unsigned int i;
+
+	/* Initialise decompressor */
+	xz_init ( xz );
+
+	/* Initialise output chunk */
+	assert ( test->expected_len <= sizeof ( xz_out ) );
+	deflate_chunk_init ( &out, virt_to_user ( xz_out ), 0,
+			     test->expected_len );
+
+	/* Process input (in fragments, if applicable) */
+	for ( i = 0 ; i < ( sizeof ( frags->len ) /
+			    sizeof ( frags->len[0] ) ) ; i++ ) {
+
+		/* Initialise input chunk */
+		if ( frags )
+			frag_len = frags->len[i];
+		if ( frag_len > remaining )
+			frag_len = remaining;
+		deflate_chunk_init ( &in, virt_to_user ( test->compressed ),
+				     offset, ( offset + frag_len ) );
+
+		/* Decompress this fragment */
+		okx ( xz_decompress ( xz, &in, &out ) == 0, file, line );
+		okx ( in.len == ( offset + frag_len ), file, line );
+		okx ( in.offset == in.len, file, line );
+
+		/* Move to next fragment */
+		offset = in.offset;
+		remaining -= frag_len;
+		if ( ! remaining )
+			break;
+
+		/* Check that decompression has not terminated early */
+		okx ( ! xz_finished ( xz ), file, line );
+	}
+
+	/* Check decompression has terminated as expected */
+	okx ( xz_finished ( xz ), file, line );
+	okx ( offset == test->compressed_len, file, line );
+	okx ( out.offset == test->expected_len, file, line );
+	okx ( memcmp ( xz_out, test->expected, test->expected_len ) == 0,
+	      file, line );
+}
+#define xz_ok( xz, test, frags ) \
+	xz_okx ( xz, test, frags, __FILE__, __LINE__ )
+
+/**
+ * Perform XZ self-test
+ *
+ */
+static void xz_test_exec ( void ) {
+	struct xz *xz;
+	unsigned int i;
+
+	/* Allocate shared structure */
+	xz = malloc ( sizeof ( *xz ) );
+	ok ( xz != NULL );
+
+	/* Generate expected data */
+	xz_lines_generate();
+
+	/* Perform self-tests */
+	if ( xz ) {
+
+		/* Test as a single pass */
+		xz_ok ( xz, &empty, NULL );
+		xz_ok ( xz, &hello, NULL );
+		xz_ok ( xz, &gpl, NULL );
+		xz_ok ( xz, &lines, NULL );
+
+		/* Test fragmentation */
+		for ( i = 0 ; i < ( sizeof ( gpl_fragments ) /
+				    sizeof ( gpl_fragments[0] ) ) ; i++ ) {
+			xz_ok ( xz, &gpl, &gpl_fragments[i] );
+		}
+		for ( i = 0 ; i < ( sizeof ( lines_fragments ) /
+				    sizeof ( lines_fragments[0] ) ) ; i++ ) {
+			xz_ok ( xz, &lines, &lines_fragments[i] );
+		}
+	}
+
+	/* Free shared structure */
+	free ( xz );
+}
+
+/** XZ self-test */
+struct self_test xz_test __self_test = {
+	.name = "xz",
+	.exec = xz_test_exec,
+};
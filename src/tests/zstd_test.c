@@ -0,0 +1,370 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+/** @file
+ *
+ * Zstandard decompression tests
+ *
+ */
+
+/* Forcibly enable assertions */
+#undef NDEBUG
+
+#include <assert.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <ipxe/zstd.h>
+#include <ipxe/test.h>
+
+/** Number of lines in generated multi-block test data */
+#define ZSTD_LINES_COUNT 12000
+
+/** Length of generated multi-block test data */
+#define ZSTD_LINES_LEN 310680
+
+/** A Zstandard test */
+struct zstd_test {
+	/** Compressed data */
+	const void *compressed;
+	/** Length of compressed data */
+	size_t compressed_len;
+	/** Expected uncompressed data */
+	const void *expected;
+	/** Length of expected uncompressed data */
+	size_t expected_len;
+};
+
+/** A Zstandard fragment list */
+struct zstd_test_fragments {
+	/** Fragment lengths */
+	size_t len[8];
+};
+
+/** Define inline data */
+#define DATA(...) { __VA_ARGS__ }
+
+/** Define a Zstandard test */
+#define ZSTD( name, COMPRESSED, EXPECTED )				\
+	static const uint8_t name ## _compressed[] = COMPRESSED;	\
+	static const uint8_t name ## _expected[] = EXPECTED;		\
+	static struct zstd_test name = {				\
+		.compressed = name ## _compressed,			\
+		.compressed_len = sizeof ( name ## _compressed ),	\
+		.expected = name ## _expected,				\
+		.expected_len = sizeof ( name ## _expected ),		\
+	};
+
+/** Define a Zstandard test with generated multi-block expected data */
+#define ZSTD_LINES( name, COMPRESSED )					\
+	static const uint8_t name ## _compressed[] = COMPRESSED;	\
+	static struct zstd_test name = {				\
+		.compressed = name ## _compressed,			\
+		.compressed_len = sizeof ( name ## _compressed ),	\
+		.expected = zstd_lines_expected,			\
+		.expected_len = sizeof ( zstd_lines_expected ),		\
+	};
+
+/** Generated multi-block expected data */
+static uint8_t zstd_lines_expected[ZSTD_LINES_LEN];
+
+/** Decompressed data (with space for a maximum-length block) */
+static uint8_t zstd_out[ ZSTD_LINES_LEN + ZSTD_BLOCK_MAX ];
+
+/* Empty file */
+ZSTD ( empty,
+	  DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x00, 0x01, 0x00, 0x00, 0x99,
+		 0xe9, 0xd8, 0x51 ),
+	  DATA() );
+
+/* "Hello world" (with content checksum) */
+ZSTD ( hello,
+	  DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x0b, 0x59, 0x00, 0x00, 0x48,
+		 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c, 0x64,
+		 0xd8, 0x76, 0xb3, 0x12 ),
+	  DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+		 0x64 ) );
+
+/* "Hello world" preceded by a skippable frame */
+ZSTD ( skippable,
+	  DATA ( 0x50, 0x2a, 0x4d, 0x18, 0x04, 0x00, 0x00, 0x00, 0x69, 0x50,
+		 0x58, 0x45, 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0x0b, 0x59, 0x00,
+		 0x00, 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72,
+		 0x6c, 0x64, 0xd8, 0x76, 0xb3, 0x12 ),
+	  DATA ( 0x48, 0x65, 0x6c, 0x6c, 0x6f, 0x20, 0x77, 0x6f, 0x72, 0x6c,
+		 0x64 ) );
+
+/* GPL notice at level 19 (with Huffman literals and FSE sequences) */
+ZSTD ( gpl,
+	  DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0x24, 0xde, 0xad, 0x04, 0x00, 0x02,
+		 0x4b, 0x1f, 0x18, 0x70, 0x4f, 0x1b, 0xa0, 0x20, 0x3b, 0x6a,
+		 0x23, 0x50, 0x46, 0x24, 0x90, 0xff, 0xc9, 0x2e, 0x1c, 0xbb,
+		 0x95, 0x8f, 0x02, 0x40, 0x95, 0x78, 0x01, 0x41, 0xa3, 0xf4,
+		 0xab, 0xe1, 0x79, 0x0f, 0x0c, 0x6f, 0xab, 0x8e, 0xb3, 0x3a,
+		 0x67, 0xd4, 0x9a, 0x27, 0xda, 0x6a, 0x23, 0x6b, 0x6f, 0x8b,
+		 0x2b, 0xcf, 0xe4, 0xe2, 0x6a, 0xce, 0x32, 0x72, 0xd4, 0x1d,
+		 0x3e, 0x5d, 0x4b, 0x47, 0x8f, 0x3b, 0x2a, 0x35, 0x2f, 0xb9,
+		 0x84, 0x9c, 0x2d, 0x8d, 0x33, 0x88, 0xf1, 0xec, 0xdd, 0xc4,
+		 0xd9, 0xcf, 0xa8, 0xcf, 0xc9, 0xda, 0x7b, 0xeb, 0xaf, 0x47,
+		 0xd9, 0x4e, 0xe7, 0x15, 0x58, 0xc3, 0xb7, 0x3e, 0xfb, 0x35,
+		 0xca, 0xed, 0x94, 0x25, 0xbf, 0xa1, 0xf3, 0xb7, 0xd7, 0x89,
+		 0x64, 0xb4, 0xfa, 0x59, 0xf7, 0x4c, 0x7e, 0xee, 0xf4, 0x13,
+		 0x32, 0xb4, 0x4c, 0xdd, 0x69, 0xb4, 0x04, 0x07, 0x00, 0x4a,
+		 0x77, 0x46, 0x41, 0x40, 0x64, 0x64, 0x17, 0x30, 0x59, 0xa4,
+		 0x6a, 0x73, 0xcd, 0xe5, 0x1a, 0x08, 0xd3, 0x0c, 0x11, 0xdd,
+		 0x08, 0x6e ),
+	  DATA ( 0x54, 0x68, 0x69, 0x73, 0x20, 0x70, 0x72, 0x6f, 0x67, 0x72,
+		 0x61, 0x6d, 0x20, 0x69, 0x73, 0x20, 0x66, 0x72, 0x65, 0x65,
+		 0x20, 0x73, 0x6f, 0x66, 0x74, 0x77, 0x61, 0x72, 0x65, 0x3b,
+		 0x20, 0x79, 0x6f, 0x75, 0x20, 0x63, 0x61, 0x6e, 0x20, 0x72,
+		 0x65, 0x64, 0x69, 0x73, 0x74, 0x72, 0x69, 0x62, 0x75, 0x74,
+		 0x65, 0x20, 0x69, 0x74, 0x20, 0x61, 0x6e, 0x64, 0x2f, 0x6f,
+		 0x72, 0x20, 0x6d, 0x6f, 0x64, 0x69, 0x66, 0x79, 0x20, 0x69,
+		 0x74, 0x20, 0x75, 0x6e, 0x64, 0x65, 0x72, 0x20, 0x74, 0x68,
+		 0x65, 0x20, 0x74, 0x65, 0x72, 0x6d, 0x73, 0x20, 0x6f, 0x66,
+		 0x20, 0x74, 0x68, 0x65, 0x20, 0x47, 0x4e, 0x55, 0x20, 0x47,
+		 0x65, 0x6e, 0x65, 0x72, 0x61, 0x6c, 0x20, 0x50, 0x75, 0x62,
+		 0x6c, 0x69, 0x63, 0x20, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73,
+		 0x65, 0x20, 0x61, 0x73, 0x20, 0x70, 0x75, 0x62, 0x6c, 0x69,
+		 0x73, 0x68, 0x65, 0x64, 0x20, 0x62, 0x79, 0x20, 0x74, 0x68,
+		 0x65, 0x20, 0x46, 0x72, 0x65, 0x65, 0x20, 0x53, 0x6f, 0x66,
+		 0x74, 0x77, 0x61, 0x72, 0x65, 0x20, 0x46, 0x6f, 0x75, 0x6e,
+		 0x64, 0x61, 0x74, 0x69, 0x6f, 0x6e, 0x3b, 0x20, 0x65, 0x69,
+		 0x74, 0x68, 0x65, 0x72, 0x20, 0x76, 0x65, 0x72, 0x73, 0x69,
+		 0x6f, 0x6e, 0x20, 0x32, 0x20, 0x6f, 0x66, 0x20, 0x74, 0x68,
+		 0x65, 0x20, 0x4c, 0x69, 0x63, 0x65, 0x6e, 0x73, 0x65, 0x2c,
+		 0x20, 0x6f, 0x72, 0x20, 0x61, 0x6e, 0x79, 0x20, 0x6c, 0x61,
+		 0x74, 0x65, 0x72, 0x20, 0x76, 0x65, 0x72, 0x73, 0x69, 0x6f,
+		 0x6e, 0x2e ) );
+
+/* Generated lines at level 19 (with multiple blocks, no checksum) */
+ZSTD_LINES ( lines,
+	  DATA ( 0x28, 0xb5, 0x2f, 0xfd, 0xa0, 0x98, 0xbd, 0x04, 0x00, 0xa4,
+		 0x09, 0x00, 0xb6, 0xd7, 0x32, 0x16, 0x90, 0xa9, 0x9a, 0x03,
+		 0xb5, 0xaf, 0x82, 0x11, 0x37, 0x15, 0xdb, 0x50, 0x44, 0x44,
+		 0x84, 0xc8, 0xc4, 0x01, 0x19, 0x4f, 0x03, 0x02, 0x37, 0x00,
+		 0x29, 0x00, 0x2c, 0x00, 0x34, 0xd2, 0x19, 0x74, 0x56, 0x34,
+		 0xd2, 0x19, 0x73, 0x56, 0x34, 0xd2, 0x19, 0x72, 0x56, 0x34,
+		 0xd2, 0x19, 0x3d, 0x2b, 0x1a, 0xe9, 0x8c, 0xcf, 0x8a, 0x46,
+		 0x3a, 0x79, 0x56, 0x34, 0xd2, 0x09, 0xb0, 0xa0, 0x70, 0x58,
+		 0x30, 0x1c, 0x0a, 0x16, 0x0c, 0x04, 0x09, 0x86, 0x30, 0x1c,
+		 0x10, 0x0c, 0x0e, 0x0c, 0x01, 0x03, 0x02, 0x06, 0x01, 0xbd,
+		 0xed, 0x9a, 0x9e, 0xe5, 0xfe, 0x3c, 0x3e, 0x1a, 0x8b, 0xc4,
+		 0xa1, 0xb0, 0x9c, 0x64, 0xf0, 0xc2, 0xa2, 0x82, 0x62, 0x42,
+		 0xa2, 0x71, 0x30, 0xce, 0x8a, 0x46, 0x3a, 0xe3, 0xce, 0x8a,
+		 0x46, 0x3a, 0xc3, 0xce, 0x8a, 0x46, 0x3a, 0xa3, 0xce, 0x2a,
+		 0x55, 0x54, 0x53, 0x52, 0xad, 0x8b, 0x15, 0x75, 0x64, 0x54,
+		 0x44, 0x34, 0x24, 0x54, 0x9a, 0x48, 0x41, 0x37, 0x36, 0x35,
+		 0x34, 0x33, 0x32, 0x9d, 0x87, 0x13, 0x73, 0x62, 0x52, 0x42,
+		 0x32, 0x22, 0x52, 0x59, 0x28, 0x21, 0x57, 0x6b, 0x95, 0x3a,
+		 0x95, 0xb6, 0x97, 0x8d, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f, 0x67, 0x57, 0x47,
+		 0x37, 0x27, 0xd7, 0xfb, 0x78, 0x71, 0x67, 0x66, 0x65, 0x64,
+		 0x63, 0x62, 0xb5, 0x8d, 0x16, 0x76, 0x65, 0x15, 0x80, 0xfa,
+		 0xa8, 0x11, 0x50, 0xfa, 0xfe, 0x6f, 0xe0, 0xa5, 0x65, 0x0e,
+		 0x11, 0x3c, 0x42, 0xf0, 0x6b, 0xc8, 0x0f, 0x65, 0xa3, 0x88,
+		 0x2c, 0x92, 0x85, 0x64, 0x91, 0x2c, 0x24, 0x8b, 0x64, 0x22,
+		 0x59, 0x24, 0x13, 0xc9, 0x22, 0xa9, 0x48, 0xaa, 0x56, 0x94,
+		 0x04, 0x98, 0xca, 0xa9, 0x8c, 0xca, 0xa4, 0x4c, 0xc9, 0x54,
+		 0x4c, 0x65, 0x54, 0x26, 0x65, 0x4a, 0xa6, 0x62, 0x2a, 0xa3,
+		 0x32, 0x29, 0x53, 0x32, 0xb9, 0xf6, 0xa6, 0x66, 0x3c, 0xb1,
+		 0x77, 0x73, 0xfb, 0xc6, 0xf7, 0x95, 0xef, 0x35, 0xb7, 0x6f,
+		 0x7c, 0x5f, 0xf9, 0x5e, 0x73, 0xfb, 0xc6, 0xcf, 0x3b, 0x3a,
+		 0x3b, 0x73, 0x4d, 0x6c, 0x8b, 0xbc, 0x7a, 0x2c, 0xb0, 0xab,
+		 0x14, 0x02, 0x00, 0xa2, 0x0f, 0x0e, 0x04, 0xf0, 0x39, 0xb2,
+		 0x82, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+		 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+		 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0xff, 0xff, 0xff, 0xff,
+		 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x0f, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x01, 0x80, 0xfa, 0x54, 0x01, 0x00, 0x16, 0x01, 0x14,
+		 0x02, 0x00, 0xa2, 0x0f, 0x0e, 0x04, 0xf0, 0x39, 0x32, 0x93,
+		 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55, 0x55,
+		 0x55, 0x55, 0x05, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xf0, 0xff, 0xff,
+		 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
+		 0x01, 0x80, 0xfa, 0x54, 0x01, 0x00, 0x16, 0x01, 0xec, 0x02,
+		 0x00, 0xb2, 0x4f, 0x10, 0x07, 0xe0, 0xe9, 0xc0, 0x0b, 0x99,
+		 0xc0, 0x44, 0xa9, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa,
+		 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xaa, 0xfa, 0xff, 0xff,
+		 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+		 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x20, 0x80,
+		 0xfb, 0x68, 0x01, 0xe0, 0xf7, 0xcf, 0x12, 0xf8, 0x5f, 0x41,
+		 0xc0, 0xbf, 0xfe, 0xff, 0x6f, 0xd4, 0x9a, 0x25, 0x65, 0x2b,
+		 0x10, 0x84, 0x02, 0x1e, 0x54, 0x00, 0x00, 0x00, 0x01, 0x00,
+		 0xfd, 0xff, 0xad, 0xf9, 0xb9, 0x06, 0x02, 0x45, 0x00, 0x00,
+		 0x00, 0x01, 0x00, 0x95, 0x3d, 0x1d, 0x00, 0x01 ) );
+
+/* GPL notice fragment list */
+static struct zstd_test_fragments gpl_fragments[] = {
+	{ { 1, 1, 1, 1, 1, 1, 1, -1UL } },
+	{ { 4, 1, 3, 5, 7, 11, 13, -1UL } },
+	{ { 0, 17, 0, 30, 1, 100, 1, -1UL } },
+	{ { 161, -1UL } },
+};
+
+/* Generated lines fragment list */
+static struct zstd_test_fragments lines_fragments[] = {
+	{ { 1, 2, 3, 4, 5, 6, 7, -1UL } },
+	{ { 100, 100, 100, 100, 100, -1UL } },
+	{ { 577, -1UL } },
+};
+
+/**
+ * Generate multi-block expected data
+ *
+ */
+static void zstd_lines_generate ( void ) {
+	char *data = ( ( char * ) zstd_lines_expected );
+	char buf[32];
+	size_t len = 0;
+	size_t frag_len;
+	unsigned int i;
+
+	for ( i = 0 ; i < ZSTD_LINES_COUNT ; i++ ) {
+		frag_len = snprintf ( buf, sizeof ( buf ),
+				      "iPXE line %d of the test\n",
+				      ( i % 1000 ) );
+		assert ( ( len + frag_len ) <= sizeof ( zstd_lines_expected ) );
+		memcpy ( ( data + len ), buf, frag_len );
+		len += frag_len;
+	}
+	assert ( len == sizeof ( zstd_lines_expected ) );
+}
+
+/**
+ * Report Zstandard test result
+ *
+ * @v zstd		Decompressor
+ * @v test		Zstandard test
+ * @v frags		Fragment list, or NULL
+ * @v file		Test code file
+ * @v line		Test code line
+ */
+static void zstd_okx ( struct zstd *zstd, struct zstd_test *test,
+		       struct zstd_test_fragments *frags,
+		       const char *file, unsigned int line ) {
+	struct deflate_chunk in;
+	struct deflate_chunk out;
+	size_t frag_len = -1UL;
+	size_t offset = 0;
+	size_t remaining = test->compressed_len;
+	unsigned int i;
+
+	/* Initialise decompressor */
+	zstd_init ( zstd );
+
+	/* Initialise output chunk */
+	assert ( ( test->expected_len + ZSTD_BLOCK_MAX ) <=
+		 sizeof ( zstd_out ) );
+	deflate_chunk_init ( &out, virt_to_user ( zstd_out ), 0,
+			     ( test->expected_len + ZSTD_BLOCK_MAX ) );
+
+	/* Process input (in fragments, if applicable) */
+	for ( i = 0 ; i < ( sizeof ( frags->len ) /
+			    sizeof ( frags->len[0] ) ) ; i++ ) {
+
+		/* Initialise input chunk */
+		if ( frags )
+			frag_len = frags->len[i];
+		if ( frag_len > remaining )
+			frag_len = remaining;
+		deflate_chunk_init ( &in, virt_to_user ( test->compressed ),
+				     offset, ( offset + frag_len ) );
+
+		/* Decompress this fragment */
+		okx ( zstd_decompress ( zstd, &in, &out ) == 0, file, line );
+		okx ( in.len == ( offset + frag_len ), file, line );
+		okx ( in.offset == in.len, file, line );
+
+		/* Move to next fragment */
+		offset = in.offset;
+		remaining -= frag_len;
+		if ( ! remaining )
+			break;
+
+		/* Check that decompression has not terminated early */
+		okx ( ! zstd_finished ( zstd ), file, line );
+	}
+
+	/* Check decompression has terminated as expected */
+	okx ( zstd_finished ( zstd ), file, line );
+	okx ( offset == test->compressed_len, file, line );
+	okx ( out.offset == test->expected_len, file, line );
+	okx ( memcmp ( zstd_out, test->expected, test->expected_len ) == 0,
+	      file, line );
+}
+#define zstd_ok( zstd, test, frags ) \
+	zstd_okx ( zstd, test, frags, __FILE__, __LINE__ )
+
+/**
+ * Perform Zstandard self-test
+ *
+ */
+static void zstd_test_exec ( void ) {
+	struct zstd *zstd;
+	unsigned int i;
+
+	/* Allocate shared structure */
+	zstd = malloc ( sizeof ( *zstd ) );
+	ok ( zstd != NULL );
+
+	/* Generate multi-block expected data */
+	zstd_lines_generate();
+
+	/* Perform self-tests */
+	if ( zstd ) {
+
+		/* Test as a single pass */
+		zstd_ok ( zstd, &empty, NULL );
+		zstd_ok ( zstd, &hello, NULL );
+		zstd_ok ( zstd, &skippable, NULL );
+		zstd_ok ( zstd, &gpl, NULL );
+		zstd_ok ( zstd, &lines, NULL );
+
+		/* Test fragmentation */
+		for ( i = 0 ; i < ( sizeof ( gpl_fragments ) /
+				    sizeof ( gpl_fragments[0] ) ) ; i++ ) {
+			zstd_ok ( zstd, &gpl, &gpl_fragments[i] );
+		}
+		for ( i = 0 ; i < ( sizeof ( lines_fragments ) /
+				    sizeof ( lines_fragments[0] ) ) ; i++ ) {
+			zstd_ok ( zstd, &lines, &lines_fragments[i] );
+		}
+	}
+
+	/* Free shared structure */
+	free ( zstd );
+}
+
+/** Zstandard self-test */
+struct self_test zstd_test __self_test = {
+	.name = "zstd",
+	.exec = zstd_test_exec,
+};
@@ -87,6 +87,17 @@ __weak int pxe_menu_boot ( struct net_device *netdev __unused ) {
 	return -ENOTSUP;
 }
 
+/**
+ * Boot from all network devices concurrently when not supported
+ *
+ * @v is_candidate	Candidate network device test, or NULL
+ * @ret rc		Return status code
+ */
+__weak int netboot_concurrent ( int ( * is_candidate )
+					( struct net_device *netdev ) __unused ) {
+	return -ENOTSUP;
+}
+
 /** The "keep-san" setting */
 const struct setting keep_san_setting __setting ( SETTING_SANBOOT_EXTRA,
 						  keep-san ) = {
@@ -352,9 +363,10 @@ static char * fetch_san_filename ( struct settings *settings ) {
 /**
  * Check whether or not we have a usable PXE menu
  *
+ * @v settings		Settings block
  * @ret have_menu	A usable PXE menu is present
  */
-static int have_pxe_menu ( void ) {
+static int have_pxe_menu ( struct settings *settings ) {
 	struct setting vendor_class_id_setting
 		= { .tag = DHCP_VENDOR_CLASS_ID };
 	struct setting pxe_discovery_control_setting
@@ -364,57 +376,59 @@ static int have_pxe_menu ( void ) {
 	char buf[ 10 /* "PXEClient" + NUL */ ];
 	unsigned int pxe_discovery_control;
 
-	fetch_string_setting ( NULL, &vendor_class_id_setting,
+	fetch_string_setting ( settings, &vendor_class_id_setting,
 			       buf, sizeof ( buf ) );
 	pxe_discovery_control =
-		fetch_uintz_setting ( NULL, &pxe_discovery_control_setting );
+		fetch_uintz_setting ( settings, &pxe_discovery_control_setting );
 
 	return ( ( strcmp ( buf, "PXEClient" ) == 0 ) &&
-		 setting_exists ( NULL, &pxe_boot_menu_setting ) &&
+		 setting_exists ( settings, &pxe_boot_menu_setting ) &&
 		 ( ! ( ( pxe_discovery_control & PXEBS_SKIP ) &&
-		       setting_exists ( NULL, &filename_setting ) ) ) );
+		       setting_exists ( settings, &filename_setting ) ) ) );
 }
 
 /**
- * Boot from a network device
+ * Check whether or not we have something to boot
+ *
+ * @v settings		Settings block
+ * @ret bootable	Settings specify something to boot
+ */
+int netboot_is_bootable ( struct settings *settings ) {
+
+	return ( have_pxe_menu ( settings ) ||
+		 setting_exists ( settings, &filename_setting ) ||
+		 setting_exists ( settings, &root_path_setting ) );
+}
+
+/**
+ * Boot from a configured network device
  *
  * @v netdev		Network device
+ * @v settings		Settings block, or NULL to use all settings
  * @ret rc		Return status code
  */
-int netboot ( struct net_device *netdev ) {
+int netboot_configured ( struct net_device *netdev,
+			 struct settings *settings ) {
 	struct uri *filename;
 	struct uri *root_path;
 	char *san_filename;
 	int rc;
 
-	/* Close all other network devices */
-	close_all_netdevs();
-
-	/* Open device and display device status */
-	if ( ( rc = ifopen ( netdev ) ) != 0 )
-		goto err_ifopen;
-	ifstat ( netdev );
-
-	/* Configure device */
-	if ( ( rc = ifconf ( netdev, NULL ) ) != 0 )
-		goto err_dhcp;
-	route();
-
 	/* Try PXE menu boot, if applicable */
-	if ( have_pxe_menu() ) {
+	if ( have_pxe_menu ( settings ) ) {
 		printf ( "Booting from PXE menu\n" );
 		rc = pxe_menu_boot ( netdev );
 		goto err_pxe_menu_boot;
 	}
 
 	/* Fetch next server and filename (if any) */
-	filename = fetch_next_server_and_filename ( NULL );
+	filename = fetch_next_server_and_filename ( settings );
 
 	/* Fetch root path (if any) */
-	root_path = fetch_root_path ( NULL );
+	root_path = fetch_root_path ( settings );
 
 	/* Fetch SAN filename (if any) */
-	san_filename = fetch_san_filename ( NULL );
+	san_filename = fetch_san_filename ( settings );
 
 	/* If we have both a filename and a root path, ignore an
 	 * unsupported or missing URI scheme in the root path, since
@@ -447,6 +461,34 @@ int netboot ( struct net_device *netdev ) {
 	uri_put ( root_path );
 	uri_put ( filename );
  err_pxe_menu_boot:
+	return rc;
+}
+
+/**
+ * Boot from a network device
+ *
+ * @v netdev		Network device
+ * @ret rc		Return status code
+ */
+int netboot ( struct net_device *netdev ) {
+	int rc;
+
+	/* Close all other network devices */
+	close_all_netdevs();
+
+	/* Open device and display device status */
+	if ( ( rc = ifopen ( netdev ) ) != 0 )
+		goto err_ifopen;
+	ifstat ( netdev );
+
+	/* Configure device */
+	if ( ( rc = ifconf ( netdev, NULL ) ) != 0 )
+		goto err_dhcp;
+	route();
+
+	/* Boot from configured device */
+	rc = netboot_configured ( netdev, NULL );
+
  err_dhcp:
  err_ifopen:
 	return rc;
@@ -519,20 +561,26 @@ void set_autoboot_ll_addr ( const void *ll_addr, size_t len ) {
  */
 static int autoboot ( void ) {
 	struct net_device *netdev;
-	int rc = -ENODEV;
+	int rc;
 
-	/* Try booting from each network device.  If we have a
-	 * specified autoboot device location, then use only devices
-	 * matching that location.
+	/* Try booting from all network devices concurrently, if
+	 * supported.  Otherwise, try booting from each network device
+	 * in turn.  If we have a specified autoboot device location,
+	 * then use only devices matching that location.
 	 */
-	for_each_netdev ( netdev ) {
-
-		/* Skip any non-matching devices, if applicable */
-		if ( is_autoboot_device && ( ! is_autoboot_device ( netdev ) ) )
-			continue;
-
-		/* Attempt booting from this device */
-		rc = netboot ( netdev );
+	rc = netboot_concurrent ( is_autoboot_device );
+	if ( rc == -ENOTSUP ) {
+		rc = -ENODEV;
+		for_each_netdev ( netdev ) {
+
+			/* Skip any non-matching devices, if applicable */
+			if ( is_autoboot_device &&
+			     ( ! is_autoboot_device ( netdev ) ) )
+				continue;
+
+			/* Attempt booting from this device */
+			rc = netboot ( netdev );
+		}
 	}
 
 	printf ( "No more network devices\n" );
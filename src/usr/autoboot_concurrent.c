@@ -0,0 +1,252 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <ipxe/netdevice.h>
+#include <ipxe/interface.h>
+#include <ipxe/job.h>
+#include <ipxe/monojob.h>
+#include <ipxe/timer.h>
+#include <ipxe/timeline.h>
+#include <usr/ifmgmt.h>
+#include <usr/route.h>
+#include <usr/autoboot.h>
+
+/** @file
+ *
+ * Concurrent network booting
+ *
+ * Network devices are opened and configured concurrently, and the
+ * first device to obtain something to boot is used.  This avoids
+ * waiting for a complete configuration timeout on each unconnected
+ * or unconfigured device in turn before reaching a working device.
+ *
+ */
+
+/** A candidate network boot device */
+struct netboot_candidate {
+	/** Network device */
+	struct net_device *netdev;
+	/** Configuration has been started */
+	int started;
+	/** Candidate has been eliminated */
+	int failed;
+};
+
+/** A concurrent network boot poller */
+struct netboot_poller {
+	/** Job control interface */
+	struct interface job;
+	/** Time at which devices were opened */
+	unsigned long start;
+	/** Chosen network device (if any) */
+	struct net_device *netdev;
+	/** Number of candidate devices */
+	unsigned int count;
+	/** Candidate devices */
+	struct netboot_candidate candidates[0];
+};
+
+/**
+ * Check progress of a candidate network boot device
+ *
+ * @v poller		Concurrent network boot poller
+ * @v candidate		Candidate device
+ * @ret ongoing		Candidate is still being configured
+ */
+static int netboot_candidate_progress ( struct netboot_poller *poller,
+					struct netboot_candidate *candidate ) {
+	struct net_device *netdev = candidate->netdev;
+	unsigned long elapsed;
+	int rc;
+
+	/* Do nothing if candidate has already been eliminated */
+	if ( candidate->failed )
+		return 0;
+
+	/* Start configuration once link is up */
+	if ( ! candidate->started ) {
+		if ( ! netdev_link_ok ( netdev ) ) {
+			elapsed = ( currticks() - poller->start );
+			if ( elapsed < LINK_WAIT_TIMEOUT )
+				return 1;
+			DBGC ( poller, "NETBOOT %s link is down: %s\n",
+			       netdev->name, strerror ( netdev->link_rc ) );
+			timeline_end ( "link", netdev, netdev->link_rc );
+			candidate->failed = 1;
+			return 0;
+		}
+		timeline_end ( "link", netdev, 0 );
+		if ( ( rc = netdev_configure_all ( netdev ) ) != 0 ) {
+			DBGC ( poller, "NETBOOT %s could not configure: %s\n",
+			       netdev->name, strerror ( rc ) );
+			candidate->failed = 1;
+			return 0;
+		}
+		candidate->started = 1;
+	}
+
+	/* Accept device as soon as it has something to boot */
+	if ( netboot_is_bootable ( netdev_settings ( netdev ) ) ) {
+		poller->netdev = netdev;
+		return 0;
+	}
+
+	/* Eliminate device once configuration has finished */
+	if ( netdev_configuration_in_progress ( netdev ) )
+		return 1;
+	DBGC ( poller, "NETBOOT %s has nothing to boot\n", netdev->name );
+	candidate->failed = 1;
+	return 0;
+}
+
+/**
+ * Report concurrent network boot progress
+ *
+ * @v poller		Concurrent network boot poller
+ * @v progress		Progress report to fill in
+ * @ret ongoing_rc	Ongoing job status code (if known)
+ *
+ * Candidates are checked in network device order, so the device
+ * chosen from several that become bootable at the same time is
+ * always the first of those devices.
+ */
+static int netboot_poller_progress ( struct netboot_poller *poller,
+				     struct job_progress *progress __unused ) {
+	unsigned int ongoing = 0;
+	unsigned int i;
+
+	/* Check each candidate */
+	for ( i = 0 ; i < poller->count ; i++ ) {
+		ongoing += netboot_candidate_progress ( poller,
+							&poller->candidates[i] );
+		if ( poller->netdev ) {
+			intf_close ( &poller->job, 0 );
+			return 0;
+		}
+	}
+
+	/* Fail if all candidates have been eliminated */
+	if ( ! ongoing )
+		intf_close ( &poller->job, -ENODEV );
+
+	return 0;
+}
+
+/** Concurrent network boot poller operations */
+static struct interface_operation netboot_poller_job_op[] = {
+	INTF_OP ( job_progress, struct netboot_poller *,
+		  netboot_poller_progress ),
+};
+
+/** Concurrent network boot poller descriptor */
+static struct interface_descriptor netboot_poller_job_desc =
+	INTF_DESC ( struct netboot_poller, job, netboot_poller_job_op );
+
+/**
+ * Boot from all network devices concurrently
+ *
+ * @v is_candidate	Candidate network device test, or NULL
+ * @ret rc		Return status code
+ */
+int netboot_concurrent ( int ( * is_candidate )
+				( struct net_device *netdev ) ) {
+	struct netboot_poller *poller;
+	struct netboot_candidate *candidate;
+	struct net_device *netdev;
+	unsigned int count = 0;
+	unsigned int i;
+	int rc;
+
+	/* Count candidate devices */
+	for_each_netdev ( netdev ) {
+		if ( ( ! is_candidate ) || is_candidate ( netdev ) )
+			count++;
+	}
+	if ( ! count )
+		return -ENODEV;
+
+	/* Allocate and initialise poller */
+	poller = zalloc ( sizeof ( *poller ) +
+			  ( count * sizeof ( poller->candidates[0] ) ) );
+	if ( ! poller ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	intf_init ( &poller->job, &netboot_poller_job_desc, NULL );
+
+	/* Open all candidate devices, and close all others */
+	candidate = poller->candidates;
+	for_each_netdev ( netdev ) {
+		if ( is_candidate && ( ! is_candidate ( netdev ) ) ) {
+			ifclose ( netdev );
+			continue;
+		}
+		candidate->netdev = netdev_get ( netdev );
+		if ( ifopen ( netdev ) == 0 ) {
+			timeline_begin ( "link", netdev );
+			ifstat ( netdev );
+		} else {
+			candidate->failed = 1;
+		}
+		candidate++;
+	}
+	poller->count = count;
+	poller->start = currticks();
+
+	/* Wait for a candidate to become bootable */
+	printf ( "Configuring (" );
+	for ( i = 0 ; i < count ; i++ ) {
+		netdev = poller->candidates[i].netdev;
+		printf ( "%s%s", ( i ? " " : "" ), netdev->name );
+	}
+	printf ( ")" );
+	intf_plug_plug ( &monojob, &poller->job );
+	if ( ( rc = monojob_wait ( "", 0 ) ) != 0 )
+		goto err_wait;
+	netdev = poller->netdev;
+
+	/* Close all other devices */
+	for ( i = 0 ; i < count ; i++ ) {
+		if ( poller->candidates[i].netdev != netdev )
+			ifclose ( poller->candidates[i].netdev );
+	}
+	route();
+
+	/* Boot from chosen device */
+	printf ( "Booting from %s\n", netdev->name );
+	rc = netboot_configured ( netdev, netdev_settings ( netdev ) );
+
+ err_wait:
+	for ( i = 0 ; i < count ; i++ )
+		netdev_put ( poller->candidates[i].netdev );
+	intf_shutdown ( &poller->job, rc );
+	free ( poller );
+ err_alloc:
+	return rc;
+}
@@ -34,6 +34,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/monojob.h>
 #include <ipxe/timer.h>
 #include <ipxe/errortab.h>
+#include <ipxe/timeline.h>
 #include <usr/ifmgmt.h>
 
 /** @file
@@ -42,9 +43,6 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
-/** Default time to wait for link-up */
-#define LINK_WAIT_TIMEOUT ( 15 * TICKS_PER_SEC )
-
 /** Default unsuccessful configuration status code */
 #define EADDRNOTAVAIL_CONFIG __einfo_error ( EINFO_EADDRNOTAVAIL_CONFIG )
 #define EINFO_EADDRNOTAVAIL_CONFIG					\
@@ -271,7 +269,10 @@ int ifconf ( struct net_device *netdev,
 	int rc;
 
 	/* Ensure device is open and link is up */
-	if ( ( rc = iflinkwait ( netdev, LINK_WAIT_TIMEOUT ) ) != 0 )
+	timeline_begin ( "link", netdev );
+	rc = iflinkwait ( netdev, LINK_WAIT_TIMEOUT );
+	timeline_end ( "link", netdev, rc );
+	if ( rc != 0 )
 		return rc;
 
 	/* Start configuration */
@@ -26,7 +26,12 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <stdint.h>
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 #include <errno.h>
+#include <ipxe/list.h>
+#include <ipxe/refcnt.h>
+#include <ipxe/interface.h>
+#include <ipxe/job.h>
 #include <ipxe/image.h>
 #include <ipxe/downloader.h>
 #include <ipxe/monojob.h>
@@ -40,6 +45,30 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
  *
  */
 
+/**
+ * Allocate image to be downloaded
+ *
+ * @v uri		URI
+ * @ret image		Image, or NULL on error
+ */
+static struct image * imgdownload_alloc ( struct uri *uri ) {
+	struct image *image;
+
+	/* Allocate image */
+	image = alloc_image ( uri );
+	if ( ! image )
+		return NULL;
+
+	/* Treat any image downloaded after a kernel has been selected
+	 * as an initrd, so that it may be placed directly at its
+	 * final location.
+	 */
+	if ( image_find_selected() )
+		image->flags |= IMAGE_INITRD;
+
+	return image;
+}
+
 /**
  * Download a new image
  *
@@ -74,7 +103,7 @@ int imgdownload ( struct uri *uri, unsigned long timeout,
 	}
 
 	/* Allocate image */
-	*image = alloc_image ( uri );
+	*image = imgdownload_alloc ( uri );
 	if ( ! *image ) {
 		rc = -ENOMEM;
 		goto err_alloc_image;
@@ -130,6 +159,321 @@ int imgdownload_string ( const char *uri_string, unsigned long timeout,
 	return rc;
 }
 
+/** A background image download */
+struct imgdownload_background {
+	/** Reference count */
+	struct refcnt refcnt;
+	/** List of background downloads */
+	struct list_head list;
+	/** Job control interface */
+	struct interface job;
+	/** Image being downloaded */
+	struct image *image;
+	/** Download status code (or -EINPROGRESS if ongoing) */
+	int rc;
+};
+
+/** List of background downloads
+ *
+ * Successfully completed downloads are registered as images and
+ * removed from this list.  Failed downloads remain in the list until
+ * their failure has been reported by imgwait().
+ */
+static LIST_HEAD ( imgdownloads );
+
+/**
+ * Free background image download
+ *
+ * @v refcnt		Reference count
+ */
+static void imgdownload_background_free ( struct refcnt *refcnt ) {
+	struct imgdownload_background *bg =
+		container_of ( refcnt, struct imgdownload_background, refcnt );
+
+	image_put ( bg->image );
+	free ( bg );
+}
+
+/**
+ * Remove background image download from list
+ *
+ * @v bg		Background image download
+ */
+static void imgdownload_background_remove ( struct imgdownload_background *bg ){
+
+	list_del ( &bg->list );
+	ref_put ( &bg->refcnt );
+}
+
+/**
+ * Handle completion of background image download
+ *
+ * @v bg		Background image download
+ * @v rc		Reason for completion
+ */
+static void imgdownload_background_close ( struct imgdownload_background *bg,
+					   int rc ) {
+
+	/* Shut down interface */
+	intf_shutdown ( &bg->job, rc );
+
+	/* Register image, if download succeeded */
+	if ( ( rc == 0 ) && ( ( rc = register_image ( bg->image ) ) != 0 ) ) {
+		DBGC ( bg, "IMGMGMT could not register %s: %s\n",
+		       bg->image->name, strerror ( rc ) );
+	}
+	bg->rc = rc;
+
+	/* Forget about successful downloads */
+	if ( rc == 0 )
+		imgdownload_background_remove ( bg );
+}
+
+/** Background image download job control interface operations */
+static struct interface_operation imgdownload_background_job_op[] = {
+	INTF_OP ( intf_close, struct imgdownload_background *,
+		  imgdownload_background_close ),
+};
+
+/** Background image download job control interface descriptor */
+static struct interface_descriptor imgdownload_background_job_desc =
+	INTF_DESC ( struct imgdownload_background, job,
+		    imgdownload_background_job_op );
+
+/**
+ * Start downloading a new image in the background
+ *
+ * @v uri		URI
+ * @v image		Image to fill in
+ * @ret rc		Return status code
+ *
+ * The image will be registered when the download completes.  Use
+ * imgwait() to wait for completion and to report any failure.
+ */
+int imgdownload_background ( struct uri *uri, struct image **image ) {
+	struct imgdownload_background *bg;
+	int rc;
+
+	/* Allocate and initialise structure */
+	bg = zalloc ( sizeof ( *bg ) );
+	if ( ! bg ) {
+		rc = -ENOMEM;
+		goto err_alloc;
+	}
+	ref_init ( &bg->refcnt, imgdownload_background_free );
+	intf_init ( &bg->job, &imgdownload_background_job_desc,
+		    &bg->refcnt );
+	bg->rc = -EINPROGRESS;
+
+	/* Resolve URI */
+	uri = resolve_uri ( cwuri, uri );
+	if ( ! uri ) {
+		rc = -ENOMEM;
+		goto err_resolve_uri;
+	}
+
+	/* Allocate image */
+	bg->image = imgdownload_alloc ( uri );
+	if ( ! bg->image ) {
+		rc = -ENOMEM;
+		goto err_alloc_image;
+	}
+
+	/* Create downloader */
+	if ( ( rc = create_downloader ( &bg->job, bg->image ) ) != 0 ) {
+		printf ( "Could not start download: %s\n", strerror ( rc ) );
+		goto err_create_downloader;
+	}
+
+	/* Add to list of background downloads (transferring ownership
+	 * of our reference to the list).
+	 */
+	list_add_tail ( &bg->list, &imgdownloads );
+	*image = bg->image;
+	uri_put ( uri );
+	return 0;
+
+ err_create_downloader:
+ err_alloc_image:
+	uri_put ( uri );
+ err_resolve_uri:
+	intf_shutdown ( &bg->job, rc );
+	ref_put ( &bg->refcnt );
+ err_alloc:
+	return rc;
+}
+
+/**
+ * Start downloading a new image in the background
+ *
+ * @v uri_string	URI string
+ * @v timeout		Download timeout (unused)
+ * @v image		Image to fill in
+ * @ret rc		Return status code
+ */
+int imgdownload_background_string ( const char *uri_string,
+				    unsigned long timeout __unused,
+				    struct image **image ) {
+	struct uri *uri;
+	int rc;
+
+	if ( ! ( uri = parse_uri ( uri_string ) ) )
+		return -ENOMEM;
+
+	rc = imgdownload_background ( uri, image );
+
+	uri_put ( uri );
+	return rc;
+}
+
+/** A wait for background image downloads */
+struct imgwait {
+	/** Job control interface */
+	struct interface job;
+	/** Image names to wait for (or NULL for all images) */
+	char **names;
+	/** Number of image names */
+	unsigned int count;
+};
+
+/**
+ * Check if background image download is being waited for
+ *
+ * @v wait		Wait
+ * @v bg		Background image download
+ * @ret waited		Background image download is being waited for
+ */
+static int imgwait_match ( struct imgwait *wait,
+			   struct imgdownload_background *bg ) {
+	unsigned int i;
+
+	if ( ! wait->names )
+		return 1;
+	if ( ! bg->image->name )
+		return 0;
+	for ( i = 0 ; i < wait->count ; i++ ) {
+		if ( strcmp ( wait->names[i], bg->image->name ) == 0 )
+			return 1;
+	}
+	return 0;
+}
+
+/**
+ * Report progress of all waited-for background image downloads
+ *
+ * @v wait		Wait
+ * @v progress		Progress report to fill in
+ * @ret ongoing_rc	Ongoing job status code (if known)
+ */
+static int imgwait_progress ( struct imgwait *wait,
+			      struct job_progress *progress ) {
+	struct imgdownload_background *bg;
+	struct job_progress bg_progress;
+	unsigned int ongoing = 0;
+
+	/* Sum progress of all ongoing downloads */
+	list_for_each_entry ( bg, &imgdownloads, list ) {
+		if ( ( bg->rc != -EINPROGRESS ) || ! imgwait_match ( wait, bg ))
+			continue;
+		job_progress ( &bg->job, &bg_progress );
+		progress->completed += bg_progress.completed;
+		progress->total += bg_progress.total;
+		ongoing++;
+	}
+
+	/* Finish waiting once no downloads remain ongoing */
+	if ( ! ongoing ) {
+		intf_close ( &wait->job, 0 );
+		return 0;
+	}
+	snprintf ( progress->message, sizeof ( progress->message ),
+		   "%d left", ongoing );
+
+	return 0;
+}
+
+/** Background image download wait job control interface operations */
+static struct interface_operation imgwait_job_op[] = {
+	INTF_OP ( job_progress, struct imgwait *, imgwait_progress ),
+};
+
+/** Background image download wait job control interface descriptor */
+static struct interface_descriptor imgwait_job_desc =
+	INTF_DESC ( struct imgwait, job, imgwait_job_op );
+
+/**
+ * Find background image download by name
+ *
+ * @v name		Image name
+ * @ret bg		Background image download, or NULL if not found
+ */
+static struct imgdownload_background *
+imgdownload_background_find ( const char *name ) {
+	struct imgdownload_background *bg;
+
+	list_for_each_entry ( bg, &imgdownloads, list ) {
+		if ( bg->image->name &&
+		     ( strcmp ( bg->image->name, name ) == 0 ) )
+			return bg;
+	}
+	return NULL;
+}
+
+/**
+ * Wait for background image downloads to complete
+ *
+ * @v names		Image names to wait for (or NULL for all images)
+ * @v count		Number of image names
+ * @v timeout		Timeout period (0=indefinite)
+ * @ret rc		Return status code
+ *
+ * Failed downloads are reported and discarded.
+ */
+int imgwait ( char **names, unsigned int count, unsigned long timeout ) {
+	struct imgwait wait;
+	struct imgdownload_background *bg;
+	struct imgdownload_background *tmp;
+	unsigned int ongoing = 0;
+	unsigned int i;
+	int rc = 0;
+
+	/* Check that all named images exist */
+	for ( i = 0 ; names && ( i < count ) ; i++ ) {
+		if ( ( ! imgdownload_background_find ( names[i] ) ) &&
+		     ( ! find_image ( names[i] ) ) ) {
+			printf ( "\"%s\": no such image\n", names[i] );
+			return -ENOENT;
+		}
+	}
+
+	/* Wait for any ongoing downloads */
+	intf_init ( &wait.job, &imgwait_job_desc, NULL );
+	wait.names = names;
+	wait.count = count;
+	list_for_each_entry ( bg, &imgdownloads, list ) {
+		if ( ( bg->rc == -EINPROGRESS ) && imgwait_match ( &wait, bg ) )
+			ongoing++;
+	}
+	if ( ongoing ) {
+		intf_plug_plug ( &monojob, &wait.job );
+		rc = monojob_wait ( "Waiting for downloads", timeout );
+		intf_shutdown ( &wait.job, rc );
+	}
+
+	/* Report and discard any failed downloads */
+	list_for_each_entry_safe ( bg, tmp, &imgdownloads, list ) {
+		if ( ( bg->rc == -EINPROGRESS ) || ! imgwait_match ( &wait, bg))
+			continue;
+		printf ( "Could not download %s: %s\n",
+			 bg->image->name, strerror ( bg->rc ) );
+		if ( rc == 0 )
+			rc = bg->rc;
+		imgdownload_background_remove ( bg );
+	}
+
+	return rc;
+}
+
 /**
  * Acquire an image
  *
@@ -140,6 +484,14 @@ int imgdownload_string ( const char *uri_string, unsigned long timeout,
  */
 int imgacquire ( const char *name_uri, unsigned long timeout,
 		 struct image **image ) {
+	int rc;
+
+	/* If the image is being downloaded in the background, wait for it */
+	if ( imgdownload_background_find ( name_uri ) ) {
+		if ( ( rc = imgwait ( ( char ** ) &name_uri, 1,
+				      timeout ) ) != 0 )
+			return rc;
+	}
 
 	/* If we already have an image with the specified name, use it */
 	*image = find_image ( name_uri );
@@ -32,6 +32,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/cms.h>
 #include <ipxe/validator.h>
 #include <ipxe/monojob.h>
+#include <ipxe/timeline.h>
 #include <usr/imgtrust.h>
 
 /** @file
@@ -59,6 +60,7 @@ int imgverify ( struct image *image, struct image *signature,
 
 	/* Mark image as untrusted */
 	image_untrust ( image );
+	timeline_begin ( "verify", image );
 
 	/* Get raw signature data */
 	next = image_asn1 ( signature, 0, &data );
@@ -85,8 +87,8 @@ int imgverify ( struct image *image, struct image *signature,
 
 	/* Use signature to verify image */
 	now = time ( NULL );
-	if ( ( rc = cms_verify ( sig, image->data, image->len,
-				 name, now, NULL, NULL ) ) != 0 )
+	if ( ( rc = cms_verify ( sig, image, name, now,
+				 NULL, NULL ) ) != 0 )
 		goto err_verify;
 
 	/* Drop reference to signature */
@@ -96,6 +98,7 @@ int imgverify ( struct image *image, struct image *signature,
 	/* Mark image as trusted */
 	image_trust ( image );
 	syslog ( LOG_NOTICE, "Image \"%s\" signature OK\n", image->name );
+	timeline_end ( "verify", image, 0 );
 
 	return 0;
 
@@ -108,5 +111,6 @@ int imgverify ( struct image *image, struct image *signature,
  err_asn1:
 	syslog ( LOG_ERR, "Image \"%s\" signature bad: %s\n",
 		 image->name, strerror ( rc ) );
+	timeline_end ( "verify", image, rc );
 	return rc;
 }
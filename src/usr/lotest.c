@@ -34,6 +34,7 @@ FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
 #include <ipxe/if_ether.h>
 #include <ipxe/keys.h>
 #include <ipxe/console.h>
+#include <ipxe/timer.h>
 #include <usr/ifmgmt.h>
 #include <usr/lotest.h>
 
@@ -182,6 +183,22 @@ static int loopback_wait ( void *data, size_t len ) {
 	}
 }
 
+/**
+ * Print loopback test progress
+ *
+ * @v count		Number of packets received
+ * @v mtu		Packet size
+ * @v elapsed		Elapsed time (in ticks)
+ */
+static void loopback_progress ( unsigned int count, size_t mtu,
+				unsigned long elapsed ) {
+	unsigned long long bits = ( 8ULL * count * mtu );
+	unsigned long ms = ( ( elapsed * 1000 ) / TICKS_PER_SEC );
+
+	printf ( "\r%d packets in %ldms (%lld Mbps)", count, ms,
+		 ( ms ? ( bits / ( ms * 1000 ) ) : 0 ) );
+}
+
 /**
  * Perform loopback test between two network devices
  *
@@ -189,16 +206,28 @@ static int loopback_wait ( void *data, size_t len ) {
  * @v receiver		Received network device
  * @v mtu		Packet size (excluding link-layer headers)
  * @v broadcast		Use broadcast link-layer address
+ * @v window		Maximum number of packets in flight
+ * @v count		Number of packets to send, or zero to send forever
  * @ret rc		Return status code
+ *
+ * With a window of more than one packet, packets are streamed from
+ * the sender to the receiver, and the achieved throughput is
+ * reported.
  */
 int loopback_test ( struct net_device *sender, struct net_device *receiver,
-		    size_t mtu, int broadcast ) {
+		    size_t mtu, int broadcast, unsigned int window,
+		    unsigned int count ) {
+	uint8_t *bufs;
 	uint8_t *buf;
 	uint32_t *seq;
 	struct io_buffer *iobuf;
 	const void *ll_dest;
-	unsigned int i;
+	unsigned long started;
+	unsigned long updated;
+	unsigned long now;
+	unsigned int sent;
 	unsigned int successes;
+	unsigned int i;
 	int rc;
 
 	/* Open network devices */
@@ -213,61 +242,93 @@ int loopback_test ( struct net_device *sender, struct net_device *receiver,
 	if ( ( rc = iflinkwait ( receiver, 0 ) ) != 0 )
 		return rc;
 
-	/* Allocate data buffer */
+	/* Allocate data buffers (one per packet in flight) */
 	if ( mtu < sizeof ( *seq ) )
 		mtu = sizeof ( *seq );
-	buf = malloc ( mtu );
-	if ( ! buf )
+	if ( ! window )
+		window = 1;
+	bufs = malloc ( window * mtu );
+	if ( ! bufs )
 		return -ENOMEM;
-	seq = ( ( void * ) buf );
 
 	/* Determine destination address */
 	ll_dest = ( broadcast ? sender->ll_broadcast : receiver->ll_addr );
 
 	/* Print initial statistics */
-	printf ( "Performing %sloopback test from %s to %s with %zd byte MTU\n",
+	printf ( "Performing %sloopback test from %s to %s with %zd byte MTU",
 		 ( broadcast ? "broadcast " : "" ), sender->name,
 		 receiver->name, mtu );
+	if ( window > 1 )
+		printf ( " and %d packet window", window );
+	printf ( "\n" );
 	ifstat ( sender );
 	ifstat ( receiver );
 
 	/* Start loopback test */
 	lotest_flush();
 	lotest_receiver = receiver;
+	started = updated = currticks();
 
 	/* Perform loopback test */
-	for ( successes = 0 ; ; successes++ ) {
-
-		/* Print running total */
-		printf ( "\r%d", successes );
-
-		/* Generate random packet */
-		*seq = htonl ( successes );
-		for ( i = sizeof ( *seq ) ; i < mtu ; i++ )
-			buf[i] = random();
-		iobuf = alloc_iob ( MAX_LL_HEADER_LEN + mtu );
-		if ( ! iobuf ) {
-			printf ( "\nFailed to allocate I/O buffer" );
-			rc = -ENOMEM;
-			break;
-		}
-		iob_reserve ( iobuf, MAX_LL_HEADER_LEN );
-		memcpy ( iob_put ( iobuf, mtu ), buf, mtu );
-
-		/* Transmit packet */
-		if ( ( rc = net_tx ( iob_disown ( iobuf ), sender,
-				     &lotest_protocol, ll_dest,
-				     sender->ll_addr ) ) != 0 ) {
-			printf ( "\nFailed to transmit packet: %s",
-				 strerror ( rc ) );
-			break;
+	for ( sent = successes = 0 ; ( ( ! count ) || ( successes < count ) ) ;
+	      successes++ ) {
+
+		/* Fill window */
+		for ( ; ( ( sent - successes ) < window ) &&
+			( ( ! count ) || ( sent < count ) ) ; sent++ ) {
+
+			/* Generate random packet.  When streaming, the
+			 * random content of each buffer is reused for
+			 * subsequent packets to avoid limiting
+			 * throughput.
+			 */
+			buf = ( bufs + ( ( sent % window ) * mtu ) );
+			seq = ( ( void * ) buf );
+			*seq = htonl ( sent );
+			if ( ( window == 1 ) || ( sent < window ) ) {
+				for ( i = sizeof ( *seq ) ; i < mtu ; i++ )
+					buf[i] = random();
+			}
+			iobuf = alloc_iob ( MAX_LL_HEADER_LEN + mtu );
+			if ( ! iobuf ) {
+				printf ( "\nFailed to allocate I/O buffer" );
+				rc = -ENOMEM;
+				goto done;
+			}
+			iob_reserve ( iobuf, MAX_LL_HEADER_LEN );
+			memcpy ( iob_put ( iobuf, mtu ), buf, mtu );
+
+			/* Transmit packet */
+			if ( ( rc = net_tx ( iob_disown ( iobuf ), sender,
+					     &lotest_protocol, ll_dest,
+					     sender->ll_addr ) ) != 0 ) {
+				printf ( "\nFailed to transmit packet: %s",
+					 strerror ( rc ) );
+				goto done;
+			}
 		}
 
 		/* Wait for received packet */
+		buf = ( bufs + ( ( successes % window ) * mtu ) );
 		if ( ( rc = loopback_wait ( buf, mtu ) ) != 0 )
-			break;
+			goto done;
+
+		/* Print running total (at most ten times per second
+		 * when streaming, to avoid limiting throughput).
+		 */
+		now = currticks();
+		if ( window == 1 ) {
+			printf ( "\r%d", ( successes + 1 ) );
+		} else if ( ( now - updated ) >= ( TICKS_PER_SEC / 10 ) ) {
+			loopback_progress ( ( successes + 1 ), mtu,
+					    ( now - started ) );
+			updated = now;
+		}
 	}
 
+ done:
+	/* Print final throughput */
+	loopback_progress ( successes, mtu, ( currticks() - started ) );
 	printf ( "\n");
 
 	/* Stop loopback testing */
@@ -278,8 +339,8 @@ int loopback_test ( struct net_device *sender, struct net_device *receiver,
 	ifstat ( sender );
 	ifstat ( receiver );
 
-	/* Free buffer */
-	free ( buf );
+	/* Free buffers */
+	free ( bufs );
 
 	return 0;
 }
@@ -0,0 +1,167 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ *
+ * You can also choose to distribute this program under the terms of
+ * the Unmodified Binary Distribution Licence (as given in the file
+ * COPYING.UBDL), provided that you have satisfied its requirements.
+ */
+
+FILE_LICENCE ( GPL2_OR_LATER_OR_UBDL );
+
+#include <stdio.h>
+#include <string.h>
+#include <syslog.h>
+#include <ipxe/timer.h>
+#include <ipxe/timeline.h>
+#include <usr/timestat.h>
+
+/** @file
+ *
+ * Boot timeline
+ *
+ */
+
+/** Maximum number of distinct boot phases summarised */
+#define TIMELINE_MAX_PHASES 16
+
+/** A boot phase summary */
+struct timeline_phase {
+	/** Phase name */
+	const char *name;
+	/** Number of completed instances */
+	unsigned int count;
+	/** Number of failed instances */
+	unsigned int failures;
+	/** Total duration (in ticks) */
+	unsigned long total;
+	/** Maximum duration (in ticks) */
+	unsigned long max;
+};
+
+/**
+ * Convert ticks to milliseconds
+ *
+ * @v ticks		Ticks
+ * @ret ms		Milliseconds
+ */
+static unsigned long timeline_ms ( unsigned long ticks ) {
+
+	return ( ( ticks * 1000ULL ) / TICKS_PER_SEC );
+}
+
+/**
+ * Print boot timeline summary
+ *
+ * Phases are listed in order of decreasing total duration, so that
+ * the slowest phase appears first.
+ */
+void timeline_stat ( void ) {
+	struct timeline_phase phases[TIMELINE_MAX_PHASES];
+	struct timeline_phase *phase;
+	struct timeline_phase tmp;
+	struct timeline_event *begin;
+	struct timeline_event *end;
+	unsigned int count = timeline_count();
+	unsigned int num_phases = 0;
+	unsigned long duration;
+	unsigned int i;
+	unsigned int j;
+
+	/* Do nothing if no events have been recorded */
+	if ( ! count ) {
+		printf ( "No boot timeline events recorded\n" );
+		return;
+	}
+
+	/* Accumulate durations of all completed phase instances */
+	memset ( phases, 0, sizeof ( phases ) );
+	for ( i = 0 ; i < count ; i++ ) {
+		end = timeline_event ( i );
+		if ( end->type != TIMELINE_END )
+			continue;
+		begin = timeline_begin_of ( i );
+		if ( ! begin )
+			continue;
+		for ( j = 0 ; j < num_phases ; j++ ) {
+			if ( strcmp ( phases[j].name, end->name ) == 0 )
+				break;
+		}
+		if ( j == num_phases ) {
+			if ( num_phases == TIMELINE_MAX_PHASES )
+				continue;
+			phases[num_phases++].name = end->name;
+		}
+		phase = &phases[j];
+		duration = ( end->ticks - begin->ticks );
+		phase->count++;
+		if ( end->rc != 0 )
+			phase->failures++;
+		phase->total += duration;
+		if ( phase->max < duration )
+			phase->max = duration;
+	}
+
+	/* Sort by decreasing total duration */
+	for ( i = 1 ; i < num_phases ; i++ ) {
+		memcpy ( &tmp, &phases[i], sizeof ( tmp ) );
+		for ( j = i ; j && ( phases[ j - 1 ].total < tmp.total ) ; j-- )
+			memcpy ( &phases[j], &phases[ j - 1 ], sizeof ( tmp ) );
+		memcpy ( &phases[j], &tmp, sizeof ( tmp ) );
+	}
+
+	/* Print summary */
+	printf ( "%d events over %ldms\n", count,
+		 timeline_ms ( timeline_event ( count - 1 )->ticks -
+			       timeline_event ( 0 )->ticks ) );
+	for ( i = 0 ; i < num_phases ; i++ ) {
+		phase = &phases[i];
+		printf ( "%s: %ldms total, %ldms max (%d completed, "
+			 "%d failed)\n", phase->name,
+			 timeline_ms ( phase->total ),
+			 timeline_ms ( phase->max ), phase->count,
+			 phase->failures );
+	}
+}
+
+/**
+ * Send boot timeline event to system log
+ *
+ * @v event		Event
+ */
+static void timeline_log_event ( struct timeline_event *event ) {
+	size_t len = timeline_json_event ( event, NULL, 0 );
+	char buf[ len + 1 /* NUL */ ];
+
+	timeline_json_event ( event, buf, sizeof ( buf ) );
+	log_printf ( "%s\n", buf );
+}
+
+/**
+ * Send boot timeline events to system log
+ *
+ * Each event is logged as a single Chrome trace event JSON object.
+ * Events are logged regardless of the configured LOG_LEVEL, since
+ * this is an explicit request for export.
+ */
+void timeline_log ( void ) {
+	unsigned int count = timeline_count();
+	unsigned int i;
+
+	for ( i = 0 ; i < count ; i++ )
+		timeline_log_event ( timeline_event ( i ) );
+}